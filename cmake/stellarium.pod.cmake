@@ -120,6 +120,24 @@ stereographic, fisheye, cylinder, mercator, perspective, and orthographic.
 
 Delete existing config.ini and use defaults.
 
+=item B<--export-ephemeris> I<file>
+
+Write an ephemeris of solar system objects to I<file> and quit. A CSV file 
+is written if I<file> ends in .csv, a binary columnar file otherwise.
+
+=item B<--ephemeris-objects> I<names>
+
+Comma separated English names of the objects for B<--export-ephemeris>, 
+e.g. Mars,Jupiter.
+
+=item B<--ephemeris-start> I<date>, B<--ephemeris-stop> I<date>
+
+First and last date of the ephemeris in format yyyymmdd (UTC).
+
+=item B<--ephemeris-step> I<minutes>
+
+Time step of the ephemeris in minutes (default 60).
+
 =back
 
 =head1 RETURN VALUE
@@ -19,7 +19,6 @@
 
 #include <QtMath>
 
-#include "LandscapeMgr.hpp"
 #include "StelLocaleMgr.hpp"
 #include "MeteorShower.hpp"
 #include "MeteorShowers.hpp"
@@ -42,6 +41,7 @@ MeteorShower::MeteorShower(MeteorShowersMgr* mgr, const QVariantMap& map)
 	, m_driftAlpha(0)
 	, m_driftDelta(0)
 	, m_pidx(0)
+	, m_palette(-1)
 	, m_radiantAlpha(0)
 	, m_radiantDelta(0)
 {
@@ -175,7 +175,7 @@ MeteorShower::MeteorShower(MeteorShowersMgr* mgr, const QVariantMap& map)
 			QVariantMap colorMap = ms.toMap();
 			QString color = colorMap.value("color").toString();
 			int intensity = colorMap.value("intensity").toInt();
-			m_colors.append(Meteor::ColorPair(color, intensity));
+			m_colors.append(MeteorParticles::ColorPair(color, intensity));
 			totalIntensity += intensity;
 		}
 
@@ -189,7 +189,7 @@ MeteorShower::MeteorShower(MeteorShowersMgr* mgr, const QVariantMap& map)
 	}
 
 	if (m_colors.isEmpty()) {
-		m_colors.push_back(Meteor::ColorPair("white", 100));
+		m_colors.push_back(MeteorParticles::ColorPair("white", 100));
 	}
 
 	m_status = UNDEFINED;
@@ -197,8 +197,6 @@ MeteorShower::MeteorShower(MeteorShowersMgr* mgr, const QVariantMap& map)
 
 MeteorShower::~MeteorShower()
 {
-	qDeleteAll(m_activeMeteors);
-	m_activeMeteors.clear();
 	m_colors.clear();
 }
 
@@ -222,7 +220,7 @@ bool MeteorShower::enabled() const
 	}
 }
 
-void MeteorShower::update(StelCore* core, double deltaTime)
+void MeteorShower::update(StelCore* core, double deltaTime, MeteorParticles& meteors)
 {
 	if (m_status == INVALID)
 	{
@@ -266,17 +264,6 @@ void MeteorShower::update(StelCore* core, double deltaTime)
 		m_radiantDelta += static_cast<double>(m_driftDelta) * daysToPeak;
 	}
 
-	// step through and update all active meteors
-	foreach (MeteorObj* m, m_activeMeteors)
-	{
-		if (!m->update(deltaTime))
-		{
-			//important to delete when no longer active
-			m_activeMeteors.removeOne(m);
-			delete m;
-		}
-	}
-
 	// paused | forward | backward ?
 	// don't create new meteors
 	if(!core->getRealTimeSpeed())
@@ -291,30 +278,27 @@ void MeteorShower::update(StelCore* core, double deltaTime)
 		return;
 	}
 
-	// average meteors per frame
-	const float mpf = currentZHR * static_cast<float>(deltaTime) / 3600.f;
+	const int n = meteors.getNrOfSpawns(static_cast<float>(currentZHR), deltaTime);
+	if (n < 1)
+	{
+		return;
+	}
 
-	// maximum amount of meteors for the current frame
-	int maxMpf = qRound(mpf);
-	maxMpf = maxMpf < 1 ? 1 : maxMpf;
+	if (m_palette < 0)
+	{
+		m_palette = meteors.addPalette(m_colors);
+	}
+	meteors.updateBrightness(core->getSkyDrawer());
 
-	float rate = mpf / static_cast<float>(maxMpf);
-	for (int i = 0; i < maxMpf; ++i)
+	// the radiant is the same for all meteors of the frame
+	Vec3d radiant;
+	StelUtils::spheToRect(m_radiantAlpha, m_radiantDelta, radiant);
+	radiant = core->j2000ToAltAz(radiant);
+	for (int i = 0; i < n; ++i)
 	{
-		float prob = static_cast<float>(qrand()) / static_cast<float>(RAND_MAX);
-		if (prob < rate)
-		{
-			MeteorObj *m = new MeteorObj(core, m_speed, static_cast<float>(m_radiantAlpha), static_cast<float>(m_radiantDelta),
-						     m_pidx, m_colors, m_mgr->getBolideTexture());
-			if (m->isAlive())
-			{
-				m_activeMeteors.append(m);
-			}
-			else
-			{
-				delete m;
-			}
-		}
+		// if speed is zero, use a random value
+		const int speed = m_speed ? m_speed : 11 + static_cast<int>(meteors.random() * 61);  // abs range 11-72 km/s
+		meteors.spawn(radiant, static_cast<float>(speed), m_palette, m_pidx);
 	}
 }
 
@@ -325,7 +309,6 @@ void MeteorShower::draw(StelCore* core)
 		return;
 	}
 	drawRadiant(core);
-	drawMeteors(core);
 }
 
 void MeteorShower::drawRadiant(StelCore *core)
@@ -375,27 +358,6 @@ void MeteorShower::drawRadiant(StelCore *core)
 	}
 }
 
-void MeteorShower::drawMeteors(StelCore *core)
-{
-	if (!core->getSkyDrawer()->getFlagHasAtmosphere())
-	{
-		return;
-	}
-
-	LandscapeMgr* landmgr = GETSTELMODULE(LandscapeMgr);
-	if (landmgr->getFlagAtmosphere() && landmgr->getLuminance() > 5.f)
-	{
-		return;
-	}
-
-	// step through and draw all active meteors
-	StelPainter painter(core->getProjection(StelCore::FrameAltAz));
-	for (auto* m : m_activeMeteors)
-	{
-		m->draw(core, painter);
-	}
-}
-
 MeteorShower::Activity MeteorShower::hasGenericShower(QDate date, bool &found) const
 {
 	int year = date.year();
@@ -20,8 +20,9 @@
 #ifndef METEORSHOWER_HPP
 #define METEORSHOWER_HPP
 
-#include "MeteorObj.hpp"
+#include "MeteorParticles.hpp"
 #include "MeteorShowersMgr.hpp"
+#include "StelCore.hpp"
 #include "StelFader.hpp"
 #include "StelObject.hpp"
 #include "StelPainter.hpp"
@@ -68,9 +69,10 @@ public:
 
 	//! Update
 	//! @param deltaTime the time increment in seconds since the last call.
-	void update(StelCore *core, double deltaTime);
+	//! @param meteors the pool in which the new meteors are created.
+	void update(StelCore *core, double deltaTime, MeteorParticles& meteors);
 
-	//! Draw
+	//! Draw the radiant
 	void draw(StelCore *core);
 
 	//! Checks if we have generic data for a given date
@@ -142,7 +144,8 @@ private:
 	float m_driftDelta;                //! Drift of Dec. for each day from peak
 	QString m_parentObj;               //! Parent object for meteor shower
 	float m_pidx;                      //! The population index
-	QList<Meteor::ColorPair> m_colors; //! <colorName, 0-100>
+	QList<MeteorParticles::ColorPair> m_colors; //! <colorName, 0-100>
+	int m_palette;                     //! Palette of m_colors in the meteor pool, or -1
 
 	//current information
 	Vec3d m_position;                  //! Cartesian equatorial position
@@ -150,14 +153,9 @@ private:
 	double m_radiantDelta;             //! Current Dec. for radiant of meteor shower
 	Activity m_activity;               //! Current activity
 
-	QList<MeteorObj*> m_activeMeteors; //! List with all the active meteors
-
 	//! Draws the radiant
 	void drawRadiant(StelCore* core);
 
-	//! Draws all active meteors
-	void drawMeteors(StelCore* core);
-
 	//! Calculates the ZHR using normal distribution
 	//! @param current julian day
 	int calculateZHR(const double& currentJD);
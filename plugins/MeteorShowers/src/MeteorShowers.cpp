@@ -17,8 +17,10 @@
  * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
  */
 
+#include <QDateTime>
 #include <QtMath>
 
+#include "LandscapeMgr.hpp"
 #include "MeteorShowers.hpp"
 #include "StelApp.hpp"
 #include "StelModuleMgr.hpp"
@@ -40,9 +42,13 @@ MeteorShowers::~MeteorShowers()
 void MeteorShowers::update(double deltaTime)
 {
 	StelCore* core = StelApp::getInstance().getCore();
+
+	// update all active meteors
+	m_meteors.update(deltaTime, core->getRealTimeSpeed());
+
 	for (const auto& ms : m_meteorShowers)
 	{
-		ms->update(core, deltaTime);
+		ms->update(core, deltaTime, m_meteors);
 	}
 }
 
@@ -52,6 +58,7 @@ void MeteorShowers::draw(StelCore* core)
 	{
 		ms->draw(core);
 	}
+	drawMeteors(core);
 
 	if (GETSTELMODULE(StelObjectMgr)->getFlagSelectedObjectPointer())
 	{
@@ -59,6 +66,24 @@ void MeteorShowers::draw(StelCore* core)
 	}
 }
 
+void MeteorShowers::drawMeteors(StelCore* core)
+{
+	if (!core->getSkyDrawer()->getFlagHasAtmosphere())
+	{
+		return;
+	}
+
+	LandscapeMgr* landmgr = GETSTELMODULE(LandscapeMgr);
+	if (landmgr->getFlagAtmosphere() && landmgr->getLuminance() > 5.f)
+	{
+		return;
+	}
+
+	// draw the active meteors of all showers at once
+	StelPainter painter(core->getProjection(StelCore::FrameAltAz));
+	m_meteors.draw(core, painter, m_mgr->getBolideTexture());
+}
+
 void MeteorShowers::drawPointer(StelCore* core)
 {
 	const QList<StelObjectP> newSelected = GETSTELMODULE(StelObjectMgr)->getSelectedObject("MeteorShower");
@@ -97,6 +122,8 @@ void MeteorShowers::drawPointer(StelCore* core)
 void MeteorShowers::loadMeteorShowers(const QVariantMap& map)
 {
 	m_meteorShowers.clear();
+	// the palettes of the meteors belong to the previous showers
+	m_meteors.clear();
 	for (auto msKey : map.keys())
 	{
 		QVariantMap msData = map.value(msKey).toMap();
@@ -110,6 +137,11 @@ void MeteorShowers::loadMeteorShowers(const QVariantMap& map)
 	}
 }
 
+void MeteorShowers::setRandomSeed(int seed)
+{
+	m_meteors.setSeed(seed ? static_cast<quint64>(seed) : static_cast<quint64>(QDateTime::currentMSecsSinceEpoch()));
+}
+
 QList<MeteorShowers::SearchResult> MeteorShowers::searchEvents(QDate dateFrom, QDate dateTo) const
 {
 	QList<SearchResult> result;
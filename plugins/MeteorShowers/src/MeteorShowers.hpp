@@ -64,6 +64,10 @@ public:
 	//! @param map
 	void loadMeteorShowers(const QVariantMap& map);
 
+	//! Restart the random generation of the meteors, so that the same seed gives the same meteors.
+	//! @param seed the seed, or 0 to use the current time.
+	void setRandomSeed(int seed);
+
 	//! Find all meteor_shower events in a given date interval
 	//! @param dateFrom
 	//! @param dateTo
@@ -85,9 +89,14 @@ public:
 private:
 	MeteorShowersMgr* m_mgr;
 	QList<MeteorShowerP> m_meteorShowers;
+	//! The meteors of all showers, drawn at once
+	MeteorParticles m_meteors;
 
 	//! Draw pointer
 	void drawPointer(StelCore* core);
+
+	//! Draws all active meteors
+	void drawMeteors(StelCore* core);
 };
 
 #endif /*METEORSHOWERS_HPP*/
@@ -172,6 +172,7 @@ void MeteorShowersMgr::loadConfig()
 	setUrl(m_conf->value(MS_CONFIG_PREFIX + "/url", "https://stellarium.org/json/showers.json").toString());
 	setLastUpdate(m_conf->value(MS_CONFIG_PREFIX + "/last_update", "2015-07-01T00:00:00").toDateTime());
 	setStatusOfLastUpdate(m_conf->value(MS_CONFIG_PREFIX + "/last_update_status", 0).toInt());	
+	setRandomSeed(m_conf->value(MS_CONFIG_PREFIX + "/random_seed", 0).toInt());
 }
 
 void MeteorShowersMgr::saveSettings()
@@ -544,6 +545,14 @@ void MeteorShowersMgr::setColorIR(const Vec3f& rgb)
 	m_conf->setValue(MS_CONFIG_PREFIX + "/colorIR", rgb.toStr());
 }
 
+void MeteorShowersMgr::setRandomSeed(int seed)
+{
+	if (m_meteorShowers)
+	{
+		m_meteorShowers->setRandomSeed(seed);
+	}
+}
+
 void MeteorShowersMgr::setEnableAtStartup(const bool& b)
 {
 	m_enableAtStartup = b;
@@ -267,6 +267,14 @@ public slots:
 	//! @endcode
 	Vec3f getColorIR() { return m_colorIR; }
 
+	//! Restart the random generation of the meteors, so that a show gives the same meteors each time.
+	//! @param seed the seed, or 0 to use the current time.
+	//! @code
+	//! // example of usage in scripts
+	//! MeteorShowers.setRandomSeed(1833);
+	//! @endcode
+	void setRandomSeed(int seed);
+
 	//! Download the Meteor Showers catalog from the Internet.
 	void updateCatalog();
 
@@ -187,6 +187,10 @@ public:
 	//! result in better performance if done correctly.
 	//! Unless you are sure, return false here.
 	virtual bool isThreadSafe() const = 0;
+	//! Return true if the get() method can safely be run in the HTTP handler thread for this operation.
+	//! This lets services which are not thread-safe answer some queries without waiting for the main thread,
+	//! for example from data that is published each frame. The default implementation returns isThreadSafe().
+	virtual bool isThreadSafeGet(const QByteArray& operation) const { Q_UNUSED(operation) return isThreadSafe(); }
 	//! Implement this to define reactions to HTTP GET requests.
 	//! GET requests generally should only query data or program state, and not change it.
 	//! If there is an error with the request, use APIServiceResponse::writeRequestError to notify the client.
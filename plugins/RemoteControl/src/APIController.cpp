@@ -100,7 +100,7 @@ void APIController::service(HttpRequest &request, HttpResponse &response)
 #ifdef FORCE_THREADED_SERVICES
 			sv->get(operation, request.getParameterMap(), apiresponse);
 #else
-			if(sv->isThreadSafe())
+			if(sv->isThreadSafeGet(operation))
 			{
 				sv->get(operation,request.getParameterMap(), apiresponse);
 			}
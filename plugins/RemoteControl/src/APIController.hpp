@@ -45,8 +45,9 @@ public:
 	//! depending on the service name (first part of path until slash). An error is returned for invalid requests.
 	//! If a service was found, the request is passed on to its RemoteControlServiceInterface::get or RemoteControlServiceInterface::post
 	//! method depending on the HTTP request type.
-	//! If RemoteControlServiceInterface::isThreadSafe is false, these methods are called in the Stellarium main thread
-	//! using QMetaObject::invokeMethod, otherwise they are directly executed in the current thread (HTTP worker thread).
+	//! If RemoteControlServiceInterface::isThreadSafe (or RemoteControlServiceInterface::isThreadSafeGet for GET requests) is false,
+	//! these methods are called in the Stellarium main thread using QMetaObject::invokeMethod,
+	//! otherwise they are directly executed in the current thread (HTTP worker thread).
 	virtual void service(HttpRequest& request, HttpResponse& response);
 
 	//! Registers a service with the APIController.
@@ -96,9 +96,29 @@ void LocationSearchService::get(const QByteArray& operation, const APIParameters
 
 		response.writeJSON(QJsonDocument(QJsonArray::fromStringList(results.keys())));
 	}
+	else if(operation=="nearest")
+	{
+		QString sPlanet = QString::fromUtf8(parameters.value("planet"));
+		float latitude = QString::fromUtf8(parameters.value("latitude")).toFloat();
+		float longitude = QString::fromUtf8(parameters.value("longitude")).toFloat();
+		bool ok;
+		float radius = QString::fromUtf8(parameters.value("radius")).toFloat(&ok);
+		if (!ok)
+			radius = 180.f;
+
+		locMgrMutex.lock();
+		StelLocation loc = locMgr.pickNearestLocation(sPlanet,longitude,latitude,radius);
+		locMgrMutex.unlock();
+
+		//same format as nearby, with at most one entry
+		QJsonArray results;
+		if (loc.isValid())
+			results.append(loc.getID());
+		response.writeJSON(QJsonDocument(results));
+	}
 	else
 	{
 		//TODO some sort of service description?
-		response.writeRequestError("unsupported operation. GET: search,nearby");
+		response.writeRequestError("unsupported operation. GET: search,nearby,nearest");
 	}
 }
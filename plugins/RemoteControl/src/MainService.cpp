@@ -34,17 +34,21 @@
 #include "StelTranslator.hpp"
 #include "StelUtils.hpp"
 
+#include <QDateTime>
+#include <QElapsedTimer>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QThread>
 
+//! Snapshots are published while a client polled within this time (ms)
+static const qint64 CLIENT_POLL_WINDOW = 5000;
 
 MainService::MainService(QObject *parent)
 	: AbstractAPIService(parent),
 	  moveX(0),moveY(0),lastMoveUpdateTime(0),
-	  //100 should be more than enough
-	  //this only has to encompass events that occur between 2 status updates
-	  actionCache(100), propCache(100)
+	  propertyCount(-1), actionsChanged(true), lastClientPoll(0),
+	  lastSelectionInfoRequest(0), lastSelectionInfoUpdate(0), lastSelectedObject(Q_NULLPTR)
 {
 	//this is run in the main thread
 	core = StelApp::getInstance().getCore();
@@ -58,6 +62,7 @@ MainService::MainService(QObject *parent)
 	skyCulMgr = &StelApp::getInstance().getSkyCultureMgr();
 
 	connect(actionMgr,SIGNAL(actionToggled(QString,bool)),this,SLOT(actionToggled(QString,bool)));
+	connect(actionMgr,SIGNAL(actionAdded(StelAction*)),this,SLOT(actionAdded()));
 	connect(propMgr,SIGNAL(stelPropertyChanged(StelProperty*,QVariant)),this,SLOT(propertyChanged(StelProperty*,QVariant)));
 
 	Q_ASSERT(this->thread()==objMgr->thread());
@@ -95,96 +100,269 @@ void MainService::update(double deltaTime)
 		//this is required to enable maximal fps for smoothness
 		StelMainView::getInstance().thereWasAnEvent();
 	}
+
+	publishSnapshot();
 }
 
-void MainService::get(const QByteArray& operation, const APIParameters &parameters, APIServiceResponse &response)
+bool MainService::isThreadSafeGet(const QByteArray &operation) const
 {
-	if(operation=="status")
-	{
-		//a listing of the most common stuff that can change often
+	return operation=="status" || operation=="events";
+}
 
-		QString sActionId = QString::fromUtf8(parameters.value("actionId"));
-		bool actionOk;
-		int actionId = sActionId.toInt(&actionOk);
+void MainService::publishSnapshot()
+{
+	//collecting the state costs time in each frame, so it is skipped while no client polls
+	qint64 now = QDateTime::currentMSecsSinceEpoch();
+	if(clientPolled.fetchAndStoreRelaxed(0))
+		lastClientPoll = now;
+	if((now - lastClientPoll) >= CLIENT_POLL_WINDOW)
+	{
+		publishing.storeRelease(0);
+		return;
+	}
 
-		QString sPropId = QString::fromUtf8(parameters.value("propId"));
-		bool propOk;
-		int propId = sPropId.toInt(&propOk);
+	const qint64 serial = state.serial + 1;
 
-		QJsonObject obj;
+	//// Location
+	const StelLocation& loc = core->getCurrentLocation();
+	{
+		QJsonObject obj2;
+		obj2.insert("name",loc.name);
+		obj2.insert("role",QString(loc.role));
+		obj2.insert("planet",loc.planetName);
+		obj2.insert("latitude",static_cast<double>(loc.latitude));
+		obj2.insert("longitude",static_cast<double>(loc.longitude));
+		obj2.insert("altitude",loc.altitude);
+		obj2.insert("country",loc.country);
+		obj2.insert("state",loc.state);
+		obj2.insert("landscapeKey",loc.landscapeKey);
+		if(obj2!=state.location)
+		{
+			state.location = obj2;
+			state.locationSerial = serial;
+		}
+	}
 
-		//// Location
-		const StelLocation& loc = core->getCurrentLocation();
+	//// Time related stuff
+	{
+		double jday = core->getJD();
+		double deltaT = core->getDeltaT() * StelCore::JD_SECOND;
+
+		double gmtShift = static_cast<double>(core->getUTCOffset(jday)) / 24.0;
+
+		QString utcIso = StelUtils::julianDayToISO8601String(jday,true).append('Z');
+		QString localIso = StelUtils::julianDayToISO8601String(jday+gmtShift,true);
+
+		//time zone string
+		QString timeZone = localeMgr->getPrintableTimeZoneLocal(jday);
+
+		QJsonObject obj2;
+		obj2.insert("jday",jday);
+		obj2.insert("deltaT",deltaT);
+		obj2.insert("gmtShift",gmtShift);
+		obj2.insert("timeZone",timeZone);
+		obj2.insert("utc",utcIso);
+		obj2.insert("local",localIso);
+		obj2.insert("isTimeNow",core->getIsTimeNow());
+		obj2.insert("timerate",core->getTimeRate());
+		if(obj2!=state.time)
 		{
-			QJsonObject obj2;
-			obj2.insert("name",loc.name);
-			obj2.insert("role",QString(loc.role));
-			obj2.insert("planet",loc.planetName);
-			obj2.insert("latitude",static_cast<double>(loc.latitude));
-			obj2.insert("longitude",static_cast<double>(loc.longitude));
-			obj2.insert("altitude",loc.altitude);
-			obj2.insert("country",loc.country);
-			obj2.insert("state",loc.state);
-			obj2.insert("landscapeKey",loc.landscapeKey);
-			obj.insert("location",obj2);
+			state.time = obj2;
+			state.timeSerial = serial;
 		}
+	}
 
-		//// Time related stuff
+	//// Info about selected object (only primary)
+	//the info string is expensive, so it is only updated while clients ask for it, and at most every 100 ms
+	{
+		if(selectionInfoRequested.fetchAndStoreRelaxed(0))
+			lastSelectionInfoRequest = now;
+		bool wanted = (now - lastSelectionInfoRequest) < CLIENT_POLL_WINDOW;
+		if(wanted)
 		{
-			double jday = core->getJD();
-			double deltaT = core->getDeltaT() * StelCore::JD_SECOND;
-
-			double gmtShift = static_cast<double>(core->getUTCOffset(jday)) / 24.0;
-
-			QString utcIso = StelUtils::julianDayToISO8601String(jday,true).append('Z');
-			QString localIso = StelUtils::julianDayToISO8601String(jday+gmtShift,true);
-
-			//time zone string
-			QString timeZone = localeMgr->getPrintableTimeZoneLocal(jday);
-
-			QJsonObject obj2;
-			obj2.insert("jday",jday);
-			obj2.insert("deltaT",deltaT);
-			obj2.insert("gmtShift",gmtShift);
-			obj2.insert("timeZone",timeZone);
-			obj2.insert("utc",utcIso);
-			obj2.insert("local",localIso);
-			obj2.insert("isTimeNow",core->getIsTimeNow());
-			obj2.insert("timerate",core->getTimeRate());
-			obj.insert("time",obj2);
+			StelObjectP selectedObject = getSelectedObject();
+			if(!state.selectionInfoValid || selectedObject.data()!=lastSelectedObject || (now - lastSelectionInfoUpdate) >= 100)
+			{
+				QString infoStr = getInfoString();
+				if(infoStr!=state.selectionInfo)
+				{
+					state.selectionInfo = infoStr;
+					state.selectionSerial = serial;
+				}
+				lastSelectedObject = selectedObject.data();
+				lastSelectionInfoUpdate = now;
+			}
 		}
+		state.selectionInfoValid = wanted;
+	}
+
+	//// Info about current view
+	{
+		QJsonObject obj2;
+
+		// the aim fov may lie outside the min/max bounds, so constrain it
+		double fov = mvmgr->getAimFov();
+		if(fov < mvmgr->getMinFov())
+			fov = mvmgr->getMinFov();
+		else if (fov>mvmgr->getMaxFov())
+			fov = mvmgr->getMaxFov();
 
-		//// Info about selected object (only primary)
+		obj2.insert("fov",fov);
+		if(obj2!=state.view)
 		{
-			QString infoStr;
-			QMetaObject::invokeMethod(this,"getInfoString",SERVICE_DEFAULT_INVOKETYPE,
-						  Q_RETURN_ARG(QString,infoStr));
-			obj.insert("selectioninfo",infoStr);
+			state.view = obj2;
+			state.viewSerial = serial;
 		}
+	}
 
-		//// Info about current view
+	//// Values of all actions & props
+	//modules register their actions and properties when they are loaded, changes of the values are logged as they happen
+	if(actionsChanged)
+	{
+		QJsonObject actionValues;
+		for (const auto* ac : actionMgr->getActionList())
 		{
-			QJsonObject obj2;
+			if(ac->isCheckable())
+			{
+				actionValues.insert(ac->getId(),ac->isChecked());
+			}
+		}
+		state.actions.setValues(actionValues);
+		actionsChanged = false;
+	}
+	const StelPropertyMgr::StelPropertyMap& map = propMgr->getPropertyMap();
+	if(map.size()!=propertyCount)
+	{
+		QJsonObject propValues;
+		for (auto it = map.constBegin(); it != map.constEnd(); ++it)
+		{
+			propValues.insert(it.key(), QJsonValue::fromVariant((*it)->getValue()));
+		}
+		state.properties.setValues(propValues);
+		propertyCount = map.size();
+	}
 
-			// the aim fov may lie outside the min/max bounds, so constrain it
-			double fov = mvmgr->getAimFov();
-			if(fov < mvmgr->getMinFov())
-				fov = mvmgr->getMinFov();
-			else if (fov>mvmgr->getMaxFov())
-				fov = mvmgr->getMaxFov();
+	state.serial = serial;
+	snapshots.publish(new StateSnapshot(state));
+	publishing.storeRelease(1);
+}
 
-			obj2.insert("fov",fov);
+StateSnapshot MainService::getSnapshot(bool withSelectionInfo)
+{
+	clientPolled.fetchAndStoreRelaxed(1);
+	if(withSelectionInfo)
+		selectionInfoRequested.fetchAndStoreRelaxed(1);
+	bool current = publishing.loadAcquire();
+	StateSnapshot snapshot = snapshots.get();
+	if((!current || (withSelectionInfo && !snapshot.selectionInfoValid)) && QThread::currentThread()!=thread())
+	{
+		//nobody polled recently, wait until the next frame publishes a current snapshot
+		QMetaObject::invokeMethod(this,"requestFrame",Qt::QueuedConnection);
+		snapshots.waitForSerial(snapshot.serial, 1000);
+		snapshot = snapshots.get();
+	}
+	return snapshot;
+}
 
-			obj.insert("view",obj2);
-		}
+QJsonObject MainService::getChangesSinceSerial(const StateSnapshot &snapshot, qint64 since, const QByteArrayList &parts) const
+{
+	QJsonObject obj;
+	if(parts.contains("location") && snapshot.locationSerial>since)
+		obj.insert("location",snapshot.location);
+	if(parts.contains("time") && snapshot.timeSerial>since)
+		obj.insert("time",snapshot.time);
+	if(parts.contains("view") && snapshot.viewSerial>since)
+		obj.insert("view",snapshot.view);
+	if(parts.contains("selection") && snapshot.selectionSerial>since)
+		obj.insert("selectioninfo",snapshot.selectionInfo);
+	if(parts.contains("actions") && (since==0 || snapshot.actions.getLastSerial()>since))
+		obj.insert("actionChanges",snapshot.actions.getChangesSinceSerial(since));
+	if(parts.contains("properties") && (since==0 || snapshot.properties.getLastSerial()>since))
+		obj.insert("propertyChanges",snapshot.properties.getChangesSinceSerial(since));
+	return obj;
+}
+
+void MainService::get(const QByteArray& operation, const APIParameters &parameters, APIServiceResponse &response)
+{
+	if(operation=="status")
+	{
+		//a listing of the most common stuff that can change often
+
+		QString sActionId = QString::fromUtf8(parameters.value("actionId"));
+		bool actionOk;
+		int actionId = sActionId.toInt(&actionOk);
+
+		QString sPropId = QString::fromUtf8(parameters.value("propId"));
+		bool propOk;
+		int propId = sPropId.toInt(&propOk);
+
+		//this runs in the HTTP thread, all the information is taken from the last snapshot
+		StateSnapshot snapshot = getSnapshot(true);
+
+		QJsonObject obj;
+		obj.insert("location",snapshot.location);
+		obj.insert("time",snapshot.time);
+		obj.insert("selectioninfo",snapshot.selectionInfo);
+		obj.insert("view",snapshot.view);
 
 		//// Info about changed actions & props (if requested)
 		{
 			if(actionOk)
-				obj.insert("actionChanges",getActionChangesSinceID(actionId));
+				obj.insert("actionChanges",snapshot.actions.getChangesSinceID(actionId));
 			if(propOk)
-				obj.insert("propertyChanges",getPropertyChangesSinceID(propId));
+				obj.insert("propertyChanges",snapshot.properties.getChangesSinceID(propId));
+		}
+
+		response.writeJSON(QJsonDocument(obj));
+	}
+	else if(operation=="events")
+	{
+		//long poll for the parts of the state which changed after the frame "since" (the serial of the last reply)
+		//parameters: since (default 0 = everything), timeout (ms, default 20000, max 60000),
+		//parts (comma-separated list of location,time,view,selection,actions,properties, default all)
+		bool ok = true;
+		qint64 since = 0;
+		if(parameters.contains("since"))
+			since = QString::fromUtf8(parameters.value("since")).toLongLong(&ok);
+		int timeout = 20000;
+		if(ok && parameters.contains("timeout"))
+			timeout = QString::fromUtf8(parameters.value("timeout")).toInt(&ok);
+		if(!ok || since<0 || timeout<0)
+		{
+			response.writeRequestError("invalid since or timeout parameter");
+			return;
+		}
+		timeout = qMin(timeout, 60000);
+
+		QByteArrayList parts;
+		if(parameters.contains("parts"))
+			parts = parameters.value("parts").split(',');
+		else
+			parts << "location" << "time" << "view" << "selection" << "actions" << "properties";
+		bool selection = parts.contains("selection");
+
+		QElapsedTimer timer;
+		timer.start();
+		StateSnapshot snapshot = getSnapshot(selection);
+		//a client from before a restart of the program gets everything
+		if(since>snapshot.serial)
+			since = 0;
+		QJsonObject obj = getChangesSinceSerial(snapshot, since, parts);
+		while(obj.isEmpty())
+		{
+			qint64 remaining = timeout - timer.elapsed();
+			if(remaining<=0)
+				break;
+			//the waiting client counts as polling, so that the snapshots are still published
+			clientPolled.fetchAndStoreRelaxed(1);
+			if(selection)
+				selectionInfoRequested.fetchAndStoreRelaxed(1);
+			if(!snapshots.waitForSerial(snapshot.serial, static_cast<int>(qMin(remaining, qint64(1000)))))
+				continue;
+			snapshot = snapshots.get();
+			obj = getChangesSinceSerial(snapshot, since, parts);
 		}
+		obj.insert("serial",static_cast<double>(snapshot.serial));
 
 		response.writeJSON(QJsonDocument(obj));
 	}
@@ -268,7 +446,7 @@ void MainService::get(const QByteArray& operation, const APIParameters &paramete
 	else
 	{
 		//TODO some sort of service description?
-		response.writeRequestError("unsupported operation. GET: status, plugins, view");
+		response.writeRequestError("unsupported operation. GET: status, events, plugins, view");
 	}
 }
 
@@ -621,151 +799,23 @@ void MainService::setFov(double fov)
 	mvmgr->zoomTo(fov,0.25f);
 }
 
-void MainService::actionToggled(const QString &id, bool val)
+void MainService::requestFrame()
 {
-	actionMutex.lock();
-	actionCache.append(ActionCacheEntry(id,val));
-	if(!actionCache.areIndexesValid())
-	{
-		//in theory, this can happen, but practically not so much
-		qWarning()<<"Action cache indices invalid";
-		actionCache.clear();
-	}
-	actionMutex.unlock();
+	StelMainView::getInstance().thereWasAnEvent();
 }
 
-void MainService::propertyChanged(StelProperty* prop, const QVariant& val)
+void MainService::actionToggled(const QString &id, bool val)
 {
-	propMutex.lock();
-	propCache.append(PropertyCacheEntry(prop->getId(),val));
-	if(!propCache.areIndexesValid())
-	{
-		//in theory, this can happen, but practically not so much
-		qWarning()<<"Property cache indices invalid";
-		propCache.clear();
-	}
-	propMutex.unlock();
+	//the change is published with the next snapshot
+	state.actions.append(id, val, state.serial+1);
 }
 
-QJsonObject MainService::getActionChangesSinceID(int changeId)
+void MainService::actionAdded()
 {
-	//changeId is the last id the interface is available
-	//or -2 if the interface just started
-	// -1 means the initial state was set
-
-	QJsonObject obj;
-	QJsonObject changes;
-	int newId = changeId;
-
-
-	actionMutex.lock();
-	if(actionCache.isEmpty())
-	{
-		if(changeId!=-1)
-		{
-			//this is either the initial state (-2) or
-			//something is "broken", probably from an existing web interface that reconnected after restart
-			//force a full reload
-
-			for (const auto* ac : actionMgr->getActionList())
-			{
-				if(ac->isCheckable())
-				{
-					changes.insert(ac->getId(),ac->isChecked());
-				}
-			}
-			newId = -1;
-		}
-	}
-	else
-	{
-		if(changeId > actionCache.lastIndex() || changeId < (actionCache.firstIndex()-1))
-		{
-			//this is either the initial state (-2) or
-			//"broken" state again, force full reload
-			for (const auto* ac : actionMgr->getActionList())
-			{
-				if(ac->isCheckable())
-				{
-					changes.insert(ac->getId(),ac->isChecked());
-				}
-			}
-			newId = actionCache.lastIndex();
-		}
-		else if(changeId < actionCache.lastIndex())
-		{
-			//create a "diff" between changeId to lastIndex
-			for(int i = changeId+1;i<=actionCache.lastIndex();++i)
-			{
-				const ActionCacheEntry& e = actionCache.at(i);
-				changes.insert(e.action,e.val);
-			}
-			newId = actionCache.lastIndex();
-		}
-		//else no changes happened, interface is at current state!
-	}
-	actionMutex.unlock();
-
-	obj.insert("changes",changes);
-	obj.insert("id",newId);
-
-	return obj;
+	actionsChanged = true;
 }
 
-QJsonObject MainService::getPropertyChangesSinceID(int changeId)
+void MainService::propertyChanged(StelProperty* prop, const QVariant& val)
 {
-	//changeId is the last id the interface is available
-	//or -2 if the interface just started
-	// -1 means the initial state was set
-	QJsonObject obj;
-	QJsonObject changes;
-	int newId = changeId;
-
-	propMutex.lock();
-	if(propCache.isEmpty())
-	{
-		if(changeId!=-1)
-		{
-			//this is either the initial state (-2) or
-			//something is "broken", probably from an existing web interface that reconnected after restart
-			//force a full reload
-			const auto& map = propMgr->getPropertyMap();
-			for (auto it = map.constBegin(); it != map.constEnd(); ++it)
-			{
-				changes.insert(it.key(), QJsonValue::fromVariant((*it)->getValue()));
-			}
-			newId = -1;
-		}
-	}
-	else
-	{
-		if(changeId > propCache.lastIndex() || changeId < (propCache.firstIndex()-1))
-		{
-			//this is either the initial state (-2) or
-			//"broken" state again, force full reload
-			const auto& map = propMgr->getPropertyMap();
-			for (auto it = map.constBegin(); it != map.constEnd(); ++it)
-			{
-				changes.insert(it.key(), QJsonValue::fromVariant((*it)->getValue()));
-			}
-			newId = propCache.lastIndex();
-		}
-		else if(changeId < propCache.lastIndex())
-		{
-			//create a "diff" between changeId to lastIndex
-			for(int i = changeId+1;i<=propCache.lastIndex();++i)
-			{
-				const PropertyCacheEntry& e = propCache.at(i);
-				changes.insert(e.id,QJsonValue::fromVariant(e.val));
-			}
-			newId = propCache.lastIndex();
-		}
-		//else no changes happened, interface is at current state!
-	}
-	propMutex.unlock();
-
-	obj.insert("changes",changes);
-	obj.insert("id",newId);
-
-	return obj;
+	state.properties.append(prop->getId(), QJsonValue::fromVariant(val), state.serial+1);
 }
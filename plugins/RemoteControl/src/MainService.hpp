@@ -21,13 +21,14 @@
 #define MAINSERVICE_HPP
 
 #include "AbstractAPIService.hpp"
+#include "StateSnapshot.hpp"
 
 #include "StelObjectType.hpp"
 #include "VecMath.hpp"
 
-#include <QContiguousCache>
+#include <QAtomicInt>
+#include <QByteArrayList>
 #include <QJsonObject>
-#include <QMutex>
 
 class StelCore;
 class StelActionMgr;
@@ -44,6 +45,12 @@ class StelSkyCultureMgr;
 //! Implements the main API services, including the \c status operation which can be repeatedly polled to find the current state of the main program,
 //! including time, view, location, StelAction and StelProperty state changes, movement, script status ...
 //!
+//! This state is collected in each frame into a StateSnapshot, so that the \c status and \c events operations
+//! are answered in the HTTP worker threads without waiting for the main thread.
+//! The snapshots are only collected while clients poll; the first request after a pause waits for the next frame.
+//! The \c events operation is a long poll: it returns the parts of the state which changed after a given frame,
+//! as soon as there are some.
+//!
 //! @see @ref rcMainService
 class MainService : public AbstractAPIService
 {
@@ -60,9 +67,11 @@ public:
 
 	MainService(QObject* parent = Q_NULLPTR);
 
-	//! Used to implement move functionality
+	//! Used to implement move functionality, and publishes the StateSnapshot of the frame
 	virtual void update(double deltaTime) Q_DECL_OVERRIDE;
 	virtual QLatin1String getPath() const Q_DECL_OVERRIDE { return QLatin1String("main"); }
+	//! The \c status and \c events operations only read the published StateSnapshot
+	virtual bool isThreadSafeGet(const QByteArray& operation) const Q_DECL_OVERRIDE;
 	//! @brief Implements the GET operations
 	//! @see @ref rcMainServiceGET
 	virtual void get(const QByteArray& operation,const APIParameters &parameters, APIServiceResponse& response) Q_DECL_OVERRIDE;
@@ -87,6 +96,11 @@ private slots:
 
 	void actionToggled(const QString& id, bool val);
 	void propertyChanged(StelProperty* prop, const QVariant &val);
+	//! Called when StelActionMgr registers a new action, to read the values of all actions in the next snapshot
+	void actionAdded();
+
+	//! Make sure a frame is drawn soon, even if the frame rate is reduced while nothing happens
+	void requestFrame();
 
 private:
 	StelCore* core;
@@ -102,27 +116,33 @@ private:
 	double moveX,moveY;
 	qint64 lastMoveUpdateTime;
 
-	struct ActionCacheEntry
-	{
-		ActionCacheEntry(const QString& str,bool val) : action(str),val(val) {}
-		QString action;
-		bool val;
-	};
-
-	//lists the recently toggled actions - this is a pseudo-circular buffer
-	QContiguousCache<ActionCacheEntry> actionCache;
-	QMutex actionMutex;
-	QJsonObject getActionChangesSinceID(int changeId);
-
-	struct PropertyCacheEntry
-	{
-		PropertyCacheEntry(const QString& str, const QVariant& val) : id(str),val(val) {}
-		QString id;
-		QVariant val;
-	};
-	QContiguousCache<PropertyCacheEntry> propCache;
-	QMutex propMutex;
-	QJsonObject getPropertyChangesSinceID(int changeId);
+	//! Collects the state of the current frame into a snapshot and publishes it.
+	void publishSnapshot();
+	//! Writes the parts of the snapshot changed after the frame \p since, see the \c events operation
+	QJsonObject getChangesSinceSerial(const StateSnapshot& snapshot, qint64 since, const QByteArrayList& parts) const;
+	//! Asks the main thread to keep publishing snapshots, and to keep their selection info updated if \p withSelectionInfo is set.
+	//! Returns a current snapshot, waiting for the next frame if the snapshots were paused.
+	StateSnapshot getSnapshot(bool withSelectionInfo);
+
+	//! The state being collected in the main thread
+	StateSnapshot state;
+	StateSnapshotPublisher snapshots;
+	//! The StelPropertyMgr property count when the values of properties were last read
+	int propertyCount;
+	//! Set when actions were registered after the values of actions were last read
+	bool actionsChanged;
+
+	//! Set by the worker threads when a client polled the \c status or \c events operation
+	QAtomicInt clientPolled;
+	qint64 lastClientPoll;
+	//! Set while snapshots are published in each frame
+	QAtomicInt publishing;
+
+	//! Set by the worker threads when a client asked for the selection info
+	QAtomicInt selectionInfoRequested;
+	qint64 lastSelectionInfoRequest;
+	qint64 lastSelectionInfoUpdate;
+	const StelObject* lastSelectedObject;
 };
 
 
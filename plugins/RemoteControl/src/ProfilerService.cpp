@@ -0,0 +1,81 @@
+/*
+ * Stellarium Remote Control plugin
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "ProfilerService.hpp"
+
+#include "StelApp.hpp"
+#include "StelProfiler.hpp"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+
+ProfilerService::ProfilerService(QObject *parent) : AbstractAPIService(parent)
+{
+	//this is run in the main thread
+	profiler = StelApp::getInstance().getProfiler();
+}
+
+void ProfilerService::get(const QByteArray& operation, const APIParameters &parameters, APIServiceResponse &response)
+{
+	Q_UNUSED(parameters);
+
+	if(operation=="stats")
+	{
+		//statistics of the profiled scopes over the last frames
+		QVariantMap stats;
+		QMetaObject::invokeMethod(profiler,"getStatistics",SERVICE_DEFAULT_INVOKETYPE,
+					  Q_RETURN_ARG(QVariantMap,stats));
+		stats["enabled"] = profiler->getFlagEnabled();
+		response.writeJSON(QJsonDocument(QJsonObject::fromVariantMap(stats)));
+	}
+	else
+	{
+		response.writeRequestError("unsupported operation. GET: stats");
+	}
+}
+
+void ProfilerService::post(const QByteArray& operation, const APIParameters &parameters, const QByteArray &data, APIServiceResponse &response)
+{
+	Q_UNUSED(data);
+
+	if(operation=="trace")
+	{
+		//record the next frames to a Chrome trace file
+		//parameters: frames (default 100), file (relative to the user directory, default trace.json)
+		int frames = 100;
+		bool ok = true;
+		if(parameters.contains("frames"))
+			frames = QString::fromUtf8(parameters.value("frames")).toInt(&ok);
+		if(!ok || frames <= 0)
+		{
+			response.writeRequestError("invalid frames parameter");
+			return;
+		}
+		QString file = QString::fromUtf8(parameters.value("file"));
+
+		QMetaObject::invokeMethod(profiler,"startTrace",SERVICE_DEFAULT_INVOKETYPE,
+					  Q_ARG(int,frames),
+					  Q_ARG(QString,file));
+		response.setData("ok");
+	}
+	else
+	{
+		response.writeRequestError("unsupported operation. POST: trace");
+	}
+}
@@ -0,0 +1,87 @@
+/*
+ * Stellarium Remote Control plugin
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "SatelliteService.hpp"
+
+#include "StelApp.hpp"
+#include "StelCore.hpp"
+#include "StelModuleMgr.hpp"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+
+SatelliteService::SatelliteService(QObject *parent) : AbstractAPIService(parent)
+{
+	//this is run in the main thread
+	core = StelApp::getInstance().getCore();
+}
+
+void SatelliteService::get(const QByteArray& operation, const APIParameters &parameters, APIServiceResponse &response)
+{
+	if(operation=="passes")
+	{
+		//passes of satellites over the current location
+		//parameters: start (JD, default: current date), days (default 1), minalt (degrees, default 0),
+		//ids (comma-separated catalog numbers, default: whole catalog), visible (only visible passes)
+		StelModule* satellites = StelApp::getInstance().getModuleMgr().getModule("Satellites", true);
+		if(!satellites)
+		{
+			response.setStatus(404,"not found");
+			response.setData("Satellites plugin not loaded");
+			return;
+		}
+
+		bool ok = true;
+		double startJD = core->getJD();
+		if(parameters.contains("start"))
+			startJD = QString::fromUtf8(parameters.value("start")).toDouble(&ok);
+		double days = 1.;
+		if(ok && parameters.contains("days"))
+			days = QString::fromUtf8(parameters.value("days")).toDouble(&ok);
+		double minAltitude = 0.;
+		if(ok && parameters.contains("minalt"))
+			minAltitude = QString::fromUtf8(parameters.value("minalt")).toDouble(&ok);
+		if(!ok || days <= 0.)
+		{
+			response.writeRequestError("invalid start, days or minalt parameter");
+			return;
+		}
+
+		QStringList ids;
+		if(parameters.contains("ids"))
+			ids = QString::fromUtf8(parameters.value("ids")).split(',', QString::SkipEmptyParts);
+		QString visible = QString::fromUtf8(parameters.value("visible"));
+		bool visibleOnly = (visible == "true" || visible == "1");
+
+		QVariantList passes;
+		QMetaObject::invokeMethod(satellites,"getPassPredictions",SERVICE_DEFAULT_INVOKETYPE,
+					  Q_RETURN_ARG(QVariantList,passes),
+					  Q_ARG(double,startJD),
+					  Q_ARG(double,days),
+					  Q_ARG(double,minAltitude),
+					  Q_ARG(QStringList,ids),
+					  Q_ARG(bool,visibleOnly));
+
+		response.writeJSON(QJsonDocument(QJsonArray::fromVariantList(passes)));
+	}
+	else
+	{
+		response.writeRequestError("unsupported operation. GET: passes");
+	}
+}
@@ -0,0 +1,46 @@
+/*
+ * Stellarium Remote Control plugin
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef SATELLITESERVICE_HPP
+#define SATELLITESERVICE_HPP
+
+#include "AbstractAPIService.hpp"
+
+class StelCore;
+
+//! @ingroup remoteControl
+//! Provides satellite pass predictions of the Satellites plugin.
+//! The plugin is accessed through its slots, so this service only works when it is loaded.
+//!
+//! @see \ref rcSatelliteService
+class SatelliteService : public AbstractAPIService
+{
+	Q_OBJECT
+public:
+	SatelliteService(QObject* parent = Q_NULLPTR);
+
+	virtual QLatin1String getPath() const Q_DECL_OVERRIDE { return QLatin1String("satellites"); }
+	//! @brief Implements the HTTP GET operations
+	//! @see \ref rcSatelliteServiceGET
+	virtual void get(const QByteArray& operation,const APIParameters& parameters, APIServiceResponse& response) Q_DECL_OVERRIDE;
+private:
+	StelCore* core;
+};
+
+#endif
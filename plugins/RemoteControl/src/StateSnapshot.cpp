@@ -0,0 +1,184 @@
+/*
+ * Stellarium Remote Control plugin
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StateSnapshot.hpp"
+
+#include <QElapsedTimer>
+#include <QMutexLocker>
+
+StateChangeLog::StateChangeLog(int capacity)
+	: capacity(capacity)
+	, lastId(-1)
+	, droppedSerial(0)
+{
+}
+
+void StateChangeLog::setValues(const QJsonObject &values)
+{
+	this->values = values;
+}
+
+void StateChangeLog::append(const QString &id, const QJsonValue &value, qint64 serial)
+{
+	values.insert(id, value);
+	Change change;
+	change.id = id;
+	change.value = value;
+	change.serial = serial;
+	changes.append(change);
+	++lastId;
+	if(changes.size() > capacity)
+	{
+		droppedSerial = changes.first().serial;
+		changes.removeFirst();
+	}
+}
+
+QJsonObject StateChangeLog::getChangesSinceID(int changeId) const
+{
+	//changeId is the last id the interface is available
+	//or -2 if the interface just started
+	// -1 means the initial state was set
+	QJsonObject obj;
+	QJsonObject result;
+	int newId = changeId;
+
+	if(lastId<0)
+	{
+		if(changeId!=-1)
+		{
+			//this is either the initial state (-2) or
+			//something is "broken", probably from an existing web interface that reconnected after restart
+			//force a full reload
+			result = values;
+			newId = -1;
+		}
+	}
+	else
+	{
+		const int firstId = lastId - changes.size() + 1;
+		if(changeId > lastId || changeId < firstId-1)
+		{
+			//this is either the initial state (-2) or
+			//"broken" state again, force full reload
+			result = values;
+			newId = lastId;
+		}
+		else if(changeId < lastId)
+		{
+			//create a "diff" between changeId to lastId
+			for(int i = changeId+1-firstId; i<changes.size(); ++i)
+				result.insert(changes.at(i).id, changes.at(i).value);
+			newId = lastId;
+		}
+		//else no changes happened, interface is at current state!
+	}
+
+	obj.insert("changes",result);
+	obj.insert("id",newId);
+	return obj;
+}
+
+QJsonObject StateChangeLog::getChangesSinceSerial(qint64 serial) const
+{
+	QJsonObject obj;
+	if(serial<=0 || serial<droppedSerial)
+	{
+		obj.insert("changes",values);
+		obj.insert("full",true);
+		return obj;
+	}
+
+	int first = changes.size();
+	while(first>0 && changes.at(first-1).serial>serial)
+		--first;
+	QJsonObject result;
+	for(int i=first; i<changes.size(); ++i)
+		result.insert(changes.at(i).id, changes.at(i).value);
+	obj.insert("changes",result);
+	obj.insert("full",false);
+	return obj;
+}
+
+StateSnapshotPublisher::StateSnapshotPublisher()
+	: current(new StateSnapshot())
+{
+}
+
+StateSnapshotPublisher::~StateSnapshotPublisher()
+{
+	delete current.loadAcquire();
+	qDeleteAll(retired);
+}
+
+void StateSnapshotPublisher::publish(StateSnapshot *snapshot)
+{
+	retired.append(current.fetchAndStoreOrdered(snapshot));
+	//readers starting after the swap get the new snapshot,
+	//so the old ones can be deleted as soon as no reader is active
+	if(readers.fetchAndAddOrdered(0)==0)
+	{
+		qDeleteAll(retired);
+		retired.clear();
+	}
+
+	if(waiting.fetchAndAddOrdered(0)>0)
+	{
+		QMutexLocker locker(&waitMutex);
+		published.wakeAll();
+	}
+}
+
+StateSnapshot StateSnapshotPublisher::get() const
+{
+	readers.ref();
+	const StateSnapshot snapshot = *current.loadAcquire();
+	readers.deref();
+	return snapshot;
+}
+
+qint64 StateSnapshotPublisher::getSerial() const
+{
+	readers.ref();
+	const qint64 serial = current.loadAcquire()->serial;
+	readers.deref();
+	return serial;
+}
+
+bool StateSnapshotPublisher::waitForSerial(qint64 serial, int timeout) const
+{
+	QElapsedTimer timer;
+	timer.start();
+	//the publisher only takes the mutex if somebody is waiting
+	waiting.ref();
+	QMutexLocker locker(&waitMutex);
+	bool result = true;
+	while(getSerial()<=serial)
+	{
+		const qint64 remaining = timeout - timer.elapsed();
+		if(remaining<=0)
+		{
+			result = false;
+			break;
+		}
+		published.wait(&waitMutex, static_cast<unsigned long>(remaining));
+	}
+	waiting.deref();
+	return result;
+}
@@ -0,0 +1,147 @@
+/*
+ * Stellarium Remote Control plugin
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef STATESNAPSHOT_HPP
+#define STATESNAPSHOT_HPP
+
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QJsonObject>
+#include <QMutex>
+#include <QVector>
+#include <QWaitCondition>
+
+//! @ingroup remoteControl
+//! The values of a set of named states (like the checked StelActions or the StelProperties),
+//! and the list of their recent changes.
+//! Each change has an id, which is used by the \c status operation of MainService, and the serial of the frame in which it
+//! was published, which is used by the \c events operation.
+class StateChangeLog
+{
+public:
+	//! @param capacity the number of recent changes kept
+	StateChangeLog(int capacity = 100);
+
+	//! Replace the values of all states, e.g. after new states were registered. The recent changes are kept.
+	void setValues(const QJsonObject& values);
+	//! Return the values of all states.
+	const QJsonObject& getValues() const { return values; }
+	//! Record the change of a state.
+	//! @param serial the serial of the frame which publishes the change
+	void append(const QString& id, const QJsonValue& value, qint64 serial);
+
+	//! Return an object with the states changed after the change \p changeId as \c changes, and the id of the last change as \c id.
+	//! All states are returned if the changes since \p changeId are not known anymore, or if \p changeId is -2 (a new client).
+	//! -1 means that the client knows the state before the first change.
+	QJsonObject getChangesSinceID(int changeId) const;
+	//! Return an object with the states changed after the frame \p serial as \c changes.
+	//! All states are returned, and \c full is true, if the changes since then are not known anymore or \p serial is 0.
+	QJsonObject getChangesSinceSerial(qint64 serial) const;
+	//! Return the serial of the frame of the last change, or 0 if there was no change.
+	qint64 getLastSerial() const { return changes.isEmpty() ? 0 : changes.last().serial; }
+
+private:
+	struct Change
+	{
+		QString id;
+		QJsonValue value;
+		qint64 serial;
+	};
+
+	int capacity;
+	QJsonObject values;
+	//! The recent changes, the last one has the id lastId
+	QVector<Change> changes;
+	int lastId;
+	//! The serial of the last change that was removed from the list
+	qint64 droppedSerial;
+};
+
+//! @ingroup remoteControl
+//! The state of the main program which is shown by the remote control clients, as it was at the end of a frame.
+//! Each part has the serial of the frame in which it last changed, so that clients can be sent only the changed parts.
+struct StateSnapshot
+{
+	StateSnapshot()
+		: serial(0)
+		, locationSerial(0)
+		, timeSerial(0)
+		, viewSerial(0)
+		, selectionSerial(0)
+		, selectionInfoValid(false)
+	{
+	}
+
+	//! The serial of the frame, increasing from 1
+	qint64 serial;
+	qint64 locationSerial;
+	qint64 timeSerial;
+	qint64 viewSerial;
+	qint64 selectionSerial;
+
+	QJsonObject location;
+	QJsonObject time;
+	QJsonObject view;
+	//! The info string of the selected object
+	QString selectionInfo;
+	//! False if the selection info was not updated recently, because no client asked for it
+	bool selectionInfoValid;
+	StateChangeLog actions;
+	StateChangeLog properties;
+};
+
+//! @ingroup remoteControl
+//! Publishes the StateSnapshot of each frame from the main thread to the HTTP worker threads.
+//! The snapshots are immutable once published, and the current one is replaced with an atomic pointer swap.
+//! Readers take a copy of it without locks; the main thread deletes replaced snapshots only when no reader is active.
+//! Worker threads can also wait for the next snapshot, which blocks only the waiting thread.
+class StateSnapshotPublisher
+{
+public:
+	StateSnapshotPublisher();
+	//! No reader may be active anymore.
+	~StateSnapshotPublisher();
+
+	//! Publish a new snapshot, from the main thread. The publisher takes the ownership of the snapshot.
+	void publish(StateSnapshot* snapshot);
+	//! Return a copy of the current snapshot. Never blocks, the data is implicitly shared.
+	StateSnapshot get() const;
+	//! Return the serial of the current snapshot.
+	qint64 getSerial() const;
+	//! Wait until a snapshot with a serial larger than \p serial is published.
+	//! @param timeout milliseconds
+	//! @return false on timeout
+	bool waitForSerial(qint64 serial, int timeout) const;
+
+private:
+	Q_DISABLE_COPY(StateSnapshotPublisher)
+
+	QAtomicPointer<StateSnapshot> current;
+	//! The number of threads reading the current snapshot
+	mutable QAtomicInt readers;
+	//! Replaced snapshots which may still be read, only used by the main thread
+	QVector<StateSnapshot*> retired;
+
+	//! The number of threads in waitForSerial()
+	mutable QAtomicInt waiting;
+	mutable QMutex waitMutex;
+	mutable QWaitCondition published;
+};
+
+#endif
@@ -0,0 +1,493 @@
+/*
+ * Stellarium Remote Control plugin
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "testStateSnapshot.hpp"
+#include "APIController.hpp"
+#include "httpserver/httplistener.h"
+
+#include <QJsonDocument>
+#include <QTcpSocket>
+#include <QThread>
+
+#include <algorithm>
+
+QTEST_GUILESS_MAIN(TestStateSnapshot)
+
+namespace
+{
+//! Keeps the thread busy, like the drawing of a frame
+void spin(double ms)
+{
+	QElapsedTimer timer;
+	timer.start();
+	while(timer.nsecsElapsed() < ms*1e6) {}
+}
+
+//! Returns the 95th percentile
+double getPercentile95(QVector<double> values)
+{
+	if(values.isEmpty())
+		return 0.;
+	std::sort(values.begin(), values.end());
+	return values.at(values.size()*95/100);
+}
+
+//! Reads a complete HTTP response with a Content-Length header
+bool readResponse(QTcpSocket& socket, QByteArray& body)
+{
+	QByteArray data;
+	int headerEnd;
+	while((headerEnd = data.indexOf("\r\n\r\n")) < 0)
+	{
+		if(!socket.waitForReadyRead(10000))
+			return false;
+		data += socket.readAll();
+	}
+	const QByteArray header = data.left(headerEnd).toLower();
+	const int idx = header.indexOf("content-length:");
+	if(!header.startsWith("http/1.1 200") || idx < 0)
+		return false;
+	const int end = header.indexOf("\r\n", idx);
+	const int length = header.mid(idx+15, end<0 ? -1 : end-idx-15).trimmed().toInt();
+	while(data.size() < headerEnd+4+length)
+	{
+		if(!socket.waitForReadyRead(10000))
+			return false;
+		data += socket.readAll();
+	}
+	body = data.mid(headerEnd+4, length);
+	return true;
+}
+
+//! A remote control client on a keep-alive connection.
+//! It either polls every 100 ms and measures the request latency, or long-polls the events
+//! and measures the delay between the publication of a snapshot and its reception.
+class LoadClient : public QThread
+{
+public:
+	LoadClient(quint16 port, const QByteArray& path, bool longPoll, const QElapsedTimer& clock, qint64 endTime)
+		: errors(0), port(port), path(path), longPoll(longPoll), clock(clock), endTime(endTime)
+	{
+	}
+
+	QVector<double> latencies;
+	int errors;
+
+protected:
+	virtual void run() Q_DECL_OVERRIDE
+	{
+		QTcpSocket socket;
+		socket.connectToHost(QHostAddress::LocalHost, port);
+		if(!socket.waitForConnected(5000))
+		{
+			++errors;
+			return;
+		}
+		qint64 since = 0;
+		while(clock.elapsed() < endTime)
+		{
+			QByteArray request = "GET " + path;
+			if(longPoll)
+				request += "?since=" + QByteArray::number(since);
+			request += " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+			const double start = clock.nsecsElapsed()/1e6;
+			socket.write(request);
+			socket.waitForBytesWritten(5000);
+			QByteArray body;
+			if(!readResponse(socket, body))
+			{
+				++errors;
+				return;
+			}
+			const double now = clock.nsecsElapsed()/1e6;
+			const QJsonObject obj = QJsonDocument::fromJson(body).object();
+			if(longPoll)
+			{
+				//each reply is a newer snapshot
+				if(obj.value("serial").toDouble() <= since)
+					++errors;
+				since = static_cast<qint64>(obj.value("serial").toDouble());
+				latencies << now - obj.value("time").toObject().value("published").toDouble();
+			}
+			else
+			{
+				latencies << now - start;
+				QThread::msleep(100);
+			}
+		}
+	}
+
+private:
+	quint16 port;
+	QByteArray path;
+	bool longPoll;
+	const QElapsedTimer& clock;
+	qint64 endTime;
+};
+
+//! Reads snapshots until stopped, and checks that each one is consistent and newer than the last one
+class SnapshotReader : public QThread
+{
+public:
+	SnapshotReader(const StateSnapshotPublisher& publisher) : reads(0), errors(0), publisher(publisher) {}
+
+	QAtomicInt stop;
+	int reads;
+	int errors;
+
+protected:
+	virtual void run() Q_DECL_OVERRIDE
+	{
+		qint64 last = 0;
+		while(!stop.loadAcquire())
+		{
+			const StateSnapshot snapshot = publisher.get();
+			if(snapshot.serial < last)
+				++errors;
+			else if(snapshot.serial > 0
+			   && (snapshot.selectionInfo != QString::number(snapshot.serial)
+			   || snapshot.time.value("jday").toDouble() != static_cast<double>(snapshot.serial)
+			   || snapshot.properties.getValues().size() != 50))
+				++errors;
+			last = snapshot.serial;
+			++reads;
+		}
+	}
+
+private:
+	const StateSnapshotPublisher& publisher;
+};
+
+//! Waits for the snapshot after serial
+class SnapshotWaiter : public QThread
+{
+public:
+	SnapshotWaiter(const StateSnapshotPublisher& publisher, qint64 serial) : result(false), elapsed(0), publisher(publisher), serial(serial) {}
+
+	bool result;
+	qint64 elapsed;
+
+protected:
+	virtual void run() Q_DECL_OVERRIDE
+	{
+		QElapsedTimer timer;
+		timer.start();
+		result = publisher.waitForSerial(serial, 5000);
+		elapsed = timer.elapsed();
+	}
+
+private:
+	const StateSnapshotPublisher& publisher;
+	qint64 serial;
+};
+}
+
+void LoadTestService::get(const QByteArray &operation, const APIParameters &parameters, APIServiceResponse &response)
+{
+	response.setHeader("Content-Type","application/json; charset=utf-8");
+	if(operation=="blocking")
+	{
+		//like the status operation before the snapshots, which was answered by the main thread between frames
+		QByteArray data;
+		QMetaObject::invokeMethod(this,"getStatus",Qt::BlockingQueuedConnection,
+					  Q_RETURN_ARG(QByteArray,data));
+		response.setData(data);
+	}
+	else if(operation=="snapshot")
+	{
+		response.setData(toJson(snapshots.get()));
+	}
+	else if(operation=="events")
+	{
+		snapshots.waitForSerial(parameters.value("since").toLongLong(), 5000);
+		response.setData(toJson(snapshots.get()));
+	}
+	else
+	{
+		response.writeRequestError("unsupported operation. GET: blocking, snapshot, events");
+	}
+}
+
+void LoadTestService::post(const QByteArray &operation, const APIParameters &parameters, const QByteArray &data, APIServiceResponse &response)
+{
+	Q_UNUSED(operation)
+	Q_UNUSED(parameters)
+	Q_UNUSED(data)
+	response.writeRequestError("unsupported operation");
+}
+
+void LoadTestService::update(double deltaTime)
+{
+	Q_UNUSED(deltaTime)
+	++state.serial;
+	QJsonObject time;
+	time.insert("jday", 2451545.0 + state.serial/86400.);
+	time.insert("published", clock.nsecsElapsed()/1e6);
+	state.time = time;
+	state.timeSerial = state.serial;
+	if(publishSnapshots)
+	{
+		//the info string of the selected object, which MainService updates at most every 100 ms
+		if(state.serial%6==0)
+			spin(0.2);
+		state.selectionInfo = QString("Info %1").arg(state.serial);
+		snapshots.publish(new StateSnapshot(state));
+	}
+}
+
+QByteArray LoadTestService::getStatus()
+{
+	spin(0.2);
+	StateSnapshot snapshot = state;
+	snapshot.selectionInfo = QString("Info %1").arg(state.serial);
+	return toJson(snapshot);
+}
+
+QByteArray LoadTestService::toJson(const StateSnapshot &snapshot) const
+{
+	QJsonObject obj;
+	obj.insert("serial", static_cast<double>(snapshot.serial));
+	obj.insert("time", snapshot.time);
+	obj.insert("selectioninfo", snapshot.selectionInfo);
+	return QJsonDocument(obj).toJson(QJsonDocument::Compact);
+}
+
+void TestStateSnapshot::testChangesSinceID()
+{
+	StateChangeLog log(5);
+	QJsonObject values;
+	values.insert("a", false);
+	values.insert("b", 1);
+	log.setValues(values);
+
+	// No change yet
+	QJsonObject obj = log.getChangesSinceID(-2);
+	QCOMPARE(obj.value("id").toInt(), -1);
+	QVERIFY(obj.value("changes").toObject()==values);
+	obj = log.getChangesSinceID(-1);
+	QCOMPARE(obj.value("id").toInt(), -1);
+	QVERIFY(obj.value("changes").toObject().isEmpty());
+
+	log.append("a", true, 1);
+	log.append("b", 2, 1);
+	log.append("b", 3, 2);
+	obj = log.getChangesSinceID(-1);
+	QCOMPARE(obj.value("id").toInt(), 2);
+	QCOMPARE(obj.value("changes").toObject().size(), 2);
+	QCOMPARE(obj.value("changes").toObject().value("a").toBool(), true);
+	QCOMPARE(obj.value("changes").toObject().value("b").toInt(), 3);
+	obj = log.getChangesSinceID(1);
+	QCOMPARE(obj.value("id").toInt(), 2);
+	QCOMPARE(obj.value("changes").toObject().size(), 1);
+	QCOMPARE(obj.value("changes").toObject().value("b").toInt(), 3);
+	obj = log.getChangesSinceID(2);
+	QCOMPARE(obj.value("id").toInt(), 2);
+	QVERIFY(obj.value("changes").toObject().isEmpty());
+	// A new client and a client from before a restart get all values
+	for (int id : {-2, 3, 100})
+	{
+		obj = log.getChangesSinceID(id);
+		QCOMPARE(obj.value("id").toInt(), 2);
+		QVERIFY(obj.value("changes").toObject()==log.getValues());
+	}
+
+	// More changes than the capacity, the ids 8 to 12 are kept
+	for (int i=0; i<10; ++i)
+		log.append("c", i, 3+i);
+	QCOMPARE(log.getValues().size(), 3);
+	obj = log.getChangesSinceID(2);
+	QCOMPARE(obj.value("id").toInt(), 12);
+	QVERIFY(obj.value("changes").toObject()==log.getValues());
+	obj = log.getChangesSinceID(7);
+	QCOMPARE(obj.value("id").toInt(), 12);
+	QCOMPARE(obj.value("changes").toObject().size(), 1);
+	QCOMPARE(obj.value("changes").toObject().value("c").toInt(), 9);
+}
+
+void TestStateSnapshot::testChangesSinceSerial()
+{
+	StateChangeLog log(3);
+	QCOMPARE(log.getLastSerial(), 0LL);
+	log.append("a", 1, 2);
+	log.append("b", 1, 2);
+	log.append("a", 2, 4);
+	QCOMPARE(log.getLastSerial(), 4LL);
+
+	QJsonObject obj = log.getChangesSinceSerial(0);
+	QVERIFY(obj.value("full").toBool());
+	QVERIFY(obj.value("changes").toObject()==log.getValues());
+	obj = log.getChangesSinceSerial(1);
+	QVERIFY(!obj.value("full").toBool());
+	QCOMPARE(obj.value("changes").toObject().size(), 2);
+	QCOMPARE(obj.value("changes").toObject().value("a").toInt(), 2);
+	obj = log.getChangesSinceSerial(2);
+	QCOMPARE(obj.value("changes").toObject().size(), 1);
+	QCOMPARE(obj.value("changes").toObject().value("a").toInt(), 2);
+	obj = log.getChangesSinceSerial(4);
+	QVERIFY(obj.value("changes").toObject().isEmpty());
+
+	// The first change of frame 2 is dropped, so the changes since frame 1 are not known anymore
+	log.append("c", 1, 5);
+	obj = log.getChangesSinceSerial(1);
+	QVERIFY(obj.value("full").toBool());
+	QCOMPARE(obj.value("changes").toObject().size(), 3);
+	obj = log.getChangesSinceSerial(2);
+	QVERIFY(!obj.value("full").toBool());
+	QCOMPARE(obj.value("changes").toObject().size(), 2);
+}
+
+void TestStateSnapshot::testConcurrentReaders()
+{
+	StateSnapshotPublisher publisher;
+	QVector<SnapshotReader*> readers;
+	for (int i=0; i<4; ++i)
+	{
+		readers << new SnapshotReader(publisher);
+		readers.last()->start();
+	}
+
+	StateSnapshot state;
+	for (int i=0; i<50; ++i)
+		state.properties.append(QString("prop%1").arg(i), i, 1);
+	const int n = 20000;
+	for (int i=1; i<=n; ++i)
+	{
+		state.serial = i;
+		QJsonObject time;
+		time.insert("jday", static_cast<double>(i));
+		state.time = time;
+		state.selectionInfo = QString::number(i);
+		state.properties.append(QString("prop%1").arg(i%50), i, i);
+		publisher.publish(new StateSnapshot(state));
+		if(i%1000==0)
+			QThread::yieldCurrentThread();
+	}
+
+	int reads = 0;
+	for (auto* reader : readers)
+	{
+		reader->stop.storeRelease(1);
+		reader->wait();
+		QCOMPARE(reader->errors, 0);
+		reads += reader->reads;
+		delete reader;
+	}
+	QVERIFY(reads>0);
+	QCOMPARE(publisher.getSerial(), static_cast<qint64>(n));
+	QCOMPARE(publisher.get().selectionInfo, QString::number(n));
+}
+
+void TestStateSnapshot::testWaitForSerial()
+{
+	StateSnapshotPublisher publisher;
+	QCOMPARE(publisher.getSerial(), 0LL);
+	QVERIFY(!publisher.waitForSerial(0, 20));
+
+	SnapshotWaiter waiter(publisher, 0);
+	waiter.start();
+	QThread::msleep(50);
+	StateSnapshot* snapshot = new StateSnapshot();
+	snapshot->serial = 1;
+	publisher.publish(snapshot);
+	QVERIFY(waiter.wait(5000));
+	QVERIFY(waiter.result);
+	QVERIFY(waiter.elapsed < 4000);
+
+	// Returns at once when the snapshot is already there
+	QVERIFY(publisher.waitForSerial(0, 0));
+	QVERIFY(!publisher.waitForSerial(1, 0));
+}
+
+void TestStateSnapshot::testLoad_data()
+{
+	QTest::addColumn<QByteArray>("operation");
+	QTest::newRow("blocking") << QByteArray("blocking");
+	QTest::newRow("snapshot") << QByteArray("snapshot");
+	QTest::newRow("events") << QByteArray("events");
+}
+
+void TestStateSnapshot::testLoad()
+{
+	// A dozen tablets and a show controller polling at 10 Hz, or waiting for events, while the main thread draws 60 frames per second.
+	QFETCH(QByteArray, operation);
+	QElapsedTimer clock;
+	clock.start();
+	LoadTestService service(clock, operation!="blocking");
+	APIController controller(5);
+	controller.registerService(&service);
+	HttpListenerSettings settings;
+	settings.host = "127.0.0.1";
+	settings.port = 0;
+	settings.maxThreads = 30;
+	HttpListener listener(settings, &controller);
+	QVERIFY(listener.isListening());
+
+	const int nbClients = 13;
+	const qint64 endTime = clock.elapsed() + 3000;
+	QVector<LoadClient*> clients;
+	for (int i=0; i<nbClients; ++i)
+	{
+		clients << new LoadClient(listener.serverPort(), "/api/load/" + operation, operation=="events", clock, endTime);
+		clients.last()->start();
+	}
+
+	// The main thread processes the queued requests between the frames, like the event loop
+	QVector<double> lateness;
+	const double period = 1e9/60.;
+	const qint64 start = clock.nsecsElapsed();
+	bool running = true;
+	for (int frame=1; running; ++frame)
+	{
+		const qint64 scheduled = start + static_cast<qint64>(frame*period);
+		while(clock.nsecsElapsed() < scheduled)
+		{
+			QCoreApplication::processEvents();
+			QThread::usleep(100);
+		}
+		lateness << (clock.nsecsElapsed() - scheduled)/1e6;
+
+		spin(2.);
+		service.update(period/1e9);
+		QCoreApplication::processEvents();
+
+		running = false;
+		for (const auto* client : clients)
+			running = running || !client->isFinished();
+	}
+
+	QVector<double> latencies;
+	int errors = 0;
+	for (auto* client : clients)
+	{
+		latencies += client->latencies;
+		errors += client->errors;
+		delete client;
+	}
+	QCOMPARE(errors, 0);
+	QVERIFY(latencies.size() >= nbClients);
+
+	// Answering the clients doesn't delay the frames
+	const double frameMs = period/1e6;
+	QVERIFY2(getPercentile95(lateness) < frameMs, qPrintable(QString("frame start delay %1 ms").arg(getPercentile95(lateness))));
+	// Blocking requests wait for the end of a frame. The snapshots are read, or sent after their publication,
+	// without waiting for the main thread.
+	const double maxLatency = operation=="blocking" ? 10*frameMs : frameMs;
+	QVERIFY2(getPercentile95(latencies) < maxLatency, qPrintable(QString("latency %1 ms").arg(getPercentile95(latencies))));
+}
@@ -0,0 +1,72 @@
+/*
+ * Stellarium Remote Control plugin
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef TESTSTATESNAPSHOT_HPP
+#define TESTSTATESNAPSHOT_HPP
+
+#include <QtTest>
+#include <QElapsedTimer>
+
+#include "RemoteControlServiceInterface.hpp"
+#include "StateSnapshot.hpp"
+
+//! A service answering like MainService, either from the main thread or from the published snapshots.
+//! GET load/blocking waits for the main thread, load/snapshot reads the last snapshot,
+//! and load/events?since=serial waits for the next snapshot.
+class LoadTestService : public QObject, public RemoteControlServiceInterface
+{
+	Q_OBJECT
+	Q_INTERFACES(RemoteControlServiceInterface)
+public:
+	//! @param publishSnapshots false to simulate the main thread before snapshots, which collected the state for each request
+	LoadTestService(const QElapsedTimer& clock, bool publishSnapshots) : clock(clock), publishSnapshots(publishSnapshots) {}
+
+	virtual QLatin1String getPath() const Q_DECL_OVERRIDE { return QLatin1String("load"); }
+	virtual bool isThreadSafe() const Q_DECL_OVERRIDE { return true; }
+	virtual void get(const QByteArray& operation, const APIParameters& parameters, APIServiceResponse& response) Q_DECL_OVERRIDE;
+	virtual void post(const QByteArray& operation, const APIParameters& parameters, const QByteArray& data, APIServiceResponse& response) Q_DECL_OVERRIDE;
+	//! Advances the state by one frame, and collects and publishes it like MainService
+	virtual void update(double deltaTime) Q_DECL_OVERRIDE;
+
+private slots:
+	//! Answers a status request in the main thread
+	QByteArray getStatus();
+
+private:
+	QByteArray toJson(const StateSnapshot& snapshot) const;
+
+	const QElapsedTimer& clock;
+	bool publishSnapshots;
+	StateSnapshot state;
+	StateSnapshotPublisher snapshots;
+};
+
+class TestStateSnapshot : public QObject
+{
+Q_OBJECT
+private slots:
+	void testChangesSinceID();
+	void testChangesSinceSerial();
+	void testConcurrentReaders();
+	void testWaitForSerial();
+	void testLoad_data();
+	void testLoad();
+};
+
+#endif // TESTSTATESNAPSHOT_HPP
@@ -803,24 +803,8 @@ void Satellite::update(double)
 		velocity                 = pSatWrapper->getTEMEVel();
 		latLongSubPointPosition  = pSatWrapper->getSubPoint();
 		height                   = latLongSubPointPosition[2]; // km
-		if (height < 80.0)
-		{
-			// The orbit is no longer valid.  Causes include very out of date
-			// TLE, system date and time out of a reasonable range, and orbital
-			// degradation and re-entry of a satellite.  In any of these cases
-			// we might end up with a problem - usually a crash of Stellarium
-			// because of a div/0 or something.  To prevent this, we turn off
-			// the satellite when the computed height is 80km.
-			// Low Earth Orbit (LEO):
-			// A geocentric orbit with an altitude much less than the Earth's radius.
-			// Satellites in this orbit are between 80 and 2000 kilometres above
-			// the Earth's surface.
-			// Source: https://www.nasa.gov/directorates/heo/scan/definitions/glossary/index.html#L
-			qWarning() << "Satellite has invalid orbit:" << name << id;
-			orbitValid = false;
-			displayed = false; // It shouldn't be displayed!
+		if (!checkOrbitHeight())
 			return;
-		}
 
 		elAzPosition = pSatWrapper->getAltAz();
 		elAzPosition.normalize();
@@ -835,6 +819,57 @@ void Satellite::update(double)
 	}
 }
 
+void Satellite::update(const gSatBatch& batch, int index)
+{
+	if (pSatWrapper && orbitValid)
+	{
+		StelCore* core = StelApp::getInstance().getCore();
+		epochTime = core->getJD();
+
+		position                 = batch.getTEMEPos(index);
+		velocity                 = batch.getTEMEVel(index);
+		latLongSubPointPosition  = batch.getSubPoint(index);
+		height                   = latLongSubPointPosition[2]; // km
+		if (!checkOrbitHeight())
+			return;
+
+		elAzPosition = batch.getAltAz(index);
+		elAzPosition.normalize();
+		XYZ = getJ2000EquatorialPos(core);
+
+		range      = batch.getSlantRange(index);
+		rangeRate  = batch.getSlantRangeRate(index);
+		visibility = static_cast<gSatWrapper::Visibility>(batch.getVisibility(index));
+		phaseAngle = batch.getPhaseAngle(index);
+
+		// Compute orbit points to draw orbit line.
+		if (orbitDisplayed) computeOrbitPoints();
+	}
+}
+
+bool Satellite::checkOrbitHeight()
+{
+	if (height < 80.0)
+	{
+		// The orbit is no longer valid.  Causes include very out of date
+		// TLE, system date and time out of a reasonable range, and orbital
+		// degradation and re-entry of a satellite.  In any of these cases
+		// we might end up with a problem - usually a crash of Stellarium
+		// because of a div/0 or something.  To prevent this, we turn off
+		// the satellite when the computed height is 80km.
+		// Low Earth Orbit (LEO):
+		// A geocentric orbit with an altitude much less than the Earth's radius.
+		// Satellites in this orbit are between 80 and 2000 kilometres above
+		// the Earth's surface.
+		// Source: https://www.nasa.gov/directorates/heo/scan/definitions/glossary/index.html#L
+		qWarning() << "Satellite has invalid orbit:" << name << id;
+		orbitValid = false;
+		displayed = false; // It shouldn't be displayed!
+		return false;
+	}
+	return true;
+}
+
 double Satellite::getDoppler(double freq) const
 {
 	return  -freq*((rangeRate*1000.0)/SPEED_OF_LIGHT);
@@ -1064,6 +1099,9 @@ void Satellite::computeOrbitPoints()
 	gTime epoch(epochTime);
 	gTime lastEpochComp(lastEpochCompForOrbit);	
 	int diffSlots;
+	// The orbit points move the epoch shared by all satellites, it is set back for the others and the magnitudes
+	const double frameEpoch = gSatWrapper::getEpoch().getGmtTm();
+	bool epochMoved = false;
 
 	if (orbitPoints.isEmpty())//Setup orbitPoints
 	{
@@ -1077,6 +1115,7 @@ void Satellite::computeOrbitPoints()
 			epochTm    += computeInterval;
 		}
 		lastEpochCompForOrbit = epochTime;
+		epochMoved = true;
 	}
 	else if (epochTime > lastEpochCompForOrbit)
 	{
@@ -1108,6 +1147,7 @@ void Satellite::computeOrbitPoints()
 			}
 
 			lastEpochCompForOrbit = epochTime;
+			epochMoved = true;
 		}
 	}
 	else if (epochTime < lastEpochCompForOrbit)
@@ -1137,8 +1177,12 @@ void Satellite::computeOrbitPoints()
 				epochTm -= computeInterval;
 			}
 			lastEpochCompForOrbit = epochTime;
+			epochMoved = true;
 		}
 	}
+
+	if (epochMoved)
+		pSatWrapper->setEpoch(frameEpoch);
 }
 
 bool operator <(const SatelliteP& left, const SatelliteP& right)
@@ -197,6 +197,10 @@ public:
 
 	// calculate faders, new position
 	void update(double deltaTime);
+	//! Same as update(double), but take the position from a batch propagation
+	//! of the catalog made by Satellites::update().
+	//! @param index the index of this satellite in @a batch
+	void update(const gSatBatch& batch, int index);
 
 	double getDoppler(double freq) const;
 	static bool showLabels;
@@ -310,6 +314,9 @@ private:
 	static double timeRateLimit;
 
 	void draw(StelCore *core, StelPainter& painter);
+	//! Disable the satellite when the computed height shows that its orbit is no longer valid.
+	//! @return false when the satellite has been disabled.
+	bool checkOrbitHeight();
 
 	//Satellite Orbit Position calculation
 	gSatWrapper *pSatWrapper;
@@ -0,0 +1,403 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "SatellitePassPredictor.hpp"
+#include "gSatWrapper.hpp"
+
+#include "gsatellite/gTime.hpp"
+#include "gsatellite/stdsat.h"
+
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	//! Precision of the refined times (one second)
+	const double TIME_PRECISION = 1./86400.;
+	//! Local altitude maxima this close below the horizon are refined to find grazing passes (degrees)
+	const double GRAZING_MARGIN = 5.;
+	//! Sampling step limits (minutes)
+	const double MIN_STEP = 0.5;
+	const double MAX_STEP = 10.;
+	//! Number of samples per orbital period
+	const double SAMPLES_PER_ORBIT = 40.;
+	//! Sampling step of the visible part of a pass (days) and maximum number of samples
+	const double VISIBILITY_STEP = 30./86400.;
+	const int MAX_VISIBILITY_SAMPLES = 200;
+	//! Margin of the culling test (radians)
+	const double CULLING_MARGIN = 1.*KDEG2RAD;
+	//! Fraction of the shortest time to rise used as sampling step when a satellite is far below the horizon
+	const double SKIP_SAFETY = 0.8;
+	const double GOLDEN_RATIO = 0.5*(std::sqrt(5.) - 1.);
+
+	double normalizedAzimuth(double south, double east)
+	{
+		double azimuth = std::atan2(east, -south)/KDEG2RAD;
+		if (azimuth < 0.)
+			azimuth += 360.;
+		return azimuth;
+	}
+}
+
+SatellitePassPredictor::SatellitePassPredictor()
+	: latitude(0.)
+	, longitude(0.)
+	, altitude(0.)
+	, sinLatitude(0.)
+	, cosLatitude(1.)
+	, minAltitude(0.)
+	, sunAltitudeLimit(0.)
+{
+}
+
+void SatellitePassPredictor::setObserver(double latitude, double longitude, double altitude)
+{
+	this->latitude = latitude;
+	this->longitude = longitude;
+	this->altitude = altitude;
+	sinLatitude = std::sin(latitude*KDEG2RAD);
+	cosLatitude = std::cos(latitude*KDEG2RAD);
+}
+
+void SatellitePassPredictor::addSatellite(const QString& id, const QString& name, const elsetrec& satrec)
+{
+	Target target;
+	target.id = id;
+	target.name = name;
+	target.satrec = satrec;
+	// no is the mean motion in radians per minute
+	const double period = satrec.no > 0. ? K2PI/satrec.no : MAX_STEP*SAMPLES_PER_ORBIT;
+	target.stepDays = qBound(MIN_STEP, period/SAMPLES_PER_ORBIT, MAX_STEP)/KMIN_PER_DAY;
+	targets.append(target);
+}
+
+int SatellitePassPredictor::culledCount() const
+{
+	int count = 0;
+	Reach reach;
+	for (const auto& target : targets)
+	{
+		if (!getReach(target.satrec, reach))
+			count++;
+	}
+	return count;
+}
+
+bool SatellitePassPredictor::getReach(const elsetrec& satrec, Reach& reach) const
+{
+	if (satrec.no <= 0. || satrec.ecco >= 1.)
+		return false;
+
+	double tumin, mu, radiusearthkm, xke, j2, j3, j4, j3oj2;
+	getgravconst(wgs72, tumin, mu, radiusearthkm, xke, j2, j3, j4, j3oj2);
+
+	// Largest Earth central angle between observer and subpoint which still puts the
+	// satellite above the minimum altitude, at apogee.
+	const double apogee = std::pow(xke/satrec.no, 2./3.)*(1. + satrec.ecco)*radiusearthkm;
+	const double elevation = minAltitude*KDEG2RAD;
+	const double cosFootprint = radiusearthkm*std::cos(elevation)/apogee;
+	if (cosFootprint >= 1.)
+		return false;
+	reach.footprint = std::acos(cosFootprint) - elevation;
+
+	// The subpoint never goes further from the equator than the inclination
+	const double maxLatitude = satrec.inclo <= M_PI_2 ? satrec.inclo : M_PI - satrec.inclo;
+	if (std::fabs(latitude*KDEG2RAD) - maxLatitude > reach.footprint + CULLING_MARGIN)
+		return false;
+
+	// Fastest angular motion is at perigee, the observer adds the Earth rotation
+	const double e = satrec.ecco;
+	const double perigeeRate = satrec.no*(1. + e)*(1. + e)/std::pow(1. - e*e, 1.5);
+	reach.maxRate = (perigeeRate + KMFACTOR*KSEC_PER_MIN)*KMIN_PER_DAY;
+	return true;
+}
+
+Vec3d SatellitePassPredictor::getSunECIPos(double jd)
+{
+	// Astronomical Almanac low precision formulae for the Sun
+	const double n = jd - 2451545.0;
+	const double L = (280.460 + 0.9856474*n)*KDEG2RAD;
+	const double g = (357.528 + 0.9856003*n)*KDEG2RAD;
+	const double lambda = L + (1.915*std::sin(g) + 0.020*std::sin(2.*g))*KDEG2RAD;
+	const double epsilon = (23.439 - 0.0000004*n)*KDEG2RAD;
+	const double r = (1.00014 - 0.01671*std::cos(g) - 0.00014*std::cos(2.*g))*KAU;
+	return Vec3d(r*std::cos(lambda), r*std::cos(epsilon)*std::sin(lambda), r*std::sin(epsilon)*std::sin(lambda));
+}
+
+SatellitePassPredictor::Sample SatellitePassPredictor::sample(elsetrec& satrec, double jd) const
+{
+	Sample result;
+	result.jd = jd;
+	result.altitude = -90.;
+	result.azimuth = 0.;
+	result.visible = false;
+	result.centralAngle = M_PI;
+
+	double ro[3] = {};
+	double vo[3] = {};
+	const double tsince = ((jd - satrec.jdsatepoch) * KSEC_PER_DAY) / KSEC_PER_MIN;
+	sgp4(wgs72, satrec, tsince, ro, vo);
+	if (satrec.error != 0)
+		return result;
+
+	// Topocentric position, see gSatWrapper::getAltAz()
+	const gTime epoch(jd);
+	Vec3d observerPos, observerVel;
+	gSatWrapper::computeObserverECIPosition(epoch, latitude, longitude, altitude, observerPos, observerVel);
+	const double theta = epoch.toThetaLMST(longitude*KDEG2RAD);
+	const double sinTheta = std::sin(theta);
+	const double cosTheta = std::cos(theta);
+
+	const Vec3d satPos(ro[0], ro[1], ro[2]);
+	const Vec3d slant = satPos - observerPos;
+	const double south = sinLatitude*cosTheta*slant[0] + sinLatitude*sinTheta*slant[1] - cosLatitude*slant[2];
+	const double east = -sinTheta*slant[0] + cosTheta*slant[1];
+	const double zenith = cosLatitude*cosTheta*slant[0] + cosLatitude*sinTheta*slant[1] + sinLatitude*slant[2];
+	result.altitude = std::asin(zenith/slant.length())/KDEG2RAD;
+	result.centralAngle = observerPos.angle(satPos);
+	result.azimuth = normalizedAzimuth(south, east);
+
+	if (result.altitude >= minAltitude)
+	{
+		if (getSunAltitude(jd, theta) < sunAltitudeLimit)
+		{
+			Vec3d sunDir = getSunECIPos(jd);
+			sunDir.normalize();
+			// Cylindrical Earth shadow
+			const double along = satPos.dot(sunDir);
+			result.visible = along > 0. || (satPos - sunDir*along).length() > KEARTHRADIUS;
+		}
+	}
+	return result;
+}
+
+double SatellitePassPredictor::getSunAltitude(double jd, double theta) const
+{
+	Vec3d sunDir = getSunECIPos(jd);
+	sunDir.normalize();
+	const double zenith = cosLatitude*std::cos(theta)*sunDir[0] + cosLatitude*std::sin(theta)*sunDir[1] + sinLatitude*sunDir[2];
+	return std::asin(zenith)/KDEG2RAD;
+}
+
+SatellitePassPredictor::Sample SatellitePassPredictor::refineCrossing(elsetrec& satrec, Sample a, Sample b) const
+{
+	// keep a below and b above the minimum altitude
+	if (a.altitude >= minAltitude)
+		std::swap(a, b);
+	while (std::fabs(b.jd - a.jd) > TIME_PRECISION)
+	{
+		const Sample middle = sample(satrec, 0.5*(a.jd + b.jd));
+		if (middle.altitude >= minAltitude)
+			b = middle;
+		else
+			a = middle;
+	}
+	return b;
+}
+
+SatellitePassPredictor::Sample SatellitePassPredictor::refineMaximum(elsetrec& satrec, double a, double b) const
+{
+	double c = b - GOLDEN_RATIO*(b - a);
+	double d = a + GOLDEN_RATIO*(b - a);
+	Sample sc = sample(satrec, c);
+	Sample sd = sample(satrec, d);
+	while (b - a > TIME_PRECISION)
+	{
+		if (sc.altitude > sd.altitude)
+		{
+			b = d;
+			d = c;
+			sd = sc;
+			c = b - GOLDEN_RATIO*(b - a);
+			sc = sample(satrec, c);
+		}
+		else
+		{
+			a = c;
+			c = d;
+			sc = sd;
+			d = a + GOLDEN_RATIO*(b - a);
+			sd = sample(satrec, d);
+		}
+	}
+	return sc.altitude > sd.altitude ? sc : sd;
+}
+
+void SatellitePassPredictor::refineVisibility(elsetrec& satrec, SatellitePass& pass) const
+{
+	pass.visibleStart = pass.visibleStop = pass.aos;
+
+	const double duration = pass.los - pass.aos;
+	// Short passes in daylight are never visible, the Sun moves less than 4 degrees in a quarter hour
+	const double sunMotionMargin = 4.;
+	const double longitudeRad = longitude*KDEG2RAD;
+	if (duration < 0.01
+	    && getSunAltitude(pass.aos, gTime(pass.aos).toThetaLMST(longitudeRad)) > sunAltitudeLimit + sunMotionMargin
+	    && getSunAltitude(pass.los, gTime(pass.los).toThetaLMST(longitudeRad)) > sunAltitudeLimit + sunMotionMargin)
+		return;
+
+	const int count = qBound(2, static_cast<int>(std::ceil(duration/VISIBILITY_STEP)), MAX_VISIBILITY_SAMPLES);
+	const double step = duration/count;
+	int first = -1, last = -1;
+	QVector<bool> visible(count + 1);
+	for (int i = 0; i <= count; ++i)
+	{
+		visible[i] = sample(satrec, pass.aos + i*step).visible;
+		if (visible[i])
+		{
+			if (first < 0)
+				first = i;
+			last = i;
+		}
+	}
+	if (first < 0)
+		return;
+
+	// Bisection of the visibility boundaries between samples
+	auto refine = [&](double invisibleJD, double visibleJD) {
+		while (std::fabs(visibleJD - invisibleJD) > TIME_PRECISION)
+		{
+			const double middle = 0.5*(invisibleJD + visibleJD);
+			if (sample(satrec, middle).visible)
+				visibleJD = middle;
+			else
+				invisibleJD = middle;
+		}
+		return visibleJD;
+	};
+	pass.visibleStart = first == 0 ? pass.aos : refine(pass.aos + (first - 1)*step, pass.aos + first*step);
+	pass.visibleStop = last == count ? pass.los : refine(pass.aos + (last + 1)*step, pass.aos + last*step);
+}
+
+SatellitePassList SatellitePassPredictor::predictTarget(const Target& target, double startJD, double stopJD) const
+{
+	SatellitePassList passes;
+	Reach reach;
+	if (!getReach(target.satrec, reach))
+		return passes;
+
+	// sgp4() keeps state for deep-space satellites, work on a copy
+	elsetrec satrec = target.satrec;
+	SatellitePass pass;
+	pass.id = target.id;
+	pass.name = target.name;
+
+	auto finishPass = [&](const Sample& los, const Sample& best) {
+		pass.los = los.jd;
+		pass.losAzimuth = los.azimuth;
+		// the culmination is within one step of the highest sample
+		const Sample tca = refineMaximum(satrec, qMax(pass.aos, best.jd - target.stepDays), qMin(pass.los, best.jd + target.stepDays));
+		const Sample& top = tca.altitude > best.altitude ? tca : best;
+		pass.tca = top.jd;
+		pass.tcaAzimuth = top.azimuth;
+		pass.maxAltitude = top.altitude;
+		refineVisibility(satrec, pass);
+		passes.append(pass);
+	};
+
+	Sample previous = sample(satrec, startJD);
+	Sample beforePrevious = previous;
+	Sample best = previous;
+	bool up = previous.altitude >= minAltitude;
+	if (up)
+	{
+		pass.aos = startJD;
+		pass.aosAzimuth = previous.azimuth;
+	}
+
+	for (double jd = startJD; jd < stopJD;)
+	{
+		double step = target.stepDays;
+		if (!up)
+		{
+			// The satellite cannot be up before it gets within the footprint
+			step = qMax(step, SKIP_SAFETY*(previous.centralAngle - reach.footprint)/reach.maxRate);
+		}
+		jd = qMin(jd + step, stopJD);
+		const Sample current = sample(satrec, jd);
+		if (!up && current.altitude >= minAltitude)
+		{
+			const Sample aos = refineCrossing(satrec, previous, current);
+			pass.aos = aos.jd;
+			pass.aosAzimuth = aos.azimuth;
+			best = current;
+			up = true;
+		}
+		else if (up && current.altitude < minAltitude)
+		{
+			finishPass(refineCrossing(satrec, previous, current), best);
+			up = false;
+		}
+		else if (up)
+		{
+			if (current.altitude > best.altitude)
+				best = current;
+		}
+		else if (previous.altitude > beforePrevious.altitude && previous.altitude >= current.altitude
+			 && previous.altitude > minAltitude - GRAZING_MARGIN)
+		{
+			// Local maximum below the horizon: look for a pass shorter than the step
+			const Sample top = refineMaximum(satrec, beforePrevious.jd, current.jd);
+			if (top.altitude >= minAltitude)
+			{
+				const Sample aos = refineCrossing(satrec, beforePrevious, top);
+				pass.aos = aos.jd;
+				pass.aosAzimuth = aos.azimuth;
+				finishPass(refineCrossing(satrec, top, current), top);
+			}
+		}
+		beforePrevious = previous;
+		previous = current;
+	}
+
+	if (up)
+		finishPass(previous, best);
+
+	return passes;
+}
+
+SatellitePassList SatellitePassPredictor::predict(double startJD, double stopJD, bool parallel) const
+{
+	SatellitePassList passes;
+	if (stopJD <= startJD)
+		return passes;
+
+	QVector<SatellitePassList> results(targets.size());
+	QVector<int> indices(targets.size());
+	for (int i = 0; i < indices.size(); ++i)
+		indices[i] = i;
+
+	SatellitePassList* const lists = results.data();
+	auto predictOne = [this, lists, startJD, stopJD](const int& i) {
+		lists[i] = predictTarget(targets.at(i), startJD, stopJD);
+	};
+	if (parallel)
+		QtConcurrent::blockingMap(indices, predictOne);
+	else
+		std::for_each(indices.begin(), indices.end(), predictOne);
+
+	for (const auto& list : results)
+		passes.append(list);
+	std::stable_sort(passes.begin(), passes.end(), [](const SatellitePass& a, const SatellitePass& b) {
+		return a.aos < b.aos;
+	});
+	return passes;
+}
@@ -0,0 +1,160 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef SATELLITEPASSPREDICTOR_HPP
+#define SATELLITEPASSPREDICTOR_HPP
+
+#include <QList>
+#include <QString>
+#include <QVector>
+
+#include "VecMath.hpp"
+#include "gsatellite/sgp4unit.h"
+
+//! A pass of a satellite over the observer horizon.
+//! @ingroup satellites
+struct SatellitePass
+{
+	SatellitePass()
+		: aos(0.), tca(0.), los(0.)
+		, aosAzimuth(0.), tcaAzimuth(0.), losAzimuth(0.)
+		, maxAltitude(0.)
+		, visibleStart(0.), visibleStop(0.)
+	{
+	}
+
+	QString id;		//!< catalog number of the satellite
+	QString name;		//!< name of the satellite
+	double aos;		//!< acquisition of signal (JD, UTC)
+	double tca;		//!< time of closest approach, i.e. maximum altitude (JD, UTC)
+	double los;		//!< loss of signal (JD, UTC)
+	double aosAzimuth;	//!< azimuth at AOS, degrees from north over east
+	double tcaAzimuth;	//!< azimuth at TCA, degrees from north over east
+	double losAzimuth;	//!< azimuth at LOS, degrees from north over east
+	double maxAltitude;	//!< altitude at TCA (degrees)
+	double visibleStart;	//!< start of the part of the pass where the satellite is sunlit and the sky dark (JD, UTC)
+	double visibleStop;	//!< end of that part, equal to visibleStart when the pass cannot be seen
+
+	//! @return true when the satellite can be seen during a part of the pass.
+	bool isVisible() const { return visibleStop > visibleStart; }
+};
+
+//! @ingroup satellites
+typedef QList<SatellitePass> SatellitePassList;
+
+//! @class SatellitePassPredictor
+//! Finds the passes of a set of satellites over an observer location.
+//! Each satellite is sampled with a step derived from its orbital period, horizon
+//! crossings are refined by bisection and the culmination by a golden section search.
+//! Local maxima just below the horizon are refined too, so grazing passes shorter than
+//! a step are not missed. Satellites whose ground track can never bring them above the
+//! horizon of the observer (e.g. low inclination orbits seen from high latitudes) are
+//! culled before sampling, and while a satellite is far from the region of the sky where
+//! it would be up, sampling jumps over the time it needs at least to get there.
+//! The predictor only works on its own copies of the SGP4 elements, so satellites are
+//! processed in parallel by the global thread pool.
+//! @ingroup satellites
+class SatellitePassPredictor
+{
+public:
+	SatellitePassPredictor();
+
+	//! Set the observer location.
+	//! @param latitude geodetic latitude in degrees
+	//! @param longitude longitude in degrees
+	//! @param altitude altitude in meters
+	void setObserver(double latitude, double longitude, double altitude);
+	//! Set the altitude above which a satellite is considered up (degrees, default 0).
+	void setMinAltitude(double degrees) { minAltitude = degrees; }
+	double getMinAltitude() const { return minAltitude; }
+	//! Set the Sun altitude below which the sky is dark enough to see sunlit
+	//! satellites (degrees, default 0, as for gSatWrapper::VISIBLE).
+	void setSunAltitudeLimit(double degrees) { sunAltitudeLimit = degrees; }
+	double getSunAltitudeLimit() const { return sunAltitudeLimit; }
+
+	//! Remove all satellites.
+	void clear() { targets.clear(); }
+	//! Add a satellite with initialized SGP4 elements.
+	void addSatellite(const QString& id, const QString& name, const elsetrec& satrec);
+	//! @return the number of satellites.
+	int satelliteCount() const { return targets.size(); }
+	//! @return the number of satellites which can never rise over the horizon of the observer.
+	int culledCount() const;
+
+	//! Find all passes between @a startJD and @a stopJD (UTC).
+	//! Passes already in progress at @a startJD or still in progress at @a stopJD are
+	//! clipped to the range.
+	//! @param parallel when true, satellites are distributed over the global thread pool.
+	//! @return the passes sorted by AOS.
+	SatellitePassList predict(double startJD, double stopJD, bool parallel = true) const;
+
+	//! Low precision geocentric position of the Sun in the equatorial frame of date (km),
+	//! good to about 0.01 degree, which is enough for eclipse and twilight tests.
+	static Vec3d getSunECIPos(double jd);
+
+private:
+	struct Target
+	{
+		QString id;
+		QString name;
+		elsetrec satrec;
+		double stepDays;	//!< sampling step
+	};
+
+	//! Reach of a satellite over the Earth.
+	struct Reach
+	{
+		double footprint;	//!< largest Earth central angle between observer and satellite for which it is up (radians)
+		double maxRate;		//!< upper bound of the rate of that angle (radians per day)
+	};
+
+	//! Topocentric state of a satellite at a given time.
+	struct Sample
+	{
+		double jd;
+		double altitude;	//!< degrees
+		double azimuth;		//!< degrees from north over east
+		bool visible;		//!< sunlit satellite in a dark sky
+		double centralAngle;	//!< Earth central angle between observer and satellite (radians)
+	};
+
+	//! Compute the reach of a satellite.
+	//! @return false when the satellite can never rise over the horizon of the observer.
+	bool getReach(const elsetrec& satrec, Reach& reach) const;
+	Sample sample(elsetrec& satrec, double jd) const;
+	//! @return the altitude of the Sun in degrees, for the local sidereal time @a theta.
+	double getSunAltitude(double jd, double theta) const;
+	//! Bisection of the horizon crossing between @a below and @a above (either order in time).
+	Sample refineCrossing(elsetrec& satrec, Sample a, Sample b) const;
+	//! Golden section search of the maximum altitude in [a, b].
+	Sample refineMaximum(elsetrec& satrec, double a, double b) const;
+	//! Fill the visible part of @a pass.
+	void refineVisibility(elsetrec& satrec, SatellitePass& pass) const;
+	SatellitePassList predictTarget(const Target& target, double startJD, double stopJD) const;
+
+	double latitude;
+	double longitude;
+	double altitude;
+	double sinLatitude, cosLatitude;
+	double minAltitude;
+	double sunAltitudeLimit;
+	QVector<Target> targets;
+};
+
+#endif // SATELLITEPASSPREDICTOR_HPP
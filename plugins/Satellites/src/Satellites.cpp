@@ -1970,11 +1970,75 @@ void Satellites::update(double deltaTime)
 
 	hintFader.update(static_cast<int>(deltaTime*1000));
 
+	// Propagate all displayed satellites at once. The batch is only refilled
+	// when the set of satellites or their TLE changed.
+	QList<SatelliteP> active;
+	QVector<quint64> serials;
 	for (const auto& sat : satellites)
 	{
-		if (sat->initialized && sat->displayed)
-			sat->update(deltaTime);
+		if (sat->initialized && sat->displayed && sat->orbitValid && sat->pSatWrapper)
+		{
+			active.append(sat);
+			serials.append(sat->pSatWrapper->getSerial());
+		}
+	}
+	if (serials != batchSerials)
+	{
+		satelliteBatch.clear();
+		for (const auto& sat : active)
+			satelliteBatch.add(sat->pSatWrapper->getSatrec());
+		batchSerials = serials;
+	}
+
+	gSatBatch::Observer observer;
+	gSatWrapper::computeFrameObserver(core->getJD(), observer);
+	satelliteBatch.update(observer);
+	for (int i = 0; i < active.size(); ++i)
+		active.at(i)->update(satelliteBatch, i);
+}
+
+SatellitePassList Satellites::predictPasses(double startJD, double stopJD, double minAltitude, const QStringList& ids) const
+{
+	const StelLocation& loc = StelApp::getInstance().getCore()->getCurrentLocation();
+	SatellitePassPredictor predictor;
+	predictor.setObserver(loc.latitude, loc.longitude, loc.altitude);
+	predictor.setMinAltitude(minAltitude);
+	for (const auto& sat : satellites)
+	{
+		if (sat->initialized && sat->orbitValid && sat->pSatWrapper && (ids.isEmpty() || ids.contains(sat->getCatalogNumberString())))
+			predictor.addSatellite(sat->getCatalogNumberString(), sat->getNameI18n(), sat->pSatWrapper->getSatrec());
 	}
+	return predictor.predict(startJD, stopJD);
+}
+
+QVariantList Satellites::getPassPredictions(double startJD, double days, double minAltitude, const QStringList& ids, bool visibleOnly) const
+{
+	QVariantList result;
+	const SatellitePassList passes = predictPasses(startJD, startJD + days, minAltitude, ids);
+	for (const auto& pass : passes)
+	{
+		if (visibleOnly && !pass.isVisible())
+			continue;
+
+		QVariantMap map;
+		map.insert("id", pass.id);
+		map.insert("name", pass.name);
+		map.insert("aos", pass.aos);
+		map.insert("tca", pass.tca);
+		map.insert("los", pass.los);
+		map.insert("aosAzimuth", pass.aosAzimuth);
+		map.insert("tcaAzimuth", pass.tcaAzimuth);
+		map.insert("losAzimuth", pass.losAzimuth);
+		map.insert("maxAltitude", pass.maxAltitude);
+		map.insert("visible", pass.isVisible());
+		if (pass.isVisible())
+		{
+			map.insert("visibleStart", pass.visibleStart);
+			map.insert("visibleStop", pass.visibleStop);
+		}
+		result.append(map);
+	}
+	return result;
 }
 
 void Satellites::draw(StelCore* core)
@@ -22,6 +22,7 @@
 
 #include "StelObjectModule.hpp"
 #include "Satellite.hpp"
+#include "SatellitePassPredictor.hpp"
 #include "StelFader.hpp"
 #include "StelGui.hpp"
 #include "StelDialog.hpp"
@@ -31,6 +32,7 @@
 #include <QFile>
 #include <QDir>
 #include <QUrl>
+#include <QVector>
 #include <QVariantMap>
 
 class StelButton;
@@ -360,6 +362,14 @@ public:
 	//! @note We are having permissions for use this file from Mike McCants.	
 	void loadExtraData();
 	
+	//! Find the passes of the catalog satellites over the current location.
+	//! @param startJD start of the search (JD, UTC)
+	//! @param stopJD end of the search (JD, UTC)
+	//! @param minAltitude altitude above which a satellite is up (degrees)
+	//! @param ids catalog numbers of the satellites, or an empty list for the whole catalog
+	//! @return the passes sorted by AOS
+	SatellitePassList predictPasses(double startJD, double stopJD, double minAltitude = 0., const QStringList& ids = QStringList()) const;
+
 #if(SATELLITES_PLUGIN_IRIDIUM == 1)
 	//! Get depth of prediction for Iridium flares
 	int getIridiumFlaresPredictionDepth(void) const { return iridiumFlaresPredictionDepth; }
@@ -512,6 +522,17 @@ public slots:
 	//! Save the current satellite catalog to disk.
 	void saveCatalog(QString path=QString());
 
+	//! Find the passes of the catalog satellites over the current location, see predictPasses().
+	//! @param startJD start of the search (JD, UTC)
+	//! @param days length of the search
+	//! @param minAltitude altitude above which a satellite is up (degrees)
+	//! @param ids catalog numbers of the satellites, or an empty list for the whole catalog
+	//! @param visibleOnly only return the passes where the satellite can be seen
+	//! @return a list of maps with the keys "id", "name", "aos", "tca", "los" (JD, UTC), "aosAzimuth",
+	//! "tcaAzimuth", "losAzimuth", "maxAltitude" (degrees), "visible", and for visible passes
+	//! "visibleStart" and "visibleStop" (JD, UTC)
+	QVariantList getPassPredictions(double startJD, double days = 1., double minAltitude = 0., const QStringList& ids = QStringList(), bool visibleOnly = false) const;
+
 #if(SATELLITES_PLUGIN_IRIDIUM == 1)
 	//! Set depth of prediction for Iridium flares
 	//! @param depth in days
@@ -592,6 +613,12 @@ private:
 	QList<SatelliteP> satellites;
 	SatellitesListModel* satelliteListModel;
 
+	//! Elements of the satellites propagated together by update().
+	gSatBatch satelliteBatch;
+	//! Serials of the gSatWrapper objects used to fill satelliteBatch,
+	//! to detect changes of the displayed satellites or of their TLE.
+	QVector<quint64> batchSerials;
+
 	QHash<int, double> qsMagList, rcsList;
 	
 	//! Union of the groups used by all loaded satellites - see @ref groups.
@@ -0,0 +1,419 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "gSatBatch.hpp"
+#include "gSatWrapper.hpp"
+
+#include "gsatellite/mathUtils.hpp"
+#include "gsatellite/stdsat.h"
+#include "gsatellite/gTime.hpp"
+
+#include <QPair>
+#include <QVector>
+#include <QtConcurrent>
+
+#include <cmath>
+
+gSatBatch::gSatBatch()
+{
+	// Same constants as gSatTEME
+	getgravconst(wgs72, tumin, mu, radiusearthkm, xke, j2, j3, j4, j3oj2);
+	vkmpersec = radiusearthkm * xke/60.0;
+}
+
+void gSatBatch::clear()
+{
+	methods.clear();
+	deepSpaceIndex.clear();
+	isimp.clear();
+	for (auto* column : { &jdsatepoch, &mo, &mdot, &argpo, &argpdot, &nodeo, &nodedot, &nodecf,
+			      &cc1, &cc4, &cc5, &bstar, &t2cof, &t3cof, &t4cof, &t5cof,
+			      &omgcof, &xmcof, &eta, &delmo, &d2, &d3, &d4, &sinmao,
+			      &no, &ecco, &inclo, &aycof, &xlcof, &con41, &x1mth2, &x7thm1,
+			      &rx, &ry, &rz, &vx, &vy, &vz, &latitude, &longitude, &altitude,
+			      &topoS, &topoE, &topoZ, &slantRange, &slantRangeRate, &phaseAngle })
+		column->clear();
+	deepSpace.clear();
+	errors.clear();
+	visibility.clear();
+}
+
+int gSatBatch::add(const elsetrec& satrec)
+{
+	const int index = size();
+	methods.push_back(satrec.method);
+	if (satrec.method == 'd')
+	{
+		deepSpaceIndex.push_back(static_cast<int>(deepSpace.size()));
+		deepSpace.push_back(satrec);
+	}
+	else
+		deepSpaceIndex.push_back(-1);
+
+	isimp.push_back(satrec.isimp);
+	jdsatepoch.push_back(satrec.jdsatepoch);
+	mo.push_back(satrec.mo);
+	mdot.push_back(satrec.mdot);
+	argpo.push_back(satrec.argpo);
+	argpdot.push_back(satrec.argpdot);
+	nodeo.push_back(satrec.nodeo);
+	nodedot.push_back(satrec.nodedot);
+	nodecf.push_back(satrec.nodecf);
+	cc1.push_back(satrec.cc1);
+	cc4.push_back(satrec.cc4);
+	cc5.push_back(satrec.cc5);
+	bstar.push_back(satrec.bstar);
+	t2cof.push_back(satrec.t2cof);
+	t3cof.push_back(satrec.t3cof);
+	t4cof.push_back(satrec.t4cof);
+	t5cof.push_back(satrec.t5cof);
+	omgcof.push_back(satrec.omgcof);
+	xmcof.push_back(satrec.xmcof);
+	eta.push_back(satrec.eta);
+	delmo.push_back(satrec.delmo);
+	d2.push_back(satrec.d2);
+	d3.push_back(satrec.d3);
+	d4.push_back(satrec.d4);
+	sinmao.push_back(satrec.sinmao);
+	no.push_back(satrec.no);
+	ecco.push_back(satrec.ecco);
+	inclo.push_back(satrec.inclo);
+	aycof.push_back(satrec.aycof);
+	xlcof.push_back(satrec.xlcof);
+	con41.push_back(satrec.con41);
+	x1mth2.push_back(satrec.x1mth2);
+	x7thm1.push_back(satrec.x7thm1);
+
+	for (auto* column : { &rx, &ry, &rz, &vx, &vy, &vz, &latitude, &longitude, &altitude,
+			      &topoS, &topoE, &topoZ, &slantRange, &slantRangeRate, &phaseAngle })
+		column->push_back(0.);
+	errors.push_back(0);
+	visibility.push_back(gSatWrapper::UNKNOWN);
+
+	return index;
+}
+
+void gSatBatch::update(const Observer& observer, bool parallel)
+{
+	const int count = size();
+	if (!parallel || count <= BLOCK_SIZE)
+	{
+		for (int begin = 0; begin < count; begin += BLOCK_SIZE)
+			processBlock(begin, qMin(begin + BLOCK_SIZE, count), observer);
+		return;
+	}
+
+	QVector<QPair<int, int> > blocks;
+	for (int begin = 0; begin < count; begin += BLOCK_SIZE)
+		blocks.push_back(qMakePair(begin, qMin(begin + BLOCK_SIZE, count)));
+	QtConcurrent::blockingMap(blocks, [this, &observer](const QPair<int, int>& block) {
+		processBlock(block.first, block.second, observer);
+	});
+}
+
+void gSatBatch::processBlock(int begin, int end, const Observer& observer)
+{
+	propagateBlock(begin, end, observer.julianDay);
+	transformBlock(begin, end, observer);
+}
+
+// This is sgp4() from sgp4unit.cpp for the near-earth case, split in stages which each
+// loop over the lanes of a block. Lanes which left the computation (deep-space satellites
+// or propagation errors) are masked with the active flags. Failed lanes report the origin,
+// as gSatTEME does.
+void gSatBatch::propagateBlock(int begin, int end, double julianDay)
+{
+	const int n = end - begin;
+	const double twopi = 2.0 * M_PI;
+	const double x2o3  = 2.0 / 3.0;
+
+	bool active[BLOCK_SIZE];
+	double am[BLOCK_SIZE], nm[BLOCK_SIZE], axnl[BLOCK_SIZE], aynl[BLOCK_SIZE];
+	double nodep[BLOCK_SIZE], u[BLOCK_SIZE];
+	double eo1[BLOCK_SIZE], sineo1[BLOCK_SIZE], coseo1[BLOCK_SIZE];
+
+	int* const error = errors.data() + begin;
+	double* const px = rx.data() + begin;
+	double* const py = ry.data() + begin;
+	double* const pz = rz.data() + begin;
+	double* const qx = vx.data() + begin;
+	double* const qy = vy.data() + begin;
+	double* const qz = vz.data() + begin;
+
+	// Deep-space satellites use the scalar propagator
+	for (int l = 0; l < n; ++l)
+	{
+		const int i = begin + l;
+		active[l] = methods[i] != 'd';
+		if (active[l])
+			continue;
+
+		double ro[3] = {};
+		double vo[3] = {};
+		const double tsince = ((julianDay - jdsatepoch[i]) * KSEC_PER_DAY) / KSEC_PER_MIN;
+		elsetrec& satrec = deepSpace[deepSpaceIndex[i]];
+		sgp4(wgs72, satrec, tsince, ro, vo);
+		error[l] = satrec.error;
+		px[l] = ro[0]; py[l] = ro[1]; pz[l] = ro[2];
+		qx[l] = vo[0]; qy[l] = vo[1]; qz[l] = vo[2];
+	}
+
+	// Secular gravity, atmospheric drag and long period periodics
+	for (int l = 0; l < n; ++l)
+	{
+		if (!active[l])
+			continue;
+		const int i = begin + l;
+		const double t = ((julianDay - jdsatepoch[i]) * KSEC_PER_DAY) / KSEC_PER_MIN;
+
+		const double xmdf   = mo[i] + mdot[i] * t;
+		const double argpdf = argpo[i] + argpdot[i] * t;
+		const double nodedf = nodeo[i] + nodedot[i] * t;
+		const double t2     = t * t;
+		double argpm = argpdf;
+		double mm    = xmdf;
+		double nodem = nodedf + nodecf[i] * t2;
+		double tempa = 1.0 - cc1[i] * t;
+		double tempe = bstar[i] * cc4[i] * t;
+		double templ = t2cof[i] * t2;
+
+		if (isimp[i] != 1)
+		{
+			const double delomg = omgcof[i] * t;
+			const double delm   = xmcof[i] * (std::pow((1.0 + eta[i] * std::cos(xmdf)), 3) - delmo[i]);
+			const double temp   = delomg + delm;
+			mm    = xmdf + temp;
+			argpm = argpdf - temp;
+			const double t3 = t2 * t;
+			const double t4 = t3 * t;
+			tempa = tempa - d2[i] * t2 - d3[i] * t3 - d4[i] * t4;
+			tempe = tempe + bstar[i] * cc5[i] * (std::sin(mm) - sinmao[i]);
+			templ = templ + t3cof[i] * t3 + t4 * (t4cof[i] + t * t5cof[i]);
+		}
+
+		double n0 = no[i];
+		double em = ecco[i];
+		if (n0 <= 0.0)
+		{
+			error[l] = 2;
+			active[l] = false;
+			px[l] = py[l] = pz[l] = 0.0;
+			qx[l] = qy[l] = qz[l] = 0.0;
+			continue;
+		}
+		am[l] = std::pow((xke / n0), x2o3) * tempa * tempa;
+		nm[l] = xke / std::pow(am[l], 1.5);
+		em = em - tempe;
+		if ((em >= 1.0) || (em < -0.001))
+		{
+			error[l] = 1;
+			active[l] = false;
+			px[l] = py[l] = pz[l] = 0.0;
+			qx[l] = qy[l] = qz[l] = 0.0;
+			continue;
+		}
+		if (em < 1.0e-6)
+			em = 1.0e-6;
+		mm = mm + no[i] * templ;
+		double xlm = mm + argpm + nodem;
+
+		nodem = std::fmod(nodem, twopi);
+		argpm = std::fmod(argpm, twopi);
+		xlm   = std::fmod(xlm, twopi);
+		mm    = std::fmod(xlm - argpm - nodem, twopi);
+
+		axnl[l] = em * std::cos(argpm);
+		const double temp = 1.0 / (am[l] * (1.0 - em * em));
+		aynl[l] = em * std::sin(argpm) + temp * aycof[i];
+		const double xl = mm + argpm + nodem + temp * xlcof[i] * axnl[l];
+
+		nodep[l] = nodem;
+		u[l]     = std::fmod(xl - nodem, twopi);
+		eo1[l]   = u[l];
+		error[l] = 0;
+	}
+
+	// Kepler's equation: iterate all lanes together until each one converged
+	bool solving[BLOCK_SIZE];
+	for (int l = 0; l < n; ++l)
+	{
+		solving[l] = active[l];
+		sineo1[l] = 0.0;
+		coseo1[l] = 0.0;
+	}
+	for (int ktr = 1; ktr <= 10; ++ktr)
+	{
+		bool any = false;
+		for (int l = 0; l < n; ++l)
+		{
+			if (!solving[l])
+				continue;
+			sineo1[l] = std::sin(eo1[l]);
+			coseo1[l] = std::cos(eo1[l]);
+			double tem5 = 1.0 - coseo1[l] * axnl[l] - sineo1[l] * aynl[l];
+			tem5 = (u[l] - aynl[l] * coseo1[l] + axnl[l] * sineo1[l] - eo1[l]) / tem5;
+			if (std::fabs(tem5) >= 0.95)
+				tem5 = tem5 > 0.0 ? 0.95 : -0.95;
+			eo1[l] = eo1[l] + tem5;
+			solving[l] = std::fabs(tem5) >= 1.0e-12;
+			any |= solving[l];
+		}
+		if (!any)
+			break;
+	}
+
+	// Short period periodics, orientation vectors, position and velocity
+	for (int l = 0; l < n; ++l)
+	{
+		if (!active[l])
+			continue;
+		const int i = begin + l;
+
+		const double ecose = axnl[l]*coseo1[l] + aynl[l]*sineo1[l];
+		const double esine = axnl[l]*sineo1[l] - aynl[l]*coseo1[l];
+		const double el2   = axnl[l]*axnl[l] + aynl[l]*aynl[l];
+		const double pl    = am[l]*(1.0-el2);
+		if (pl < 0.0)
+		{
+			error[l] = 4;
+			px[l] = py[l] = pz[l] = 0.0;
+			qx[l] = qy[l] = qz[l] = 0.0;
+			continue;
+		}
+
+		const double rl     = am[l] * (1.0 - ecose);
+		const double rdotl  = std::sqrt(am[l]) * esine/rl;
+		const double rvdotl = std::sqrt(pl) / rl;
+		const double betal  = std::sqrt(1.0 - el2);
+		double temp         = esine / (1.0 + betal);
+		const double sinu   = am[l] / rl * (sineo1[l] - aynl[l] - axnl[l] * temp);
+		const double cosu   = am[l] / rl * (coseo1[l] - axnl[l] + aynl[l] * temp);
+		double su           = std::atan2(sinu, cosu);
+		const double sin2u  = (cosu + cosu) * sinu;
+		const double cos2u  = 1.0 - 2.0 * sinu * sinu;
+		temp                = 1.0 / pl;
+		const double temp1  = 0.5 * j2 * temp;
+		const double temp2  = temp1 * temp;
+
+		// inclination is constant in the near-earth case
+		const double sinip = std::sin(inclo[i]);
+		const double cosip = std::cos(inclo[i]);
+
+		const double mrt   = rl * (1.0 - 1.5 * temp2 * betal * con41[i]) +
+				     0.5 * temp1 * x1mth2[i] * cos2u;
+		su                 = su - 0.25 * temp2 * x7thm1[i] * sin2u;
+		const double xnode = nodep[l] + 1.5 * temp2 * cosip * sin2u;
+		const double xinc  = inclo[i] + 1.5 * temp2 * cosip * sinip * cos2u;
+		const double mvt   = rdotl - nm[l] * temp1 * x1mth2[i] * sin2u / xke;
+		const double rvdot = rvdotl + nm[l] * temp1 * (x1mth2[i] * cos2u + 1.5 * con41[i]) / xke;
+
+		const double sinsu = std::sin(su);
+		const double cossu = std::cos(su);
+		const double snod  = std::sin(xnode);
+		const double cnod  = std::cos(xnode);
+		const double sini  = std::sin(xinc);
+		const double cosi  = std::cos(xinc);
+		const double xmx   = -snod * cosi;
+		const double xmy   =  cnod * cosi;
+		const double ux    =  xmx * sinsu + cnod * cossu;
+		const double uy    =  xmy * sinsu + snod * cossu;
+		const double uz    =  sini * sinsu;
+		const double wx    =  xmx * cossu - cnod * sinsu;
+		const double wy    =  xmy * cossu - snod * sinsu;
+		const double wz    =  sini * cossu;
+
+		px[l] = (mrt * ux)* radiusearthkm;
+		py[l] = (mrt * uy)* radiusearthkm;
+		pz[l] = (mrt * uz)* radiusearthkm;
+		qx[l] = (mvt * ux + rvdot * wx) * vkmpersec;
+		qy[l] = (mvt * uy + rvdot * wy) * vkmpersec;
+		qz[l] = (mvt * uz + rvdot * wz) * vkmpersec;
+
+		// decaying satellite
+		if (mrt < 1.0)
+			error[l] = 6;
+	}
+
+}
+
+void gSatBatch::transformBlock(int begin, int end, const Observer& observer)
+{
+	const double e2 = __f*(2 - __f);
+	const Vec3d& observerPos = observer.position;
+	const Vec3d& observerVel = observer.velocity;
+	const Vec3d& sunPos = observer.sunPosition;
+
+	for (int i = begin; i < end; ++i)
+	{
+		const Vec3d satPos(rx[i], ry[i], rz[i]);
+		const Vec3d satVel(vx[i], vy[i], vz[i]);
+
+		// Subpoint, see gSatTEME::computeSubPoint()
+		const double theta = AcTan(satPos[1], satPos[0]);
+		double lon = std::fmod((theta - observer.thetaGMST), K2PI);
+		const double r = std::sqrt(Sqr(satPos[0]) + Sqr(satPos[1]));
+		double lat = AcTan(satPos[2], r);
+		double phi, c;
+		do
+		{
+			phi = lat;
+			c = 1/std::sqrt(1 - e2*Sqr(std::sin(phi)));
+			lat = AcTan(satPos[2] + KEARTHRADIUS*c*e2*std::sin(phi), r);
+		}
+		while (std::fabs(lat - phi) >= 1E-10);
+		altitude[i] = r/std::cos(lat) - KEARTHRADIUS*c;
+		if (lat > (KPI/2.0)) lat -= K2PI;
+		lat = lat/KDEG2RAD;
+		lon = lon/KDEG2RAD;
+		if (lon < -180.0) lon += 360;
+		else if (lon > 180.0) lon -= 360;
+		latitude[i] = lat;
+		longitude[i] = lon;
+
+		// Topocentric position, see gSatWrapper::getAltAz()
+		const Vec3d slant = satPos - observerPos;
+		topoS[i] = (observer.sinLatitude * observer.cosTheta*slant[0]
+			    + observer.sinLatitude* observer.sinTheta*slant[1]
+			    - observer.cosLatitude* slant[2]);
+		topoE[i] = ((-1.0)* observer.sinTheta*slant[0]
+			    + observer.cosTheta*slant[1]);
+		topoZ[i] = (observer.cosLatitude * observer.cosTheta*slant[0]
+			    + observer.cosLatitude * observer.sinTheta*slant[1]
+			    + observer.sinLatitude *slant[2]);
+
+		const Vec3d slantVelocity = satVel - observerVel;
+		slantRange[i] = slant.length();
+		slantRangeRate[i] = slant.dot(slantVelocity)/slantRange[i];
+
+		// Visibility, see gSatWrapper::getVisibilityPredict()
+		phaseAngle[i] = sunPos.angle(satPos);
+		if (topoZ[i] > 0)
+		{
+			if (observer.sunAboveHorizon)
+				visibility[i] = gSatWrapper::RADAR_SUN;
+			else
+			{
+				const double dist = satPos.length()*std::cos(phaseAngle[i] - (M_PI/2));
+				visibility[i] = dist > KEARTHRADIUS ? gSatWrapper::VISIBLE : gSatWrapper::RADAR_NIGHT;
+			}
+		}
+		else
+			visibility[i] = gSatWrapper::NOT_VISIBLE;
+	}
+}
@@ -0,0 +1,141 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef GSATBATCH_HPP
+#define GSATBATCH_HPP
+
+#include <vector>
+
+#include "VecMath.hpp"
+
+#include "gsatellite/sgp4unit.h"
+
+//! @class gSatBatch
+//! Propagates a whole satellite catalog at once.
+//! The near-earth SGP4 elements of all satellites are kept in structure-of-arrays
+//! form and processed in fixed size blocks: every stage of the propagator and of the
+//! TEME to topocentric transform runs as a plain loop over the lanes of a block, so
+//! the compiler can vectorize it, and the blocks are distributed over the global
+//! thread pool. Deep-space satellites (SDP4) keep their own elsetrec and use the
+//! scalar sgp4() inside the same blocks.
+//! The quantities which only depend on the epoch and the observer (sidereal time,
+//! observer and Sun ECI positions) are computed once per frame and passed in an
+//! Observer, see gSatWrapper::computeFrameObserver().
+//! The results are bit-identical to those of gSatWrapper for the same epoch.
+//! @ingroup satellites
+class gSatBatch
+{
+public:
+	//! Per-epoch quantities shared by all satellites of a frame.
+	struct Observer
+	{
+		Observer()
+			: julianDay(0.)
+			, thetaGMST(0.)
+			, sinLatitude(0.)
+			, cosLatitude(1.)
+			, sinTheta(0.)
+			, cosTheta(1.)
+			, sunAboveHorizon(false)
+		{
+		}
+
+		double julianDay;	//!< UTC epoch of the frame
+		double thetaGMST;	//!< Greenwich mean sidereal time (radians)
+		double sinLatitude;	//!< sine of the observer geodetic latitude
+		double cosLatitude;	//!< cosine of the observer geodetic latitude
+		double sinTheta;	//!< sine of the local mean sidereal time
+		double cosTheta;	//!< cosine of the local mean sidereal time
+		Vec3d position;		//!< observer ECI position (km)
+		Vec3d velocity;		//!< observer ECI velocity (km/s)
+		Vec3d sunPosition;	//!< Sun ECI position (km)
+		bool sunAboveHorizon;	//!< true when the Sun is above the geometric horizon
+	};
+
+	//! Number of satellites processed together by one task.
+	static const int BLOCK_SIZE = 256;
+
+	gSatBatch();
+
+	//! Remove all satellites.
+	void clear();
+	//! Add a satellite with initialized SGP4 elements.
+	//! @return the index of the satellite in the batch.
+	int add(const elsetrec& satrec);
+	//! @return the number of satellites in the batch.
+	int size() const { return static_cast<int>(methods.size()); }
+
+	//! Propagate all satellites to the observer epoch and compute their topocentric
+	//! data.
+	//! @param parallel when true, blocks are processed by the global thread pool.
+	void update(const Observer& observer, bool parallel = true);
+
+	//! @return the SGP4 error code of the last update (0 when the propagation succeeded).
+	int getErrorCode(int index) const { return errors[index]; }
+	//! @return the TEME position in km.
+	Vec3d getTEMEPos(int index) const { return Vec3d(rx[index], ry[index], rz[index]); }
+	//! @return the TEME velocity in km/s.
+	Vec3d getTEMEVel(int index) const { return Vec3d(vx[index], vy[index], vz[index]); }
+	//! @return latitude and longitude in degrees and altitude in km,
+	//! see gSatWrapper::getSubPoint().
+	Vec3d getSubPoint(int index) const { return Vec3d(latitude[index], longitude[index], altitude[index]); }
+	//! @return the topocentric (south, east, zenith) position in km,
+	//! see gSatWrapper::getAltAz().
+	Vec3d getAltAz(int index) const { return Vec3d(topoS[index], topoE[index], topoZ[index]); }
+	//! @return the slant range in km.
+	double getSlantRange(int index) const { return slantRange[index]; }
+	//! @return the slant range rate in km/s.
+	double getSlantRangeRate(int index) const { return slantRangeRate[index]; }
+	//! @return one of the gSatWrapper::Visibility values.
+	int getVisibility(int index) const { return visibility[index]; }
+	//! @return the Sun-satellite angle as seen from the Earth centre (radians).
+	double getPhaseAngle(int index) const { return phaseAngle[index]; }
+
+private:
+	//! Run both stages for the satellites [begin, end).
+	void processBlock(int begin, int end, const Observer& observer);
+	//! SGP4 for the near-earth satellites of [begin, end) and sgp4() for the deep-space ones.
+	void propagateBlock(int begin, int end, double julianDay);
+	//! Subpoint, topocentric position, slant range and visibility for [begin, end).
+	void transformBlock(int begin, int end, const Observer& observer);
+
+	// gravitational constants (wgs72, as used by gSatTEME)
+	double tumin, mu, radiusearthkm, xke, j2, j3, j4, j3oj2, vkmpersec;
+
+	// Near-earth elements, one entry per satellite
+	std::vector<char> methods;
+	std::vector<int> deepSpaceIndex;
+	std::vector<int> isimp;
+	std::vector<double> jdsatepoch, mo, mdot, argpo, argpdot, nodeo, nodedot, nodecf;
+	std::vector<double> cc1, cc4, cc5, bstar, t2cof, t3cof, t4cof, t5cof;
+	std::vector<double> omgcof, xmcof, eta, delmo, d2, d3, d4, sinmao;
+	std::vector<double> no, ecco, inclo, aycof, xlcof, con41, x1mth2, x7thm1;
+	//! Full elements of the deep-space satellites, propagated by sgp4().
+	std::vector<elsetrec> deepSpace;
+
+	// Results of the last update
+	std::vector<int> errors;
+	std::vector<double> rx, ry, rz, vx, vy, vz;
+	std::vector<double> latitude, longitude, altitude;
+	std::vector<double> topoS, topoE, topoZ;
+	std::vector<double> slantRange, slantRangeRate, phaseAngle;
+	std::vector<int> visibility;
+};
+
+#endif // GSATBATCH_HPP
@@ -41,6 +41,7 @@
 #include <QByteArray>
 
 gSatWrapper::gSatWrapper(QString designation, QString tle1,QString tle2)
+	: serial(++lastSerial)
 {
 	// The TLE library actually modifies the TLE strings, which is annoying (because
 	// when we get updates, we want to check if there has been a change by using ==
@@ -108,30 +109,34 @@ void gSatWrapper::calcObserverECIPosition(Vec3d& ao_position, Vec3d& ao_velocity
 	if (epoch != lastCalcObserverECIPosition)
 	{
 		StelLocation loc   = StelApp::getInstance().getCore()->getCurrentLocation();
-
-		double radLatitude	= loc.latitude * KDEG2RAD;
-		double theta		= epoch.toThetaLMST(loc.longitude * KDEG2RAD);
-		double r;
-		double c,sq;
-
-		/* Reference:  Explanatory supplement to the Astronomical Almanac 1992, page 209-210. */
-		/* Elipsoid earth model*/
-		/* c = Nlat/a */
-		c = 1/std::sqrt(1 + __f*(__f - 2)*Sqr(sin(radLatitude)));
-		sq = Sqr(1 - __f)*c;
-
-		r = (KEARTHRADIUS*c + (loc.altitude/1000))*cos(radLatitude);
-		ao_position[0] = r * cos(theta);/*kilometers*/
-		ao_position[1] = r * sin(theta);
-		ao_position[2] = (KEARTHRADIUS*sq + (loc.altitude/1000))*sin(radLatitude);
-		ao_velocity[0] = -KMFACTOR*ao_position[1];/*kilometers/second*/
-		ao_velocity[1] =  KMFACTOR*ao_position[0];
-		ao_velocity[2] =  0;
-
+		computeObserverECIPosition(epoch, loc.latitude, loc.longitude, loc.altitude, ao_position, ao_velocity);
 		lastCalcObserverECIPosition=epoch;
 	}
 }
 
+void gSatWrapper::computeObserverECIPosition(gTime ai_epoch, double ai_latitude, double ai_longitude, double ai_altitude,
+					     Vec3d& ao_position, Vec3d& ao_velocity)
+{
+	double radLatitude	= ai_latitude * KDEG2RAD;
+	double theta		= ai_epoch.toThetaLMST(ai_longitude * KDEG2RAD);
+	double r;
+	double c,sq;
+
+	/* Reference:  Explanatory supplement to the Astronomical Almanac 1992, page 209-210. */
+	/* Elipsoid earth model*/
+	/* c = Nlat/a */
+	c = 1/std::sqrt(1 + __f*(__f - 2)*Sqr(sin(radLatitude)));
+	sq = Sqr(1 - __f)*c;
+
+	r = (KEARTHRADIUS*c + (ai_altitude/1000))*cos(radLatitude);
+	ao_position[0] = r * cos(theta);/*kilometers*/
+	ao_position[1] = r * sin(theta);
+	ao_position[2] = (KEARTHRADIUS*sq + (ai_altitude/1000))*sin(radLatitude);
+	ao_velocity[0] = -KMFACTOR*ao_position[1];/*kilometers/second*/
+	ao_velocity[1] =  KMFACTOR*ao_position[0];
+	ao_velocity[2] =  0;
+}
+
 Vec3d gSatWrapper::getAltAz() const
 {
 	StelLocation loc   = StelApp::getInstance().getCore()->getCurrentLocation();
@@ -203,6 +208,36 @@ Vec3d gSatWrapper::getSunECIPos()
 	return sunECIPos;
 }
 
+const elsetrec& gSatWrapper::getSatrec() const
+{
+	return pSatellite->getSatrec();
+}
+
+void gSatWrapper::computeFrameObserver(double ai_julianDaysEpoch, gSatBatch::Observer& ao_observer)
+{
+	epoch = ai_julianDaysEpoch;
+
+	StelCore* core = StelApp::getInstance().getCore();
+	StelLocation loc = core->getCurrentLocation();
+	const double radLatitude = loc.latitude * KDEG2RAD;
+	const double theta       = epoch.toThetaLMST(loc.longitude * KDEG2RAD);
+
+	ao_observer.julianDay   = ai_julianDaysEpoch;
+	ao_observer.thetaGMST   = epoch.toThetaGMST();
+	ao_observer.sinLatitude = sin(radLatitude);
+	ao_observer.cosLatitude = cos(radLatitude);
+	ao_observer.sinTheta    = sin(theta);
+	ao_observer.cosTheta    = cos(theta);
+
+	calcObserverECIPosition(observerECIPos, observerECIVel);
+	ao_observer.position    = observerECIPos;
+	ao_observer.velocity    = observerECIVel;
+	ao_observer.sunPosition = getSunECIPos();
+
+	static const SolarSystem *solsystem = (SolarSystem*)StelApp::getInstance().getModuleMgr().getModule("SolarSystem");
+	ao_observer.sunAboveHorizon = solsystem->getSun()->getAltAzPosGeometric(core)[2] > 0.0;
+}
+
 // Operation getVisibilityPredict
 // @brief This operation predicts the satellite visibility conditions.
 gSatWrapper::Visibility gSatWrapper::getVisibilityPredict() const
@@ -260,6 +295,7 @@ Vec2d gSatWrapper::getPerigeeApogeeAltitudes() const
 	return pSatellite->getPerigeeApogee();
 }
 
+quint64 gSatWrapper::lastSerial = 0;
 gTime gSatWrapper::epoch;
 gTime gSatWrapper::lastSunECIepoch=0.0; // store last time of computation to avoid all-1 computations.
 gTime gSatWrapper::lastCalcObserverECIPosition;
@@ -33,6 +33,7 @@
 
 #include "VecMath.hpp"
 
+#include "gSatBatch.hpp"
 #include "gsatellite/gSatTEME.hpp"
 #include "gsatellite/gTime.hpp"
 
@@ -124,6 +125,18 @@ public:
 	Vec2d getPerigeeApogeeAltitudes() const;
 	static gTime getEpoch() { return epoch; }
 
+	//! @return the SGP4 elements of the satellite, used to fill a gSatBatch.
+	const elsetrec& getSatrec() const;
+	//! @return a number identifying this wrapper (and thus its TLE set) during the session.
+	quint64 getSerial() const { return serial; }
+
+	// Operation computeFrameObserver
+	//! @brief Set the epoch shared by all satellites and compute the quantities
+	//! which only depend on it and on the observer.
+	//! They are computed once per frame and used by gSatBatch for every satellite.
+	//! @param[out] ao_observer sidereal time, observer and Sun ECI positions at the epoch
+	static void computeFrameObserver(double ai_julianDaysEpoch, gSatBatch::Observer& ao_observer);
+
 	// Operation calcObserverECIPosition
 	//! @brief This operation computes the observer ECI coordinates in Geocentric
 	//! Equatorial Coordinate System (IJK) for the ai_epoch time.
@@ -138,11 +151,22 @@ public:
         //! @param[out] ao_vel Observer ECI velocity vector measured in Km/s
 	static void calcObserverECIPosition(Vec3d& ao_position, Vec3d& ao_vel) ;
 
+	// Operation computeObserverECIPosition
+	//! @brief Same as calcObserverECIPosition() for a given epoch and location,
+	//! without using the shared cache (this can be called from any thread).
+	//! @param ai_latitude geodetic latitude in degrees
+	//! @param ai_longitude longitude in degrees
+	//! @param ai_altitude altitude in meters
+	static void computeObserverECIPosition(gTime ai_epoch, double ai_latitude, double ai_longitude, double ai_altitude,
+					       Vec3d& ao_position, Vec3d& ao_vel);
+
 private:
 	//! do the actual work to compute a cached value.
 	static void updateSunECIPos();
 
 	gSatTEME *pSatellite;
+	quint64 serial;
+	static quint64 lastSerial;
 	static gTime	 epoch;
 
 	// GZ We can avoid many computations (solar and observer positions for every satellite) by computing them only once for all objects.
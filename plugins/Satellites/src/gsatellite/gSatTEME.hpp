@@ -125,6 +125,12 @@ public:
 		return satrec.error;
 	}
 
+	//! @return the SGP4 elements of the satellite.
+	const elsetrec& getSatrec() const
+	{
+		return satrec;
+	}
+
 	double getPeriod() const
 	{
 		// Get orbital period from mean motion (rad/min)
@@ -18,6 +18,12 @@
 
 #include <QString>
 #include "testSatellites.hpp"
+#include "gSatBatch.hpp"
+#include "gSatWrapper.hpp"
+#include "SatellitePassPredictor.hpp"
+#include "gsatellite/gSatTEME.hpp"
+
+#include <random>
 
 QTEST_GUILESS_MAIN(TestSatellites)
 
@@ -46,4 +52,181 @@ void TestSatellites::testNoSatDuplication()
     QVERIFY(dutA == dutB);
 }
 
+void TestSatellites::testBatchPropagation_data()
+{
+    QTest::addColumn<bool>("parallel");
+    QTest::newRow("serial") << false;
+    QTest::newRow("parallel") << true;
+}
+
+void TestSatellites::testBatchPropagation()
+{
+    QFETCH(bool, parallel);
+
+    // Near-earth (ISS, NOAA 4) and deep-space (GPS, Molniya) elements
+    const char* tles[][3] = {
+        { "ISS", "1 25544U 98067A   20300.51782528  .00001264  00000-0  31004-4 0  9992",
+                 "2 25544  51.6441  93.0890 0001445  93.8620  33.3773 15.49331638252498" },
+        { "NOAA 4", "1 07530U 74089B   20300.80478596 -.00000049  00000-0 -21012-4 0  9993",
+                    "2 07530 101.7770 337.7317 0012122 318.4445 104.4962 12.53641440 65623" },
+        { "GPS", "1 24876U 97035A   20300.34512620  .00000023  00000-0  00000+0 0  9995",
+                 "2 24876  55.5296 146.3218 0043468  55.6829 304.7679  2.00564105169837" },
+        { "MOLNIYA", "1 21897U 92014A   20299.92766939  .00000116  00000-0  10212-2 0  9990",
+                     "2 21897  62.0964 205.6993 6818540 271.1785  16.7658  2.45098127211843" }
+    };
+
+    // Enough copies to fill several blocks
+    QList<QSharedPointer<gSatTEME> > satellites;
+    gSatBatch batch;
+    for (int i = 0; i < 3 * gSatBatch::BLOCK_SIZE; ++i)
+    {
+        const auto& tle = tles[i % 4];
+        QByteArray line1(tle[1]), line2(tle[2]);
+        satellites.append(QSharedPointer<gSatTEME>(new gSatTEME(tle[0], line1.data(), line2.data())));
+        QCOMPARE(batch.add(satellites.last()->getSatrec()), i);
+    }
+    QCOMPARE(batch.size(), satellites.size());
+
+    gSatBatch::Observer observer;
+    observer.sinLatitude = std::sin(0.9);
+    observer.cosLatitude = std::cos(0.9);
+    observer.position = Vec3d(3700., 1200., 5000.);
+    observer.sunPosition = Vec3d(1.2e8, -6.5e7, -2.8e7);
+    for (double jd = 2459150.; jd < 2459152.; jd += 0.37)
+    {
+        observer.julianDay = jd;
+        observer.thetaGMST = gTime(jd).toThetaGMST();
+        batch.update(observer, parallel);
+
+        for (int i = 0; i < satellites.size(); ++i)
+        {
+            gSatTEME* sat = satellites.at(i).data();
+            sat->setEpoch(gTime(jd));
+            QCOMPARE(batch.getErrorCode(i), sat->getErrorCode());
+            QVERIFY(batch.getTEMEPos(i) == sat->getPos());
+            QVERIFY(batch.getTEMEVel(i) == sat->getVel());
+            QVERIFY(batch.getSubPoint(i) == sat->getSubPoint());
+
+            const Vec3d slant = sat->getPos() - observer.position;
+            QCOMPARE(batch.getSlantRange(i), slant.length());
+            QCOMPARE(batch.getPhaseAngle(i), observer.sunPosition.angle(sat->getPos()));
+        }
+    }
+}
+
+void TestSatellites::testPassPrediction()
+{
+    QByteArray line1("1 25544U 98067A   20300.51782528  .00001264  00000-0  31004-4 0  9992");
+    QByteArray line2("2 25544  51.6441  93.0890 0001445  93.8620  33.3773 15.49331638252498");
+    gSatTEME iss("ISS", line1.data(), line2.data());
+
+    const double latitude = 48., longitude = 11., altitude = 500., minAltitude = 10.;
+    SatellitePassPredictor predictor;
+    predictor.setObserver(latitude, longitude, altitude);
+    predictor.setMinAltitude(minAltitude);
+    predictor.addSatellite("25544", "ISS", iss.getSatrec());
+    QCOMPARE(predictor.culledCount(), 0);
+
+    const double startJD = 2459154., stopJD = startJD + 3.;
+    const SatellitePassList passes = predictor.predict(startJD, stopJD, false);
+    QVERIFY(passes.size() > 10);
+    for (const auto& pass : passes)
+    {
+        QVERIFY(pass.aos < pass.tca && pass.tca < pass.los);
+        QVERIFY(pass.maxAltitude >= minAltitude);
+        if (pass.isVisible())
+            QVERIFY(pass.visibleStart >= pass.aos && pass.visibleStop <= pass.los);
+    }
+
+    // Every time the satellite is up must be in a pass, and every pass must contain such times
+    const double sinLat = std::sin(latitude*M_PI/180.), cosLat = std::cos(latitude*M_PI/180.);
+    QVector<int> hits(passes.size());
+    for (double jd = startJD; jd < stopJD; jd += 5./86400.)
+    {
+        const gTime epoch(jd);
+        iss.setEpoch(epoch);
+        Vec3d observerPos, observerVel;
+        gSatWrapper::computeObserverECIPosition(epoch, latitude, longitude, altitude, observerPos, observerVel);
+        const double theta = epoch.toThetaLMST(longitude*M_PI/180.);
+        const Vec3d slant = iss.getPos() - observerPos;
+        const double zenith = cosLat*std::cos(theta)*slant[0] + cosLat*std::sin(theta)*slant[1] + sinLat*slant[2];
+        if (std::asin(zenith/slant.length())*180./M_PI < minAltitude)
+            continue;
+
+        bool found = false;
+        for (int i = 0; i < passes.size(); ++i)
+        {
+            if (jd >= passes.at(i).aos - 1e-5 && jd <= passes.at(i).los + 1e-5)
+            {
+                found = true;
+                hits[i]++;
+            }
+        }
+        QVERIFY2(found, qPrintable(QString("satellite up outside of the predicted passes at JD %1").arg(jd, 0, 'f', 6)));
+    }
+    QVERIFY(!hits.contains(0));
+
+    // An equatorial orbit never rises over the poles
+    elsetrec equatorial = elsetrec();
+    sgp4init(wgs72, 'i', 1, startJD - 2433281.5, 1e-5, 0.001, 0., 0., 0., 15.*2.*M_PI/1440., 0., equatorial);
+    equatorial.jdsatepoch = startJD;
+    predictor.clear();
+    predictor.setObserver(85., 0., 0.);
+    predictor.addSatellite("1", "EQUATORIAL", equatorial);
+    QCOMPARE(predictor.culledCount(), 1);
+    QVERIFY(predictor.predict(startJD, stopJD).isEmpty());
+}
+
+void TestSatellites::benchmarkPassPrediction_data()
+{
+    QTest::addColumn<int>("satelliteCount");
+    QTest::addColumn<double>("days");
+    QTest::newRow("2000 satellites, 1 day") << 2000 << 1.;
+    QTest::newRow("20000 satellites, 7 days") << 20000 << 7.;
+}
+
+void TestSatellites::benchmarkPassPrediction()
+{
+    QFETCH(int, satelliteCount);
+    QFETCH(double, days);
+
+    const double startJD = 2459154.;
+    SatellitePassPredictor predictor;
+    predictor.setObserver(48., 11., 500.);
 
+    // Reproducible synthetic catalog with elements one day old:
+    // 80% low earth orbits, 10% medium and 10% geostationary orbits
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<double> uniform(0., 1.);
+    for (int i = 0; i < satelliteCount; ++i)
+    {
+        const double kind = uniform(generator);
+        double revolutionsPerDay, inclination;
+        if (kind < 0.8)
+        {
+            revolutionsPerDay = 14. + 2.*uniform(generator);
+            inclination = 100.*uniform(generator);
+        }
+        else if (kind < 0.9)
+        {
+            revolutionsPerDay = 2. + 0.01*uniform(generator);
+            inclination = 100.*uniform(generator);
+        }
+        else
+        {
+            revolutionsPerDay = 1.0027;
+            inclination = 5.*uniform(generator);
+        }
+
+        elsetrec satrec = elsetrec();
+        sgp4init(wgs72, 'i', i, startJD - 1. - 2433281.5, 1e-5, 0.001 + 0.01*uniform(generator),
+                 2.*M_PI*uniform(generator), inclination*M_PI/180., 2.*M_PI*uniform(generator),
+                 revolutionsPerDay*2.*M_PI/1440., 2.*M_PI*uniform(generator), satrec);
+        satrec.jdsatepoch = startJD - 1.;
+        predictor.addSatellite(QString::number(i), QString("SYNTH %1").arg(i), satrec);
+    }
+
+    QBENCHMARK {
+        predictor.predict(startJD, startJD + days);
+    }
+}
@@ -30,6 +30,11 @@ private slots:
     void testCelestrackFormattedLine2();
     void testSpaceTrackFormattedLine2();
     void testNoSatDuplication();
+    void testBatchPropagation_data();
+    void testBatchPropagation();
+    void testPassPrediction();
+    void benchmarkPassPrediction_data();
+    void benchmarkPassPrediction();
 };
 
 #endif // TESTSATELLITES_HPP
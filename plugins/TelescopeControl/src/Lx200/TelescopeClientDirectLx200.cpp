@@ -39,6 +39,7 @@ TelescopeClientDirectLx200::TelescopeClientDirectLx200 (const QString &name, con
 	: TelescopeClient(name)
 	, time_delay(0)
 	, equinox(eq)
+	, channel(Q_NULLPTR)
 	, lx200(Q_NULLPTR)
 	, long_format_used(false)
 	, answers_received(false)
@@ -96,6 +97,8 @@ TelescopeClientDirectLx200::TelescopeClientDirectLx200 (const QString &name, con
 	queue_get_position = true;
 	next_pos_time = -0x8000000000000000LL;
 	answers_received = false;
+
+	channel = new TelescopeServerChannel(*this, lx200);
 }
 
 //! queues a GOTO command
@@ -120,7 +123,12 @@ void TelescopeClientDirectLx200::telescopeGoto(const Vec3d &j2000Pos, StelObject
 	unsigned int ra_int = static_cast<unsigned int>(floor(0.5 + ra*(static_cast<unsigned int>(0x80000000)/M_PI)));
 	int dec_int = static_cast<int>(floor(0.5 + dec*(static_cast<unsigned int>(0x80000000)/M_PI)));
 
-	gotoReceived(ra_int, dec_int);
+	// gotoReceived() is called in the I/O thread
+	TelescopeCommand command;
+	command.type = TelescopeCommand::Goto;
+	command.ra_int = ra_int;
+	command.dec_int = dec_int;
+	channel->queueCommand(command);
 }
 
 void TelescopeClientDirectLx200::telescopeSync(const Vec3d &j2000Pos, StelObjectP selectObject)
@@ -144,7 +152,12 @@ void TelescopeClientDirectLx200::telescopeSync(const Vec3d &j2000Pos, StelObject
 	unsigned int ra_int = static_cast<unsigned int>(floor(0.5 + ra*(static_cast<unsigned int>(0x80000000)/M_PI)));
 	int dec_int = static_cast<int>(floor(0.5 + dec*(static_cast<unsigned int>(0x80000000)/M_PI)));
 
-	syncReceived(ra_int, dec_int);
+	// syncReceived() is called in the I/O thread
+	TelescopeCommand command;
+	command.type = TelescopeCommand::Sync;
+	command.ra_int = ra_int;
+	command.dec_int = dec_int;
+	channel->queueCommand(command);
 }
 
 void TelescopeClientDirectLx200::gotoReceived(unsigned int ra_int, int dec_int)
@@ -166,15 +179,16 @@ Vec3d TelescopeClientDirectLx200::getJ2000EquatorialPos(const StelCore*) const
 	return interpolatedPosition.get(now);
 }
 
+//! the communication itself is performed by the I/O thread
 bool TelescopeClientDirectLx200::prepareCommunication()
 {
-	//TODO: Nothing to prepare?
-	return true;
+	return (channel != Q_NULLPTR);
 }
 
+//! takes the positions received by the I/O thread
 void TelescopeClientDirectLx200::performCommunication()
 {
-	step(10000);
+	addReceivedPositions(channel, interpolatedPosition, equinox);
 }
 
 void TelescopeClientDirectLx200::communicationResetReceived(void)
@@ -243,28 +257,17 @@ void TelescopeClientDirectLx200::step(long long int timeout_micros)
 
 bool TelescopeClientDirectLx200::isConnected(void) const
 {
-	return (!lx200->isClosed());//TODO
+	return (channel && channel->isConnected());
 }
 
 bool TelescopeClientDirectLx200::isInitialized(void) const
 {
-	return (!lx200->isClosed());
+	return (channel && channel->isConnected());
 }
 
 //Merged from Connection::sendPosition() and TelescopeTCP::performReading()
+//Called in the I/O thread, the conversion to J2000 is done by the main thread
 void TelescopeClientDirectLx200::sendPosition(unsigned int ra_int, int dec_int, int status)
 {
-	//Server time is "now", because this class is the server
-	const qint64 server_micros = static_cast<qint64>(getNow());
-	const double ra  =  ra_int * (M_PI/0x80000000u);
-	const double dec = dec_int * (M_PI/0x80000000u);
-	const double cdec = cos(dec);
-	Vec3d position(cos(ra)*cdec, sin(ra)*cdec, sin(dec));
-	Vec3d j2000Position = position;
-	if (equinox == EquinoxJNow)
-	{
-		const StelCore* core = StelApp::getInstance().getCore();
-		j2000Position = core->equinoxEquToJ2000(position, StelCore::RefractionOff);
-	}
-	interpolatedPosition.add(j2000Position, getNow(), server_micros, status);
+	channel->positionReceived(ra_int, dec_int, status);
 }
@@ -48,11 +48,14 @@ public:
 	~TelescopeClientDirectLx200(void)
 	{
 		//hangup();
+		if (channel)
+			channel->release();
 	}
 	
 	//======================================================================
 	// Methods inherited from TelescopeClient
 	bool isConnected(void) const;
+	TelescopeIOChannel* getIOChannel() const {return channel;}
 	
 	//======================================================================
 	// Methods inherited from Server
@@ -90,6 +93,8 @@ private:
 	}
 
 	Equinox equinox;
+	//! Performs the communication in the I/O thread; the members below are only used there.
+	TelescopeServerChannel* channel;
 	
 	//======================================================================
 	// Members inherited from ServerLx200
@@ -39,6 +39,7 @@ TelescopeClientDirectNexStar::TelescopeClientDirectNexStar(const QString &name,
 	: TelescopeClient(name)
 	, time_delay(0)
 	, equinox(eq)
+	, channel(Q_NULLPTR)
 	, nexstar(Q_NULLPTR)
 	, last_ra(0)
 	, queue_get_position(true)
@@ -92,6 +93,8 @@ TelescopeClientDirectNexStar::TelescopeClientDirectNexStar(const QString &name,
 	last_ra = 0;
 	queue_get_position = true;
 	next_pos_time = -0x8000000000000000LL;
+
+	channel = new TelescopeServerChannel(*this, nexstar);
 }
 
 //! queues a GOTO command
@@ -116,7 +119,12 @@ void TelescopeClientDirectNexStar::telescopeGoto(const Vec3d &j2000Pos, StelObje
 	unsigned int ra_int = static_cast<unsigned int>(floor(0.5 + ra*(static_cast<unsigned int>(0x80000000)/M_PI)));
 	int dec_int = static_cast<int>(floor(0.5 + dec*(static_cast<unsigned int>(0x80000000)/M_PI)));
 
-	gotoReceived(ra_int, dec_int);
+	// gotoReceived() is called in the I/O thread
+	TelescopeCommand command;
+	command.type = TelescopeCommand::Goto;
+	command.ra_int = ra_int;
+	command.dec_int = dec_int;
+	channel->queueCommand(command);
 }
 
 void TelescopeClientDirectNexStar::telescopeSync(const Vec3d &j2000Pos, StelObjectP selectObject)
@@ -140,7 +148,12 @@ void TelescopeClientDirectNexStar::telescopeSync(const Vec3d &j2000Pos, StelObje
 	unsigned int ra_int = static_cast<unsigned int>(floor(0.5 + ra*(static_cast<unsigned int>(0x80000000)/M_PI)));
 	int dec_int = static_cast<int>(floor(0.5 + dec*(static_cast<unsigned int>(0x80000000)/M_PI)));
 
-	syncReceived(ra_int, dec_int);
+	// syncReceived() is called in the I/O thread
+	TelescopeCommand command;
+	command.type = TelescopeCommand::Sync;
+	command.ra_int = ra_int;
+	command.dec_int = dec_int;
+	channel->queueCommand(command);
 }
 
 
@@ -162,15 +175,16 @@ Vec3d TelescopeClientDirectNexStar::getJ2000EquatorialPos(const StelCore*) const
 	return interpolatedPosition.get(now);
 }
 
+//! the communication itself is performed by the I/O thread
 bool TelescopeClientDirectNexStar::prepareCommunication()
 {
-	//TODO: Nothing to prepare?
-	return true;
+	return (channel != Q_NULLPTR);
 }
 
+//! takes the positions received by the I/O thread
 void TelescopeClientDirectNexStar::performCommunication()
 {
-	step(10000);
+	addReceivedPositions(channel, interpolatedPosition, equinox);
 }
 
 void TelescopeClientDirectNexStar::communicationResetReceived(void)
@@ -218,28 +232,17 @@ void TelescopeClientDirectNexStar::step(long long int timeout_micros)
 
 bool TelescopeClientDirectNexStar::isConnected(void) const
 {
-	return (!nexstar->isClosed());//TODO
+	return (channel && channel->isConnected());
 }
 
 bool TelescopeClientDirectNexStar::isInitialized(void) const
 {
-	return (!nexstar->isClosed());
+	return (channel && channel->isConnected());
 }
 
 //Merged from Connection::sendPosition() and TelescopeTCP::performReading()
+//Called in the I/O thread, the conversion to J2000 is done by the main thread
 void TelescopeClientDirectNexStar::sendPosition(unsigned int ra_int, int dec_int, int status)
 {
-	//Server time is "now", because this class is the server
-	const qint64 server_micros = static_cast<qint64>(GetNow());
-	const double ra  =  ra_int * (M_PI/0x80000000u);
-	const double dec = dec_int * (M_PI/0x80000000u);
-	const double cdec = cos(dec);
-	Vec3d position(cos(ra)*cdec, sin(ra)*cdec, sin(dec));
-	Vec3d j2000Position = position;
-	if (equinox == EquinoxJNow)
-	{
-		const StelCore* core = StelApp::getInstance().getCore();
-		j2000Position = core->equinoxEquToJ2000(position, StelCore::RefractionOff);
-	}
-	interpolatedPosition.add(j2000Position, getNow(), server_micros, status);
+	channel->positionReceived(ra_int, dec_int, status);
 }
@@ -49,11 +49,14 @@ public:
 	~TelescopeClientDirectNexStar(void)
 	{
 		//hangup();
+		if (channel)
+			channel->release();
 	}
 	
 	//======================================================================
 	// Methods inherited from TelescopeClient
 	bool isConnected(void) const;
+	TelescopeIOChannel* getIOChannel() const {return channel;}
 	
 	//======================================================================
 	// Methods inherited from Server
@@ -90,6 +93,8 @@ private:
 	}
 
 	Equinox equinox;
+	//! Performs the communication in the I/O thread; the members below are only used there.
+	TelescopeServerChannel* channel;
 	
 	//======================================================================
 	// Members taken from ServerNexStar
@@ -160,6 +160,31 @@ void TelescopeClient::move(double angle, double speed)
 	qDebug() << "TelescopeClient::move not implemented";
 }
 
+void TelescopeClient::addReceivedPositions(TelescopeIOChannel *channel, InterpolatedPosition &positions, Equinox equinox)
+{
+	TelescopePositionSample sample;
+	while (channel->takeSample(sample))
+	{
+		if (sample.reset)
+		{
+			positions.reset();
+			continue;
+		}
+
+		const double ra  =  sample.ra_int * (M_PI/0x80000000u);
+		const double dec = sample.dec_int * (M_PI/0x80000000u);
+		const double cdec = cos(dec);
+		Vec3d position(cos(ra)*cdec, sin(ra)*cdec, sin(dec));
+		Vec3d j2000Position = position;
+		if (equinox == EquinoxJNow)
+		{
+			const StelCore* core = StelApp::getInstance().getCore();
+			j2000Position = core->equinoxEquToJ2000(position, StelCore::RefractionOff);
+		}
+		positions.add(j2000Position, sample.client_micros, sample.server_micros, sample.status);
+	}
+}
+
 //! returns the current system time in microseconds since the Epoch
 //! Prior to revision 6308, it was necessary to put put this method in an
 //! #ifdef block, as duplicate function definition caused errors during static
@@ -187,13 +212,10 @@ qint64 getNow(void)
 TelescopeTCP::TelescopeTCP(const QString &name, const QString &params, Equinox eq)
 	: TelescopeClient(name)
 	, port(0)
-	, tcpSocket(new QTcpSocket())
-	, end_of_timeout(0)
 	, time_delay(0)
+	, channel(Q_NULLPTR)
 	, equinox(eq)
 {
-	hangup();
-	
 	// Example params:
 	// localhost:10000:500000
 	// split into:
@@ -219,13 +241,13 @@ TelescopeTCP::TelescopeTCP(const QString &name, const QString &params, Equinox e
 	}
 
 	qDebug() << "TelescopeTCP paramaters host, port, time_delay:" << host << port << time_delay;
-	
+
 	if (time_delay <= 0 || time_delay > 10000000)
 	{
 		qWarning() << "ERROR creating TelescopeTCP - time_delay not valid (should be less than 10000000)";
 		return;
 	}
-	
+
 	//BM: TODO: This may cause some delay when there are more telescopes
 	QHostInfo info = QHostInfo::fromName(host);
 	if (info.error())
@@ -249,32 +271,19 @@ TelescopeTCP::TelescopeTCP(const QString &name, const QString &params, Equinox e
 		qWarning() << "ERROR creating TelescopeTCP: cannot find IPv4 address. Addresses found at " << host << ":" << info.addresses();
 		return;
 	}
-	
-	end_of_timeout = -0x8000000000000000LL;
-	
+
 	interpolatedPosition.reset();
-	
-	connect(tcpSocket, SIGNAL(connected()), this, SLOT(socketConnected()));
-	connect(tcpSocket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(socketFailed(QAbstractSocket::SocketError)));
+
+	channel = new TelescopeTCPChannel(name, address, port);
 }
 
-void TelescopeTCP::hangup(void)
+TelescopeTCP::~TelescopeTCP(void)
 {
-	if (tcpSocket->isValid())
-	{
-		tcpSocket->abort();// Or maybe tcpSocket->close()?
-	}
-	
-	readBufferEnd = readBuffer;
-	writeBufferEnd = writeBuffer;
-	wait_for_connection_establishment = false;
-	
-	interpolatedPosition.reset();
+	if (channel)
+		channel->release();
 }
 
-//! queues a GOTO command with the specified position to the write buffer.
-//! For the data format of the command see the
-//! "Stellarium telescope control protocol" text file
+//! queues a GOTO command with the specified position for the I/O thread.
 void TelescopeTCP::telescopeGoto(const Vec3d &j2000Pos, StelObjectP selectObject)
 {
 	Q_UNUSED(selectObject)
@@ -289,14 +298,121 @@ void TelescopeTCP::telescopeGoto(const Vec3d &j2000Pos, StelObjectP selectObject
 		position = core->j2000ToEquinoxEqu(j2000Pos, StelCore::RefractionOff);
 	}
 
+	const double ra_signed = atan2(position[1], position[0]);
+	//Workaround for the discrepancy in precision between Windows/Linux/PPC Macs and Intel Macs:
+	const double ra = (ra_signed >= 0) ? ra_signed : (ra_signed + 2.0 * M_PI);
+	const double dec = atan2(position[2], std::sqrt(position[0]*position[0]+position[1]*position[1]));
+	TelescopeCommand command;
+	command.type = TelescopeCommand::Goto;
+	command.ra_int = static_cast<unsigned int>(floor(0.5 + ra*((static_cast<unsigned int>(0x80000000))/M_PI)));
+	command.dec_int = static_cast<int>(floor(0.5 + dec*((static_cast<unsigned int>(0x80000000))/M_PI)));
+	if (!channel->queueCommand(command))
+	{
+		qDebug() << "TelescopeTCP(" << name << ")::telescopeGoto: "<< "communication is too slow, I will ignore this command";
+	}
+}
+
+void TelescopeTCP::telescopeSync(const Vec3d &j2000Pos, StelObjectP selectObject)
+{
+	Q_UNUSED(j2000Pos)
+	Q_UNUSED(selectObject)
+	return;
+}
+
+//! estimates where the telescope is by interpolation in the stored
+//! telescope positions:
+Vec3d TelescopeTCP::getJ2000EquatorialPos(const StelCore*) const
+{
+	const qint64 now = getNow() - time_delay;
+	return interpolatedPosition.get(now);
+}
+
+//! the communication itself is performed by the I/O thread
+bool TelescopeTCP::prepareCommunication()
+{
+	return (channel != Q_NULLPTR);
+}
+
+//! takes the positions received by the I/O thread
+void TelescopeTCP::performCommunication()
+{
+	addReceivedPositions(channel, interpolatedPosition, equinox);
+}
+
+TelescopeTCPChannel::TelescopeTCPChannel(const QString &name, const QHostAddress &address, quint16 port)
+	: name(name)
+	, address(address)
+	, port(port)
+	, tcpSocket(Q_NULLPTR)
+	, connectionTimer(Q_NULLPTR)
+	, wait_for_connection_establishment(false)
+	, end_of_timeout(-0x8000000000000000LL)
+{
+	readBufferEnd = readBuffer;
+	writeBufferEnd = writeBuffer;
+}
+
+void TelescopeTCPChannel::openConnection()
+{
+	// created here, so that the socket belongs to the I/O thread
+	tcpSocket = new QTcpSocket(this);
+	connect(tcpSocket, SIGNAL(connected()), this, SLOT(socketConnected()));
+	connect(tcpSocket, SIGNAL(readyRead()), this, SLOT(socketReadyRead()));
+	connect(tcpSocket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(socketFailed(QAbstractSocket::SocketError)));
+
+	connectionTimer = new QTimer(this);
+	connect(connectionTimer, SIGNAL(timeout()), this, SLOT(checkConnection()));
+	connectionTimer->start(100);
+	checkConnection();
+}
+
+void TelescopeTCPChannel::closeConnection()
+{
+	if (tcpSocket)
+	{
+		hangup();
+		tcpSocket->deleteLater();
+		tcpSocket = Q_NULLPTR;
+	}
+	if (connectionTimer)
+	{
+		connectionTimer->stop();
+		connectionTimer->deleteLater();
+		connectionTimer = Q_NULLPTR;
+	}
+}
+
+void TelescopeTCPChannel::hangup(void)
+{
+	if (tcpSocket->isValid())
+	{
+		tcpSocket->abort();// Or maybe tcpSocket->close()?
+	}
+
+	readBufferEnd = readBuffer;
+	writeBufferEnd = writeBuffer;
+	wait_for_connection_establishment = false;
+
+	if (isConnected())
+	{
+		setConnected(false);
+		resetSamples();
+	}
+}
+
+//! writes a GOTO command with the specified position to the write buffer.
+//! For the data format of the command see the
+//! "Stellarium telescope control protocol" text file
+void TelescopeTCPChannel::handleCommand(const TelescopeCommand &command)
+{
+	// The protocol has no sync command
+	if (command.type != TelescopeCommand::Goto || !tcpSocket || tcpSocket->state() != QAbstractSocket::ConnectedState)
+		return;
+
 	if (writeBufferEnd - writeBuffer + 20 < static_cast<int>(sizeof(writeBuffer)))
 	{
-		const double ra_signed = atan2(position[1], position[0]);
-		//Workaround for the discrepancy in precision between Windows/Linux/PPC Macs and Intel Macs:
-		const double ra = (ra_signed >= 0) ? ra_signed : (ra_signed + 2.0 * M_PI);
-		const double dec = atan2(position[2], std::sqrt(position[0]*position[0]+position[1]*position[1]));
-		unsigned int ra_int = static_cast<unsigned int>(floor(0.5 + ra*((static_cast<unsigned int>(0x80000000))/M_PI)));
-		int dec_int = static_cast<int>(floor(0.5 + dec*((static_cast<unsigned int>(0x80000000))/M_PI)));
+		unsigned int ra_int = command.ra_int;
+		int dec_int = command.dec_int;
 		// length of packet:
 		*writeBufferEnd++ = 20;
 		*writeBufferEnd++ = 0;
@@ -341,18 +457,14 @@ void TelescopeTCP::telescopeGoto(const Vec3d &j2000Pos, StelObjectP selectObject
 	{
 		qDebug() << "TelescopeTCP(" << name << ")::telescopeGoto: "<< "communication is too slow, I will ignore this command";
 	}
+	performWriting();
 }
 
-void TelescopeTCP::telescopeSync(const Vec3d &j2000Pos, StelObjectP selectObject)
-{
-	Q_UNUSED(j2000Pos)
-	Q_UNUSED(selectObject)
-	return;
-}
-
-void TelescopeTCP::performWriting(void)
+void TelescopeTCPChannel::performWriting(void)
 {
 	const qint64 to_write = writeBufferEnd - writeBuffer;
+	if (to_write == 0)
+		return;
 	const qint64 rc = tcpSocket->write(writeBuffer, to_write);
 	if (rc < 0)
 	{
@@ -377,8 +489,20 @@ void TelescopeTCP::performWriting(void)
 	}
 }
 
+void TelescopeTCPChannel::socketReadyRead(void)
+{
+	// All the positions which arrived together get the same receive time
+	const qint64 client_micros = getNow();
+	while (tcpSocket && tcpSocket->state() == QAbstractSocket::ConnectedState && tcpSocket->bytesAvailable() > 0)
+	{
+		//If performReading() is called when there are no bytes to read,
+		//it closes the connection
+		performReading(client_micros);
+	}
+}
+
 //! try to read some data from the telescope server
-void TelescopeTCP::performReading(void)
+void TelescopeTCPChannel::performReading(qint64 client_micros)
 {
 	const qint64 to_read = readBuffer + sizeof(readBuffer) - readBufferEnd;
 	const qint64 rc = tcpSocket->read(readBufferEnd, to_read);
@@ -452,17 +576,8 @@ void TelescopeTCP::performReading(void)
 						((static_cast<unsigned int>(static_cast<unsigned char>(p[22])) << 16)) |
 						((static_cast<unsigned int>(static_cast<unsigned char>(p[23])) << 24)));
 
-					const double ra  =  ra_int * (M_PI/0x80000000u);
-					const double dec = dec_int * (M_PI/0x80000000u);
-					const double cdec = cos(dec);
-					Vec3d position(cos(ra)*cdec, sin(ra)*cdec, sin(dec));
-					Vec3d j2000Position = position;
-					if (equinox == EquinoxJNow)
-					{
-						const StelCore* core = StelApp::getInstance().getCore();
-						j2000Position = core->equinoxEquToJ2000(position, StelCore::RefractionOff);
-					}
-					interpolatedPosition.add(j2000Position, getNow(), server_micros, status);
+					// the conversion to J2000 is done by the main thread
+					addSample(client_micros, server_micros, ra_int, dec_int, status);
 				}
 				break;
 				default:
@@ -485,73 +600,48 @@ void TelescopeTCP::performReading(void)
 	}
 }
 
-//! estimates where the telescope is by interpolation in the stored
-//! telescope positions:
-Vec3d TelescopeTCP::getJ2000EquatorialPos(const StelCore*) const
-{
-	const qint64 now = getNow() - time_delay;
-	return interpolatedPosition.get(now);
-}
-
-//! checks if the socket is connected, tries to connect if it is not
-//@return true if the socket is connected
-bool TelescopeTCP::prepareCommunication()
+void TelescopeTCPChannel::checkConnection()
 {
 	if(tcpSocket->state() == QAbstractSocket::ConnectedState)
+		return;
+
+	if (isConnected())
 	{
-		if(wait_for_connection_establishment)
-		{
-			wait_for_connection_establishment = false;
-			qDebug() << "TelescopeTCP(" << name << ")::prepareCommunication: Connection established";
-		}
-		return true;
+		qDebug() << "TelescopeTCP(" << name << ")::checkConnection: " << "server has closed the connection";
+		hangup();
 	}
-	else if(wait_for_connection_establishment)
+
+	const qint64 now = getNow();
+	if(wait_for_connection_establishment)
 	{
-		const qint64 now = getNow();
 		if (now > end_of_timeout)
 		{
 			end_of_timeout = now + 1000000;
-			qDebug() << "TelescopeTCP(" << name << ")::prepareCommunication: Connection attempt timed out";
+			qDebug() << "TelescopeTCP(" << name << ")::checkConnection: Connection attempt timed out";
 			hangup();
 		}
 	}
 	else
 	{
-		const qint64 now = getNow();
-		if (now < end_of_timeout) 
-			return false; //Don't try to reconnect for some time
+		if (now < end_of_timeout)
+			return; //Don't try to reconnect for some time
 		end_of_timeout = now + 5000000;
 		tcpSocket->connectToHost(address, port);
 		wait_for_connection_establishment = true;
-		qDebug() << "TelescopeTCP(" << name << ")::prepareCommunication: Attempting to connect to host" << address.toString() << "at port" << port;
+		qDebug() << "TelescopeTCP(" << name << ")::checkConnection: Attempting to connect to host" << address.toString() << "at port" << port;
 	}
-	return false;
 }
 
-void TelescopeTCP::performCommunication()
+void TelescopeTCPChannel::socketConnected(void)
 {
-	if (tcpSocket->state() == QAbstractSocket::ConnectedState)
-	{
-		performWriting();
-		
-		if (tcpSocket->bytesAvailable() > 0)
-		{
-			//If performReading() is called when there are no bytes to read,
-			//it closes the connection
-			performReading();
-		}
-	}
-}
-
-void TelescopeTCP::socketConnected(void)
-{
-	qDebug() << "TelescopeTCP(" << name <<"): turning off Nagle algorithm.";
+	wait_for_connection_establishment = false;
+	qDebug() << "TelescopeTCP(" << name << "): Connection established, turning off Nagle algorithm.";
 	tcpSocket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+	setConnected(true);
 }
 
 //TODO: More informative error messages?
-void TelescopeTCP::socketFailed(QAbstractSocket::SocketError)
+void TelescopeTCPChannel::socketFailed(QAbstractSocket::SocketError)
 {
 	qDebug() << "TelescopeTCP(" << name << "): TCP socket error:\n" << tcpSocket->errorString();
 }
@@ -31,11 +31,13 @@
 #include <QList>
 #include <QString>
 #include <QTcpSocket>
+#include <QTimer>
 #include <QObject>
 
 #include "StelApp.hpp"
 #include "StelObject.hpp"
 #include "common/InterpolatedPosition.hpp"
+#include "common/TelescopeIOChannel.hpp"
 
 class StelCore;
 
@@ -96,11 +98,16 @@ public:
 	
 	virtual bool prepareCommunication() {return false;}
 	virtual void performCommunication() {}
+	//! Returns the part of the client which communicates with the telescope in the I/O thread, if it has one.
+	//! TelescopeControl moves it to its TelescopeIOThread.
+	virtual TelescopeIOChannel* getIOChannel() const {return Q_NULLPTR;}
 
 	virtual QWidget* createControlWidget(QSharedPointer<TelescopeClient> telescope, QWidget* parent = Q_NULLPTR) const { Q_UNUSED(telescope) Q_UNUSED(parent) return Q_NULLPTR; }
 
 protected:
 	TelescopeClient(const QString &name);
+	//! Adds the positions received by \p channel to \p positions, converted to J2000.
+	static void addReceivedPositions(TelescopeIOChannel* channel, InterpolatedPosition& positions, Equinox equinox);
 	QString nameI18n;
 	const QString name;
 
@@ -172,25 +179,61 @@ private:
 	Vec3d desired_pos;
 };
 
+//! Communicates with a server process ("telescope server") for TelescopeTCP
+//! via the "Stellarium telescope control protocol" over TCP/IP, in the I/O thread.
+//! The socket is created in the I/O thread, and the positions are read as soon as they arrive.
+class TelescopeTCPChannel : public TelescopeIOChannel
+{
+	Q_OBJECT
+public:
+	TelescopeTCPChannel(const QString &name, const QHostAddress &address, quint16 port);
+
+protected:
+	void openConnection();
+	void closeConnection();
+	void handleCommand(const TelescopeCommand &command);
+
+private:
+	void performReading(qint64 client_micros);
+	void performWriting(void);
+	void hangup(void);
+	const QString name;
+	QHostAddress address;
+	quint16 port;
+	QTcpSocket * tcpSocket;
+	QTimer * connectionTimer;
+	bool wait_for_connection_establishment;
+	qint64 end_of_timeout;
+	char readBuffer[120];
+	char *readBufferEnd;
+	char writeBuffer[120];
+	char *writeBufferEnd;
+
+private slots:
+	//! Tries to connect if the socket is not connected, called periodically
+	void checkConnection(void);
+	void socketReadyRead(void);
+	void socketConnected(void);
+	void socketFailed(QAbstractSocket::SocketError socketError);
+};
+
 //! This TelescopeClient class can control a telescope by communicating
 //! to a server process ("telescope server") via 
 //! the "Stellarium telescope control protocol" over TCP/IP.
 //! The "Stellarium telescope control protocol" is specified in a separate
 //! document along with the telescope server software.
+//! The communication is performed by a TelescopeTCPChannel in the I/O thread.
 class TelescopeTCP : public TelescopeClient
 {
 	Q_OBJECT
 public:
 	TelescopeTCP(const QString &name, const QString &params, Equinox eq = EquinoxJ2000);
-	~TelescopeTCP(void)
-	{
-		hangup();
-	}
+	~TelescopeTCP(void);
 	bool isConnected(void) const
 	{
-		//return (tcpSocket->isValid() && !wait_for_connection_establishment);
-		return (tcpSocket->state() == QAbstractSocket::ConnectedState);
+		return (channel && channel->isConnected());
 	}
+	TelescopeIOChannel* getIOChannel() const {return channel;}
 	
 private:
 	Vec3d getJ2000EquatorialPos(const StelCore* core=Q_NULLPTR) const;
@@ -202,21 +245,12 @@ private:
 	{
 		return (!address.isNull());
 	}
-	void performReading(void);
-	void performWriting(void);
 	
 private:
-	void hangup(void);
 	QHostAddress address;
 	quint16 port;
-	QTcpSocket * tcpSocket;
-	bool wait_for_connection_establishment;
-	qint64 end_of_timeout;
-	char readBuffer[120];
-	char *readBufferEnd;
-	char writeBuffer[120];
-	char *writeBufferEnd;
 	int time_delay;
+	TelescopeTCPChannel * channel;
 
 	InterpolatedPosition interpolatedPosition;
 	virtual bool hasKnownPosition(void) const
@@ -225,10 +259,6 @@ private:
 	}
 
 	Equinox equinox;
-	
-private slots:
-	void socketConnected(void);
-	void socketFailed(QAbstractSocket::SocketError socketError);
 };
 
 #endif // TELESCOPECLIENT_HPP
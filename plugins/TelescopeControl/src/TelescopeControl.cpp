@@ -31,6 +31,7 @@
 #include "gui/TelescopeDialog.hpp"
 #include "gui/SlewDialog.hpp"
 #include "common/LogFile.hpp"
+#include "common/TelescopeIOChannel.hpp"
 
 #include "StelApp.hpp"
 #include "StelCore.hpp"
@@ -100,6 +101,7 @@ TelescopeControl::TelescopeControl()
 	, moveToCenterActionId("actionSlew_Telescope_To_Direction_%1")
 {
 	setObjectName("TelescopeControl");
+	ioThread = new TelescopeIOThread(this);
 
 	connectionTypeNames.insert(ConnectionVirtual, "virtual");
 	connectionTypeNames.insert(ConnectionInternal, "internal");
@@ -1406,6 +1408,9 @@ bool TelescopeControl::startClientAtSlot(int slotNumber, ConnectionType connecti
 			for (int i = 0; i < circles.size(); ++i)
 				newTelescope->addOcular(circles[i]);
 
+		if (newTelescope->getIOChannel())
+			ioThread->addChannel(newTelescope->getIOChannel());
+
 		telescopeClients.insert(slotNumber, TelescopeClientP(newTelescope));
 		return true;
 	}
@@ -52,6 +52,7 @@ class StelObject;
 class StelPainter;
 class StelProjector;
 class TelescopeClient;
+class TelescopeIOThread;
 class TelescopeDialog;
 class SlewDialog;
 
@@ -333,7 +334,8 @@ private:
 	//! Draw a nice animated pointer around the object if it's selected
 	void drawPointer(const StelProjectorP& prj, const StelCore* core, StelPainter& sPainter);
 
-	//! Perform the communication with the telescope servers
+	//! Perform the communication with the telescope servers, or take the positions
+	//! received by the I/O thread for the telescopes which communicate there
 	void communicate(void);
 
 	LinearFader labelFader;
@@ -360,6 +362,9 @@ private:
 	//! Contains the initialized telescope client objects representing the telescopes that Stellarium is
 	//! connected to or attempting to connect to.
 	QMap<int, TelescopeClientP> telescopeClients;
+	//! Performs the communication of the telescope clients which have a TelescopeIOChannel,
+	//! so that slow telescopes don't delay the frames.
+	TelescopeIOThread* ioThread;
 	//! Contains QProcess objects of the currently running telescope server processes that have been launched
 	//! by Stellarium.
 	QHash<int, QProcess*> telescopeServerProcess;
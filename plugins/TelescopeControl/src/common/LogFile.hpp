@@ -38,6 +38,8 @@ public:
 
 QTextStream &operator<<(QTextStream &o, const Now &now);
 
-extern QTextStream *log_file;
+//! Each thread has its own log, because the telescopes which communicate
+//! in the I/O thread (see TelescopeIOChannel) have their own logs.
+extern thread_local QTextStream *log_file;
 
 #endif
@@ -89,6 +89,16 @@ void Server::step(long long int timeout_micros)
 	}
 }
 
+bool Server::hasConnection(const Socket *s) const
+{
+	for (auto* socket : socket_list)
+	{
+		if (socket == s)
+			return true;
+	}
+	return false;
+}
+
 void Server::closeAcceptedConnections(void)
 {
 	for (auto* socket : socket_list)
@@ -49,6 +49,8 @@ public:
 	Server(int port);
 	virtual ~Server(void) {}
 	virtual void step(long long int timeout_micros);
+	//! Returns true if \p s is in the list of connections, i.e. it has not been deleted by step().
+	bool hasConnection(const Socket *s) const;
 	
 protected:
 	void sendPosition(unsigned int ra_int, int dec_int, int status);
@@ -70,6 +72,7 @@ private:
 	virtual void gotoReceived(unsigned int ra_int, int dec_int) = 0;
 	virtual void syncReceived(unsigned int ra_int, int dec_int) = 0;
 	friend class Connection;
+	friend class TelescopeServerChannel;
 	
 	class SocketList : public list<Socket*>
 	{
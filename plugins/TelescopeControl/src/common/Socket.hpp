@@ -93,6 +93,8 @@ public:
 		return IS_INVALID_SOCKET(fd);
 	}
 	virtual bool isTcpConnection() const { return false; }
+	//! Returns the file descriptor of the connection, e.g. to watch it for incoming data.
+	SOCKET getFd() const { return fd; }
 	virtual void sendPosition(unsigned int ra_int, int dec_int, int status) {Q_UNUSED(ra_int); Q_UNUSED(dec_int); Q_UNUSED(status);}
 	
 protected:
@@ -0,0 +1,74 @@
+/*
+ * Stellarium Telescope Control Plug-in
+ *
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef SPSCRING_HPP
+#define SPSCRING_HPP
+
+#include <QAtomicInt>
+
+//! A queue of fixed capacity between exactly one producer thread and one consumer thread.
+//! Only the producer writes the tail index and only the consumer writes the head index,
+//! so push() and pop() never lock, never wait and never allocate.
+template<class T, int Capacity>
+class SpscRing
+{
+public:
+	SpscRing() : head(0), tail(0) {}
+
+	//! Appends a copy of \p item. Must only be called by the producer thread.
+	//! @return false if the queue is full; the item is not appended
+	bool push(const T& item)
+	{
+		const int t = tail.loadAcquire();
+		const int next = (t + 1) % (Capacity + 1);
+		if (next == head.loadAcquire())
+			return false;
+		items[t] = item;
+		tail.storeRelease(next);
+		return true;
+	}
+
+	//! Removes the oldest item and copies it to \p item. Must only be called by the consumer thread.
+	//! @return false if the queue is empty
+	bool pop(T& item)
+	{
+		const int h = head.loadAcquire();
+		if (h == tail.loadAcquire())
+			return false;
+		item = items[h];
+		head.storeRelease((h + 1) % (Capacity + 1));
+		return true;
+	}
+
+	bool isEmpty() const
+	{
+		return head.loadAcquire() == tail.loadAcquire();
+	}
+
+private:
+	Q_DISABLE_COPY(SpscRing)
+
+	//! One slot is always free, to tell a full queue from an empty one
+	T items[Capacity + 1];
+	QAtomicInt head;
+	QAtomicInt tail;
+};
+
+#endif // SPSCRING_HPP
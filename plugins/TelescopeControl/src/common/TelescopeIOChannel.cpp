@@ -0,0 +1,231 @@
+/*
+ * Stellarium Telescope Control Plug-in
+ *
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "TelescopeIOChannel.hpp"
+
+#include <QMetaObject>
+#include <QSocketNotifier>
+#include <QTimer>
+
+#include "Server.hpp"
+#include "Socket.hpp"
+#include "LogFile.hpp"
+#include "StelUtils.hpp"
+
+TelescopeIOChannel::TelescopeIOChannel()
+	: connected(0)
+	, droppedSamples(0)
+	, wakeupQueued(0)
+	, resetPending(false)
+	, stopped(false)
+{
+}
+
+bool TelescopeIOChannel::queueCommand(const TelescopeCommand &command)
+{
+	if (!commands.push(command))
+		return false;
+	// one queued call handles all the commands pushed before it runs
+	if (wakeupQueued.testAndSetOrdered(0, 1))
+		QMetaObject::invokeMethod(this, "processCommands", Qt::QueuedConnection);
+	return true;
+}
+
+bool TelescopeIOChannel::takeSample(TelescopePositionSample &sample)
+{
+	return samples.pop(sample);
+}
+
+void TelescopeIOChannel::release()
+{
+	QThread* ioThread = thread();
+	if (ioThread != QThread::currentThread() && ioThread->isRunning())
+	{
+		QMetaObject::invokeMethod(this, "stop", Qt::BlockingQueuedConnection);
+		deleteLater();
+	}
+	else
+	{
+		stop();
+		delete this;
+	}
+}
+
+void TelescopeIOChannel::start()
+{
+	if (!stopped)
+		openConnection();
+}
+
+void TelescopeIOChannel::stop()
+{
+	if (stopped)
+		return;
+	stopped = true;
+	closeConnection();
+	setConnected(false);
+}
+
+void TelescopeIOChannel::processCommands()
+{
+	wakeupQueued.fetchAndStoreOrdered(0);
+	TelescopeCommand command;
+	while (!stopped && commands.pop(command))
+		handleCommand(command);
+}
+
+void TelescopeIOChannel::addSample(qint64 client_micros, qint64 server_micros, unsigned int ra_int, int dec_int, int status)
+{
+	if (resetPending)
+		resetSamples();
+
+	TelescopePositionSample sample;
+	sample.client_micros = client_micros;
+	sample.server_micros = server_micros;
+	sample.ra_int = ra_int;
+	sample.dec_int = dec_int;
+	sample.status = status;
+	sample.reset = false;
+	// a position must not overtake a pending reset
+	if (resetPending || !samples.push(sample))
+		droppedSamples.ref();
+}
+
+void TelescopeIOChannel::resetSamples()
+{
+	TelescopePositionSample sample;
+	sample.client_micros = 0;
+	sample.server_micros = 0;
+	sample.ra_int = 0;
+	sample.dec_int = 0;
+	sample.status = 0;
+	sample.reset = true;
+	resetPending = !samples.push(sample);
+}
+
+void TelescopeIOChannel::setConnected(bool value)
+{
+	connected.fetchAndStoreOrdered(value ? 1 : 0);
+}
+
+TelescopeServerChannel::TelescopeServerChannel(Server &server, Socket *connection)
+	: server(server)
+	, connection(connection)
+	, log(log_file)
+	, timer(Q_NULLPTR)
+	, notifier(Q_NULLPTR)
+{
+	setConnected(connection && !connection->isClosed());
+}
+
+void TelescopeServerChannel::openConnection()
+{
+	timer = new QTimer(this);
+	timer->setTimerType(Qt::PreciseTimer);
+	connect(timer, SIGNAL(timeout()), this, SLOT(step()));
+	timer->start(10);
+
+#ifndef Q_OS_WIN
+	if (connection && !connection->isClosed())
+	{
+		notifier = new QSocketNotifier(connection->getFd(), QSocketNotifier::Read, this);
+		connect(notifier, SIGNAL(activated(int)), this, SLOT(step()));
+	}
+#endif
+	step();
+}
+
+void TelescopeServerChannel::closeConnection()
+{
+	// this may run in a signal of the notifier or of the timer
+	if (notifier)
+	{
+		notifier->setEnabled(false);
+		notifier->deleteLater();
+		notifier = Q_NULLPTR;
+	}
+	if (timer)
+	{
+		timer->stop();
+		timer->deleteLater();
+		timer = Q_NULLPTR;
+	}
+	connection = Q_NULLPTR;
+}
+
+void TelescopeServerChannel::handleCommand(const TelescopeCommand &command)
+{
+	if (!connection)
+		return;
+	log_file = log;
+	if (command.type == TelescopeCommand::Goto)
+		server.gotoReceived(command.ra_int, command.dec_int);
+	else
+		server.syncReceived(command.ra_int, command.dec_int);
+	// send the command right away
+	step();
+}
+
+void TelescopeServerChannel::positionReceived(unsigned int ra_int, int dec_int, int status)
+{
+	// Server time is "now", because the server is part of the client
+	const qint64 now = GetNow();
+	addSample(now, now, ra_int, dec_int, status);
+}
+
+void TelescopeServerChannel::step()
+{
+	if (isStopped() || !connection)
+		return;
+
+	log_file = log;
+	server.step(0);
+
+	// Server::step() deletes the connection when it was closed
+	if (!server.hasConnection(connection) || connection->isClosed())
+	{
+		if (log_file)
+			*log_file << Now() << "TelescopeServerChannel::step: the connection to the telescope was closed"
+				  << StelUtils::getEndLineChar();
+		closeConnection();
+		setConnected(false);
+		resetSamples();
+	}
+}
+
+TelescopeIOThread::TelescopeIOThread(QObject *parent)
+	: QThread(parent)
+{
+	setObjectName("TelescopeIO");
+}
+
+TelescopeIOThread::~TelescopeIOThread()
+{
+	quit();
+	wait();
+}
+
+void TelescopeIOThread::addChannel(TelescopeIOChannel *channel)
+{
+	channel->moveToThread(this);
+	if (!isRunning())
+		start();
+	QMetaObject::invokeMethod(channel, "start", Qt::QueuedConnection);
+}
@@ -0,0 +1,175 @@
+/*
+ * Stellarium Telescope Control Plug-in
+ *
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef TELESCOPEIOCHANNEL_HPP
+#define TELESCOPEIOCHANNEL_HPP
+
+#include <QAtomicInt>
+#include <QObject>
+#include <QThread>
+
+#include "SpscRing.hpp"
+
+class QSocketNotifier;
+class QTextStream;
+class QTimer;
+class Server;
+class Socket;
+
+//! A position of a telescope as it was received in the I/O thread.
+//! The coordinates are in the units of the Stellarium telescope control protocol,
+//! in the equinox used by the telescope.
+struct TelescopePositionSample
+{
+	//! The time when the position was received, in microseconds since the Epoch
+	qint64 client_micros;
+	//! The time when the position was sent by the telescope server
+	qint64 server_micros;
+	unsigned int ra_int;
+	int dec_int;
+	int status;
+	//! True if the connection was lost; the positions received before are obsolete.
+	//! Such a sample contains no position.
+	bool reset;
+};
+
+//! A command for a telescope, queued by the main thread for the I/O thread.
+struct TelescopeCommand
+{
+	enum Type
+	{
+		Goto,
+		Sync
+	};
+
+	Type type;
+	unsigned int ra_int;
+	int dec_int;
+};
+
+//! The part of a telescope client which communicates with the telescope in the TelescopeIOThread,
+//! so that slow serial ports or networks cannot delay the frames of the main thread.
+//! The main thread queues commands with queueCommand() and takes the received positions with takeSample().
+//! Both go through lock-free single producer, single consumer rings, so neither thread ever waits for the other.
+//! The positions are timestamped when they are received, independently of the frame timing.
+class TelescopeIOChannel : public QObject
+{
+	Q_OBJECT
+public:
+	TelescopeIOChannel();
+	virtual ~TelescopeIOChannel() {}
+
+	//! Queues a command and wakes up the I/O thread. Must only be called by the main thread.
+	//! @return false if too many commands are waiting; the command is dropped
+	bool queueCommand(const TelescopeCommand& command);
+	//! Takes the oldest received position. Must only be called by the main thread.
+	//! @return false if no position is waiting
+	bool takeSample(TelescopePositionSample& sample);
+	bool isConnected() const {return connected.loadAcquire() != 0;}
+	//! Returns the number of positions which were dropped because the main thread did not take them in time.
+	int getDroppedSamples() const {return droppedSamples.loadAcquire();}
+	//! Stops the communication and deletes the channel, from the main thread.
+	//! Blocks until the I/O thread has left the channel, so the channel may refer
+	//! to its telescope client until then.
+	void release();
+
+public slots:
+	//! Starts the communication, in the I/O thread.
+	void start();
+	//! Stops the communication, in the I/O thread.
+	void stop();
+
+protected:
+	virtual void openConnection() = 0;
+	virtual void closeConnection() = 0;
+	virtual void handleCommand(const TelescopeCommand& command) = 0;
+	//! Queues a position for the main thread.
+	//! @param client_micros the time when the position was received
+	void addSample(qint64 client_micros, qint64 server_micros, unsigned int ra_int, int dec_int, int status);
+	//! Tells the main thread that the positions received so far are obsolete.
+	void resetSamples();
+	void setConnected(bool value);
+	bool isStopped() const {return stopped;}
+
+private slots:
+	void processCommands();
+
+private:
+	SpscRing<TelescopePositionSample, 64> samples;
+	SpscRing<TelescopeCommand, 16> commands;
+	QAtomicInt connected;
+	QAtomicInt droppedSamples;
+	//! Set while a call of processCommands() is queued for the I/O thread
+	QAtomicInt wakeupQueued;
+	//! Set if the reset of the positions did not fit in the ring yet (I/O thread only)
+	bool resetPending;
+	bool stopped;
+};
+
+//! Performs the communication of a telescope client which is also a Server
+//! (TelescopeClientDirectLx200 and TelescopeClientDirectNexStar) in the I/O thread.
+//! The server is stepped without waiting whenever the device has sent data, and every 10 ms
+//! to send the queued commands and to handle timeouts. On Windows, where the serial ports
+//! cannot be watched, the timer does all the work.
+class TelescopeServerChannel : public TelescopeIOChannel
+{
+	Q_OBJECT
+public:
+	//! @param server the telescope client; it must call release() in its destructor.
+	//! @param connection the connection to the device, owned by the server
+	TelescopeServerChannel(Server& server, Socket* connection);
+
+	//! Called by the server in the I/O thread when the device has answered its position.
+	void positionReceived(unsigned int ra_int, int dec_int, int status);
+
+protected:
+	void openConnection();
+	void closeConnection();
+	void handleCommand(const TelescopeCommand& command);
+
+private slots:
+	void step();
+
+private:
+	Server& server;
+	//! Q_NULLPTR once the server has closed the connection
+	Socket* connection;
+	//! The log of the telescope, see TelescopeControl::logAtSlot()
+	QTextStream* log;
+	QTimer* timer;
+	QSocketNotifier* notifier;
+};
+
+//! The thread which performs the communication with all the telescopes which have a TelescopeIOChannel.
+//! It only runs an event loop; the channels react to their sockets and timers.
+class TelescopeIOThread : public QThread
+{
+	Q_OBJECT
+public:
+	TelescopeIOThread(QObject* parent = Q_NULLPTR);
+	//! Stops the thread. The channels must have been released before.
+	~TelescopeIOThread();
+
+	//! Moves \p channel to this thread and starts its communication there.
+	//! Starts the thread if it is not running yet.
+	void addChannel(TelescopeIOChannel* channel);
+};
+
+#endif // TELESCOPEIOCHANNEL_HPP
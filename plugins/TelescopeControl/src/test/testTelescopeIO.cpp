@@ -0,0 +1,522 @@
+/*
+ * Stellarium Telescope Control Plug-in
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "testTelescopeIO.hpp"
+
+#include "TelescopeClient.hpp"
+#include "common/LogFile.hpp"
+#include "common/TelescopeIOChannel.hpp"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QScopedPointer>
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef Q_OS_UNIX
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+QTEST_GUILESS_MAIN(TestTelescopeIO)
+
+//! The mock telescope sends its position at 100 Hz
+static const int POSITION_INTERVAL = 10;
+static const int NB_POSITIONS = 300;
+//! Every half second, the main thread simulates a frame which takes this long (milliseconds)
+static const int FRAME_HITCH = 300;
+
+static qint64 percentile(QVector<qint64> values, double p)
+{
+	if (values.isEmpty())
+		return 0;
+	std::sort(values.begin(), values.end());
+	return values.at(qMin(values.size()-1, static_cast<int>(p*values.size())));
+}
+
+static unsigned int raToInt(double ra)
+{
+	return static_cast<unsigned int>(std::floor(0.5 + ra*((static_cast<unsigned int>(0x80000000))/M_PI)));
+}
+
+static qint64 readInt(const QByteArray& data, int offset, int size)
+{
+	quint64 value = 0;
+	for (int i=size-1; i>=0; --i)
+		value = (value << 8) | static_cast<unsigned char>(data.at(offset+i));
+	return static_cast<qint64>(value);
+}
+
+static void writeInt(char* p, quint64 value, int size)
+{
+	for (int i=0; i<size; ++i)
+	{
+		p[i] = static_cast<char>(value & 0xFF);
+		value >>= 8;
+	}
+}
+
+QVector<MockGoto> MockTCPTelescope::getGotos() const
+{
+	QMutexLocker locker(&mutex);
+	return gotos;
+}
+
+int MockTCPTelescope::listen()
+{
+	server = new QTcpServer(this);
+	connect(server, SIGNAL(newConnection()), this, SLOT(acceptConnection()));
+	if (!server->listen(QHostAddress::LocalHost, 0))
+		return 0;
+	return server->serverPort();
+}
+
+void MockTCPTelescope::close()
+{
+	delete timer;
+	timer = Q_NULLPTR;
+	delete socket;
+	socket = Q_NULLPTR;
+	delete server;
+	server = Q_NULLPTR;
+}
+
+void MockTCPTelescope::acceptConnection()
+{
+	QTcpSocket* connection = server->nextPendingConnection();
+	if (socket)
+	{
+		// only one client
+		connection->abort();
+		connection->deleteLater();
+		return;
+	}
+	socket = connection;
+	socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+	connect(socket, SIGNAL(readyRead()), this, SLOT(readCommands()));
+
+	timer = new QTimer(this);
+	timer->setTimerType(Qt::PreciseTimer);
+	connect(timer, SIGNAL(timeout()), this, SLOT(sendPosition()));
+	timer->start(interval);
+}
+
+void MockTCPTelescope::sendPosition()
+{
+	char packet[24];
+	writeInt(packet, 24, 2);
+	writeInt(packet+2, 0, 2);
+	writeInt(packet+4, static_cast<quint64>(getNow()), 8);
+	writeInt(packet+12, getRa(counter++), 4);
+	writeInt(packet+16, 0, 4);
+	writeInt(packet+20, 0, 4);
+	socket->write(packet, sizeof(packet));
+}
+
+void MockTCPTelescope::readCommands()
+{
+	const qint64 now = getNow();
+	readBuffer += socket->readAll();
+	while (readBuffer.size() >= 4)
+	{
+		const int size = static_cast<int>(readInt(readBuffer, 0, 2));
+		if (size < 4 || size > readBuffer.size())
+			break;
+		if (readInt(readBuffer, 2, 2) == 0 && size >= 20)
+		{
+			MockGoto received;
+			received.micros = now;
+			received.ra = readInt(readBuffer, 12, 4);
+			QMutexLocker locker(&mutex);
+			gotos.append(received);
+		}
+		readBuffer.remove(0, size);
+	}
+}
+
+MockLx200Telescope::~MockLx200Telescope()
+{
+	close();
+}
+
+QVector<qint64> MockLx200Telescope::getPositionTimes() const
+{
+	QMutexLocker locker(&mutex);
+	return positionTimes;
+}
+
+QVector<MockGoto> MockLx200Telescope::getGotos() const
+{
+	QMutexLocker locker(&mutex);
+	return gotos;
+}
+
+QString MockLx200Telescope::open()
+{
+#ifdef Q_OS_UNIX
+	fd = posix_openpt(O_RDWR | O_NOCTTY);
+	if (fd < 0)
+		return QString();
+	const char* name = Q_NULLPTR;
+	if (grantpt(fd) == 0 && unlockpt(fd) == 0)
+		name = ptsname(fd);
+	if (!name || fcntl(fd, F_SETFL, O_NONBLOCK) < 0)
+	{
+		::close(fd);
+		fd = -1;
+		return QString();
+	}
+	notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+	connect(notifier, SIGNAL(activated(int)), this, SLOT(readCommands()));
+	return QString(name);
+#else
+	return QString();
+#endif
+}
+
+void MockLx200Telescope::close()
+{
+	delete notifier;
+	notifier = Q_NULLPTR;
+#ifdef Q_OS_UNIX
+	if (fd >= 0)
+		::close(fd);
+#endif
+	fd = -1;
+}
+
+void MockLx200Telescope::readCommands()
+{
+#ifdef Q_OS_UNIX
+	char buffer[256];
+	const ssize_t count = ::read(fd, buffer, sizeof(buffer));
+	if (count <= 0)
+	{
+		// EIO once the client has closed the slave device
+		if (count == 0 || errno != EAGAIN)
+			notifier->setEnabled(false);
+		return;
+	}
+	readBuffer.append(buffer, static_cast<int>(count));
+	int end;
+	while ((end = readBuffer.indexOf('#')) >= 0)
+	{
+		const QByteArray command = readBuffer.left(end);
+		readBuffer.remove(0, end+1);
+		if (!command.isEmpty())
+			answer(command);
+	}
+#endif
+}
+
+void MockLx200Telescope::write(const QByteArray &data)
+{
+#ifdef Q_OS_UNIX
+	if (::write(fd, data.constData(), static_cast<size_t>(data.size())) != data.size())
+		qWarning() << "MockLx200Telescope: write failed";
+#else
+	Q_UNUSED(data)
+#endif
+}
+
+void MockLx200Telescope::answer(const QByteArray &command)
+{
+	// Only the long format is implemented: HH:MM:SS and sDD*MM:SS
+	if (command == ":GR")
+	{
+		write(QString::asprintf("%02d:%02d:%02d#", ra/3600, (ra/60)%60, ra%60).toLatin1());
+	}
+	else if (command == ":GD")
+	{
+		const int d = qAbs(dec);
+		write(QString::asprintf("%c%02d*%02d:%02d#", dec<0 ? '-' : '+', d/3600, (d/60)%60, d%60).toLatin1());
+		QMutexLocker locker(&mutex);
+		positionTimes.append(getNow());
+	}
+	else if (command.startsWith(":Sr") && command.size() == 11)
+	{
+		selectedRa = command.mid(3, 2).toInt()*3600 + command.mid(6, 2).toInt()*60 + command.mid(9, 2).toInt();
+		write("1");
+	}
+	else if (command.startsWith(":Sd") && command.size() == 12)
+	{
+		selectedDec = command.mid(4, 2).toInt()*3600 + command.mid(7, 2).toInt()*60 + command.mid(10, 2).toInt();
+		if (command.at(3) == '-')
+			selectedDec = -selectedDec;
+		write("1");
+	}
+	else if (command == ":MS")
+	{
+		MockGoto received;
+		received.micros = getNow();
+		received.ra = selectedRa;
+		ra = selectedRa;
+		dec = selectedDec;
+		write("0");
+		QMutexLocker locker(&mutex);
+		gotos.append(received);
+	}
+	// :Q (stop slew) and :U (toggle format) have no answer
+}
+
+void RingProducer::run()
+{
+	for (int i=0; i<count; ++i)
+	{
+		while (!ring.push(i))
+			QThread::yieldCurrentThread();
+	}
+}
+
+void TestTelescopeIO::testSpscRing()
+{
+	SpscRing<int, 4> ring;
+	int value = -1;
+	QVERIFY(ring.isEmpty());
+	QVERIFY(!ring.pop(value));
+	for (int i=0; i<4; ++i)
+		QVERIFY(ring.push(i));
+	QVERIFY(!ring.push(4));
+	QVERIFY(ring.pop(value));
+	QCOMPARE(value, 0);
+	// wraps around
+	QVERIFY(ring.push(4));
+	for (int i=1; i<=4; ++i)
+	{
+		QVERIFY(ring.pop(value));
+		QCOMPARE(value, i);
+	}
+	QVERIFY(ring.isEmpty());
+	QVERIFY(!ring.pop(value));
+}
+
+void TestTelescopeIO::testSpscRingThreads()
+{
+	const int count = 1000000;
+	SpscRing<int, 64> ring;
+	RingProducer producer(ring, count);
+	producer.start();
+	int expected = 0;
+	bool ordered = true;
+	while (expected < count)
+	{
+		int value;
+		if (ring.pop(value))
+		{
+			ordered = ordered && (value == expected);
+			++expected;
+		}
+		else
+			QThread::yieldCurrentThread();
+	}
+	QVERIFY(producer.wait(10000));
+	QVERIFY(ordered);
+	QVERIFY(ring.isEmpty());
+}
+
+void TestTelescopeIO::testTCPLatency()
+{
+	QThread mockThread;
+	MockTCPTelescope mock(POSITION_INTERVAL);
+	mock.moveToThread(&mockThread);
+	mockThread.start();
+	int port = 0;
+	QMetaObject::invokeMethod(&mock, "listen", Qt::BlockingQueuedConnection, Q_RETURN_ARG(int, port));
+	QVERIFY(port > 0);
+
+	TelescopeIOThread ioThread;
+	QScopedPointer<TelescopeClient> telescope(TelescopeClient::create(QString("Mock:TCP:J2000:127.0.0.1:%1:100000").arg(port)));
+	QVERIFY(telescope);
+	TelescopeIOChannel* channel = telescope->getIOChannel();
+	QVERIFY(channel);
+	ioThread.addChannel(channel);
+	QTRY_VERIFY_WITH_TIMEOUT(telescope->isConnected(), 5000);
+
+	// The main thread takes the positions like TelescopeControl in each frame, but with a long frame every half second.
+	// The receive times must not depend on the frames.
+	QVector<qint64> latencies;
+	QVector<qint64> jitters;
+	QVector<qint64> gotoQueueTimes;
+	QVector<unsigned int> gotoRa;
+	qint64 lastServerMicros = 0;
+	qint64 lastClientMicros = 0;
+	int received = 0;
+	bool ordered = true;
+	QElapsedTimer elapsed;
+	elapsed.start();
+	qint64 nextHitch = 500;
+	while (received < NB_POSITIONS && elapsed.elapsed() < 20000)
+	{
+		TelescopePositionSample sample;
+		while (received < NB_POSITIONS && channel->takeSample(sample))
+		{
+			QVERIFY(!sample.reset);
+			if (received > 0)
+			{
+				ordered = ordered && (sample.server_micros > lastServerMicros);
+				// the difference between the intervals of sending and receiving
+				jitters.append(qAbs((sample.client_micros - lastClientMicros) - (sample.server_micros - lastServerMicros)));
+			}
+			latencies.append(sample.client_micros - sample.server_micros);
+			lastServerMicros = sample.server_micros;
+			lastClientMicros = sample.client_micros;
+			++received;
+		}
+
+		if (elapsed.elapsed() >= nextHitch)
+		{
+			// the goto must be sent during the long frame
+			const double ra = 0.1 + 0.2*gotoQueueTimes.size();
+			gotoQueueTimes.append(getNow());
+			gotoRa.append(raToInt(ra));
+			telescope->telescopeGoto(Vec3d(std::cos(ra), std::sin(ra), 0.), StelObjectP());
+			QThread::msleep(FRAME_HITCH);
+			nextHitch += 500;
+		}
+		else
+			QThread::msleep(16);
+	}
+
+	const qint64 median = percentile(latencies, 0.5);
+	const qint64 p99 = percentile(latencies, 0.99);
+	const qint64 maximum = percentile(latencies, 1.);
+	const qint64 jitter = percentile(jitters, 0.99);
+	QCOMPARE(received, NB_POSITIONS);
+	QVERIFY(ordered);
+	QCOMPARE(channel->getDroppedSamples(), 0);
+	QVERIFY(percentile(latencies, 0.) >= 0);
+	QVERIFY2(median < 20000, qPrintable(QString("positions are received too late, median latency %1 us").arg(median)));
+	QVERIFY2(p99 < FRAME_HITCH*1000/4, qPrintable(QString("positions are received too late, 99th percentile %1 us").arg(p99)));
+	QVERIFY2(maximum < FRAME_HITCH*1000/2, qPrintable(QString("the receive times depend on the frames of the main thread, maximum latency %1 us").arg(maximum)));
+	QVERIFY2(jitter < 20000, qPrintable(QString("positions are received at irregular intervals, jitter %1 us").arg(jitter)));
+
+	QTRY_COMPARE_WITH_TIMEOUT(mock.getGotos().size(), gotoQueueTimes.size(), 5000);
+	const QVector<MockGoto> gotos = mock.getGotos();
+	for (int i=0; i<gotos.size(); ++i)
+	{
+		const qint64 delay = gotos.at(i).micros - gotoQueueTimes.at(i);
+		QCOMPARE(gotos.at(i).ra, static_cast<qint64>(gotoRa.at(i)));
+		QVERIFY(delay >= 0);
+		QVERIFY2(delay < FRAME_HITCH*1000/2, qPrintable(QString("goto %1 waited for the frame of the main thread, received after %2 us").arg(i).arg(delay)));
+	}
+
+	// The telescope client takes the positions itself in each frame
+	QThread::msleep(5*POSITION_INTERVAL);
+	QVERIFY(telescope->prepareCommunication());
+	telescope->performCommunication();
+	QVERIFY(telescope->hasKnownPosition());
+	QVERIFY(std::fabs(telescope->getJ2000EquatorialPos(Q_NULLPTR).length() - 1.) < 1e-9);
+
+	telescope.reset();
+	QMetaObject::invokeMethod(&mock, "close", Qt::BlockingQueuedConnection);
+	mockThread.quit();
+	mockThread.wait();
+}
+
+void TestTelescopeIO::testLx200Latency()
+{
+#ifndef Q_OS_UNIX
+	QSKIP("The mock LX200 needs pseudo terminals");
+#else
+	// The telescope servers write to the log of their thread, see TelescopeIOChannel
+	QString log;
+	QTextStream logStream(&log);
+	log_file = &logStream;
+
+	QThread mockThread;
+	MockLx200Telescope mock;
+	mock.moveToThread(&mockThread);
+	mockThread.start();
+	QString device;
+	QMetaObject::invokeMethod(&mock, "open", Qt::BlockingQueuedConnection, Q_RETURN_ARG(QString, device));
+	if (device.isEmpty())
+	{
+		mockThread.quit();
+		mockThread.wait();
+		log_file = Q_NULLPTR;
+		QSKIP("Pseudo terminals are not available");
+	}
+
+	TelescopeIOThread ioThread;
+	QScopedPointer<TelescopeClient> telescope(TelescopeClient::create(QString("Mock:TelescopeServerLx200:J2000:%1:100000").arg(device)));
+	QVERIFY(telescope);
+	TelescopeIOChannel* channel = telescope->getIOChannel();
+	QVERIFY(channel);
+	QVERIFY(telescope->isConnected());
+	ioThread.addChannel(channel);
+
+	// TelescopeClientDirectLx200 asks for the position every half second
+	const int nbPositions = 5;
+	QVector<qint64> receiveTimes;
+	QVector<unsigned int> receivedRa;
+	qint64 gotoQueueTime = 0;
+	const double gotoRa = 1.5;
+	QElapsedTimer elapsed;
+	elapsed.start();
+	while (receiveTimes.size() < nbPositions && elapsed.elapsed() < 20000)
+	{
+		TelescopePositionSample sample;
+		while (channel->takeSample(sample))
+		{
+			QVERIFY(!sample.reset);
+			receiveTimes.append(sample.client_micros);
+			receivedRa.append(sample.ra_int);
+		}
+
+		if (gotoQueueTime == 0 && receiveTimes.size() == 1)
+		{
+			gotoQueueTime = getNow();
+			telescope->telescopeGoto(Vec3d(std::cos(gotoRa), std::sin(gotoRa), 0.), StelObjectP());
+			QThread::msleep(FRAME_HITCH);
+		}
+		else
+			QThread::msleep(16);
+	}
+	QCOMPARE(receiveTimes.size(), nbPositions);
+
+	const QVector<qint64> answerTimes = mock.getPositionTimes();
+	QVERIFY(answerTimes.size() >= nbPositions);
+	QVector<qint64> latencies;
+	for (int i=0; i<nbPositions; ++i)
+		latencies.append(receiveTimes.at(i) - answerTimes.at(i));
+	const qint64 median = percentile(latencies, 0.5);
+	const qint64 maximum = percentile(latencies, 1.);
+	QVERIFY(percentile(latencies, 0.) >= 0);
+	QVERIFY2(median < 20000, qPrintable(QString("positions are received too late, median latency %1 us").arg(median)));
+	QVERIFY2(maximum < FRAME_HITCH*1000/2, qPrintable(QString("the receive times depend on the frames of the main thread, maximum latency %1 us").arg(maximum)));
+
+	const QVector<MockGoto> gotos = mock.getGotos();
+	QCOMPARE(gotos.size(), 1);
+	const qint64 delay = gotos.at(0).micros - gotoQueueTime;
+	QVERIFY(delay >= 0);
+	QVERIFY2(delay < FRAME_HITCH*1000/2, qPrintable(QString("the goto command waited for the frame of the main thread, received after %1 us").arg(delay)));
+	QVERIFY(qAbs(gotos.at(0).ra - qRound(gotoRa*43200./M_PI)) <= 1);
+	// The mount has moved
+	QVERIFY(receivedRa.last() != receivedRa.first());
+
+	telescope.reset();
+	QMetaObject::invokeMethod(&mock, "close", Qt::BlockingQueuedConnection);
+	mockThread.quit();
+	mockThread.wait();
+	log_file = Q_NULLPTR;
+#endif
+}
@@ -0,0 +1,131 @@
+/*
+ * Stellarium Telescope Control Plug-in
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef TESTTELESCOPEIO_HPP
+#define TESTTELESCOPEIO_HPP
+
+#include <QtTest>
+#include <QMutex>
+#include <QSocketNotifier>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+
+#include "common/SpscRing.hpp"
+
+//! A goto command as it was received by a mock telescope
+struct MockGoto
+{
+	//! The time when it was received, in microseconds since the Epoch
+	qint64 micros;
+	//! Right ascension in the units of the Stellarium telescope control protocol, or in seconds for the LX200
+	qint64 ra;
+};
+
+//! A telescope server which sends its position at a fixed rate with the Stellarium telescope control protocol,
+//! and records the goto commands it receives. It should live in its own thread.
+class MockTCPTelescope : public QObject
+{
+	Q_OBJECT
+public:
+	//! @param interval milliseconds between the positions
+	MockTCPTelescope(int interval) : interval(interval), server(Q_NULLPTR), socket(Q_NULLPTR), timer(Q_NULLPTR), counter(0) {}
+	QVector<MockGoto> getGotos() const;
+	static unsigned int getRa(int counter) { return static_cast<unsigned int>(counter) * 0x01000000u; }
+
+public slots:
+	//! @return the port of the server, or 0 on error
+	int listen();
+	void close();
+
+private slots:
+	void acceptConnection();
+	void sendPosition();
+	void readCommands();
+
+private:
+	int interval;
+	QTcpServer* server;
+	QTcpSocket* socket;
+	QTimer* timer;
+	int counter;
+	QByteArray readBuffer;
+	mutable QMutex mutex;
+	QVector<MockGoto> gotos;
+};
+
+//! A Meade LX200 on the master side of a pseudo terminal, answering the commands of TelescopeClientDirectLx200.
+//! It records the times of its answers to the declination queries and the goto commands it receives.
+//! It should live in its own thread.
+class MockLx200Telescope : public QObject
+{
+	Q_OBJECT
+public:
+	MockLx200Telescope() : fd(-1), notifier(Q_NULLPTR), ra(5*3600), dec(20*3600), selectedRa(0), selectedDec(0) {}
+	~MockLx200Telescope();
+	QVector<qint64> getPositionTimes() const;
+	QVector<MockGoto> getGotos() const;
+
+public slots:
+	//! @return the name of the slave device, or an empty string if pseudo terminals are not available
+	QString open();
+	void close();
+
+private slots:
+	void readCommands();
+
+private:
+	void answer(const QByteArray& command);
+	void write(const QByteArray& data);
+
+	int fd;
+	QSocketNotifier* notifier;
+	QByteArray readBuffer;
+	//! The position of the mount and the target of a goto, in seconds of time and of arc
+	int ra, dec, selectedRa, selectedDec;
+	mutable QMutex mutex;
+	QVector<qint64> positionTimes;
+	QVector<MockGoto> gotos;
+};
+
+//! Pushes a sequence of numbers in a SpscRing, spinning while it is full.
+class RingProducer : public QThread
+{
+public:
+	RingProducer(SpscRing<int, 64>& ring, int count) : ring(ring), count(count) {}
+protected:
+	void run();
+private:
+	SpscRing<int, 64>& ring;
+	int count;
+};
+
+class TestTelescopeIO : public QObject
+{
+Q_OBJECT
+private slots:
+	void testSpscRing();
+	void testSpscRingThreads();
+	void testTCPLatency();
+	void testLx200Latency();
+};
+
+#endif // TESTTELESCOPEIO_HPP
@@ -81,6 +81,12 @@ void CLIProcessor::parseCLIArgsPreConfig(const QStringList& argList)
 		          << "--restore-defaults      : Delete existing config.ini and use defaults\n"
 		          << "--multires-image        : With filename / URL argument, specify a\n"
 			  << "                          multi-resolution image to load\n"
+			  << "--export-ephemeris      : Write an ephemeris to the given file and quit.\n"
+			  << "                          CSV for *.csv, a binary columnar file otherwise\n"
+			  << "--ephemeris-objects     : Comma separated English names, e.g. Mars,Jupiter\n"
+			  << "--ephemeris-start       : First date of the ephemeris in format yyyymmdd (UTC)\n"
+			  << "--ephemeris-stop        : Last date of the ephemeris in format yyyymmdd (UTC)\n"
+			  << "--ephemeris-step        : Time step of the ephemeris in minutes (default 60)\n"
 #ifdef Q_OS_WIN
 			  << "--angle-mode (or -a)    : Use ANGLE as OpenGL ES2 rendering engine (autodetect driver)\n"
 			  << "--angle-d3d9 (or -9)    : Force use Direct3D 9 for ANGLE OpenGL ES2 rendering engine\n"
@@ -167,6 +173,8 @@ void CLIProcessor::parseCLIArgsPostConfig(const QStringList& argList, QSettings*
 	float fov;
 	QString landscapeId, homePlanet, longitude, latitude, skyDate, skyTime;
 	QString projectionType, screenshotDir, multiresImage, startupScript;
+	QString ephemerisFile, ephemerisObjects, ephemerisStart, ephemerisStop;
+	double ephemerisStep;
 #ifdef ENABLE_SPOUT
 	QString spoutStr, spoutName;
 #endif
@@ -187,6 +195,11 @@ void CLIProcessor::parseCLIArgsPostConfig(const QStringList& argList, QSettings*
 		screenshotDir = argsGetOptionWithArg(argList, "", "--screenshot-dir", "").toString();
 		multiresImage = argsGetOptionWithArg(argList, "", "--multires-image", "").toString();
 		startupScript = argsGetOptionWithArg(argList, "", "--startup-script", "").toString();
+		ephemerisFile = argsGetOptionWithArg(argList, "", "--export-ephemeris", "").toString();
+		ephemerisObjects = argsGetOptionWithArg(argList, "", "--ephemeris-objects", "").toString();
+		ephemerisStart = argsGetOptionWithArg(argList, "", "--ephemeris-start", "").toString();
+		ephemerisStop = argsGetOptionWithArg(argList, "", "--ephemeris-stop", "").toString();
+		ephemerisStep = argsGetOptionWithArg(argList, "", "--ephemeris-step", 60.).toDouble();
 #ifdef ENABLE_SPOUT
 		// For now, we default to spout=sky when no extra option is given. Later, we should also accept "all".
 		// Unfortunately, this still throws an exception when no optarg string is given.
@@ -260,6 +273,30 @@ void CLIProcessor::parseCLIArgsPostConfig(const QStringList& argList, QSettings*
 		qApp->setProperty("onetime_startup_script", startupScript);
 	}
 
+	if (!ephemerisFile.isEmpty())
+	{
+		// The dates are taken at 0h UTC, the stop date is included.
+		QRegExp dateRx("\\d{8}");
+		const QDate today = QDate::currentDate();
+		QDate startDate = today, stopDate = today;
+		if (dateRx.exactMatch(ephemerisStart.remove("-")))
+			startDate = QDate::fromString(ephemerisStart, "yyyyMMdd");
+		else if (!ephemerisStart.isEmpty())
+			qWarning() << "WARNING: --ephemeris-start argument has unrecognised format  (I want yyyymmdd)";
+		if (dateRx.exactMatch(ephemerisStop.remove("-")))
+			stopDate = QDate::fromString(ephemerisStop, "yyyyMMdd");
+		else if (!ephemerisStop.isEmpty())
+			qWarning() << "WARNING: --ephemeris-stop argument has unrecognised format  (I want yyyymmdd)";
+
+		QVariantMap ephemeris;
+		ephemeris.insert("file", QDir::fromNativeSeparators(ephemerisFile));
+		ephemeris.insert("objects", ephemerisObjects.split(',', QString::SkipEmptyParts));
+		ephemeris.insert("startJD", startDate.toJulianDay() - 0.5);
+		ephemeris.insert("stopJD", stopDate.toJulianDay() + 0.5);
+		ephemeris.insert("step", ephemerisStep > 0. ? ephemerisStep : 60.);
+		qApp->setProperty("onetime_ephemeris_export", ephemeris);
+	}
+
 	if (fov>0.0f) confSettings->setValue("navigation/init_fov", fov);
 	if (!projectionType.isEmpty()) confSettings->setValue("projection/type", projectionType);
 	if (!screenshotDir.isEmpty())
@@ -110,6 +110,15 @@ void Refraction::setPostTransfoMat(const Mat4d& m)
 				  static_cast<float>(invertPostTransfoMat[12]), static_cast<float>(invertPostTransfoMat[13]), static_cast<float>(invertPostTransfoMat[14]), static_cast<float>(invertPostTransfoMat[15]));
 }
 
+void Refraction::getShadersParams(Mat4d& pre, Mat4d& post, float& pressTempCorr, float& minGeoAltitudeDeg, float& transitionWidthDeg) const
+{
+	pre=preTransfoMat;
+	post=postTransfoMat;
+	pressTempCorr=press_temp_corr;
+	minGeoAltitudeDeg=MIN_GEO_ALTITUDE_DEG;
+	transitionWidthDeg=TRANSITION_WIDTH_GEO_DEG;
+}
+
 void Refraction::updatePrecomputed()
 {
 	press_temp_corr=pressure/1010.f * 283.f/(273.f+temperature) / 60.f;
@@ -165,6 +165,13 @@ public:
 	void setPreTransfoMat(const Mat4d& m);
 	void setPostTransfoMat(const Mat4d& m);
 
+	//! Get the parameters needed to compute the forward refraction in a shader.
+	//! @param pre, post the transformations applied before and after the refraction of the altitude.
+	//! @param pressTempCorr the pressure and temperature correction factor of the refraction.
+	//! @param minGeoAltitudeDeg, transitionWidthDeg the geometric altitude below which the refraction is faded out,
+	//! and the width of the transition zone in which it is.
+	void getShadersParams(Mat4d& pre, Mat4d& post, float& pressTempCorr, float& minGeoAltitudeDeg, float& transitionWidthDeg) const;
+
 private:
 	//! Update precomputed variables.
 	void updatePrecomputed();
@@ -205,6 +205,7 @@ StelAction* StelActionMgr::addAction(const QString& id, const QString& groupId,
 	StelAction* action = new StelAction(id, groupId, text, shortcut, altShortcut, global);
 	connect(action,SIGNAL(toggled(bool)),this,SLOT(onStelActionToggled(bool)));
 	action->connectToObject(target, slot);
+	emit actionAdded(action);
 	return action;
 }
 
@@ -216,6 +217,7 @@ StelAction* StelActionMgr::addAction(const QString& id, const QString& groupId,
 {
 	StelAction* action = new StelAction(id, groupId, text, shortcut, altShortcut, global);
 	connect(action, &StelAction::triggered, context, lambda);
+	emit actionAdded(action);
 	return action;
 }
 
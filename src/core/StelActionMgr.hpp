@@ -199,6 +199,8 @@ signals:
 	//! @param id The id of the action that was toggled
 	//! @param value The new value of the action
 	void actionToggled(const QString& id, bool value);
+	//! Emitted when a new action was registered with addAction()
+	void actionAdded(StelAction* action);
 
 	void shortcutsChanged();
 
@@ -49,6 +49,8 @@
 #include "StelPropertyMgr.hpp"
 #include "StelProgressController.hpp"
 #include "StelModuleMgr.hpp"
+#include "StelModuleLoader.hpp"
+#include "StelProfiler.hpp"
 #include "StelLocaleMgr.hpp"
 #include "StelSkyCultureMgr.hpp"
 #include "StelFileMgr.hpp"
@@ -250,6 +252,7 @@ StelApp::StelApp(StelMainView *parent)
 	, renderBuffer(Q_NULLPTR)
 	, viewportEffect(Q_NULLPTR)
 	, gl(Q_NULLPTR)
+	, profiler(Q_NULLPTR)
 	, flagShowDecimalDegrees(false)
 	, flagUseAzimuthFromSouth(false)
 	, flagUseFormattingOutput(false)
@@ -269,6 +272,7 @@ StelApp::StelApp(StelMainView *parent)
 	singleton = this;
 
 	moduleMgr = new StelModuleMgr();
+	profiler = new StelProfiler(this);
 
 	wheelEventTimer = new QTimer(this);
 	wheelEventTimer->setInterval(25);
@@ -463,71 +467,80 @@ void StelApp::init(QSettings* conf)
 	// register non-modules for StelProperty tracking
 	propMgr->registerObject(this);
 	propMgr->registerObject(mainWin);
+	propMgr->registerObject(profiler);
+
+	// The data of some modules, e.g. the star and DSO catalogs, is loaded on the thread pool while the other
+	// modules are initialized. All modules are still initialized on the main thread in the order below.
+	StelModuleLoader loader(confSettings->value("main/flag_parallel_module_loading", true).toBool());
 
 	// Stel Object Data Base manager
 	SplashScreen::showMessage(q_("Initializing Object Database..."));
 	stelObjectMgr = new StelObjectMgr();
-	stelObjectMgr->init();
+	loader.initModule(stelObjectMgr);
 	getModuleMgr().registerModule(stelObjectMgr);	
 
+	// The object modules need the object manager in their constructor
+	StarMgr* hip_stars = new StarMgr();
+	loader.startLoading(hip_stars);
+	NebulaMgr* nebulas = new NebulaMgr();
+	loader.startLoading(nebulas);
+
 	SplashScreen::showMessage(q_("Initializing locales..."));
 	localeMgr->init();
 
 	// Hips surveys
 	SplashScreen::showMessage(q_("Initializing HiPS survey..."));
 	HipsMgr* hipsMgr = new HipsMgr();
-	hipsMgr->init();
+	loader.initModule(hipsMgr);
 	getModuleMgr().registerModule(hipsMgr);
 
 	// Init the solar system first
 	SplashScreen::showMessage(q_("Initializing Solar System objects..."));
 	SolarSystem* ssystem = new SolarSystem();
-	ssystem->init();
+	loader.initModule(ssystem);
 	getModuleMgr().registerModule(ssystem);
 
 	// Init the nomenclature for Solar system bodies
 	SplashScreen::showMessage(q_("Initializing planetary nomenclature..."));
 	NomenclatureMgr* nomenclature = new NomenclatureMgr();
-	nomenclature->init();
+	loader.initModule(nomenclature);
 	getModuleMgr().registerModule(nomenclature);
 
 	// Load stars & their names
 	SplashScreen::showMessage(q_("Initializing stars..."));
-	StarMgr* hip_stars = new StarMgr();
-	hip_stars->init();
+	loader.initModule(hip_stars);
 	getModuleMgr().registerModule(hip_stars);
 
 	SplashScreen::showMessage(q_("Initializing core..."));
-	core->init();
+	loader.runStep("StelCore", [this]() { core->init(); });
 
 	// Init nebulas
 	SplashScreen::showMessage(q_("Initializing deep-sky objects..."));
-	NebulaMgr* nebulas = new NebulaMgr();
-	nebulas->init();
+	loader.initModule(nebulas);
 	getModuleMgr().registerModule(nebulas);
 
 	// Init milky way
 	SplashScreen::showMessage(q_("Initializing Milky Way..."));
 	MilkyWay* milky_way = new MilkyWay();
-	milky_way->init();
+	loader.initModule(milky_way);
 	getModuleMgr().registerModule(milky_way);
 
 	// Init zodiacal light
 	SplashScreen::showMessage(q_("Initializing zodiacal light..."));
 	ZodiacalLight* zodiacal_light = new ZodiacalLight();
-	zodiacal_light->init();
+	loader.initModule(zodiacal_light);
 	getModuleMgr().registerModule(zodiacal_light);
 
 	// Init sky image manager
 	SplashScreen::showMessage(q_("Initializing sky image layer..."));
 	skyImageMgr = new StelSkyLayerMgr();
-	skyImageMgr->init();
+	loader.initModule(skyImageMgr);
 	getModuleMgr().registerModule(skyImageMgr);
 
 	// Toast surveys
 	SplashScreen::showMessage(q_("Initializing TOAST surveys..."));
 	ToastMgr* toasts = new ToastMgr();
-	toasts->init();
+	loader.initModule(toasts);
 	getModuleMgr().registerModule(toasts);
 
 	// Init audio manager
@@ -537,70 +550,76 @@ void StelApp::init(QSettings* conf)
 	// Init video manager
 	SplashScreen::showMessage(q_("Initializing video..."));
 	videoMgr = new StelVideoMgr();
-	videoMgr->init();
+	loader.initModule(videoMgr);
 	getModuleMgr().registerModule(videoMgr);
 
 	// Constellations
 	SplashScreen::showMessage(q_("Initializing constellations..."));
 	ConstellationMgr* constellations = new ConstellationMgr(hip_stars);
-	constellations->init();
+	loader.initModule(constellations);
 	getModuleMgr().registerModule(constellations);
 
 	// Asterisms
 	SplashScreen::showMessage(q_("Initializing asterisms..."));
 	AsterismMgr* asterisms = new AsterismMgr(hip_stars);
-	asterisms->init();
+	loader.initModule(asterisms);
 	getModuleMgr().registerModule(asterisms);
 
 	// Landscape, atmosphere & cardinal points section
 	SplashScreen::showMessage(q_("Initializing landscape..."));
 	LandscapeMgr* landscape = new LandscapeMgr();
-	landscape->init();
+	loader.initModule(landscape);
 	getModuleMgr().registerModule(landscape);
 
 	SplashScreen::showMessage(q_("Initializing grid lines..."));
 	GridLinesMgr* gridLines = new GridLinesMgr();
-	gridLines->init();
+	loader.initModule(gridLines);
 	getModuleMgr().registerModule(gridLines);
 	
 	SplashScreen::showMessage(q_("Initializing special markers..."));
 	SpecialMarkersMgr* specialMarkers = new SpecialMarkersMgr();
-	specialMarkers->init();
+	loader.initModule(specialMarkers);
 	getModuleMgr().registerModule(specialMarkers);
 
 	// Sporadic Meteors
 	SplashScreen::showMessage(q_("Initializing sporadic meteors..."));
 	SporadicMeteorMgr* meteors = new SporadicMeteorMgr(10, 72);
-	meteors->init();
+	loader.initModule(meteors);
 	getModuleMgr().registerModule(meteors);
 
 	// User labels
 	SplashScreen::showMessage(q_("Initializing user labels..."));
 	LabelMgr* skyLabels = new LabelMgr();
-	skyLabels->init();
+	loader.initModule(skyLabels);
 	getModuleMgr().registerModule(skyLabels);
 
 	SplashScreen::showMessage(q_("Initializing sky cultures..."));
-	skyCultureMgr->init();
+	loader.runStep("StelSkyCultureMgr", [this]() { skyCultureMgr->init(); });
 
 	// User markers
 	SplashScreen::showMessage(q_("Initializing user markers..."));
 	MarkerMgr* skyMarkers = new MarkerMgr();
-	skyMarkers->init();
+	loader.initModule(skyMarkers);
 	getModuleMgr().registerModule(skyMarkers);
 
 	// Init custom objects
 	SplashScreen::showMessage(q_("Initializing custom objects..."));
 	CustomObjectMgr* custObj = new CustomObjectMgr();
-	custObj->init();
+	loader.initModule(custObj);
 	getModuleMgr().registerModule(custObj);
 
 	// Init hightlights
 	SplashScreen::showMessage(q_("Initializing highlights..."));
 	HighlightMgr* hlMgr = new HighlightMgr();
-	hlMgr->init();
+	loader.initModule(hlMgr);
 	getModuleMgr().registerModule(hlMgr);
 
+	if (qApp->property("verbose").toBool())
+	{
+		qDebug() << "Initialization of the modules:";
+		loader.logTimings();
+	}
+
 	//Create the script manager here, maybe some modules/plugins may want to connect to it
 	//It has to be initialized later after all modules have been loaded by calling initScriptMgr
 #ifndef DISABLE_SCRIPTING
@@ -633,6 +652,10 @@ void StelApp::init(QSettings* conf)
 
 	// Animation
 	animationScale = confSettings->value("gui/pointer_animation_speed", 1.).toDouble();
+
+	profiler->setFlagGpuTimers(confSettings->value("devel/flag_profiler_gpu_timers", false).toBool());
+	profiler->setFlagEnabled(confSettings->value("devel/flag_profiler", false).toBool());
+	profiler->setFlagOverlay(confSettings->value("devel/flag_profiler_overlay", false).toBool());
 	
 #ifdef ENABLE_SPOUT
 	//qDebug() << "Property spout is" << qApp->property("spout").toString();
@@ -672,9 +695,29 @@ void StelApp::init(QSettings* conf)
 	}
 #endif
 
+	// A batch ephemeris requested on the command line is written once the main loop runs.
+	if (qApp->property("onetime_ephemeris_export").isValid())
+		QTimer::singleShot(0, this, SLOT(exportEphemerisAndQuit()));
+
 	initialized = true;
 }
 
+void StelApp::exportEphemerisAndQuit()
+{
+	const QVariantMap options = qApp->property("onetime_ephemeris_export").toMap();
+	const QString fileName = options.value("file").toString();
+	const QVariantMap result = GETSTELMODULE(SolarSystem)->exportEphemeris(fileName,
+									   options.value("objects").toStringList(),
+									   options.value("startJD").toDouble(),
+									   options.value("stopJD").toDouble(),
+									   options.value("step").toDouble());
+	if (result.contains("error"))
+		std::cerr << "ERROR: ephemeris export failed: " << qPrintable(result.value("error").toString()) << std::endl;
+	else
+		std::cout << result.value("rows").toLongLong() << " rows written to " << qPrintable(QDir::toNativeSeparators(fileName)) << std::endl;
+	quit();
+}
+
 // Load and initialize external modules (plugins)
 void StelApp::initPlugIns()
 {
@@ -745,6 +788,9 @@ void StelApp::update(double deltaTime)
 		frameTimeAccum=0.;
 	}
 		
+	profiler->beginFrame();
+	StelProfiler::Scope profileScope("StelApp::update");
+
 	core->update(deltaTime);
 
 	moduleMgr->update();
@@ -752,6 +798,7 @@ void StelApp::update(double deltaTime)
 	// Send the event to every StelModule
 	for (auto* i : moduleMgr->getCallOrders(StelModule::ActionUpdate))
 	{
+		StelProfiler::Scope moduleScope(i->objectName());
 		i->update(deltaTime);
 	}
 
@@ -792,20 +839,26 @@ void StelApp::draw()
 	prepareRenderBuffer();
 	currentFbo = renderBuffer ? renderBuffer->handle() : static_cast<GLuint>(drawFbo);
 
-	core->preDraw();
-
-	const QList<StelModule*> modules = moduleMgr->getCallOrders(StelModule::ActionDraw);
-	for (auto* module : modules)
 	{
-		module->draw(core);
+		StelProfiler::Scope profileScope("StelApp::draw", true);
+		core->preDraw();
+
+		const QList<StelModule*> modules = moduleMgr->getCallOrders(StelModule::ActionDraw);
+		for (auto* module : modules)
+		{
+			StelProfiler::Scope moduleScope(module->objectName(), true);
+			module->draw(core);
+		}
+		profiler->drawOverlay(core);
+		core->postDraw();
 	}
-	core->postDraw();
 #ifdef ENABLE_SPOUT
 	// At this point, the sky scene has been drawn, but no GUI panels.
 	if(spoutSender)
 		spoutSender->captureAndSendFrame(static_cast<GLuint>(drawFbo));
 #endif
 	applyRenderBuffer(static_cast<GLuint>(drawFbo));
+	profiler->endFrame();
 }
 
 /*************************************************************************
@@ -50,6 +50,7 @@ class StelScriptMgr;
 class StelActionMgr;
 class StelPropertyMgr;
 class StelProgressController;
+class StelProfiler;
 
 #ifdef 	ENABLE_SPOUT
 class SpoutSender;
@@ -85,6 +86,7 @@ class StelApp : public QObject
 public:
 	friend class StelAppGraphicsWidget;
 	friend class StelRootItem;
+	friend class TestStarBatch;
 
 	//! Create and initialize the main Stellarium application.
 	//! @param parent the QObject parent
@@ -156,6 +158,9 @@ public:
 	//! Return the property manager
 	StelPropertyMgr* getStelPropertyManager() const {return propMgr;}
 
+	//! Get the frame profiler
+	StelProfiler* getProfiler() const {return profiler;}
+
 	//! Get the video manager
 	StelVideoMgr* getStelVideoMgr() const {return videoMgr;}
 
@@ -313,6 +318,11 @@ public slots:
 
 	//! do some cleanup and call QCoreApplication::exit(0)
 	void quit();
+
+private slots:
+	//! Write the ephemeris requested with --export-ephemeris on the command line and quit.
+	void exportEphemerisAndQuit();
+
 signals:
 	void visionNightModeChanged(bool);
 	void flagShowDecimalDegreesChanged(bool);
@@ -463,6 +473,9 @@ private:
 	QOpenGLFramebufferObject* renderBuffer;
 	StelViewportEffect* viewportEffect;
 	QOpenGLFunctions* gl;
+
+	// Frame profiler timing the update and draw of the modules
+	StelProfiler* profiler;
 	
 	bool flagShowDecimalDegrees;  // Format infotext with decimal degrees, not minutes/seconds
 	bool flagUseAzimuthFromSouth; // Display calculate azimuth from south towards west (as in some astronomical literature)
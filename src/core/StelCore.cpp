@@ -86,6 +86,9 @@ StelCore::StelCore()
 	, jdOfLastJDUpdate(0.)
 	, flagUseDST(true)
 	, flagUseCTZ(false)
+	, utcOffsetLongitude(0.f)
+	, utcOffsetDST(false)
+	, utcOffsetCTZ(false)
 	, deltaTCustomNDot(-26.0)
 	, deltaTCustomYear(1820.0)
 	, deltaTnDot(-26.0)
@@ -1216,121 +1219,74 @@ void StelCore::moveObserverTo(const StelLocation& target, double duration, doubl
 	emit locationChanged(getCurrentLocation());
 }
 
-double StelCore::getUTCOffset(const double JD) const
+void StelCore::updateUTCOffsetCache(const StelLocation& loc, const QString& tzName) const
 {
-	int year, month, day, hour, minute, second;
-	StelUtils::getDateFromJulianDay(JD, &year, &month, &day);
-	StelUtils::getTimeFromJulianDay(JD, &hour, &minute, &second);
-	// as analogous to second statement in getJDFromDate, nkerr
-	if ( year <= 0 )
-	{
-		year = year - 1;
-	}
-	//getTime/DateFromJulianDay returns UTC time, not local time
-	QDateTime universal(QDate(year, month, day), QTime(hour, minute, second), Qt::UTC);
-	if (!universal.isValid())
-	{
-		//qWarning() << "JD " << QString("%1").arg(JD) << " out of bounds of QT help with GMT shift, using current datetime";
-		// Assumes the GMT shift was always the same before year -4710
-		// NOTE: QDateTime has no year 0, and therefore likely different leap year rules.
-		// Under which circumstances do we get invalid universal?
-		universal = QDateTime(QDate(-4710, month, day), QTime(hour, minute, second), Qt::UTC);
-	}
+	if (tzName==utcOffsetTimeZone && loc.planetName==utcOffsetPlanet && loc.longitude==utcOffsetLongitude
+	    && flagUseDST==utcOffsetDST && flagUseCTZ==utcOffsetCTZ)
+		return;
+	utcOffsetTimeZone = tzName;
+	utcOffsetPlanet = loc.planetName;
+	utcOffsetLongitude = loc.longitude;
+	utcOffsetDST = flagUseDST;
+	utcOffsetCTZ = flagUseCTZ;
 
-#if defined(Q_OS_WIN)
-	if (abs(year)<3)
-	{
-		// Mitigate a QTBUG on Windows (GH #594).
-		// This bug causes offset to be MIN_INT in January to March, 1AD.
-		// We assume a constant offset in this remote history,
-		// so we construct yet another date to get a valid offset.
-		// Application of the named time zones is inappropriate in any case.
-		universal = QDateTime(QDate(3, month, day), QTime(hour, minute, second), Qt::UTC);
-	}
-#endif
-	StelLocation loc = getCurrentLocation();
-	QString tzName = getCurrentTimeZone();
 	QTimeZone tz(tzName.toUtf8());
 	if (!tz.isValid() && !QString("LMST LTST system_default").contains(tzName))
 	{
 		qWarning() << "Invalid timezone: " << tzName;
 	}
-
-	qint64 shiftInSeconds = 0;
-	if (tzName=="system_default" || (loc.planetName=="Earth" && !tz.isValid() && !QString("LMST LTST").contains(tzName)))
-	{
-		QDateTime local = universal.toLocalTime();
-		//Both timezones should be interpreted as UTC because secsTo() converts both
-		//times to UTC if their zones have different daylight saving time rules.
-		local.setTimeSpec(Qt::UTC);
-		shiftInSeconds = universal.secsTo(local);
-		if (abs(shiftInSeconds)>50000 || shiftInSeconds==INT_MIN)
-		{
-			qDebug() << "TZ system_default or invalid, At JD" << QString::number(JD, 'g', 11) << ", shift:" << shiftInSeconds;
-		}
-	}
-	else
-	{
-		// The first adoption of a standard time was on December 1, 1847 in Great Britain
-		if (tz.isValid() && loc.planetName=="Earth" && (JD>=StelCore::TZ_ERA_BEGINNING || getUseCustomTimeZone()))
-		{
-			if (getUseDST())
-				shiftInSeconds = tz.offsetFromUtc(universal);
-			else
-				shiftInSeconds = tz.standardTimeOffset(universal);
-			if (abs(shiftInSeconds)>500000 || shiftInSeconds==INT_MIN)
-			{
-				// Something very strange has happened. The Windows-only clause above already mitigated GH #594.
-				// Trigger this with a named custom TZ like Europe/Stockholm.
-				// Then try to wheel back some date in January-March from year 10 to 0. Instead of year 1, it jumps to 70,
-				// an offset of INT_MIN
-				qWarning() << "ERROR TRAPPED! --- Please submit a bug report with this logfile attached.";
-				qWarning() << "TZ" << tz << "valid, but at JD" << QString::number(JD, 'g', 11) << ", shift:" << shiftInSeconds;
-				qWarning() << "Universal reference date: " << universal.toString();
-			}
-		}
-		else
-		{
-			shiftInSeconds = qRound((loc.longitude/15.f)*3600.f); // Local Mean Solar Time
-		}
-		if (tzName=="LTST")
-			shiftInSeconds += getSolutionEquationOfTime(JD)*60;
-	}
+	// The first adoption of a standard time was on December 1, 1847 in Great Britain
+	const double tzBegin = getUseCustomTimeZone() ? -1e100 : StelCore::TZ_ERA_BEGINNING;
 	#ifdef Q_OS_WIN
 	// A dirty hack for report: https://github.com/Stellarium/stellarium/issues/686
 	// TODO: switch to IANA TZ on all operating systems
-	if (tzName=="Europe/Volgograd")
-		shiftInSeconds = 4*3600; // UTC+04:00
+	const bool volgogradHack = (tzName=="Europe/Volgograd");
+	#else
+	const bool volgogradHack = false;
 	#endif
 
 	// Extraterrestrial: Either use the configured Terrestrial timezone, or even a pseudo-LMST based on planet's rotation speed?
 	if (loc.planetName!="Earth")
 	{
-		if (tz.isValid() && (JD>=StelCore::TZ_ERA_BEGINNING || getUseCustomTimeZone()))
-		{
-			if (getUseDST())
-				shiftInSeconds = tz.offsetFromUtc(universal);
-			else
-				shiftInSeconds = tz.standardTimeOffset(universal);
-			if (shiftInSeconds==INT_MIN) // triggered error
-			{
-				// Something very strange has happened. The Windows-only clause above already mitigated GH #594.
-				// Trigger this with a named custom TZ like Europe/Stockholm.
-				// Then try to wheel back some date in January-March from year 10 to 0. Instead of year 1, it jumps to 70,
-				// an offset of INT_MIN
-				qWarning() << "ERROR TRAPPED! --- Please submit a bug report with this logfile attached.";
-				qWarning() << "TZ" << tz << "valid, but at JD" << QString::number(JD, 'g', 11) << ", shift:" << shiftInSeconds;
-				qWarning() << "Universal reference date: " << universal.toString();
-			}
-		}
+		// TODO: This should give "mean solar time" for any planet.
+		// Combine rotation and orbit, or (for moons) rotation and orbit of parent planet.
+		// LTST is even worse, needs equation of time for other planets.
+		if (tz.isValid())
+			utcOffsetCache.setTimeZone(tz, getUseDST(), tzBegin, 0); // For now, give UT before tzBegin
 		else
-		{
-			// TODO: This should give "mean solar time" for any planet.
-			// Combine rotation and orbit, or (for moons) rotation and orbit of parent planet.
-			// LTST is even worse, needs equation of time for other planets.
-			shiftInSeconds = 0; // For now, give UT
-		}
+			utcOffsetCache.setFixedOffset(0);
+	}
+	else if (volgogradHack)
+	{
+		utcOffsetCache.setFixedOffset(4*3600); // UTC+04:00
+	}
+	else if (tzName=="system_default" || (!tz.isValid() && !QString("LMST LTST").contains(tzName)))
+	{
+		// The system time zone always applies daylight saving time, like QDateTime::toLocalTime() does.
+		utcOffsetCache.setTimeZone(QTimeZone::systemTimeZone(), true);
+	}
+	else
+	{
+		const int lmst = qRound((loc.longitude/15.f)*3600.f); // Local Mean Solar Time
+		if (tz.isValid())
+			utcOffsetCache.setTimeZone(tz, getUseDST(), tzBegin, lmst);
+		else
+			utcOffsetCache.setFixedOffset(lmst);
+	}
+}
+
+double StelCore::getUTCOffset(const double JD) const
+{
+	const StelLocation& loc = getCurrentLocation();
+	const QString tzName = getCurrentTimeZone();
+	qint64 shiftInSeconds;
+	{
+		QMutexLocker locker(&utcOffsetMutex);
+		updateUTCOffsetCache(loc, tzName);
+		shiftInSeconds = utcOffsetCache.getOffset(JD);
 	}
+	if (tzName=="LTST" && loc.planetName=="Earth")
+		shiftInSeconds += getSolutionEquationOfTime(JD)*60;
 
 	return shiftInSeconds / 3600.0;
 }
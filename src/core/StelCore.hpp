@@ -26,6 +26,8 @@
 #include "StelLocation.hpp"
 #include "StelSkyDrawer.hpp"
 #include "StelPropertyMgr.hpp"
+#include "StelUTCOffsetCache.hpp"
+#include <QMutex>
 #include <QString>
 #include <QStringList>
 #include <QTime>
@@ -68,6 +70,8 @@ class StelCore : public QObject
 	Q_PROPERTY(bool flagUseDST READ getUseDST WRITE setUseDST NOTIFY flagUseDSTChanged)
 
 public:
+	friend class TestStarBatch;
+
 	//! @enum FrameType
 	//! Supported reference frame types
 	enum FrameType
@@ -298,6 +302,7 @@ public:
 	//! Get the information on the current location
 	const StelLocation& getCurrentLocation() const;
 	//! Get the UTC offset on the current location (in hours)
+	//! The offsets of the current time zone are cached, so that this is fast enough to be called for each row of long tables.
 	double getUTCOffset(const double JD) const;
 
 	QString getCurrentTimeZone() const;
@@ -844,6 +849,17 @@ private:
 	bool flagUseDST;
 	bool flagUseCTZ; // custom time zone
 
+	//! Set up utcOffsetCache for the current time zone and location, unless they did not change since the last call.
+	void updateUTCOffsetCache(const StelLocation& loc, const QString& tzName) const;
+	mutable StelUTCOffsetCache utcOffsetCache;
+	mutable QMutex utcOffsetMutex; // getUTCOffset() may be called from worker threads
+	// The settings for which utcOffsetCache was set up
+	mutable QString utcOffsetTimeZone;
+	mutable QString utcOffsetPlanet;
+	mutable float utcOffsetLongitude;
+	mutable bool utcOffsetDST;
+	mutable bool utcOffsetCTZ;
+
 	// Variables for equations of DeltaT
 	Vec3d deltaTCustomEquationCoeff;
 	double deltaTCustomNDot;
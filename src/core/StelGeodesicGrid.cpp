@@ -35,8 +35,11 @@ Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
 #include "StelGeodesicGrid.hpp"
 
 #include <QDebug>
+#include <QVarLengthArray>
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
+#include <functional>
 
 static const float icosahedron_G = 0.5f*(1.0f+std::sqrt(5.0f));
 static const float icosahedron_b = 1.0f/std::sqrt(1.0f+icosahedron_G*icosahedron_G);
@@ -450,6 +453,295 @@ end:
 	return;
 }
 
+// Bounding cap of a triangle. The radius is widened by about 1e-5 to cover the rounding errors
+// of the corners and edge centers of the sub triangles.
+static void getTriangleBoundingCap(const Vec3f &c0,const Vec3f &c1,const Vec3f &c2,
+                                   Vec3d &center,double &cosRadius,double &sinRadius)
+{
+	center = (c0+c1+c2).toVec3d();
+	center.normalize();
+	cosRadius = qMin(qMin(center*c0.toVec3d(),center*c1.toVec3d()),center*c2.toVec3d()) - 2e-5;
+	sinRadius = std::sqrt(qMax(0.,1.-cosRadius*cosRadius));
+}
+
+// Return 1 if the bounding cap of a triangle lies inside a SphericalCap,
+// -1 if it lies outside and 0 if the border of the SphericalCap crosses it.
+static int classifyTriangle(const SphericalCap &half_space,const Vec3d &center,
+                            double cosRadius,double sinRadius)
+{
+	const double cosDist = center*half_space.n;
+	const double sinDist = std::sqrt(qMax(0.,1.-cosDist*cosDist));
+	// cos(dist+radius) and cos(dist-radius), with a margin for the rounding errors of SphericalCap::contains()
+	if (cosDist > -cosRadius && cosDist*cosRadius-sinDist*sinRadius >= half_space.d+1e-6)
+		return 1;
+	if (cosDist < cosRadius && cosDist*cosRadius+sinDist*sinRadius <= half_space.d-1e-6)
+		return -1;
+	return 0;
+}
+
+// First iteration on the icosahedron base triangles
+void StelGeodesicGrid::updateZones(const QVector<SphericalCap>& convex,
+                                   const PreviousSearch& previous,
+                                   int **inside_list,int **border_list,
+                                   int maxSearchLevel) const
+{
+	Q_ASSERT(previous.convex.size()==convex.size() && previous.changed.size()==convex.size());
+	if (maxSearchLevel < 0) maxSearchLevel = 0;
+	else if (maxSearchLevel > maxLevel) maxSearchLevel = maxLevel;
+	const int n = convex.size();
+	QVarLengthArray<int,16> halfs_used(n);
+	for (int h=0;h<n;h++) {halfs_used[h] = h;}
+	QVarLengthArray<bool,192> corner_inside(12*n);
+	QVarLengthArray<bool,192> previous_corner_inside(12*n);
+	for (int h=0;h<n;h++)
+	{
+		const SphericalCap& half_space(convex.at(h));
+		for (int i=0;i<12;i++)
+		{
+			corner_inside[i*n+h] = half_space.contains(icosahedron_corners[i]);
+			previous_corner_inside[i*n+h] = previous.changed.at(h) ? previous.convex.at(h).contains(icosahedron_corners[i])
+			                                                       : corner_inside[i*n+h];
+		}
+	}
+	for (int i=0;i<20;i++)
+	{
+		const int *const corners = icosahedron_triangles[i].corners;
+		updateZones(0,i,
+		            icosahedron_corners[corners[0]],
+		            icosahedron_corners[corners[1]],
+		            icosahedron_corners[corners[2]],
+		            convex,previous,
+		            halfs_used.constData(),n,
+		            corner_inside.constData()+corners[0]*n,
+		            corner_inside.constData()+corners[1]*n,
+		            corner_inside.constData()+corners[2]*n,
+		            halfs_used.constData(),n,
+		            previous_corner_inside.constData()+corners[0]*n,
+		            previous_corner_inside.constData()+corners[1]*n,
+		            previous_corner_inside.constData()+corners[2]*n,
+		            inside_list,border_list,maxSearchLevel);
+	}
+}
+
+void StelGeodesicGrid::updateZones(int lev,int index,
+                                   const Vec3f &c0,
+                                   const Vec3f &c1,
+                                   const Vec3f &c2,
+                                   const QVector<SphericalCap>& convex,
+                                   const PreviousSearch& previous,
+                                   const int *indexOfUsedSphericalCaps,
+                                   const int halfSpacesUsed,
+                                   const bool *corner0_inside,
+                                   const bool *corner1_inside,
+                                   const bool *corner2_inside,
+                                   const int *previousIndexOfUsedSphericalCaps,
+                                   const int previousHalfSpacesUsed,
+                                   const bool *previous_corner0_inside,
+                                   const bool *previous_corner1_inside,
+                                   const bool *previous_corner2_inside,
+                                   int **inside_list,int **border_list,
+                                   const int maxSearchLevel) const
+{
+	QVarLengthArray<int,16> halfs_used(halfSpacesUsed);
+	int halfs_used_count = 0;
+	for (int h=0;h<halfSpacesUsed;h++)
+	{
+		const int i = indexOfUsedSphericalCaps[h];
+		if (!corner0_inside[i] && !corner1_inside[i] && !corner2_inside[i])
+		{
+			// totally outside this SphericalCap
+			return;
+		}
+		else if (corner0_inside[i] && corner1_inside[i] && corner2_inside[i])
+		{
+			// totally inside this SphericalCap
+		}
+		else
+		{
+			// on the border of this SphericalCap
+			halfs_used[halfs_used_count++] = i;
+		}
+	}
+	if (halfs_used_count == 0)
+	{
+		// this triangle(lev,index) lies inside all halfspaces
+		**inside_list = index;
+		(*inside_list)++;
+		return;
+	}
+
+	// The previous search found the same zones in this triangle if it used the same SphericalCaps
+	// for it and none of the changed ones crosses it.
+	bool unchanged = (halfSpacesUsed == previousHalfSpacesUsed &&
+	                  std::equal(indexOfUsedSphericalCaps,indexOfUsedSphericalCaps+halfSpacesUsed,
+	                             previousIndexOfUsedSphericalCaps));
+	for (int h=0;unchanged && h<halfs_used_count;h++)
+	{
+		unchanged = !previous.changed.at(halfs_used[h]);
+	}
+	if (unchanged)
+	{
+		Vec3d center;
+		double cosRadius = 1., sinRadius = 0.;
+		bool boundingCapComputed = false;
+		for (int h=0;unchanged && h<halfSpacesUsed;h++)
+		{
+			const int i = indexOfUsedSphericalCaps[h];
+			if (!previous.changed.at(i))
+				continue;
+			if (!boundingCapComputed)
+			{
+				getTriangleBoundingCap(c0,c1,c2,center,cosRadius,sinRadius);
+				boundingCapComputed = true;
+			}
+			const int side = classifyTriangle(convex.at(i),center,cosRadius,sinRadius);
+			unchanged = (side != 0 && side == classifyTriangle(previous.convex.at(i),center,cosRadius,sinRadius));
+		}
+	}
+	if (unchanged)
+	{
+		copyZones(lev,index,previous,inside_list,border_list,maxSearchLevel);
+		return;
+	}
+	(*border_list)--;
+	**border_list = index;
+	if (lev >= maxSearchLevel)
+		return;
+
+	// Did the previous search find this triangle on the border too?
+	QVarLengthArray<int,16> previous_halfs_used(previousHalfSpacesUsed);
+	int previous_halfs_used_count = 0;
+	bool previousBorder = true;
+	for (int h=0;h<previousHalfSpacesUsed;h++)
+	{
+		const int i = previousIndexOfUsedSphericalCaps[h];
+		if (!previous_corner0_inside[i] && !previous_corner1_inside[i] && !previous_corner2_inside[i])
+		{
+			previousBorder = false;
+			break;
+		}
+		else if (!previous_corner0_inside[i] || !previous_corner1_inside[i] || !previous_corner2_inside[i])
+		{
+			previous_halfs_used[previous_halfs_used_count++] = i;
+		}
+	}
+	previousBorder = previousBorder && previous_halfs_used_count > 0;
+
+	const Triangle &t(triangles[lev][index]);
+	lev++;
+	index <<= 2;
+	inside_list++;
+	border_list++;
+	const int n = convex.size();
+	QVarLengthArray<bool,16> edge0_inside(n), edge1_inside(n), edge2_inside(n);
+	for (int h=0;h<halfs_used_count;h++)
+	{
+		const int i = halfs_used[h];
+		const SphericalCap& half_space(convex.at(i));
+		edge0_inside[i] = half_space.contains(t.e0);
+		edge1_inside[i] = half_space.contains(t.e1);
+		edge2_inside[i] = half_space.contains(t.e2);
+	}
+	if (!previousBorder)
+	{
+		// The previous search didn't look into the sub triangles
+		searchZones(lev,index+0,
+		            convex,halfs_used.constData(),halfs_used_count,
+		            corner0_inside,edge2_inside.constData(),edge1_inside.constData(),
+		            inside_list,border_list,maxSearchLevel);
+		searchZones(lev,index+1,
+		            convex,halfs_used.constData(),halfs_used_count,
+		            edge2_inside.constData(),corner1_inside,edge0_inside.constData(),
+		            inside_list,border_list,maxSearchLevel);
+		searchZones(lev,index+2,
+		            convex,halfs_used.constData(),halfs_used_count,
+		            edge1_inside.constData(),edge0_inside.constData(),corner2_inside,
+		            inside_list,border_list,maxSearchLevel);
+		searchZones(lev,index+3,
+		            convex,halfs_used.constData(),halfs_used_count,
+		            edge0_inside.constData(),edge1_inside.constData(),edge2_inside.constData(),
+		            inside_list,border_list,maxSearchLevel);
+		return;
+	}
+
+	// Both lists of used SphericalCaps are sorted, the containment of the unchanged ones can be shared
+	QVarLengthArray<bool,16> previous_edge0_inside(n), previous_edge1_inside(n), previous_edge2_inside(n);
+	for (int h=0,j=0;h<previous_halfs_used_count;h++)
+	{
+		const int i = previous_halfs_used[h];
+		while (j<halfs_used_count && halfs_used[j]<i) j++;
+		if (!previous.changed.at(i) && j<halfs_used_count && halfs_used[j]==i)
+		{
+			previous_edge0_inside[i] = edge0_inside[i];
+			previous_edge1_inside[i] = edge1_inside[i];
+			previous_edge2_inside[i] = edge2_inside[i];
+		}
+		else
+		{
+			const SphericalCap& half_space(previous.convex.at(i));
+			previous_edge0_inside[i] = half_space.contains(t.e0);
+			previous_edge1_inside[i] = half_space.contains(t.e1);
+			previous_edge2_inside[i] = half_space.contains(t.e2);
+		}
+	}
+	updateZones(lev,index+0,c0,t.e2,t.e1,convex,previous,
+	            halfs_used.constData(),halfs_used_count,
+	            corner0_inside,edge2_inside.constData(),edge1_inside.constData(),
+	            previous_halfs_used.constData(),previous_halfs_used_count,
+	            previous_corner0_inside,previous_edge2_inside.constData(),previous_edge1_inside.constData(),
+	            inside_list,border_list,maxSearchLevel);
+	updateZones(lev,index+1,t.e2,c1,t.e0,convex,previous,
+	            halfs_used.constData(),halfs_used_count,
+	            edge2_inside.constData(),corner1_inside,edge0_inside.constData(),
+	            previous_halfs_used.constData(),previous_halfs_used_count,
+	            previous_edge2_inside.constData(),previous_corner1_inside,previous_edge0_inside.constData(),
+	            inside_list,border_list,maxSearchLevel);
+	updateZones(lev,index+2,t.e1,t.e0,c2,convex,previous,
+	            halfs_used.constData(),halfs_used_count,
+	            edge1_inside.constData(),edge0_inside.constData(),corner2_inside,
+	            previous_halfs_used.constData(),previous_halfs_used_count,
+	            previous_edge1_inside.constData(),previous_edge0_inside.constData(),previous_corner2_inside,
+	            inside_list,border_list,maxSearchLevel);
+	updateZones(lev,index+3,t.e0,t.e1,t.e2,convex,previous,
+	            halfs_used.constData(),halfs_used_count,
+	            edge0_inside.constData(),edge1_inside.constData(),edge2_inside.constData(),
+	            previous_halfs_used.constData(),previous_halfs_used_count,
+	            previous_edge0_inside.constData(),previous_edge1_inside.constData(),previous_edge2_inside.constData(),
+	            inside_list,border_list,maxSearchLevel);
+}
+
+void StelGeodesicGrid::copyZones(int lev,int index,
+                                 const PreviousSearch& previous,
+                                 int **inside_list,int **border_list,
+                                 const int maxSearchLevel) const
+{
+	(*border_list)--;
+	**border_list = index;
+	for (int k=1;lev+k<=maxSearchLevel;k++)
+	{
+		const int l = lev+k;
+		// the sub triangles of level l are the zones [first,last)
+		const int first = index<<(k<<1);
+		const int last = (index+1)<<(k<<1);
+		// The zones of a level are sorted in increasing order at the beginning of the array...
+		const int *begin = previous.zones[l];
+		const int *end = previous.inside[l];
+		const int *from = std::lower_bound(begin,end,first);
+		const int *to = std::lower_bound(from,end,last);
+		inside_list[k] = std::copy(from,to,inside_list[k]);
+		// ...and in decreasing order at its end
+		begin = previous.border[l];
+		end = previous.zones[l]+nrOfZones(l);
+		from = std::lower_bound(begin,end,last-1,std::greater<int>());
+		to = std::lower_bound(from,end,first-1,std::greater<int>());
+		while (to != from)
+		{
+			border_list[k]--;
+			*border_list[k] = *--to;
+		}
+	}
+}
+
 /*************************************************************************
  Return a search result matching the given spatial region
 *************************************************************************/
@@ -470,30 +762,49 @@ const GeodesicSearchResult* StelGeodesicGrid::search(const QVector<SphericalCap>
 
 GeodesicSearchResult::GeodesicSearchResult(const StelGeodesicGrid &grid)
 		:grid(grid),
+		maxLevel(grid.getMaxLevel()),
 		zones(new int*[grid.getMaxLevel()+1]),
 		inside(new int*[grid.getMaxLevel()+1]),
-		border(new int*[grid.getMaxLevel()+1])
+		border(new int*[grid.getMaxLevel()+1]),
+		previousZones(Q_NULLPTR),
+		previousInside(Q_NULLPTR),
+		previousBorder(Q_NULLPTR),
+		lastMaxSearchLevel(-1),
+		hasPrevious(false),
+		regionChanged(false)
 {
-	for (int i=0;i<=grid.getMaxLevel();i++)
+	for (int i=0;i<=maxLevel;i++)
 	{
 		zones[i] = new int[StelGeodesicGrid::nrOfZones(i)];
+		inside[i] = zones[i];
+		border[i] = zones[i]+StelGeodesicGrid::nrOfZones(i);
 	}
 }
 
 GeodesicSearchResult::~GeodesicSearchResult(void)
 {
-	for (int i=grid.getMaxLevel();i>=0;i--)
+	for (int i=maxLevel;i>=0;i--)
 	{
 		delete[] zones[i];
 	}
 	delete[] border;
 	delete[] inside;
 	delete[] zones;
+	if (previousZones)
+	{
+		for (int i=maxLevel;i>=0;i--)
+		{
+			delete[] previousZones[i];
+		}
+		delete[] previousBorder;
+		delete[] previousInside;
+		delete[] previousZones;
+	}
 }
 
 void GeodesicSearchResult::search(const QVector<SphericalCap>& convex, int maxSearchLevel)
 {
-	for (int i=grid.getMaxLevel();i>=0;i--)
+	for (int i=maxLevel;i>=0;i--)
 	{
 		inside[i] = zones[i];
 		border[i] = zones[i]+StelGeodesicGrid::nrOfZones(i);
@@ -501,6 +812,160 @@ void GeodesicSearchResult::search(const QVector<SphericalCap>& convex, int maxSe
 	grid.searchZones(convex,inside,border,maxSearchLevel);
 }
 
+void GeodesicSearchResult::update(const QVector<SphericalCap>& convex, int maxSearchLevel)
+{
+	if (maxSearchLevel < 0) maxSearchLevel = 0;
+	else if (maxSearchLevel > maxLevel) maxSearchLevel = maxLevel;
+	const bool hasLast = (lastMaxSearchLevel >= 0);
+	if (hasLast && maxSearchLevel==lastMaxSearchLevel && convex==lastRegion)
+	{
+		regionChanged = false;
+		return;
+	}
+
+	// Keep the current result as the previous one
+	if (!previousZones)
+	{
+		previousZones = new int*[maxLevel+1];
+		previousInside = new int*[maxLevel+1];
+		previousBorder = new int*[maxLevel+1];
+		for (int i=0;i<=maxLevel;i++)
+		{
+			previousZones[i] = new int[StelGeodesicGrid::nrOfZones(i)];
+		}
+	}
+	std::swap(zones,previousZones);
+	std::swap(inside,previousInside);
+	std::swap(border,previousBorder);
+	hasPrevious = hasLast;
+	regionChanged = true;
+
+	if (hasLast && maxSearchLevel==lastMaxSearchLevel && convex.size()==lastRegion.size())
+	{
+		QVector<bool> changed(convex.size());
+		for (int h=0;h<convex.size();h++)
+		{
+			changed[h] = !(convex.at(h)==lastRegion.at(h));
+		}
+		for (int i=maxLevel;i>=0;i--)
+		{
+			inside[i] = zones[i];
+			border[i] = zones[i]+StelGeodesicGrid::nrOfZones(i);
+		}
+		const StelGeodesicGrid::PreviousSearch previous = {lastRegion,changed,previousZones,previousInside,previousBorder};
+		grid.updateZones(convex,previous,inside,border,maxSearchLevel);
+	}
+	else
+	{
+		search(convex,maxSearchLevel);
+	}
+	lastRegion = convex;
+	lastMaxSearchLevel = maxSearchLevel;
+}
+
+void GeodesicSearchResult::getZoneRanges(int level, int *const *zoneArrays, int *const *insideEnds,
+                                         int *const *borderBegins, QVector<ZoneRange>& ranges) const
+{
+	// The inside zones of the lower levels cover ranges of zones of this level
+	QVector<ZoneRange> insideRanges;
+	for (int l=0;l<=level;l++)
+	{
+		const int shift = (level-l)<<1;
+		for (const int *p=zoneArrays[l];p<insideEnds[l];p++)
+		{
+			const ZoneRange range = {(*p)<<shift,(*p+1)<<shift,true};
+			insideRanges.append(range);
+		}
+	}
+	std::sort(insideRanges.begin(),insideRanges.end());
+	// The border zones are sorted in decreasing order
+	const int *border_begin = borderBegins[level];
+	const int *border_end = zoneArrays[level]+StelGeodesicGrid::nrOfZones(level);
+	ranges.clear();
+	ranges.reserve(insideRanges.size()+static_cast<int>(border_end-border_begin));
+	auto insideRange = insideRanges.constBegin();
+	while (border_end != border_begin || insideRange != insideRanges.constEnd())
+	{
+		if (border_end != border_begin && (insideRange == insideRanges.constEnd() || *(border_end-1) < insideRange->begin))
+		{
+			const int zone = *--border_end;
+			const ZoneRange range = {zone,zone+1,false};
+			ranges.append(range);
+		}
+		else
+		{
+			ranges.append(*insideRange++);
+		}
+	}
+}
+
+void GeodesicSearchResult::getZoneChanges(int level, QVector<int>& entered, QVector<int>& left) const
+{
+	entered.clear();
+	left.clear();
+	if (lastMaxSearchLevel < 0 || (hasPrevious && !regionChanged))
+		return;
+	if (level < 0) level = 0;
+	else if (level > maxLevel) level = maxLevel;
+
+	QVector<ZoneRange> current;
+	getZoneRanges(level,zones,inside,border,current);
+	if (!hasPrevious)
+	{
+		for (const auto& range : current)
+		{
+			for (int z=range.begin;z<range.end;z++)
+				entered.append(z);
+		}
+		return;
+	}
+	QVector<ZoneRange> previous;
+	getZoneRanges(level,previousZones,previousInside,previousBorder,previous);
+
+	// Walk through both sorted lists of ranges at once, from one range limit to the next
+	const int nbZones = StelGeodesicGrid::nrOfZones(level);
+	int c = 0, p = 0;
+	int pos = 0;
+	while (c<current.size() || p<previous.size())
+	{
+		// 0: outside, 1: border, 2: inside
+		int state = 0, previousState = 0;
+		int next = nbZones;
+		if (c<current.size())
+		{
+			const ZoneRange& range = current.at(c);
+			if (range.begin<=pos)
+			{
+				state = range.isInside ? 2 : 1;
+				next = range.end;
+			}
+			else
+				next = range.begin;
+		}
+		if (p<previous.size())
+		{
+			const ZoneRange& range = previous.at(p);
+			if (range.begin<=pos)
+			{
+				previousState = range.isInside ? 2 : 1;
+				next = qMin(next,range.end);
+			}
+			else
+				next = qMin(next,range.begin);
+		}
+		if (state != previousState)
+		{
+			for (int z=pos;previousState && z<next;z++)
+				left.append(z);
+			for (int z=pos;state && z<next;z++)
+				entered.append(z);
+		}
+		pos = next;
+		if (c<current.size() && current.at(c).end<=pos) c++;
+		if (p<previous.size() && previous.at(p).end<=pos) p++;
+	}
+}
+
 void GeodesicSearchInsideIterator::reset(void)
 {
 	level = 0;
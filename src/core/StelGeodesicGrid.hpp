@@ -101,7 +101,24 @@ private:
 	//! for full search depth set maxSearchLevel = maxLevel,
 	void searchZones(const QVector<SphericalCap>& convex,
 					 int **inside,int **border,int maxSearchLevel) const;
-	
+
+	//! The region and the result of a previous search, used by updateZones()
+	struct PreviousSearch
+	{
+		const QVector<SphericalCap>& convex;
+		//! For each SphericalCap of the new region, whether it differs from the previous one
+		const QVector<bool>& changed;
+		int *const *zones;
+		int *const *inside;
+		int *const *border;
+	};
+
+	//! Same as searchZones(), but copy the zones of a previous search of a region with as many
+	//! SphericalCaps and the same maxSearchLevel for the triangles which no changed SphericalCap crosses.
+	//! The result is the same as the one of searchZones().
+	void updateZones(const QVector<SphericalCap>& convex, const PreviousSearch& previous,
+					 int **inside,int **border,int maxSearchLevel) const;
+
 	const Vec3f& getTriangleCorner(int lev, int index, int cornerNumber) const;
 	void initTriangle(int lev,int index,
 					  const Vec3f &c0,
@@ -122,6 +139,27 @@ private:
 	                 const bool *corner1_inside,
 	                 const bool *corner2_inside,
 	                 int **inside,int **border,int maxSearchLevel) const;
+	void updateZones(int lev,int index,
+	                 const Vec3f &c0,
+	                 const Vec3f &c1,
+	                 const Vec3f &c2,
+	                 const QVector<SphericalCap>& convex,
+	                 const PreviousSearch& previous,
+	                 const int *indexOfUsedSphericalCaps,
+	                 const int halfSpacesUsed,
+	                 const bool *corner0_inside,
+	                 const bool *corner1_inside,
+	                 const bool *corner2_inside,
+	                 const int *previousIndexOfUsedSphericalCaps,
+	                 const int previousHalfSpacesUsed,
+	                 const bool *previous_corner0_inside,
+	                 const bool *previous_corner1_inside,
+	                 const bool *previous_corner2_inside,
+	                 int **inside,int **border,int maxSearchLevel) const;
+	//! Copy the zones found in the border triangle(lev,index) by a previous search.
+	void copyZones(int lev,int index,
+	               const PreviousSearch& previous,
+	               int **inside,int **border,int maxSearchLevel) const;
 
 	const int maxLevel;
 	struct Triangle
@@ -144,17 +182,54 @@ public:
 	GeodesicSearchResult(const StelGeodesicGrid &grid);
 	~GeodesicSearchResult(void);
 	void print(void) const;
+
+	//! Update the result to match a new spatial region, starting from the result of the previous call.
+	//! When the region only moves a little from one call to the next, as the viewport during a pan or a zoom,
+	//! only the triangles crossed by the SphericalCaps which changed are searched again, and the zones of the rest
+	//! of the sky are copied from the previous result. The result is the same as the one of a full search.
+	//! Unlike the result of StelGeodesicGrid::search(), this result belongs to the caller, so that it is not
+	//! replaced by the searches of other regions between two calls.
+	void update(const QVector<SphericalCap>& convex, int maxSearchLevel);
+
+	//! Get the zones of a level which entered or left the result in the last call to update(), in increasing order.
+	//! The zones of a level are those returned by GeodesicSearchInsideIterator and GeodesicSearchBorderIterator.
+	//! A zone which changed from inside to border or back is both in @p entered and in @p left.
+	//! After the first call to update(), all zones are in @p entered.
+	void getZoneChanges(int level, QVector<int>& entered, QVector<int>& left) const;
+
 private:
 	friend class GeodesicSearchInsideIterator;
 	friend class GeodesicSearchBorderIterator;
 	friend class StelGeodesicGrid;
-	
+
 	void search(const QVector<SphericalCap>& convex, int maxSearchLevel);
-	
+
+	//! Consecutive zones of a level which are all inside or all on the border of the region
+	struct ZoneRange
+	{
+		int begin;
+		int end;
+		bool isInside;
+		bool operator<(const ZoneRange& other) const {return begin < other.begin;}
+	};
+	//! Get the zones of a level returned by the iterators as ranges sorted by zone number.
+	void getZoneRanges(int level, int *const *zoneArrays, int *const *insideEnds, int *const *borderBegins,
+			   QVector<ZoneRange>& ranges) const;
+
 	const StelGeodesicGrid &grid;
-	int **const zones;
-	int **const inside;
-	int **const border;
+	const int maxLevel;
+	int **zones;
+	int **inside;
+	int **border;
+	//! The result of the previous call to update(), allocated by the first call
+	int **previousZones;
+	int **previousInside;
+	int **previousBorder;
+	QVector<SphericalCap> lastRegion;
+	int lastMaxSearchLevel;
+	//! Whether the previous result is valid, and whether it differs from the current one
+	bool hasPrevious;
+	bool regionChanged;
 };
 
 class GeodesicSearchBorderIterator
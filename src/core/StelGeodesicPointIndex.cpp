@@ -0,0 +1,198 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelGeodesicPointIndex.hpp"
+
+#include <cmath>
+
+namespace
+{
+// Added to the radius of the zone caps, covers the float precision of the grid corners and of the zone lookup
+const double ZONE_CAP_MARGIN = 1e-6;
+}
+
+StelGeodesicPointIndex::StelGeodesicPointIndex(int lev)
+	: level(qMax(0, lev))
+	, grid(level + 1)
+	, built(true)
+{
+	zoneCaps.resize(level + 1);
+	for (int l=0; l<=level; ++l)
+		zoneCaps[l].resize(StelGeodesicGrid::nrOfZones(l));
+	grid.visitTriangles(level, initZoneCap, this);
+	zoneStart.fill(0, StelGeodesicGrid::nrOfZones(level) + 1);
+}
+
+void StelGeodesicPointIndex::initZoneCap(int lev, int index, const Vec3f& c0, const Vec3f& c1, const Vec3f& c2, void* context)
+{
+	StelGeodesicPointIndex* self = static_cast<StelGeodesicPointIndex*>(context);
+	const Vec3d corners[3] = { Vec3d(c0[0], c0[1], c0[2]), Vec3d(c1[0], c1[1], c1[2]), Vec3d(c2[0], c2[1], c2[2]) };
+	ZoneCap& cap = self->zoneCaps[lev][index];
+	cap.center = corners[0] + corners[1] + corners[2];
+	cap.center.normalize();
+	double minCos = 1.;
+	for (const auto& c : corners)
+		minCos = qMin(minCos, cap.center * c / c.length());
+	// The triangles are all smaller than a hemisphere, so the cap through the corners contains the whole triangle
+	const double radius = std::acos(qBound(-1., minCos, 1.)) + ZONE_CAP_MARGIN;
+	cap.cosRadius = std::cos(radius);
+	cap.sinRadius = std::sin(radius);
+}
+
+void StelGeodesicPointIndex::clear()
+{
+	positions.clear();
+	ids.clear();
+	zones.clear();
+	zoneStart.fill(0);
+	built = true;
+}
+
+void StelGeodesicPointIndex::insert(const Vec3d& pos, int id)
+{
+	Vec3d v(pos);
+	v.normalize();
+	positions.append(v);
+	ids.append(id);
+	zones.append(grid.getZoneNumberForPoint(Vec3f(static_cast<float>(v[0]), static_cast<float>(v[1]), static_cast<float>(v[2])), level));
+	built = false;
+}
+
+void StelGeodesicPointIndex::build()
+{
+	if (built)
+		return;
+
+	// Counting sort by zone, keeping the insertion order inside each zone
+	zoneStart.fill(0);
+	for (int z : zones)
+		++zoneStart[z + 1];
+	for (int z=1; z<zoneStart.size(); ++z)
+		zoneStart[z] += zoneStart[z - 1];
+
+	QVector<int> next(zoneStart);
+	QVector<Vec3d> sortedPositions(positions.size());
+	QVector<int> sortedIds(ids.size());
+	for (int i=0; i<zones.size(); ++i)
+	{
+		const int k = next[zones.at(i)]++;
+		sortedPositions[k] = positions.at(i);
+		sortedIds[k] = ids.at(i);
+	}
+	positions.swap(sortedPositions);
+	ids.swap(sortedIds);
+	zones.clear();
+	zones.squeeze();
+	built = true;
+}
+
+template<class FuncObject>
+void StelGeodesicPointIndex::processZones(int lev, int index, const Vec3d& v, double cosRadius, double sinRadius,
+					  FuncObject& func) const
+{
+	const ZoneCap& cap = zoneCaps.at(lev).at(index);
+	const double d = cap.center * v;
+	// The caps are disjoint if the distance of the centers is larger than the sum of the radii.
+	// If the sum of the radii exceeds 180 degrees, i.e. cos(zone radius) < cos(180 - radius), they always intersect.
+	if (cap.cosRadius >= -cosRadius && d < cosRadius*cap.cosRadius - sinRadius*cap.sinRadius)
+		return;
+
+	const int shift = 2*(level - lev);
+	// The zone is inside the query cap if the distance of the centers plus the zone radius is within the radius
+	if (cap.cosRadius >= cosRadius && d >= cosRadius*cap.cosRadius + sinRadius*cap.sinRadius)
+	{
+		func(zoneStart.at(index << shift), zoneStart.at((index + 1) << shift), true);
+		return;
+	}
+
+	if (lev == level)
+	{
+		func(zoneStart.at(index), zoneStart.at(index + 1), false);
+		return;
+	}
+
+	for (int i=0; i<4; ++i)
+		processZones(lev + 1, 4*index + i, v, cosRadius, sinRadius, func);
+}
+
+void StelGeodesicPointIndex::findInCone(const Vec3d& center, double cosRadius, QVector<int>& result) const
+{
+	Vec3d v(center);
+	v.normalize();
+	const Vec3d* pos = positions.constData();
+	const int* id = ids.constData();
+
+	if (!built)
+	{
+		for (int i=0; i<positions.size(); ++i)
+		{
+			if (pos[i] * v >= cosRadius)
+				result.append(id[i]);
+		}
+		return;
+	}
+
+	auto func = [&](int begin, int end, bool inside)
+	{
+		for (int i=begin; i<end; ++i)
+		{
+			if (inside || pos[i] * v >= cosRadius)
+				result.append(id[i]);
+		}
+	};
+	const double c = qBound(-1., cosRadius, 1.);
+	const double s = std::sqrt(1. - c*c);
+	for (int i=0; i<20; ++i)
+		processZones(0, i, v, c, s, func);
+}
+
+int StelGeodesicPointIndex::findNearest(const Vec3d& pos, double cosMaxAngle) const
+{
+	Vec3d v(pos);
+	v.normalize();
+	const Vec3d* p = positions.constData();
+	const int* id = ids.constData();
+
+	int nearest = -1;
+	double nearestCos = cosMaxAngle;
+	auto func = [&](int begin, int end, bool)
+	{
+		for (int i=begin; i<end; ++i)
+		{
+			const double d = p[i] * v;
+			if (d > nearestCos || (nearest >= 0 && d == nearestCos && id[i] < nearest))
+			{
+				nearestCos = d;
+				nearest = id[i];
+			}
+		}
+	};
+
+	if (!built)
+	{
+		func(0, positions.size(), false);
+		return nearest;
+	}
+
+	const double c = qBound(-1., cosMaxAngle, 1.);
+	const double s = std::sqrt(1. - c*c);
+	for (int i=0; i<20; ++i)
+		processZones(0, i, v, c, s, func);
+	return nearest;
+}
@@ -0,0 +1,101 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef STELGEODESICPOINTINDEX_HPP
+#define STELGEODESICPOINTINDEX_HPP
+
+#include "StelGeodesicGrid.hpp"
+#include "VecMath.hpp"
+
+#include <QVector>
+
+//! @class StelGeodesicPointIndex
+//! Container allowing fast nearest-point and cone queries on a fixed set of points on the sphere.
+//! The points are bucketed into the zones of a StelGeodesicGrid level, and the zone hierarchy of
+//! the grid, with a bounding cap for each triangle, is used to skip the parts of the sky away from the query.
+//! Each point carries an integer id, typically the index of the object in the owner's list.
+//! Fill the index with insert() and call build() once all points are inserted. All queries are const
+//! and can be run from several threads at once.
+class StelGeodesicPointIndex
+{
+public:
+	//! @param level The level of the geodesic grid used for the buckets. The default of 5 (20480 zones,
+	//! about 2 degrees wide) suits catalogs of some 10^4 to 10^5 points.
+	StelGeodesicPointIndex(int level = 5);
+
+	//! Remove all the points.
+	void clear();
+
+	//! Insert a point. Until the next call to build(), queries fall back to a linear scan.
+	//! @param pos the position of the point, doesn't need to be normalized.
+	//! @param id the id returned by the queries for this point.
+	void insert(const Vec3d& pos, int id);
+
+	//! Sort the inserted points into their zones.
+	void build();
+
+	//! Return the number of points in the index.
+	int size() const { return ids.size(); }
+
+	//! Return the level of the geodesic grid used for the buckets.
+	int getLevel() const { return level; }
+
+	//! Append the ids of all points with an angular distance from @p center smaller or equal
+	//! than acos(@p cosRadius) to @p result. The ids are returned in zone order, not sorted.
+	void findInCone(const Vec3d& center, double cosRadius, QVector<int>& result) const;
+
+	//! Return the id of the point closest to @p pos, if its angular distance is smaller than
+	//! acos(@p cosMaxAngle), or -1 if there is no such point. If several points have the same
+	//! distance, the one with the smallest id is returned.
+	int findNearest(const Vec3d& pos, double cosMaxAngle) const;
+
+private:
+	Q_DISABLE_COPY(StelGeodesicPointIndex)
+
+	//! The bounding cap of a zone triangle.
+	struct ZoneCap
+	{
+		Vec3d center;
+		double cosRadius;
+		double sinRadius;
+	};
+
+	static void initZoneCap(int lev, int index, const Vec3f& c0, const Vec3f& c1, const Vec3f& c2, void* context);
+
+	//! Call @p func for every range of points in the zones which intersect the given cap.
+	//! The second argument of @p func tells if the whole zone is inside the cap.
+	template<class FuncObject> void processZones(int lev, int index, const Vec3d& v, double cosRadius, double sinRadius,
+						     FuncObject& func) const;
+
+	const int level;
+	//! One level deeper than needed, because StelGeodesicGrid has no triangle data for its own maximum level.
+	StelGeodesicGrid grid;
+	//! The bounding caps of all zones, per level.
+	QVector<QVector<ZoneCap>> zoneCaps;
+	//! The position of the first point of each zone in positions and ids.
+	QVector<int> zoneStart;
+	//! The normalized positions of the points, in zone order once built.
+	QVector<Vec3d> positions;
+	QVector<int> ids;
+	//! The zones of the points inserted since the last build.
+	QVector<int> zones;
+	bool built;
+};
+
+#endif // STELGEODESICPOINTINDEX_HPP
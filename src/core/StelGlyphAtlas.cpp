@@ -0,0 +1,153 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelGlyphAtlas.hpp"
+
+#include <QGlyphRun>
+#include <QOpenGLTexture>
+#include <QPainter>
+#include <QtMath>
+
+// Empty pixels between the glyphs, so that linear filtering does not bleed into the neighbours
+static const int GLYPH_PADDING = 1;
+
+StelGlyphAtlas::StelGlyphAtlas(int pageSize)
+	: pageSize(pageSize)
+{
+}
+
+StelGlyphAtlas::~StelGlyphAtlas()
+{
+	clear();
+}
+
+void StelGlyphAtlas::clear()
+{
+	for (auto& page : pages)
+		delete page.texture;
+	pages.clear();
+	glyphs.clear();
+}
+
+bool StelGlyphAtlas::allocate(int w, int h, int& page, QPoint& pos)
+{
+	w += GLYPH_PADDING;
+	h += GLYPH_PADDING;
+	if (w > pageSize || h > pageSize)
+		return false;
+
+	for (page=0; page<pages.size(); ++page)
+	{
+		Page& p = pages[page];
+		if (p.shelfX + w > pageSize)
+		{
+			// Start a new shelf
+			p.shelfY += p.shelfHeight;
+			p.shelfX = 0;
+			p.shelfHeight = 0;
+		}
+		if (p.shelfY + h <= pageSize)
+		{
+			pos = QPoint(p.shelfX, p.shelfY);
+			p.shelfX += w;
+			p.shelfHeight = qMax(p.shelfHeight, h);
+			return true;
+		}
+	}
+
+	Page p;
+	p.image = QImage(pageSize, pageSize, QImage::Format_RGBA8888);
+	// White everywhere, so that filtering at the glyph edges only changes the alpha
+	p.image.fill(QColor(255, 255, 255, 0));
+	p.texture = Q_NULLPTR;
+	p.dirty = true;
+	p.shelfX = w;
+	p.shelfY = 0;
+	p.shelfHeight = h;
+	pages.append(p);
+	page = pages.size()-1;
+	pos = QPoint(0, 0);
+	return true;
+}
+
+const StelGlyphAtlas::Glyph& StelGlyphAtlas::getGlyph(const QRawFont& font, int fontId, quint32 index)
+{
+	const quint64 key = (static_cast<quint64>(static_cast<quint32>(fontId)) << 32) | index;
+	auto it = glyphs.constFind(key);
+	if (it != glyphs.constEnd())
+		return it.value();
+
+	Glyph glyph;
+	glyph.page = -1;
+	const QRectF bounds = font.boundingRect(index);
+	if (bounds.isEmpty())
+		return glyphs.insert(key, glyph).value();
+
+	// One pixel of margin for the antialiasing
+	const int left = qFloor(bounds.left()) - 1;
+	const int top = qFloor(bounds.top()) - 1;
+	const int w = qCeil(bounds.right()) + 1 - left;
+	const int h = qCeil(bounds.bottom()) + 1 - top;
+	QPoint pos;
+	if (!allocate(w, h, glyph.page, pos))
+	{
+		glyph.page = -1;
+		return glyphs.insert(key, glyph).value();
+	}
+	glyph.rect = QRect(pos, QSize(w, h));
+	glyph.offset = QPoint(left, top);
+
+	QImage image(w, h, QImage::Format_ARGB32_Premultiplied);
+	image.fill(Qt::transparent);
+	QGlyphRun run;
+	run.setRawFont(font);
+	run.setGlyphIndexes(QVector<quint32>() << index);
+	run.setPositions(QVector<QPointF>() << QPointF(-left, -top));
+	QPainter painter(&image);
+	painter.setPen(Qt::white);
+	painter.drawGlyphRun(QPointF(0., 0.), run);
+	painter.end();
+
+	// Keep only the coverage, the color comes from the vertices
+	Page& p = pages[glyph.page];
+	for (int y=0; y<h; ++y)
+	{
+		const QRgb* src = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+		uchar* dst = p.image.scanLine(pos.y()+y) + 4*pos.x();
+		for (int x=0; x<w; ++x)
+			dst[4*x+3] = static_cast<uchar>(qAlpha(src[x]));
+	}
+	p.dirty = true;
+	return glyphs.insert(key, glyph).value();
+}
+
+void StelGlyphAtlas::bindPage(int page)
+{
+	Page& p = pages[page];
+	if (p.dirty || !p.texture)
+	{
+		delete p.texture;
+		p.texture = new QOpenGLTexture(p.image, QOpenGLTexture::DontGenerateMipMaps);
+		p.texture->setMinificationFilter(QOpenGLTexture::Linear);
+		p.texture->setMagnificationFilter(QOpenGLTexture::Linear);
+		p.texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+		p.dirty = false;
+	}
+	p.texture->bind();
+}
@@ -0,0 +1,92 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef STELGLYPHATLAS_HPP
+#define STELGLYPHATLAS_HPP
+
+#include <QHash>
+#include <QImage>
+#include <QPoint>
+#include <QRawFont>
+#include <QRect>
+#include <QVector>
+
+class QOpenGLTexture;
+
+//! @class StelGlyphAtlas
+//! Packs the rendered glyphs of all fonts into a few large textures, so that many labels can be drawn with one
+//! texture bind and one draw call. Each glyph is rendered once, the first time it is requested, in white with
+//! the coverage in the alpha channel, and placed in the first page with room left using a shelf packer.
+//! The pages are uploaded to OpenGL textures when they are bound after new glyphs were added.
+//! Apart from bindPage() and clear(), no OpenGL context is needed.
+class StelGlyphAtlas
+{
+public:
+	//! The place of a glyph in the atlas.
+	struct Glyph
+	{
+		//! Index of the page, or -1 for glyphs without pixels like spaces.
+		int page;
+		//! Pixels of the glyph in the page.
+		QRect rect;
+		//! Position of the top left corner of rect relative to the glyph origin, y pointing down.
+		QPoint offset;
+	};
+
+	//! @param pageSize the width and height of the pages in pixels.
+	explicit StelGlyphAtlas(int pageSize=1024);
+	~StelGlyphAtlas();
+
+	//! Get a glyph, rendering it into the atlas if needed.
+	//! @param font the font of the glyph.
+	//! @param fontId a number identifying the font, e.g. the font index of StelTextShaper.
+	//! @param index the index of the glyph in the font.
+	const Glyph& getGlyph(const QRawFont& font, int fontId, quint32 index);
+
+	int getPageSize() const { return pageSize; }
+	int getPageCount() const { return pages.size(); }
+	int getGlyphCount() const { return glyphs.size(); }
+	//! Get the pixels of a page, in RGBA format.
+	const QImage& getPageImage(int page) const { return pages.at(page).image; }
+
+	//! Bind the texture of a page to the active texture unit, uploading the page first if glyphs were added.
+	void bindPage(int page);
+
+	//! Remove all the glyphs and delete the textures.
+	void clear();
+
+private:
+	struct Page
+	{
+		QImage image;
+		QOpenGLTexture* texture;
+		bool dirty;
+		//! The current shelf of the packer
+		int shelfX, shelfY, shelfHeight;
+	};
+
+	//! Find room for a w x h rectangle, adding a page if needed.
+	bool allocate(int w, int h, int& page, QPoint& pos);
+
+	int pageSize;
+	QVector<Page> pages;
+	QHash<quint64, Glyph> glyphs;
+};
+
+#endif // STELGLYPHATLAS_HPP
@@ -0,0 +1,264 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelLocationCache.hpp"
+#include "StelFileMgr.hpp"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QVector>
+
+#include <cstring>
+#include <limits>
+
+namespace
+{
+const char CACHE_MAGIC[8] = { 'S', 'T', 'E', 'L', 'L', 'O', 'C', 'C' };
+const quint32 CACHE_VERSION = 1;
+const quint32 CACHE_BYTE_ORDER_MARK = 0x01020304;
+
+//! A string of the heap, as offset and length in UTF-16 code units
+struct StringRef
+{
+	quint32 offset;
+	quint32 length;
+};
+
+struct CacheHeader
+{
+	char magic[8];
+	quint32 version;
+	quint32 byteOrderMark;
+	quint32 recordSize;
+	char key[20];
+	quint32 count;
+	quint64 recordOffset;
+	quint64 heapOffset;
+	quint64 heapLength;
+};
+
+enum { StringCount = 7 };
+
+struct LocationRecord
+{
+	float longitude;
+	float latitude;
+	qint32 altitude;
+	qint32 bortleScaleIndex;
+	qint32 population;
+	quint16 role;
+	quint16 isUserLocation;
+	//! ID, name, state, country, planet name, landscape key, time zone
+	StringRef strings[StringCount];
+};
+
+quint64 alignTo8(quint64 n)
+{
+	return (n + 7) & ~static_cast<quint64>(7);
+}
+
+//! Collect the strings of the heap, sharing the repeated ones
+class HeapWriter
+{
+public:
+	StringRef add(const QString& str)
+	{
+		StringRef ref = { 0, 0 };
+		if (str.isEmpty())
+			return ref;
+		auto it = refs.constFind(str);
+		if (it != refs.constEnd())
+			return it.value();
+		ref.offset = static_cast<quint32>(heap.size());
+		ref.length = static_cast<quint32>(str.size());
+		heap.append(str);
+		refs.insert(str, ref);
+		return ref;
+	}
+	const QString& data() const { return heap; }
+private:
+	QString heap;
+	QHash<QString, StringRef> refs;
+};
+}
+
+QByteArray StelLocationCache::getCacheKey(const QString& locationFile)
+{
+	QFileInfo fi(locationFile);
+	if (!fi.exists())
+		return QByteArray();
+
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	hash.addData(fi.absoluteFilePath().toUtf8());
+	const qint64 extra[4] = { fi.size(), fi.lastModified().toMSecsSinceEpoch(), CACHE_VERSION,
+				  static_cast<qint64>(sizeof(LocationRecord)) };
+	hash.addData(reinterpret_cast<const char*>(extra), sizeof(extra));
+	return hash.result();
+}
+
+QString StelLocationCache::getCacheFileName(const QString& locationFile)
+{
+	const QString cacheDir = StelFileMgr::getCacheDir();
+	if (cacheDir.isEmpty())
+		return QString();
+	const QByteArray pathHash = QCryptographicHash::hash(QFileInfo(locationFile).absoluteFilePath().toUtf8(), QCryptographicHash::Sha1);
+	return cacheDir + "/locationcache/" + QString::fromLatin1(pathHash.toHex()) + ".cache";
+}
+
+bool StelLocationCache::save(const QString& cacheFile, const QByteArray& key, const QMap<QString, StelLocation>& locations)
+{
+	if (static_cast<size_t>(key.size()) != sizeof(CacheHeader::key))
+		return false;
+
+	QVector<LocationRecord> records(locations.size());
+	HeapWriter heapWriter;
+
+	CacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.version = CACHE_VERSION;
+	header.byteOrderMark = CACHE_BYTE_ORDER_MARK;
+	header.recordSize = sizeof(LocationRecord);
+	memcpy(header.key, key.constData(), sizeof(header.key));
+	header.count = static_cast<quint32>(locations.size());
+
+	// The map is sorted by ID, so are the records
+	int i = 0;
+	for (auto it = locations.constBegin(); it != locations.constEnd(); ++it, ++i)
+	{
+		const StelLocation& loc = it.value();
+		LocationRecord& r = records[i];
+		memset(&r, 0, sizeof(r));
+		r.longitude = loc.longitude;
+		r.latitude = loc.latitude;
+		r.altitude = loc.altitude;
+		r.bortleScaleIndex = loc.bortleScaleIndex;
+		r.population = loc.population;
+		r.role = loc.role.unicode();
+		r.isUserLocation = loc.isUserLocation ? 1 : 0;
+		const QString* strings[StringCount] = { &it.key(), &loc.name, &loc.state, &loc.country, &loc.planetName,
+							&loc.landscapeKey, &loc.ianaTimeZone };
+		for (int j=0; j<StringCount; ++j)
+			r.strings[j] = heapWriter.add(*strings[j]);
+	}
+
+	const QString& heapData = heapWriter.data();
+	header.recordOffset = alignTo8(sizeof(CacheHeader));
+	header.heapOffset = alignTo8(header.recordOffset + sizeof(LocationRecord)*static_cast<quint64>(records.size()));
+	header.heapLength = static_cast<quint64>(heapData.size());
+
+	QDir().mkpath(QFileInfo(cacheFile).absolutePath());
+	QSaveFile file(cacheFile);
+	if (!file.open(QIODevice::WriteOnly))
+		return false;
+
+	const QByteArray padding(8, '\0');
+	auto writeBlock = [&](quint64 offset, const void* block, quint64 size)
+	{
+		file.write(padding.constData(), static_cast<qint64>(offset) - file.pos());
+		file.write(reinterpret_cast<const char*>(block), static_cast<qint64>(size));
+	};
+	writeBlock(0, &header, sizeof(header));
+	writeBlock(header.recordOffset, records.constData(), sizeof(LocationRecord)*static_cast<quint64>(records.size()));
+	writeBlock(header.heapOffset, heapData.constData(), sizeof(QChar)*header.heapLength);
+	return file.commit();
+}
+
+bool StelLocationCache::load(const QString& cacheFile, const QByteArray& key, QMap<QString, StelLocation>& locations)
+{
+	QFile file(cacheFile);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	const qint64 fileSize = file.size();
+	if (fileSize < static_cast<qint64>(sizeof(CacheHeader)))
+		return false;
+
+	const uchar* data = file.map(0, fileSize);
+	if (!data)
+	{
+		qWarning() << "Could not map location cache" << QDir::toNativeSeparators(cacheFile) << file.errorString();
+		return false;
+	}
+
+	CacheHeader header;
+	memcpy(&header, data, sizeof(CacheHeader));
+	const quint64 size = static_cast<quint64>(fileSize);
+	if (memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) || header.version != CACHE_VERSION
+			|| header.byteOrderMark != CACHE_BYTE_ORDER_MARK || header.recordSize != sizeof(LocationRecord)
+			|| static_cast<size_t>(key.size()) != sizeof(header.key) || memcmp(header.key, key.constData(), sizeof(header.key))
+			|| header.count > static_cast<quint32>(std::numeric_limits<int>::max())
+			|| header.recordOffset > size || sizeof(LocationRecord)*static_cast<quint64>(header.count) > size - header.recordOffset
+			|| header.heapOffset > size || header.heapOffset % sizeof(QChar) || header.heapLength > (size - header.heapOffset)/sizeof(QChar))
+	{
+		qDebug() << "Ignoring outdated or invalid location cache" << QDir::toNativeSeparators(cacheFile);
+		file.unmap(const_cast<uchar*>(data));
+		return false;
+	}
+
+	const uchar* records = data + header.recordOffset;
+	const QChar* heap = reinterpret_cast<const QChar*>(data + header.heapOffset);
+	// The repeated strings are created once and shared by all the locations using them
+	QHash<quint32, QString> strings;
+	auto readString = [&](const StringRef& ref, bool shared) -> QString
+	{
+		if (ref.length == 0 || static_cast<quint64>(ref.offset) + ref.length > header.heapLength)
+			return QString();
+		if (!shared)
+			return QString(heap + ref.offset, static_cast<int>(ref.length));
+		auto it = strings.constFind(ref.offset);
+		if (it != strings.constEnd())
+			return it.value();
+		const QString str(heap + ref.offset, static_cast<int>(ref.length));
+		strings.insert(ref.offset, str);
+		return str;
+	};
+
+	locations.clear();
+	for (quint32 i=0; i<header.count; ++i)
+	{
+		LocationRecord r;
+		memcpy(&r, records + sizeof(LocationRecord)*i, sizeof(LocationRecord));
+		StelLocation loc;
+		loc.longitude = r.longitude;
+		loc.latitude = r.latitude;
+		loc.altitude = r.altitude;
+		loc.bortleScaleIndex = r.bortleScaleIndex;
+		loc.population = r.population;
+		loc.role = QChar(r.role);
+		loc.isUserLocation = r.isUserLocation != 0;
+		loc.name = readString(r.strings[1], false);
+		loc.state = readString(r.strings[2], true);
+		loc.country = readString(r.strings[3], true);
+		loc.planetName = readString(r.strings[4], true);
+		loc.landscapeKey = readString(r.strings[5], true);
+		loc.ianaTimeZone = readString(r.strings[6], true);
+		// The records are sorted, appending at the end of the map avoids searching it
+		locations.insert(locations.constEnd(), readString(r.strings[0], false), loc);
+	}
+
+	file.unmap(const_cast<uchar*>(data));
+	return true;
+}
@@ -0,0 +1,54 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef STELLOCATIONCACHE_HPP
+#define STELLOCATIONCACHE_HPP
+
+#include "StelLocation.hpp"
+
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+
+//! @class StelLocationCache
+//! Binary copy of the location database, which is read by mapping the file in memory instead of
+//! uncompressing base_locations.bin.gz and deserializing it with QDataStream.
+//! The file holds a header, an array of fixed size records sorted by location ID and a heap with the UTF-16
+//! text of the string fields. Each distinct string (country, planet, time zone, landscape...) is stored once in the
+//! heap and the locations read from the cache share a single QString for it. The time zones are stored as they
+//! are in the database and still have to be checked against the zones known to Qt after loading.
+//! The file is stored in native byte order and is only valid for the database file and Stellarium build which wrote it.
+class StelLocationCache
+{
+public:
+	//! Get a key identifying the database file (from its path, size and date) and the cache format.
+	static QByteArray getCacheKey(const QString& locationFile);
+	//! Get the name of the cache file for a database file.
+	static QString getCacheFileName(const QString& locationFile);
+
+	//! Write the locations to a cache file.
+	//! @param key the key returned by getCacheKey() for the database file.
+	static bool save(const QString& cacheFile, const QByteArray& key, const QMap<QString, StelLocation>& locations);
+
+	//! Read the locations from a cache file.
+	//! @return false if the file does not exist, is invalid or does not match the key.
+	static bool load(const QString& cacheFile, const QByteArray& key, QMap<QString, StelLocation>& locations);
+};
+
+#endif // STELLOCATIONCACHE_HPP
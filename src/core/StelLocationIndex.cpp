@@ -0,0 +1,123 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelLocationIndex.hpp"
+#include "StelUtils.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+//! The cones given to the point index are widened by this much, in degrees, so that no location is missed
+//! because StelLocation::distanceDegrees() computes in single precision.
+const double CONE_MARGIN = 0.01;
+
+//! Below this number of locations, a planet is indexed with a coarse grid which is cheaper to build.
+const int SMALL_PLANET_COUNT = 1000;
+
+double cosOfDegrees(double degrees)
+{
+	return degrees + CONE_MARGIN >= 180. ? -1. : std::cos((degrees + CONE_MARGIN)*M_PI/180.);
+}
+}
+
+Vec3d StelLocationIndex::toVector(float longitude, float latitude)
+{
+	Vec3d v;
+	StelUtils::spheToRect(static_cast<double>(longitude)*M_PI/180., static_cast<double>(latitude)*M_PI/180., v);
+	return v;
+}
+
+void StelLocationIndex::build(const QMap<QString, StelLocation>& locations)
+{
+	planets.clear();
+	QHash<QString, int> counts;
+	for (const auto& loc : locations)
+		++counts[loc.planetName];
+
+	for (auto it = counts.constBegin(); it != counts.constEnd(); ++it)
+	{
+		PlanetIndex& p = planets[it.key()];
+		p.ids.reserve(it.value());
+		p.longitudes.reserve(it.value());
+		p.latitudes.reserve(it.value());
+		p.points = QSharedPointer<StelGeodesicPointIndex>(new StelGeodesicPointIndex(it.value() < SMALL_PLANET_COUNT ? 2 : 5));
+	}
+
+	// The ids are appended in map order, so sorting the indices of the results sorts their IDs
+	for (auto it = locations.constBegin(); it != locations.constEnd(); ++it)
+	{
+		const StelLocation& loc = it.value();
+		PlanetIndex& p = planets[loc.planetName];
+		p.points->insert(toVector(loc.longitude, loc.latitude), p.ids.size());
+		p.ids.append(it.key());
+		p.longitudes.append(loc.longitude);
+		p.latitudes.append(loc.latitude);
+	}
+
+	for (auto& p : planets)
+		p.points->build();
+}
+
+int StelLocationIndex::size() const
+{
+	int n = 0;
+	for (const auto& p : planets)
+		n += p.ids.size();
+	return n;
+}
+
+QStringList StelLocationIndex::findInRadius(const QString& planetName, float longitude, float latitude, float radiusDegrees) const
+{
+	QStringList result;
+	auto it = planets.constFind(planetName);
+	if (it == planets.constEnd())
+		return result;
+
+	const PlanetIndex& p = it.value();
+	QVector<int> candidates;
+	p.points->findInCone(toVector(longitude, latitude), cosOfDegrees(static_cast<double>(radiusDegrees)), candidates);
+	std::sort(candidates.begin(), candidates.end());
+	result.reserve(candidates.size());
+	for (int i : candidates)
+	{
+		// Same test as a linear scan of the locations
+		if (StelLocation::distanceDegrees(longitude, latitude, p.longitudes.at(i), p.latitudes.at(i)) <= radiusDegrees)
+			result.append(p.ids.at(i));
+	}
+	return result;
+}
+
+QString StelLocationIndex::findNearest(const QString& planetName, float longitude, float latitude, float maxDistanceDegrees) const
+{
+	auto it = planets.constFind(planetName);
+	if (it == planets.constEnd())
+		return QString();
+
+	const PlanetIndex& p = it.value();
+	const int i = p.points->findNearest(toVector(longitude, latitude), cosOfDegrees(static_cast<double>(maxDistanceDegrees)));
+	if (i < 0)
+		return QString();
+	// distanceDegrees() gives NaN for a location at the very same position
+	const float d = StelLocation::distanceDegrees(longitude, latitude, p.longitudes.at(i), p.latitudes.at(i));
+	if (d > maxDistanceDegrees)
+		return QString();
+	return p.ids.at(i);
+}
@@ -0,0 +1,77 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef STELLOCATIONINDEX_HPP
+#define STELLOCATIONINDEX_HPP
+
+#include "StelLocation.hpp"
+#include "StelGeodesicPointIndex.hpp"
+
+#include <QHash>
+#include <QMap>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QVector>
+
+//! @class StelLocationIndex
+//! Spatial index of a list of locations for radius and nearest location queries.
+//! The locations of each planet are put in a StelGeodesicPointIndex over their direction from the planet center,
+//! so a query only visits the locations in the zones around the queried position instead of the whole list.
+//! The results are the same as testing StelLocation::distanceDegrees() on every location.
+//! All queries are const and can be run from several threads at once.
+class StelLocationIndex
+{
+public:
+	StelLocationIndex() {}
+
+	//! Index the given locations, replacing the previous ones.
+	//! @param locations the locations by ID, as in StelLocationMgr.
+	void build(const QMap<QString, StelLocation>& locations);
+
+	//! Remove all the locations.
+	void clear() { planets.clear(); }
+
+	//! Return the number of indexed locations.
+	int size() const;
+
+	//! Return the IDs of the locations of a planet within a given distance of a position, sorted.
+	//! @param longitude, latitude the position in degrees.
+	//! @param radiusDegrees the maximum great-circle distance in degrees.
+	QStringList findInRadius(const QString& planetName, float longitude, float latitude, float radiusDegrees) const;
+
+	//! Return the ID of the location of a planet closest to a position, or an empty string if there
+	//! is no location within @p maxDistanceDegrees.
+	QString findNearest(const QString& planetName, float longitude, float latitude, float maxDistanceDegrees=180.f) const;
+
+private:
+	struct PlanetIndex
+	{
+		QVector<QString> ids;
+		QVector<float> longitudes;
+		QVector<float> latitudes;
+		// StelGeodesicPointIndex cannot be copied
+		QSharedPointer<StelGeodesicPointIndex> points;
+	};
+
+	static Vec3d toVector(float longitude, float latitude);
+
+	QHash<QString, PlanetIndex> planets;
+};
+
+#endif // STELLOCATIONINDEX_HPP
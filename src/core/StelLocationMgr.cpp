@@ -25,6 +25,7 @@
 #include "StelUtils.hpp"
 #include "StelJsonParser.hpp"
 #include "StelLocaleMgr.hpp"
+#include "StelLocationCache.hpp"
 
 #include <QStringListModel>
 #include <QDebug>
@@ -39,6 +40,7 @@
 #include <QSettings>
 #include <QTimeZone>
 #include <QTimer>
+#include <QSet>
 #include <QApplication>
 
 TimezoneNameMap StelLocationMgr::locationDBToIANAtranslations;
@@ -413,7 +415,7 @@ void NMEALookupHelper::nmeaTimeout()
 #endif
 
 StelLocationMgr::StelLocationMgr()
-	: nmeaHelper(Q_NULLPTR), libGpsHelper(Q_NULLPTR)
+	: indexDirty(true), nmeaHelper(Q_NULLPTR), libGpsHelper(Q_NULLPTR)
 {
 	// initialize the static QMap first if necessary.
 	// The first entry is the DB name, the second is as we display it in the program.
@@ -486,7 +488,7 @@ StelLocationMgr::~StelLocationMgr()
 }
 
 StelLocationMgr::StelLocationMgr(const LocationList &locations)
-	: nmeaHelper(Q_NULLPTR), libGpsHelper(Q_NULLPTR)
+	: indexDirty(true), nmeaHelper(Q_NULLPTR), libGpsHelper(Q_NULLPTR)
 {
 	setLocations(locations);
 
@@ -502,6 +504,7 @@ void StelLocationMgr::setLocations(const LocationList &locations)
 	{
 		this->locations.insert(loc.getID(), loc);
 	}
+	indexDirty = true;
 
 	emit locationListChanged();
 }
@@ -529,6 +532,15 @@ LocationMap StelLocationMgr::loadCitiesBin(const QString& fileName)
 	if (cityDataPath.isEmpty())
 		return res;
 
+	// The binary cache holds the same list in a form which can be read without uncompressing and deserializing it
+	const QString cacheFile = StelLocationCache::getCacheFileName(cityDataPath);
+	const QByteArray cacheKey = StelLocationCache::getCacheKey(cityDataPath);
+	if (!cacheFile.isEmpty() && StelLocationCache::load(cacheFile, cacheKey, res))
+	{
+		validateTimeZones(res);
+		return res;
+	}
+
 	QFile sourcefile(cityDataPath);
 	if (!sourcefile.open(QIODevice::ReadOnly))
 	{
@@ -548,30 +560,56 @@ LocationMap StelLocationMgr::loadCitiesBin(const QString& fileName)
 		in.setVersion(QDataStream::Qt_5_2);
 		in >> res;
 	}
-	// Now res has all location data. However, some timezone names are not available in various versions of Qt.
+
+	// The cache keeps the time zone names of the database, they are translated for the running Qt after loading
+	if (!cacheFile.isEmpty() && !cacheKey.isEmpty() && !StelLocationCache::save(cacheFile, cacheKey, res))
+		qWarning() << "Could not write location cache" << QDir::toNativeSeparators(cacheFile);
+
+	validateTimeZones(res);
+	return res;
+}
+
+void StelLocationMgr::validateTimeZones(LocationMap& locations)
+{
+	// Some timezone names are not available in various versions of Qt.
 	// Sanity checks: It seems we must translate timezone names. Quite a number on Windows, but also still some on Linux.
-	QList<QByteArray> availableTimeZoneList=QTimeZone::availableTimeZoneIds();
+	// There are only a few hundred distinct names for tens of thousands of locations, so each one is checked once.
+	QSet<QByteArray> availableTimeZones;
+	for (const auto& tz : QTimeZone::availableTimeZoneIds())
+		availableTimeZones.insert(tz);
+	QHash<QString, QString> checkedTZ; // database name -> name to use, or null string if unknown
 	QStringList unknownTZlist;
-	for (auto& loc : res)
+	for (auto& loc : locations)
 	{
-		if ((loc.ianaTimeZone!="LMST") && (loc.ianaTimeZone!="LTST") && ( ! availableTimeZoneList.contains(loc.ianaTimeZone.toUtf8())) )
+		if ((loc.ianaTimeZone=="LMST") || (loc.ianaTimeZone=="LTST"))
+			continue;
+
+		auto checked = checkedTZ.constFind(loc.ianaTimeZone);
+		if (checked == checkedTZ.constEnd())
 		{
-			// TZ name which is currently unknown to Qt detected. See if we can translate it, if not: complain to qDebug().
-			QString fixTZname=sanitizeTimezoneStringFromLocationDB(loc.ianaTimeZone);
-			if (availableTimeZoneList.contains(fixTZname.toUtf8()))
-			{
-				loc.ianaTimeZone=fixTZname;
-			}
-			else
+			QString tz = loc.ianaTimeZone;
+			if (!availableTimeZones.contains(tz.toUtf8()))
 			{
-				qDebug() << "StelLocationMgr::loadCitiesBin(): TimeZone for " << loc.name <<  " not found: " << loc.ianaTimeZone;
-				unknownTZlist.append(loc.ianaTimeZone);
+				// TZ name which is currently unknown to Qt detected. See if we can translate it, if not: complain to qDebug().
+				QString fixTZname=sanitizeTimezoneStringFromLocationDB(tz);
+				if (availableTimeZones.contains(fixTZname.toUtf8()))
+					tz=fixTZname;
+				else
+				{
+					tz=QString();
+					unknownTZlist.append(loc.ianaTimeZone);
+				}
 			}
+			checked = checkedTZ.insert(loc.ianaTimeZone, tz);
 		}
+
+		if (checked.value().isNull())
+			qDebug() << "StelLocationMgr::loadCitiesBin(): TimeZone for " << loc.name <<  " not found: " << loc.ianaTimeZone;
+		else
+			loc.ianaTimeZone=checked.value(); // shared by all locations of the zone
 	}
 	if (unknownTZlist.length()>0)
 	{
-		unknownTZlist.removeDuplicates();
 		qDebug() << "StelLocationMgr::loadCitiesBin(): Summary of unknown TimeZones:";
 		for (const auto& tz : unknownTZlist)
 		{
@@ -580,8 +618,6 @@ LocationMap StelLocationMgr::loadCitiesBin(const QString& fileName)
 		qDebug() << "Please report these timezone names (this logfile) to the Stellarium developers.";
 		// Note to developers: Fill those names and replacements to the map above.
 	}
-
-	return res;
 }
 
 // Done in the following: TZ name sanitizing also for text file!
@@ -738,6 +774,7 @@ bool StelLocationMgr::saveUserLocation(const StelLocation& loc)
 
 	// Add in the program
 	locations[loc.getID()]=loc;
+	indexDirty = true;
 
 	//emit before saving the list
 	emit locationListChanged();
@@ -796,6 +833,7 @@ bool StelLocationMgr::deleteUserLocation(const QString& id)
 		return false;
 
 	locations.remove(id);
+	indexDirty = true;
 
 	//emit before saving the list
 	emit locationListChanged();
@@ -1032,21 +1070,36 @@ void StelLocationMgr::changeLocationFromNetworkLookup()
 	networkReply->deleteLater();
 }
 
+const StelLocationIndex& StelLocationMgr::getIndex()
+{
+	if (indexDirty)
+	{
+		index.build(locations);
+		indexDirty = false;
+	}
+	return index;
+}
+
 LocationMap StelLocationMgr::pickLocationsNearby(const QString planetName, const float longitude, const float latitude, const float radiusDegrees)
 {
 	QMap<QString, StelLocation> results;
-	QMapIterator<QString, StelLocation> iter(locations);
-	while (iter.hasNext())
+	const QStringList ids = getIndex().findInRadius(planetName, longitude, latitude, radiusDegrees);
+	// The IDs are sorted, appending at the end of the map avoids searching it
+	for (const auto& id : ids)
+		results.insert(results.constEnd(), id, locations.value(id));
+	return results;
+}
+
+StelLocation StelLocationMgr::pickNearestLocation(const QString planetName, const float longitude, const float latitude, const float maxDistanceDegrees)
+{
+	const QString id = getIndex().findNearest(planetName, longitude, latitude, maxDistanceDegrees);
+	if (id.isEmpty())
 	{
-		iter.next();
-		const StelLocation *loc=&iter.value();
-		if ( (loc->planetName == planetName) &&
-				(StelLocation::distanceDegrees(longitude, latitude, loc->longitude, loc->latitude) <= radiusDegrees) )
-		{
-			results.insert(iter.key(), iter.value());
-		}
+		StelLocation ret;
+		ret.role = '!';
+		return ret;
 	}
-	return results;
+	return locations.value(id);
 }
 
 LocationMap StelLocationMgr::pickLocationsInCountry(const QString country)
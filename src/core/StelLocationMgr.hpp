@@ -20,6 +20,7 @@
 #define STELLOCATIONMGR_HPP
 
 #include "StelLocation.hpp"
+#include "StelLocationIndex.hpp"
 #include <QString>
 #include <QObject>
 #include <QMetaType>
@@ -80,6 +81,9 @@ public:
 
 	//! Find list of locations within @param radiusDegrees of selected (usually screen-clicked) coordinates.
 	LocationMap pickLocationsNearby(const QString planetName, const float longitude, const float latitude, const float radiusDegrees);
+	//! Find the location closest to the given coordinates.
+	//! @return the location, or an invalid location if there is none within @param maxDistanceDegrees.
+	StelLocation pickNearestLocation(const QString planetName, const float longitude, const float latitude, const float maxDistanceDegrees=180.f);
 	//! Find list of locations in a particular country only.
 	LocationMap pickLocationsInCountry(const QString country);
 
@@ -139,9 +143,18 @@ private:
 	//! Load cities from a file
 	static LocationMap loadCities(const QString& fileName, bool isUserLocation);
 	static LocationMap loadCitiesBin(const QString& fileName);
+	//! Replace the time zones of the locations which are unknown to Qt by the names Qt uses.
+	//! Each distinct time zone name is only checked once.
+	static void validateTimeZones(LocationMap& locations);
+
+	//! Return the spatial index of the locations, rebuilt if the list changed.
+	const StelLocationIndex& getIndex();
 
 	//! The list of all loaded locations
 	LocationMap locations;
+	//! Spatial index of the locations for pickLocationsNearby() and pickNearestLocation()
+	StelLocationIndex index;
+	bool indexDirty;
 	//! A Map which has to be used to replace, system- and Qt-version dependent,
 	//! timezone names from our location database to the code names currently used by Qt.
 	//! Required to avoid https://bugs.launchpad.net/stellarium/+bug/1662132,
@@ -65,6 +65,13 @@ public:
 	//! If the initialization takes significant time, the progress should be displayed on the loading bar.
 	virtual void init() = 0;
 
+	//! Load the data files of the module, before init() is called.
+	//! StelApp calls this from a worker thread, concurrently with the data loading of other modules and
+	//! with the initialization of the modules on the main thread. It must therefore not use OpenGL, GUI
+	//! objects, the application settings, signals of other objects or other modules. The default
+	//! implementation does nothing and all the work is done in init().
+	virtual void loadModuleData() {;}
+
 	//! Called before the module will be delete, and before the openGL context is suppressed.
 	//! Deinitialize all openGL texture in this method.
 	virtual void deinit() {;}
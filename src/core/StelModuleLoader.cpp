@@ -0,0 +1,133 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelModuleLoader.hpp"
+#include "StelModule.hpp"
+
+#include <QDebug>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+StelModuleLoader::StelModuleLoader(bool parallel, QThreadPool* pool)
+	: parallel(parallel)
+	, pool(pool ? pool : QThreadPool::globalInstance())
+{
+	clock.start();
+}
+
+StelModuleLoader::~StelModuleLoader()
+{
+	for (const auto& e : entries)
+		e->loading.waitForFinished();
+}
+
+StelModuleLoader::EntryP StelModuleLoader::getEntry(StelModule* module, const QString& name)
+{
+	EntryP e = module ? moduleEntries.value(module) : EntryP();
+	if (!e)
+	{
+		e = EntryP(new Entry);
+		e->name = name;
+		entries.append(e);
+		if (module)
+			moduleEntries.insert(module, e);
+	}
+	return e;
+}
+
+void StelModuleLoader::startLoading(StelModule* module, const QVector<StelModule*>& dependencies)
+{
+	Q_ASSERT(!moduleEntries.contains(module));
+	EntryP e = getEntry(module, module->objectName());
+	e->hasData = true;
+	if (!parallel)
+		return;
+
+	// The dependencies were queued before, so waiting for them cannot starve the pool
+	QVector<QFuture<void>> waitFor;
+	for (auto* dep : dependencies)
+	{
+		Q_ASSERT(moduleEntries.contains(dep));
+		waitFor.append(moduleEntries.value(dep)->loading);
+	}
+
+	const QElapsedTimer* c = &clock;
+	e->loading = QtConcurrent::run(pool, [module, e, waitFor, c]() {
+		for (auto f : waitFor)
+			f.waitForFinished();
+		e->loadStart = c->elapsed();
+		module->loadModuleData();
+		e->loadEnd = c->elapsed();
+	});
+}
+
+void StelModuleLoader::initModule(StelModule* module)
+{
+	EntryP e = getEntry(module, module->objectName());
+	if (e->hasData)
+	{
+		const qint64 t = clock.elapsed();
+		if (parallel)
+			e->loading.waitForFinished();
+		else
+		{
+			e->loadStart = t;
+			module->loadModuleData();
+			e->loadEnd = clock.elapsed();
+		}
+		e->waitMs = clock.elapsed() - t;
+	}
+
+	e->initStart = clock.elapsed();
+	module->init();
+	e->initEnd = clock.elapsed();
+}
+
+void StelModuleLoader::runStep(const QString& name, const std::function<void()>& step)
+{
+	EntryP e = getEntry(Q_NULLPTR, name);
+	e->initStart = clock.elapsed();
+	step();
+	e->initEnd = clock.elapsed();
+}
+
+void StelModuleLoader::logTimings() const
+{
+	qint64 initTotal = 0, waitTotal = 0, loadTotal = 0, end = 0;
+	for (const auto& e : entries)
+	{
+		const qint64 initMs = e->initEnd - e->initStart;
+		const qint64 loadMs = e->loadEnd - e->loadStart;
+		if (e->loadStart>=0)
+		{
+			qDebug().noquote() << QString("  %1: data %2 ms (at %3 ms), waited %4 ms, init %5 ms")
+					      .arg(e->name).arg(loadMs).arg(e->loadStart).arg(e->waitMs).arg(initMs);
+			loadTotal += loadMs;
+		}
+		else
+			qDebug().noquote() << QString("  %1: init %2 ms").arg(e->name).arg(initMs);
+		initTotal += initMs;
+		waitTotal += e->waitMs;
+		end = qMax(end, e->initEnd);
+	}
+	qDebug().noquote() << QString("Module initialization took %1 ms (%2): %3 ms of init on the main thread, "
+				      "%4 ms waiting for data, %5 ms of data loading")
+			      .arg(end).arg(parallel ? QString("%1 threads").arg(pool->maxThreadCount()) : "serial")
+			      .arg(initTotal).arg(waitTotal).arg(loadTotal);
+}
@@ -0,0 +1,92 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef STELMODULELOADER_HPP
+#define STELMODULELOADER_HPP
+
+#include <functional>
+
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QHash>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+class StelModule;
+class QThreadPool;
+
+//! @class StelModuleLoader
+//! Initializes the modules in two phases and times them.
+//! The data phase (StelModule::loadModuleData()) of the modules passed to startLoading() runs on a thread pool,
+//! concurrently with the other modules and with the main thread. A module's data is loaded only once the data
+//! of the modules it depends on is loaded.
+//! The second phase (StelModule::init()) runs on the main thread when initModule() is called, in the order of
+//! the calls, after waiting for the data phase of the module to complete.
+//! logTimings() reports the time spent by each module in both phases, and how long the main thread was blocked
+//! waiting for data, which shows the critical path of the startup.
+class StelModuleLoader
+{
+public:
+	//! @param parallel if false, the data phase of each module is run on the main thread from initModule().
+	//! @param pool the pool running the data phases, or Q_NULLPTR for the global thread pool.
+	explicit StelModuleLoader(bool parallel=true, QThreadPool* pool=Q_NULLPTR);
+	//! Wait for the data phases still running.
+	~StelModuleLoader();
+
+	//! Start loading the data of a module in the background.
+	//! @param dependencies the modules whose data must be loaded before. They must have been passed to
+	//! startLoading() before this module.
+	void startLoading(StelModule* module, const QVector<StelModule*>& dependencies=QVector<StelModule*>());
+
+	//! Wait until the data of a module is loaded, then call its init() on the calling thread.
+	//! Modules which were not passed to startLoading() are simply initialized.
+	void initModule(StelModule* module);
+
+	//! Run and time another initialization step on the calling thread.
+	void runStep(const QString& name, const std::function<void()>& step);
+
+	//! Log the time spent in each module and step so far. StelApp only calls it with --verbose.
+	void logTimings() const;
+
+private:
+	struct Entry
+	{
+		QString name;
+		bool hasData = false;
+		QFuture<void> loading;
+		// All times in ms, relative to the creation of the loader. Set by the worker thread for the data phase.
+		qint64 loadStart = -1;
+		qint64 loadEnd = -1;
+		qint64 waitMs = 0;
+		qint64 initStart = -1;
+		qint64 initEnd = -1;
+	};
+	typedef QSharedPointer<Entry> EntryP;
+
+	EntryP getEntry(StelModule* module, const QString& name);
+
+	bool parallel;
+	QThreadPool* pool;
+	QElapsedTimer clock;
+	QVector<EntryP> entries;
+	QHash<StelModule*, EntryP> moduleEntries;
+};
+
+#endif // STELMODULELOADER_HPP
@@ -19,16 +19,21 @@
  */
 
 #include "StelApp.hpp"
+#include "StelFileMgr.hpp"
 #include "StelOBJ.hpp"
 #include "StelTextureMgr.hpp"
 #include "StelUtils.hpp"
 
 #include <QBuffer>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDir>
 #include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
 #include <QRegularExpression>
+#include <QSaveFile>
 #include <QTextStream>
 
 Q_LOGGING_CATEGORY(stelOBJ,"stel.OBJ")
@@ -94,6 +99,300 @@ bool StelOBJ::load(const QString& filename, const VertexOrder vertexOrder)
 	return load(file,fi.canonicalPath(),vertexOrder);
 }
 
+namespace
+{
+//! Fixed-size header at the start of a binary OBJ cache file.
+//! The cache is only meant to be read on the machine that wrote it, so the vertex and
+//! index blocks are stored in native byte order and with the native Vertex layout.
+struct CacheHeader
+{
+	char magic[8];
+	quint32 version;
+	quint32 byteOrderMark;
+	quint32 vertexSize;
+	quint32 vertexOrder;
+	char key[20];
+	quint32 reserved;
+	quint64 vertexOffset;
+	quint64 vertexCount;
+	quint64 indexOffset;
+	quint64 indexCount;
+	quint64 metaOffset;
+	quint64 metaSize;
+};
+
+const char CACHE_MAGIC[8] = { 'S', 'T', 'E', 'L', 'O', 'B', 'J', 'C' };
+//increase this when the cache layout or the post-processing changes
+const quint32 CACHE_VERSION = 1;
+const quint32 CACHE_BYTE_ORDER_MARK = 0x01020304;
+//the data blocks are aligned to this amount of bytes inside the file
+const quint64 CACHE_ALIGNMENT = 16;
+
+inline quint64 alignCacheOffset(quint64 offset)
+{
+	return (offset + CACHE_ALIGNMENT - 1) & ~(CACHE_ALIGNMENT - 1);
+}
+}
+
+static QDataStream& operator<<(QDataStream& out, const AABBox& box)
+{
+	return out << box.min << box.max;
+}
+
+static QDataStream& operator>>(QDataStream& in, AABBox& box)
+{
+	return in >> box.min >> box.max;
+}
+
+static QDataStream& operator<<(QDataStream& out, const StelOBJ::Material& mat)
+{
+	out << static_cast<qint32>(mat.illum) << mat.name << mat.Ka << mat.Kd << mat.Ks << mat.Ke << mat.Ns << mat.d;
+	out << mat.map_Ka << mat.map_Kd << mat.map_Ks << mat.map_Ke << mat.map_bump << mat.map_height;
+	return out << mat.additionalParams;
+}
+
+static QDataStream& operator>>(QDataStream& in, StelOBJ::Material& mat)
+{
+	qint32 illum;
+	in >> illum >> mat.name >> mat.Ka >> mat.Kd >> mat.Ks >> mat.Ke >> mat.Ns >> mat.d;
+	in >> mat.map_Ka >> mat.map_Kd >> mat.map_Ks >> mat.map_Ke >> mat.map_bump >> mat.map_height;
+	mat.illum = static_cast<StelOBJ::Material::Illum>(illum);
+	return in >> mat.additionalParams;
+}
+
+static QDataStream& operator<<(QDataStream& out, const StelOBJ::MaterialGroup& grp)
+{
+	out << static_cast<qint32>(grp.startIndex) << static_cast<qint32>(grp.indexCount);
+	out << static_cast<qint32>(grp.objectIndex) << static_cast<qint32>(grp.materialIndex);
+	return out << grp.centroid << grp.boundingbox;
+}
+
+static QDataStream& operator>>(QDataStream& in, StelOBJ::MaterialGroup& grp)
+{
+	qint32 startIndex, indexCount, objectIndex, materialIndex;
+	in >> startIndex >> indexCount >> objectIndex >> materialIndex;
+	grp.startIndex = startIndex;
+	grp.indexCount = indexCount;
+	grp.objectIndex = objectIndex;
+	grp.materialIndex = materialIndex;
+	return in >> grp.centroid >> grp.boundingbox;
+}
+
+static QDataStream& operator<<(QDataStream& out, const StelOBJ::Object& obj)
+{
+	return out << obj.isDefaultObject << obj.name << obj.centroid << obj.boundingbox << obj.groups;
+}
+
+static QDataStream& operator>>(QDataStream& in, StelOBJ::Object& obj)
+{
+	return in >> obj.isDefaultObject >> obj.name >> obj.centroid >> obj.boundingbox >> obj.groups;
+}
+
+QByteArray StelOBJ::getCacheKey(const QString &filename, const VertexOrder vertexOrder)
+{
+	QFile file(filename);
+	if(!file.open(QIODevice::ReadOnly))
+		return QByteArray();
+
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	if(!hash.addData(&file))
+		return QByteArray();
+	const quint32 extra[2] = { CACHE_VERSION, static_cast<quint32>(vertexOrder) };
+	hash.addData(reinterpret_cast<const char*>(extra), sizeof(extra));
+	return hash.result();
+}
+
+QStringList StelOBJ::getCacheFileNames(const QString &filename)
+{
+	QStringList list;
+	QFileInfo fi(filename);
+	list.append(fi.absoluteFilePath() + ".cache");
+
+	//fallback for read-only scene directories, named after the path of the .obj file
+	const QString cacheDir = StelFileMgr::getCacheDir();
+	if(!cacheDir.isEmpty())
+	{
+		const QByteArray pathHash = QCryptographicHash::hash(fi.absoluteFilePath().toUtf8(), QCryptographicHash::Sha1);
+		list.append(cacheDir + "/objcache/" + QString::fromLatin1(pathHash.toHex()) + ".cache");
+	}
+	return list;
+}
+
+bool StelOBJ::loadCached(const QString &filename, const VertexOrder vertexOrder)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	const QByteArray key = getCacheKey(filename, vertexOrder);
+	if(key.isEmpty())
+	{
+		qCCritical(stelOBJ)<<"Could not read file"<<filename;
+		return false;
+	}
+
+	const QStringList cacheFiles = getCacheFileNames(filename);
+	for (const auto& cacheFile : cacheFiles)
+	{
+		if(loadCache(cacheFile, key))
+		{
+			qCDebug(stelOBJ)<<"Loaded"<<filename<<"from cache"<<cacheFile<<"in"<<timer.elapsed()<<"ms";
+			return true;
+		}
+	}
+
+	if(!load(filename, vertexOrder))
+		return false;
+
+	for (const auto& cacheFile : cacheFiles)
+	{
+		QDir().mkpath(QFileInfo(cacheFile).absolutePath());
+		if(saveCache(cacheFile, key))
+		{
+			qCDebug(stelOBJ)<<"Wrote OBJ cache"<<cacheFile;
+			return true;
+		}
+	}
+	qCWarning(stelOBJ)<<"Could not write a cache for"<<filename;
+	return true;
+}
+
+bool StelOBJ::loadCache(const QString &cacheFile, const QByteArray &key)
+{
+	QFile file(cacheFile);
+	if(!file.open(QIODevice::ReadOnly))
+		return false;
+
+	const qint64 fileSize = file.size();
+	if(fileSize < static_cast<qint64>(sizeof(CacheHeader)))
+		return false;
+
+	const uchar* data = file.map(0, fileSize);
+	if(!data)
+	{
+		qCWarning(stelOBJ)<<"Could not map OBJ cache"<<cacheFile<<file.errorString();
+		return false;
+	}
+
+	CacheHeader header;
+	memcpy(&header, data, sizeof(CacheHeader));
+	const quint64 size = static_cast<quint64>(fileSize);
+	if(memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) || header.version != CACHE_VERSION
+			|| header.byteOrderMark != CACHE_BYTE_ORDER_MARK || header.vertexSize != sizeof(Vertex)
+			|| static_cast<size_t>(key.size()) != sizeof(header.key) || memcmp(header.key, key.constData(), sizeof(header.key))
+			|| header.vertexCount > static_cast<quint64>(std::numeric_limits<int>::max())
+			|| header.indexCount > static_cast<quint64>(std::numeric_limits<int>::max())
+			|| header.metaSize > static_cast<quint64>(std::numeric_limits<int>::max())
+			|| header.vertexOffset > size || header.vertexCount * sizeof(Vertex) > size - header.vertexOffset
+			|| header.indexOffset > size || header.indexCount * sizeof(unsigned int) > size - header.indexOffset
+			|| header.metaOffset > size || header.metaSize > size - header.metaOffset)
+	{
+		qCDebug(stelOBJ)<<"Ignoring outdated or invalid OBJ cache"<<cacheFile;
+		return false;
+	}
+
+	//the materials and objects are small, these are serialized with QDataStream
+	const QByteArray meta = QByteArray::fromRawData(reinterpret_cast<const char*>(data + header.metaOffset), static_cast<int>(header.metaSize));
+	QDataStream in(meta);
+	in.setVersion(QDataStream::Qt_5_6);
+	in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+	StelOBJ obj;
+	QVector<qint64> fileSizes, fileTimes;
+	in >> obj.m_materialFiles >> fileSizes >> fileTimes;
+	if(in.status() != QDataStream::Ok || fileSizes.size() != obj.m_materialFiles.size() || fileTimes.size() != obj.m_materialFiles.size())
+		return false;
+
+	//the .obj contents are part of the key, but the referenced .mtl files have to be checked separately
+	for(int i = 0; i < obj.m_materialFiles.size(); ++i)
+	{
+		QFileInfo fi(obj.m_materialFiles.at(i));
+		if(fi.size() != fileSizes.at(i) || fi.lastModified().toMSecsSinceEpoch() != fileTimes.at(i))
+		{
+			qCDebug(stelOBJ)<<"Material file"<<fi.filePath()<<"has changed, ignoring OBJ cache"<<cacheFile;
+			return false;
+		}
+	}
+
+	in >> obj.m_materials >> obj.m_materialMap >> obj.m_objects >> obj.m_objectMap >> obj.m_bbox >> obj.m_centroid;
+	if(in.status() != QDataStream::Ok)
+	{
+		qCWarning(stelOBJ)<<"Damaged OBJ cache"<<cacheFile;
+		return false;
+	}
+
+	obj.m_vertices.resize(static_cast<int>(header.vertexCount));
+	memcpy(obj.m_vertices.data(), data + header.vertexOffset, header.vertexCount * sizeof(Vertex));
+	obj.m_indices.resize(static_cast<int>(header.indexCount));
+	memcpy(obj.m_indices.data(), data + header.indexOffset, header.indexCount * sizeof(unsigned int));
+	obj.m_isLoaded = true;
+
+	file.unmap(const_cast<uchar*>(data));
+	*this = obj;
+	return true;
+}
+
+bool StelOBJ::saveCache(const QString &cacheFile, const QByteArray &key) const
+{
+	CacheHeader header;
+	if(!m_isLoaded || static_cast<size_t>(key.size()) != sizeof(header.key))
+		return false;
+
+	QByteArray meta;
+	{
+		QDataStream out(&meta, QIODevice::WriteOnly);
+		out.setVersion(QDataStream::Qt_5_6);
+		out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+		QVector<qint64> fileSizes, fileTimes;
+		for (const auto& mtl : m_materialFiles)
+		{
+			QFileInfo fi(mtl);
+			fileSizes.append(fi.size());
+			fileTimes.append(fi.lastModified().toMSecsSinceEpoch());
+		}
+		out << m_materialFiles << fileSizes << fileTimes;
+		out << m_materials << m_materialMap << m_objects << m_objectMap << m_bbox << m_centroid;
+	}
+
+	memset(&header, 0, sizeof(CacheHeader));
+	memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.version = CACHE_VERSION;
+	header.byteOrderMark = CACHE_BYTE_ORDER_MARK;
+	header.vertexSize = sizeof(Vertex);
+	memcpy(header.key, key.constData(), sizeof(header.key));
+	header.vertexOffset = alignCacheOffset(sizeof(CacheHeader));
+	header.vertexCount = static_cast<quint64>(m_vertices.size());
+	header.indexOffset = alignCacheOffset(header.vertexOffset + header.vertexCount * sizeof(Vertex));
+	header.indexCount = static_cast<quint64>(m_indices.size());
+	header.metaOffset = alignCacheOffset(header.indexOffset + header.indexCount * sizeof(unsigned int));
+	header.metaSize = static_cast<quint64>(meta.size());
+
+	//QSaveFile only replaces an existing cache once everything has been written
+	QSaveFile file(cacheFile);
+	if(!file.open(QIODevice::WriteOnly))
+		return false;
+
+	const char padding[CACHE_ALIGNMENT] = {};
+	auto writeBlock = [&](const void* block, quint64 blockSize, quint64 offset)
+	{
+		const qint64 gap = static_cast<qint64>(offset) - file.pos();
+		Q_ASSERT(gap >= 0 && gap < static_cast<qint64>(CACHE_ALIGNMENT));
+		return file.write(padding, gap) == gap
+			&& file.write(static_cast<const char*>(block), static_cast<qint64>(blockSize)) == static_cast<qint64>(blockSize);
+	};
+
+	const bool ok = writeBlock(&header, sizeof(CacheHeader), 0)
+			&& writeBlock(m_vertices.constData(), header.vertexCount * sizeof(Vertex), header.vertexOffset)
+			&& writeBlock(m_indices.constData(), header.indexCount * sizeof(unsigned int), header.indexOffset)
+			&& writeBlock(meta.constData(), header.metaSize, header.metaOffset);
+	if(!ok)
+	{
+		file.cancelWriting();
+		return false;
+	}
+	return file.commit();
+}
+
 //macro to test out different ways of comparison and their performance
 #define CMD_CMP(a) (QLatin1String(a)==cmd)
 
@@ -874,7 +1173,8 @@ bool StelOBJ::load(QIODevice& device, const QString &basePath, const VertexOrder
 				if(ok)
 				{
 					//load external material file
-					MaterialList newMaterials = Material::loadFromFile(baseDir.absoluteFilePath(fileName));
+					m_materialFiles.append(baseDir.absoluteFilePath(fileName));
+					MaterialList newMaterials = Material::loadFromFile(m_materialFiles.last());
 					for (const auto& m : newMaterials)
 					{
 						m_materials.append(m);
@@ -26,6 +26,7 @@
 #include <qopengl.h>
 #include <QLoggingCategory>
 #include <QString>
+#include <QStringList>
 #include <QIODevice>
 #include <QVector>
 #include <QHash>
@@ -252,6 +253,26 @@ public:
 	//! @param vertexOrder The order to use for vertex positions
 	//! @return true if load was successful
 	bool load(QIODevice& device, const QString& basePath, const VertexOrder vertexOrder = VertexOrder::XYZ);
+	//! Loads an .obj file like load(const QString&, const VertexOrder), but keeps a binary cache
+	//! of the parsed and post-processed data to skip parsing on later loads.
+	//! The cache is stored next to the .obj file with the additional extension \c .cache
+	//! (or in the cache directory if that location is not writable). It is keyed by the contents
+	//! of the file, the vertex order and the cache format version, and a stale cache is silently replaced.
+	//! @return true if load was successful
+	bool loadCached(const QString& filename, const VertexOrder vertexOrder = VertexOrder::XYZ);
+	//! Replaces the current data with the contents of a binary cache file written by saveCache().
+	//! The file is memory-mapped and the vertex and index blocks are copied without any parsing.
+	//! @param key The expected cache key, as returned by getCacheKey()
+	//! @return false if the file is missing or damaged, was written for another key or format version,
+	//! or if one of the .mtl files it depends on has changed since
+	bool loadCache(const QString& cacheFile, const QByteArray& key);
+	//! Writes the currently loaded data into a binary cache file.
+	//! @param key The cache key, as returned by getCacheKey()
+	//! @return true if the cache was written successfully
+	bool saveCache(const QString& cacheFile, const QByteArray& key) const;
+	//! Computes the cache key for the given .obj file and vertex order.
+	//! @return an empty array if the file could not be read
+	static QByteArray getCacheKey(const QString& filename, const VertexOrder vertexOrder);
 
 	//! Returns true if this object contains valid data from a load() method
 	bool isLoaded() const { return m_isLoaded; }
@@ -318,6 +339,8 @@ private:
 	MaterialMap m_materialMap;
 	ObjectList m_objects;
 	ObjectMap m_objectMap;
+	//absolute paths of the .mtl files used by this model, needed to validate the binary cache
+	QStringList m_materialFiles;
 
 	//global bounding box
 	AABBox m_bbox;
@@ -354,6 +377,9 @@ private:
 
 	inline void addObject(const QString& name, CurrentParserState& state);
 
+	//! Returns the possible locations of the binary cache for the given .obj file, in order of preference
+	static QStringList getCacheFileNames(const QString& filename);
+
 	//! Regenerate all normals in the vertex list
 	void generateNormals();
 
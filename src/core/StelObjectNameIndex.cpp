@@ -0,0 +1,163 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelObjectNameIndex.hpp"
+
+#include <QSet>
+
+#include <algorithm>
+
+StelObjectNameIndex::StelObjectNameIndex()
+	: built(true)
+{
+}
+
+void StelObjectNameIndex::clear()
+{
+	entries.clear();
+	trigrams.clear();
+	built = true;
+}
+
+void StelObjectNameIndex::insert(const QString& name, const QString& alias)
+{
+	if (name.isEmpty())
+		return;
+	Entry e;
+	e.key = (alias.isEmpty() ? name : alias).toUpper();
+	e.name = name;
+	entries.append(e);
+	built = false;
+}
+
+void StelObjectNameIndex::build()
+{
+	if (built)
+		return;
+
+	std::sort(entries.begin(), entries.end());
+	entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+	entries.squeeze();
+
+	trigrams.clear();
+	for (int i=0; i<entries.size(); ++i)
+	{
+		const QString& key = entries.at(i).key;
+		for (int j=0; j+3<=key.size(); ++j)
+		{
+			QVector<int>& ids = trigrams[trigram(key.constData()+j)];
+			// a trigram can appear several times in the same key
+			if (ids.isEmpty() || ids.last()!=i)
+				ids.append(i);
+		}
+	}
+	for (auto& ids : trigrams)
+		ids.squeeze();
+	built = true;
+}
+
+QStringList StelObjectNameIndex::findPrefix(const QString& text, int maxNbItem) const
+{
+	QStringList result;
+	if (maxNbItem == 0)
+		return result;
+
+	const QString prefix = text.toUpper();
+	QSet<QString> found;
+	auto add = [&](const Entry& e)
+	{
+		if (!found.contains(e.name))
+		{
+			found.insert(e.name);
+			result.append(e.name);
+		}
+		return maxNbItem < 0 || result.size() < maxNbItem;
+	};
+
+	if (!built)
+	{
+		for (const auto& e : entries)
+		{
+			if (e.key.startsWith(prefix) && !add(e))
+				break;
+		}
+		result.sort();
+		return result;
+	}
+
+	Entry first;
+	first.key = prefix;
+	for (auto it = std::lower_bound(entries.constBegin(), entries.constEnd(), first); it != entries.constEnd(); ++it)
+	{
+		if (!it->key.startsWith(prefix) || !add(*it))
+			break;
+	}
+	result.sort();
+	return result;
+}
+
+QStringList StelObjectNameIndex::findSubstring(const QString& text, int maxNbItem) const
+{
+	QStringList result;
+	if (maxNbItem == 0)
+		return result;
+
+	const QString sub = text.toUpper();
+	QSet<QString> found;
+	auto add = [&](const Entry& e)
+	{
+		if (!found.contains(e.name))
+		{
+			found.insert(e.name);
+			result.append(e.name);
+		}
+		return maxNbItem < 0 || result.size() < maxNbItem;
+	};
+
+	if (!built || sub.size() < 3)
+	{
+		// Short texts match most names, so the scan usually stops early
+		for (const auto& e : entries)
+		{
+			if (e.key.contains(sub) && !add(e))
+				break;
+		}
+		result.sort();
+		return result;
+	}
+
+	// Check the names containing the rarest trigram of the text
+	const QVector<int>* candidates = Q_NULLPTR;
+	for (int j=0; j+3<=sub.size(); ++j)
+	{
+		auto it = trigrams.constFind(trigram(sub.constData()+j));
+		if (it == trigrams.constEnd())
+			return result;
+		if (!candidates || it->size() < candidates->size())
+			candidates = &it.value();
+	}
+	for (int i : *candidates)
+	{
+		const Entry& e = entries.at(i);
+		if (e.key.contains(sub) && !add(e))
+			break;
+	}
+	result.sort();
+	return result;
+}
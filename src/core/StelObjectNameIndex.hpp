@@ -0,0 +1,99 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef STELOBJECTNAMEINDEX_HPP
+#define STELOBJECTNAMEINDEX_HPP
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+//! @class StelObjectNameIndex
+//! Case insensitive index of object names and designations, used by the StelObjectModule::listMatchingObjects()
+//! implementations. The names are kept sorted by their upper case key, so that all names starting with a prefix
+//! form a contiguous range found by binary search. Substring queries use a trigram index: the candidates are the
+//! names containing the rarest trigram of the searched text, which are then checked one by one.
+//! The index is meant to be rebuilt when the names change, e.g. on sky culture or language change.
+//! Fill it with insert() and call build() once all names are inserted.
+class StelObjectNameIndex
+{
+public:
+	StelObjectNameIndex();
+
+	//! Remove all the names.
+	void clear();
+
+	//! Insert a name. Until the next call to build(), queries fall back to a linear scan.
+	//! @param name the name returned by the queries.
+	//! @param alias the text matched by the queries instead of the name, if not empty.
+	//! This allows to find e.g. "Mel 31" by typing "Melotte 31".
+	void insert(const QString& name, const QString& alias=QString());
+
+	//! Sort the names and build the trigram index.
+	void build();
+
+	//! Return the number of names in the index.
+	int size() const { return entries.size(); }
+	bool isEmpty() const { return entries.isEmpty(); }
+
+	//! Find the names starting with the given text, ignoring case.
+	//! @param maxNbItem the maximum number of returned names, or -1 for all names.
+	//! @return the matching names in alphabetical order, without duplicates.
+	QStringList findPrefix(const QString& text, int maxNbItem=-1) const;
+
+	//! Find the names containing the given text, ignoring case.
+	//! @param maxNbItem the maximum number of returned names, or -1 for all names.
+	//! @return the matching names in alphabetical order, without duplicates.
+	QStringList findSubstring(const QString& text, int maxNbItem=-1) const;
+
+	//! Find the matching names in the same way as StelObjectModule::matchObjectName().
+	//! @param useStartOfWords use findPrefix() if true, findSubstring() otherwise.
+	QStringList find(const QString& text, int maxNbItem, bool useStartOfWords) const
+	{
+		return useStartOfWords ? findPrefix(text, maxNbItem) : findSubstring(text, maxNbItem);
+	}
+
+private:
+	struct Entry
+	{
+		QString key;
+		QString name;
+		bool operator<(const Entry& other) const
+		{
+			return key < other.key || (key == other.key && name < other.name);
+		}
+		bool operator==(const Entry& other) const
+		{
+			return key == other.key && name == other.name;
+		}
+	};
+
+	static quint64 trigram(const QChar* c)
+	{
+		return (static_cast<quint64>(c[0].unicode()) << 32) | (static_cast<quint64>(c[1].unicode()) << 16) | c[2].unicode();
+	}
+
+	QVector<Entry> entries;
+	//! The ids of the entries containing each trigram, in increasing order.
+	QHash<quint64, QVector<int>> trigrams;
+	bool built;
+};
+
+#endif // STELOBJECTNAMEINDEX_HPP
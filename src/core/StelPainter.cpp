@@ -26,6 +26,8 @@
 #include "StelUtils.hpp"
 #include "Dithering.hpp"
 #include "SaturationShader.hpp"
+#include "StelTextShaper.hpp"
+#include "StelGlyphAtlas.hpp"
 
 #include <QDebug>
 #include <QString>
@@ -35,19 +37,20 @@
 #include <QMutex>
 #include <QVarLengthArray>
 #include <QPaintEngine>
-#include <QCache>
 #include <QOpenGLPaintDevice>
 #include <QOpenGLShader>
 #include <QOpenGLTexture>
 #include <QApplication>
 
-static const int TEX_CACHE_LIMIT = 7000000;
-
 #ifndef NDEBUG
 QMutex* StelPainter::globalMutex = new QMutex();
 #endif
 
-QCache<QByteArray, StringTexture> StelPainter::texCache(TEX_CACHE_LIMIT);
+QVector<StelPainter::GlyphBatch> StelPainter::glyphBatches;
+int StelPainter::pendingGlyphs = 0;
+StelTextShaper* StelPainter::textShaper = Q_NULLPTR;
+StelGlyphAtlas* StelPainter::glyphAtlas = Q_NULLPTR;
+bool StelPainter::useGlyphAtlas = false;
 QOpenGLShaderProgram* StelPainter::texturesShaderProgram=Q_NULLPTR;
 QOpenGLShaderProgram* StelPainter::basicShaderProgram=Q_NULLPTR;
 QOpenGLShaderProgram* StelPainter::colorShaderProgram=Q_NULLPTR;
@@ -155,6 +158,9 @@ StelPainter::StelPainter(const StelProjectorP& proj) : QOpenGLFunctions(QOpenGLC
 
 void StelPainter::setProjector(const StelProjectorP& p)
 {
+	// The pending glyphs are in window coordinates of the previous projector
+	if (prj)
+		flushText();
 	prj=p;
 	// Init GL viewport to current projector values
 	glViewport(prj->viewportXywh[0], prj->viewportXywh[1], prj->viewportXywh[2], prj->viewportXywh[3]);
@@ -163,6 +169,7 @@ void StelPainter::setProjector(const StelProjectorP& p)
 
 StelPainter::~StelPainter()
 {
+	flushText();
 	if(bayerPatternTex)
 		glDeleteTextures(1, &bayerPatternTex);
 	//reset opengl state
@@ -628,49 +635,106 @@ void StelPainter::drawText(const Vec3d& v, const QString& str, float angleDeg, f
  Draw the string at the given position and angle with the given font
 *************************************************************************/
 
-// Methods taken from text-use-opengl-buffer
-// Container for one cached string texture
-struct StringTexture
+void StelPainter::drawTextWithAtlas(float x, float y, const QString& str, float angleDeg, float xshift, float yshift)
 {
-	QOpenGLTexture* texture;
-	QSize size;
-	QSizeF getTexSize() const {
-		return QSizeF(static_cast<qreal>(size.width())  / static_cast<qreal>(texture->width()),
-			      static_cast<qreal>(size.height()) / static_cast<qreal>(texture->height()));
+	const float scaleRatio = StelApp::getInstance().getGlobalScalingRatio();
+	QFont tmpFont = currentFont;
+	tmpFont.setPixelSize(currentFont.pixelSize()*static_cast<int>(static_cast<float>(prj->getDevicePixelsPerPixel())*scaleRatio));
+	const StelShapedText* text = textShaper->shape(str, tmpFont);
+	xshift*=scaleRatio;
+	yshift*=scaleRatio;
+
+	const bool rotated = std::fabs(angleDeg)>1.f;
+	const float cosr = rotated ? std::cos(angleDeg * M_PI_180f) : 1.f;
+	const float sinr = rotated ? std::sin(angleDeg * M_PI_180f) : 0.f;
+	if (!rotated)
+	{
+		// Align the glyphs on the pixels to keep them sharp
+		x = std::round(x + xshift);
+		y = std::round(y + yshift);
+		xshift = 0.f;
+		yshift = 0.f;
+	}
+	const float texScale = 1.f/glyphAtlas->getPageSize();
+
+	for (const auto& g : text->glyphs)
+	{
+		const StelGlyphAtlas::Glyph& glyph = glyphAtlas->getGlyph(textShaper->getFont(g.font), g.font, g.index);
+		if (glyph.page<0)
+			continue;
+		if (glyph.page>=glyphBatches.size())
+			glyphBatches.resize(glyph.page+1);
+		GlyphBatch& batch = glyphBatches[glyph.page];
+
+		// Corners of the glyph relative to the text origin, y pointing up as in window coordinates
+		const float gx = rotated ? g.x : std::round(g.x);
+		const float u0 = xshift + gx + glyph.offset.x();
+		const float u1 = u0 + glyph.rect.width();
+		const float v0 = yshift - g.y - glyph.offset.y();
+		const float v1 = v0 - glyph.rect.height();
+		const Vec2f topLeft(x + u0*cosr - v0*sinr, y + u0*sinr + v0*cosr);
+		const Vec2f topRight(x + u1*cosr - v0*sinr, y + u1*sinr + v0*cosr);
+		const Vec2f bottomLeft(x + u0*cosr - v1*sinr, y + u0*sinr + v1*cosr);
+		const Vec2f bottomRight(x + u1*cosr - v1*sinr, y + u1*sinr + v1*cosr);
+		batch.vertices << bottomLeft << bottomRight << topLeft << topLeft << bottomRight << topRight;
+
+		// The first row of the page image is the first row of the texture
+		const float s0 = glyph.rect.x()*texScale;
+		const float s1 = (glyph.rect.x()+glyph.rect.width())*texScale;
+		const float t0 = glyph.rect.y()*texScale;
+		const float t1 = (glyph.rect.y()+glyph.rect.height())*texScale;
+		batch.texCoords << Vec2f(s0, t1) << Vec2f(s1, t1) << Vec2f(s0, t0) << Vec2f(s0, t0) << Vec2f(s1, t1) << Vec2f(s1, t0);
+
+		for (int i=0; i<6; ++i)
+			batch.colors << currentColor;
+		++pendingGlyphs;
 	}
+}
 
-	StringTexture(QOpenGLTexture* tex, const QSize& size) :
-	     texture(tex), size(size) {}
-	~StringTexture() {delete texture;}
-};
-
-StringTexture* StelPainter::getTexTexture(const QString& str, int pixelSize) const
+void StelPainter::flushText()
 {
-	// Render first the text into a QPixmap, then create a QOpenGLTexture
-	// from it.  We could optimize by directly using a QImage, but for some
-	// reason the result is not exactly the same than with a QPixmap.
-	QByteArray hash = str.toUtf8() + QByteArray::number(pixelSize);
-	StringTexture* cachedTex = texCache.object(hash);
-	if (cachedTex)
-		return cachedTex;
-	QFont tmpFont = currentFont;
-	tmpFont.setPixelSize(currentFont.pixelSize()*static_cast<int>(static_cast<float>(prj->getDevicePixelsPerPixel())*StelApp::getInstance().getGlobalScalingRatio()));
-	QRect strRect = QFontMetrics(tmpFont).boundingRect(str);
-	int w = strRect.width()+1+static_cast<int>(0.02f*strRect.width());
-	int h = strRect.height();
-
-	QPixmap strImage = QPixmap(StelUtils::getBiggerPowerOfTwo(w), StelUtils::getBiggerPowerOfTwo(h));
-	strImage.fill(Qt::transparent);
-	QPainter painter(&strImage);
-	tmpFont.setStyleStrategy(QFont::NoAntialias);
-	painter.setFont(tmpFont);
-	//painter.setRenderHints(QPainter::TextAntialiasing);
-	painter.setPen(Qt::white);
-	painter.drawText(-strRect.x(), -strRect.y(), str);
-	StringTexture* newTex = new StringTexture(new QOpenGLTexture(strImage.toImage()), QSize(w, h));
-	texCache.insert(hash, newTex, 3*w*h);
-	// simply returning newTex is dangerous as the object is owned by the cache now. (Coverity Scan barks.)
-	return texCache.object(hash);
+	if (pendingGlyphs==0)
+		return;
+	// Reset first, as drawFromArray() flushes the text too
+	pendingGlyphs = 0;
+
+	// Save the state changed to draw the glyphs: the caller may have set up a texture and arrays for its next draw
+	const ArrayDesc oldVertexArray = vertexArray;
+	const ArrayDesc oldTexCoordArray = texCoordArray;
+	const ArrayDesc oldColorArray = colorArray;
+	const ArrayDesc oldNormalArray = normalArray;
+	const bool oldBlending = glState.blend;
+	const GLenum oldSrc = glState.blendSrc, oldDst = glState.blendDst;
+	GLint oldTexture = 0;
+	glActiveTexture(GL_TEXTURE0);
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &oldTexture);
+
+	setBlending(true);
+	enableClientStates(true, true, true);
+	for (int page=0; page<glyphBatches.size(); ++page)
+	{
+		GlyphBatch& batch = glyphBatches[page];
+		if (batch.vertices.isEmpty())
+			continue;
+		glActiveTexture(GL_TEXTURE0);
+		glyphAtlas->bindPage(page);
+		setVertexPointer(2, GL_FLOAT, batch.vertices.constData());
+		setTexCoordPointer(2, GL_FLOAT, batch.texCoords.constData());
+		setColorPointer(4, GL_FLOAT, batch.colors.constData());
+		drawFromArray(Triangles, batch.vertices.size(), 0, false);
+		// resize() keeps the capacity for the next frames
+		batch.vertices.resize(0);
+		batch.texCoords.resize(0);
+		batch.colors.resize(0);
+	}
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(oldTexture));
+	setBlending(oldBlending, oldSrc, oldDst);
+	vertexArray = oldVertexArray;
+	texCoordArray = oldTexCoordArray;
+	colorArray = oldColorArray;
+	normalArray = oldNormalArray;
 }
 
 void StelPainter::drawText(float x, float y, const QString& str, float angleDeg, float xshift, float yshift, bool noGravity)
@@ -679,61 +743,11 @@ void StelPainter::drawText(float x, float y, const QString& str, float angleDeg,
 	{
 		drawTextGravity180(x, y, str, xshift, yshift);
 	}
-	else if (qApp->property("text_texture")==true) // CLI option -t given?
+	else if (useGlyphAtlas)
 	{
-		//qDebug() <<  "Text texture" << str;
-		// This is taken from branch text-use-opengl-buffer. This is essential on devices like Raspberry Pi (2016-03).
-		StringTexture* tex = getTexTexture(str, currentFont.pixelSize());
-		Q_ASSERT(tex);
 		if (!noGravity)
 			angleDeg += prj->defaultAngleForGravityText;
-		tex->texture->bind();
-
-		static float vertexData[8];
-		// compute the vertex coordinates applying the translation and the rotation
-		static const float vertexBase[] = {0., 0., 1., 0., 0., 1., 1., 1.};
-		if (std::fabs(angleDeg)>1.f*static_cast<float>(M_PI)/180.f)
-		{
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-			const float cosr = std::cos(angleDeg * static_cast<float>(M_PI/180.));
-			const float sinr = std::sin(angleDeg * static_cast<float>(M_PI/180.));
-			for (int i = 0; i < 8; i+=2)
-			{
-				vertexData[i] = int(x + (tex->size.width()*vertexBase[i]+xshift) * cosr - (tex->size.height()*vertexBase[i+1]+yshift) * sinr);
-				vertexData[i+1] = int(y  + (tex->size.width()*vertexBase[i]+xshift) * sinr + (tex->size.height()*vertexBase[i+1]+yshift) * cosr);
-			}
-		}
-		else
-		{
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-			for (int i = 0; i < 8; i+=2)
-			{
-				vertexData[i] = int(x + tex->size.width()*vertexBase[i]+xshift);
-				vertexData[i+1] = int(y  + tex->size.height()*vertexBase[i+1]+yshift);
-			}
-		}
-
-		float* texCoords = new float[8];
-		for (int i=0;i<4;i++)
-		{
-			texCoords[i*2+0] = static_cast<float>(tex->getTexSize().width()) * (i % 2);
-			texCoords[i*2+1] = static_cast<float>(tex->getTexSize().height()) * (1 - static_cast<float>(i) / 2);
-		}
-		setTexCoordPointer(2, GL_FLOAT, texCoords);
-
-		//text drawing requires blending, but we reset GL state afterwards if necessary
-		bool oldBlending = glState.blend;
-		GLenum oldSrc = glState.blendSrc, oldDst = glState.blendDst;
-		setBlending(true);
-		enableClientStates(true, true);
-		setVertexPointer(2, GL_FLOAT, vertexData);
-		drawFromArray(TriangleStrip, 4, 0, false);
-		setBlending(oldBlending, oldSrc, oldDst);
-		enableClientStates(false, false);
-		tex->texture->release();
-		delete[] texCoords;
+		drawTextWithAtlas(x, y, str, angleDeg, xshift, yshift);
 	}
 	else
 	{
@@ -2156,6 +2170,12 @@ void StelPainter::initGLShaders()
 	texturesColorShaderVars.bayerPattern = texturesColorShaderProgram->uniformLocation("bayerPattern");
 	texturesColorShaderVars.rgbMaxValue = texturesColorShaderProgram->uniformLocation("rgbMaxValue");
 	texturesColorShaderVars.saturation = texturesColorShaderProgram->uniformLocation("saturation");
+
+	// Text drawn with a glyph atlas, needed on devices like the Raspberry Pi where QPainter is too slow (CLI option -t)
+	QSettings*const conf = StelApp::getInstance().getSettings();
+	useGlyphAtlas = qApp->property("text_texture")==true || (conf && conf->value("video/glyph_atlas_text", false).toBool());
+	textShaper = new StelTextShaper();
+	glyphAtlas = new StelGlyphAtlas();
 }
 
 
@@ -2169,7 +2189,12 @@ void StelPainter::deinitGLShaders()
 	texturesShaderProgram = Q_NULLPTR;
 	delete texturesColorShaderProgram;
 	texturesColorShaderProgram = Q_NULLPTR;
-	texCache.clear();
+	glyphBatches.clear();
+	pendingGlyphs = 0;
+	delete glyphAtlas;
+	glyphAtlas = Q_NULLPTR;
+	delete textShaper;
+	textShaper = Q_NULLPTR;
 }
 
 
@@ -2201,6 +2226,8 @@ void StelPainter::enableClientStates(bool vertex, bool texture, bool color, bool
 
 void StelPainter::drawFromArray(DrawingMode mode, int count, int offset, bool doProj, const unsigned short* indices)
 {
+	flushText();
+
 	ArrayDesc projectedVertexArray = vertexArray;
 	if (doProj)
 	{
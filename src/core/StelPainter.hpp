@@ -27,6 +27,7 @@
 #include "StelProjector.hpp"
 #include <QString>
 #include <QVarLengthArray>
+#include <QVector>
 #include <QFontMetrics>
 
 class QOpenGLShaderProgram;
@@ -78,7 +79,8 @@ public:
 	//! Returns a QOpenGLFunctions object suitable for drawing directly with OpenGL while this StelPainter is active.
 	//! This is recommended to be used instead of QOpenGLContext::currentContext()->functions() when a StelPainter is available,
 	//! and you only need to call a few GL functions directly.
-	inline QOpenGLFunctions* glFuncs() { return this; }
+	//! Text drawn with the glyph atlas is drawn first, so that it stays below what is drawn next.
+	inline QOpenGLFunctions* glFuncs() { flushText(); return this; }
 
 	//! Return the instance of projector associated to this painter
 	const StelProjectorP& getProjector() const {return prj;}
@@ -356,9 +358,25 @@ private:
 		QOpenGLFunctions* gl;
 	} glState;
 
-	// From text-use-opengl-buffer
-	static QCache<QByteArray, struct StringTexture> texCache;
-	struct StringTexture* getTexTexture(const QString& str, int pixelSize) const;
+	//! Add the glyphs of a string to the pending glyph quads, see drawText().
+	void drawTextWithAtlas(float x, float y, const QString& str, float angleDeg, float xshift, float yshift);
+	//! Draw the pending glyph quads, with one draw call per page of the glyph atlas.
+	void flushText();
+
+	//! Glyph quads waiting to be drawn, for one page of the glyph atlas
+	struct GlyphBatch
+	{
+		QVector<Vec2f> vertices;
+		QVector<Vec2f> texCoords;
+		QVector<Vec4f> colors;
+	};
+	//! The pending glyph quads by page. Static as there is only one StelPainter at a time, to reuse the memory.
+	static QVector<GlyphBatch> glyphBatches;
+	static int pendingGlyphs;
+	static class StelTextShaper* textShaper;
+	static class StelGlyphAtlas* glyphAtlas;
+	//! Whether drawText() uses the glyph atlas instead of QPainter
+	static bool useGlyphAtlas;
 
 	//! Struct describing one opengl array
 	typedef struct ArrayDesc
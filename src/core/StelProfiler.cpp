@@ -0,0 +1,481 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelProfiler.hpp"
+#include "StelApp.hpp"
+#include "StelCore.hpp"
+#include "StelFileMgr.hpp"
+#include "StelPainter.hpp"
+#include "StelProjector.hpp"
+
+#include <algorithm>
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QOpenGLContext>
+#include <QOpenGLTimerQuery>
+#include <QThread>
+
+// Number of frames whose GPU timers may be pending before waiting for their results
+static const int MAX_PENDING_GPU_FRAMES = 4;
+// Frames between updates of the overlay text
+static const int OVERLAY_UPDATE_FRAMES = 30;
+
+QAtomicPointer<StelProfiler> StelProfiler::active;
+
+StelProfiler* StelProfiler::Scope::getProfiler()
+{
+	StelProfiler* profiler = StelProfiler::active.load();
+	if (profiler && QThread::currentThread()!=profiler->thread())
+		return Q_NULLPTR;
+	return profiler;
+}
+
+StelProfiler::Scope::Scope(const char* name, bool gpu)
+	: profiler(getProfiler())
+{
+	if (profiler)
+		profiler->push(QLatin1String(name), gpu);
+}
+
+StelProfiler::Scope::Scope(const QString& name, bool gpu)
+	: profiler(getProfiler())
+{
+	if (profiler)
+		profiler->push(name, gpu);
+}
+
+StelProfiler::Scope::~Scope()
+{
+	if (profiler)
+		profiler->pop();
+}
+
+StelProfiler::StelProfiler(QObject* parent)
+	: QObject(parent)
+	, enabled(false)
+	, gpuTimers(false)
+	, gpuTimersSupported(false)
+	, overlay(false)
+	, inFrame(false)
+	, historyPos(0)
+	, historyCount(0)
+	, traceFramesLeft(0)
+{
+	setObjectName("StelProfiler");
+	clock.start();
+	reset();
+}
+
+StelProfiler::~StelProfiler()
+{
+	active.testAndSetOrdered(this, Q_NULLPTR);
+}
+
+void StelProfiler::reset()
+{
+	// The queries of pending samples are reused without reading their results
+	for (const auto& frame : gpuPending)
+		for (const auto& s : frame)
+			queryPool << s.begin << s.end;
+	for (const auto& s : gpuSamples)
+	{
+		queryPool << s.begin;
+		if (s.end)
+			queryPool << s.end;
+	}
+	gpuPending.clear();
+	gpuSamples.clear();
+
+	nodes.clear();
+	stack.clear();
+	inFrame = false;
+	historyPos = 0;
+	historyCount = 0;
+	overlayLines.clear();
+
+	// Virtual root holding the top level scopes
+	Node root;
+	root.parent = -1;
+	root.depth = -1;
+	root.frameNs = 0;
+	root.frameCalls = 0;
+	root.gpuPos = 0;
+	root.gpuCount = 0;
+	nodes.append(root);
+}
+
+int StelProfiler::getChild(int parent, const QString& name)
+{
+	auto it = nodes[parent].children.constFind(name);
+	if (it!=nodes[parent].children.constEnd())
+		return it.value();
+
+	Node n;
+	n.name = name;
+	n.parent = parent;
+	n.depth = nodes[parent].depth+1;
+	n.frameNs = 0;
+	n.frameCalls = 0;
+	n.cpuMs.fill(0.f, HistorySize);
+	n.calls.fill(0, HistorySize);
+	n.gpuMs.fill(0.f, HistorySize);
+	n.gpuPos = 0;
+	n.gpuCount = 0;
+	nodes.append(n);
+	const int idx = nodes.size()-1;
+	nodes[parent].children.insert(name, idx);
+	return idx;
+}
+
+QString StelProfiler::getPath(int node) const
+{
+	QStringList names;
+	for (int i=node; i>0; i=nodes[i].parent)
+		names.prepend(nodes[i].name);
+	return names.join('/');
+}
+
+QOpenGLTimerQuery* StelProfiler::takeQuery()
+{
+	if (!queryPool.isEmpty())
+		return queryPool.takeLast();
+	QOpenGLTimerQuery* q = new QOpenGLTimerQuery(this);
+	q->create();
+	return q;
+}
+
+void StelProfiler::push(const QString& name, bool gpu)
+{
+	StackEntry e;
+	e.node = getChild(stack.isEmpty() ? 0 : stack.last().node, name);
+	e.gpuSample = -1;
+	if (gpu && gpuTimers && gpuTimersSupported)
+	{
+		GpuSample s;
+		s.node = e.node;
+		s.begin = takeQuery();
+		s.end = Q_NULLPTR;
+		s.begin->recordTimestamp();
+		gpuSamples.append(s);
+		e.gpuSample = gpuSamples.size()-1;
+	}
+	e.startNs = clock.nsecsElapsed();
+	stack.append(e);
+}
+
+void StelProfiler::pop()
+{
+	// The profiler may have been reset while the scope was open
+	if (stack.isEmpty())
+		return;
+	const StackEntry e = stack.takeLast();
+	const qint64 duration = clock.nsecsElapsed() - e.startNs;
+	Node& n = nodes[e.node];
+	n.frameNs += duration;
+	++n.frameCalls;
+	if (e.gpuSample>=0)
+	{
+		GpuSample& s = gpuSamples[e.gpuSample];
+		s.end = takeQuery();
+		s.end->recordTimestamp();
+	}
+	if (traceFramesLeft>0)
+	{
+		TraceEvent t;
+		t.node = e.node;
+		t.startNs = e.startNs;
+		t.durationNs = duration;
+		traceEvents.append(t);
+	}
+}
+
+void StelProfiler::beginFrame()
+{
+	if (!enabled)
+		return;
+	if (inFrame)
+		endFrame();
+
+	if (gpuTimers && !gpuTimersSupported && QOpenGLContext::currentContext())
+	{
+		QOpenGLTimerQuery probe;
+		gpuTimersSupported = probe.create();
+		if (!gpuTimersSupported)
+		{
+			qWarning() << "StelProfiler: OpenGL timer queries are not supported, GPU timers disabled";
+			setFlagGpuTimers(false);
+		}
+	}
+
+	inFrame = true;
+	push("Frame", true);
+}
+
+void StelProfiler::endFrame()
+{
+	if (!enabled || !inFrame)
+		return;
+	Q_ASSERT(stack.size()==1);
+	pop();
+	inFrame = false;
+
+	for (auto& n : nodes)
+	{
+		if (n.cpuMs.isEmpty())
+			continue;
+		n.cpuMs[historyPos] = static_cast<float>(n.frameNs*1e-6);
+		n.calls[historyPos] = n.frameCalls;
+		n.frameNs = 0;
+		n.frameCalls = 0;
+	}
+	historyPos = (historyPos+1) % HistorySize;
+	historyCount = qMin(historyCount+1, static_cast<int>(HistorySize));
+
+	if (!gpuSamples.isEmpty())
+	{
+		gpuPending.append(gpuSamples);
+		gpuSamples.clear();
+	}
+	if (!gpuPending.isEmpty())
+		collectGpuSamples(gpuPending.size()>MAX_PENDING_GPU_FRAMES);
+
+	if (traceFramesLeft>0 && --traceFramesLeft==0)
+		writeTrace();
+
+	if (overlay && (historyPos % OVERLAY_UPDATE_FRAMES==0 || overlayLines.isEmpty()))
+	{
+		overlayLines.clear();
+		const QVariantList scopes = getStatistics().value("scopes").toList();
+		for (const auto& v : scopes)
+		{
+			const QVariantMap s = v.toMap();
+			const int depth = s.value("depth").toInt();
+			const double mean = s.value("mean").toDouble();
+			if (depth>2 || (depth>0 && mean<0.05))
+				continue;
+			QString line = QString("%1%2: %3 ms (max %4)").arg(QString(2*depth, ' '), s.value("name").toString())
+					.arg(mean, 0, 'f', 2).arg(s.value("max").toDouble(), 0, 'f', 2);
+			if (s.contains("gpuMean"))
+				line += QString(", GPU %1 ms").arg(s.value("gpuMean").toDouble(), 0, 'f', 2);
+			overlayLines << line;
+		}
+	}
+}
+
+void StelProfiler::collectGpuSamples(bool wait)
+{
+	while (!gpuPending.isEmpty())
+	{
+		const QVector<GpuSample>& frame = gpuPending.first();
+		// Timestamps complete in order, so the last one is available when all are
+		if (!wait && !frame.last().end->isResultAvailable())
+			break;
+
+		QHash<int, qint64> totals;
+		for (const auto& s : frame)
+		{
+			totals[s.node] += static_cast<qint64>(s.end->waitForResult() - s.begin->waitForResult());
+			queryPool << s.begin << s.end;
+		}
+		for (auto it=totals.constBegin(); it!=totals.constEnd(); ++it)
+		{
+			Node& n = nodes[it.key()];
+			n.gpuMs[n.gpuPos] = static_cast<float>(it.value()*1e-6);
+			n.gpuPos = (n.gpuPos+1) % HistorySize;
+			n.gpuCount = qMin(n.gpuCount+1, static_cast<int>(HistorySize));
+		}
+		gpuPending.removeFirst();
+		wait = false;
+	}
+}
+
+void StelProfiler::setFlagEnabled(bool b)
+{
+	if (b==enabled)
+		return;
+	enabled = b;
+	reset();
+	if (b)
+		active.store(this);
+	else
+	{
+		active.testAndSetOrdered(this, Q_NULLPTR);
+		traceFramesLeft = 0;
+		traceEvents.clear();
+		if (overlay)
+		{
+			overlay = false;
+			emit flagOverlayChanged(false);
+		}
+	}
+	emit flagEnabledChanged(b);
+}
+
+void StelProfiler::setFlagGpuTimers(bool b)
+{
+	if (b==gpuTimers)
+		return;
+	gpuTimers = b;
+	emit flagGpuTimersChanged(b);
+}
+
+void StelProfiler::setFlagOverlay(bool b)
+{
+	if (b==overlay)
+		return;
+	if (b)
+		setFlagEnabled(true);
+	overlay = b;
+	overlayLines.clear();
+	emit flagOverlayChanged(b);
+}
+
+QVariantMap StelProfiler::getStatistics() const
+{
+	QVariantMap map;
+	QVariantList scopes;
+	map["frames"] = historyCount;
+
+	// Depth-first, children in order of creation
+	QVector<int> todo;
+	for (int i=nodes.size()-1; i>0; --i)
+		if (nodes[i].parent==0)
+			todo.append(i);
+	QVector<float> values;
+	while (!todo.isEmpty())
+	{
+		const int idx = todo.takeLast();
+		const Node& n = nodes[idx];
+		for (int i=nodes.size()-1; i>idx; --i)
+			if (nodes[i].parent==idx)
+				todo.append(i);
+		if (historyCount==0)
+			continue;
+
+		// The history is full, or filled from index 0
+		values = n.cpuMs.mid(0, historyCount);
+		double sum = 0.;
+		int calls = 0;
+		for (int i=0; i<historyCount; ++i)
+		{
+			sum += static_cast<double>(values[i]);
+			calls += n.calls[i];
+		}
+		std::sort(values.begin(), values.end());
+
+		QVariantMap s;
+		s["path"] = getPath(idx);
+		s["name"] = n.name;
+		s["depth"] = n.depth;
+		s["calls"] = static_cast<double>(calls)/historyCount;
+		s["mean"] = sum/historyCount;
+		s["min"] = static_cast<double>(values.first());
+		s["max"] = static_cast<double>(values.last());
+		s["p95"] = static_cast<double>(values[qMin(historyCount-1, historyCount*95/100)]);
+		if (n.gpuCount>0)
+		{
+			double gpuSum = 0., gpuMax = 0.;
+			for (int i=0; i<n.gpuCount; ++i)
+			{
+				gpuSum += static_cast<double>(n.gpuMs[i]);
+				gpuMax = qMax(gpuMax, static_cast<double>(n.gpuMs[i]));
+			}
+			s["gpuMean"] = gpuSum/n.gpuCount;
+			s["gpuMax"] = gpuMax;
+		}
+		scopes.append(s);
+	}
+	map["scopes"] = scopes;
+	return map;
+}
+
+void StelProfiler::startTrace(int frames, const QString& fileName)
+{
+	if (frames<=0)
+		return;
+	setFlagEnabled(true);
+	if (fileName.isEmpty())
+		traceFileName = StelFileMgr::getUserDir() + "/trace.json";
+	else if (QDir::isRelativePath(fileName))
+		traceFileName = StelFileMgr::getUserDir() + "/" + fileName;
+	else
+		traceFileName = fileName;
+	traceEvents.clear();
+	traceFramesLeft = frames;
+}
+
+void StelProfiler::writeTrace()
+{
+	QJsonArray events;
+	for (const auto& t : traceEvents)
+	{
+		QJsonObject e;
+		e["name"] = nodes[t.node].name;
+		e["cat"] = nodes[t.node].depth<=1 ? "frame" : "scope";
+		e["ph"] = "X";
+		e["ts"] = t.startNs*1e-3;
+		e["dur"] = t.durationNs*1e-3;
+		e["pid"] = 1;
+		e["tid"] = 1;
+		events.append(e);
+	}
+	traceEvents.clear();
+
+	QJsonObject root;
+	root["traceEvents"] = events;
+	root["displayTimeUnit"] = "ms";
+
+	QFile file(traceFileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qWarning() << "StelProfiler: cannot write trace to" << QDir::toNativeSeparators(traceFileName);
+		return;
+	}
+	file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+	file.close();
+	qDebug() << "StelProfiler: wrote" << events.size() << "trace events to" << QDir::toNativeSeparators(traceFileName);
+	emit traceWritten(traceFileName);
+}
+
+void StelProfiler::drawOverlay(StelCore* core)
+{
+	if (!overlay || overlayLines.isEmpty())
+		return;
+
+	const StelProjectorP prj = core->getProjection2d();
+	StelPainter sPainter(prj);
+	QFont font;
+	font.setPixelSize(StelApp::getInstance().getScreenFontSize());
+	sPainter.setFont(font);
+	sPainter.setColor(1.f, 1.f, 0.f, 0.9f);
+	sPainter.setBlending(true);
+
+	const float lineHeight = 1.2f*font.pixelSize();
+	float y = prj->getViewportHeight() - 2.f*lineHeight;
+	for (const auto& line : overlayLines)
+	{
+		sPainter.drawText(10.f, y, line);
+		y -= lineHeight;
+	}
+}
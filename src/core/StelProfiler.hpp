@@ -0,0 +1,199 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef STELPROFILER_HPP
+#define STELPROFILER_HPP
+
+#include <QAtomicPointer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+class StelCore;
+class QOpenGLTimerQuery;
+
+//! @class StelProfiler
+//! A hierarchical frame profiler for the main thread.
+//! Code is timed by creating a StelProfiler::Scope on the stack. Scopes opened while another one is open become its
+//! children, so the same function called from different places is accounted separately. StelApp opens a scope for
+//! the whole frame, for StelApp::update and StelApp::draw, and for the update and draw of each module; modules can
+//! add their own scopes in their hot functions:
+//! @code
+//! StelProfiler::Scope scope("StarMgr::prepareDraw");
+//! @endcode
+//! When the profiler is disabled, a scope only tests a pointer. Scopes created on other threads are ignored.
+//!
+//! For each scope the time spent in it per frame is kept for the last HistorySize frames, from which
+//! getStatistics() computes the mean, minimum, maximum and 95th percentile. Scopes opened with gpu=true can also
+//! be timed on the GPU with OpenGL timer queries, which are read back a few frames later to avoid stalls.
+//! startTrace() records every scope of the next frames and writes them as a Chrome trace (chrome://tracing).
+class StelProfiler : public QObject
+{
+	Q_OBJECT
+	Q_PROPERTY(bool enabled READ getFlagEnabled WRITE setFlagEnabled NOTIFY flagEnabledChanged)
+	Q_PROPERTY(bool gpuTimers READ getFlagGpuTimers WRITE setFlagGpuTimers NOTIFY flagGpuTimersChanged)
+	Q_PROPERTY(bool overlay READ getFlagOverlay WRITE setFlagOverlay NOTIFY flagOverlayChanged)
+
+public:
+	//! Number of frames of the rolling history.
+	static const int HistorySize = 240;
+
+	//! Times the code from its creation to its destruction as a child of the innermost open scope.
+	class Scope
+	{
+	public:
+		//! @param name the name of the scope, e.g. a function name. It is only converted to a QString
+		//! when the profiler is enabled, so string literals cost nothing while it is disabled.
+		//! @param gpu also time the OpenGL commands issued in the scope, if GPU timers are enabled.
+		explicit Scope(const char* name, bool gpu=false);
+		//! @param name the name of the scope, e.g. the name of a module.
+		//! @param gpu also time the OpenGL commands issued in the scope, if GPU timers are enabled.
+		explicit Scope(const QString& name, bool gpu=false);
+		~Scope();
+	private:
+		//! The active profiler if called from its thread, else null.
+		static StelProfiler* getProfiler();
+		StelProfiler* profiler;
+		Q_DISABLE_COPY(Scope)
+	};
+
+	explicit StelProfiler(QObject* parent=Q_NULLPTR);
+	~StelProfiler();
+
+	//! Start a frame. Called by StelApp before the update of the modules.
+	void beginFrame();
+	//! End the current frame, store its times in the history and process the GPU timers and the trace.
+	//! Called by StelApp after drawing the modules, with the OpenGL context current.
+	void endFrame();
+
+	//! Draw the mean times of the top levels of scopes in the upper left corner of the view.
+	void drawOverlay(StelCore* core);
+
+public slots:
+	bool getFlagEnabled() const {return enabled;}
+	//! Enable or disable the profiler. Disabling clears the history.
+	void setFlagEnabled(bool b);
+
+	bool getFlagGpuTimers() const {return gpuTimers;}
+	//! Enable or disable GPU timing of the scopes opened with gpu=true.
+	//! It is ignored if the OpenGL context does not support timer queries.
+	void setFlagGpuTimers(bool b);
+
+	bool getFlagOverlay() const {return overlay;}
+	//! Show the timing overlay. This also enables the profiler.
+	void setFlagOverlay(bool b);
+
+	//! Get the statistics of all scopes over the frames in the history.
+	//! @return a map with the number of frames ("frames") and the list of scopes ("scopes") in depth-first order.
+	//! Each scope is a map with its "path" (names of the parent scopes and its own separated by "/"), "name",
+	//! "depth", mean "calls" per frame and its CPU time per frame in ms: "mean", "min", "max" and "p95". Scopes
+	//! timed on the GPU also have "gpuMean" and "gpuMax".
+	QVariantMap getStatistics() const;
+
+	//! Record the next frames and write them to a Chrome trace JSON file.
+	//! This also enables the profiler.
+	//! @param frames the number of frames to record.
+	//! @param fileName the output file. Relative paths are relative to the user directory.
+	//! The default is trace.json in the user directory.
+	void startTrace(int frames, const QString& fileName=QString());
+
+signals:
+	void flagEnabledChanged(bool b);
+	void flagGpuTimersChanged(bool b);
+	void flagOverlayChanged(bool b);
+	//! Emitted when a trace was written.
+	void traceWritten(const QString& fileName);
+
+private:
+	struct Node
+	{
+		QString name;
+		int parent;
+		int depth;
+		QHash<QString, int> children;
+		qint64 frameNs;          //!< time spent in the current frame
+		int frameCalls;          //!< calls in the current frame
+		QVector<float> cpuMs;    //!< ring buffer of the time per frame, indexed like the history
+		QVector<int> calls;      //!< ring buffer of the calls per frame
+		QVector<float> gpuMs;    //!< ring buffer of the GPU time per frame, in the order the results arrive
+		int gpuPos;
+		int gpuCount;
+	};
+
+	struct StackEntry
+	{
+		int node;
+		qint64 startNs;
+		int gpuSample;           //!< index in gpuSamples, or -1
+	};
+
+	struct GpuSample
+	{
+		int node;
+		QOpenGLTimerQuery* begin;
+		QOpenGLTimerQuery* end;
+	};
+
+	struct TraceEvent
+	{
+		int node;
+		qint64 startNs;
+		qint64 durationNs;
+	};
+
+	void push(const QString& name, bool gpu);
+	void pop();
+	int getChild(int parent, const QString& name);
+	QString getPath(int node) const;
+	void reset();
+	//! Accumulate the GPU times of the frames whose timer results are available.
+	void collectGpuSamples(bool wait);
+	QOpenGLTimerQuery* takeQuery();
+	void writeTrace();
+
+	//! The profiler which scopes report to, null if disabled.
+	static QAtomicPointer<StelProfiler> active;
+
+	bool enabled;
+	bool gpuTimers;
+	bool gpuTimersSupported;
+	bool overlay;
+	bool inFrame;
+
+	QElapsedTimer clock;
+	QVector<Node> nodes;
+	QVector<StackEntry> stack;
+	int historyPos;
+	int historyCount;
+
+	QVector<GpuSample> gpuSamples;              //!< samples of the current frame
+	QVector<QVector<GpuSample>> gpuPending;     //!< samples of previous frames waiting for their results
+	QVector<QOpenGLTimerQuery*> queryPool;
+
+	int traceFramesLeft;
+	QString traceFileName;
+	QVector<TraceEvent> traceEvents;
+
+	QStringList overlayLines;
+};
+
+#endif // STELPROFILER_HPP
@@ -25,6 +25,8 @@
 
 #include <QDebug>
 #include <QString>
+#include <algorithm>
+#include <typeinfo>
 
 StelProjector::Mat4dTransform::Mat4dTransform(const Mat4d& m)
     : transfoMat(m),
@@ -70,6 +72,31 @@ void StelProjector::Mat4dTransform::backward(Vec3f& v) const
 	v[2] = transfoMatf.r[8]*x + transfoMatf.r[9]*y + transfoMatf.r[10]*z;
 }
 
+void StelProjector::ModelViewTranform::forward(int n, float* x, float* y, float* z) const
+{
+	Vec3f v;
+	for (int i = 0; i < n; ++i)
+	{
+		v.set(x[i], y[i], z[i]);
+		forward(v);
+		x[i] = v[0];
+		y[i] = v[1];
+		z[i] = v[2];
+	}
+}
+
+void StelProjector::Mat4dTransform::forward(int n, float* x, float* y, float* z) const
+{
+	const float* m = transfoMatf.r;
+	for (int i = 0; i < n; ++i)
+	{
+		const float vx = x[i], vy = y[i], vz = z[i];
+		x[i] = m[0]*vx + m[4]*vy + m[8]*vz + m[12];
+		y[i] = m[1]*vx + m[5]*vy + m[9]*vz + m[13];
+		z[i] = m[2]*vx + m[6]*vy + m[10]*vz + m[14];
+	}
+}
+
 void StelProjector::Mat4dTransform::combine(const Mat4d& m)
 {
 	Mat4f mf(static_cast<float>(m[0]),  static_cast<float>(m[1]) ,  static_cast<float>(m[2]),  static_cast<float>(m[3]),
@@ -336,6 +363,38 @@ void StelProjector::project(int n, const Vec3f* in, Vec3f* out)
 	}
 }
 
+void StelProjector::forward(int n, float* x, float* y, float* z, quint8* valid) const
+{
+	Vec3f v;
+	for (int i = 0; i < n; ++i)
+	{
+		v.set(x[i], y[i], z[i]);
+		valid[i] = forward(v) ? 1 : 0;
+		x[i] = v[0];
+		y[i] = v[1];
+		z[i] = v[2];
+	}
+}
+
+void StelProjector::project(int n, float* x, float* y, float* z, quint8* valid) const
+{
+	modelViewTransform->forward(n, x, y, z);
+	forward(n, x, y, z, valid);
+	// As in projectInPlace(), finish reprojecting even the invalid points.
+	const float cx = static_cast<float>(viewportCenter[0]);
+	const float cy = static_cast<float>(viewportCenter[1]);
+	const float sx = flipHorz * pixelPerRad;
+	const float sy = flipVert * pixelPerRad;
+	const float zn = static_cast<float>(zNear);
+	const float zf = static_cast<float>(oneOverZNearMinusZFar);
+	for (int i = 0; i < n; ++i)
+	{
+		x[i] = cx + sx * x[i];
+		y[i] = cy + sy * y[i];
+		z[i] = (z[i] - zn) * zf;
+	}
+}
+
 bool StelProjector::projectInPlace(Vec3d& vd) const
 {
 	modelViewTransform->forward(vd);
@@ -480,6 +539,17 @@ Mat4f StelProjector::getProjectionMatrix() const
 	return Mat4f(2.f/viewportXywh[2], 0, 0, 0, 0, 2.f/viewportXywh[3], 0, 0, 0, 0, -1., 0., -(2.f*viewportXywh[0] + viewportXywh[2])/viewportXywh[2], -(2.f*viewportXywh[1] + viewportXywh[3])/viewportXywh[3], 0, 1);
 }
 
+bool StelProjector::hasSameView(const StelProjector& other) const
+{
+	if (typeid(*this)!=typeid(other) || viewportXywh!=other.viewportXywh || viewportCenter!=other.viewportCenter
+			|| flipHorz!=other.flipHorz || flipVert!=other.flipVert || pixelPerRad!=other.pixelPerRad
+			|| widthStretch!=other.widthStretch)
+		return false;
+	const Mat4d m1 = modelViewTransform->getApproximateLinearTransfo();
+	const Mat4d m2 = other.modelViewTransform->getApproximateLinearTransfo();
+	return std::equal(static_cast<const double*>(m1), static_cast<const double*>(m1)+16, static_cast<const double*>(m2));
+}
+
 StelProjector::StelProjectorMaskType StelProjector::getMaskType(void) const
 {
 	return maskType;
@@ -39,6 +39,8 @@ class StelProjector
 public:
 	friend class StelPainter;
 	friend class StelCore;
+	friend class StelSkyDrawer;
+	friend class TestStarBatch;
 
 	class ModelViewTranform;
 	//! @typedef ModelViewTranformP
@@ -56,6 +58,9 @@ public:
 		virtual void backward(Vec3d&) const =0;
 		virtual void forward(Vec3f&) const =0;
 		virtual void backward(Vec3f&) const =0;
+		//! Apply the transformation in place to n vectors stored as structure of arrays.
+		//! The default implementation calls forward(Vec3f&) for each vector.
+		virtual void forward(int n, float* x, float* y, float* z) const;
 
 		virtual void combine(const Mat4d&)=0;
 		virtual ModelViewTranformP clone() const=0;
@@ -71,6 +76,7 @@ public:
         void backward(Vec3d& v) const;
         void forward(Vec3f& v) const;
         void backward(Vec3f& v) const;
+        void forward(int n, float* x, float* y, float* z) const;
         void combine(const Mat4d& m);
         Mat4d getApproximateLinearTransfo() const;
         ModelViewTranformP clone() const;
@@ -89,6 +95,18 @@ public:
 		MaskDisk	//!< For disk viewport mode (circular mask to seem like bins/telescope)
 	};
 
+	//! @enum ShaderProjection
+	//! The projections which the vertex shaders of StelSkyDrawer can compute on the GPU.
+	enum ShaderProjection
+	{
+		ShaderProjectionNone,		//!< The projection can only be computed on the CPU.
+		ShaderProjectionPerspective,
+		ShaderProjectionEqualArea,
+		ShaderProjectionStereographic,
+		ShaderProjectionFisheye,
+		ShaderProjectionOrthographic
+	};
+
 	//! @struct StelProjectorParams
 	//! Contains all the param needed to initialize a StelProjector
 	struct StelProjectorParams
@@ -144,8 +162,16 @@ public:
 	//! But then far away objects are not textured any more, perhaps because of a depth buffer overflow although
 	//! the depth test is disabled?
 	virtual bool forward(Vec3f& v) const = 0;
+	//! Apply the transformation in the forward direction in place to n vectors stored as structure of arrays.
+	//! The default implementation calls forward(Vec3f&) for each vector. The projections override it with
+	//! branch-free loops over plain float arrays, which the compiler can vectorize.
+	//! @param valid receives for each vector the value forward(Vec3f&) would have returned, as 1 or 0.
+	virtual void forward(int n, float* x, float* y, float* z, quint8* valid) const;
 	//! Apply the transformation in the backward projection in place.
 	virtual bool backward(Vec3d& v) const = 0;
+	//! Return which of the projections a vertex shader can compute with the same results as forward(),
+	//! or ShaderProjectionNone if the projection must be computed on the CPU.
+	virtual ShaderProjection getShaderProjection() const {return ShaderProjectionNone;}
 	//! Return the small zoom increment to use at the given FOV for nice movements
 	virtual float deltaZoom(float fov) const = 0;
 
@@ -233,6 +259,12 @@ public:
 
 	virtual void project(int n, const Vec3f* in, Vec3f* out);
 
+	//! Project n vectors stored as structure of arrays from the current frame into the viewport, in place.
+	//! This is the batch version of projectInPlace(Vec3f&) for large numbers of points like stars.
+	//! @param x, y, z the coordinates of the vectors in the current frame, replaced by the projected coordinates.
+	//! @param valid receives for each vector 1 if its projected coordinate is valid, 0 otherwise.
+	void project(int n, float* x, float* y, float* z, quint8* valid) const;
+
 	//! Project the vector v from the current frame into the viewport.
 	//! @param vd the vector in the current frame.
 	//! @return true if the projected coordinate is valid.
@@ -276,6 +308,12 @@ public:
 	//! Get the current projection matrix.
 	Mat4f getProjectionMatrix() const;
 
+	//! Return whether unProject() gives the same results for this projector and another one, i.e. if they have the
+	//! same projection type, viewport and parameters and the same model view matrix. Only the linear part of the model
+	//! view transforms is compared, so use it with projectors without refraction.
+	//! This allows to keep data computed for a view as long as the view doesn't change.
+	bool hasSameView(const StelProjector& other) const;
+
 	///////////////////////////////////////////////////////////////////////////
 	//! Get a string description of a StelProjectorMaskType.
 	static const QString maskTypeToString(StelProjectorMaskType type);
@@ -53,6 +53,22 @@ bool StelProjectorPerspective::forward(Vec3f &v) const
 	return false;
 }
 
+void StelProjectorPerspective::forward(int n, float* x, float* y, float* z, quint8* valid) const
+{
+	const float ws = static_cast<float>(widthStretch);
+	for (int i = 0; i < n; ++i)
+	{
+		const float vx = x[i], vy = y[i], vz = z[i];
+		const float r = std::sqrt(vx*vx + vy*vy + vz*vz);
+		const float az = std::fabs(vz);
+		const bool inFront = vz < 0.f;
+		x[i] = vz != 0.f ? vx*ws/az : std::numeric_limits<float>::max();
+		y[i] = vz != 0.f ? vy/az : std::numeric_limits<float>::max();
+		z[i] = inFront ? r : -std::numeric_limits<float>::max();
+		valid[i] = inFront;
+	}
+}
+
 bool StelProjectorPerspective::backward(Vec3d &v) const
 {
 	v[0] /= static_cast<double>(widthStretch);
@@ -102,6 +118,21 @@ bool StelProjectorEqualArea::forward(Vec3f &v) const
 	return true;
 }
 
+void StelProjectorEqualArea::forward(int n, float* x, float* y, float* z, quint8* valid) const
+{
+	const float ws = static_cast<float>(widthStretch);
+	for (int i = 0; i < n; ++i)
+	{
+		const float vx = x[i], vy = y[i], vz = z[i];
+		const float r = std::sqrt(vx*vx + vy*vy + vz*vz);
+		const float f = std::sqrt(2.f/(r*(r-vz)));
+		x[i] = vx*f*ws;
+		y[i] = vy*f;
+		z[i] = r;
+		valid[i] = 1;
+	}
+}
+
 bool StelProjectorEqualArea::backward(Vec3d &v) const
 {
 	v[0] /= static_cast<double>(widthStretch);
@@ -167,6 +198,23 @@ bool StelProjectorStereographic::forward(Vec3f &v) const
 	return true;
 }
 
+void StelProjectorStereographic::forward(int n, float* x, float* y, float* z, quint8* valid) const
+{
+	const float ws = static_cast<float>(widthStretch);
+	for (int i = 0; i < n; ++i)
+	{
+		const float vx = x[i], vy = y[i], vz = z[i];
+		const float r = std::sqrt(vx*vx + vy*vy + vz*vz);
+		const float h = 0.5f*(r-vz);
+		const bool ok = h > 0.f;
+		const float f = 1.f / h;
+		x[i] = ok ? vx*f*ws : std::numeric_limits<float>::max();
+		y[i] = ok ? vy*f : std::numeric_limits<float>::max();
+		z[i] = ok ? r : -std::numeric_limits<float>::min();
+		valid[i] = ok;
+	}
+}
+
 bool StelProjectorStereographic::backward(Vec3d &v) const
 {
 	v[0] /= static_cast<double>(widthStretch);
@@ -228,6 +276,24 @@ bool StelProjectorFisheye::forward(Vec3f &v) const
 	return false;
 }
 
+void StelProjectorFisheye::forward(int n, float* x, float* y, float* z, quint8* valid) const
+{
+	const float ws = static_cast<float>(widthStretch);
+	for (int i = 0; i < n; ++i)
+	{
+		const float vx = x[i], vy = y[i], vz = z[i];
+		const float rq1 = vx*vx + vy*vy;
+		const float h = std::sqrt(rq1);
+		const float f = std::atan2(h,-vz) / h;
+		const bool offAxis = rq1 > 0.f;
+		const bool inFront = vz < 0.f;
+		x[i] = offAxis ? vx*f*ws : (inFront ? 0.f : std::numeric_limits<float>::max());
+		y[i] = offAxis ? vy*f : (inFront ? 0.f : std::numeric_limits<float>::max());
+		z[i] = offAxis ? std::sqrt(rq1 + vz*vz) : (inFront ? 1.f : std::numeric_limits<float>::min());
+		valid[i] = offAxis || inFront;
+	}
+}
+
 bool StelProjectorFisheye::backward(Vec3d &v) const
 {
 	v[0] /= static_cast<double>(widthStretch);
@@ -279,6 +345,22 @@ bool StelProjectorHammer::forward(Vec3f &v) const
 	return true;
 }
 
+void StelProjectorHammer::forward(int n, float* x, float* y, float* z, quint8* valid) const
+{
+	for (int i = 0; i < n; ++i)
+	{
+		const float vx = x[i], vy = y[i], vz = z[i];
+		const float r = std::sqrt(vx*vx + vy*vy + vz*vz);
+		const float alpha = std::atan2(vx,-vz);
+		const float cosDelta = std::sqrt(1.f-vy*vy/(r*r));
+		const float h = std::sqrt(1.f+cosDelta*std::cos(alpha/2.f));
+		x[i] = 2.f*static_cast<float>(M_SQRT2)*cosDelta*std::sin(alpha/2.f)/h * widthStretch;
+		y[i] = static_cast<float>(M_SQRT2)*vy/r/h;
+		z[i] = r;
+		valid[i] = 1;
+	}
+}
+
 bool StelProjectorHammer::backward(Vec3d &v) const
 {
 	v[0] /= static_cast<double>(widthStretch);
@@ -333,6 +415,20 @@ bool StelProjectorCylinder::forward(Vec3f &v) const
 	return rval;
 }
 
+void StelProjectorCylinder::forward(int n, float* x, float* y, float* z, quint8* valid) const
+{
+	const float ws = static_cast<float>(widthStretch);
+	for (int i = 0; i < n; ++i)
+	{
+		const float vx = x[i], vy = y[i], vz = z[i];
+		const float r = std::sqrt(vx*vx + vy*vy + vz*vz);
+		valid[i] = (-r < vy && vy < r);
+		x[i] = std::atan2(vx,-vz)*ws;
+		y[i] = std::asin(vy/r);
+		z[i] = r;
+	}
+}
+
 bool StelProjectorCylinder::backward(Vec3d &v) const
 {
 	v[0] /= static_cast<double>(widthStretch);
@@ -381,6 +477,21 @@ bool StelProjectorMercator::forward(Vec3f &v) const
 	return rval;
 }
 
+void StelProjectorMercator::forward(int n, float* x, float* y, float* z, quint8* valid) const
+{
+	const float ws = static_cast<float>(widthStretch);
+	for (int i = 0; i < n; ++i)
+	{
+		const float vx = x[i], vy = y[i], vz = z[i];
+		const float r = std::sqrt(vx*vx + vy*vy + vz*vz);
+		const float sin_delta = vy/r;
+		valid[i] = (-r < vy && vy < r);
+		x[i] = std::atan2(vx,-vz)*ws;
+		y[i] = 0.5f*std::log((1.f+sin_delta)/(1.f-sin_delta));
+		z[i] = r;
+	}
+}
+
 
 bool StelProjectorMercator::backward(Vec3d &v) const
 {
@@ -434,6 +545,21 @@ bool StelProjectorOrthographic::forward(Vec3f &v) const
 	return rval;
 }
 
+void StelProjectorOrthographic::forward(int n, float* x, float* y, float* z, quint8* valid) const
+{
+	const float ws = static_cast<float>(widthStretch);
+	for (int i = 0; i < n; ++i)
+	{
+		const float vx = x[i], vy = y[i], vz = z[i];
+		const float r = std::sqrt(vx*vx + vy*vy + vz*vz);
+		const float h = 1.f/r;
+		x[i] = vx*h*ws;
+		y[i] = vy*h;
+		z[i] = r;
+		valid[i] = (vz <= 0.f);
+	}
+}
+
 bool StelProjectorOrthographic::backward(Vec3d &v) const
 {
 	v[0] /= static_cast<double>(widthStretch);
@@ -487,6 +613,21 @@ bool StelProjectorSinusoidal::forward(Vec3f &v) const
 	return rval;
 }
 
+void StelProjectorSinusoidal::forward(int n, float* x, float* y, float* z, quint8* valid) const
+{
+	const float ws = static_cast<float>(widthStretch);
+	for (int i = 0; i < n; ++i)
+	{
+		const float vx = x[i], vy = y[i], vz = z[i];
+		const float r = std::sqrt(vx*vx + vy*vy + vz*vz);
+		const float delta = std::asin(vy/r);
+		valid[i] = (-r < vy && vy < r);
+		x[i] = std::atan2(vx,-vz)*std::cos(delta)*ws;
+		y[i] = delta;
+		z[i] = r;
+	}
+}
+
 bool StelProjectorSinusoidal::backward(Vec3d &v) const
 {
 	v[0] /= static_cast<double>(widthStretch);
@@ -529,6 +670,21 @@ bool StelProjectorMiller::forward(Vec3f &v) const
 	return rval;
 }
 
+void StelProjectorMiller::forward(int n, float* x, float* y, float* z, quint8* valid) const
+{
+	const float ws = static_cast<float>(widthStretch);
+	for (int i = 0; i < n; ++i)
+	{
+		const float vx = x[i], vy = y[i], vz = z[i];
+		const float r = std::sqrt(vx*vx + vy*vy + vz*vz);
+		const float delta = std::asin(vy/r);
+		valid[i] = (-r < vy && vy < r);
+		x[i] = std::atan2(vx,-vz)*ws;
+		y[i] = 1.25f*std::asinh(std::tan(0.8f*delta));
+		z[i] = r;
+	}
+}
+
 bool StelProjectorMiller::backward(Vec3d &v) const
 {
 	v[0] /= static_cast<double>(widthStretch);
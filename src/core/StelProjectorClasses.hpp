@@ -30,7 +30,9 @@ public:
 	virtual QString getDescriptionI18() const Q_DECL_OVERRIDE;
 	virtual float getMaxFov() const  Q_DECL_OVERRIDE{return 120.f;}
 	virtual bool forward(Vec3f &v) const Q_DECL_OVERRIDE;
+	virtual void forward(int n, float* x, float* y, float* z, quint8* valid) const Q_DECL_OVERRIDE;
 	virtual bool backward(Vec3d &v) const Q_DECL_OVERRIDE;
+	virtual ShaderProjection getShaderProjection() const Q_DECL_OVERRIDE {return ShaderProjectionPerspective;}
 	virtual float fovToViewScalingFactor(float fov) const Q_DECL_OVERRIDE;
 	virtual float viewScalingFactorToFov(float vsf) const Q_DECL_OVERRIDE;
 	virtual float deltaZoom(float fov) const Q_DECL_OVERRIDE;
@@ -48,7 +50,9 @@ public:
 	virtual QString getDescriptionI18() const Q_DECL_OVERRIDE;
 	virtual float getMaxFov() const  Q_DECL_OVERRIDE{return 360.f;}
 	virtual bool forward(Vec3f &v) const Q_DECL_OVERRIDE;
+	virtual void forward(int n, float* x, float* y, float* z, quint8* valid) const Q_DECL_OVERRIDE;
 	virtual bool backward(Vec3d &v) const Q_DECL_OVERRIDE;
+	virtual ShaderProjection getShaderProjection() const Q_DECL_OVERRIDE {return ShaderProjectionEqualArea;}
 	virtual float fovToViewScalingFactor(float fov) const Q_DECL_OVERRIDE;
 	virtual float viewScalingFactorToFov(float vsf) const Q_DECL_OVERRIDE;
 	virtual float deltaZoom(float fov) const Q_DECL_OVERRIDE;
@@ -81,7 +85,9 @@ public:
 	}
 
 	virtual bool forward(Vec3f &v) const Q_DECL_OVERRIDE;
+	virtual void forward(int n, float* x, float* y, float* z, quint8* valid) const Q_DECL_OVERRIDE;
 	virtual bool backward(Vec3d &v) const Q_DECL_OVERRIDE;
+	virtual ShaderProjection getShaderProjection() const Q_DECL_OVERRIDE {return ShaderProjectionStereographic;}
 	virtual float fovToViewScalingFactor(float fov) const Q_DECL_OVERRIDE;
 	virtual float viewScalingFactorToFov(float vsf) const Q_DECL_OVERRIDE;
 	virtual float deltaZoom(float fov) const Q_DECL_OVERRIDE;
@@ -99,7 +105,9 @@ public:
 	virtual QString getDescriptionI18() const Q_DECL_OVERRIDE;
 	virtual float getMaxFov() const Q_DECL_OVERRIDE {return 360.0f;}
 	virtual bool forward(Vec3f &v) const Q_DECL_OVERRIDE;
+	virtual void forward(int n, float* x, float* y, float* z, quint8* valid) const Q_DECL_OVERRIDE;
 	virtual bool backward(Vec3d &v) const Q_DECL_OVERRIDE;
+	virtual ShaderProjection getShaderProjection() const Q_DECL_OVERRIDE {return ShaderProjectionFisheye;}
 	virtual float fovToViewScalingFactor(float fov) const Q_DECL_OVERRIDE;
 	virtual float viewScalingFactorToFov(float vsf) const Q_DECL_OVERRIDE;
 	virtual float deltaZoom(float fov) const Q_DECL_OVERRIDE;
@@ -131,6 +139,7 @@ public:
 		}
 	}
 	virtual bool forward(Vec3f &v) const Q_DECL_OVERRIDE;
+	virtual void forward(int n, float* x, float* y, float* z, quint8* valid) const Q_DECL_OVERRIDE;
 	virtual bool backward(Vec3d &v) const Q_DECL_OVERRIDE;
 	virtual float fovToViewScalingFactor(float fov) const Q_DECL_OVERRIDE;
 	virtual float viewScalingFactorToFov(float vsf) const Q_DECL_OVERRIDE;
@@ -156,6 +165,7 @@ public:
 	virtual QString getDescriptionI18() const Q_DECL_OVERRIDE;
 	virtual float getMaxFov() const Q_DECL_OVERRIDE {return 200.f;} // slight overshoot
 	virtual bool forward(Vec3f &win) const Q_DECL_OVERRIDE;
+	virtual void forward(int n, float* x, float* y, float* z, quint8* valid) const Q_DECL_OVERRIDE;
 	virtual bool backward(Vec3d &v) const Q_DECL_OVERRIDE;
 	virtual float fovToViewScalingFactor(float fov) const Q_DECL_OVERRIDE;
 	virtual float viewScalingFactorToFov(float vsf) const Q_DECL_OVERRIDE;
@@ -184,6 +194,7 @@ public:
 	virtual QString getDescriptionI18() const Q_DECL_OVERRIDE;
 	virtual float getMaxFov() const Q_DECL_OVERRIDE {return 270.f; }
 	virtual bool forward(Vec3f &win) const Q_DECL_OVERRIDE;
+	virtual void forward(int n, float* x, float* y, float* z, quint8* valid) const Q_DECL_OVERRIDE;
 	virtual bool backward(Vec3d &v) const Q_DECL_OVERRIDE;
 	virtual float fovToViewScalingFactor(float fov) const Q_DECL_OVERRIDE;
 	virtual float viewScalingFactorToFov(float vsf) const Q_DECL_OVERRIDE;
@@ -212,7 +223,9 @@ public:
 	virtual QString getDescriptionI18() const Q_DECL_OVERRIDE;
 	virtual float getMaxFov() const Q_DECL_OVERRIDE {return 179.9999f;}
 	virtual bool forward(Vec3f &win) const Q_DECL_OVERRIDE;
+	virtual void forward(int n, float* x, float* y, float* z, quint8* valid) const Q_DECL_OVERRIDE;
 	virtual bool backward(Vec3d &v) const Q_DECL_OVERRIDE;
+	virtual ShaderProjection getShaderProjection() const Q_DECL_OVERRIDE {return ShaderProjectionOrthographic;}
 	virtual float fovToViewScalingFactor(float fov) const Q_DECL_OVERRIDE;
 	virtual float viewScalingFactorToFov(float vsf) const Q_DECL_OVERRIDE;
 	virtual float deltaZoom(float fov) const Q_DECL_OVERRIDE;
@@ -229,6 +242,7 @@ public:
 	virtual QString getNameI18() const Q_DECL_OVERRIDE;
 	virtual QString getDescriptionI18() const Q_DECL_OVERRIDE;
 	virtual bool forward(Vec3f &win) const Q_DECL_OVERRIDE;
+	virtual void forward(int n, float* x, float* y, float* z, quint8* valid) const Q_DECL_OVERRIDE;
 	virtual bool backward(Vec3d &v) const Q_DECL_OVERRIDE;
 };
 
@@ -240,6 +254,7 @@ public:
 	virtual QString getDescriptionI18() const Q_DECL_OVERRIDE;
 	virtual float getMaxFov() const Q_DECL_OVERRIDE {return 270.f; }
 	virtual bool forward(Vec3f &win) const Q_DECL_OVERRIDE;
+	virtual void forward(int n, float* x, float* y, float* z, quint8* valid) const Q_DECL_OVERRIDE;
 	virtual bool backward(Vec3d &v) const Q_DECL_OVERRIDE;
 };
 
@@ -36,9 +36,11 @@
 #include "LandscapeMgr.hpp"
 #include "Landscape.hpp"
 
+#include <QOpenGLBuffer>
 #include <QOpenGLContext>
 #include <QOpenGLShaderProgram>
 #include <QStringList>
+#include <QVector4D>
 #include <QSettings>
 #include <QDebug>
 #include <QtGlobal>
@@ -73,6 +75,8 @@ StelSkyDrawer::StelSkyDrawer(StelCore* acore) :
 	inScale(1.f),
 	starShaderProgram(Q_NULLPTR),
 	starShaderVars(StarShaderVars()),
+	pointSourceBufferShaderProgram(Q_NULLPTR),
+	pointSourceBufferShaderVars(PointSourceBufferShaderVars()),
 	nbPointSources(0),
 	maxPointSources(1000),
 	maxLum(0.f),
@@ -141,6 +145,9 @@ StelSkyDrawer::~StelSkyDrawer()
 	
 	delete starShaderProgram;
 	starShaderProgram = Q_NULLPTR;
+
+	delete pointSourceBufferShaderProgram;
+	pointSourceBufferShaderProgram = Q_NULLPTR;
 }
 
 // Init parameters from config file
@@ -196,6 +203,175 @@ void StelSkyDrawer::init()
 	starShaderVars.color = starShaderProgram->attributeLocation("color");
 	starShaderVars.texture = starShaderProgram->uniformLocation("tex");
 
+	// Create the shader drawing the point sources stored in buffers. It computes on the GPU what
+	// computeRCMag(), addPointSource() and StelProjector::project() compute on the CPU.
+	QOpenGLShader bufferVshader(QOpenGLShader::Vertex);
+	const char *bufferVsrc =
+		"attribute highp vec3 pos;\n"
+		"attribute mediump vec4 color;\n"
+		"attribute highp float magIndex;\n"
+		"uniform highp mat4 projectionMatrix;\n"
+		"uniform highp mat4 modelViewMatrix;\n"
+		"uniform highp mat4 postRefractionMatrix;\n"
+		"uniform highp vec4 refractionParams;\n"
+		"uniform int projection;\n"
+		"uniform highp vec4 windowParams;\n"
+		"uniform highp float widthStretch;\n"
+		"uniform highp vec4 caps[8];\n"
+		"uniform int nbCaps;\n"
+		"uniform highp vec4 altitudeRow;\n"
+		"uniform highp vec4 extinctionParams;\n"
+		"uniform highp vec4 magParams;\n"
+		"uniform highp vec4 radiusParams;\n"
+		"uniform highp float twinkleSeed;\n"
+		"varying mediump vec2 texc;\n"
+		"varying mediump vec3 outColor;\n"
+		"\n"
+		"highp float airmass(highp float cosZ)\n"
+		"{\n"
+		"    if (cosZ < -0.035)\n"
+		"    {\n"
+		"        if (extinctionParams.y < 0.5) return 0.;\n"
+		"        if (extinctionParams.y < 1.5) return 42.;\n"
+		"        cosZ = min(1., -0.035 - (cosZ + 0.035));\n"
+		"    }\n"
+		"    highp float nom = (1.002432*cosZ + 0.148386)*cosZ + 0.0096467;\n"
+		"    highp float denum = ((cosZ + 0.149864)*cosZ + 0.0102963)*cosZ + 0.000303978;\n"
+		"    return nom/denum;\n"
+		"}\n"
+		"\n"
+		"highp vec3 refraction(highp vec3 v)\n"
+		"{\n"
+		"    highp float len = length(v);\n"
+		"    if (len == 0.) return v;\n"
+		"    highp float geomAlt = degrees(asin(clamp(v.z/len, -1., 1.)));\n"
+		"    highp float minAlt = refractionParams.y;\n"
+		"    highp float width = refractionParams.z;\n"
+		"    highp float alt;\n"
+		"    if (geomAlt > minAlt)\n"
+		"        alt = min(90., geomAlt + refractionParams.x*(1.02/tan(radians(geomAlt + 10.3/(geomAlt + 5.11))) + 0.0019279));\n"
+		"    else if (geomAlt > minAlt - width)\n"
+		"        alt = geomAlt + refractionParams.x*(1.02/tan(radians(minAlt + 10.3/(minAlt + 5.11))) + 0.0019279)*(geomAlt - (minAlt - width))/width;\n"
+		"    else\n"
+		"        return v;\n"
+		"    highp float cosGeom = cos(radians(geomAlt));\n"
+		"    highp float shorten = cosGeom > 0. ? cos(radians(alt))/cosGeom : 1.;\n"
+		"    return vec3(v.xy*shorten, sin(radians(alt))*len);\n"
+		"}\n"
+		"\n"
+		"void main(void)\n"
+		"{\n"
+		"    texc = vec2(0.);\n"
+		"    outColor = vec3(0.);\n"
+		"    // Sources which are not drawn are moved out of the clipping volume\n"
+		"    gl_Position = vec4(2., 2., 2., 1.);\n"
+		"    for (int i=0; i<8; ++i)\n"
+		"    {\n"
+		"        if (i >= nbCaps) break;\n"
+		"        if (dot(caps[i].xyz, pos) < caps[i].w) return;\n"
+		"    }\n"
+		"\n"
+		"    highp float index = magIndex;\n"
+		"    highp float twinkleFactor = 1.;\n"
+		"    if (extinctionParams.z > 0.5)\n"
+		"    {\n"
+		"        highp float sinAlt = dot(altitudeRow.xyz, pos) + altitudeRow.w;\n"
+		"        highp float shift = airmass(sinAlt)*extinctionParams.x/magParams.y;\n"
+		"        index += sign(shift)*floor(abs(shift));\n"
+		"        if (index >= magParams.z || index < 0.) return;\n"
+		"        twinkleFactor = min(1., 1. - 0.9*sinAlt);\n"
+		"    }\n"
+		"\n"
+		"    highp float radius = exp(radiusParams.x + radiusParams.y*(magParams.x + magParams.y*index));\n"
+		"    highp float luminance = 1.;\n"
+		"    if (radius < 0.3) return;\n"
+		"    if (radius < 1.2)\n"
+		"    {\n"
+		"        luminance = radius*radius*radius/1.728;\n"
+		"        if (luminance < 0.05) return;\n"
+		"        radius = 1.2;\n"
+		"    }\n"
+		"    else if (radius > 8.)\n"
+		"        radius = 8. + sqrt(1. + radius - 8.) - 1.;\n"
+		"    radius *= radiusParams.z;\n"
+		"\n"
+		"    highp vec3 v = (modelViewMatrix*vec4(pos, 1.)).xyz;\n"
+		"    if (refractionParams.w > 0.5)\n"
+		"        v = (postRefractionMatrix*vec4(refraction(v), 1.)).xyz;\n"
+		"    highp float r = length(v);\n"
+		"    highp vec2 p;\n"
+		"    if (projection == 1)\n"
+		"    {\n"
+		"        if (v.z >= 0.) return;\n"
+		"        p = v.xy/-v.z;\n"
+		"    }\n"
+		"    else if (projection == 2)\n"
+		"        p = v.xy*sqrt(2./(r*(r - v.z)));\n"
+		"    else if (projection == 3)\n"
+		"    {\n"
+		"        highp float h = 0.5*(r - v.z);\n"
+		"        if (h <= 0.) return;\n"
+		"        p = v.xy/h;\n"
+		"    }\n"
+		"    else if (projection == 4)\n"
+		"    {\n"
+		"        highp float h = length(v.xy);\n"
+		"        if (h > 0.)\n"
+		"            p = v.xy*atan(h, -v.z)/h;\n"
+		"        else if (v.z < 0.)\n"
+		"            p = vec2(0.);\n"
+		"        else\n"
+		"            return;\n"
+		"    }\n"
+		"    else\n"
+		"    {\n"
+		"        if (v.z > 0.) return;\n"
+		"        p = v.xy/r;\n"
+		"    }\n"
+		"    p.x *= widthStretch;\n"
+		"\n"
+		"    highp float corner = floor(color.a*255. + 0.5);\n"
+		"    highp vec2 side = vec2(mod(corner, 2.), floor(corner*0.5))*2. - 1.;\n"
+		"    gl_Position = projectionMatrix*vec4(windowParams.xy + windowParams.zw*p + side*radius, 0., 1.);\n"
+		"    texc = side*0.5 + 0.5;\n"
+		"    // Random coef for star twinkling, the same for the 6 vertices of a source\n"
+		"    highp float rnd = fract(sin(dot(pos.xy, vec2(12.9898, 78.233)) + pos.z + twinkleSeed)*43758.5453);\n"
+		"    outColor = min(color.rgb*(1. - twinkleFactor*radiusParams.w*rnd)*luminance, 1.);\n"
+		"}\n";
+	bufferVshader.compileSourceCode(bufferVsrc);
+	if (!bufferVshader.log().isEmpty()) { qWarning() << "StelSkyDrawer::init(): Warnings while compiling point source buffer vshader: " << bufferVshader.log(); }
+
+	pointSourceBufferShaderProgram = new QOpenGLShaderProgram(QOpenGLContext::currentContext());
+	pointSourceBufferShaderProgram->addShader(&bufferVshader);
+	pointSourceBufferShaderProgram->addShader(&fshader);
+	if (StelPainter::linkProg(pointSourceBufferShaderProgram, "pointSourceBufferShader"))
+	{
+		pointSourceBufferShaderVars.projectionMatrix = pointSourceBufferShaderProgram->uniformLocation("projectionMatrix");
+		pointSourceBufferShaderVars.modelViewMatrix = pointSourceBufferShaderProgram->uniformLocation("modelViewMatrix");
+		pointSourceBufferShaderVars.postRefractionMatrix = pointSourceBufferShaderProgram->uniformLocation("postRefractionMatrix");
+		pointSourceBufferShaderVars.refractionParams = pointSourceBufferShaderProgram->uniformLocation("refractionParams");
+		pointSourceBufferShaderVars.projection = pointSourceBufferShaderProgram->uniformLocation("projection");
+		pointSourceBufferShaderVars.windowParams = pointSourceBufferShaderProgram->uniformLocation("windowParams");
+		pointSourceBufferShaderVars.widthStretch = pointSourceBufferShaderProgram->uniformLocation("widthStretch");
+		pointSourceBufferShaderVars.caps = pointSourceBufferShaderProgram->uniformLocation("caps");
+		pointSourceBufferShaderVars.nbCaps = pointSourceBufferShaderProgram->uniformLocation("nbCaps");
+		pointSourceBufferShaderVars.altitudeRow = pointSourceBufferShaderProgram->uniformLocation("altitudeRow");
+		pointSourceBufferShaderVars.extinctionParams = pointSourceBufferShaderProgram->uniformLocation("extinctionParams");
+		pointSourceBufferShaderVars.magParams = pointSourceBufferShaderProgram->uniformLocation("magParams");
+		pointSourceBufferShaderVars.radiusParams = pointSourceBufferShaderProgram->uniformLocation("radiusParams");
+		pointSourceBufferShaderVars.twinkleSeed = pointSourceBufferShaderProgram->uniformLocation("twinkleSeed");
+		pointSourceBufferShaderVars.pos = pointSourceBufferShaderProgram->attributeLocation("pos");
+		pointSourceBufferShaderVars.color = pointSourceBufferShaderProgram->attributeLocation("color");
+		pointSourceBufferShaderVars.magIndex = pointSourceBufferShaderProgram->attributeLocation("magIndex");
+		pointSourceBufferShaderVars.texture = pointSourceBufferShaderProgram->uniformLocation("tex");
+	}
+	else
+	{
+		// The point sources are then always drawn from the CPU
+		delete pointSourceBufferShaderProgram;
+		pointSourceBufferShaderProgram = Q_NULLPTR;
+	}
+
 	update(0);
 }
 
@@ -332,13 +508,19 @@ float StelSkyDrawer::luminanceToSurfacebrightness(float lum)
 }
 
 // Compute RMag and CMag from magnitude for a point source.
-bool StelSkyDrawer::computeRCMag(float mag, RCMag* rcMag) const
+float StelSkyDrawer::pointSourceMagToRadius(float mag) const
 {
-	rcMag->radius = eye->adaptLuminanceScaledLn(pointSourceMagToLnLuminance(mag), static_cast<float>(starRelativeScale)*1.40f*0.5f);
-	rcMag->radius *=starLinearScale;
+	float radius = eye->adaptLuminanceScaledLn(pointSourceMagToLnLuminance(mag), static_cast<float>(starRelativeScale)*1.40f*0.5f);
+	radius *=starLinearScale;
 #ifndef USE_OLD_QGLWIDGET
-	rcMag->radius *=StelMainView::getInstance().getCustomScreenshotMagnification();
+	radius *=StelMainView::getInstance().getCustomScreenshotMagnification();
 #endif
+	return radius;
+}
+
+bool StelSkyDrawer::computeRCMag(float mag, RCMag* rcMag) const
+{
+	rcMag->radius = pointSourceMagToRadius(mag);
 	// Use now statically min_rmag = 0.5, because higher and too small values look bad
 	if (rcMag->radius < 0.3f)
 	{
@@ -413,6 +595,26 @@ void StelSkyDrawer::postDrawPointSource(StelPainter* sPainter)
 	nbPointSources = 0;
 }
 
+void StelSkyDrawer::computeStarColor(const RCMag& rcMag, const Vec3f& color, float twinkleFactor, float random, unsigned char starColor[3]) const
+{
+	// Random coef for star twinkling. twinkleFactor can introduce height-dependent twinkling.
+	const float tw = ((flagStarTwinkle && (flagHasAtmosphere || flagForcedTwinkle))) ? (1.f-twinkleFactor*static_cast<float>(twinkleAmount)*random)*rcMag.luminance : rcMag.luminance;
+
+	starColor[0] = static_cast<unsigned char>(std::min(static_cast<int>(color[0]*tw*255+0.5f), 255));
+	starColor[1] = static_cast<unsigned char>(std::min(static_cast<int>(color[1]*tw*255+0.5f), 255));
+	starColor[2] = static_cast<unsigned char>(std::min(static_cast<int>(color[2]*tw*255+0.5f), 255));
+}
+
+void StelSkyDrawer::fillStarVertices(StarVertex* vx, float x, float y, float radius, const unsigned char starColor[3])
+{
+	vx->pos.set(x-radius,y-radius); memcpy(vx->color, starColor, 3); ++vx;
+	vx->pos.set(x+radius,y-radius); memcpy(vx->color, starColor, 3); ++vx;
+	vx->pos.set(x+radius,y+radius); memcpy(vx->color, starColor, 3); ++vx;
+	vx->pos.set(x-radius,y-radius); memcpy(vx->color, starColor, 3); ++vx;
+	vx->pos.set(x+radius,y+radius); memcpy(vx->color, starColor, 3); ++vx;
+	vx->pos.set(x-radius,y+radius); memcpy(vx->color, starColor, 3);
+}
+
 // Draw a point source halo.
 bool StelSkyDrawer::drawPointSource(StelPainter* sPainter, const Vec3f& v, const RCMag& rcMag, const Vec3f& color, bool checkInScreen, float twinkleFactor)
 {
@@ -426,8 +628,6 @@ bool StelSkyDrawer::drawPointSource(StelPainter* sPainter, const Vec3f& v, const
 		return false;
 
 	const float radius = rcMag.radius;
-	// Random coef for star twinkling. twinkleFactor can introduce height-dependent twinkling.
-	const float tw = ((flagStarTwinkle && (flagHasAtmosphere || flagForcedTwinkle))) ? (1.f-twinkleFactor*static_cast<float>(twinkleAmount)*(static_cast<float>(qrand())/static_cast<float>(RAND_MAX)))*rcMag.luminance : rcMag.luminance;
 
 	// If the rmag is big, draw a big halo
 	if (flagDrawBigStarHalo && radius>MAX_LINEAR_RADIUS+5.f)
@@ -442,18 +642,10 @@ bool StelSkyDrawer::drawPointSource(StelPainter* sPainter, const Vec3f& v, const
 	}
 
 	unsigned char starColor[3] = {0, 0, 0};
-	starColor[0] = static_cast<unsigned char>(std::min(static_cast<int>(color[0]*tw*255+0.5f), 255));
-	starColor[1] = static_cast<unsigned char>(std::min(static_cast<int>(color[1]*tw*255+0.5f), 255));
-	starColor[2] = static_cast<unsigned char>(std::min(static_cast<int>(color[2]*tw*255+0.5f), 255));
+	computeStarColor(rcMag, color, twinkleFactor, static_cast<float>(qrand())/static_cast<float>(RAND_MAX), starColor);
 	
 	// Store the drawing instructions in the vertex arrays
-	StarVertex* vx = &(vertexArray[nbPointSources*6]);
-	vx->pos.set(win[0]-radius,win[1]-radius); memcpy(vx->color, starColor, 3); ++vx;
-	vx->pos.set(win[0]+radius,win[1]-radius); memcpy(vx->color, starColor, 3); ++vx;
-	vx->pos.set(win[0]+radius,win[1]+radius); memcpy(vx->color, starColor, 3); ++vx;
-	vx->pos.set(win[0]-radius,win[1]-radius); memcpy(vx->color, starColor, 3); ++vx;
-	vx->pos.set(win[0]+radius,win[1]+radius); memcpy(vx->color, starColor, 3); ++vx;
-	vx->pos.set(win[0]-radius,win[1]+radius); memcpy(vx->color, starColor, 3); ++vx;
+	fillStarVertices(&(vertexArray[nbPointSources*6]), win[0], win[1], radius, starColor);
 
 	++nbPointSources;
 	if (nbPointSources>=maxPointSources)
@@ -464,6 +656,189 @@ bool StelSkyDrawer::drawPointSource(StelPainter* sPainter, const Vec3f& v, const
 	return true;
 }
 
+// Compute a point source halo into a batch. Must not use any OpenGL call, as this may run in a worker thread.
+bool StelSkyDrawer::addPointSource(float x, float y, const RCMag& rcMag, const Vec3f& color, PointSourceBatch& batch, float twinkleFactor) const
+{
+	if (rcMag.radius<=0.f)
+		return false;
+
+	const float radius = rcMag.radius;
+
+	// If the rmag is big, remember to draw a big halo
+	if (flagDrawBigStarHalo && radius>MAX_LINEAR_RADIUS+5.f)
+	{
+		BigHalo halo;
+		halo.pos.set(x, y);
+		halo.color = color*qMin(1.0f, qMin(rcMag.luminance, (radius-(MAX_LINEAR_RADIUS+5.f))/30.f));
+		batch.bigHalos.append(halo);
+	}
+
+	unsigned char starColor[3] = {0, 0, 0};
+	computeStarColor(rcMag, color, twinkleFactor, batch.nextTwinkleRandom(), starColor);
+
+	const int n = batch.vertices.size();
+	batch.vertices.resize(n+6);
+	fillStarVertices(batch.vertices.data()+n, x, y, radius, starColor);
+	return true;
+}
+
+void StelSkyDrawer::drawPointSourceBatch(StelPainter* sPainter, const PointSourceBatch& batch)
+{
+	Q_ASSERT(sPainter);
+
+	if (!batch.bigHalos.isEmpty())
+	{
+		texBigHalo->bind();
+		sPainter->setBlending(true, GL_ONE, GL_ONE);
+		for (const auto& halo : batch.bigHalos)
+		{
+			sPainter->setColor(halo.color);
+			sPainter->drawSprite2dModeNoDeviceScale(halo.pos[0], halo.pos[1], 150.f);
+		}
+	}
+
+	// Copy the vertices into the vertex arrays, flushing whenever they are full
+	const StarVertex* src = batch.vertices.constData();
+	unsigned int remaining = static_cast<unsigned int>(batch.vertices.size()/6);
+	while (remaining>0)
+	{
+		const unsigned int nb = qMin(remaining, maxPointSources-nbPointSources);
+		memcpy(&(vertexArray[nbPointSources*6]), src, nb*6*sizeof(StarVertex));
+		nbPointSources += nb;
+		src += nb*6;
+		remaining -= nb;
+		if (nbPointSources>=maxPointSources)
+			postDrawPointSource(sPainter);
+	}
+}
+
+void StelSkyDrawer::fillPointSourceBufferVertices(PointSourceBufferVertex* vx, const Vec3f& v, int bVindex, int magIndex)
+{
+	// Same corners as fillStarVertices()
+	static const unsigned char corners[6] = {0, 1, 3, 0, 3, 2};
+	const Vec3f& color = colorTable[bVindex];
+	for (int i=0; i<6; ++i, ++vx)
+	{
+		vx->pos = v;
+		vx->color[0] = static_cast<unsigned char>(std::min(static_cast<int>(color[0]*255+0.5f), 255));
+		vx->color[1] = static_cast<unsigned char>(std::min(static_cast<int>(color[1]*255+0.5f), 255));
+		vx->color[2] = static_cast<unsigned char>(std::min(static_cast<int>(color[2]*255+0.5f), 255));
+		vx->corner = corners[i];
+		vx->magIndex = static_cast<float>(magIndex);
+	}
+}
+
+bool StelSkyDrawer::canDrawPointSourceBuffers(const StelProjector* prj, const QVector<SphericalCap>& caps) const
+{
+	if (!pointSourceBufferShaderProgram || prj->getShaderProjection()==StelProjector::ShaderProjectionNone || caps.size()>8)
+		return false;
+	const StelProjector::ModelViewTranform* modelView = prj->modelViewTransform.data();
+	return dynamic_cast<const StelProjector::Mat4dTransform*>(modelView) || dynamic_cast<const Refraction*>(modelView);
+}
+
+void StelSkyDrawer::preDrawPointSourceBuffers(StelPainter* sPainter, const QVector<SphericalCap>& caps, float radiusFactor)
+{
+	Q_ASSERT(sPainter);
+	const StelProjector* prj = sPainter->getProjector().data();
+	Q_ASSERT(canDrawPointSourceBuffers(prj, caps));
+
+	auto toQMatrix = [](const Mat4d& m)
+	{
+		return QMatrix4x4(static_cast<float>(m[0]), static_cast<float>(m[4]), static_cast<float>(m[8]), static_cast<float>(m[12]),
+				  static_cast<float>(m[1]), static_cast<float>(m[5]), static_cast<float>(m[9]), static_cast<float>(m[13]),
+				  static_cast<float>(m[2]), static_cast<float>(m[6]), static_cast<float>(m[10]), static_cast<float>(m[14]),
+				  static_cast<float>(m[3]), static_cast<float>(m[7]), static_cast<float>(m[11]), static_cast<float>(m[15]));
+	};
+
+	texHalo->bind();
+	sPainter->setBlending(true, GL_ONE, GL_ONE);
+
+	const PointSourceBufferShaderVars& vars = pointSourceBufferShaderVars;
+	QOpenGLShaderProgram* prog = pointSourceBufferShaderProgram;
+	prog->bind();
+
+	const Mat4f& m = prj->getProjectionMatrix();
+	prog->setUniformValue(vars.projectionMatrix, QMatrix4x4(m[0], m[4], m[8], m[12], m[1], m[5], m[9], m[13], m[2], m[6], m[10], m[14], m[3], m[7], m[11], m[15]));
+
+	// The refraction is applied between the J2000 to AltAz and the AltAz to view transformations
+	const Refraction* refr = dynamic_cast<const Refraction*>(prj->modelViewTransform.data());
+	if (refr)
+	{
+		Mat4d pre, post;
+		float pressTempCorr, minGeoAltitudeDeg, transitionWidthDeg;
+		refr->getShadersParams(pre, post, pressTempCorr, minGeoAltitudeDeg, transitionWidthDeg);
+		prog->setUniformValue(vars.modelViewMatrix, toQMatrix(pre));
+		prog->setUniformValue(vars.postRefractionMatrix, toQMatrix(post));
+		prog->setUniformValue(vars.refractionParams, pressTempCorr, minGeoAltitudeDeg, transitionWidthDeg, 1.f);
+	}
+	else
+	{
+		prog->setUniformValue(vars.modelViewMatrix, toQMatrix(prj->modelViewTransform->getApproximateLinearTransfo()));
+		prog->setUniformValue(vars.refractionParams, 0.f, 0.f, 1.f, 0.f);
+	}
+
+	prog->setUniformValue(vars.projection, static_cast<int>(prj->getShaderProjection()));
+	prog->setUniformValue(vars.windowParams, static_cast<float>(prj->viewportCenter[0]), static_cast<float>(prj->viewportCenter[1]),
+			      prj->flipHorz*prj->pixelPerRad, prj->flipVert*prj->pixelPerRad);
+	prog->setUniformValue(vars.widthStretch, static_cast<float>(prj->widthStretch));
+
+	QVector4D capValues[8];
+	for (int i=0; i<caps.size(); ++i)
+		capValues[i] = QVector4D(static_cast<float>(caps.at(i).n[0]), static_cast<float>(caps.at(i).n[1]), static_cast<float>(caps.at(i).n[2]), static_cast<float>(caps.at(i).d));
+	prog->setUniformValueArray(vars.caps, capValues, 8);
+	prog->setUniformValue(vars.nbCaps, caps.size());
+
+	// The sine of the altitude is the z coordinate in the AltAz frame without refraction
+	const bool withExtinction = flagHasAtmosphere && extinction.getExtinctionCoefficient()>=0.01f;
+	Vec3f origin(0.f), ex(1.f, 0.f, 0.f), ey(0.f, 1.f, 0.f), ez(0.f, 0.f, 1.f);
+	core->j2000ToAltAzInPlaceNoRefraction(&origin);
+	core->j2000ToAltAzInPlaceNoRefraction(&ex);
+	core->j2000ToAltAzInPlaceNoRefraction(&ey);
+	core->j2000ToAltAzInPlaceNoRefraction(&ez);
+	prog->setUniformValue(vars.altitudeRow, ex[2]-origin[2], ey[2]-origin[2], ez[2]-origin[2], origin[2]);
+	prog->setUniformValue(vars.extinctionParams, extinction.getExtinctionCoefficient(), static_cast<float>(extinction.getUndergroundExtinctionMode()),
+			      withExtinction ? 1.f : 0.f, 0.f);
+
+	// The radius before computeRCMag() limits it is an exponential of the magnitude
+	const float lnRadius0 = std::log(pointSourceMagToRadius(0.f));
+	const float lnRadius1 = std::log(pointSourceMagToRadius(1.f));
+	const bool twinkle = flagStarTwinkle && (flagHasAtmosphere || flagForcedTwinkle);
+	prog->setUniformValue(vars.radiusParams, lnRadius0, lnRadius1-lnRadius0, radiusFactor, twinkle ? static_cast<float>(twinkleAmount) : 0.f);
+	prog->setUniformValue(vars.twinkleSeed, static_cast<float>(qrand())/static_cast<float>(RAND_MAX)*100.f);
+	prog->setUniformValue(vars.texture, 0);
+
+	prog->enableAttributeArray(vars.pos);
+	prog->enableAttributeArray(vars.color);
+	prog->enableAttributeArray(vars.magIndex);
+}
+
+void StelSkyDrawer::drawPointSourceBuffer(QOpenGLBuffer& buffer, int nbSources, float magMin, float magStep, int cutoffMagIndex)
+{
+	if (nbSources<=0)
+		return;
+	const PointSourceBufferShaderVars& vars = pointSourceBufferShaderVars;
+	QOpenGLShaderProgram* prog = pointSourceBufferShaderProgram;
+	prog->setUniformValue(vars.magParams, magMin, magStep, static_cast<float>(cutoffMagIndex), 0.f);
+
+	buffer.bind();
+	prog->setAttributeBuffer(vars.pos, GL_FLOAT, static_cast<int>(offsetof(PointSourceBufferVertex, pos)), 3, sizeof(PointSourceBufferVertex));
+	prog->setAttributeBuffer(vars.color, GL_UNSIGNED_BYTE, static_cast<int>(offsetof(PointSourceBufferVertex, color)), 4, sizeof(PointSourceBufferVertex));
+	prog->setAttributeBuffer(vars.magIndex, GL_FLOAT, static_cast<int>(offsetof(PointSourceBufferVertex, magIndex)), 1, sizeof(PointSourceBufferVertex));
+	buffer.release();
+
+	glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(nbSources)*6);
+}
+
+void StelSkyDrawer::postDrawPointSourceBuffers()
+{
+	const PointSourceBufferShaderVars& vars = pointSourceBufferShaderVars;
+	QOpenGLShaderProgram* prog = pointSourceBufferShaderProgram;
+	prog->disableAttributeArray(vars.pos);
+	prog->disableAttributeArray(vars.color);
+	prog->disableAttributeArray(vars.magIndex);
+	prog->release();
+}
+
 // Draw's the Sun's corona during a solar eclipse on Earth.
 void StelSkyDrawer::drawSunCorona(StelPainter* painter, const Vec3f& v, float radius, const Vec3f& color, const float alpha, const float angle)
 {
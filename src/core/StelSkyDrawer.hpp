@@ -28,10 +28,12 @@
 
 #include <QObject>
 #include <QImage>
+#include <QVector>
 
 class StelToneReproducer;
 class StelCore;
 class StelPainter;
+class QOpenGLBuffer;
 
 //! Contains the 2 parameters necessary to draw a star on screen.
 //! the radius and luminance of the star halo texture.
@@ -108,6 +110,97 @@ public:
 
 	bool drawPointSource(StelPainter* sPainter, const Vec3f& v, const RCMag &rcMag, const Vec3f& bcolor, bool checkInScreen=false, float twinkleFactor=1.0f);
 
+	//! Vertex format for a point source.
+	//! Texture pos is stored in another separately.
+	struct StarVertex {
+		Vec2f pos;
+		unsigned char color[4];
+	};
+
+	//! A big halo around a very bright point source. It needs its own draw call.
+	struct BigHalo {
+		Vec2f pos;
+		Vec3f color;
+	};
+
+	//! Buffer of point source vertices which can be filled by addPointSource() from any thread,
+	//! and is then handed over to drawPointSourceBatch() in the main thread.
+	//! The twinkling of the stars in a batch comes from its own random sequence, because qrand() gives the same
+	//! sequence in every thread. Restart it with seedTwinkle() from a seed chosen by the main thread so that
+	//! the result doesn't depend on the thread which fills the batch.
+	struct PointSourceBatch {
+		QVector<StarVertex> vertices;
+		QVector<BigHalo> bigHalos;
+		quint32 twinkleState;
+		PointSourceBatch() : twinkleState(1u) {}
+		void clear() {vertices.clear(); bigHalos.clear();}
+		void seedTwinkle(quint32 seed) {twinkleState = seed ? seed : 0x9E3779B9u;}
+		//! Return the next random number of the twinkling sequence in [0, 1) (xorshift32).
+		float nextTwinkleRandom()
+		{
+			twinkleState ^= twinkleState << 13;
+			twinkleState ^= twinkleState >> 17;
+			twinkleState ^= twinkleState << 5;
+			return static_cast<float>(twinkleState >> 8) * (1.f/16777216.f);
+		}
+	};
+
+	//! Compute the vertices of the halo of a point source already projected, e.g. by
+	//! StelProjector::project(int, float*, float*, float*, quint8*), and append them to batch instead of drawing them.
+	//! This method doesn't touch any OpenGL state and is safe to call from worker threads.
+	//! @param x, y the position of the source in window coordinates.
+	//! @param batch the buffer to which the vertices of the point source are appended.
+	//! See drawPointSource() for the other parameters.
+	//! @return true if the source is visible and was added to the batch
+	bool addPointSource(float x, float y, const RCMag &rcMag, int bVindex, PointSourceBatch& batch, float twinkleFactor=1.0f) const
+	{
+		return addPointSource(x, y, rcMag, colorTable[bVindex], batch, twinkleFactor);
+	}
+
+	bool addPointSource(float x, float y, const RCMag &rcMag, const Vec3f& bcolor, PointSourceBatch& batch, float twinkleFactor=1.0f) const;
+
+	//! Draw all the point sources stored in a batch filled by addPointSource().
+	//! Must be called between preDrawPointSource() and postDrawPointSource().
+	void drawPointSourceBatch(StelPainter* sPainter, const PointSourceBatch& batch);
+
+	//! Vertex format of the point sources stored in OpenGL buffers and drawn by drawPointSourceBuffer().
+	//! Each point source is stored as the 6 vertices of its halo quad, which all hold its J2000 direction.
+	struct PointSourceBufferVertex {
+		Vec3f pos;
+		unsigned char color[3];
+		//! The corner of the halo quad: bit 0 for the x side, bit 1 for the y side
+		unsigned char corner;
+		//! The magnitude index of the source, see drawPointSourceBuffer()
+		float magIndex;
+	};
+
+	//! Write the 6 vertices of a point source for a buffer drawn by drawPointSourceBuffer().
+	//! @param v the 3d position of the source in J2000 reference frame
+	static void fillPointSourceBufferVertices(PointSourceBufferVertex* vx, const Vec3f& v, int bVindex, int magIndex);
+
+	//! Return whether point sources can be drawn from buffers with the given projector.
+	//! The shader of drawPointSourceBuffer() computes the projection and the refraction itself, and only supports
+	//! the projections with a StelProjector::getShaderProjection() and up to 8 caps.
+	bool canDrawPointSourceBuffers(const StelProjector* prj, const QVector<SphericalCap>& caps) const;
+
+	//! Set the proper openGL state and the shader parameters of the frame before making calls to drawPointSourceBuffer().
+	//! canDrawPointSourceBuffers() must have returned true for the projector of the painter and the caps.
+	//! @param caps the sources which are not inside all the caps are not drawn.
+	//! @param radiusFactor a factor applied to the halo radius, e.g. to fade the sources in and out.
+	void preDrawPointSourceBuffers(StelPainter* sPainter, const QVector<SphericalCap>& caps, float radiusFactor);
+
+	//! Draw the first sources of a buffer of vertices written by fillPointSourceBufferVertices().
+	//! The shader computes the same halo radius, luminance, extinction and twinkling as computeRCMag() and
+	//! addPointSource(), without the big halos, which are only drawn around sources much brighter than the limit magnitude.
+	//! Must be called between preDrawPointSourceBuffers() and postDrawPointSourceBuffers().
+	//! @param nbSources the number of sources to draw from the start of the buffer.
+	//! @param magMin, magStep the V magnitude of a source is magMin+magStep*magIndex.
+	//! @param cutoffMagIndex the sources whose magnitude index is not below this index after extinction are not drawn.
+	void drawPointSourceBuffer(QOpenGLBuffer& buffer, int nbSources, float magMin, float magStep, int cutoffMagIndex);
+
+	//! Finalize the drawing of point source buffers
+	void postDrawPointSourceBuffers();
+
 	//! Draw an image of the solar corona onto the screen at position v.
 	//! @param radius depends on the actually used texture and current disk size of the sun.
 	//! @param alpha opacity value. Set 1 for full visibility, but usually keep close to 0 except during solar eclipses.
@@ -393,6 +486,9 @@ private:
 	//! @return V magnitude of the point source
 	float pointSourceLuminanceToMag(float lum) const;
 
+	//! Compute the radius of the halo of a point source with the given mag, before it is limited by computeRCMag()
+	float pointSourceMagToRadius(float mag) const;
+
 	//! Compute the log of the luminance for a point source with the given mag for the current FOV
 	//! @param mag V magnitude of the point source
 	//! @return the luminance in cd/m^2
@@ -461,6 +557,13 @@ private:
 	//! Load B-V conversion parameters from config file
 	void initColorTableFromConfigFile(class QSettings* conf);
 
+	//! Compute the twinkled color of a point source as stored in the vertex array
+	//! @param random a random number in [0, 1] for the twinkling
+	void computeStarColor(const RCMag& rcMag, const Vec3f& color, float twinkleFactor, float random, unsigned char starColor[3]) const;
+
+	//! Write the 6 vertices of the halo quad of a point source at screen position x, y
+	static void fillStarVertices(StarVertex* vx, float x, float y, float radius, const unsigned char starColor[3]);
+
 	//! Contains the list of colors matching a given B-V index
 	static Vec3f colorTable[128];
 
@@ -471,13 +574,8 @@ private:
 	float inScale;
 
 	// Variables used for GL optimization when displaying point sources
-	//! Vertex format for a point source.
-	//! Texture pos is stored in another separately.
-	struct StarVertex {
-		Vec2f pos;
-		unsigned char color[4];
-	};
 	static_assert(sizeof(StarVertex) == 12, "Size of StarVertex must be 12 bytes");
+	static_assert(sizeof(PointSourceBufferVertex) == 20, "Size of PointSourceBufferVertex must be 20 bytes");
 	
 	//! Buffer for storing the vertex array data
 	StarVertex* vertexArray;
@@ -494,6 +592,30 @@ private:
 		int texture;
 	};
 	StarShaderVars starShaderVars;
+
+	//! Shader drawing the point sources stored in OpenGL buffers
+	class QOpenGLShaderProgram* pointSourceBufferShaderProgram;
+	struct PointSourceBufferShaderVars {
+		int projectionMatrix;
+		int modelViewMatrix;
+		int postRefractionMatrix;
+		int refractionParams;
+		int projection;
+		int windowParams;
+		int widthStretch;
+		int caps;
+		int nbCaps;
+		int altitudeRow;
+		int extinctionParams;
+		int magParams;
+		int radiusParams;
+		int twinkleSeed;
+		int pos;
+		int color;
+		int magIndex;
+		int texture;
+	};
+	PointSourceBufferShaderVars pointSourceBufferShaderVars;
 	
 	//! Current number of sources stored in the buffers (still to display)
 	unsigned int nbPointSources;
@@ -0,0 +1,111 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelTextShaper.hpp"
+
+#include <QGlyphRun>
+#include <QTextLayout>
+#include <QTextOption>
+
+StelTextShaper::StelTextShaper(int maxCachedGlyphs)
+	: cache(maxCachedGlyphs)
+	, cacheHits(0)
+	, cacheMisses(0)
+{
+}
+
+void StelTextShaper::clear()
+{
+	cache.clear();
+	cacheHits = 0;
+	cacheMisses = 0;
+}
+
+int StelTextShaper::getFontIndex(const QRawFont& font)
+{
+	const QString key = QString("%1\n%2\n%3\n%4\n%5").arg(font.familyName(), font.styleName())
+			    .arg(font.pixelSize()).arg(font.weight()).arg(static_cast<int>(font.style()));
+	auto it = fontIndexes.constFind(key);
+	if (it != fontIndexes.constEnd())
+		return it.value();
+	fonts.append(font);
+	fontIndexes.insert(key, fonts.size()-1);
+	return fonts.size()-1;
+}
+
+const StelShapedText* StelTextShaper::shape(const QString& str, const QFont& font)
+{
+	if (lastFontKey.isEmpty() || font != lastFont)
+	{
+		lastFont = font;
+		lastFontKey = font.key();
+	}
+	const QString key = lastFontKey + QChar('\n') + str;
+	StelShapedText* text = cache.object(key);
+	if (text)
+	{
+		++cacheHits;
+		return text;
+	}
+	++cacheMisses;
+
+	QTextLayout layout(str, font);
+	QTextOption option;
+	option.setWrapMode(QTextOption::NoWrap);
+	layout.setTextOption(option);
+	layout.beginLayout();
+	QTextLine line = layout.createLine();
+	if (line.isValid())
+		line.setLineWidth(1e6);
+	layout.endLayout();
+
+	text = new StelShapedText;
+	text->width = 0.f;
+	if (line.isValid())
+	{
+		const qreal baseline = line.y() + line.ascent();
+		for (const auto& run : layout.glyphRuns())
+		{
+			const int f = getFontIndex(run.rawFont());
+			const QVector<quint32> indexes = run.glyphIndexes();
+			const QVector<QPointF> positions = run.positions();
+			for (int i=0; i<indexes.size(); ++i)
+			{
+				StelShapedGlyph g;
+				g.font = f;
+				g.index = indexes.at(i);
+				g.x = static_cast<float>(positions.at(i).x());
+				g.y = static_cast<float>(positions.at(i).y() - baseline);
+				text->glyphs.append(g);
+			}
+		}
+		text->width = static_cast<float>(line.naturalTextWidth());
+	}
+	text->glyphs.squeeze();
+
+	const int cost = qMax(1, text->glyphs.size());
+	if (cost > cache.maxCost())
+	{
+		// Too long to be cached, keep it until the next call
+		uncached.reset(text);
+		return text;
+	}
+	cache.insert(key, text, cost);
+	return text;
+}
@@ -0,0 +1,90 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef STELTEXTSHAPER_HPP
+#define STELTEXTSHAPER_HPP
+
+#include <QCache>
+#include <QFont>
+#include <QHash>
+#include <QRawFont>
+#include <QScopedPointer>
+#include <QString>
+#include <QVector>
+
+//! One glyph of a shaped string.
+struct StelShapedGlyph
+{
+	//! Index of the font of the glyph, see StelTextShaper::getFont().
+	int font;
+	//! Index of the glyph in the font.
+	quint32 index;
+	//! Position of the glyph origin in pixels, relative to the start of the baseline, y pointing down.
+	float x, y;
+};
+
+//! A string converted to positioned glyphs.
+struct StelShapedText
+{
+	QVector<StelShapedGlyph> glyphs;
+	//! Advance width of the string in pixels.
+	float width;
+};
+
+//! @class StelTextShaper
+//! Converts strings to positioned glyphs with QTextLayout and caches the result, so that a label drawn at every
+//! frame is only shaped once. The shaping handles kerning, ligatures, right-to-left scripts and font fallback,
+//! the fonts used by the glyphs are interned and referred to by their index.
+//! The shaper does not need an OpenGL context. It is used by StelPainter to fill the glyph atlas.
+class StelTextShaper
+{
+public:
+	//! @param maxCachedGlyphs the maximum number of glyphs of the cached strings.
+	explicit StelTextShaper(int maxCachedGlyphs=100000);
+
+	//! Shape a string with the given font.
+	//! @return the shaped string, which stays valid until the next call to shape() or clear().
+	const StelShapedText* shape(const QString& str, const QFont& font);
+
+	//! Get a font used by the shaped glyphs.
+	const QRawFont& getFont(int index) const { return fonts.at(index); }
+	int getFontCount() const { return fonts.size(); }
+
+	//! Remove all the cached strings.
+	void clear();
+
+	//! Get the number of shape() calls answered from the cache and shaped, since the last call to clear().
+	int getCacheHits() const { return cacheHits; }
+	int getCacheMisses() const { return cacheMisses; }
+
+private:
+	int getFontIndex(const QRawFont& font);
+
+	QCache<QString, StelShapedText> cache;
+	QScopedPointer<StelShapedText> uncached;
+	QVector<QRawFont> fonts;
+	QHash<QString, int> fontIndexes;
+	//! The key of the last used font, as QFont::key() is not cached by Qt
+	QFont lastFont;
+	QString lastFontKey;
+	int cacheHits;
+	int cacheMisses;
+};
+
+#endif // STELTEXTSHAPER_HPP
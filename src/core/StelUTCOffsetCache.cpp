@@ -0,0 +1,176 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelUTCOffsetCache.hpp"
+
+#include <QDateTime>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+//! JD of the Unix epoch
+const double JD_EPOCH = 2440587.5;
+//! JD of January 1st of MinYear, and of MaxYear+1
+const double MIN_JD = QDate(StelUTCOffsetCache::MinYear, 1, 1).toJulianDay() - 0.5;
+const double MAX_JD = QDate(StelUTCOffsetCache::MaxYear+1, 1, 1).toJulianDay() - 0.5;
+const double BLOCK_DAYS = StelUTCOffsetCache::BlockYears*365.25;
+
+QDateTime jdToUTC(double JD)
+{
+	return QDateTime::fromMSecsSinceEpoch(static_cast<qint64>(std::floor((JD-JD_EPOCH)*86400000.+0.5)), Qt::UTC);
+}
+
+double utcToJD(const QDateTime& dateTime)
+{
+	return JD_EPOCH + dateTime.toMSecsSinceEpoch()/86400000.;
+}
+
+//! Append the table of the dates following boundaryJD to a table.
+void appendTable(QVector<double>& transitions, QVector<int>& offsets, double boundaryJD,
+		 const QVector<double>& nextTransitions, const QVector<int>& nextOffsets)
+{
+	if (nextOffsets.first()!=offsets.last())
+	{
+		transitions.append(boundaryJD);
+		offsets.append(nextOffsets.first());
+	}
+	transitions += nextTransitions;
+	offsets += nextOffsets.mid(1);
+}
+}
+
+StelUTCOffsetCache::StelUTCOffsetCache()
+	: useDST(true)
+	, fixed(true)
+	, beginJD(-1e100)
+	, offsetBefore(0)
+	, firstBlock(0)
+	, lastBlock(-1)
+{
+}
+
+void StelUTCOffsetCache::setTimeZone(const QTimeZone& tz, bool dst, double begin, int before)
+{
+	timeZone = tz;
+	useDST = dst;
+	fixed = !tz.isValid();
+	beginJD = begin;
+	offsetBefore = before;
+	firstBlock = 0;
+	lastBlock = -1;
+	transitions.clear();
+	offsets.clear();
+}
+
+void StelUTCOffsetCache::setFixedOffset(int offset)
+{
+	setTimeZone(QTimeZone(), true, -1e100, offset);
+}
+
+int StelUTCOffsetCache::getBlock(double JD)
+{
+	const int nbBlocks = static_cast<int>(std::ceil((MAX_JD-MIN_JD)/BLOCK_DAYS));
+	return qBound(0, static_cast<int>(std::floor((JD-MIN_JD)/BLOCK_DAYS)), nbBlocks-1);
+}
+
+double StelUTCOffsetCache::getBlockJD(int block)
+{
+	return MIN_JD + block*BLOCK_DAYS;
+}
+
+int StelUTCOffsetCache::getTimeZoneOffset(double JD) const
+{
+	const QDateTime universal = jdToUTC(qBound(MIN_JD, JD, MAX_JD));
+	return useDST ? timeZone.offsetFromUtc(universal) : timeZone.standardTimeOffset(universal);
+}
+
+void StelUTCOffsetCache::load(int first, int last)
+{
+	const double fromJD = getBlockJD(first);
+	const double toJD = getBlockJD(last+1);
+	QVector<double> newTransitions;
+	QVector<int> newOffsets;
+	newOffsets.append(getTimeZoneOffset(fromJD));
+	const QTimeZone::OffsetDataList list = timeZone.transitions(jdToUTC(fromJD), jdToUTC(toJD));
+	for (const auto& data : list)
+	{
+		const double JD = utcToJD(data.atUtc);
+		const int offset = useDST ? data.offsetFromUtc : data.standardTimeOffset;
+		if (JD>fromJD && JD<toJD && offset!=newOffsets.last())
+		{
+			newTransitions.append(JD);
+			newOffsets.append(offset);
+		}
+	}
+
+	if (firstBlock>lastBlock)
+	{
+		transitions = newTransitions;
+		offsets = newOffsets;
+		firstBlock = first;
+		lastBlock = last;
+	}
+	else if (last<firstBlock)
+	{
+		Q_ASSERT(last==firstBlock-1);
+		appendTable(newTransitions, newOffsets, toJD, transitions, offsets);
+		transitions = newTransitions;
+		offsets = newOffsets;
+		firstBlock = first;
+	}
+	else
+	{
+		Q_ASSERT(first==lastBlock+1);
+		appendTable(transitions, offsets, fromJD, newTransitions, newOffsets);
+		lastBlock = last;
+	}
+}
+
+void StelUTCOffsetCache::preload(double fromJD, double toJD)
+{
+	if (fixed || !timeZone.hasTransitions() || toJD<beginJD)
+		return;
+	const int first = getBlock(qMax(fromJD, beginJD));
+	const int last = getBlock(toJD);
+	if (firstBlock>lastBlock)
+	{
+		load(first, last);
+		return;
+	}
+	if (first<firstBlock)
+		load(first, firstBlock-1);
+	if (last>lastBlock)
+		load(lastBlock+1, last);
+}
+
+int StelUTCOffsetCache::getOffset(double JD)
+{
+	if (fixed || JD<beginJD)
+		return offsetBefore;
+	if (!timeZone.hasTransitions())
+		return getTimeZoneOffset(JD);
+
+	const int block = getBlock(JD);
+	if (block<firstBlock || block>lastBlock)
+		preload(JD, JD);
+	const double t = qBound(MIN_JD, JD, MAX_JD);
+	return offsets.at(static_cast<int>(std::upper_bound(transitions.constBegin(), transitions.constEnd(), t) - transitions.constBegin()));
+}
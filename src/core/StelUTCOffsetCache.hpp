@@ -0,0 +1,88 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef STELUTCOFFSETCACHE_HPP
+#define STELUTCOFFSETCACHE_HPP
+
+#include <QTimeZone>
+#include <QVector>
+
+//! @class StelUTCOffsetCache
+//! Table of the offsets of a time zone from UTC, used by StelCore::getUTCOffset().
+//! The transitions of the time zone (changes of standard time, begin and end of daylight saving time) are loaded
+//! from QTimeZone for blocks of years when a date of the block is first queried, or in advance with preload().
+//! A query is then a binary search over the transition dates.
+//! The time zone only applies from a given date on (usually StelCore::TZ_ERA_BEGINNING), with a fixed offset before,
+//! e.g. the local mean solar time. Dates outside the years MinYear to MaxYear have the offset of the nearest of these years,
+//! so that dates outside the range of QDateTime or of the time zone database get a consistent answer.
+//! The class is not thread-safe.
+class StelUTCOffsetCache
+{
+public:
+	//! The range of years for which the time zone is queried
+	static const int MinYear = 1800;
+	static const int MaxYear = 9999;
+	//! The number of years loaded at once
+	static const int BlockYears = 20;
+
+	StelUTCOffsetCache();
+
+	//! Use the offsets of a time zone.
+	//! @param useDST false to use the standard time of the time zone all year long.
+	//! @param beginJD the date from which on the time zone applies.
+	//! @param offsetBefore the offset before beginJD, seconds.
+	void setTimeZone(const QTimeZone& tz, bool useDST, double beginJD=-1e100, int offsetBefore=0);
+	//! Use the same offset at all dates, seconds.
+	void setFixedOffset(int offset);
+
+	//! Load the transitions of the time zone between two dates.
+	void preload(double fromJD, double toJD);
+
+	//! Return the offset from UTC at a date, seconds.
+	//! @param JD the date (UT)
+	int getOffset(double JD);
+
+	//! Return the number of transitions in the table.
+	int getNbTransitions() const {return transitions.size();}
+
+private:
+	//! Return the block of years of a date, after limiting the date to MinYear...MaxYear.
+	static int getBlock(double JD);
+	//! Return the first date of a block.
+	static double getBlockJD(int block);
+	//! Return the offset of the time zone at a date.
+	int getTimeZoneOffset(double JD) const;
+	//! Load the transitions of the blocks from firstBlock to lastBlock.
+	void load(int firstBlock, int lastBlock);
+
+	QTimeZone timeZone;
+	bool useDST;
+	bool fixed;
+	double beginJD;
+	int offsetBefore;
+
+	//! Blocks covered by the table, or firstBlock>lastBlock if the table is empty.
+	int firstBlock;
+	int lastBlock;
+	//! Dates of the transitions in increasing order. offsets[0] applies before transitions[0], offsets[i+1] from transitions[i] on.
+	QVector<double> transitions;
+	QVector<int> offsets;
+};
+
+#endif // STELUTCOFFSETCACHE_HPP
@@ -25,11 +25,26 @@
 #include "StelCore.hpp"
 #include "StelPainter.hpp"
 #include "StelFileMgr.hpp"
+#include "StelModuleMgr.hpp"
+#include "SolarSystem.hpp"
 #include "Dithering.hpp"
 
 #include <QDebug>
 #include <QSettings>
 #include <QOpenGLShaderProgram>
+#include <QThread>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+//! Grids with less points per thread are computed by fewer threads
+const int MIN_POINTS_PER_THREAD = 4096;
+//! Number of points whose brightness is computed at once
+const int POINT_BLOCK_SIZE = 256;
+}
 
 
 Atmosphere::Atmosphere(void)
@@ -41,6 +56,11 @@ Atmosphere::Atmosphere(void)
 	, indicesBuffer(QOpenGLBuffer::IndexBuffer)
 	, colorGrid(Q_NULLPTR)
 	, colorGridBuffer(QOpenGLBuffer::VertexBuffer)
+	, gridBuffersDirty(false)
+	, colorGridDirty(false)
+	, gridPlanetsVisible(true)
+	, gridLightPollution(0.f)
+	, threadCount(0)
 	, averageLuminance(0.f)
 	, overrideAverageLuminance(false)
 	, eclipseFactor(1.f)
@@ -113,73 +133,211 @@ Atmosphere::~Atmosphere(void)
 	atmoShaderProgram = Q_NULLPTR;
 }
 
-void Atmosphere::computeColor(double JD, Vec3d _sunPos, Vec3d moonPos, float moonPhase, float moonMagnitude,
-							   StelCore* core, float latitude, float altitude, float temperature, float relativeHumidity)
+void Atmosphere::updateGrid(const StelProjectorP& prj, unsigned int resolutionY)
 {
-	const StelProjectorP prj = core->getProjection(StelCore::FrameAltAz, StelCore::RefractionOff);
-	if (viewport != prj->getViewport())
+	viewport = prj->getViewport();
+	delete[] colorGrid;
+	delete [] posGrid;
+	const float aspect = 0.5f*sqrtf(3.0f)*prj->getViewportWidth()/prj->getViewportHeight();
+	// The grid is drawn with 16 bit indices
+	for (skyResolutionY=qMax(resolutionY, 2u); ; --skyResolutionY)
 	{
-		// The viewport changed: update the number of point of the grid
-		viewport = prj->getViewport();
-		delete[] colorGrid;
-		delete [] posGrid;
-		skyResolutionY = StelApp::getInstance().getSettings()->value("landscape/atmosphereybin", 44).toUInt();
-		skyResolutionX = static_cast<unsigned int>(floorf(0.5f+skyResolutionY*(0.5f*sqrtf(3.0f))*prj->getViewportWidth()/prj->getViewportHeight()));
-		posGrid = new Vec2f[static_cast<size_t>((1+skyResolutionX)*(1+skyResolutionY))];
-		colorGrid = new Vec4f[static_cast<size_t>((1+skyResolutionX)*(1+skyResolutionY))];
-		float stepX = static_cast<float>(prj->getViewportWidth()) / static_cast<float>(skyResolutionX-0.5f);
-		float stepY = static_cast<float>(prj->getViewportHeight()) / skyResolutionY;
-		float viewport_left = prj->getViewportPosX();
-		float viewport_bottom = prj->getViewportPosY();
-		for (unsigned int x=0; x<=skyResolutionX; ++x)
+		skyResolutionX = static_cast<unsigned int>(floorf(0.5f+skyResolutionY*aspect));
+		if ((1+skyResolutionX)*(1+skyResolutionY) <= std::numeric_limits<unsigned short>::max()+1u || skyResolutionY<=2)
+			break;
+	}
+	if (skyResolutionY < resolutionY)
+		qWarning() << "Atmosphere grid resolution reduced to" << skyResolutionY << "for this viewport";
+	const int count = static_cast<int>((1+skyResolutionX)*(1+skyResolutionY));
+	posGrid = new Vec2f[static_cast<size_t>(count)];
+	colorGrid = new Vec4f[static_cast<size_t>(count)];
+	float stepX = static_cast<float>(prj->getViewportWidth()) / static_cast<float>(skyResolutionX-0.5f);
+	float stepY = static_cast<float>(prj->getViewportHeight()) / skyResolutionY;
+	float viewport_left = prj->getViewportPosX();
+	float viewport_bottom = prj->getViewportPosY();
+	for (unsigned int x=0; x<=skyResolutionX; ++x)
+	{
+		for(unsigned int y=0; y<=skyResolutionY; ++y)
 		{
-			for(unsigned int y=0; y<=skyResolutionY; ++y)
-			{
-				Vec2f &v(posGrid[y*(1+skyResolutionX)+x]);
-				v[0] = viewport_left + ((x == 0) ? 0.f :
-						(x == skyResolutionX) ? prj->getViewportWidth() : (x-0.5f*(y&1))*stepX);
-				v[1] = viewport_bottom+y*stepY;
-			}
+			Vec2f &v(posGrid[y*(1+skyResolutionX)+x]);
+			v[0] = viewport_left + ((x == 0) ? 0.f :
+					(x == skyResolutionX) ? prj->getViewportWidth() : (x-0.5f*(y&1))*stepX);
+			v[1] = viewport_bottom+y*stepY;
+		}
+	}
+	std::fill(colorGrid, colorGrid+count, Vec4f(0.f, 0.f, 1.f, 0.f));
+	gridDirX.resize(count);
+	gridDirY.resize(count);
+	gridDirZ.resize(count);
+	gridProjector.clear();
+	gridBuffersDirty = true;
+	colorGridDirty = true;
+}
+
+void Atmosphere::createGridBuffers()
+{
+	posGridBuffer.destroy();
+	//posGridBuffer = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+	Q_ASSERT(posGridBuffer.type()==QOpenGLBuffer::VertexBuffer);
+	posGridBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+	posGridBuffer.create();
+	posGridBuffer.bind();
+	posGridBuffer.allocate(posGrid, static_cast<int>((1+skyResolutionX)*(1+skyResolutionY)*8));
+	posGridBuffer.release();
+
+	// Generate the indices used to draw the quads
+	unsigned short* indices = new unsigned short[static_cast<size_t>((skyResolutionX+1)*skyResolutionY*2)];
+	int i=0;
+	for (unsigned int y2=0; y2<skyResolutionY; ++y2)
+	{
+		unsigned short g0 = static_cast<unsigned short>(y2*(1+skyResolutionX));
+		unsigned short g1 = static_cast<unsigned short>((y2+1)*(1+skyResolutionX));
+		for (unsigned int x2=0; x2<=skyResolutionX; ++x2)
+		{
+			indices[i++]=g0++;
+			indices[i++]=g1++;
 		}
-		posGridBuffer.destroy();
-		//posGridBuffer = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
-		Q_ASSERT(posGridBuffer.type()==QOpenGLBuffer::VertexBuffer);
-		posGridBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
-		posGridBuffer.create();
-		posGridBuffer.bind();
-		posGridBuffer.allocate(posGrid, (1+skyResolutionX)*(1+skyResolutionY)*8);
-		posGridBuffer.release();
-		
-		// Generate the indices used to draw the quads
-		unsigned short* indices = new unsigned short[static_cast<size_t>((skyResolutionX+1)*skyResolutionY*2)];
-		int i=0;
-		for (unsigned int y2=0; y2<skyResolutionY; ++y2)
+	}
+	indicesBuffer.destroy();
+	//indicesBuffer = QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
+	Q_ASSERT(indicesBuffer.type()==QOpenGLBuffer::IndexBuffer);
+	indicesBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+	indicesBuffer.create();
+	indicesBuffer.bind();
+	indicesBuffer.allocate(indices, static_cast<int>((skyResolutionX+1)*skyResolutionY*2*2));
+	indicesBuffer.release();
+	delete[] indices;
+	indices=Q_NULLPTR;
+
+	colorGridBuffer.destroy();
+	colorGridBuffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+	colorGridBuffer.create();
+	colorGridBuffer.bind();
+	colorGridBuffer.allocate(colorGrid, static_cast<int>((1+skyResolutionX)*(1+skyResolutionY)*4*4));
+	colorGridBuffer.release();
+	gridBuffersDirty = false;
+	colorGridDirty = false;
+}
+
+int Atmosphere::getEffectiveThreadCount() const
+{
+	return threadCount>0 ? threadCount : qMax(1, QThread::idealThreadCount());
+}
+
+float Atmosphere::computeGridPoints(int begin, int end, bool unproject, const StelProjector& prj)
+{
+	float* x = gridDirX.data();
+	float* y = gridDirY.data();
+	float* z = gridDirZ.data();
+
+	if (unproject)
+	{
+		Vec3d point(1., 0., 0.);
+		for (int i=begin; i<end; ++i)
 		{
-			unsigned short g0 = static_cast<unsigned short>(y2*(1+skyResolutionX));
-			unsigned short g1 = static_cast<unsigned short>((y2+1)*(1+skyResolutionX));
-			for (unsigned int x2=0; x2<=skyResolutionX; ++x2)
+			const Vec2f &v(posGrid[i]);
+			prj.unProject(static_cast<double>(v[0]),static_cast<double>(v[1]),point);
+
+			Q_ASSERT(fabs(point.lengthSquared()-1.0) < 1e-10);
+
+			Vec3f pointF=point.toVec3f();
+			// Use mirroring for sun only
+			if (pointF[2]<=0.f)
 			{
-				indices[i++]=g0++;
-				indices[i++]=g1++;
+				pointF[2] *= -1.f;
+				// The sky below the ground is the symmetric of the one above :
+				// it looks nice and gives proper values for brightness estimation
+				// Use the Skybright.cpp 's models for brightness which gives better results.
 			}
+			x[i] = pointF[0];
+			y[i] = pointF[1];
+			z[i] = pointF[2];
 		}
-		indicesBuffer.destroy();
-		//indicesBuffer = QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
-		Q_ASSERT(indicesBuffer.type()==QOpenGLBuffer::IndexBuffer);
-		indicesBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
-		indicesBuffer.create();
-		indicesBuffer.bind();
-		indicesBuffer.allocate(indices, static_cast<int>((skyResolutionX+1)*skyResolutionY*2*2));
-		indicesBuffer.release();
-		delete[] indices;
-		indices=Q_NULLPTR;
-		
-		colorGridBuffer.destroy();
-		colorGridBuffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
-		colorGridBuffer.create();
-		colorGridBuffer.bind();
-		colorGridBuffer.allocate(colorGrid, static_cast<int>((1+skyResolutionX)*(1+skyResolutionY)*4*4));
-		colorGridBuffer.release();
+	}
+
+	// Variables used to compute the average sky luminance
+	float sum_lum = 0.f;
+	float cosDistMoon[POINT_BLOCK_SIZE];
+	float cosDistSun[POINT_BLOCK_SIZE];
+	float lum[POINT_BLOCK_SIZE];
+	const Vec3f& moonPosF = gridMoonPos;
+	const Vec3f& sunPosF = gridSunPos;
+	for (int blockBegin=begin; blockBegin<end; blockBegin+=POINT_BLOCK_SIZE)
+	{
+		const int n = qMin(POINT_BLOCK_SIZE, end-blockBegin);
+		const float* bx = x+blockBegin;
+		const float* by = y+blockBegin;
+		const float* bz = z+blockBegin;
+		for (int j=0; j<n; ++j)
+		{
+			cosDistMoon[j] = moonPosF[0]*bx[j]+moonPosF[1]*by[j]+moonPosF[2]*bz[j];
+			cosDistSun[j] = sunPosF[0]*bx[j]+sunPosF[1]*by[j]+sunPosF[2]*bz[j];
+		}
+		if (gridPlanetsVisible)
+			skyb.getLuminance(n, cosDistMoon, cosDistSun, bz, lum);
+		else
+			std::fill(lum, lum+n, 0.f);
+
+		for (int j=0; j<n; ++j)
+		{
+			float lumi = lum[j]*eclipseFactor;
+			// Add star background luminance
+			lumi += 0.0001f;
+			// Multiply by the input scale of the ToneConverter (is not done automatically by the xyYtoRGB method called later)
+			//lumi*=eye->getInputScale();
+
+			// Add the light pollution luminance AFTER the scaling to avoid scaling it because it is the cause
+			// of the scaling itself
+			lumi += gridLightPollution;
+
+			// Store for later statistics
+			sum_lum+=lumi;
+
+			// Now need to compute the xy part of the color component
+			// This is done in the openGL shader
+			// Store the back projected position + luminance in the input color to the shader
+			colorGrid[blockBegin+j].set(bx[j], by[j], bz[j], lumi);
+		}
+	}
+	return sum_lum;
+}
+
+float Atmosphere::computeGrid(const StelProjectorP& prj, int threads)
+{
+	const int count = static_cast<int>((1+skyResolutionX)*(1+skyResolutionY));
+	// The directions of the grid points only change with the view
+	const bool unproject = !gridProjector || !prj->hasSameView(*gridProjector);
+	gridProjector = prj;
+
+	// Each thread computes a contiguous part of the grid, the calling thread the first one
+	const int parts = qBound(1, qMin(threads, count/MIN_POINTS_PER_THREAD), count);
+	QVector<float> sums(parts, 0.f);
+	auto worker = [&](int part)
+	{
+		sums[part] = computeGridPoints(count*part/parts, count*(part+1)/parts, unproject, *prj);
+	};
+	QVector<QFuture<void>> futures;
+	for (int part=1; part<parts; ++part)
+		futures.append(QtConcurrent::run([&worker, part]() { worker(part); }));
+	worker(0);
+	for (auto& f : futures)
+		f.waitForFinished();
+
+	float sum_lum = 0.f;
+	for (float s : sums)
+		sum_lum += s;
+	colorGridDirty = true;
+	return sum_lum;
+}
+
+void Atmosphere::computeColor(double JD, Vec3d _sunPos, Vec3d moonPos, float moonPhase, float moonMagnitude,
+							   StelCore* core, float latitude, float altitude, float temperature, float relativeHumidity)
+{
+	const StelProjectorP prj = core->getProjection(StelCore::FrameAltAz, StelCore::RefractionOff);
+	if (viewport != prj->getViewport())
+	{
+		// The viewport changed: update the number of point of the grid
+		updateGrid(prj, StelApp::getInstance().getSettings()->value("landscape/atmosphereybin", 44).toUInt());
 	}
 
 	if (qIsNaN(_sunPos.length()))
@@ -246,55 +404,16 @@ void Atmosphere::computeColor(double JD, Vec3d _sunPos, Vec3d moonPos, float moo
 	StelUtils::getDateFromJulianDay(JD, &year, &month, &day);
 	skyb.setDate(year, month, moonPhase, moonMagnitude);
 
-	// Variables used to compute the average sky luminance
-	float sum_lum = 0.f;
-
-	Vec3d point(1., 0., 0.);
-	float lumi;
+	// No Sun and Moon on the sky
+	// Details: https://bugs.launchpad.net/stellarium/+bug/1499699
+	gridPlanetsVisible = GETSTELMODULE(SolarSystem)->getFlagPlanets();
+	gridSunPos = sunPosF;
+	gridMoonPos = moonPosF;
+	gridLightPollution = fader.getInterstate()*lightPollutionLuminance;
 
 	// Compute the sky color for every point above the ground
-	for (unsigned int i=0; i<(1+skyResolutionX)*(1+skyResolutionY); ++i)
-	{
-		const Vec2f &v(posGrid[i]);
-		prj->unProject(static_cast<double>(v[0]),static_cast<double>(v[1]),point);
-
-		Q_ASSERT(fabs(point.lengthSquared()-1.0) < 1e-10);
+	const float sum_lum = computeGrid(prj, getEffectiveThreadCount());
 
-		Vec3f pointF=point.toVec3f();
-		// Use mirroring for sun only
-		if (pointF[2]<=0.f)
-		{
-			pointF[2] *= -1.f;
-			// The sky below the ground is the symmetric of the one above :
-			// it looks nice and gives proper values for brightness estimation
-			// Use the Skybright.cpp 's models for brightness which gives better results.
-		}
-		lumi = skyb.getLuminance(moonPosF[0]*pointF[0]+moonPosF[1]*pointF[1]+
-				moonPosF[2]*pointF[2], sunPosF[0]*pointF[0]+sunPosF[1]*pointF[1]+
-				sunPosF[2]*pointF[2], pointF[2]);
-		lumi *= eclipseFactor;
-		// Add star background luminance
-		lumi += 0.0001f;
-		// Multiply by the input scale of the ToneConverter (is not done automatically by the xyYtoRGB method called later)
-		//lumi*=eye->getInputScale();
-
-		// Add the light pollution luminance AFTER the scaling to avoid scaling it because it is the cause
-		// of the scaling itself
-		lumi += fader.getInterstate()*lightPollutionLuminance;
-
-		// Store for later statistics
-		sum_lum+=lumi;
-
-		// Now need to compute the xy part of the color component
-		// This is done in the openGL shader
-		// Store the back projected position + luminance in the input color to the shader
-		colorGrid[i].set(pointF[0], pointF[1], pointF[2], lumi);
-	}
-	
-	colorGridBuffer.bind();
-	colorGridBuffer.write(0, colorGrid, static_cast<int>((1+skyResolutionX)*(1+skyResolutionY)*4*4));
-	colorGridBuffer.release();
-	
 	// Update average luminance
 	if (!overrideAverageLuminance)
 		averageLuminance = sum_lum/((1+skyResolutionX)*(1+skyResolutionY));
@@ -327,6 +446,16 @@ void Atmosphere::draw(StelCore* core)
 	if (!fader.getInterstate())
 		return;
 
+	if (gridBuffersDirty)
+		createGridBuffers();
+	if (colorGridDirty)
+	{
+		colorGridBuffer.bind();
+		colorGridBuffer.write(0, colorGrid, static_cast<int>((1+skyResolutionX)*(1+skyResolutionY)*4*4));
+		colorGridBuffer.release();
+		colorGridDirty = false;
+	}
+
 	StelPainter sPainter(core->getProjection2d());
 	sPainter.setBlending(true, GL_ONE, GL_ONE);
 
@@ -26,8 +26,10 @@
 
 #include "Skybright.hpp"
 #include "StelFader.hpp"
+#include "StelProjectorType.hpp"
 
 #include <QOpenGLBuffer>
+#include <QVector>
 
 class StelProjector;
 class StelToneReproducer;
@@ -81,7 +83,28 @@ public:
 	//! Get the light pollution luminance in cd/m^2
 	float getLightPollutionLuminance() const { return lightPollutionLuminance; }
 
+	//! Set the number of threads used to compute the sky brightness of the grid in computeColor().
+	//! Small grids are always computed by the calling thread only.
+	//! @param n the number of threads, or 0 to use one thread per CPU core
+	void setThreadCount(int n) { threadCount = n; }
+	//! Get the number of threads used to compute the sky brightness (0 means one per CPU core).
+	int getThreadCount() const { return threadCount; }
+
 private:
+	//! Set the grid resolution and the screen positions of the grid points for the viewport of a projector.
+	//! The OpenGL buffers are updated in the next draw().
+	void updateGrid(const StelProjectorP& prj, unsigned int resolutionY);
+	//! Create the OpenGL buffers for the current grid.
+	void createGridBuffers();
+	//! Compute the sky brightness of the whole grid with the current sky model.
+	//! @return the sum of the luminance of the grid points
+	float computeGrid(const StelProjectorP& prj, int threads);
+	//! Compute the sky brightness of the grid points from begin to end (excluded).
+	//! @param unproject compute the directions of the points, else reuse those of the previous frame.
+	//! @return the sum of their luminance
+	float computeGridPoints(int begin, int end, bool unproject, const StelProjector& prj);
+	int getEffectiveThreadCount() const;
+
 	Vec4i viewport;
 	Skylight sky;
 	Skybright skyb;
@@ -92,6 +115,21 @@ private:
 	QOpenGLBuffer indicesBuffer;
 	Vec4f* colorGrid;
 	QOpenGLBuffer colorGridBuffer;
+	//! The grid changed since the OpenGL buffers were created
+	bool gridBuffersDirty;
+	//! colorGrid changed since it was written to colorGridBuffer
+	bool colorGridDirty;
+
+	//! The directions of the grid points in the alt-azimuthal frame, mirrored above the horizon, as structure of arrays.
+	//! They only depend on the view and are kept until it changes.
+	QVector<float> gridDirX, gridDirY, gridDirZ;
+	//! The projector used to compute the directions, null if they have to be computed again
+	StelProjectorP gridProjector;
+	//! The sky model of the current frame, used by computeGridPoints()
+	Vec3f gridSunPos, gridMoonPos;
+	bool gridPlanetsVisible;
+	float gridLightPollution;
+	int threadCount;
 
 	//! The average luminance of the atmosphere in cd/m2
 	float averageLuminance;
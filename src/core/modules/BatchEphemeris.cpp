@@ -0,0 +1,270 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "BatchEphemeris.hpp"
+#include "Planet.hpp"
+#include "StelUtils.hpp"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFuture>
+#include <QQueue>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <cmath>
+
+// Values per body and date: RA, Dec, distance, heliocentric distance
+#define BATCH_EPHEMERIS_VALUES 4
+
+namespace
+{
+	//! Positions from a copy of a PositionEvaluator, so that every chunk has its own ephemeris caches.
+	class EvaluatorSource : public BatchEphemeris::Source
+	{
+	public:
+		EvaluatorSource(const SolarSystem::PositionEvaluator& evaluator, const QList<PlanetP>& objects)
+			: evaluator(evaluator), objects(objects) {}
+		virtual void compute(double JD, Vec3d* positions, double* heliocentricDistances) Q_DECL_OVERRIDE
+		{
+			const double JDE = evaluator.getJDE(JD);
+			for (int b=0; b<objects.size(); ++b)
+			{
+				const Planet* planet = objects.at(b).data();
+				positions[b] = evaluator.getJ2000EquatorialPos(planet, JDE);
+				heliocentricDistances[b] = evaluator.getHeliocentricEclipticPos(planet, JDE).length();
+			}
+		}
+
+	private:
+		SolarSystem::PositionEvaluator evaluator;
+		QList<PlanetP> objects;
+	};
+}
+
+BatchEphemeris::BatchEphemeris(const SolarSystem* solarSystem, StelCore* core)
+	: solarSystem(solarSystem)
+	, startJD(0.)
+	, step(1.)
+	, stepCount(0)
+	, format(Csv)
+	, chunkSize(1440)
+	, threadCount(0)
+{
+	// The settings of the core are taken now, every chunk works on its own copy of this evaluator.
+	const SolarSystem::PositionEvaluator evaluator(solarSystem, core);
+	createSource = [this, evaluator]() { return SourceP(new EvaluatorSource(evaluator, objects)); };
+}
+
+BatchEphemeris::BatchEphemeris(const QStringList& englishNames, const std::function<SourceP()>& createSource)
+	: solarSystem(Q_NULLPTR)
+	, objectNames(englishNames)
+	, createSource(createSource)
+	, startJD(0.)
+	, step(1.)
+	, stepCount(0)
+	, format(Csv)
+	, chunkSize(1440)
+	, threadCount(0)
+{
+}
+
+bool BatchEphemeris::setObjects(const QStringList& englishNames)
+{
+	objects.clear();
+	objectNames.clear();
+	for (const auto& name : englishNames)
+	{
+		PlanetP planet = solarSystem->searchByEnglishName(name.trimmed());
+		if (!planet)
+		{
+			error = QString("unknown solar system object: %1").arg(name);
+			objects.clear();
+			objectNames.clear();
+			return false;
+		}
+		objects.append(planet);
+		objectNames.append(planet->getEnglishName());
+	}
+	return true;
+}
+
+void BatchEphemeris::setRange(double startJD, double stopJD, double step)
+{
+	this->startJD = startJD;
+	this->step = step;
+	if (step > 0. && stopJD >= startJD)
+		stepCount = static_cast<qint64>(std::floor((stopJD - startJD) / step + 1e-9)) + 1;
+	else
+		stepCount = 0;
+}
+
+qint64 BatchEphemeris::rowCount() const
+{
+	return stepCount * objectNames.size();
+}
+
+BatchEphemeris::Format BatchEphemeris::formatForFileName(const QString& fileName)
+{
+	return fileName.endsWith(".csv", Qt::CaseInsensitive) ? Csv : Binary;
+}
+
+qint64 BatchEphemeris::writeFile(const QString& fileName)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		error = QString("cannot open %1 for writing: %2").arg(QDir::toNativeSeparators(fileName), file.errorString());
+		return -1;
+	}
+	const qint64 rows = write(&file);
+	file.close();
+	return rows;
+}
+
+qint64 BatchEphemeris::write(QIODevice* device)
+{
+	if (objectNames.isEmpty() || stepCount==0)
+	{
+		error = "nothing to compute: no objects or an empty time range";
+		return -1;
+	}
+	error.clear();
+
+	const QByteArray header = encodeHeader();
+	if (device && device->write(header) != header.size())
+	{
+		error = device->errorString();
+		return -1;
+	}
+
+	QThreadPool pool;
+	pool.setMaxThreadCount(threadCount>0 ? threadCount : QThread::idealThreadCount());
+	// Keep every thread busy while the oldest chunk is written, but no more chunks than that in memory.
+	const int maxInFlight = 2*pool.maxThreadCount();
+
+	QQueue<QFuture<QByteArray> > inFlight;
+	qint64 nextStep = 0;
+	while (nextStep < stepCount || !inFlight.isEmpty())
+	{
+		while (nextStep < stepCount && inFlight.size() < maxInFlight)
+		{
+			const qint64 first = nextStep;
+			const int steps = static_cast<int>(qMin<qint64>(chunkSize, stepCount - first));
+			inFlight.enqueue(QtConcurrent::run(&pool, [this, first, steps]() { return computeChunk(first, steps); }));
+			nextStep += steps;
+		}
+
+		const QByteArray data = inFlight.dequeue().result();
+		if (device && error.isEmpty() && device->write(data) != data.size())
+		{
+			// Let the chunks in flight finish before the pool goes out of scope, but start no more.
+			error = device->errorString();
+			nextStep = stepCount;
+		}
+	}
+	return error.isEmpty() ? rowCount() : -1;
+}
+
+QByteArray BatchEphemeris::encodeHeader() const
+{
+	QByteArray data;
+	if (format==Csv)
+	{
+		data = "jd,object,ra_j2000,dec_j2000,distance,heliocentric_distance\n";
+		return data;
+	}
+
+	QDataStream out(&data, QIODevice::WriteOnly);
+	out.setByteOrder(QDataStream::LittleEndian);
+	out.writeRawData("STELEPHB", 8);
+	out << quint32(1) << quint32(objectNames.size());
+	for (const auto& englishName : objectNames)
+	{
+		const QByteArray name = englishName.toUtf8();
+		out << quint32(name.size());
+		out.writeRawData(name.constData(), name.size());
+	}
+	return data;
+}
+
+QByteArray BatchEphemeris::computeChunk(qint64 firstStep, int steps) const
+{
+	SourceP source = createSource();
+	const int bodies = objectNames.size();
+
+	// Columns: values[(body*BATCH_EPHEMERIS_VALUES + column)*steps + i]
+	QVector<double> jds(steps);
+	QVector<double> values(bodies*BATCH_EPHEMERIS_VALUES*steps);
+	QVector<Vec3d> positions(bodies);
+	QVector<double> heliocentricDistances(bodies);
+	for (int i=0; i<steps; ++i)
+	{
+		// Index based, so that long runs do not accumulate rounding errors
+		const double JD = startJD + (firstStep + i)*step;
+		jds[i] = JD;
+		source->compute(JD, positions.data(), heliocentricDistances.data());
+		for (int b=0; b<bodies; ++b)
+		{
+			double ra, dec;
+			const Vec3d& pos = positions.at(b);
+			StelUtils::rectToSphe(&ra, &dec, pos);
+			double* v = values.data() + b*BATCH_EPHEMERIS_VALUES*steps;
+			v[i] = StelUtils::fmodpos(ra, 2.*M_PI)*M_180_PI;
+			v[steps + i] = dec*M_180_PI;
+			v[2*steps + i] = pos.length();
+			v[3*steps + i] = heliocentricDistances.at(b);
+		}
+	}
+
+	QByteArray data;
+	if (format==Csv)
+	{
+		QVector<QByteArray> names;
+		for (const auto& englishName : objectNames)
+			names.append(englishName.toUtf8());
+		data.reserve(steps*bodies*80);
+		for (int i=0; i<steps; ++i)
+		{
+			const QByteArray jd = QByteArray::number(jds.at(i), 'f', 6);
+			for (int b=0; b<bodies; ++b)
+			{
+				const double* v = values.constData() + b*BATCH_EPHEMERIS_VALUES*steps;
+				data.append(jd).append(',').append(names.at(b)).append(',')
+				    .append(QByteArray::number(v[i], 'f', 6)).append(',')
+				    .append(QByteArray::number(v[steps + i], 'f', 6)).append(',')
+				    .append(QByteArray::number(v[2*steps + i], 'f', 9)).append(',')
+				    .append(QByteArray::number(v[3*steps + i], 'f', 9)).append('\n');
+			}
+		}
+	}
+	else
+	{
+		QDataStream out(&data, QIODevice::WriteOnly);
+		out.setByteOrder(QDataStream::LittleEndian);
+		out.setFloatingPointPrecision(QDataStream::DoublePrecision);
+		out << quint32(steps);
+		for (double jd : jds)
+			out << jd;
+		for (double v : values)
+			out << v;
+	}
+	return data;
+}
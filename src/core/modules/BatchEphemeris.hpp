@@ -0,0 +1,116 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef BATCHEPHEMERIS_HPP
+#define BATCHEPHEMERIS_HPP
+
+#include "SolarSystem.hpp"
+
+#include <QStringList>
+#include <QSharedPointer>
+
+#include <functional>
+
+class QIODevice;
+
+//! @class BatchEphemeris
+//! Computes ephemerides of many solar system bodies over long time spans and streams them to a CSV or binary file.
+//! The time range is split into chunks which are computed in parallel, each with its own copy of a
+//! SolarSystem::PositionEvaluator. The encoded chunks are written in order as soon as they are ready, so that only a
+//! few chunks are held in memory at any time, whatever the length of the ephemeris.
+//!
+//! Every row holds, for one body at one date: JD (UT), right ascension and declination (J2000.0, degrees),
+//! distance from the observer (AU) and distance from the Sun (AU). The rows are ordered by date and then by body.
+//!
+//! The CSV format has a header line with the column names and one line per row.
+//! The binary format is columnar and little-endian:
+//! - header: the 8 characters "STELEPHB", quint32 version (1), quint32 number of bodies,
+//!   and for every body a quint32 length followed by its English name in UTF-8;
+//! - blocks until the end of the file: quint32 number of dates n, n doubles with the JD, and for every body
+//!   n doubles each of right ascension, declination, distance and heliocentric distance.
+class BatchEphemeris
+{
+public:
+	enum Format
+	{
+		Csv,
+		Binary
+	};
+
+	//! Computes the positions of the bodies. A new source is created for every chunk on the thread which computes it,
+	//! so implementations need not be thread-safe.
+	class Source
+	{
+	public:
+		virtual ~Source() {}
+		//! Compute, for every body at JD (UT), the J2000 equatorial position relative to the observer in AU
+		//! and the distance from the Sun in AU. The arrays have one element per body.
+		virtual void compute(double JD, Vec3d* positions, double* heliocentricDistances) = 0;
+	};
+	typedef QSharedPointer<Source> SourceP;
+
+	//! Set up a generator for the current observer and the current settings of the core.
+	BatchEphemeris(const SolarSystem* solarSystem, StelCore* core);
+	//! Set up a generator for the named bodies whose positions come from the sources made by createSource.
+	//! Used by the tests, which run without StelApp. setObjects() must not be called on such a generator.
+	BatchEphemeris(const QStringList& englishNames, const std::function<SourceP()>& createSource);
+
+	//! Set the bodies by English name.
+	//! @return false if a body is not known, see errorString()
+	bool setObjects(const QStringList& englishNames);
+	//! Set the dates: from startJD to stopJD (inclusive, UT) in steps of step days.
+	void setRange(double startJD, double stopJD, double step);
+	void setFormat(Format format) { this->format = format; }
+	//! Number of dates computed per chunk.
+	void setChunkSize(int steps) { chunkSize = qMax(1, steps); }
+	//! Number of threads, 0 means one per CPU core.
+	void setThreadCount(int threads) { threadCount = threads; }
+
+	//! Number of rows write() produces with the current settings.
+	qint64 rowCount() const;
+	//! Compute the ephemeris and write it to device. With a null device the rows are computed and encoded, but dropped.
+	//! @return the number of rows written, or -1 on error, see errorString()
+	qint64 write(QIODevice* device);
+	//! Write to a file, the format is not changed.
+	qint64 writeFile(const QString& fileName);
+	QString errorString() const { return error; }
+
+	//! The format implied by a file name: Csv for names ending in .csv, Binary otherwise.
+	static Format formatForFileName(const QString& fileName);
+
+private:
+	Q_DISABLE_COPY(BatchEphemeris)
+	QByteArray encodeHeader() const;
+	//! Compute and encode the dates with indices [firstStep, firstStep+steps). Runs on a worker thread.
+	QByteArray computeChunk(qint64 firstStep, int steps) const;
+
+	const SolarSystem* solarSystem;
+	QList<PlanetP> objects;
+	QStringList objectNames;
+	std::function<SourceP()> createSource;
+	double startJD;
+	double step;
+	qint64 stepCount;
+	Format format;
+	int chunkSize;
+	int threadCount;
+	QString error;
+};
+
+#endif // BATCHEPHEMERIS_HPP
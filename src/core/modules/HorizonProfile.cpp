@@ -0,0 +1,262 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "HorizonProfile.hpp"
+#include "StelUtils.hpp"
+
+#include <QHash>
+#include <QImage>
+
+#include <cmath>
+
+namespace
+{
+//! Return the image with its alpha channel only, one byte per pixel.
+QImage toAlpha(const QImage& image)
+{
+	return image.convertToFormat(QImage::Format_Alpha8);
+}
+
+//! Return x in 0..1
+float wrap1(float x)
+{
+	x -= std::floor(x);
+	return x<1.f ? x : 0.f;
+}
+}
+
+HorizonProfile::HorizonProfile()
+	: nbAltitudes(0)
+	, altBottom(0.f)
+	, rowsPerRadian(0.f)
+	, columnsPerRadian(0.f)
+	, rotation(0.f)
+{
+}
+
+void HorizonProfile::clear()
+{
+	columns.clear();
+	bands.clear();
+	nbAltitudes = 0;
+}
+
+void HorizonProfile::build(int nbAzimuths, int nbAlt, float altBot, float altTop, const QVector<uchar>& alpha)
+{
+	clear();
+	if (nbAzimuths<=0 || nbAlt<=0 || altTop<=altBot)
+		return;
+	Q_ASSERT(alpha.size()==nbAzimuths*nbAlt);
+
+	nbAltitudes = nbAlt;
+	altBottom = altBot;
+	rowsPerRadian = nbAlt/(altTop-altBot);
+	columnsPerRadian = nbAzimuths/(2.f*M_PIf);
+
+	// Sine of the bottom of each row, and of the top of the last one
+	QVector<float> sinRow(nbAlt+1);
+	for (int r=0; r<=nbAlt; ++r)
+		sinRow[r] = std::sin(altBot + r/rowsPerRadian);
+
+	columns.resize(nbAzimuths);
+	for (int c=0; c<nbAzimuths; ++c)
+	{
+		const uchar* col = alpha.constData() + c*nbAlt;
+		int first = 0;
+		while (first<nbAlt && col[first]==255)
+			++first;
+		int last = nbAlt-1;
+		while (last>=first && col[last]==0)
+			--last;
+
+		Column& column = columns[c];
+		column.sinBottom = sinRow[first];
+		column.sinTop = sinRow[last+1];
+		column.bandOffset = bands.size();
+		column.bandRow = static_cast<short>(first);
+		column.bandSize = static_cast<short>(last+1-first);
+		for (int r=first; r<=last; ++r)
+			bands.append(col[r]);
+	}
+	bands.squeeze();
+}
+
+void HorizonProfile::buildEquirectangular(const QImage& image, float altTop, float altBot, float angleRotateZ)
+{
+	if (image.isNull())
+	{
+		clear();
+		return;
+	}
+	const QImage alphaImage = toAlpha(image);
+	const int width = alphaImage.width();
+	const int height = alphaImage.height();
+	const int nbAz = qMin(width, MaxAzimuths);
+	const int nbAlt = qMin(height, MaxAltitudes);
+
+	// The left border of the image is East when angleRotateZ is 0.
+	QVector<int> x(nbAz);
+	for (int c=0; c<nbAz; ++c)
+	{
+		const float az = (c+0.5f)*2.f*M_PIf/nbAz;
+		x[c] = qMin(static_cast<int>(wrap1((az - M_PI_2f - angleRotateZ)/(2.f*M_PIf))*width), width-1);
+	}
+	QVector<uchar> alpha(nbAz*nbAlt);
+	for (int r=0; r<nbAlt; ++r)
+	{
+		const float y_img_1 = (r+0.5f)/nbAlt; // altitude in 0..1 image height from bottom
+		const int y = qBound(0, static_cast<int>((1.f-y_img_1)*height), height-1);
+		const uchar* line = alphaImage.constScanLine(y);
+		for (int c=0; c<nbAz; ++c)
+			alpha[c*nbAlt+r] = line[x[c]];
+	}
+	build(nbAz, nbAlt, altBot, altTop, alpha);
+}
+
+void HorizonProfile::buildFisheye(const QImage& image, float texFov, float angleRotateZ)
+{
+	if (image.isNull())
+	{
+		clear();
+		return;
+	}
+	const QImage alphaImage = toAlpha(image);
+	const int width = alphaImage.width();
+	const int height = alphaImage.height();
+	// The circle of the horizon is about pi*height pixels long, and the radius height/2 pixels.
+	const int nbAz = qBound(1, static_cast<int>(M_PIf*height), MaxAzimuths);
+	const int nbAlt = qBound(1, height/2, MaxAltitudes);
+	const float altBot = M_PI_2f - qMin(texFov, 2.f*M_PIf)*0.5f;
+
+	QVector<float> sinAz(nbAz), cosAz(nbAz);
+	for (int c=0; c<nbAz; ++c)
+	{
+		// The image has south on top, east at right (if angleRotateZ=0)
+		const float az = (c+0.5f)*2.f*M_PIf/nbAz - angleRotateZ;
+		sinAz[c] = std::sin(az);
+		cosAz[c] = std::cos(az);
+	}
+	QVector<uchar> alpha(nbAz*nbAlt);
+	for (int r=0; r<nbAlt; ++r)
+	{
+		const float alt = altBot + (r+0.5f)*(M_PI_2f-altBot)/nbAlt;
+		const float radius = (M_PI_2f-alt)*2.f/texFov; // radius in units of height/2
+		for (int c=0; c<nbAz; ++c)
+		{
+			const int x = qBound(0, static_cast<int>(height/2*(1.f + radius*sinAz[c])), width-1);
+			const int y = qBound(0, static_cast<int>(height/2*(1.f + radius*cosAz[c])), height-1);
+			alpha[c*nbAlt+r] = alphaImage.constScanLine(y)[x];
+		}
+	}
+	build(nbAz, nbAlt, altBot, M_PI_2f, alpha);
+}
+
+void HorizonProfile::buildPanels(const QVector<Panel>& panels, int nbDecorRepeat, float decorAltAngle, float decorAngleShift,
+				 float angleRotateZ, bool tanMode)
+{
+	clear();
+	if (panels.isEmpty() || nbDecorRepeat<=0 || decorAltAngle<=0.f)
+		return;
+
+	QHash<const QImage*, QImage> alphaImages;
+	int panoWidth = 0;
+	int panoHeight = 1;
+	for (const auto& panel : panels)
+	{
+		if (!panel.image || panel.image->isNull())
+			return; // can happen if image is misconfigured and failed to load.
+		if (!alphaImages.contains(panel.image))
+			alphaImages.insert(panel.image, toAlpha(*panel.image));
+		panoWidth += static_cast<int>(std::fabs(panel.texCoords[2]-panel.texCoords[0])*panel.image->width());
+		panoHeight = qMax(panoHeight, static_cast<int>(std::fabs(panel.texCoords[3]-panel.texCoords[1])*panel.image->height()));
+	}
+	const int nbSide = panels.size();
+	const int nbAz = qBound(1, panoWidth*nbDecorRepeat, MaxAzimuths);
+	const int nbAlt = qMin(panoHeight, MaxAltitudes);
+	const float altBot = decorAngleShift*M_PI_180f;
+	const float altTop = (decorAltAngle+decorAngleShift)*M_PI_180f;
+
+	// Altitude of each row in 0..1 visible image height from bottom
+	QVector<float> y_img_1(nbAlt);
+	const float tanTop = std::tan(altTop);
+	const float tanBot = std::tan(altBot);
+	for (int r=0; r<nbAlt; ++r)
+	{
+		const float alt = altBot + (r+0.5f)*(altTop-altBot)/nbAlt;
+		y_img_1[r] = tanMode ? (std::tan(alt)-tanBot)/(tanTop-tanBot) : (r+0.5f)/nbAlt;
+	}
+
+	QVector<uchar> alpha(nbAz*nbAlt);
+	for (int c=0; c<nbAz; ++c)
+	{
+		const float az = (c+0.5f)*2.f*M_PIf/nbAz;
+		// The left border of the first panel is East when angleRotateZ is 0.
+		const float az_phot = wrap1((az - M_PI_2f - angleRotateZ)/(2.f*M_PIf));  // 0..1 = image-X for a non-repeating pano photo
+		const float az_panel = nbSide*nbDecorRepeat*az_phot;                      // azimuth in "panel space"
+		const float x_in_panel = az_panel - std::floor(az_panel);
+		const Panel& panel = panels[static_cast<int>(std::floor(az_panel)) % nbSide];
+		const QImage& image = alphaImages[panel.image];
+		const int x = qBound(0, static_cast<int>((panel.texCoords[0] + x_in_panel*(panel.texCoords[2]-panel.texCoords[0]))*image.width()), image.width()-1);
+		for (int r=0; r<nbAlt; ++r)
+		{
+			// x0/y0 is lower left, x1/y1 upper right corner. QImage has pixel 0/0 in top left corner.
+			const float y_baseImg_1 = panel.texCoords[1] + y_img_1[r]*(panel.texCoords[3]-panel.texCoords[1]);
+			const int y = qBound(0, static_cast<int>((1.f-y_baseImg_1)*image.height()), image.height()-1);
+			alpha[c*nbAlt+r] = image.constScanLine(y)[x];
+		}
+	}
+	build(nbAz, nbAlt, altBot, altTop, alpha);
+}
+
+float HorizonProfile::getColumnOpacity(const Column& column, double z, double r) const
+{
+	const double len = std::sqrt(r*r + z*z);
+	if (z < column.sinBottom*len)
+		return 1.f;
+	if (z >= column.sinTop*len)
+		return 0.f;
+	const int row = qBound(static_cast<int>(column.bandRow),
+			       static_cast<int>((static_cast<float>(std::atan2(z, r))-altBottom)*rowsPerRadian),
+			       column.bandRow+column.bandSize-1);
+	return bands.at(column.bandOffset + row - column.bandRow)/255.f;
+}
+
+float HorizonProfile::getOpacity(const Vec3d& azalt) const
+{
+	if (columns.isEmpty())
+		return azalt[2]>0.0 ? 0.0f : 1.0f;
+	// Azimuth counted from North towards East
+	const float az = M_PIf - static_cast<float>(std::atan2(azalt[1], azalt[0])) - rotation;
+	const int nbAz = columns.size();
+	int c = static_cast<int>(std::floor(az*columnsPerRadian)) % nbAz;
+	if (c<0)
+		c += nbAz;
+	return getColumnOpacity(columns.at(c), azalt[2], std::sqrt(azalt[0]*azalt[0]+azalt[1]*azalt[1]));
+}
+
+void HorizonProfile::getOpacity(int n, const Vec3d* azalt, float* opacity) const
+{
+	for (int i=0; i<n; ++i)
+		opacity[i] = getOpacity(azalt[i]);
+}
+
+int HorizonProfile::getMemorySize() const
+{
+	return static_cast<int>(sizeof(HorizonProfile)) + columns.size()*static_cast<int>(sizeof(Column)) + bands.size();
+}
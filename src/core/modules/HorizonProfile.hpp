@@ -0,0 +1,122 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef HORIZONPROFILE_HPP
+#define HORIZONPROFILE_HPP
+
+#include "VecMath.hpp"
+
+#include <QVector>
+
+class QImage;
+
+//! @class HorizonProfile
+//! Compact description of the opacity of a landscape, used to answer opacity queries without keeping the landscape images in memory.
+//! The sky is divided in columns of equal azimuth, and the part of the panorama covered by the image in rows of equal altitude.
+//! For each column, the profile keeps the altitude below which the landscape is fully opaque and the altitude above which it is
+//! fully transparent. The opacity of the rows between these two altitudes (tree tops, fences, windows...) is kept in a band
+//! of one byte per row, so that columns with a sharp horizon cost no more than their two altitudes.
+//! Below the image, the landscape is opaque; above, it is transparent.
+//! A query costs one atan2 for the azimuth, and one more for the altitude when the direction falls into a band.
+class HorizonProfile
+{
+public:
+	//! A side panel of an old_style landscape
+	struct Panel
+	{
+		const QImage* image;
+		//! Left, bottom, right and top coordinates of the panel in its image, in 0..1.
+		float texCoords[4];
+	};
+
+	HorizonProfile();
+
+	//! Build the profile from a grid of opacities.
+	//! @param nbAzimuths the number of columns, starting at North and going towards East.
+	//! @param nbAltitudes the number of rows, starting at altBottom.
+	//! @param altBottom altitude of the bottom of the grid, radians.
+	//! @param altTop altitude of the top of the grid, radians.
+	//! @param alpha the opacities (0..255), nbAltitudes values per column.
+	void build(int nbAzimuths, int nbAltitudes, float altBottom, float altTop, const QVector<uchar>& alpha);
+
+	//! Build the profile of the equirectangular image of a spherical landscape.
+	//! @param altTop altitude of the top line of the image, radians.
+	//! @param altBottom altitude of the bottom line of the image, radians.
+	//! @param angleRotateZ azimuth rotation of the image, radians. If 0, the left border is due east.
+	void buildEquirectangular(const QImage& image, float altTop, float altBottom, float angleRotateZ);
+	//! Build the profile of the image of a fisheye landscape, centered on the zenith with south on top.
+	//! @param texFov field of view of the image, radians.
+	//! @param angleRotateZ azimuth rotation of the image, radians.
+	void buildFisheye(const QImage& image, float texFov, float angleRotateZ);
+	//! Build the profile of the side panels of a calibrated old_style landscape.
+	//! @param panels the panels from East towards North, repeated nbDecorRepeat times around the horizon.
+	//! @param decorAltAngle vertical extent of the panels, degrees.
+	//! @param decorAngleShift altitude of the bottom of the panels, degrees.
+	//! @param angleRotateZ azimuth rotation of the panels, radians. If 0, the left border of the first panel is due east.
+	//! @param tanMode true for cylindrical panoramas, false for equirectangular ones.
+	void buildPanels(const QVector<Panel>& panels, int nbDecorRepeat, float decorAltAngle, float decorAngleShift,
+			 float angleRotateZ, bool tanMode);
+
+	//! Remove the profile.
+	void clear();
+	//! Return true if the profile has been built.
+	bool isValid() const {return !columns.isEmpty();}
+
+	//! Set an azimuth rotation applied to the queries after the profile has been built, radians (see Landscape::setZRotation()).
+	void setZRotation(float angle) {rotation = angle;}
+
+	//! Find the opacity in a direction.
+	//! @param azalt direction in the alt-az frame, not necessarily normalized.
+	//! @retval alpha (0=fully transparent, 1=fully opaque)
+	float getOpacity(const Vec3d& azalt) const;
+	//! Find the opacity in n directions.
+	void getOpacity(int n, const Vec3d* azalt, float* opacity) const;
+
+	//! Return the number of columns and rows of the profile.
+	int getNbAzimuths() const {return columns.size();}
+	int getNbAltitudes() const {return nbAltitudes;}
+	//! Return the number of bytes used by the profile.
+	int getMemorySize() const;
+
+	//! The maximum size of the grid built from an image
+	static const int MaxAzimuths = 8192;
+	static const int MaxAltitudes = 2048;
+
+private:
+	struct Column
+	{
+		float sinBottom;  //!< Sine of the altitude below which the column is fully opaque
+		float sinTop;     //!< Sine of the altitude above which the column is fully transparent
+		int bandOffset;   //!< Index of the first row of the band in bands
+		short bandRow;    //!< First row of the band
+		short bandSize;   //!< Number of rows of the band
+	};
+
+	float getColumnOpacity(const Column& column, double z, double r) const;
+
+	QVector<Column> columns;
+	QVector<uchar> bands;
+	int nbAltitudes;
+	float altBottom;
+	float rowsPerRadian;
+	float columnsPerRadian;
+	float rotation;
+};
+
+#endif // HORIZONPROFILE_HPP
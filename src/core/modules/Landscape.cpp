@@ -39,6 +39,8 @@
 #include <QDir>
 #include <QtAlgorithms>
 
+#include <algorithm>
+
 Landscape::Landscape(float _radius)
 	: radius(static_cast<double>(_radius))
 	, id("uninitialized")
@@ -264,6 +266,17 @@ const QString Landscape::getTexturePath(const QString& basename, const QString&
 	return path;
 }
 
+void Landscape::getOpacity(int n, const Vec3d* azalt, float* opacity) const
+{
+	if (horizonProfile.isValid())
+	{
+		horizonProfile.getOpacity(n, azalt, opacity);
+		return;
+	}
+	for (int i=0; i<n; ++i)
+		opacity[i] = getOpacity(azalt[i]);
+}
+
 // find optional file and fill landscapeLabels list.
 void Landscape::loadLabels(const QString& landscapeId)
 {
@@ -391,11 +404,6 @@ LandscapeOldStyle::~LandscapeOldStyle()
 	}
 
 	if (sides) delete [] sides;
-	if (sidesImages.size()>0)
-	{
-		qDeleteAll(sidesImages);
-		sidesImages.clear();
-	}
 	landscapeLabels.clear();
 }
 
@@ -431,23 +439,19 @@ void LandscapeOldStyle::load(const QSettings& landscapeIni, const QString& lands
 	// Load sides textures
 	nbSideTexs = static_cast<unsigned short>(landscapeIni.value("landscape/nbsidetex", 0).toUInt());
 	sideTexs = new StelTextureSP[static_cast<size_t>(nbSideTexs)*2]; // 0.14: allow upper half for light textures!
+	// GZ: To query the textures, also load them as images, but only
+	// if that query is not going to be prevented by the polygon that already has been loaded at that point...
+	// The images are only kept until the horizon profile has been built.
+	const bool buildProfile = (!horizonPolygon) && calibrated; // for uncalibrated landscapes the texture is currently never queried, so no need to load.
+	QVector<QImage> sidesImages;
 	for (unsigned int i=0; i<nbSideTexs; ++i)
 	{
 		QString textureKey = QString("landscape/tex%1").arg(i);
 		QString textureName = landscapeIni.value(textureKey).toString();
 		const QString texturePath = getTexturePath(textureName, landscapeId);
 		sideTexs[i] = StelApp::getInstance().getTextureManager().createTexture(texturePath);
-		// GZ: To query the textures, also keep an array of QImage*, but only
-		// if that query is not going to be prevented by the polygon that already has been loaded at that point...
-		if ( (!horizonPolygon) && calibrated ) { // for uncalibrated landscapes the texture is currently never queried, so no need to store.
-			QImage *image = new QImage(texturePath);
-			sidesImages.append(image); // indices identical to those in sideTexs
-#if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
-			memorySize+=(image->sizeInBytes());
-#else
-			memorySize+=static_cast<uint>(image->byteCount());
-#endif
-		}
+		if (buildProfile)
+			sidesImages.append(QImage(texturePath)); // indices identical to those in sideTexs
 		// Also allow light textures. The light textures must cover the same geometry as the sides. It is allowed that not all or even any light textures are present!
 		textureKey = QString("landscape/light%1").arg(i);
 		textureName = landscapeIni.value(textureKey).toString();
@@ -461,10 +465,7 @@ void LandscapeOldStyle::load(const QSettings& landscapeIni, const QString& lands
 		else
 			sideTexs[nbSideTexs+i].clear();
 	}
-	if ( (!horizonPolygon) && calibrated )
-	{
-		Q_ASSERT(sidesImages.size()==nbSideTexs);
-	}
+	Q_ASSERT(!buildProfile || sidesImages.size()==nbSideTexs);
 	QMap<unsigned int, unsigned int> texToSide;
 	// Init sides parameters
 	nbSide = static_cast<unsigned short>(landscapeIni.value("landscape/nbside", 0).toUInt());
@@ -495,6 +496,25 @@ void LandscapeOldStyle::load(const QSettings& landscapeIni, const QString& lands
 		// Maybe this can be again simplified?
 		texToSide[i] = texnum;
 	}
+	if (buildProfile)
+	{
+		// Side i shows the texture texToSide[i] with the texture coordinates of that texture, like in the precomputed sides below.
+		QVector<HorizonProfile::Panel> panels;
+		for (unsigned int i=0;i<nbSide;++i)
+		{
+			const unsigned int ti = texToSide[i];
+			if (ti>=nbSideTexs || ti>=nbSide)
+				break;
+			HorizonProfile::Panel panel;
+			panel.image = &sidesImages.at(static_cast<int>(ti));
+			std::copy(sides[ti].texCoords, sides[ti].texCoords+4, panel.texCoords);
+			panels.append(panel);
+		}
+		if (panels.size()==nbSide)
+			horizonProfile.buildPanels(panels, nbDecorRepeat, decorAltAngle, decorAngleShift, angleRotateZ, tanMode);
+		horizonProfile.setZRotation(angleRotateZOffset);
+		memorySize+=static_cast<uint>(horizonProfile.getMemorySize());
+	}
 	const QString groundTexName = landscapeIni.value("landscape/groundtex").toString();
 	const QString groundTexPath = getTexturePath(groundTexName, landscapeId);
 	groundTex = StelApp::getInstance().getTextureManager().createTexture(groundTexPath, StelTexture::StelTextureParams(true));
@@ -764,20 +784,13 @@ float LandscapeOldStyle::getOpacity(Vec3d azalt) const
 {
 	if(!validLandscape) return (azalt[2]>0.0 ? 0.0f : 1.0f);
 
-	if (angleRotateZOffset!=0.0f)
-		azalt.transfo4d(Mat4d::zrotation(static_cast<double>(angleRotateZOffset)));
-
 	// in case we also have a horizon polygon defined, this is trivial and fast.
 	if (horizonPolygon)
 	{
+		if (angleRotateZOffset!=0.0f)
+			azalt.transfo4d(Mat4d::zrotation(static_cast<double>(angleRotateZOffset)));
 		if (horizonPolygon->contains(azalt)) return 1.0f; else return 0.0f;
 	}
-	// Else, sample the images...
-	float az, alt_rad;
-	StelUtils::rectToSphe(&az, &alt_rad, azalt);
-
-	if (alt_rad < decorAngleShift*M_PI_180f) return 1.0f; // below decor, i.e. certainly opaque ground.
-	if (alt_rad > (decorAltAngle+decorAngleShift)*M_PI_180f) return 0.0f; // above decor, i.e. certainly free sky.
 	if (!calibrated) // the result of this function has no real use here: just complain and return result for math. horizon.
 	{
 		static QString lastLandscapeName;
@@ -788,61 +801,8 @@ float LandscapeOldStyle::getOpacity(Vec3d azalt) const
 		}
 		return (azalt[2] > 0 ? 0.0f : 1.0f);
 	}
-	az = (M_PIf-az) / M_PIf;                             //  0..2 = N.E.S.W.N
-	// we go to 0..1 domain, it's easier to think.
-	const float xShift=angleRotateZ /(2.0f*M_PIf); // shift value in -1..1 domain
-	Q_ASSERT(xShift >= -1.0f);
-	Q_ASSERT(xShift <=  1.0f);
-	float az_phot=az*0.5f - 0.25f - xShift;      // The 0.25 is caused by regular pano left edge being East. The xShift compensates any configured angleRotateZ
-	az_phot=fmodf(az_phot, 1.0f);
-	if (az_phot<0) az_phot+=1.0f;                                //  0..1 = image-X for a non-repeating pano photo
-	float az_panel =  nbSide*nbDecorRepeat * az_phot; // azimuth in "panel space". Ex for nbS=4, nbDR=3: [0..[12, say 11.4
-	float x_in_panel=fmodf(az_panel, 1.0f);
-	int currentSide = static_cast<int>(floor(fmodf(az_panel, nbSide)));
-	Q_ASSERT(currentSide>=0);
-	Q_ASSERT(currentSide<static_cast<int>(nbSideTexs));
-	if (sidesImages[currentSide]->isNull()) return 0.0f; // can happen if image is misconfigured and failed to load.
-	int x= static_cast<int>(sides[currentSide].texCoords[0] + x_in_panel*(sides[currentSide].texCoords[2]-sides[currentSide].texCoords[0]))
-			* sidesImages[currentSide]->width(); // pixel X from left.
-
-	// QImage has pixel 0/0 in top left corner. We must find image Y for optionally cropped images.
-	// It should no longer be possible that sample position is outside cropped texture. in this case, assert(0) but again assume full transparency and exit early.
-
-	float y_img_1; // y of the sampled altitude in 0..1 visible image height from bottom
-	if (tanMode)
-	{
-		const float tanAlt=std::tan(alt_rad);
-		const float tanTop=std::tan((decorAltAngle+decorAngleShift)*M_PI_180f);
-		const float tanBot=std::tan(decorAngleShift*M_PI_180f);
-		y_img_1=(tanAlt-tanBot)/(tanTop-tanBot); // Y position 0..1 in visible image height from bottom
-	}
-	else
-	{ // adapted from spherical...
-		const float alt_pm1 = 2.0f * alt_rad  / M_PIf;  // sampled altitude, -1...+1 linear in altitude angle
-		const float img_top_pm1 = 1.0f-( (90.0f-decorAltAngle-decorAngleShift) / 90.0f); // the top line in -1..+1 (angular)
-		if (alt_pm1>img_top_pm1) { Q_ASSERT(0); return 0.0f; } // should have been caught above with alt_rad tests
-		const float img_bot_pm1 = 1.0f-((90.0f-decorAngleShift) / 90.0f); // the bottom line in -1..+1 (angular)
-		if (alt_pm1<img_bot_pm1) { Q_ASSERT(0); return 1.0f; } // should have been caught above with alt_rad tests
-
-		y_img_1=(alt_pm1-img_bot_pm1)/(img_top_pm1-img_bot_pm1); // the sampled altitude in 0..1 visible image height from bottom
-		Q_ASSERT(y_img_1<=1.f);
-		Q_ASSERT(y_img_1>=0.f);
-	}
-	// x0/y0 is lower left, x1/y1 upper right corner.
-	float y_baseImg_1 = sides[currentSide].texCoords[1]+ y_img_1*(sides[currentSide].texCoords[3]-sides[currentSide].texCoords[1]);
-	int y=static_cast<int>((1.0f-y_baseImg_1)*static_cast<float>(sidesImages[currentSide]->height()));           // pixel Y from top.
-	QRgb pixVal=sidesImages[currentSide]->pixel(x, y);
-/*
-#ifndef NDEBUG
-	// GZ: please leave the comment available for further development!
-	qDebug() << "Oldstyle Landscape sampling: az=" << az*180.0 << "° alt=" << alt_rad*180.0f/M_PI
-			 << "°, xShift[-1..+1]=" << xShift << " az_phot[0..1]=" << az_phot
-			 << " --> current side panel " << currentSide
-			 << ", w=" << sidesImages[currentSide]->width() << " h=" << sidesImages[currentSide]->height()
-			 << " --> x:" << x << " y:" << y << " alpha:" << qAlpha(pixVal)/255.0f;
-#endif
-*/
-	return qAlpha(pixVal)/255.0f;
+	// Else, look up the profile of the side panels. (Without profile, e.g. if an image is misconfigured and failed to load, this is the math. horizon.)
+	return horizonProfile.getOpacity(azalt);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -932,7 +892,6 @@ LandscapeFisheye::LandscapeFisheye(float _radius)
 	, mapTex(StelTextureSP())
 	, mapTexFog(StelTextureSP())
 	, mapTexIllum(StelTextureSP())
-	, mapImage(Q_NULLPTR)
 	, texFov(360.)
 {
 	memorySize=sizeof(LandscapeFisheye);
@@ -940,7 +899,6 @@ LandscapeFisheye::LandscapeFisheye(float _radius)
 
 LandscapeFisheye::~LandscapeFisheye()
 {
-	if (mapImage) delete mapImage;
 	landscapeLabels.clear();
 }
 
@@ -975,12 +933,10 @@ void LandscapeFisheye::create(const QString _name, float _texturefov, const QStr
 
 	if (!horizonPolygon)
 	{
-		mapImage = new QImage(_maptex);
-#if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
-		memorySize+=(mapImage->sizeInBytes());
-#else
-		memorySize+=static_cast<uint>(mapImage->byteCount());
-#endif
+		// The image is only used to sample its opacity into the horizon profile.
+		horizonProfile.buildFisheye(QImage(_maptex), texFov, angleRotateZ);
+		horizonProfile.setZRotation(angleRotateZOffset);
+		memorySize+=static_cast<uint>(horizonProfile.getMemorySize());
 	}
 	mapTex = StelApp::getInstance().getTextureManager().createTexture(_maptex, StelTexture::StelTextureParams(true));
 	memorySize+=mapTex->getGlSize();
@@ -1058,42 +1014,17 @@ void LandscapeFisheye::draw(StelCore* core, bool onlyPolygon)
 
 float LandscapeFisheye::getOpacity(Vec3d azalt) const
 {
-	if(!validLandscape || (!horizonPolygon && (!mapImage || mapImage->isNull()))) return (azalt[2]>0.0 ? 0.0f : 1.0f); // can happen if image is misconfigured and failed to load.
-
-	if (angleRotateZOffset!=0.0f)
-		azalt.transfo4d(Mat4d::zrotation(static_cast<double>(angleRotateZOffset)));
+	if(!validLandscape || (!horizonPolygon && !horizonProfile.isValid())) return (azalt[2]>0.0 ? 0.0f : 1.0f); // can happen if image is misconfigured and failed to load.
 
 	// in case we also have a horizon polygon defined, this is trivial and fast.
 	if (horizonPolygon)
 	{
+		if (angleRotateZOffset!=0.0f)
+			azalt.transfo4d(Mat4d::zrotation(static_cast<double>(angleRotateZOffset)));
 		if (horizonPolygon->contains(azalt)) return 1.0f; else return 0.0f;
 	}
-	// Else, sample the image...
-	float az, alt_rad;
-	StelUtils::rectToSphe(&az, &alt_rad, azalt);
-
-	// QImage has pixel 0/0 in top left corner.
-	// The texture is taken from the center circle in the square texture.
-	// It is possible that sample position is outside. in this case, assume full opacity and exit early.
-	if (M_PI_2f-alt_rad > texFov/2.0f ) return 1.0f; // outside fov, in the clamped texture zone: always opaque.
-
-	float radius=(M_PI_2f-alt_rad)*2.0f/texFov; // radius in units of mapImage.height/2
-
-	az = (M_PIf-az) - static_cast<float>(angleRotateZ); // 0..+2pi -angleRotateZ, real azimuth. NESW
-	//  The texture map has south on top, east at right (if anglerotateZ=0)
-	int x= static_cast<int>(mapImage->height()/2*(1 + radius*std::sin(az)));
-	int y= static_cast<int>(mapImage->height()/2*(1 + radius*std::cos(az)));
-
-	QRgb pixVal=mapImage->pixel(x, y);
-/*
-#ifndef NDEBUG
-	// GZ: please leave the comment available for further development!
-	qDebug() << "Landscape sampling: az=" << (az+angleRotateZ)/M_PI*180.0f << "° alt=" << alt_rad/M_PI*180.f
-			 << "°, w=" << mapImage->width() << " h=" << mapImage->height()
-			 << " --> x:" << x << " y:" << y << " alpha:" << qAlpha(pixVal)/255.0f;
-#endif
-*/
-	return qAlpha(pixVal)/255.0f;
+	// Else, look up the profile sampled from the image.
+	return horizonProfile.getOpacity(azalt);
 }
 /////////////////////////////////////////////////////////////////////////////////////////////////
 // spherical panoramas
@@ -1110,7 +1041,6 @@ LandscapeSpherical::LandscapeSpherical(float _radius)
 	, fogTexBottom(0.)
 	, illumTexTop(0.)
 	, illumTexBottom(0.)
-	, mapImage(Q_NULLPTR)
 	, bottomCapColor(-1.0f, 0.0f, 0.0f)
 {
 	memorySize=sizeof(LandscapeSpherical);
@@ -1118,7 +1048,6 @@ LandscapeSpherical::LandscapeSpherical(float _radius)
 
 LandscapeSpherical::~LandscapeSpherical()
 {
-	if (mapImage) delete mapImage;
 	landscapeLabels.clear();
 }
 
@@ -1175,12 +1104,10 @@ void LandscapeSpherical::create(const QString _name, const QString& _maptex, con
 	illumTexBottom= (90.f-_illumTexBottom)*M_PI_180f;
 	if (!horizonPolygon)
 	{
-		mapImage = new QImage(_maptex);
-#if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
-		memorySize+=(mapImage->sizeInBytes());
-#else
-		memorySize+=static_cast<uint>(mapImage->byteCount());
-#endif
+		// The image is only used to sample its opacity into the horizon profile.
+		horizonProfile.buildEquirectangular(QImage(_maptex), M_PI_2f-mapTexTop, M_PI_2f-mapTexBottom, angleRotateZ);
+		horizonProfile.setZRotation(angleRotateZOffset);
+		memorySize+=static_cast<uint>(horizonProfile.getMemorySize());
 	}
 	mapTex = StelApp::getInstance().getTextureManager().createTexture(_maptex, StelTexture::StelTextureParams(true));
 	memorySize+=mapTex->getGlSize();
@@ -1278,53 +1205,15 @@ void LandscapeSpherical::draw(StelCore* core, bool onlyPolygon)
 //! @retval alpha (0..1), where 0=fully transparent.
 float LandscapeSpherical::getOpacity(Vec3d azalt) const
 {
-	if(!validLandscape || (!horizonPolygon && (!mapImage || mapImage->isNull()))) return (azalt[2]>0.0 ? 0.0f : 1.0f); // can happen if image is misconfigured and failed to load.
-
-	if (angleRotateZOffset!=0.0f)
-		azalt.transfo4d(Mat4d::zrotation(static_cast<double>(angleRotateZOffset)));
+	if(!validLandscape || (!horizonPolygon && !horizonProfile.isValid())) return (azalt[2]>0.0 ? 0.0f : 1.0f); // can happen if image is misconfigured and failed to load.
 
 	// in case we also have a horizon polygon defined, this is trivial and fast.
 	if (horizonPolygon)
 	{
+		if (angleRotateZOffset!=0.0f)
+			azalt.transfo4d(Mat4d::zrotation(static_cast<double>(angleRotateZOffset)));
 		if (horizonPolygon->contains(azalt)) return 1.0f; else return 0.0f;
 	}
-	// Else, sample the image...
-	float az, alt_rad;
-	StelUtils::rectToSphe(&az, &alt_rad, azalt);
-
-	// QImage has pixel 0/0 in top left corner. We must first find image Y for optionally cropped images.
-	// It is possible that sample position is outside cropped texture. in this case, assume full transparency and exit early.
-
-	const float alt_pm1 = 2.0f * alt_rad / M_PIf;               // sampled altitude, -1...+1 linear in altitude angle
-	const float img_top_pm1 = 1.0f-2.0f*(mapTexTop    / M_PIf); // the top    line in -1..+1
-	if (alt_pm1>img_top_pm1) return 0.0f;
-	const float img_bot_pm1 = 1.0f-2.0f*(mapTexBottom / M_PIf); // the bottom line in -1..+1
-	if (alt_pm1<img_bot_pm1) return 1.0f; // rare case of a hole in the ground. Even though there is a visible hole, play opaque.
-
-	float y_img_1=(alt_pm1-img_bot_pm1)/(img_top_pm1-img_bot_pm1); // the sampled altitude in 0..1 image height from bottom
-	Q_ASSERT(y_img_1<=1.f);
-	Q_ASSERT(y_img_1>=0.f);
-
-	int y=static_cast<int>((1.0f-y_img_1)*mapImage->height());           // pixel Y from top.
-
-	az = (M_PIf-az) / M_PIf;                            //  0..2 = N.E.S.W.N
-
-	const float xShift=static_cast<float>(angleRotateZ) /M_PIf; // shift value in -2..2
-	float az_phot=az - 0.5f - xShift;      // The 0.5 is caused by regular pano left edge being East. The xShift compensates any configured angleRotateZ
-	az_phot=fmodf(az_phot, 2.0f);
-	if (az_phot<0) az_phot+=2.0f;                                //  0..2 = image-X
-
-	int x=static_cast<int>((az_phot*0.5f) * mapImage->width()); // pixel X from left.
-
-	QRgb pixVal=mapImage->pixel(x, y);
-/*
-#ifndef NDEBUG
-	// GZ: please leave the comment available for further development!
-	qDebug() << "Landscape sampling: az=" << az*180.0 << "° alt=" << alt_pm1*90.0f
-			 << "°, xShift[-2..+2]=" << xShift << " az_phot[0..2]=" << az_phot
-			 << ", w=" << mapImage->width() << " h=" << mapImage->height()
-			 << " --> x:" << x << " y:" << y << " alpha:" << qAlpha(pixVal)/255.0f;
-#endif
-*/
-	return qAlpha(pixVal)/255.0f;
+	// Else, look up the profile sampled from the image.
+	return horizonProfile.getOpacity(azalt);
 }
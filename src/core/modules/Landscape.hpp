@@ -29,6 +29,7 @@
 #include "StelTextureTypes.hpp"
 #include "StelLocation.hpp"
 #include "StelSphereGeometry.hpp"
+#include "HorizonProfile.hpp"
 
 #include <QMap>
 #include <QImage>
@@ -161,7 +162,7 @@ public:
 	//! e.g. by the LandscapeMgr. Contrary to that, the purpose of the azimuth rotation
 	//! (landscape/[decor_]angle_rotatez) in landscape.ini is to orient the pano.
 	//! @param d the rotation angle in degrees.
-	void setZRotation(float d) {angleRotateZOffset = d * static_cast<float>(M_PI)/180.0f;}
+	void setZRotation(float d) {angleRotateZOffset = d * static_cast<float>(M_PI)/180.0f; horizonProfile.setZRotation(angleRotateZOffset);}
 
 	//! Get whether the landscape is currently fully visible (i.e. opaque).
 	bool getIsFullyVisible() const {return landFader.getInterstate() >= 0.999f;}
@@ -173,6 +174,13 @@ public:
 	//! Default implementation indicates the horizon equals math horizon.
 	// TBD: Maybe change this to azalt[2]<sinMinAltitudeLimit ? (But never called in practice, reimplemented by the subclasses...)
 	virtual float getOpacity(Vec3d azalt) const { Q_ASSERT(0); return (azalt[2]<0 ? 1.0f : 0.0f); }
+	//! Find opacity in n directions, e.g. to skip the stars or nebulae hidden by the landscape.
+	//! Landscapes with a horizon profile answer from the profile without any virtual call, the others from getOpacity(Vec3d).
+	//! @param azalt n directions in alt-az frame
+	//! @param opacity receives the n opacities
+	void getOpacity(int n, const Vec3d* azalt, float* opacity) const;
+	//! Return the horizon profile used for opacity queries (may be invalid).
+	const HorizonProfile& getHorizonProfile() const {return horizonProfile;}
 	//! The list of azimuths (counted from True North towards East) and altitudes can come in various formats. We read the first two elements, which can be of formats:
 	enum horizonListMode {
 		invalid        =-1,
@@ -245,6 +253,8 @@ protected:
 					   //! For LandscapePolygonal, this is the only horizon data item.
 	Vec3f horizonPolygonLineColor;     //! for all horizon types, the horizonPolygon line, if specified, will be drawn in this color
 					   //! specified in landscape.ini[landscape]horizon_line_color. Negative red (default) indicated "don't draw".
+	HorizonProfile horizonProfile;     //! Opacity of the landscape images, built at load time when there is no horizonPolygon.
+					   //! The images themselves are not kept in memory.
 	// Optional element: labels for landscape features.
 	QList<LandscapeLabel> landscapeLabels;
 	int fontSize;     //! Used for landscape labels (optionally indicating landscape features)
@@ -276,6 +286,7 @@ public:
 	virtual void draw(StelCore* core, bool onlyPolygon) Q_DECL_OVERRIDE;
 	//void create(bool _fullpath, QMap<QString, QString> param); // still not implemented
 	virtual float getOpacity(Vec3d azalt) const Q_DECL_OVERRIDE;
+	using Landscape::getOpacity;
 protected:
 	typedef struct
 	{
@@ -297,7 +308,6 @@ private:
 	landscapeTexCoord* sides;
 	StelTextureSP fogTex;
 	StelTextureSP groundTex;
-	QVector<QImage*> sidesImages; // Required for opacity lookup
 	unsigned short int nbDecorRepeat;
 	float fogAltAngle;
 	float fogAngleShift;
@@ -335,6 +345,7 @@ public:
 	virtual void load(const QSettings& landscapeIni, const QString& landscapeId) Q_DECL_OVERRIDE;
 	virtual void draw(StelCore* core, bool onlyPolygon) Q_DECL_OVERRIDE;
 	virtual float getOpacity(Vec3d azalt) const Q_DECL_OVERRIDE;
+	using Landscape::getOpacity;
 private:
 	// we have inherited: horizonFileName, horizonPolygon, horizonPolygonLineColor
 	Vec3f groundColor; //! specified in landscape.ini[landscape]ground_color.
@@ -356,6 +367,7 @@ public:
 	//! Sample landscape texture for transparency/opacity. May be used for visibility, sunrise etc.
 	//! @param azalt normalized direction in alt-az frame
 	virtual float getOpacity(Vec3d azalt) const Q_DECL_OVERRIDE;
+	using Landscape::getOpacity;
 	//! create a fisheye landscape from basic parameters (no ini file needed).
 	//! @param name Landscape name
 	//! @param maptex the fisheye texture
@@ -371,7 +383,6 @@ private:
 				   //!< can also be smaller, just the texture is again mapped onto the same geometry.
 	StelTextureSP mapTexIllum; //!< Optional fisheye image of identical size (create as layer in your favorite image processor) or at least, proportions.
 				   //!< To simulate light pollution (skyglow), street lights, light in windows, ... at night
-	QImage *mapImage;          //!< The same image as mapTex, but stored in-mem for sampling.
 
 	float texFov;
 };
@@ -397,6 +408,7 @@ public:
 	//! @param azalt normalized direction in alt-az frame
 	//! @retval alpha (0=fully transparent, 1=fully opaque. Trees, leaves, glass etc may have intermediate values.)
 	virtual float getOpacity(Vec3d azalt) const Q_DECL_OVERRIDE;
+	using Landscape::getOpacity;
 	//! create a spherical landscape from basic parameters (no ini file needed).
 	//! @param name Landscape name
 	//! @param maptex the equirectangular texture
@@ -429,7 +441,6 @@ private:
 	float fogTexBottom;	   //!< zenithal bottom angle of the fog texture, radians
 	float illumTexTop;	   //!< zenithal top angle of the illumination texture, radians
 	float illumTexBottom;	   //!< zenithal bottom angle of the illumination texture, radians
-	QImage *mapImage;          //!< The same image as mapTex, but stored in-mem for opacity sampling.
 	Vec3f bottomCapColor;      //!< The bottomCap, if specified, will be drawn in this color
 };
 
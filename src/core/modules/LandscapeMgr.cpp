@@ -34,6 +34,7 @@
 #include "StelIniParser.hpp"
 #include "StelSkyDrawer.hpp"
 #include "StelPainter.hpp"
+#include "StelProfiler.hpp"
 #include "qzipreader.h"
 
 #include <QDebug>
@@ -290,9 +291,12 @@ void LandscapeMgr::update(double deltaTime)
 		lunarPhaseAngle=0.0f;
 	}
 	// GZ: First parameter in next call is used for particularly earth-bound computations in Schaefer's sky brightness model. Difference DeltaT makes no difference here.
-	atmosphere->computeColor(core->getJDE(), sunPos, moonPos, lunarPhaseAngle, lunarMagnitude,
-		core, core->getCurrentLocation().latitude, core->getCurrentLocation().altitude,
-		15.f, 40.f);	// Temperature = 15c, relative humidity = 40%
+	{
+		StelProfiler::Scope profileScope("Atmosphere::computeColor");
+		atmosphere->computeColor(core->getJDE(), sunPos, moonPos, lunarPhaseAngle, lunarMagnitude,
+			core, core->getCurrentLocation().latitude, core->getCurrentLocation().altitude,
+			15.f, 40.f);	// Temperature = 15c, relative humidity = 40%
+	}
 
 	core->getSkyDrawer()->reportLuminanceInFov(3.75f+atmosphere->getAverageLuminance()*3.5f, true);
 
@@ -472,6 +476,7 @@ void LandscapeMgr::init()
 	setFlagAtmosphere(conf->value("landscape/flag_atmosphere", true).toBool());
 	setAtmosphereFadeDuration(conf->value("landscape/atmosphere_fade_duration",0.5).toFloat());
 	setAtmosphereLightPollutionLuminance(conf->value("viewing/light_pollution_luminance",0.0).toFloat());
+	setAtmosphereThreadCount(conf->value("landscape/atmosphere_threads", 0).toInt());
 
 	defaultLandscapeID = conf->value("init_location/landscape_name").toString();
 
@@ -1085,6 +1090,16 @@ void LandscapeMgr::setAtmosphereAverageLuminance(const float overrideLum)
 	atmosphere->setAverageLuminance(overrideLum);
 }
 
+void LandscapeMgr::setAtmosphereThreadCount(int n)
+{
+	atmosphere->setThreadCount(qMax(0, n));
+}
+
+int LandscapeMgr::getAtmosphereThreadCount() const
+{
+	return atmosphere->getThreadCount();
+}
+
 Landscape* LandscapeMgr::createFromFile(const QString& landscapeFile, const QString& landscapeId)
 {
 	QSettings landscapeIni(landscapeFile, StelIniFormat);
@@ -204,6 +204,12 @@ public slots:
 	//! this value explicitly to freeze it during image export. To unfreeze, call this again with any negative value.
 	void setAtmosphereAverageLuminance(const float overrideLuminance);
 
+	//! Set the number of threads used to compute the sky brightness of the atmosphere.
+	//! @param n the number of threads, or 0 to use one thread per CPU core
+	void setAtmosphereThreadCount(int n);
+	//! Get the number of threads used to compute the sky brightness of the atmosphere (0 means one per CPU core).
+	int getAtmosphereThreadCount() const;
+
 	//! Return a map of landscape names to landscape IDs (directory names).
 	static QMap<QString,QString> getNameToDirMap();
 
@@ -472,6 +478,10 @@ public slots:
 		StelUtils::spheToRect((180.0f-azimuth)*M_PI_180f, altitude*M_PI_180f, azalt);
 		return landscape->getOpacity(azalt);
 	}
+	//! Forward opacity query for n directions to current landscape.
+	//! @param azalt n directions of view lines to sample in azaltimuth coordinates.
+	//! @param opacity receives the n opacities.
+	void getLandscapeOpacity(int n, const Vec3d* azalt, float* opacity) const {landscape->getOpacity(n, azalt, opacity);}
 
 signals:
 	void atmosphereDisplayedChanged(const bool displayed);
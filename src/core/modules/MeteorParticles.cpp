@@ -0,0 +1,520 @@
+/*
+ * Stellarium
+ * Copyright (C) 2014-2015 Marcos Cardinot
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "MeteorParticles.hpp"
+#include "StelCore.hpp"
+#include "StelMovementMgr.hpp"
+#include "StelPainter.hpp"
+#include "StelSkyDrawer.hpp"
+#include "StelTexture.hpp"
+#include "StelUtils.hpp"
+
+#include <QMap>
+#include <QtMath>
+
+namespace
+{
+const float EARTH_RADIUS = 6378.f;          //! earth_radius in km
+const float EARTH_RADIUS2 = 40678884.f;     //! earth_radius^2 in km
+const float MAX_ALTITUDE = 120.f;           //! max meteor altitude in km
+const float MIN_ALTITUDE = 80.f;            //! min meteor altitude in km
+const float SCALE = 1242.f;                 //! to scale the positions down under 1
+const int BRIGHTNESS_SAMPLES = 76;          //! every 0.1 magnitude
+}
+
+const float MeteorParticles::MinMagnitude = -3.f;
+const float MeteorParticles::MaxMagnitude = 4.5f;
+
+MeteorParticles::MeteorParticles(int n)
+	: capacity(0)
+	, count(0)
+	, rngState(0)
+	, brightness(BRIGHTNESS_SAMPLES, 0.f)
+{
+	setCapacity(n);
+	setSeed(0);
+}
+
+void MeteorParticles::setCapacity(int n)
+{
+	capacity = qMax(0, n);
+	count = 0;
+	for (auto* array : {&xyDist2, &z, &trainZ, &initialZ, &finalZ, &speed, &minDist2, &absMag, &aptMag})
+		array->resize(capacity);
+	geometry.resize(capacity);
+}
+
+void MeteorParticles::clear()
+{
+	count = 0;
+	palettes.clear();
+}
+
+void MeteorParticles::setSeed(quint64 seed)
+{
+	// One splitmix64 step, so that close seeds give unrelated sequences
+	quint64 s = seed + 0x9E3779B97F4A7C15ULL;
+	s = (s ^ (s >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	s = (s ^ (s >> 27)) * 0x94D049BB133111EBULL;
+	// The xorshift state must not be 0
+	rngState = (s ^ (s >> 31)) | 1;
+}
+
+float MeteorParticles::random()
+{
+	// xorshift64*, keeping the 24 high bits of the result
+	rngState ^= rngState >> 12;
+	rngState ^= rngState << 25;
+	rngState ^= rngState >> 27;
+	return static_cast<float>((rngState * 0x2545F4914F6CDD1DULL) >> 40) * (1.f / 16777216.f);
+}
+
+Vec3f MeteorParticles::getColorFromName(const QString& colorName)
+{
+	static const QMap<QString, Vec3f>colorMap={
+		{ "violet",       { 176.f,  67.f, 172.f}},  // Calcium
+		{ "blueGreen",    {   0.f, 255.f, 152.f}},  // Magnesium
+		{ "yellow",       { 255.f, 255.f,   0.f}},  // Iron
+		{ "orangeYellow", { 255.f, 160.f,   0.f}},  // Sodium
+		{ "red",          { 255.f,  30.f,   0.f}}}; // atmospheric nitrogen and oxygen
+	Vec3f rgb=colorMap.value(colorName, Vec3f(255.f));  // default: white
+
+	return rgb/255.f;
+}
+
+int MeteorParticles::addPalette(const QList<ColorPair>& colors)
+{
+	Palette palette;
+	palette.multiColor = colors.size() > 1;
+	int segs = 0;
+	for (const auto& color : colors)
+	{
+		// segments to be painted with the current color
+		const int n = qRound(Segments * (color.second / 100.f)); // rounds to nearest integer
+		const Vec3f rgb = getColorFromName(color.first);
+		for (int s = 0; s < n && segs < Segments; ++s)
+			palette.colors[segs++] = rgb;
+	}
+
+	// make sure that all segments have been painted!
+	// use the last color to paint the last segments
+	const Vec3f last = colors.isEmpty() ? Vec3f(1.f) : getColorFromName(colors.last().first);
+	for (; segs < Segments; ++segs)
+		palette.colors[segs] = last;
+
+	palettes.append(palette);
+	return palettes.size() - 1;
+}
+
+void MeteorParticles::updateBrightness(const StelSkyDrawer* skyDrawer)
+{
+	QVector<float> table(BRIGHTNESS_SAMPLES);
+	for (int i = 0; i < BRIGHTNESS_SAMPLES; ++i)
+	{
+		const float mag = MinMagnitude + (MaxMagnitude - MinMagnitude) * i / (BRIGHTNESS_SAMPLES - 1);
+		RCMag rcMag;
+		skyDrawer->computeRCMag(mag, &rcMag);
+		table[i] = rcMag.radius <= 1.2f ? 0.f : rcMag.luminance;
+	}
+	setBrightness(table);
+}
+
+void MeteorParticles::setBrightness(const QVector<float>& table)
+{
+	brightness = table;
+}
+
+float MeteorParticles::getBrightness(float mag) const
+{
+	const int n = brightness.size();
+	if (n < 2)
+		return brightness.value(0);
+	const float t = qBound(0.f, (mag - MinMagnitude) / (MaxMagnitude - MinMagnitude), 1.f) * (n - 1);
+	const int i = qMin(static_cast<int>(t), n - 2);
+	const float f = t - i;
+	// a meteor too faint for the sky drawer stays invisible
+	if (brightness[i] == 0.f || brightness[i+1] == 0.f)
+		return f < 0.5f ? brightness[i] : brightness[i+1];
+	return brightness[i] + (brightness[i+1] - brightness[i]) * f;
+}
+
+int MeteorParticles::getNrOfSpawns(float zhr, double deltaTime)
+{
+	// average meteors per frame
+	const float mpf = zhr * static_cast<float>(deltaTime) / 3600.f;
+
+	// maximum amount of meteors for the current frame
+	const int maxMpf = qMax(1, qRound(mpf));
+
+	const float rate = mpf / static_cast<float>(maxMpf);
+	int n = 0;
+	for (int i = 0; i < maxMpf; ++i)
+	{
+		if (random() < rate)
+			++n;
+	}
+	return n;
+}
+
+float MeteorParticles::meteorZ(float zenithAngle, float altitude)
+{
+	float distance;
+
+	if (zenithAngle > 1.13446401f) // > 65 degrees?
+	{
+		const float zcos = std::cos(zenithAngle);
+		distance = std::sqrt(EARTH_RADIUS2 * zcos * zcos
+				 + 2 * EARTH_RADIUS * altitude
+				 + altitude * altitude);
+		distance -= EARTH_RADIUS * zcos;
+	}
+	else
+	{
+		// (first order approximation)
+		distance = altitude / std::cos(zenithAngle);
+	}
+
+	return distance;
+}
+
+bool MeteorParticles::spawn(const Vec3d& radiantAltAz, float meteorSpeed, int palette, float pidx)
+{
+	if (count >= capacity || palette < 0 || palette >= palettes.size())
+	{
+		return false;
+	}
+
+	float radiantAlt, radiantAz;
+	// S is zero, E is 90 degrees (SDSS)
+	StelUtils::rectToSphe(&radiantAz, &radiantAlt, radiantAltAz);
+
+	// meteors won't be visible if radiant is below 0degrees
+	if (radiantAlt < 0.f)
+	{
+		return false;
+	}
+
+	// define the radiant coordinate system
+	// rotation matrix to align z axis with radiant
+	const Mat4d matRadiantToAltAz = Mat4d::zrotation(static_cast<double>(radiantAz)) * Mat4d::yrotation(M_PI_2 - static_cast<double>(radiantAlt));
+
+	// select a random initial meteor altitude in the horizontal system [MIN_ALTITUDE, MAX_ALTITUDE]
+	const float initialAlt = MIN_ALTITUDE + (MAX_ALTITUDE - MIN_ALTITUDE) * random();
+
+	// calculates the max z-coordinate for the current radiant
+	const float maxZ = meteorZ(M_PI_2f - radiantAlt, initialAlt);
+
+	// meteor trajectory
+	// select a random xy position in polar coordinates (radiant system)
+	const float xyDist = maxZ * random(); // [0, maxZ]
+	const float theta = 2 * M_PIf * random(); // [0, 2pi]
+	const float x = xyDist * std::cos(theta);
+	const float y = xyDist * std::sin(theta);
+
+	// find the initial meteor coordinates in the horizontal system
+	Vec3d positionAltAz(static_cast<double>(x), static_cast<double>(y), static_cast<double>(maxZ));
+	positionAltAz.transfo4d(matRadiantToAltAz);
+
+	// find the angle from horizon to meteor
+	const float meteorAlt = static_cast<float>(std::asin(positionAltAz[2] / positionAltAz.length()));
+
+	// this meteor should not be visible if it is above the maximum altitude
+	// or if it's below the horizon!
+	if (positionAltAz[2] > static_cast<double>(MAX_ALTITUDE) || meteorAlt <= 0.f)
+	{
+		return false;
+	}
+
+	// determine the final z-component and the min distance between meteor and observer
+	float endZ, minDist;
+	if (radiantAlt < 0.0262f) // (<1.5 degrees) earth grazing meteor ?
+	{
+		// earth-grazers are rare!
+		// introduce a probabilistic factor just to make them a bit harder to occur
+		if (random() > 0.3f) {
+			return false;
+		}
+
+		// limit lifetime to 12sec
+		endZ = qMax(maxZ - meteorSpeed * 12.f, -maxZ);
+		minDist = xyDist;
+	}
+	else
+	{
+		// limit lifetime to 12sec
+		endZ = qMax(maxZ - meteorSpeed * 12.f, meteorZ(M_PI_2f - meteorAlt, MIN_ALTITUDE));
+		minDist = std::sqrt(endZ * endZ + xyDist * xyDist);
+	}
+
+	// a meteor cannot hit the observer!
+	if (minDist < MIN_ALTITUDE) {
+		return false;
+	}
+
+	// select random magnitude [-3; 4.5]
+	float mag = getBrightness(MinMagnitude + (MaxMagnitude - MinMagnitude) * random());
+	if (mag == 0.f) {
+		return false;
+	}
+
+	// most visible meteors are under about 184km distant
+	// scale max mag down if outside this range
+	mag *= qMin(184.f * 184.f / (minDist * minDist), 1.f);
+
+	// implements the population index (pidx) - usually a decimal between 2 and 4
+	// higher pidx implies a larger fraction of faint meteors than average
+	if (pidx > 1.f && random() > 1.f / pidx)
+	{
+		// Increase the absolute magnitude ([-3; 4.5]) in 1.5!
+		// As we are working on a 0-1 scale (where 1 is brighter),
+		// more 1.5 means less 0.2!
+		mag -= 0.2f;
+	}
+
+	const int i = count++;
+	xyDist2[i] = xyDist * xyDist;
+	z[i] = maxZ;
+	trainZ[i] = maxZ;
+	initialZ[i] = maxZ;
+	finalZ[i] = endZ;
+	speed[i] = meteorSpeed;
+	minDist2[i] = minDist * minDist;
+	absMag[i] = mag;
+	aptMag[i] = mag;
+
+	Geometry& g = geometry[i];
+	const Mat4d& m = matRadiantToAltAz;
+	g.axisX = Vec3f(static_cast<float>(m[0]), static_cast<float>(m[1]), static_cast<float>(m[2])) / SCALE;
+	g.axisY = Vec3f(static_cast<float>(m[4]), static_cast<float>(m[5]), static_cast<float>(m[6])) / SCALE;
+	g.axisZ = Vec3f(static_cast<float>(m[8]), static_cast<float>(m[9]), static_cast<float>(m[10])) / SCALE;
+	g.center = g.axisX * x + g.axisY * y;
+	g.palette = palette;
+	// multi-color ?
+	// select a random segment to be the first (to alternate colors)
+	g.firstSegment = palettes[palette].multiColor ? qRound((Segments - 1) * random()) : 0; // [0, segments-1]
+	return true;
+}
+
+void MeteorParticles::update(double deltaTime, bool realTimeSpeed)
+{
+	const float dt = static_cast<float>(deltaTime);
+	const float stopped = realTimeSpeed ? 0.f : 1.f;
+	float* const zs = z.data();
+	float* const trainZs = trainZ.data();
+	float* const absMags = absMag.data();
+	float* const aptMags = aptMag.data();
+	const float* const speeds = speed.constData();
+	const float* const initialZs = initialZ.constData();
+	const float* const finalZs = finalZ.constData();
+	const float* const xyDist2s = xyDist2.constData();
+	const float* const minDist2s = minDist2.constData();
+
+	for (int i = 0; i < count; ++i)
+	{
+		// burning has stopped so magnitude fades out
+		// assume linear fade out
+		const float fading = qMax(stopped, zs[i] < finalZs[i] ? 1.f : 0.f);
+		absMags[i] -= fading * dt * 2.f;
+
+		zs[i] -= speeds[i] * dt;
+
+		// train doesn't extend beyond start of burn
+		const float train = trainZs[i] - speeds[i] * dt;
+		trainZs[i] = zs[i] + speeds[i] * 0.5f > initialZs[i] ? initialZs[i] : train;
+
+		// update apparent magnitude based on distance to observer
+		const float scale = minDist2s[i] / (xyDist2s[i] + zs[i] * zs[i]);
+		aptMags[i] = qMax(absMags[i] * qMin(scale, 1.f), 0.f);
+	}
+
+	// remove the meteors which are no longer visible, keeping the others packed at the start of the arrays
+	int n = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		if (absMags[i] > 0.f)
+		{
+			if (n != i)
+				moveMeteor(i, n);
+			++n;
+		}
+	}
+	count = n;
+}
+
+void MeteorParticles::moveMeteor(int from, int to)
+{
+	for (auto* array : {&xyDist2, &z, &trainZ, &initialZ, &finalZ, &speed, &minDist2, &absMag, &aptMag})
+		(*array)[to] = (*array)[from];
+	geometry[to] = geometry[from];
+}
+
+void MeteorParticles::calculateThickness(const StelCore* core, double& thickness, double& bolideSize)
+{
+	const double maxFOV = core->getMovementMgr()->getMaxFov();
+	const double FOV = core->getMovementMgr()->getCurrentFov();
+	thickness = 2*log(FOV + 0.25)/(1.2*maxFOV - (FOV + 0.25)) + 0.01;
+	if (FOV <= 0.5)
+	{
+		thickness = 0.013 * FOV; // decreasing faster
+	}
+	else if (FOV > 100.0)
+	{
+		thickness = 0; // remove prism
+	}
+
+	bolideSize = thickness*3;
+}
+
+void MeteorParticles::buildDrawArrays(float thickness, float bolideSize)
+{
+	// Two triangles per segment and side of the train prism, one line per segment, two triangles per bolide
+	const int trainSize = thickness != 0.f ? count * 3 * (Segments - 1) * 6 : 0;
+	const int bolideSize6 = bolideSize != 0.f ? count * 6 : 0;
+	trainVertices.resize(trainSize);
+	trainColors.resize(trainSize);
+	lineVertices.resize(count * (Segments - 1) * 2);
+	lineColors.resize(lineVertices.size());
+	bolideVertices.resize(bolideSize6);
+	bolideColors.resize(bolideSize6);
+	bolideTexCoords.resize(bolideSize6);
+
+	Vec3d* trainV = trainVertices.data();
+	Vec4f* trainC = trainColors.data();
+	Vec3d* lineV = lineVertices.data();
+	Vec4f* lineC = lineColors.data();
+	Vec3d* bolideV = bolideVertices.data();
+	Vec4f* bolideC = bolideColors.data();
+	Vec2f* bolideT = bolideTexCoords.data();
+	static const Vec2f bolideTexCoordData[6] = {Vec2f(1.f, 0.f), Vec2f(0.f, 0.f), Vec2f(0.f, 1.f),
+						    Vec2f(1.f, 0.f), Vec2f(0.f, 1.f), Vec2f(1.f, 1.f)};
+
+	for (int m = 0; m < count; ++m)
+	{
+		const Geometry& g = geometry[m];
+		const Palette& palette = palettes[g.palette];
+
+		// the line and the 3 edges of the train prism, at each segment
+		Vec3d line[Segments], edgeB[Segments], edgeL[Segments], edgeR[Segments];
+		Vec4f colors[Segments];
+		const Vec3f offsetB = (g.axisX + g.axisY) * (thickness * 0.7f);
+		const Vec3f offsetL = g.axisY * (-thickness);
+		const Vec3f offsetR = g.axisX * (-thickness);
+		for (int i = 0; i < Segments; ++i)
+		{
+			const float height = trainZ[m] + i * (z[m] - trainZ[m]) / (Segments - 1);
+			const Vec3f p = g.center + g.axisZ * height;
+			line[i].set(static_cast<double>(p[0]), static_cast<double>(p[1]), static_cast<double>(p[2]));
+			const Vec3f b = p + offsetB, l = p + offsetL, r = p + offsetR;
+			edgeB[i].set(static_cast<double>(b[0]), static_cast<double>(b[1]), static_cast<double>(b[2]));
+			edgeL[i].set(static_cast<double>(l[0]), static_cast<double>(l[1]), static_cast<double>(l[2]));
+			edgeR[i].set(static_cast<double>(r[0]), static_cast<double>(r[1]), static_cast<double>(r[2]));
+			const Vec3f& rgb = palette.colors[(i + g.firstSegment) % Segments];
+			colors[i].set(rgb[0], rgb[1], rgb[2], aptMag[m] * static_cast<float>(i) / static_cast<float>(Segments - 1));
+		}
+
+		for (int i = 0; i < Segments - 1; ++i)
+		{
+			*lineV++ = line[i];
+			*lineV++ = line[i+1];
+			*lineC++ = colors[i];
+			*lineC++ = colors[i+1];
+		}
+
+		if (trainSize)
+		{
+			const Vec3d* sides[3][2] = {{edgeB, edgeL}, {edgeB, edgeR}, {edgeL, edgeR}};
+			for (const auto& side : sides)
+			{
+				for (int i = 0; i < Segments - 1; ++i)
+				{
+					*trainV++ = side[0][i];
+					*trainV++ = side[1][i];
+					*trainV++ = side[0][i+1];
+					*trainV++ = side[1][i];
+					*trainV++ = side[0][i+1];
+					*trainV++ = side[1][i+1];
+					*trainC++ = colors[i];
+					*trainC++ = colors[i];
+					*trainC++ = colors[i+1];
+					*trainC++ = colors[i];
+					*trainC++ = colors[i+1];
+					*trainC++ = colors[i+1];
+				}
+			}
+		}
+
+		if (bolideSize6)
+		{
+			const Vec3f p = g.center + g.axisZ * z[m];
+			const Vec3f corners[4] = {p - g.axisY * bolideSize, p - g.axisX * bolideSize,
+						  p + g.axisY * bolideSize, p + g.axisX * bolideSize};
+			static const int fan[6] = {0, 1, 2, 0, 2, 3};
+			const Vec4f bolideColor(1.f, 1.f, 1.f, aptMag[m]);
+			for (int i = 0; i < 6; ++i)
+			{
+				const Vec3f& c = corners[fan[i]];
+				(bolideV++)->set(static_cast<double>(c[0]), static_cast<double>(c[1]), static_cast<double>(c[2]));
+				*bolideC++ = bolideColor;
+				*bolideT++ = bolideTexCoordData[i];
+			}
+		}
+	}
+}
+
+void MeteorParticles::draw(const StelCore* core, StelPainter& sPainter, const StelTextureSP& bolideTexture)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	double thickness;
+	double bolideSize;
+	calculateThickness(core, thickness, bolideSize);
+	buildDrawArrays(static_cast<float>(thickness), bolideTexture ? static_cast<float>(bolideSize) : 0.f);
+
+	// train (triangular prism)
+	sPainter.setBlending(true);
+	sPainter.enableClientStates(true, false, true);
+	if (!trainVertices.isEmpty())
+	{
+		sPainter.setColorPointer(4, GL_FLOAT, trainColors.constData());
+		sPainter.setVertexPointer(3, GL_DOUBLE, trainVertices.constData());
+		sPainter.drawFromArray(StelPainter::Triangles, trainVertices.size(), 0, true);
+	}
+	sPainter.setColorPointer(4, GL_FLOAT, lineColors.constData());
+	sPainter.setVertexPointer(3, GL_DOUBLE, lineVertices.constData());
+	sPainter.drawFromArray(StelPainter::Lines, lineVertices.size(), 0, true);
+
+	// bolide
+	if (!bolideVertices.isEmpty())
+	{
+		sPainter.setBlending(true, GL_ONE, GL_ONE);
+		sPainter.enableClientStates(true, true, true);
+		bolideTexture->bind();
+		sPainter.setTexCoordPointer(2, GL_FLOAT, bolideTexCoords.constData());
+		sPainter.setColorPointer(4, GL_FLOAT, bolideColors.constData());
+		sPainter.setVertexPointer(3, GL_DOUBLE, bolideVertices.constData());
+		sPainter.drawFromArray(StelPainter::Triangles, bolideVertices.size(), 0, true);
+	}
+
+	sPainter.setBlending(false);
+	sPainter.enableClientStates(false);
+}
@@ -0,0 +1,173 @@
+/*
+ * Stellarium
+ * Copyright (C) 2014-2015 Marcos Cardinot
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef METEORPARTICLES_HPP
+#define METEORPARTICLES_HPP
+
+#include "StelTextureTypes.hpp"
+#include "VecMath.hpp"
+
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+class StelCore;
+class StelPainter;
+class StelSkyDrawer;
+
+//! @class MeteorParticles
+//! Pool of meteors sharing the same storage, updated and drawn all at once.
+//! Each meteor starts between 80 and 120 km of altitude, goes straight away from its radiant and leaves a train
+//! behind it. Once it stops burning, its brightness fades out and it is removed from the pool.
+//! The meteors are stored in a fixed number of slots, in one array per property, so that update() goes through
+//! arrays of floats without allocating nor branching. The meteors which would not fit in the pool are not created.
+//! draw() builds the trains, lines and bolides of all meteors in three vertex arrays and draws each with a single call.
+//! The random numbers come from a generator owned by the pool, so that the same seed and the same frames
+//! give the same meteors.
+class MeteorParticles
+{
+public:
+	//! <colorName, intensity>
+	typedef QPair<QString, int> ColorPair;
+
+	//! Number of segments along the train (useful to curve along projection distortions)
+	static const int Segments = 10;
+	//! Range of the magnitudes of the meteors
+	static const float MinMagnitude;
+	static const float MaxMagnitude;
+
+	//! Create a pool for at most capacity meteors.
+	MeteorParticles(int capacity=4096);
+
+	//! Set the maximum number of meteors. Removes all meteors.
+	void setCapacity(int capacity);
+	int getCapacity() const {return capacity;}
+	//! Get the number of meteors in the pool.
+	int getNrOfMeteors() const {return count;}
+
+	//! Remove all meteors and color palettes.
+	void clear();
+
+	//! Restart the random number generator from a seed.
+	void setSeed(quint64 seed);
+	//! Get a random number in [0, 1) from the generator of the pool.
+	float random();
+
+	//! Register the colors of a kind of meteors.
+	//! @param colors the colors along the train, with their percentage of the train.
+	//! @return the palette index to pass to spawn().
+	int addPalette(const QList<ColorPair>& colors);
+
+	//! Set the brightness of the meteors from their magnitude, as computed by the sky drawer.
+	//! Must be called before spawn() when the settings of the sky drawer may have changed.
+	void updateBrightness(const StelSkyDrawer* skyDrawer);
+	//! Set the brightness of the meteors for magnitudes evenly spaced between MinMagnitude and MaxMagnitude.
+	//! The meteors with a brightness of 0 are not created.
+	void setBrightness(const QVector<float>& brightness);
+
+	//! Get at random the number of meteors to create in a frame for a zenithal hourly rate.
+	int getNrOfSpawns(float zhr, double deltaTime);
+
+	//! Create a meteor with a random trajectory and magnitude.
+	//! @param radiantAltAz the direction of the radiant in the horizontal system.
+	//! @param speed the meteor speed in km/s.
+	//! @param palette the index returned by addPalette().
+	//! @param pidx the population index, or 0. A higher value implies a larger fraction of faint meteors.
+	//! @return false if the meteor would not be visible or if the pool is full.
+	bool spawn(const Vec3d& radiantAltAz, float speed, int palette, float pidx=0.f);
+
+	//! Move all meteors and remove those which faded out.
+	//! @param deltaTime the time increment in seconds since the last call.
+	//! @param realTimeSpeed false if the time runs at another speed, in which case the meteors fade out.
+	void update(double deltaTime, bool realTimeSpeed);
+
+	//! Draw all meteors. The painter must use the horizontal frame.
+	void draw(const StelCore* core, StelPainter& sPainter, const StelTextureSP& bolideTexture);
+
+	//! Build the vertex arrays drawn by draw().
+	//! @param thickness the thickness of the trains in km, or 0 to draw lines only.
+	//! @param bolideSize the size of the bolides in km, or 0 to draw no bolide.
+	void buildDrawArrays(float thickness, float bolideSize);
+	//! Get the vertex arrays built by the last call to buildDrawArrays(), in the horizontal system.
+	const QVector<Vec3d>& getTrainVertices() const {return trainVertices;}
+	const QVector<Vec3d>& getLineVertices() const {return lineVertices;}
+	const QVector<Vec3d>& getBolideVertices() const {return bolideVertices;}
+
+private:
+	//! Data of a meteor which are only read by draw()
+	struct Geometry
+	{
+		//! Position of the trajectory and axes of the radiant system in the horizontal system, scaled down under 1
+		Vec3f center, axisX, axisY, axisZ;
+		int palette;
+		int firstSegment;
+	};
+
+	struct Palette
+	{
+		Vec3f colors[Segments];
+		bool multiColor;
+	};
+
+	//! Move the meteor in the slot from to the slot to.
+	void moveMeteor(int from, int to);
+
+	//! Get the brightness of a magnitude from the brightness table.
+	float getBrightness(float mag) const;
+
+	//! Get RGB from color name
+	static Vec3f getColorFromName(const QString& colorName);
+
+	//! Calculates the train thickness and bolide size.
+	static void calculateThickness(const StelCore* core, double& thickness, double& bolideSize);
+
+	//! Calculates the z-component of a meteor as a function of meteor zenith angle
+	static float meteorZ(float zenithAngle, float altitude);
+
+	int capacity;
+	int count;
+	quint64 rngState;
+
+	// Properties of the meteors in the radiant coordinate system, one array per property
+	QVector<float> xyDist2;         //! Square of the distance to the axis of the radiant system.
+	QVector<float> z;               //! z-component of the meteor.
+	QVector<float> trainZ;          //! z-component of the end of the train.
+	QVector<float> initialZ;        //! Initial z-component of the meteor.
+	QVector<float> finalZ;          //! Final z-component of the meteor.
+	QVector<float> speed;           //! Velocity of meteor in km/s.
+	QVector<float> minDist2;        //! Square of the shortest distance between meteor and observer.
+	QVector<float> absMag;          //! Absolute magnitude [0, 1]
+	QVector<float> aptMag;          //! Apparent magnitude [0, 1]
+	QVector<Geometry> geometry;
+
+	QVector<Palette> palettes;
+	QVector<float> brightness;
+
+	QVector<Vec3d> trainVertices;
+	QVector<Vec4f> trainColors;
+	QVector<Vec3d> lineVertices;
+	QVector<Vec4f> lineColors;
+	QVector<Vec3d> bolideVertices;
+	QVector<Vec4f> bolideColors;
+	QVector<Vec2f> bolideTexCoords;
+};
+
+#endif // METEORPARTICLES_HPP
@@ -200,7 +200,7 @@ QString Nebula::getInfoString(const StelCore *core, const InfoStringGroup& flags
 		if (!nameI18.isEmpty() && !withoutID && flags&Name)
 			oss << "<br>";
 
-		oss << designations.join(" - ");
+		oss << getDesignations().join(" - ");
 	}
 
 	if ((flags&Name) || (flags&CatalogNumber))
@@ -900,7 +900,7 @@ QString Nebula::getDSODesignation() const
 QString Nebula::getDSODesignationWIC() const
 {
 	if (!withoutID)
-		return designations.first();
+		return getDesignations().first();
 	else
 		return QString();
 }
@@ -916,10 +916,27 @@ void Nebula::readDSO(QDataStream &in)
 		>> Mel_nb >> PGC_nb >> UGC_nb >> Ced_nb >> Arp_nb >> VV_nb >> PK_nb >> PNG_nb >> SNRG_nb >> ACO_nb
 		>> HCG_nb >> ESO_nb >> VdBH_nb >> DWB_nb >> Tr_nb >> St_nb >> Ru_nb >> VdBHa_nb;
 
+	StelUtils::spheToRect(ra,dec,XYZ);
+	setupDSO(oType);
+}
+
+void Nebula::setupDSO(unsigned int oType)
+{
 	const unsigned int f = NGC_nb + IC_nb + M_nb + C_nb + B_nb + Sh2_nb + VdB_nb + RCW_nb + LDN_nb + LBN_nb + Cr_nb + Mel_nb + PGC_nb + UGC_nb + Arp_nb + VV_nb + DWB_nb + Tr_nb + St_nb + Ru_nb + VdBHa_nb;
 	if (f==0 && Ced_nb.isEmpty() && PK_nb.isEmpty() && PNG_nb.isEmpty() && SNRG_nb.isEmpty() && ACO_nb.isEmpty() && HCG_nb.isEmpty() && ESO_nb.isEmpty() && VdBH_nb.isEmpty())
 		withoutID = true;
 
+	designations.clear();
+	Q_ASSERT(fabs(XYZ.lengthSquared()-1.)<1e-9);
+	nType = static_cast<Nebula::NebulaType>(oType);
+	pointRegion = SphericalRegionP(new SphericalPoint(getJ2000EquatorialPos(Q_NULLPTR)));
+}
+
+const QStringList& Nebula::getDesignations() const
+{
+	if (!designations.isEmpty() || withoutID)
+		return designations;
+
 	if (M_nb > 0) designations << QString("M %1").arg(M_nb);
 	if (C_nb > 0)  designations << QString("C %1").arg(C_nb);
 	if (NGC_nb > 0) designations << QString("NGC %1").arg(NGC_nb);
@@ -950,10 +967,7 @@ void Nebula::readDSO(QDataStream &in)
 	if (Ru_nb > 0) designations << QString("Ru %1").arg(Ru_nb);
 	if (VdBHa_nb > 0) designations << QString("vdB-Ha %1").arg(VdBHa_nb);
 
-	StelUtils::spheToRect(ra,dec,XYZ);
-	Q_ASSERT(fabs(XYZ.lengthSquared()-1.)<1e-9);
-	nType = static_cast<Nebula::NebulaType>(oType);
-	pointRegion = SphericalRegionP(new SphericalPoint(getJ2000EquatorialPos(Q_NULLPTR)));
+	return designations;
 }
 
 bool Nebula::objectInDisplayedType() const
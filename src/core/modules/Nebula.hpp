@@ -35,6 +35,8 @@ class QDataStream;
 class Nebula : public StelObject
 {
 friend class NebulaMgr;
+friend class NebulaCatalogCache;
+friend class TestNebulaCatalogCache;
 
 	//Required for the correct working of the Q_FLAGS macro (which requires a MOC pass)
 	Q_GADGET
@@ -244,6 +246,12 @@ private:
 	}
 
 	void readDSO(QDataStream& in);
+	//! Set the type and flags of the DSO once its catalog data and position are read.
+	void setupDSO(unsigned int oType);
+
+	//! Get the list of catalog designations, e.g. "M 31" and "NGC 224".
+	//! The list is only built when needed, i.e. for the selected object.
+	const QStringList& getDesignations() const;
 
 	void drawLabel(StelPainter& sPainter, float maxMagLabel) const;
 	void drawHints(StelPainter& sPainter, float maxMagHints) const;
@@ -310,7 +318,7 @@ private:
 	NebulaType nType;
 
 	SphericalRegionP pointRegion;
-	QStringList designations;
+	mutable QStringList designations;
 
 	static StelTextureSP texCircle;				// The symbolic circle texture
 	static StelTextureSP texCircleLarge;			// The symbolic circle texture for large objects
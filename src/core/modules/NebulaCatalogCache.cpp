@@ -0,0 +1,360 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "NebulaCatalogCache.hpp"
+#include "StelFileMgr.hpp"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+
+#include <cstring>
+#include <limits>
+
+namespace
+{
+const char CACHE_MAGIC[8] = { 'S', 'T', 'E', 'L', 'D', 'S', 'O', 'C' };
+const quint32 CACHE_VERSION = 1;
+const quint32 CACHE_BYTE_ORDER_MARK = 0x01020304;
+
+//! A string of the heap, as offset and length in UTF-16 code units
+struct StringRef
+{
+	quint32 offset;
+	quint32 length;
+};
+
+struct CacheHeader
+{
+	char magic[8];
+	quint32 version;
+	quint32 byteOrderMark;
+	quint32 hotRecordSize;
+	quint32 coldRecordSize;
+	char key[20];
+	quint32 count;
+	StringRef catalogVersion;
+	StringRef catalogEdition;
+	quint64 hotOffset;
+	quint64 coldOffset;
+	quint64 heapOffset;
+	quint64 heapLength;
+};
+
+//! The data needed to draw a DSO
+struct HotRecord
+{
+	double xyz[3];
+	float bMag;
+	float vMag;
+	float majorAxisSize;
+	float minorAxisSize;
+	qint32 orientationAngle;
+	quint32 type;
+	quint32 dsoNb;
+	quint32 reserved;
+};
+
+enum { NumberCount = 21, StringCount = 9 };
+
+//! The other catalog data
+struct ColdRecord
+{
+	float redshift;
+	float redshiftErr;
+	float parallax;
+	float parallaxErr;
+	float oDistance;
+	float oDistanceErr;
+	//! NGC, IC, M, C, B, Sh2, VdB, RCW, LDN, LBN, Cr, Mel, PGC, UGC, Arp, VV, DWB, Tr, St, Ru, VdBHa
+	quint32 numbers[NumberCount];
+	//! morphological type, Ced, PK, PN G, SNR G, ACO, HCG, ESO, VdBH
+	StringRef strings[StringCount];
+	quint32 reserved;
+};
+
+quint64 alignTo8(quint64 n)
+{
+	return (n + 7) & ~static_cast<quint64>(7);
+}
+
+//! Collect the strings of the heap, sharing the repeated ones (e.g. morphological types)
+class HeapWriter
+{
+public:
+	StringRef add(const QString& str)
+	{
+		StringRef ref = { 0, 0 };
+		if (str.isEmpty())
+			return ref;
+		auto it = refs.constFind(str);
+		if (it != refs.constEnd())
+			return it.value();
+		ref.offset = static_cast<quint32>(heap.size());
+		ref.length = static_cast<quint32>(str.size());
+		heap.append(str);
+		refs.insert(str, ref);
+		return ref;
+	}
+	const QString& data() const { return heap; }
+private:
+	QString heap;
+	QHash<QString, StringRef> refs;
+};
+}
+
+NebulaCatalogCache::NebulaCatalogCache()
+	: data(Q_NULLPTR)
+	, count(0)
+	, hot(Q_NULLPTR)
+	, cold(Q_NULLPTR)
+	, heap(Q_NULLPTR)
+	, heapLength(0)
+{
+}
+
+NebulaCatalogCache::~NebulaCatalogCache()
+{
+	close();
+}
+
+QByteArray NebulaCatalogCache::getCacheKey(const QString& catalogFile, const QString& catalogVersion)
+{
+	// Hashing catalog.dat would cost about as much as uncompressing it, its path, size and date are enough
+	QFileInfo fi(catalogFile);
+	if (!fi.exists())
+		return QByteArray();
+
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	hash.addData(fi.absoluteFilePath().toUtf8());
+	hash.addData(catalogVersion.toUtf8());
+	const qint64 extra[5] = { fi.size(), fi.lastModified().toMSecsSinceEpoch(), CACHE_VERSION,
+				  static_cast<qint64>(sizeof(HotRecord)), static_cast<qint64>(sizeof(ColdRecord)) };
+	hash.addData(reinterpret_cast<const char*>(extra), sizeof(extra));
+	return hash.result();
+}
+
+QString NebulaCatalogCache::getCacheFileName(const QString& catalogFile)
+{
+	const QString cacheDir = StelFileMgr::getCacheDir();
+	if (cacheDir.isEmpty())
+		return QString();
+	const QByteArray pathHash = QCryptographicHash::hash(QFileInfo(catalogFile).absoluteFilePath().toUtf8(), QCryptographicHash::Sha1);
+	return cacheDir + "/dsocache/" + QString::fromLatin1(pathHash.toHex()) + ".cache";
+}
+
+bool NebulaCatalogCache::save(const QString& cacheFile, const QByteArray& key, const QString& version, const QString& edition,
+			      const QVector<NebulaP>& dsos)
+{
+	if (static_cast<size_t>(key.size()) != sizeof(CacheHeader::key))
+		return false;
+
+	QVector<HotRecord> hotRecords(dsos.size());
+	QVector<ColdRecord> coldRecords(dsos.size());
+	HeapWriter heapWriter;
+
+	CacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.version = CACHE_VERSION;
+	header.byteOrderMark = CACHE_BYTE_ORDER_MARK;
+	header.hotRecordSize = sizeof(HotRecord);
+	header.coldRecordSize = sizeof(ColdRecord);
+	memcpy(header.key, key.constData(), sizeof(header.key));
+	header.count = static_cast<quint32>(dsos.size());
+	header.catalogVersion = heapWriter.add(version);
+	header.catalogEdition = heapWriter.add(edition);
+
+	for (int i=0; i<dsos.size(); ++i)
+	{
+		const Nebula& n = *dsos.at(i);
+		HotRecord& h = hotRecords[i];
+		memset(&h, 0, sizeof(h));
+		for (int j=0; j<3; ++j)
+			h.xyz[j] = n.XYZ[j];
+		h.bMag = n.bMag;
+		h.vMag = n.vMag;
+		h.majorAxisSize = n.majorAxisSize;
+		h.minorAxisSize = n.minorAxisSize;
+		h.orientationAngle = n.orientationAngle;
+		h.type = static_cast<quint32>(n.nType);
+		h.dsoNb = n.DSO_nb;
+
+		ColdRecord& c = coldRecords[i];
+		memset(&c, 0, sizeof(c));
+		c.redshift = n.redshift;
+		c.redshiftErr = n.redshiftErr;
+		c.parallax = n.parallax;
+		c.parallaxErr = n.parallaxErr;
+		c.oDistance = n.oDistance;
+		c.oDistanceErr = n.oDistanceErr;
+		const unsigned int numbers[NumberCount] = { n.NGC_nb, n.IC_nb, n.M_nb, n.C_nb, n.B_nb, n.Sh2_nb, n.VdB_nb, n.RCW_nb,
+							    n.LDN_nb, n.LBN_nb, n.Cr_nb, n.Mel_nb, n.PGC_nb, n.UGC_nb, n.Arp_nb, n.VV_nb,
+							    n.DWB_nb, n.Tr_nb, n.St_nb, n.Ru_nb, n.VdBHa_nb };
+		for (int j=0; j<NumberCount; ++j)
+			c.numbers[j] = numbers[j];
+		const QString* strings[StringCount] = { &n.mTypeString, &n.Ced_nb, &n.PK_nb, &n.PNG_nb, &n.SNRG_nb, &n.ACO_nb,
+							&n.HCG_nb, &n.ESO_nb, &n.VdBH_nb };
+		for (int j=0; j<StringCount; ++j)
+			c.strings[j] = heapWriter.add(*strings[j]);
+	}
+
+	const QString& heapData = heapWriter.data();
+	header.hotOffset = alignTo8(sizeof(CacheHeader));
+	header.coldOffset = alignTo8(header.hotOffset + sizeof(HotRecord)*static_cast<quint64>(hotRecords.size()));
+	header.heapOffset = alignTo8(header.coldOffset + sizeof(ColdRecord)*static_cast<quint64>(coldRecords.size()));
+	header.heapLength = static_cast<quint64>(heapData.size());
+
+	QDir().mkpath(QFileInfo(cacheFile).absolutePath());
+	QSaveFile file(cacheFile);
+	if (!file.open(QIODevice::WriteOnly))
+		return false;
+
+	const QByteArray padding(8, '\0');
+	auto writeBlock = [&](quint64 offset, const void* block, quint64 size)
+	{
+		file.write(padding.constData(), static_cast<qint64>(offset) - file.pos());
+		file.write(reinterpret_cast<const char*>(block), static_cast<qint64>(size));
+	};
+	writeBlock(0, &header, sizeof(header));
+	writeBlock(header.hotOffset, hotRecords.constData(), sizeof(HotRecord)*static_cast<quint64>(hotRecords.size()));
+	writeBlock(header.coldOffset, coldRecords.constData(), sizeof(ColdRecord)*static_cast<quint64>(coldRecords.size()));
+	writeBlock(header.heapOffset, heapData.constData(), sizeof(QChar)*header.heapLength);
+	return file.commit();
+}
+
+bool NebulaCatalogCache::open(const QString& cacheFile, const QByteArray& key)
+{
+	close();
+
+	file.setFileName(cacheFile);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	const qint64 fileSize = file.size();
+	if (fileSize < static_cast<qint64>(sizeof(CacheHeader)))
+	{
+		file.close();
+		return false;
+	}
+
+	data = file.map(0, fileSize);
+	if (!data)
+	{
+		qWarning() << "Could not map DSO cache" << QDir::toNativeSeparators(cacheFile) << file.errorString();
+		file.close();
+		return false;
+	}
+
+	CacheHeader header;
+	memcpy(&header, data, sizeof(CacheHeader));
+	const quint64 size = static_cast<quint64>(fileSize);
+	if (memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) || header.version != CACHE_VERSION
+			|| header.byteOrderMark != CACHE_BYTE_ORDER_MARK
+			|| header.hotRecordSize != sizeof(HotRecord) || header.coldRecordSize != sizeof(ColdRecord)
+			|| static_cast<size_t>(key.size()) != sizeof(header.key) || memcmp(header.key, key.constData(), sizeof(header.key))
+			|| header.count > static_cast<quint32>(std::numeric_limits<int>::max())
+			|| header.hotOffset > size || sizeof(HotRecord)*static_cast<quint64>(header.count) > size - header.hotOffset
+			|| header.coldOffset > size || sizeof(ColdRecord)*static_cast<quint64>(header.count) > size - header.coldOffset
+			|| header.heapOffset > size || header.heapOffset % sizeof(QChar) || header.heapLength > (size - header.heapOffset)/sizeof(QChar))
+	{
+		qDebug() << "Ignoring outdated or invalid DSO cache" << QDir::toNativeSeparators(cacheFile);
+		close();
+		return false;
+	}
+
+	count = static_cast<int>(header.count);
+	hot = data + header.hotOffset;
+	cold = data + header.coldOffset;
+	heap = reinterpret_cast<const QChar*>(data + header.heapOffset);
+	heapLength = header.heapLength;
+	version = readString(header.catalogVersion.offset, header.catalogVersion.length);
+	edition = readString(header.catalogEdition.offset, header.catalogEdition.length);
+	return true;
+}
+
+void NebulaCatalogCache::close()
+{
+	if (data)
+		file.unmap(const_cast<uchar*>(data));
+	file.close();
+	data = Q_NULLPTR;
+	hot = Q_NULLPTR;
+	cold = Q_NULLPTR;
+	heap = Q_NULLPTR;
+	heapLength = 0;
+	strings.clear();
+	count = 0;
+	version.clear();
+	edition.clear();
+}
+
+QString NebulaCatalogCache::readString(quint32 offset, quint32 length) const
+{
+	if (length == 0 || static_cast<quint64>(offset) + length > heapLength)
+		return QString();
+	// The heap stores repeated strings once, share them between the objects too
+	auto it = strings.constFind(offset);
+	if (it != strings.constEnd())
+		return it.value();
+	const QString str(heap + offset, static_cast<int>(length));
+	strings.insert(offset, str);
+	return str;
+}
+
+NebulaP NebulaCatalogCache::createNebula(int index) const
+{
+	Q_ASSERT(index >= 0 && index < count);
+	HotRecord h;
+	ColdRecord c;
+	memcpy(&h, hot + sizeof(HotRecord)*static_cast<size_t>(index), sizeof(HotRecord));
+	memcpy(&c, cold + sizeof(ColdRecord)*static_cast<size_t>(index), sizeof(ColdRecord));
+
+	NebulaP n(new Nebula);
+	n->XYZ.set(h.xyz[0], h.xyz[1], h.xyz[2]);
+	n->bMag = h.bMag;
+	n->vMag = h.vMag;
+	n->majorAxisSize = h.majorAxisSize;
+	n->minorAxisSize = h.minorAxisSize;
+	n->orientationAngle = h.orientationAngle;
+	n->DSO_nb = h.dsoNb;
+
+	n->redshift = c.redshift;
+	n->redshiftErr = c.redshiftErr;
+	n->parallax = c.parallax;
+	n->parallaxErr = c.parallaxErr;
+	n->oDistance = c.oDistance;
+	n->oDistanceErr = c.oDistanceErr;
+	unsigned int* numbers[NumberCount] = { &n->NGC_nb, &n->IC_nb, &n->M_nb, &n->C_nb, &n->B_nb, &n->Sh2_nb, &n->VdB_nb, &n->RCW_nb,
+					       &n->LDN_nb, &n->LBN_nb, &n->Cr_nb, &n->Mel_nb, &n->PGC_nb, &n->UGC_nb, &n->Arp_nb, &n->VV_nb,
+					       &n->DWB_nb, &n->Tr_nb, &n->St_nb, &n->Ru_nb, &n->VdBHa_nb };
+	for (int j=0; j<NumberCount; ++j)
+		*numbers[j] = c.numbers[j];
+	QString* fields[StringCount] = { &n->mTypeString, &n->Ced_nb, &n->PK_nb, &n->PNG_nb, &n->SNRG_nb, &n->ACO_nb,
+					 &n->HCG_nb, &n->ESO_nb, &n->VdBH_nb };
+	for (int j=0; j<StringCount; ++j)
+		*fields[j] = readString(c.strings[j].offset, c.strings[j].length);
+
+	n->setupDSO(h.type);
+	return n;
+}
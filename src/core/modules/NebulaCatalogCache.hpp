@@ -0,0 +1,89 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef NEBULACATALOGCACHE_HPP
+#define NEBULACATALOGCACHE_HPP
+
+#include "Nebula.hpp"
+
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QSharedPointer>
+#include <QVector>
+
+typedef QSharedPointer<Nebula> NebulaP;
+
+//! @class NebulaCatalogCache
+//! Binary copy of the DSO catalog, which is loaded by mapping the file in memory instead of
+//! uncompressing catalog.dat and parsing it record by record with QDataStream.
+//! The file holds a header, an array of fixed size "hot" records with the data needed to draw the objects
+//! (position, magnitudes, sizes, type and flags), an array of "cold" records with the other catalog data
+//! and a heap with the UTF-16 text of the string fields. The arrays are stored in native byte order and the
+//! file is only valid for the catalog file, catalog version and Stellarium build which wrote it.
+//! The cache is written to the cache directory the first time a catalog is loaded.
+class NebulaCatalogCache
+{
+public:
+	NebulaCatalogCache();
+	~NebulaCatalogCache();
+
+	//! Get a key identifying the catalog file (from its path, size and date) and the cache format.
+	static QByteArray getCacheKey(const QString& catalogFile, const QString& catalogVersion);
+	//! Get the name of the cache file for a catalog file.
+	static QString getCacheFileName(const QString& catalogFile);
+
+	//! Write the catalog to a cache file.
+	//! @param key the key returned by getCacheKey() for the catalog file.
+	static bool save(const QString& cacheFile, const QByteArray& key, const QString& version, const QString& edition,
+			 const QVector<NebulaP>& dsos);
+
+	//! Map a cache file in memory and check that it matches the key.
+	//! @return false if the file does not exist, is invalid or outdated.
+	bool open(const QString& cacheFile, const QByteArray& key);
+	//! Unmap and close the file.
+	void close();
+	bool isOpen() const { return data != Q_NULLPTR; }
+
+	//! Get the number of DSO in the catalog.
+	int size() const { return count; }
+	QString getVersion() const { return version; }
+	QString getEdition() const { return edition; }
+
+	//! Create the DSO of the given index from its records.
+	NebulaP createNebula(int index) const;
+
+private:
+	QString readString(quint32 offset, quint32 length) const;
+
+	QFile file;
+	const uchar* data;
+	int count;
+	QString version;
+	QString edition;
+	// Pointers into the mapped file
+	const uchar* hot;
+	const uchar* cold;
+	const QChar* heap;
+	quint64 heapLength;
+	//! The strings already read, by offset in the heap
+	mutable QHash<quint32, QString> strings;
+};
+
+#endif // NEBULACATALOGCACHE_HPP
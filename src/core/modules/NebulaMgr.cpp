@@ -40,6 +40,7 @@
 #include "StelPainter.hpp"
 #include "RefractionExtinction.hpp"
 #include "StelActionMgr.hpp"
+#include "NebulaCatalogCache.hpp"
 
 #include <algorithm>
 #include <vector>
@@ -145,6 +146,7 @@ NebulaMgr::NebulaMgr(void) : StelObjectModule()
 	, labelsAmount(0)
 	, flagConverter(false)
 	, flagDecimalCoordinates(true)
+	, dataLoaded(false)
 {
 	setObjectName("NebulaMgr");
 }
@@ -461,8 +463,13 @@ void NebulaMgr::init()
 	// 2. load all
 	// 3. flag in nebula_textures.fab (yuk)
 	// 4. info.ini file in each set containing a "load at startup" item
-	// For now (0.9.0), just load the default set
-	loadNebulaSet("default");
+	// For now (0.9.0), just load the default set. It is normally already loaded on a worker thread by StelApp,
+	// but the converter is configured by the settings above and has to run before loading.
+	if (flagConverter)
+		dataLoaded = false;
+	loadModuleData();
+	if (!catalogVersionMismatch.isEmpty())
+		QMessageBox::warning(Q_NULLPTR, q_("Attention!"), QString("%1. %2: %3 - %4: %5. %6").arg(q_("DSO catalog version mismatch"),  q_("Found"), catalogVersionMismatch, q_("Expected"), StellariumDSOCatalogVersion, q_("See Logfile for instructions.")), QMessageBox::Ok);
 
 	updateI18n();
 
@@ -746,15 +753,26 @@ NebulaP NebulaMgr::search(const QString& name)
 	return searchByDesignation(uname);
 }
 
+void NebulaMgr::loadModuleData()
+{
+	if (dataLoaded)
+		return;
+	loadNebulaSet("default");
+	dataLoaded = true;
+}
+
 void NebulaMgr::loadNebulaSet(const QString& setName)
 {
 	QString srcCatalogPath		= StelFileMgr::findFile("nebulae/" + setName + "/catalog.txt");
 	QString dsoCatalogPath		= StelFileMgr::findFile("nebulae/" + setName + "/catalog.dat");
 	QString dsoOutlinesPath		= StelFileMgr::findFile("nebulae/" + setName + "/outlines.dat");
 
+	catalogVersionMismatch.clear();
 	dsoArray.clear();
 	dsoIndex.clear();
 	nebGrid.clear();
+	dsoPointIndex.clear();
+	designationIndex.clear();
 
 	if (flagConverter)
 	{
@@ -779,22 +797,10 @@ void NebulaMgr::loadNebulaSet(const QString& setName)
 // Look for a nebulae by XYZ coords
 NebulaP NebulaMgr::search(const Vec3d& apos)
 {
-	Vec3d pos = apos;
-	pos.normalize();
-	NebulaP plusProche;
-	double anglePlusProche=0.0;
-	for (const auto& n : dsoArray)
-	{
-		if (n->XYZ*pos>anglePlusProche)
-		{
-			anglePlusProche=n->XYZ*pos;
-			plusProche=n;
-		}
-	}
-	if (anglePlusProche>0.999)
-	{
-		return plusProche;
-	}
+	// The nearest DSO within about 2.5 degrees
+	const int nearest = dsoPointIndex.findNearest(apos, 0.999);
+	if (nearest>=0)
+		return dsoArray.at(nearest);
 	else return NebulaP();
 }
 
@@ -805,19 +811,14 @@ QList<StelObjectP> NebulaMgr::searchAround(const Vec3d& av, double limitFov, con
 	if (!getFlagShow())
 		return result;
 
-	Vec3d v(av);
-	v.normalize();
 	const double cosLimFov = cos(limitFov * M_PI/180.);
-	Vec3d equPos;
-	for (const auto& n : dsoArray)
-	{
-		equPos = n->XYZ;
-		equPos.normalize();
-		if (equPos*v >= cosLimFov)
-		{
-			result.push_back(qSharedPointerCast<StelObject>(n));
-		}
-	}
+	QVector<int> found;
+	dsoPointIndex.findInCone(av, cosLimFov, found);
+	// keep the catalog order of the full scan
+	std::sort(found.begin(), found.end());
+	result.reserve(found.size());
+	for (int i : found)
+		result.push_back(qSharedPointerCast<StelObject>(dsoArray.at(i)));
 	return result;
 }
 
@@ -1345,19 +1346,16 @@ void NebulaMgr::convertDSOCatalog(const QString &in, const QString &out, bool de
 	qDebug() << "[...] Please use 'gzip -nc catalog.pack > catalog.dat' to pack the catalog.";
 }
 
-bool NebulaMgr::loadDSOCatalog(const QString &filename)
+bool NebulaMgr::readDSOCatalog(const QString &filename, QVector<NebulaP>& dsos, QString& version, QString& edition)
 {
 	QFile in(filename);
 	if (!in.open(QIODevice::ReadOnly))
 		return false;
 
-	qDebug() << "Loading DSO data ...";
-
 	// Let's begin use gzipped data
 	QDataStream ins(StelUtils::uncompress(in.readAll()));
 	ins.setVersion(QDataStream::Qt_5_2);
 
-	QString version = "", edition= "";
 	int totalRecords=0;
 	while (!ins.atEnd())
 	{
@@ -1368,31 +1366,83 @@ bool NebulaMgr::loadDSOCatalog(const QString &filename)
 				version = "3.1"; // The first version of extended edition of the catalog
 			if (edition.isEmpty())
 				edition = "unknown";
-			qDebug() << "[...]" << QString("Stellarium DSO Catalog, version %1 (%2 edition)").arg(version).arg(edition);
 			if (StelUtils::compareVersions(version, StellariumDSOCatalogVersion)!=0)
-			{
-				++totalRecords;
-				qDebug() << "WARNING: Mismatch of DSO catalog version (" << version << ")! The expected version is" << StellariumDSOCatalogVersion;
-				qDebug() << "         See section 5.5 of the User Guide and install the right version of the catalog!";
-				QMessageBox::warning(Q_NULLPTR, q_("Attention!"), QString("%1. %2: %3 - %4: %5. %6").arg(q_("DSO catalog version mismatch"),  q_("Found"), version, q_("Expected"), StellariumDSOCatalogVersion, q_("See Logfile for instructions.")), QMessageBox::Ok);
 				break;
-			}
 		}
 		else
 		{
 			// Create a new Nebula record
 			NebulaP e = NebulaP(new Nebula);
 			e->readDSO(ins);
-
-			dsoArray.append(e);
-			nebGrid.insert(qSharedPointerCast<StelRegionObject>(e));
-			if (e->DSO_nb!=0)
-				dsoIndex.insert(e->DSO_nb, e);
+			dsos.append(e);
 		}
 		++totalRecords;
 	}
 	in.close();
-	qDebug() << "Loaded" << --totalRecords << "DSO records";
+	return true;
+}
+
+bool NebulaMgr::readDSOCatalogCache(const QString &filename, QVector<NebulaP>& dsos, QString& version, QString& edition)
+{
+	const QString cacheFile = NebulaCatalogCache::getCacheFileName(filename);
+	NebulaCatalogCache cache;
+	if (cacheFile.isEmpty() || !cache.open(cacheFile, NebulaCatalogCache::getCacheKey(filename, StellariumDSOCatalogVersion)))
+		return false;
+
+	version = cache.getVersion();
+	edition = cache.getEdition();
+	dsos.reserve(cache.size());
+	for (int i=0; i<cache.size(); ++i)
+		dsos.append(cache.createNebula(i));
+	return true;
+}
+
+bool NebulaMgr::loadDSOCatalog(const QString &filename)
+{
+	qDebug() << "Loading DSO data ...";
+
+	QVector<NebulaP> dsos;
+	QString version, edition;
+	const bool fromCache = readDSOCatalogCache(filename, dsos, version, edition);
+	if (!fromCache && !readDSOCatalog(filename, dsos, version, edition))
+		return false;
+
+	qDebug() << "[...]" << QString("Stellarium DSO Catalog, version %1 (%2 edition)").arg(version).arg(edition);
+	if (StelUtils::compareVersions(version, StellariumDSOCatalogVersion)!=0)
+	{
+		qDebug() << "WARNING: Mismatch of DSO catalog version (" << version << ")! The expected version is" << StellariumDSOCatalogVersion;
+		qDebug() << "         See section 5.5 of the User Guide and install the right version of the catalog!";
+		// Shown by init(), as this may run on a worker thread
+		catalogVersionMismatch = version;
+		return true;
+	}
+
+	if (!fromCache)
+	{
+		// Next start will map the binary cache instead of parsing catalog.dat again
+		const QString cacheFile = NebulaCatalogCache::getCacheFileName(filename);
+		const QByteArray cacheKey = NebulaCatalogCache::getCacheKey(filename, StellariumDSOCatalogVersion);
+		if (!cacheFile.isEmpty() && !cacheKey.isEmpty())
+		{
+			if (NebulaCatalogCache::save(cacheFile, cacheKey, version, edition, dsos))
+				qDebug() << "Wrote DSO cache" << QDir::toNativeSeparators(cacheFile);
+			else
+				qWarning() << "Could not write DSO cache" << QDir::toNativeSeparators(cacheFile);
+		}
+	}
+
+	dsoArray.reserve(dsos.size());
+	for (const auto& e : dsos)
+	{
+		dsoArray.append(e);
+		nebGrid.insert(qSharedPointerCast<StelRegionObject>(e));
+		dsoPointIndex.insert(e->XYZ, dsoArray.size()-1);
+		if (e->DSO_nb!=0)
+			dsoIndex.insert(e->DSO_nb, e);
+	}
+	dsoPointIndex.build();
+	buildDesignationIndex();
+	qDebug() << "Loaded" << dsos.size() << "DSO records" << (fromCache ? "from cache" : "");
 	return true;
 }
 
@@ -1728,6 +1778,7 @@ void NebulaMgr::updateI18n()
 	const StelTranslator& trans = StelApp::getInstance().getLocaleMgr().getSkyTranslator();
 	for (const auto& n : dsoArray)
 		n->translateName(trans);
+	buildNameIndexes();
 }
 
 
@@ -1858,630 +1909,115 @@ NebulaP NebulaMgr::searchByDesignation(const QString &designation) const
 	return n;
 }
 
-//! Find and return the list of at most maxNbItem objects auto-completing the passed object name
-QStringList NebulaMgr::listMatchingObjects(const QString& objPrefix, int maxNbItem, bool useStartOfWords, bool inEnglish) const
+// Add a catalog designation in the compact ("M31") and the spaced ("M 31") form. Designations using the
+// long name of the catalog (like "Melotte 31") are found as well, but listed with the short name.
+static void addDesignation(StelObjectNameIndex& index, const QString& catalog, const QString& spacedCatalog, const QString& number, const QString& longCatalog=QString())
 {
-	QStringList result;
-	if (maxNbItem <= 0)
-	{
-		return result;
-	}
-
-	QString objw = objPrefix.toUpper();
-
-	// Search by Messier objects number (possible formats are "M31" or "M 31")
-	if (objw.size()>=1 && objw.left(1)=="M" && objw.left(3)!="MEL")
+	index.insert(catalog + number);
+	index.insert(spacedCatalog + number);
+	if (!longCatalog.isEmpty())
 	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->M_nb==0) continue;
-			QString constw = QString("M%1").arg(n->M_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("M %1").arg(n->M_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-				result << constw;
-		}
-	}
-
-	// Search by Melotte objects number (possible formats are "Mel31" or "Mel 31")
-	if (objw.size()>=1 && objw.left(3)=="MEL")
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->Mel_nb==0) continue;
-			QString constw = QString("Mel%1").arg(n->Mel_nb);
-			QString constws = constw.mid(0, objw.size());
-			QString constws2 = QString("Melotte%1").arg(n->Mel_nb).mid(0, objw.size());
-			if (constws.toUpper()==objw || constws2.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("Mel %1").arg(n->Mel_nb);
-			constws = constw.mid(0, objw.size());
-			constws2 = QString("Melotte %1").arg(n->Mel_nb).mid(0, objw.size());
-			if (constws.toUpper()==objw || constws2.toUpper()==objw)
-				result << constw;
-		}
+		index.insert(catalog + number, longCatalog + number);
+		index.insert(spacedCatalog + number, longCatalog + " " + number);
 	}
+}
 
-	// Search by IC objects number (possible formats are "IC466" or "IC 466")
-	if (objw.size()>=1 && objw.left(2)=="IC")
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->IC_nb==0) continue;
-			QString constw = QString("IC%1").arg(n->IC_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("IC %1").arg(n->IC_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-				result << constw;
-		}
-	}
+static void addDesignation(StelObjectNameIndex& index, const QString& catalog, unsigned int number, const QString& longCatalog=QString())
+{
+	if (number>0)
+		addDesignation(index, catalog, catalog + " ", QString::number(number), longCatalog);
+}
 
-	// Search by NGC numbers (possible formats are "NGC31" or "NGC 31")
+void NebulaMgr::buildDesignationIndex()
+{
+	designationIndex.clear();
 	for (const auto& n : dsoArray)
 	{
-		if (n->NGC_nb==0) continue;
-		QString constw = QString("NGC%1").arg(n->NGC_nb);
-		QString constws = constw.mid(0, objw.size());
-		if (constws.toUpper()==objw)
-		{
-			result << constws;
-			continue;
-		}
-		constw = QString("NGC %1").arg(n->NGC_nb);
-		constws = constw.mid(0, objw.size());
-		if (constws.toUpper()==objw)
-			result << constw;
-	}
-
-	// Search by PGC object numbers (possible formats are "PGC31" or "PGC 31")
-	if (objw.size()>=1 && objw.left(3)=="PGC")
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->PGC_nb==0) continue;
-			QString constw = QString("PGC%1").arg(n->PGC_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-			{
-				result << constws;	// Prevent adding both forms for name
-				continue;
-			}
-			constw = QString("PGC %1").arg(n->PGC_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-				result << constw;
-		}
-	}
-
-	// Search by UGC object numbers (possible formats are "UGC31" or "UGC 31")
-	if (objw.size()>=1 && objw.left(3)=="UGC")
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->UGC_nb==0) continue;
-			QString constw = QString("UGC%1").arg(n->UGC_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("UGC %1").arg(n->UGC_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-				result << constw;
-		}
-	}
-
-	// Search by Caldwell objects number (possible formats are "C31" or "C 31")
-	if (objw.size()>=1 && objw.left(1)=="C" && objw.left(2)!="CR" && objw.left(2)!="CE")
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->C_nb==0) continue;
-			QString constw = QString("C%1").arg(n->C_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("C %1").arg(n->C_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-				result << constw;
-		}
-	}
-
-	// Search by Collinder objects number (possible formats are "Cr31" or "Cr 31")
-	if (objw.size()>=1 && (objw.left(2)=="CR" || objw.left(9)=="COLLINDER"))
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->Cr_nb==0) continue;
-			QString constw = QString("Cr%1").arg(n->Cr_nb);
-			QString constws = constw.mid(0, objw.size());
-			QString constws2 = QString("Collinder%1").arg(n->Cr_nb).mid(0, objw.size());
-			if (constws.toUpper()==objw || constws2.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("Cr %1").arg(n->Cr_nb);
-			constws = constw.mid(0, objw.size());
-			constws2 = QString("Collinder %1").arg(n->Cr_nb).mid(0, objw.size());
-			if (constws.toUpper()==objw || constws2.toUpper()==objw)
-				result << constw;
-		}
-	}
-
-	// Search by Ced objects number (possible formats are "Ced31" or "Ced 31")
-	if (objw.size()>=1 && objw.left(3)=="CED")
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->Ced_nb.isEmpty()) continue;
-			QString constw = QString("Ced%1").arg(n->Ced_nb.trimmed());
-			QString constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("Ced %1").arg(n->Ced_nb.trimmed());
-			constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-				result << constw;
-		}
-	}
-
-	// Search by Barnard objects number (possible formats are "B31" or "B 31")
-	if (objw.size()>=1 && objw.left(1)=="B")
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->B_nb==0) continue;
-			QString constw = QString("B%1").arg(n->B_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("B %1").arg(n->B_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-				result << constw;
-		}
-	}
-
-	// Search by Sharpless objects number (possible formats are "Sh2-31" or "Sh 2-31")
-	if (objw.size()>=1 && objw.left(2)=="SH")
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->Sh2_nb==0) continue;
-			QString constw = QString("SH2-%1").arg(n->Sh2_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("SH 2-%1").arg(n->Sh2_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-				result << constw;
-		}
-	}
-
-	// Search by van den Bergh objects number (possible formats are "vdB31" or "vdB 31")
-	if (objw.size()>=1 && objw.left(3)=="VDB" && objw.left(6)!="VDB-HA" && objw.left(4)!="VDBH")
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->VdB_nb==0) continue;
-			QString constw = QString("vdB%1").arg(n->VdB_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("vdB %1").arg(n->VdB_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-				result << constw;
-		}
-	}
-
-	// Search by RCW objects number (possible formats are "RCW31" or "RCW 31")
-	if (objw.size()>=1 && objw.left(3)=="RCW")
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->RCW_nb==0) continue;
-			QString constw = QString("RCW%1").arg(n->RCW_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("RCW %1").arg(n->RCW_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-				result << constw;
-		}
-	}
-
-	// Search by LDN objects number (possible formats are "LDN31" or "LDN 31")
-	if (objw.size()>=1 && objw.left(3)=="LDN")
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->LDN_nb==0) continue;
-			QString constw = QString("LDN%1").arg(n->LDN_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("LDN %1").arg(n->LDN_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-				result << constw;
-		}
-	}
-
-	// Search by LBN objects number (possible formats are "LBN31" or "LBN 31")
-	if (objw.size()>=1 && objw.left(3)=="LBN")
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->LBN_nb==0) continue;
-			QString constw = QString("LBN%1").arg(n->LBN_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("LBN %1").arg(n->LBN_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-				result << constw;
-		}
-	}
-
-	// Search by Arp objects number
-	if (objw.size()>=1 && objw.left(3)=="ARP")
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->Arp_nb==0) continue;
-			QString constw = QString("Arp%1").arg(n->Arp_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("Arp %1").arg(n->Arp_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-				result << constw;
-		}
-	}
-
-	// Search by VV objects number
-	if (objw.size()>=1 && objw.left(2)=="VV")
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->VV_nb==0) continue;
-			QString constw = QString("VV%1").arg(n->VV_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("VV %1").arg(n->VV_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-				result << constw;
-		}
-	}
-
-	// Search by PK objects number
-	if (objw.size()>=1 && objw.left(2)=="PK")
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->PK_nb.isEmpty()) continue;
-			QString constw = QString("PK%1").arg(n->PK_nb.trimmed());
-			QString constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("PK %1").arg(n->PK_nb.trimmed());
-			constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-				result << constw;
-		}
-	}
-
-	// Search by PN G objects number
-	if (objw.size()>=1 && objw.left(2)=="PN")
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->PNG_nb.isEmpty()) continue;
-			QString constw = QString("PNG%1").arg(n->PNG_nb.trimmed());
-			QString constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("PN G%1").arg(n->PNG_nb.trimmed());
-			constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-				result << constw;
-		}
-	}
-
-	// Search by SNR G objects number
-	if (objw.size()>=1 && objw.left(3)=="SNR")
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->SNRG_nb.isEmpty()) continue;
-			QString constw = QString("SNRG%1").arg(n->SNRG_nb.trimmed());
-			QString constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("SNR G%1").arg(n->SNRG_nb.trimmed());
-			constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-				result << constw;
-		}
-	}
-
-	// Search by ACO (Abell) objects number
-	if (objw.size()>=1 && (objw.left(5)=="ABELL" || objw.left(3)=="ACO"))
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->ACO_nb.isEmpty()) continue;
-			QString constw = QString("Abell%1").arg(n->ACO_nb.trimmed());
-			QString constws = constw.mid(0, objw.size());
-			QString constws2 = QString("ACO%1").arg(n->ACO_nb.trimmed()).mid(0, objw.size());
-			if (constws.toUpper()==objw || constws2.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("Abell %1").arg(n->ACO_nb.trimmed());
-			constws = constw.mid(0, objw.size());
-			constws2 = QString("ACO %1").arg(n->ACO_nb.trimmed()).mid(0, objw.size());
-			if (constws.toUpper()==objw || constws2.toUpper()==objw)
-				result << constw;
-		}
-	}
-
-	// Search by HCG objects number
-	if (objw.size()>=1 && objw.left(3)=="HCG")
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->HCG_nb.isEmpty()) continue;
-			QString constw = QString("HCG%1").arg(n->HCG_nb.trimmed());
-			QString constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("HCG %1").arg(n->HCG_nb.trimmed());
-			constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-				result << constw;
-		}
-	}
-
-	// Search by ESO objects number
-	if (objw.size()>=1 && objw.left(3)=="ESO")
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->ESO_nb.isEmpty()) continue;
-			QString constw = QString("ESO%1").arg(n->ESO_nb.trimmed());
-			QString constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("ESO %1").arg(n->ESO_nb.trimmed());
-			constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-				result << constw;
-		}
-	}
-
-	// Search by VdBH objects number
-	if (objw.size()>=1 && objw.left(4)=="VDBH")
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->VdBH_nb.isEmpty()) continue;
-			QString constw = QString("vdBH%1").arg(n->VdBH_nb.trimmed());
-			QString constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("vdBH %1").arg(n->VdBH_nb.trimmed());
-			constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-				result << constw;
-		}
-	}
-
-	// Search by DWB objects number
-	if (objw.size()>=1 && objw.left(3)=="DWB")
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->DWB_nb==0) continue;
-			QString constw = QString("DWB%1").arg(n->DWB_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("DWB %1").arg(n->DWB_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-				result << constw;
-		}
-	}
-
-	// Search by Tr (Trumpler) objects number
-	if (objw.size()>=1 && (objw.left(8)=="TRUMPLER" || objw.left(2)=="TR"))
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->Tr_nb==0) continue;
-			QString constw = QString("Tr%1").arg(n->Tr_nb);
-			QString constws = constw.mid(0, objw.size());
-			QString constws2 = QString("Trumpler%1").arg(n->Tr_nb).mid(0, objw.size());
-			if (constws.toUpper()==objw || constws2.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("Tr %1").arg(n->Tr_nb);
-			constws = constw.mid(0, objw.size());
-			constws2 = QString("Trumpler %1").arg(n->Tr_nb).mid(0, objw.size());
-			if (constws.toUpper()==objw || constws2.toUpper()==objw)
-				result << constw;
-		}
-	}
-
-	// Search by St (Stock) objects number
-	if (objw.size()>=1 && (objw.left(5)=="STOCK" || objw.left(2)=="ST"))
+		addDesignation(designationIndex, "M", n->M_nb);
+		addDesignation(designationIndex, "Mel", n->Mel_nb, "Melotte");
+		addDesignation(designationIndex, "IC", n->IC_nb);
+		addDesignation(designationIndex, "NGC", n->NGC_nb);
+		addDesignation(designationIndex, "PGC", n->PGC_nb);
+		addDesignation(designationIndex, "UGC", n->UGC_nb);
+		addDesignation(designationIndex, "C", n->C_nb);
+		addDesignation(designationIndex, "Cr", n->Cr_nb, "Collinder");
+		addDesignation(designationIndex, "B", n->B_nb);
+		if (n->Sh2_nb>0)
+			addDesignation(designationIndex, "SH2-", "SH 2-", QString::number(n->Sh2_nb));
+		addDesignation(designationIndex, "vdB", n->VdB_nb);
+		addDesignation(designationIndex, "RCW", n->RCW_nb);
+		addDesignation(designationIndex, "LDN", n->LDN_nb);
+		addDesignation(designationIndex, "LBN", n->LBN_nb);
+		addDesignation(designationIndex, "Arp", n->Arp_nb);
+		addDesignation(designationIndex, "VV", n->VV_nb);
+		addDesignation(designationIndex, "DWB", n->DWB_nb);
+		addDesignation(designationIndex, "Tr", n->Tr_nb, "Trumpler");
+		addDesignation(designationIndex, "St", n->St_nb, "Stock");
+		addDesignation(designationIndex, "Ru", n->Ru_nb, "Ruprecht");
+		addDesignation(designationIndex, "vdB-Ha", n->VdBHa_nb);
+		if (!n->Ced_nb.isEmpty())
+			addDesignation(designationIndex, "Ced", "Ced ", n->Ced_nb.trimmed());
+		if (!n->PK_nb.isEmpty())
+			addDesignation(designationIndex, "PK", "PK ", n->PK_nb.trimmed());
+		if (!n->PNG_nb.isEmpty())
+			addDesignation(designationIndex, "PNG", "PN G", n->PNG_nb.trimmed());
+		if (!n->SNRG_nb.isEmpty())
+			addDesignation(designationIndex, "SNRG", "SNR G", n->SNRG_nb.trimmed());
+		if (!n->ACO_nb.isEmpty())
+			addDesignation(designationIndex, "Abell", "Abell ", n->ACO_nb.trimmed(), "ACO");
+		if (!n->HCG_nb.isEmpty())
+			addDesignation(designationIndex, "HCG", "HCG ", n->HCG_nb.trimmed());
+		if (!n->ESO_nb.isEmpty())
+			addDesignation(designationIndex, "ESO", "ESO ", n->ESO_nb.trimmed());
+		if (!n->VdBH_nb.isEmpty())
+			addDesignation(designationIndex, "vdBH", "vdBH ", n->VdBH_nb.trimmed());
+	}
+	designationIndex.build();
+}
+
+void NebulaMgr::buildNameIndexes()
+{
+	nameIndex.clear();
+	nameIndexI18n.clear();
+	aliasIndex.clear();
+	aliasIndexI18n.clear();
+	for (const auto& n : dsoArray)
 	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->St_nb==0) continue;
-			QString constw = QString("St%1").arg(n->St_nb);
-			QString constws = constw.mid(0, objw.size());
-			QString constws2 = QString("Stock%1").arg(n->St_nb).mid(0, objw.size());
-			if (constws.toUpper()==objw || constws2.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("St %1").arg(n->St_nb);
-			constws = constw.mid(0, objw.size());
-			constws2 = QString("Stock %1").arg(n->St_nb).mid(0, objw.size());
-			if (constws.toUpper()==objw || constws2.toUpper()==objw)
-				result << constw;
-		}
+		nameIndex.insert(n->englishName);
+		nameIndexI18n.insert(n->nameI18);
+		for (const auto& alias : n->englishAliases)
+			aliasIndex.insert(alias);
+		for (const auto& alias : n->nameI18Aliases)
+			aliasIndexI18n.insert(alias);
 	}
+	nameIndex.build();
+	nameIndexI18n.build();
+	aliasIndex.build();
+	aliasIndexI18n.build();
+}
 
-	// Search by Ru (Ruprecht) objects number
-	if (objw.size()>=1 && (objw.left(8)=="RUPRECHT" || objw.left(2)=="RU"))
+//! Find and return the list of at most maxNbItem objects auto-completing the passed object name
+QStringList NebulaMgr::listMatchingObjects(const QString& objPrefix, int maxNbItem, bool useStartOfWords, bool inEnglish) const
+{
+	QStringList result;
+	if (maxNbItem <= 0)
 	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->Ru_nb==0) continue;
-			QString constw = QString("Ru%1").arg(n->Ru_nb);
-			QString constws = constw.mid(0, objw.size());
-			QString constws2 = QString("Ruprecht%1").arg(n->Ru_nb).mid(0, objw.size());
-			if (constws.toUpper()==objw || constws2.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("Ru %1").arg(n->Ru_nb);
-			constws = constw.mid(0, objw.size());
-			constws2 = QString("Ruprecht %1").arg(n->Ru_nb).mid(0, objw.size());
-			if (constws.toUpper()==objw || constws2.toUpper()==objw)
-				result << constw;
-		}
+		return result;
 	}
 
-	// Search by van den Bergh-Hagen Catalogue objects number
-	if (objw.size()>=1 && objw.left(6)=="VDB-HA")
-	{
-		for (const auto& n : dsoArray)
-		{
-			if (n->VdBHa_nb==0) continue;
-			QString constw = QString("vdB-Ha%1").arg(n->VdBHa_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("vdB-Ha %1").arg(n->VdBHa_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw)
-				result << constw;
-		}
-	}
+	// Search by catalog designations (possible formats are e.g. "M31" or "M 31"), always from the start
+	result << designationIndex.findPrefix(objPrefix, maxNbItem);
 
 	// Search by common names
-	for (const auto& n : dsoArray)
-	{
-		QString name = inEnglish ? n->englishName : n->nameI18;
-		if (matchObjectName(name, objPrefix, useStartOfWords))
-		{
-			result.append(name);
-		}
-	}
+	result << (inEnglish ? nameIndex : nameIndexI18n).find(objPrefix, maxNbItem, useStartOfWords);
 
 	if (getFlagAdditionalNames())
 	{
 		// Search by aliases of common names
-		for (const auto& n : dsoArray)
-		{
-			QStringList nameList = inEnglish ? n->englishAliases : n->nameI18Aliases;
-			for (auto name : nameList)
-			{
-				if (matchObjectName(name, objPrefix, useStartOfWords))
-					result.append(name);
-			}
-		}
+		result << (inEnglish ? aliasIndex : aliasIndexI18n).find(objPrefix, maxNbItem, useStartOfWords);
 	}
 
+	result.removeDuplicates();
 	result.sort();
 	if (result.size() > maxNbItem)
 	{
@@ -25,6 +25,8 @@
 #include "StelObjectType.hpp"
 #include "StelFader.hpp"
 #include "StelSphericalIndex.hpp"
+#include "StelGeodesicPointIndex.hpp"
+#include "StelObjectNameIndex.hpp"
 #include "StelObjectModule.hpp"
 #include "StelTextureTypes.hpp"
 #include "Nebula.hpp"
@@ -48,6 +50,7 @@ typedef QSharedPointer<Nebula> NebulaP;
 class NebulaMgr : public StelObjectModule
 {
 	Q_OBJECT
+	friend class TestNebulaCatalogCache;
 	//StelActions
 	Q_PROPERTY(bool flagHintDisplayed
 		   READ getFlagHints
@@ -330,6 +333,9 @@ public:
 	//!  - call updateI18n() to translate names.
 	virtual void init();
 
+	//! Load the default set of deep-sky objects, i.e. the catalog and the outlines.
+	virtual void loadModuleData();
+
 	//! Draws all nebula objects.
 	virtual void draw(StelCore* core);
 
@@ -984,11 +990,18 @@ private:
 	//! @param name The case in-sensitive designation of deep-sky object
 	NebulaP searchByDesignation(const QString& designation) const;
 
-	// Load catalog of DSO
+	// Load catalog of DSO, from its binary cache if it is up to date
 	bool loadDSOCatalog(const QString& filename);
+	// Read all the records of catalog.dat
+	static bool readDSOCatalog(const QString& filename, QVector<NebulaP>& dsos, QString& version, QString& edition);
+	// Read all the records of the binary cache of a catalog, if it is up to date
+	static bool readDSOCatalogCache(const QString& filename, QVector<NebulaP>& dsos, QString& version, QString& edition);
 	void convertDSOCatalog(const QString& in, const QString& out, bool decimal);
 	// Load proper names for DSO
 	bool loadDSONames(const QString& filename);
+	// Fill the indexes used by listMatchingObjects()
+	void buildDesignationIndex();
+	void buildNameIndexes();
 	// Load outlines for DSO
 	bool loadDSOOutlines(const QString& filename);
 
@@ -1000,6 +1013,12 @@ private:
 
 	//! The internal grid for fast positional lookup
 	StelSphericalIndex nebGrid;
+	//! The point index of the DSO positions for search() and searchAround(), the ids are indices into dsoArray
+	StelGeodesicPointIndex dsoPointIndex;
+	//! Catalog designations like "M 31" for listMatchingObjects(), built when the catalog is loaded
+	StelObjectNameIndex designationIndex;
+	//! Common names and their aliases for listMatchingObjects(), rebuilt in updateI18n()
+	StelObjectNameIndex nameIndex, nameIndexI18n, aliasIndex, aliasIndexI18n;
 
 	//! The amount of hints (between 0 and 10)
 	double hintsAmount;
@@ -1014,6 +1033,11 @@ private:
 	// For DSO convertor
 	bool flagConverter;
 	bool flagDecimalCoordinates;
+
+	//! Set once the default set is loaded.
+	bool dataLoaded;
+	//! Version of the loaded catalog if it does not match StellariumDSOCatalogVersion, reported by init().
+	QString catalogVersionMismatch;
 };
 
 #endif // NEBULAMGR_HPP
@@ -44,7 +44,7 @@ using namespace std;
 //! @param dt: days from perihel
 //! @param rCosNu: r*cos(nu)
 //! @param rSinNu: r*sin(nu)
-void KeplerOrbit::InitHyp(const double dt, double &rCosNu, double &rSinNu)
+void KeplerOrbit::InitHyp(const double dt, double &rCosNu, double &rSinNu) const
 {
 //	qDebug() << "InitHyp";
 	Q_ASSERT(e>1.0);
@@ -71,7 +71,7 @@ void KeplerOrbit::InitHyp(const double dt, double &rCosNu, double &rSinNu)
 //! @param dt: days from perihel
 //! @param rCosNu: r*cos(nu)
 //! @param rSinNu: r*sin(nu)
-void KeplerOrbit::InitPar(const double dt, double &rCosNu, double &rSinNu)
+void KeplerOrbit::InitPar(const double dt, double &rCosNu, double &rSinNu) const
 {
 //	qDebug() << "InitPar";
 	Q_ASSERT(e==1.0);
@@ -89,7 +89,7 @@ void KeplerOrbit::InitPar(const double dt, double &rCosNu, double &rSinNu)
 //! @param dt: days from perihel
 //! @param rCosNu: r*cos(nu)
 //! @param rSinNu: r*sin(nu)
-void KeplerOrbit::InitEll(const double dt, double &rCosNu, double &rSinNu)
+void KeplerOrbit::InitEll(const double dt, double &rCosNu, double &rSinNu) const
 {
 //	qDebug() << "InitEll";
 	Q_ASSERT(e<1.0);
@@ -191,6 +191,12 @@ void Orbit::setParentOrientation(const double parentRotObliquity, const double p
 
 
 void KeplerOrbit::positionAtTimevInVSOP87Coordinates(double JDE, double *v)
+{
+	computePositionAtTime(JDE, v, rdot);
+	updateTails=true;
+}
+
+void KeplerOrbit::computePositionAtTime(double JDE, double *v, double *vdot) const
 {
 	JDE -= t0;
 	double rCosNu,rSinNu;
@@ -240,11 +246,9 @@ void KeplerOrbit::positionAtTimevInVSOP87Coordinates(double JDE, double *v)
 
 	//rdot.set(s0, s1, s2); // FIXME: The speed also needs to be rotated. Correct?
 
-	rdot[0] = rotateToVsop87[0]*s0 + rotateToVsop87[1]*s1 + rotateToVsop87[2]*s2;
-	rdot[1] = rotateToVsop87[3]*s0 + rotateToVsop87[4]*s1 + rotateToVsop87[5]*s2;
-	rdot[2] = rotateToVsop87[6]*s0 + rotateToVsop87[7]*s1 + rotateToVsop87[8]*s2;
-
-	updateTails=true;
+	vdot[0] = rotateToVsop87[0]*s0 + rotateToVsop87[1]*s1 + rotateToVsop87[2]*s2;
+	vdot[1] = rotateToVsop87[3]*s0 + rotateToVsop87[4]*s1 + rotateToVsop87[5]*s2;
+	vdot[2] = rotateToVsop87[6]*s0 + rotateToVsop87[7]*s1 + rotateToVsop87[8]*s2;
 }
 
 // Calculate sidereal period in days from semi-major axis.
@@ -272,6 +276,12 @@ GimbalOrbit::GimbalOrbit(double distance, double longitude, double latitude):
 };
 //! Compute the position (JDE is just a placeholder) and return a "stellarium compliant" position
 void GimbalOrbit::positionAtTimevInVSOP87Coordinates(double JDE, double* v)
+{
+	double vdot[3];
+	computePositionAtTime(JDE, v, vdot);
+}
+
+void GimbalOrbit::computePositionAtTime(double JDE, double* v, double* vdot) const
 {
 	Q_UNUSED(JDE)
 	Vec3d pos;
@@ -282,4 +292,5 @@ void GimbalOrbit::positionAtTimevInVSOP87Coordinates(double JDE, double* v)
 	v[0] *= distance;
 	v[1] *= distance;
 	v[2] *= distance;
+	vdot[0] = vdot[1] = vdot[2] = 0.;
 }
@@ -29,6 +29,11 @@ public:
     //! @param JDE Julian Ephemeris Date
     //! @param v double array of at least 3 elements. The first three should be filled by the X/Y/Z data.
     virtual void positionAtTimevInVSOP87Coordinates(double JDE, double* v){Q_UNUSED(JDE) Q_UNUSED(v)}
+    //! Compute position (XYZ in AU) and speed [AU/d] without updating any cached values, so that it can be called from other threads.
+    //! @param JDE Julian Ephemeris Date
+    //! @param v double array of at least 3 elements which receives X/Y/Z.
+    //! @param vdot double array of at least 3 elements which receives the speed. (zero in the base class)
+    virtual void computePositionAtTime(double JDE, double* v, double* vdot) const {Q_UNUSED(JDE) Q_UNUSED(v) vdot[0]=0.; vdot[1]=0.; vdot[2]=0.;}
     //! return speed value [AU/d]. (zero in the base class)
     virtual Vec3d getVelocity() const { return Vec3d(0.); }
     //! write speed value [AU/d] into first 3 elements of vel. (zero in the base class)
@@ -67,6 +72,7 @@ public:
 	//! @param JDE Julian Ephemeris Day
 	//! @param v double vector of at least 3 elements. The first three will receive X/Y/Z values in AU.
 	virtual void positionAtTimevInVSOP87Coordinates(double JDE, double* v) Q_DECL_OVERRIDE;
+	virtual void computePositionAtTime(double JDE, double* v, double* vdot) const Q_DECL_OVERRIDE;
 	//! updating comet tails is a bit expensive. try not to overdo it.
 	bool getUpdateTails() const { return updateTails; }
 	void setUpdateTails(const bool update){ updateTails=update; }
@@ -95,9 +101,9 @@ private:
 	const double orbitGood; //!< orb. elements are only valid for this time from perihel [days]. Don't draw the object outside. Values <=0 mean "always good" (objects on undisturbed elliptic orbit)
 	Vec3d rdot;       //!< velocity vector. Caches velocity from last position computation, [AU/d]
 	bool updateTails; //!< flag to signal that comet tails must be recomputed.
-	void InitEll(const double dt, double &rCosNu, double &rSinNu);
-	void InitPar(const double dt, double &rCosNu, double &rSinNu);
-	void InitHyp(const double dt, double &rCosNu, double &rSinNu);
+	void InitEll(const double dt, double &rCosNu, double &rSinNu) const;
+	void InitPar(const double dt, double &rCosNu, double &rSinNu) const;
+	void InitHyp(const double dt, double &rCosNu, double &rSinNu) const;
 };
 
 //! A pseudo-orbit for "observers" linked to a planet's sphere. It allows setting distance and longitude/latitude in the VSOP87 frame.
@@ -110,6 +116,7 @@ public:
 		   );
 	//! Compute position for a (unused) Julian day.
 	virtual void positionAtTimevInVSOP87Coordinates(double JDE, double* v) Q_DECL_OVERRIDE;
+	virtual void computePositionAtTime(double JDE, double* v, double* vdot) const Q_DECL_OVERRIDE;
 	//! Returns (pseudo) semimajor axis [AU] of a circular orbit.
 	double getSemimajorAxis() const Q_DECL_OVERRIDE { return distance; }
 
@@ -0,0 +1,631 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "PhenomenaSearch.hpp"
+#include "StelUtils.hpp"
+
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <QMetaType>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+// Shards smaller than this number of coarse steps are not worth the overhead.
+#define MIN_STEPS_PER_WINDOW 64
+#define MAX_WINDOWS_PER_JOB 32
+// Overlap of neighbouring windows, in coarse steps. The scans need a few samples to detect a turning point.
+#define WINDOW_MARGIN_STEPS 4
+
+PhenomenaSearch::PhenomenaSearch(QObject* parent)
+	: QObject(parent)
+	, pool(new QThreadPool(this))
+	, doneShards(0)
+	, running(false)
+{
+	qRegisterMetaType<QMap<double, double> >();
+	connect(this, SIGNAL(shardFinished(int,int,QMap<double, double>)), this, SLOT(onShardFinished(int,int,QMap<double, double>)), Qt::QueuedConnection);
+}
+
+PhenomenaSearch::~PhenomenaSearch()
+{
+	// Stop without emitting finished(), the receivers may already be half destroyed.
+	cancelled.store(1);
+	generation.fetchAndAddOrdered(1);
+	running = false;
+	waitForFinished();
+}
+
+QMap<double, double> PhenomenaSearch::search(const Job& job, double startJD, double stopJD)
+{
+	return search(job, startJD, stopJD, Q_NULLPTR);
+}
+
+QMap<double, double> PhenomenaSearch::search(const Job& job, double startJD, double stopJD, const QAtomicInt* cancelled)
+{
+	SamplerP sampler = job.createSampler();
+	switch (job.kind)
+	{
+		case Conjunction:
+		case Opposition:
+			return findClosestApproach(sampler.data(), startJD, stopJD, job.step, job.maxSeparation, job.kind==Opposition, cancelled);
+		case GreatestElongation:
+			return findGreatestElongation(sampler.data(), startJD, stopJD, job.step, cancelled);
+		case StationaryPoint:
+			return findStationaryPoint(sampler.data(), startJD, stopJD, job.step, cancelled);
+		case OrbitalPoint:
+			return findOrbitalPoint(sampler.data(), startJD, stopJD, job.step, cancelled);
+	}
+	return QMap<double, double>();
+}
+
+int PhenomenaSearch::windowCount(const Job& job, double startJD, double stopJD)
+{
+	const double steps = (stopJD - startJD) / job.step;
+	return qBound(1, static_cast<int>(steps / MIN_STEPS_PER_WINDOW), MAX_WINDOWS_PER_JOB);
+}
+
+void PhenomenaSearch::start(const QVector<Job>& newJobs, double startJD, double stopJD, int threads)
+{
+	cancel();
+	waitForFinished();
+
+	jobs = newJobs;
+	shards.clear();
+	reported.fill(QMap<double, double>(), jobs.size());
+	for (int j=0; j<jobs.size(); ++j)
+	{
+		const Job& job = jobs.at(j);
+		const int windows = windowCount(job, startJD, stopJD);
+		// Window borders lie on the sampling grid of the reference search.
+		const double windowLength = std::ceil((stopJD - startJD) / job.step / windows) * job.step;
+		const double margin = WINDOW_MARGIN_STEPS * job.step;
+		for (int w=0; w<windows; ++w)
+		{
+			Shard shard;
+			shard.job = j;
+			shard.windowStart = startJD + w*windowLength;
+			shard.windowStop = (w==windows-1 ? stopJD : startJD + (w+1)*windowLength);
+			if (shard.windowStart >= stopJD)
+				break;
+			shard.scanStart = qMax(startJD, shard.windowStart - margin);
+			shard.scanStop = qMin(stopJD, shard.windowStop + margin);
+			// The first window keeps everything before its end, the last window everything after its start.
+			if (w==0)
+				shard.windowStart = -std::numeric_limits<double>::max();
+			if (w==windows-1 || shard.windowStop >= stopJD)
+				shard.windowStop = std::numeric_limits<double>::max();
+			shards.append(shard);
+		}
+	}
+	// Run the early windows of all jobs first, so that the table fills in date order.
+	std::stable_sort(shards.begin(), shards.end(), [](const Shard& a, const Shard& b) { return a.scanStart < b.scanStart; });
+
+	nextShard.store(0);
+	cancelled.store(0);
+	const int gen = generation.fetchAndAddOrdered(1) + 1;
+	doneShards = 0;
+	running = true;
+	if (shards.isEmpty())
+	{
+		running = false;
+		emit finished(false);
+		return;
+	}
+
+	if (threads<=0)
+		threads = QThread::idealThreadCount();
+	threads = qBound(1, threads, shards.size());
+	pool->setMaxThreadCount(threads);
+	workers.clearFutures();
+	for (int i=0; i<threads; ++i)
+		workers.addFuture(QtConcurrent::run(pool, [this, gen]() { runShards(gen); }));
+	emit progressChanged(0, shards.size());
+}
+
+void PhenomenaSearch::cancel()
+{
+	if (!running)
+		return;
+	cancelled.store(1);
+	generation.fetchAndAddOrdered(1);
+	running = false;
+	emit finished(true);
+}
+
+void PhenomenaSearch::waitForFinished()
+{
+	workers.waitForFinished();
+}
+
+void PhenomenaSearch::runShards(int gen)
+{
+	while (!cancelled.load())
+	{
+		const int i = nextShard.fetchAndAddOrdered(1);
+		if (i >= shards.size())
+			break;
+		const Shard& shard = shards.at(i);
+		const Job& job = jobs.at(shard.job);
+		const QMap<double, double> found = search(job, shard.scanStart, shard.scanStop, &cancelled);
+		if (cancelled.load())
+			break;
+		// Neighbouring windows overlap: keep only the events inside this window. Events close to the border may be
+		// refined to slightly different times by both shards, so half a step on either side is kept and duplicates are
+		// dropped in onShardFinished().
+		const double tolerance = 0.5*job.step;
+		QMap<double, double> results;
+		for (auto it = found.constBegin(); it != found.constEnd(); ++it)
+		{
+			if (it.key() >= shard.windowStart - tolerance && it.key() < shard.windowStop + tolerance)
+				results.insert(it.key(), it.value());
+		}
+		emit shardFinished(gen, shard.job, results);
+	}
+}
+
+void PhenomenaSearch::onShardFinished(int gen, int job, const QMap<double, double>& results)
+{
+	if (gen != generation.load() || !running)
+		return;
+
+	++doneShards;
+	// Two events of a job are at least one coarse step apart, anything closer was found by both neighbouring shards.
+	const double tolerance = 0.5*jobs.at(job).step;
+	QMap<double, double>& jobResults = reported[job];
+	QMap<double, double> newResults;
+	for (auto it = results.constBegin(); it != results.constEnd(); ++it)
+	{
+		const auto closest = jobResults.lowerBound(it.key() - tolerance);
+		if (closest != jobResults.end() && closest.key() <= it.key() + tolerance)
+			continue;
+		jobResults.insert(it.key(), it.value());
+		newResults.insert(it.key(), it.value());
+	}
+	if (!newResults.isEmpty())
+		emit resultsReady(job, newResults);
+	emit progressChanged(doneShards, shards.size());
+	if (doneShards == shards.size())
+	{
+		running = false;
+		emit finished(false);
+	}
+}
+
+QMap<double, double> PhenomenaSearch::findClosestApproach(Sampler* sampler, double startJD, double stopJD, double step0, double maxSeparation, bool opposition, const QAtomicInt* cancelled)
+{
+	double dist, prevDist, step;
+	int sgn, prevSgn = 0;
+	QMap<double, double> separations;
+	QPair<double, double> extremum;
+
+	auto distance = [&](double JD) {
+		const double angle = sampler->angularDistance(JD);
+		return opposition ? M_PI - angle : angle;
+	};
+
+	step = step0;
+	double jd = startJD;
+	prevDist = distance(jd);
+	jd += step;
+	while (jd <= stopJD)
+	{
+		if (cancelled && cancelled->load())
+			break;
+
+		dist = distance(jd);
+		sgn = StelUtils::sign(dist - prevDist);
+
+		double factor = qAbs((dist - prevDist) / dist);
+		if (factor > 10.)
+			step = step0 * factor / 10.;
+		else
+			step = step0;
+
+		if (sgn != prevSgn && prevSgn == -1)
+		{
+			if (step > step0)
+			{
+				jd -= step;
+				step = step0;
+				sgn = prevSgn;
+				while (jd <= stopJD)
+				{
+					dist = distance(jd);
+					sgn = StelUtils::sign(dist - prevDist);
+					if (sgn != prevSgn)
+						break;
+
+					prevDist = dist;
+					prevSgn = sgn;
+					jd += step;
+				}
+			}
+
+			if (findPrecise(sampler, &extremum, jd, step, sgn, opposition))
+			{
+				double sep = extremum.second * 180. / M_PI;
+				if (sep < maxSeparation)
+					separations.insert(extremum.first, extremum.second);
+			}
+		}
+
+		prevDist = dist;
+		prevSgn = sgn;
+		jd += step;
+	}
+	return separations;
+}
+
+bool PhenomenaSearch::findPrecise(Sampler* sampler, QPair<double, double>* out, double JD, double step, int prevSign, bool opposition)
+{
+	int sgn;
+	double dist, prevDist;
+
+	if (out == Q_NULLPTR)
+		return false;
+
+	auto distance = [&](double jd) {
+		const double angle = sampler->angularDistance(jd);
+		return opposition ? M_PI - angle : angle;
+	};
+
+	prevDist = distance(JD);
+	step = -step / 2.;
+	prevSign = -prevSign;
+
+	while (true)
+	{
+		JD += step;
+		dist = distance(JD);
+
+		if (qAbs(step) < 1. / 1440.)
+		{
+			out->first = JD - step / 2.0;
+			out->second = distance(JD - step / 2.0);
+			if (out->second < distance(JD - 5.0))
+				return true;
+			else
+				return false;
+		}
+		sgn = StelUtils::sign(dist - prevDist);
+		if (sgn != prevSign)
+		{
+			step = -step / 2.0;
+			sgn = -sgn;
+		}
+		prevDist = dist;
+		prevSign = sgn;
+	}
+}
+
+QMap<double, double> PhenomenaSearch::findGreatestElongation(Sampler* sampler, double startJD, double stopJD, double step0, const QAtomicInt* cancelled)
+{
+	double dist, prevDist, step;
+	QMap<double, double> separations;
+	QPair<double, double> extremum;
+
+	step = step0;
+	double jd = startJD;
+	prevDist = sampler->angularDistance(jd);
+	jd += step;
+	while (jd <= stopJD)
+	{
+		if (cancelled && cancelled->load())
+			break;
+
+		dist = sampler->angularDistance(jd);
+		double factor = qAbs((dist - prevDist) / dist);
+		if (factor > 10.)
+			step = step0 * factor / 10.;
+		else
+			step = step0;
+
+		if (dist>prevDist)
+		{
+			if (step > step0)
+			{
+				jd -= step;
+				step = step0;
+				while (jd <= stopJD)
+				{
+					dist = sampler->angularDistance(jd);
+					if (dist<prevDist)
+						break;
+
+					prevDist = dist;
+					jd += step;
+				}
+			}
+
+			if (findPreciseGreatestElongation(sampler, &extremum, jd, stopJD, step))
+			{
+				separations.insert(extremum.first, extremum.second);
+			}
+		}
+
+		prevDist = dist;
+		jd += step;
+	}
+	return separations;
+}
+
+bool PhenomenaSearch::findPreciseGreatestElongation(Sampler* sampler, QPair<double, double>* out, double JD, double stopJD, double step)
+{
+	double dist, prevDist;
+
+	if (out == Q_NULLPTR)
+		return false;
+
+	prevDist = sampler->angularDistance(JD);
+	step = -step / 2.;
+
+	while (true)
+	{
+		JD += step;
+		dist = sampler->angularDistance(JD);
+
+		if (qAbs(step) < 1. / 1440.)
+		{
+			out->first = JD - step / 2.0;
+			out->second = sampler->angularDistance(JD - step / 2.0);
+			if (out->second > sampler->angularDistance(JD - 5.0))
+			{
+				if (sampler->isEast(JD - 5.0))
+					out->second *= -1.0; // let's use negative value for eastern elongations
+				return true;
+			}
+			else
+				return false;
+		}
+		if (dist<prevDist)
+		{
+			step = -step / 2.0;
+		}
+		prevDist = dist;
+
+		if (JD > stopJD)
+			return false;
+	}
+}
+
+QMap<double, double> PhenomenaSearch::findStationaryPoint(Sampler* sampler, double startJD, double stopJD, double step0, const QAtomicInt* cancelled)
+{
+	double RA, prevRA, step;
+	QMap<double, double> separations;
+	QPair<double, double> extremum;
+
+	// First pass: begin of retrograde motion, second pass: end of retrograde motion
+	for (const bool retrograde : {true, false})
+	{
+		step = step0;
+		double jd = startJD;
+		prevRA = sampler->rightAscension(jd);
+		jd += step;
+		while (jd <= stopJD)
+		{
+			if (cancelled && cancelled->load())
+				break;
+
+			RA = sampler->rightAscension(jd);
+			double factor = qAbs((RA - prevRA) / RA);
+			if (factor > 10.)
+				step = step0 * factor / 10.;
+			else
+				step = step0;
+
+			if ((retrograde ? RA>prevRA : RA<prevRA) && qAbs(RA - prevRA)<180.)
+			{
+				if (step > step0)
+				{
+					jd -= step;
+					step = step0;
+					while (jd <= stopJD)
+					{
+						RA = sampler->rightAscension(jd);
+						if (retrograde ? RA<prevRA : RA>prevRA)
+							break;
+
+						prevRA = RA;
+						jd += step;
+					}
+				}
+
+				if (findPreciseStationaryPoint(sampler, &extremum, jd, stopJD, step, retrograde))
+				{
+					separations.insert(extremum.first, extremum.second);
+				}
+			}
+			prevRA = RA;
+			jd += step;
+		}
+	}
+
+	return separations;
+}
+
+bool PhenomenaSearch::findPreciseStationaryPoint(Sampler* sampler, QPair<double, double>* out, double JD, double stopJD, double step, bool retrograde)
+{
+	double RA, prevRA;
+
+	if (out == Q_NULLPTR)
+		return false;
+
+	prevRA = sampler->rightAscension(JD);
+	step = -step / 2.;
+
+	while (true)
+	{
+		JD += step;
+		RA = sampler->rightAscension(JD);
+
+		if (qAbs(step) < 1. / 1440.)
+		{
+			out->first = JD - step / 2.0;
+			out->second = sampler->rightAscension(JD - step / 2.0);
+			if (retrograde) // begin retrograde motion
+			{
+				if (out->second > sampler->rightAscension(JD - 5.0))
+				{
+					out->second = -1.0;
+					return true;
+				}
+				else
+					return false;
+			}
+			else
+			{
+				if (out->second < sampler->rightAscension(JD - 5.0))
+				{
+					out->second = 1.0;
+					return true;
+				}
+				else
+					return false;
+			}
+		}
+		if (retrograde)
+		{
+			if (RA<prevRA)
+				step = -step / 2.0;
+		}
+		else
+		{
+			if (RA>prevRA)
+				step = -step / 2.0;
+		}
+		prevRA = RA;
+
+		if (JD > stopJD)
+			return false;
+	}
+}
+
+QMap<double, double> PhenomenaSearch::findOrbitalPoint(Sampler* sampler, double startJD, double stopJD, double step0, const QAtomicInt* cancelled)
+{
+	double distance, prevDistance, step;
+	QMap<double, double> separations;
+	QPair<double, double> extremum;
+
+	const double stopJDfx = stopJD + step0;
+	// First pass: aphelion, second pass: perihelion
+	for (const bool minimal : {false, true})
+	{
+		step = step0;
+		double jd = startJD - step;
+		prevDistance = sampler->heliocentricDistance(jd);
+		jd += step;
+		while (jd <= stopJDfx)
+		{
+			if (cancelled && cancelled->load())
+				break;
+
+			distance = sampler->heliocentricDistance(jd);
+			double factor = qAbs((distance - prevDistance) / distance);
+			if (factor > 10.)
+				step = step0 * factor / 10.;
+			else
+				step = step0;
+
+			if (minimal ? distance<prevDistance : distance>prevDistance)
+			{
+				if (step > step0)
+				{
+					jd -= step;
+					step = step0;
+					while (jd <= stopJDfx)
+					{
+						distance = sampler->heliocentricDistance(jd);
+						if (minimal ? distance>prevDistance : distance<prevDistance)
+							break;
+
+						prevDistance = distance;
+						jd += step;
+					}
+				}
+
+				if (findPreciseOrbitalPoint(sampler, &extremum, jd, stopJDfx, step, minimal))
+				{
+					if (extremum.first>startJD && extremum.first<stopJD)
+						separations.insert(extremum.first, extremum.second);
+				}
+			}
+
+			prevDistance = distance;
+			jd += step;
+		}
+	}
+
+	return separations;
+}
+
+bool PhenomenaSearch::findPreciseOrbitalPoint(Sampler* sampler, QPair<double, double>* out, double JD, double stopJD, double step, bool minimal)
+{
+	double dist, prevDist;
+
+	if (out == Q_NULLPTR)
+		return false;
+
+	prevDist = sampler->heliocentricDistance(JD);
+	step = -step / 2.;
+
+	while (true)
+	{
+		JD += step;
+		dist = sampler->heliocentricDistance(JD);
+
+		if (qAbs(step) < 1. / 1440.)
+		{
+			out->first = JD - step / 2.0;
+			out->second = sampler->heliocentricDistance(JD - step / 2.0);
+			if (minimal)
+			{
+				if (out->second > sampler->heliocentricDistance(JD - step / 5.0))
+				{
+					out->second *= -1;
+					return true;
+				}
+				else
+					return false;
+			}
+			else
+			{
+				if (out->second < sampler->heliocentricDistance(JD - step / 5.0))
+					return true;
+				else
+					return false;
+			}
+		}
+		if (minimal)
+		{
+			if (dist>prevDist)
+				step = -step / 2.0;
+		}
+		else
+		{
+			if (dist<prevDist)
+				step = -step / 2.0;
+		}
+		prevDist = dist;
+
+		if (JD > stopJD)
+			return false;
+	}
+}
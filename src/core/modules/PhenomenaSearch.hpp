@@ -0,0 +1,162 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef PHENOMENASEARCH_HPP
+#define PHENOMENASEARCH_HPP
+
+#include <QObject>
+#include <QMap>
+#include <QVector>
+#include <QSharedPointer>
+#include <QAtomicInt>
+#include <QFutureSynchronizer>
+
+#include <functional>
+
+class QThreadPool;
+
+//! @class PhenomenaSearch
+//! Searches for conjunctions, oppositions, greatest elongations, stationary points and perihelion/aphelion passages.
+//! The search algorithms step through the time range with a coarse step and refine every extremum they find to one minute.
+//!
+//! There are two ways to run a search:
+//! - search() runs one job on the calling thread over the whole time range. This is the deterministic reference.
+//! - start() shards every job into time windows and runs the shards on a thread pool. The results are streamed with
+//!   resultsReady() while the search runs, it can be cancelled and reports its progress.
+//!
+//! The windows of a job start on the coarse sampling grid of the reference search and overlap by a few steps. Every shard
+//! keeps the events within half a step around its window and an event found by two shards is reported once.
+//! While the scans keep the coarse step, a shard samples the same dates as the reference search and finds the same events.
+//! After an adaptive (larger) step the scans leave the grid, so near the window borders the refined times may differ from
+//! the reference search within the refinement precision of about one minute.
+class PhenomenaSearch : public QObject
+{
+	Q_OBJECT
+
+public:
+	//! The phenomena. The values are the same as AstroCalcDialog::PhenomenaTypeIndex.
+	enum Kind
+	{
+		Conjunction		= 0,
+		Opposition		= 1,
+		GreatestElongation	= 2,
+		StationaryPoint		= 3,
+		OrbitalPoint		= 4
+	};
+
+	//! Provides the quantities the algorithms search for extrema. All times are JD (UT).
+	//! A new sampler is created for every shard on the thread which runs it, so implementations need not be thread-safe.
+	class Sampler
+	{
+	public:
+		virtual ~Sampler() {}
+		//! Angular distance between the two objects in radians. Used for conjunctions, oppositions and greatest elongations.
+		virtual double angularDistance(double JD) { Q_UNUSED(JD) return 0.; }
+		//! True if the first object has a larger J2000 longitude than the second. Used to mark eastern elongations.
+		virtual bool isEast(double JD) { Q_UNUSED(JD) return false; }
+		//! J2000 right ascension of the first object in degrees. Used for stationary points.
+		virtual double rightAscension(double JD) { Q_UNUSED(JD) return 0.; }
+		//! Heliocentric distance of the first object in AU. Used for perihelion and aphelion.
+		virtual double heliocentricDistance(double JD) { Q_UNUSED(JD) return 0.; }
+	};
+	typedef QSharedPointer<Sampler> SamplerP;
+
+	//! One search: a kind of phenomenon for one object (pair).
+	struct Job
+	{
+		Job() : kind(Conjunction), step(1.), maxSeparation(180.) {}
+		Kind kind;
+		//! coarse sampling step in days, see AstroCalcDialog::findInitialStep()
+		double step;
+		//! largest separation in degrees reported for conjunctions and oppositions
+		double maxSeparation;
+		//! creates the sampler for this job. Called on the worker threads.
+		std::function<SamplerP()> createSampler;
+	};
+
+	PhenomenaSearch(QObject* parent=Q_NULLPTR);
+	~PhenomenaSearch() Q_DECL_OVERRIDE;
+
+	//! Run a job over [startJD, stopJD] on the calling thread.
+	//! @return map of JD to the value of the phenomenon (separation in radians, elongation with negative values
+	//! for eastern elongations, -1/+1 for begin/end of retrograde motion, heliocentric distance with negative values for perihelion)
+	static QMap<double, double> search(const Job& job, double startJD, double stopJD);
+
+	//! Start searching all jobs over [startJD, stopJD] in the background. A running search is cancelled first.
+	//! @param threads number of threads to use, 0 means one per CPU core
+	void start(const QVector<Job>& jobs, double startJD, double stopJD, int threads=0);
+	//! Stop the running search. Shards in progress finish their current sample, no further results are reported.
+	void cancel();
+	//! Wait until the background search has finished or has been cancelled.
+	void waitForFinished();
+	bool isRunning() const { return running; }
+
+	//! Number of time windows a job over the given range is split into.
+	static int windowCount(const Job& job, double startJD, double stopJD);
+
+signals:
+	//! Results of one shard of a job. The signals are emitted on the thread of this object, never for a cancelled search.
+	void resultsReady(int job, const QMap<double, double>& results);
+	//! Emitted after every finished shard.
+	void progressChanged(int done, int total);
+	//! Emitted when all shards have finished or the search has been cancelled.
+	void finished(bool cancelled);
+
+	//! Internal: posted by the worker threads.
+	void shardFinished(int generation, int job, const QMap<double, double>& results);
+
+private slots:
+	void onShardFinished(int generation, int job, const QMap<double, double>& results);
+
+private:
+	struct Shard
+	{
+		int job;
+		double windowStart;
+		double windowStop;
+		double scanStart;
+		double scanStop;
+	};
+
+	static QMap<double, double> search(const Job& job, double startJD, double stopJD, const QAtomicInt* cancelled);
+	static QMap<double, double> findClosestApproach(Sampler* sampler, double startJD, double stopJD, double step, double maxSeparation, bool opposition, const QAtomicInt* cancelled);
+	static bool findPrecise(Sampler* sampler, QPair<double, double>* out, double JD, double step, int prevSign, bool opposition);
+	static QMap<double, double> findGreatestElongation(Sampler* sampler, double startJD, double stopJD, double step, const QAtomicInt* cancelled);
+	static bool findPreciseGreatestElongation(Sampler* sampler, QPair<double, double>* out, double JD, double stopJD, double step);
+	static QMap<double, double> findStationaryPoint(Sampler* sampler, double startJD, double stopJD, double step, const QAtomicInt* cancelled);
+	static bool findPreciseStationaryPoint(Sampler* sampler, QPair<double, double>* out, double JD, double stopJD, double step, bool retrograde);
+	static QMap<double, double> findOrbitalPoint(Sampler* sampler, double startJD, double stopJD, double step, const QAtomicInt* cancelled);
+	static bool findPreciseOrbitalPoint(Sampler* sampler, QPair<double, double>* out, double JD, double stopJD, double step, bool minimal);
+
+	//! Worker loop: takes shards from the queue until it is empty or the search is cancelled.
+	void runShards(int generation);
+
+	QThreadPool* pool;
+	QFutureSynchronizer<void> workers;
+	QVector<Job> jobs;
+	QVector<Shard> shards;
+	QVector<QMap<double, double> > reported; //!< events reported so far for every job, to drop the duplicates of neighbouring shards
+	QAtomicInt nextShard;
+	QAtomicInt generation;   //!< incremented by every start() and cancel(), results of older searches are dropped
+	QAtomicInt cancelled;
+	int doneShards;          //!< counted on the thread of this object
+	bool running;
+};
+
+#endif // PHENOMENASEARCH_HPP
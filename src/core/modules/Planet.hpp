@@ -44,6 +44,7 @@ typedef void (OsculatingFunctType)(double jde0,double jde,double xyz[3], double
 
 class Orbit;
 class KeplerOrbit;
+class EphemerisContext;
 class StelFont;
 class StelPainter;
 class StelTranslator;
@@ -92,6 +93,7 @@ class Planet : public StelObject
 public:
 	static const QString PLANET_TYPE;
 	friend class SolarSystem;
+	friend class TestPositionEvaluator;
 
 	Q_ENUMS(PlanetType)
 	Q_ENUMS(PlanetOrbitColorStyle)
@@ -295,6 +297,14 @@ public:
 	//! This requires both flavours of JD in cases involving Earth.
 	void computeTransMatrix(double JD, double JDE);
 
+	//! Compute the position in the parent Planet coordinate system at dateJDE without updating the state of this Planet.
+	//! @param context ephemeris caches to use for the major planets and the Moon. May be Q_NULLPTR to use the shared caches.
+	//! This may be called from other threads as long as each thread uses its own context.
+	Vec3d computeEclipticPos(double dateJDE, EphemerisContext* context) const;
+	//! Compute the rotation from the planet's equatorial frame to VSOP87 at dateJDE without updating the state of this Planet.
+	//! This is the stateless counterpart of computeTransMatrix() followed by getRotEquatorialToVsop87().
+	Mat4d computeRotEquatorialToVsop87(double dateJDE) const;
+
 	//! Get the phase angle (radians) for an observer at pos obsPos in heliocentric coordinates (in AU)
 	double getPhaseAngle(const Vec3d& obsPos) const;
 	//! Get the elongation angle (radians) for an observer at pos obsPos in heliocentric coordinates (in AU)
@@ -509,6 +519,9 @@ protected:
 
 	void computeModelMatrix(Mat4d &result) const;
 
+	//! Compute the axis orientation with respect to the parent body at JDE (the value computeTransMatrix() stores in rotLocalToParent).
+	Mat4d computeRotLocalToParent(double JDE) const;
+
 	//! Update the orbit position values.
 	void computeOrbit();
 
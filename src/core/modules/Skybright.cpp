@@ -107,6 +107,61 @@ float Skybright::getLuminance( float cosDistMoon,
 	if (!GETSTELMODULE(SolarSystem)->getFlagPlanets())
 		return 0.f;
 
+	return computeLuminance(cosDistMoon, cosDistSun, cosDistZenith);
+}
+
+// Same model as computeLuminance(), written without branches: the conditional terms are always computed
+// and then kept or dropped, so that the loop can be vectorized.
+void Skybright::getLuminance(int n, const float* cosDistMoon, const float* cosDistSun, const float* cosDistZenith, float* luminance) const
+{
+	const float KTwilight = K> 0.05f ? K : 0.05f;
+	for (int i=0; i<n; ++i)
+	{
+		const float cz = cosDistZenith[i];
+		const float cs = cosDistSun[i];
+		const float cm = cosDistMoon[i] < 1.f ? cosDistMoon[i] : 1.f;
+
+		// Air mass, with both halves of StelUtils::fastExp()
+		const float x = -11.f*cz;
+		const float expPos = 1.f + x*(1.f+ x/2.f*(1.f+ x/3.f*(1.f+x/4.f*(1.f+x/5.f))));
+		const float expNeg = 1.f / (1.f -x*(1.f -x/2.f*(1.f- x/3.f*(1.f-x/4.f*(1.f-x/5.f)))));
+		const float bKX = stelpow10f(-0.4f * K * (1.f / (cz + 0.025f*(x>=0 ? expPos : expNeg))));
+
+		// Daylight brightness
+		const float distSun = StelUtils::fastAcos(cs);
+		const float FSv = 18886.28f / (distSun*distSun + 0.0007f)
+		               + stelpow10f(6.15f - (distSun+0.001f)* 1.43239f)
+		               + 229086.77f * ( 1.06f + cs*cs );
+		const float b_daylight = 9.289663e-12f * (1.f - bKX) * (FSv * C4 + 440000.f * (1.f - C4));
+
+		//Twilight brightness
+		const float b_twilight = stelpow10f(bTwilightTerm + 0.063661977f * StelUtils::fastAcos(cz)/KTwilight) * (1.7453293f / distSun) * (1.f-bKX);
+
+		float b_total = ((b_twilight<b_daylight) ? b_twilight : b_daylight);
+
+		// Moonlight brightness, only added if more than 1% daylight.
+		// Around 1, acos(x) is computed from its series in sqrt(2(1-x)) instead of calling acosf().
+		const float t = 1.f - cm;
+		const float distMoonNear = std::sqrt(2.f*t) * (1.f + t*(1.f/12.f + t*(3.f/160.f)));
+		const float dist_moon = cm > 0.99f ? distMoonNear : StelUtils::fastAcos(cm);
+		const float FM = 18886.28f / (dist_moon*dist_moon + 0.0005f)
+			+ stelpow10f(6.15f - dist_moon * 1.43239f)
+			+ 229086.77f * ( 1.06f + cm*cm );
+		const float b_moon = bMoonTerm1 * (1.f - bKX) * (FM * C3 + 440000.f * (1.f - C3));
+		const bool addMoon = (bMoonTerm1 * (1.f - bKX) * (28860205.1341274269f * C3 + 440000.f * (1.f - C3)))/b_total>0.01f;
+		b_total += addMoon ? b_moon : 0.f;
+
+		// Dark night sky brightness, only added if more than 1% daylight
+		const float b_night = (0.4f + 0.6f / std::sqrt(0.04f + 0.96f * cz*cz)) * bNightTerm * bKX;
+		const bool addNight = (bNightTerm*bKX)/b_total>0.01f;
+		b_total += addNight ? b_night : 0.f;
+
+		luminance[i] = (b_total<0.f) ? 0.f : b_total * (900900.9f * M_PIf * 1e-4f * 3239389.f*2.f *1.5f);
+	}
+}
+
+float Skybright::computeLuminance(float cosDistMoon, const float cosDistSun, const float cosDistZenith) const
+{
 	// Air mass
 	const float bKX = stelpow10f(-0.4f * K * (1.f / (cosDistZenith + 0.025f*StelUtils::fastExp(-11.f*cosDistZenith))));
 
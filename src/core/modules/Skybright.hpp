@@ -39,6 +39,7 @@
 //! the code here really follows the Schaefer model (with obvious amendments).
 class Skybright
 {
+	friend class TestSkybright;
 public:
 	//! Constructor
 	Skybright();
@@ -69,7 +70,21 @@ public:
 	//! @param cosDistZenith cos(angular distance between zenith and the position)
 	float getLuminance(float cosDistMoon, const float cosDistSun, const float cosDistZenith) const;
 
+	//! Compute the luminance at n positions given as structure of arrays.
+	//! This is the batch version of getLuminance() for large grids of positions. Unlike getLuminance(), it doesn't check
+	//! whether the planets are displayed: the caller has to do it once for the whole grid. It uses no other object, so
+	//! several threads can call it at once on different parts of a grid.
+	//! The loop has no branches, the moonlight and night sky terms are computed for every position and then kept or
+	//! dropped. Whether it is vectorized depends on the compiler having vector versions of exp(), e.g. with -ffast-math.
+	//! The results match getLuminance() to about 1e-5 relative.
+	//! @param cosDistMoon, cosDistSun, cosDistZenith arrays of the n cosines of the angular distances to the moon, the sun and the zenith.
+	//! @param luminance receives the n luminances.
+	void getLuminance(int n, const float* cosDistMoon, const float* cosDistSun, const float* cosDistZenith, float* luminance) const;
+
 private:
+	//! The luminance model of getLuminance(), without checking whether the planets are displayed.
+	float computeLuminance(float cosDistMoon, const float cosDistSun, const float cosDistZenith) const;
+
 	float airMassMoon;  // Air mass for the Moon
 	float airMassSun;   // Air mass for the Sun
 	float magMoon;      // Moon magnitude
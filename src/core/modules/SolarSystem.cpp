@@ -42,13 +42,16 @@
 #include "StelSkyDrawer.hpp"
 #include "StelUtils.hpp"
 #include "StelPainter.hpp"
+#include "StelProfiler.hpp"
 #include "TrailGroup.hpp"
 #include "RefractionExtinction.hpp"
 
 #include "AstroCalcDialog.hpp"
+#include "BatchEphemeris.hpp"
 #include "StelObserver.hpp"
 
 #include <functional>
+#include <limits>
 #include <algorithm>
 
 #include <QTextStream>
@@ -62,6 +65,7 @@
 #include <QDebug>
 #include <QDir>
 #include <QHash>
+#include <QElapsedTimer>
 
 SolarSystem::SolarSystem() : StelObjectModule()
 	, shadowPlanetCount(0)
@@ -70,6 +74,7 @@ SolarSystem::SolarSystem() : StelObjectModule()
 	, flagMinorBodyScale(false)
 	, minorBodyScale(1.0)
 	, labelsAmount(false)
+	, nameIndexDirty(true)
 	, flagOrbits(false)
 	, flagLightTravelTime(true)
 	, flagUseObjModels(false)
@@ -1079,6 +1084,7 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 		systemPlanets.push_back(newP);
 		readOk++;
 	}
+	nameIndexDirty = true;
 
 	if (systemPlanets.isEmpty())
 	{
@@ -1108,6 +1114,7 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 // The order is not important since the position is computed relatively to the mother body
 void SolarSystem::computePositions(double dateJDE, PlanetP observerPlanet)
 {
+	StelProfiler::Scope profileScope("SolarSystem::computePositions");
 	if (flagLightTravelTime)
 	{
 		for (const auto& p : systemPlanets)
@@ -1168,6 +1175,160 @@ void SolarSystem::computeTransMatrices(double dateJDE, const Vec3d& observerPos)
 	}
 }
 
+SolarSystem::PositionEvaluator::PositionEvaluator(const SolarSystem* solarSystem, StelCore* core)
+	: core(core)
+	, context(Q_NULLPTR)
+	, useDe430(core->de430IsActive())
+	, useDe431(core->de431IsActive())
+	, sun(solarSystem->getSun())
+	, homePlanet(core->getCurrentPlanet())
+	, lightTravelTime(solarSystem->getFlagLightTravelTime())
+	, topocentric(core->getUseTopocentricCoordinates())
+	, longitude(static_cast<double>(core->getCurrentLocation().longitude))
+	, latitude(qBound(-90.0, static_cast<double>(core->getCurrentLocation().latitude), 90.0))
+	, observerJDE(std::numeric_limits<double>::quiet_NaN())
+{
+	// Same offset as in StelCore::updateTransformMatrices()
+	const Vec4d offset=core->getCurrentObserver()->getTopographicOffsetFromCenter(); // [rho cosPhi', rho sinPhi', phi'_rad, rho]
+	const double sigma=static_cast<double>(core->getCurrentLocation().latitude)*M_PI/180.0 - offset.v[2];
+	const double rho=offset.v[3];
+	topocentricOffset.set(rho*sin(sigma), 0., rho*cos(sigma));
+	context = new EphemerisContext(useDe430, useDe431);
+}
+
+SolarSystem::PositionEvaluator::PositionEvaluator(const PositionEvaluator& other)
+	: core(other.core)
+	, context(new EphemerisContext(other.useDe430, other.useDe431))
+	, useDe430(other.useDe430)
+	, useDe431(other.useDe431)
+	, sun(other.sun)
+	, homePlanet(other.homePlanet)
+	, lightTravelTime(other.lightTravelTime)
+	, topocentric(other.topocentric)
+	, longitude(other.longitude)
+	, latitude(other.latitude)
+	, topocentricOffset(other.topocentricOffset)
+	, observerJDE(std::numeric_limits<double>::quiet_NaN())
+{
+}
+
+SolarSystem::PositionEvaluator::~PositionEvaluator()
+{
+	delete context;
+}
+
+double SolarSystem::PositionEvaluator::getJDE(double JD) const
+{
+	return JD + core->computeDeltaT(JD)/86400.0;
+}
+
+Vec3d SolarSystem::PositionEvaluator::getGeometricHeliocentricEclipticPos(const Planet* planet, double JDE)
+{
+	Vec3d pos(0.);
+	// The sun is the ultimate parent and stays in the origin.
+	for (const Planet* p=planet; p->getParent(); p=p->getParent().data())
+		pos += p->computeEclipticPos(JDE, context);
+	return pos;
+}
+
+Vec3d SolarSystem::PositionEvaluator::computeLightTimeCorrectedPos(const Planet* planet, double JDE, const Vec3d& observerCenter, EphemerisContext* context)
+{
+	if (!planet->getParent())
+		return Vec3d(0.);
+
+	// computePositions() corrects the parents before their satellites, so the satellite is seen relative to its corrected parent.
+	const Vec3d parentPos = computeLightTimeCorrectedPos(planet->getParent().data(), JDE, observerCenter, context);
+	const Vec3d geometricPos = parentPos + planet->computeEclipticPos(JDE, context);
+	const double light_speed_correction = (geometricPos-observerCenter).length() * (AU / (SPEED_OF_LIGHT * 86400.));
+	// Planet::computePosition() keeps the position of dateJDE if the date changes by no more than deltaJDE.
+	if (light_speed_correction<=planet->deltaJDE)
+		return geometricPos;
+	return parentPos + planet->computeEclipticPos(JDE-light_speed_correction, context);
+}
+
+void SolarSystem::PositionEvaluator::updateObserver(double JDE)
+{
+	if (JDE==observerJDE)
+		return;
+
+	observerJDE = JDE;
+	observerCenterPos = getGeometricHeliocentricEclipticPos(homePlanet.data(), JDE);
+	observerPos = observerCenterPos;
+	if (topocentric)
+	{
+		// See StelCore::updateTransformMatrices() and StelObserver::getRotAltAzToEquatorial()
+		const double JD = JDE - core->computeDeltaT(JDE)/86400.0;
+		const Mat4d matAltAzToEquinoxEqu = Mat4d::zrotation((homePlanet->getSiderealTime(JD, JDE)+longitude)*M_PI/180.)
+						 * Mat4d::yrotation((90.-latitude)*M_PI/180.);
+		const Mat4d matAltAzToVsop87 = homePlanet->computeRotEquatorialToVsop87(JDE) * matAltAzToEquinoxEqu;
+		observerPos += matAltAzToVsop87.multiplyWithoutTranslation(topocentricOffset);
+	}
+
+	// See the solar light time hack in computePositions()
+	if (lightTravelTime)
+	{
+		const double obsDist = observerCenterPos.length();
+		lightTimeSunPos = observerCenterPos - getGeometricHeliocentricEclipticPos(homePlanet.data(), JDE-obsDist * (AU / (SPEED_OF_LIGHT * 86400.)));
+	}
+	else
+		lightTimeSunPos.set(0., 0., 0.);
+}
+
+Vec3d SolarSystem::PositionEvaluator::getHeliocentricEclipticPos(const Planet* planet, double JDE)
+{
+	if (!lightTravelTime)
+		return getGeometricHeliocentricEclipticPos(planet, JDE);
+
+	updateObserver(JDE);
+	return computeLightTimeCorrectedPos(planet, JDE, observerCenterPos, context);
+}
+
+Vec3d SolarSystem::PositionEvaluator::getObserverHeliocentricEclipticPos(double JDE)
+{
+	updateObserver(JDE);
+	return observerPos;
+}
+
+Vec3d SolarSystem::PositionEvaluator::getJ2000EquatorialPos(const StelObject* object, double JDE)
+{
+	const Planet* planet = dynamic_cast<const Planet*>(object);
+	if (!planet)
+		return object->getJ2000EquatorialPos(core);
+
+	updateObserver(JDE);
+	const Vec3d pos = (planet==sun.data() ? lightTimeSunPos : getHeliocentricEclipticPos(planet, JDE));
+	return StelCore::matVsop87ToJ2000.multiplyWithoutTranslation(pos - observerPos);
+}
+
+QVariantMap SolarSystem::exportEphemeris(const QString& fileName, const QStringList& objects, double startJD, double stopJD, double stepMinutes, const QString& format)
+{
+	BatchEphemeris batch(this, StelApp::getInstance().getCore());
+	if (!batch.setObjects(objects))
+	{
+		qWarning() << "SolarSystem: ephemeris export failed:" << batch.errorString();
+		QVariantMap result;
+		result.insert("error", batch.errorString());
+		return result;
+	}
+	batch.setRange(startJD, stopJD, stepMinutes/1440.);
+	if (format.isEmpty())
+		batch.setFormat(BatchEphemeris::formatForFileName(fileName));
+	else
+		batch.setFormat(format.toLower()=="csv" ? BatchEphemeris::Csv : BatchEphemeris::Binary);
+
+	QVariantMap result;
+	const qint64 rows = batch.writeFile(fileName);
+	if (rows<0)
+	{
+		qWarning() << "SolarSystem: ephemeris export failed:" << batch.errorString();
+		result.insert("error", batch.errorString());
+		return result;
+	}
+	qDebug() << "SolarSystem: exported" << rows << "ephemeris rows to" << QDir::toNativeSeparators(fileName);
+	result.insert("rows", rows);
+	return result;
+}
+
 // And sort them from the furthest to the closest to the observer
 struct biggerDistance : public std::binary_function<PlanetP, PlanetP, bool>
 {
@@ -1613,6 +1774,7 @@ void SolarSystem::updateI18n()
 	const StelTranslator& trans = StelApp::getInstance().getLocaleMgr().getSkyTranslator();
 	for (const auto& p : systemPlanets)
 		p->translateName(trans);
+	nameIndexDirty = true;
 }
 
 void SolarSystem::setFlagTrails(bool b)
@@ -1829,6 +1991,28 @@ bool SolarSystem::nearLunarEclipse() const
 	return true;
 }
 
+QStringList SolarSystem::listMatchingObjects(const QString& objPrefix, int maxNbItem, bool useStartOfWords, bool inEnglish) const
+{
+	if (maxNbItem <= 0)
+		return QStringList();
+
+	if (nameIndexDirty)
+	{
+		nameIndex.clear();
+		nameIndexI18n.clear();
+		for (const auto& p : systemPlanets)
+		{
+			nameIndex.insert(p->getEnglishName());
+			nameIndexI18n.insert(p->getNameI18n());
+		}
+		nameIndex.build();
+		nameIndexI18n.build();
+		nameIndexDirty = false;
+	}
+
+	return (inEnglish ? nameIndex : nameIndexI18n).find(objPrefix, maxNbItem, useStartOfWords);
+}
+
 QStringList SolarSystem::listAllObjects(bool inEnglish) const
 {
 	QStringList result;
@@ -2978,6 +3162,7 @@ bool SolarSystem::removeMinorPlanet(QString name)
 		orbits.removeOne(orbPtr);
 	systemPlanets.removeOne(candidate);
 	systemMinorBodies.removeOne(candidate);
+	nameIndexDirty = true;
 	candidate.clear();
 	return true;
 }
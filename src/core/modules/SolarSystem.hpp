@@ -26,6 +26,7 @@
 #endif
 
 #include "StelObjectModule.hpp"
+#include "StelObjectNameIndex.hpp"
 #include "StelTextureTypes.hpp"
 #include "Planet.hpp"
 #include "StelGui.hpp"
@@ -34,6 +35,7 @@
 #include <QFont>
 
 class Orbit;
+class EphemerisContext;
 class StelTranslator;
 class StelObject;
 class StelCore;
@@ -191,6 +193,9 @@ public:
 		return searchByName(id);
 	}
 
+	//! Find and return the list of at most maxNbItem objects auto-completing the passed object name.
+	//! The names are looked up in an index, which is rebuilt after the bodies or their names have changed.
+	virtual QStringList listMatchingObjects(const QString& objPrefix, int maxNbItem=5, bool useStartOfWords=false, bool inEnglish=false) const;
 	virtual QStringList listAllObjects(bool inEnglish) const;
 	virtual QStringList listAllObjectsByType(const QString& objType, bool inEnglish) const;
 	virtual QString getName() const { return "Solar System"; }
@@ -680,6 +685,17 @@ public slots:
 	//! Reset and recreate trails
 	void recreateTrails();
 
+	//! Write an ephemeris of solar system bodies to a file, see BatchEphemeris for the columns and formats.
+	//! The ephemeris is computed in parallel and streamed to the file, so it may be much longer than the AstroCalc tables.
+	//! @param fileName the output file
+	//! @param objects English names of the bodies, e.g. ["Mars", "Jupiter"]
+	//! @param startJD first date (JD, UT)
+	//! @param stopJD last date (JD, UT)
+	//! @param stepMinutes time step in minutes
+	//! @param format "csv" or "binary". By default CSV is written for file names ending in .csv and binary otherwise.
+	//! @return a map with the number of rows written ("rows"), or an error message ("error") if the export failed
+	QVariantMap exportEphemeris(const QString& fileName, const QStringList& objects, double startJD, double stopJD, double stepMinutes=60., const QString& format="");
+
 signals:
 	void labelsDisplayedChanged(bool b);
 	void nomenclatureDisplayedChanged(bool b);
@@ -819,6 +835,68 @@ public:
 	//! Get lighttime corrected solar position (essential to draw the sun during solar eclipse and compute things like eclipse factor etc, until we get aberration working.)
 	const Vec3d getLightTimeSunPosition() const { return lightTimeSunPosition; }
 
+	//! @class PositionEvaluator
+	//! Computes positions of solar system bodies at arbitrary dates without changing the state of the Planet objects or of StelCore.
+	//! Searches over long time spans (e.g. the phenomena in AstroCalc) would otherwise have to call StelCore::setJD() and
+	//! StelCore::update() for every sample and recompute the whole solar system each time.
+	//! Only the requested bodies, their parents and the home planet of the observer are evaluated. Light time correction
+	//! and the topocentric offset of the observer follow computePositions() and StelCore::updateTransformMatrices().
+	//! The evaluator uses its own ephemeris caches, so one instance should be used per search. It must not be shared between threads,
+	//! but copies made on the main thread may be handed to other threads.
+	//! @note Objects outside the solar system are taken at their position for the current date of the core.
+	class PositionEvaluator
+	{
+	public:
+		//! Set up an evaluator for the current observer and the current settings of the core.
+		PositionEvaluator(const SolarSystem* solarSystem, StelCore* core);
+		//! Copy the settings of another evaluator. The copy gets its own ephemeris caches.
+		PositionEvaluator(const PositionEvaluator& other);
+		~PositionEvaluator();
+
+		//! Convert a Julian Day (UT) into JDE with the current DeltaT algorithm of the core.
+		double getJDE(double JD) const;
+
+		//! Get the geometric heliocentric ecliptical (VSOP87) position of a planet at JDE, in AU.
+		Vec3d getGeometricHeliocentricEclipticPos(const Planet* planet, double JDE);
+		//! Get the heliocentric ecliptical position of a planet at JDE as seen by the observer, i.e. with light time correction
+		//! when enabled. This matches Planet::getHeliocentricEclipticPos() after computePositions() for that date.
+		Vec3d getHeliocentricEclipticPos(const Planet* planet, double JDE);
+		//! Get the heliocentric ecliptical position of the observer at JDE, including the topocentric offset when enabled.
+		Vec3d getObserverHeliocentricEclipticPos(double JDE);
+		//! Get the position of an object in J2000 equatorial coordinates relative to the observer at JDE.
+		//! This matches StelObject::getJ2000EquatorialPos() after setting the core to that date.
+		Vec3d getJ2000EquatorialPos(const StelObject* object, double JDE);
+
+		//! Compute the light time corrected heliocentric position of planet at JDE for an observer at observerCenter
+		//! in the same way as computePositions(): the parents are corrected first, the light time of a body is taken from
+		//! its distance with its corrected parent, and like in Planet::computePosition() corrections up to Planet::deltaJDE are skipped.
+		//! @note computePositions() may also keep a position from a previous call while the date moved by no more than
+		//! deltaJDE, and deltaJDE of minor bodies depends on their distance at the last draw. The evaluator starts from
+		//! the geometric position at JDE instead, so it can differ from the drawn position by the motion of a body within deltaJDE.
+		static Vec3d computeLightTimeCorrectedPos(const Planet* planet, double JDE, const Vec3d& observerCenter, EphemerisContext* context);
+
+	private:
+		PositionEvaluator& operator=(const PositionEvaluator&);
+		//! Compute the observer position for JDE unless it is still cached.
+		void updateObserver(double JDE);
+
+		StelCore* core;
+		EphemerisContext* context;
+		bool useDe430;
+		bool useDe431;
+		PlanetP sun;
+		PlanetP homePlanet;
+		bool lightTravelTime;
+		bool topocentric;
+		double longitude;         // degrees
+		double latitude;          // degrees
+		Vec3d topocentricOffset;  // observer offset from the planet center in the altazimuthal frame [AU]
+		double observerJDE;
+		Vec3d observerCenterPos;  // geometric heliocentric position of the home planet at observerJDE
+		Vec3d observerPos;        // observerCenterPos plus topocentric offset
+		Vec3d lightTimeSunPos;    // apparent position of the sun, see getLightTimeSunPosition()
+	};
+
 private slots:
 	//! Called when a new object is selected.
 	void selectedObjectChange(StelModule::StelModuleSelectAction action);
@@ -966,6 +1044,12 @@ private:
 	//! List of all the minor bodies of the solar system.
 	QList<PlanetP> systemMinorBodies;
 
+	//! The names of all bodies for listMatchingObjects(), in English and translated.
+	//! Rebuilt on the next search once nameIndexDirty is set.
+	mutable StelObjectNameIndex nameIndex;
+	mutable StelObjectNameIndex nameIndexI18n;
+	mutable bool nameIndexDirty;
+
 	// Master settings
 	bool flagOrbits;
 	bool flagLightTravelTime;
@@ -26,7 +26,9 @@
 #include "StelModuleMgr.hpp"
 #include "StelPainter.hpp"
 #include "StelTextureMgr.hpp"
+#include "StelUtils.hpp"
 
+#include <QDateTime>
 #include <QSettings>
 
 SporadicMeteorMgr::SporadicMeteorMgr(int zhr, int maxv)
@@ -36,12 +38,17 @@ SporadicMeteorMgr::SporadicMeteorMgr(int zhr, int maxv)
 	, m_flagForcedShow(false)
 {
 	setObjectName("SporadicMeteorMgr");
+
+	typedef MeteorParticles::ColorPair ColorPair;
+	m_palettes[0] = m_meteors.addPalette({ColorPair("white", 100)});
+	m_palettes[1] = m_meteors.addPalette({ColorPair("white", 80), ColorPair("orangeYellow", 20)});
+	m_palettes[2] = m_meteors.addPalette({ColorPair("white", 80), ColorPair("violet", 20)});
+	m_palettes[3] = m_meteors.addPalette({ColorPair("white", 70), ColorPair("orangeYellow", 10),
+					      ColorPair("yellow", 10), ColorPair("blueGreen", 10)});
 }
 
 SporadicMeteorMgr::~SporadicMeteorMgr()
 {
-	qDeleteAll(activeMeteors);
-	activeMeteors.clear();
 	m_bolideTexture.clear();
 }
 
@@ -54,6 +61,7 @@ void SporadicMeteorMgr::init()
 	QSettings* conf = StelApp::getInstance().getSettings();
 	setZHR(conf->value("astro/meteor_zhr", 10).toInt());
 	setFlagForcedMeteorsActivity(conf->value("astro/flag_forced_meteor_activity", false).toBool());
+	setRandomSeed(conf->value("astro/meteor_random_seed", 0).toInt());
 }
 
 double SporadicMeteorMgr::getCallOrder(StelModuleActionName actionName) const
@@ -72,19 +80,11 @@ void SporadicMeteorMgr::update(double deltaTime)
 		return;
 	}
 
-	// step through and update all active meteors
-	foreach (SporadicMeteor* m, activeMeteors)
-	{
-		if (!m->update(deltaTime))
-		{
-			//important to delete when no longer active
-			activeMeteors.removeOne(m);
-			delete m;
-		}
-	}
-
 	StelCore* core = StelApp::getInstance().getCore();
 
+	// update all active meteors
+	m_meteors.update(deltaTime, core->getRealTimeSpeed());
+
 	// going forward/backward OR current ZHR is zero ?
 	// don't create new meteors
 	if(!core->getRealTimeSpeed() || m_zhr < 1)
@@ -92,29 +92,28 @@ void SporadicMeteorMgr::update(double deltaTime)
 		return;
 	}
 
-	// average meteors per frame
-	float mpf = m_zhr * static_cast<float>(deltaTime) / 3600.f;
+	const int n = m_meteors.getNrOfSpawns(static_cast<float>(m_zhr), deltaTime);
+	if (n > 0)
+	{
+		m_meteors.updateBrightness(core->getSkyDrawer());
+	}
+	for (int i = 0; i < n; ++i)
+	{
+		// meteor velocity
+		// (see line 460 in StelApp.cpp)
+		const float speed = 11 + (m_maxVelocity - 11) * m_meteors.random(); // [11, maxVel]
 
-	// maximum amount of meteors for the current frame
-	int maxMpf = qRound(mpf);
-	maxMpf = maxMpf < 1 ? 1 : maxMpf;
+		// select a random radiant in a visible area
+		const float rAlt = M_PI_2f * m_meteors.random(); // [0, pi/2]
+		const float rAz = 2 * M_PIf * m_meteors.random(); // [0, 2pi]
+		Vec3d radiant;
+		StelUtils::spheToRect(rAz, rAlt, radiant);
 
-	float rate = mpf / static_cast<float>(maxMpf);
-	for (int i = 0; i < maxMpf; ++i)
-	{
-		float prob = static_cast<float>(qrand()) / static_cast<float>(RAND_MAX);
-		if (prob < rate)
-		{
-			SporadicMeteor* m = new SporadicMeteor(core, m_maxVelocity, m_bolideTexture);
-			if (m->isAlive())
-			{
-				activeMeteors.append(m);
-			}
-			else
-			{
-				delete m;
-			}
-		}
+		// select a random color
+		const float prob = m_meteors.random();
+		const int palette = prob > 0.9f ? m_palettes[3] : prob > 0.85f ? m_palettes[2] : prob > 0.8f ? m_palettes[1] : m_palettes[0];
+
+		m_meteors.spawn(radiant, speed, palette);
 	}
 }
 
@@ -131,12 +130,9 @@ void SporadicMeteorMgr::draw(StelCore* core)
 		return;
 	}
 
-	// step through and draw all active meteors
+	// draw all active meteors at once
 	StelPainter sPainter(core->getProjection(StelCore::FrameAltAz));
-	for (auto* m: activeMeteors)
-	{
-		m->draw(core, sPainter);
-	}
+	m_meteors.draw(core, sPainter, m_bolideTexture);
 }
 
 void SporadicMeteorMgr::setZHR(int zhr)
@@ -147,3 +143,8 @@ void SporadicMeteorMgr::setZHR(int zhr)
 		emit zhrChanged(zhr);
 	}
 }
+
+void SporadicMeteorMgr::setRandomSeed(int seed)
+{
+	m_meteors.setSeed(seed ? static_cast<quint64>(seed) : static_cast<quint64>(QDateTime::currentMSecsSinceEpoch()));
+}
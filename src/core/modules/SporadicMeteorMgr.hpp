@@ -20,7 +20,7 @@
 #ifndef SPORADICMETEORMGR_HPP
 #define SPORADICMETEORMGR_HPP
 
-#include "SporadicMeteor.hpp"
+#include "MeteorParticles.hpp"
 #include "StelModule.hpp"
 
 //! @class SporadicMeteorMgr
@@ -58,6 +58,10 @@ public slots:
 	//! Set the maximum velocity in km/s
 	void setMaxVelocity(int maxv) { m_maxVelocity = maxv; }
 
+	//! Restart the random generation of the meteors, so that the same seed gives the same meteors.
+	//! @param seed the seed, or 0 to use the current time.
+	void setRandomSeed(int seed);
+
 	//! Set flag for enable activity of meteors when atmosphere is disabled.
 	//! @note option for planetariums
 	void setFlagForcedMeteorsActivity(bool b) {if(b!=m_flagForcedShow ){ m_flagForcedShow=b;}}
@@ -69,7 +73,9 @@ signals:
 	void zhrChanged(int);
 
 private:
-	QList<SporadicMeteor*> activeMeteors;
+	MeteorParticles m_meteors;
+	//! Palettes of the meteors with a random color
+	int m_palettes[4];
 	StelTextureSP m_bolideTexture;
 	int m_zhr;
 	int m_maxVelocity;
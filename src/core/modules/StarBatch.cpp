@@ -0,0 +1,138 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StarBatch.hpp"
+#include "StelProjector.hpp"
+
+#include <cmath>
+
+// Pick the widest instruction set the compiler targets. There is no runtime dispatch:
+// SSE2 is always there on x86_64 and NEON on aarch64, AVX needs e.g. -mavx.
+#if defined(__AVX__)
+	#include <immintrin.h>
+	#define STARBATCH_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define STARBATCH_SSE
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	#include <arm_neon.h>
+	#define STARBATCH_NEON
+#endif
+
+void StarBatch::resize(int n)
+{
+	count = n;
+	// Only grow, so that reusing the batch for the next zone doesn't allocate
+	if (x0.size() < n)
+	{
+		for (auto* v : {&x0, &x1, &dx0, &dx1, &x, &y, &z, &winX, &winY, &winZ})
+			v->resize(n);
+		valid.resize(n);
+	}
+}
+
+void StarBatch::computePositions(const ZoneData* zone, float movementFactor)
+{
+	const float* px0 = x0.constData();
+	const float* px1 = x1.constData();
+	const float* pdx0 = dx0.constData();
+	const float* pdx1 = dx1.constData();
+	float* px = x.data();
+	float* py = y.data();
+	float* pz = z.data();
+	const Vec3f& c = zone->center;
+	const Vec3f& a0 = zone->axis0;
+	const Vec3f& a1 = zone->axis1;
+
+	int i = 0;
+#if defined(STARBATCH_AVX)
+	const __m256 m = _mm256_set1_ps(movementFactor);
+	const __m256 cx = _mm256_set1_ps(c[0]), cy = _mm256_set1_ps(c[1]), cz = _mm256_set1_ps(c[2]);
+	const __m256 a0x = _mm256_set1_ps(a0[0]), a0y = _mm256_set1_ps(a0[1]), a0z = _mm256_set1_ps(a0[2]);
+	const __m256 a1x = _mm256_set1_ps(a1[0]), a1y = _mm256_set1_ps(a1[1]), a1z = _mm256_set1_ps(a1[2]);
+	for (; i+8<=count; i+=8)
+	{
+		const __m256 u = _mm256_add_ps(_mm256_loadu_ps(px0+i), _mm256_mul_ps(m, _mm256_loadu_ps(pdx0+i)));
+		const __m256 v = _mm256_add_ps(_mm256_loadu_ps(px1+i), _mm256_mul_ps(m, _mm256_loadu_ps(pdx1+i)));
+		const __m256 vx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a0x, u), _mm256_mul_ps(a1x, v)), cx);
+		const __m256 vy = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a0y, u), _mm256_mul_ps(a1y, v)), cy);
+		const __m256 vz = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a0z, u), _mm256_mul_ps(a1z, v)), cz);
+		const __m256 l = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)), _mm256_mul_ps(vz, vz)));
+		_mm256_storeu_ps(px+i, _mm256_div_ps(vx, l));
+		_mm256_storeu_ps(py+i, _mm256_div_ps(vy, l));
+		_mm256_storeu_ps(pz+i, _mm256_div_ps(vz, l));
+	}
+#elif defined(STARBATCH_SSE)
+	const __m128 m = _mm_set1_ps(movementFactor);
+	const __m128 cx = _mm_set1_ps(c[0]), cy = _mm_set1_ps(c[1]), cz = _mm_set1_ps(c[2]);
+	const __m128 a0x = _mm_set1_ps(a0[0]), a0y = _mm_set1_ps(a0[1]), a0z = _mm_set1_ps(a0[2]);
+	const __m128 a1x = _mm_set1_ps(a1[0]), a1y = _mm_set1_ps(a1[1]), a1z = _mm_set1_ps(a1[2]);
+	for (; i+4<=count; i+=4)
+	{
+		const __m128 u = _mm_add_ps(_mm_loadu_ps(px0+i), _mm_mul_ps(m, _mm_loadu_ps(pdx0+i)));
+		const __m128 v = _mm_add_ps(_mm_loadu_ps(px1+i), _mm_mul_ps(m, _mm_loadu_ps(pdx1+i)));
+		const __m128 vx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0x, u), _mm_mul_ps(a1x, v)), cx);
+		const __m128 vy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0y, u), _mm_mul_ps(a1y, v)), cy);
+		const __m128 vz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0z, u), _mm_mul_ps(a1z, v)), cz);
+		const __m128 l = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+		_mm_storeu_ps(px+i, _mm_div_ps(vx, l));
+		_mm_storeu_ps(py+i, _mm_div_ps(vy, l));
+		_mm_storeu_ps(pz+i, _mm_div_ps(vz, l));
+	}
+#elif defined(STARBATCH_NEON)
+	const float32x4_t m = vdupq_n_f32(movementFactor);
+	const float32x4_t cx = vdupq_n_f32(c[0]), cy = vdupq_n_f32(c[1]), cz = vdupq_n_f32(c[2]);
+	const float32x4_t a0x = vdupq_n_f32(a0[0]), a0y = vdupq_n_f32(a0[1]), a0z = vdupq_n_f32(a0[2]);
+	const float32x4_t a1x = vdupq_n_f32(a1[0]), a1y = vdupq_n_f32(a1[1]), a1z = vdupq_n_f32(a1[2]);
+	for (; i+4<=count; i+=4)
+	{
+		const float32x4_t u = vaddq_f32(vld1q_f32(px0+i), vmulq_f32(m, vld1q_f32(pdx0+i)));
+		const float32x4_t v = vaddq_f32(vld1q_f32(px1+i), vmulq_f32(m, vld1q_f32(pdx1+i)));
+		const float32x4_t vx = vaddq_f32(vaddq_f32(vmulq_f32(a0x, u), vmulq_f32(a1x, v)), cx);
+		const float32x4_t vy = vaddq_f32(vaddq_f32(vmulq_f32(a0y, u), vmulq_f32(a1y, v)), cy);
+		const float32x4_t vz = vaddq_f32(vaddq_f32(vmulq_f32(a0z, u), vmulq_f32(a1z, v)), cz);
+		const float32x4_t l = vsqrtq_f32(vaddq_f32(vaddq_f32(vmulq_f32(vx, vx), vmulq_f32(vy, vy)), vmulq_f32(vz, vz)));
+		vst1q_f32(px+i, vdivq_f32(vx, l));
+		vst1q_f32(py+i, vdivq_f32(vy, l));
+		vst1q_f32(pz+i, vdivq_f32(vz, l));
+	}
+#endif
+	// Scalar fallback, and remaining stars
+	for (; i<count; ++i)
+	{
+		const float u = px0[i] + movementFactor*pdx0[i];
+		const float v = px1[i] + movementFactor*pdx1[i];
+		const float vx = (a0[0]*u + a1[0]*v) + c[0];
+		const float vy = (a0[1]*u + a1[1]*v) + c[1];
+		const float vz = (a0[2]*u + a1[2]*v) + c[2];
+		const float l = std::sqrt(vx*vx + vy*vy + vz*vz);
+		px[i] = vx/l;
+		py[i] = vy/l;
+		pz[i] = vz/l;
+	}
+}
+
+void StarBatch::project(const StelProjector* prj)
+{
+	const size_t n = sizeof(float)*static_cast<size_t>(count);
+	std::memcpy(winX.data(), x.constData(), n);
+	std::memcpy(winY.data(), y.constData(), n);
+	std::memcpy(winZ.data(), z.constData(), n);
+	prj->project(count, winX.data(), winY.data(), winZ.data(), valid.data());
+}
@@ -0,0 +1,107 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef STARBATCH_HPP
+#define STARBATCH_HPP
+
+#include "ZoneData.hpp"
+#include "Star.hpp"
+
+#include <QVector>
+#include <cstring>
+
+class StelProjector;
+
+//! @class StarBatch
+//! The positions of a run of stars of one zone, stored as structure of arrays.
+//! Instead of calling Star::getJ2000Pos() and StelProjector::project() star by star,
+//! the stars of a zone are processed in three passes over plain float arrays:
+//! - decode() unpacks the positions and proper motions from the Star1/Star2/Star3 records,
+//! - computePositions() computes the normalized J2000 directions, using SSE/AVX or NEON when available,
+//! - project() runs the batch projection of the StelProjector.
+//! A StarBatch is meant to be reused from zone to zone to avoid allocations.
+class StarBatch
+{
+public:
+	StarBatch() : count(0) {}
+
+	//! Decode the packed positions of the first n stars of a zone.
+	template<class Star> void decode(const SpecialZoneData<Star>* zone, int n);
+
+	//! Compute the normalized J2000 directions x, y, z of the decoded stars.
+	//! @param zone the zone the stars were decoded from
+	//! @param movementFactor the proper motion factor, as for Star1::getJ2000Pos()
+	void computePositions(const ZoneData* zone, float movementFactor);
+
+	//! Project the J2000 directions into winX, winY, winZ and set the valid flags.
+	void project(const StelProjector* prj);
+
+	//! Get the number of stars in the batch.
+	int size() const {return count;}
+
+	//! Positions in the zone frame and proper motions, as decoded from the star records
+	QVector<float> x0, x1, dx0, dx1;
+	//! Normalized J2000 directions
+	QVector<float> x, y, z;
+	//! Window coordinates, as computed by project()
+	QVector<float> winX, winY, winZ;
+	//! Whether the projection of each star is valid
+	QVector<quint8> valid;
+
+private:
+	void resize(int n);
+	int count;
+};
+
+template<class Star>
+void StarBatch::decode(const SpecialZoneData<Star>* zone, int n)
+{
+	resize(n);
+	const Star* s = zone->getStars();
+	float* px0 = x0.data();
+	float* px1 = x1.data();
+	float* pdx0 = dx0.data();
+	float* pdx1 = dx1.data();
+	for (int i=0; i<n; ++i, ++s)
+	{
+		px0[i] = static_cast<float>(s->getX0());
+		px1[i] = static_cast<float>(s->getX1());
+		pdx0[i] = static_cast<float>(s->getDx0());
+		pdx1[i] = static_cast<float>(s->getDx1());
+	}
+}
+
+//! Star3 has no proper motion.
+template<>
+inline void StarBatch::decode<Star3>(const SpecialZoneData<Star3>* zone, int n)
+{
+	resize(n);
+	const Star3* s = zone->getStars();
+	float* px0 = x0.data();
+	float* px1 = x1.data();
+	for (int i=0; i<n; ++i, ++s)
+	{
+		px0[i] = static_cast<float>(s->getX0());
+		px1[i] = static_cast<float>(s->getX1());
+	}
+	std::memset(dx0.data(), 0, sizeof(float)*static_cast<size_t>(n));
+	std::memset(dx1.data(), 0, sizeof(float)*static_cast<size_t>(n));
+}
+
+#endif // STARBATCH_HPP
@@ -39,8 +39,10 @@
 #include "StelCore.hpp"
 #include "StelIniParser.hpp"
 #include "StelPainter.hpp"
+#include "StelProfiler.hpp"
 #include "StelJsonParser.hpp"
 #include "ZoneArray.hpp"
+#include "StarZoneBuffers.hpp"
 #include "StelSkyDrawer.hpp"
 #include "RefractionExtinction.hpp"
 #include "StelModuleMgr.hpp"
@@ -55,6 +57,9 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QCryptographicHash>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
 
 #include <cstdlib>
 
@@ -78,6 +83,10 @@ QMap<QString,int> StarMgr::commonNamesIndexI18n;
 QMap<QString,int> StarMgr::commonNamesIndex;
 QMap<QString,int> StarMgr::additionalNamesIndex;
 QMap<QString,int> StarMgr::additionalNamesIndexI18n;
+StelObjectNameIndex StarMgr::commonNamesSearchIndex;
+StelObjectNameIndex StarMgr::commonNamesSearchIndexI18n;
+StelObjectNameIndex StarMgr::additionalNamesSearchIndex;
+StelObjectNameIndex StarMgr::additionalNamesSearchIndexI18n;
 QHash<int,QString> StarMgr::sciNamesMapI18n;
 QMap<QString,int> StarMgr::sciNamesIndexI18n;
 QHash<int,QString> StarMgr::sciAdditionalNamesMapI18n;
@@ -146,7 +155,16 @@ StarMgr::StarMgr(void)
 	, gravityLabel(false)
 	, maxGeodesicGridLevel(-1)
 	, lastMaxSearchLevel(-1)
+	, dataLoaded(false)
 	, hipIndex(new HipIndexStruct[NR_OF_HIP+1])
+	, drawThreadPool(new QThreadPool(this))
+	, drawThreadCount(0)
+	, drawSearchResult(Q_NULLPTR)
+	, drawSearchGrid(Q_NULLPTR)
+	, drawSearchGridLevel(-1)
+	, zoneBuffers(new StarZoneBuffers())
+	, zoneBuffersSearchLevel(-1)
+	, flagZoneBuffers(false)
 {
 	setObjectName("StarMgr");
 	objectMgr = GETSTELMODULE(StelObjectMgr);
@@ -171,6 +189,8 @@ StarMgr::~StarMgr(void)
 	gridLevels.clear();
 	if (hipIndex)
 		delete[] hipIndex;
+	delete drawSearchResult;
+	delete zoneBuffers;
 }
 
 // Allow untranslated name here if set in constellationMgr!
@@ -407,10 +427,10 @@ void StarMgr::copyDefaultConfigFile()
 	}
 }
 
-void StarMgr::init()
+void StarMgr::loadModuleData()
 {
-	QSettings* conf = StelApp::getInstance().getSettings();
-	Q_ASSERT(conf);
+	if (dataLoaded)
+		return;
 
 	starConfigFileFullPath = StelFileMgr::findFile("stars/default/starsConfig.json", StelFileMgr::Flags(StelFileMgr::Writable|StelFileMgr::File));
 	if (starConfigFileFullPath.isEmpty())
@@ -443,6 +463,17 @@ void StarMgr::init()
 	loadData(starSettings);
 
 	populateStarsDesignations();
+	dataLoaded = true;
+}
+
+void StarMgr::init()
+{
+	QSettings* conf = StelApp::getInstance().getSettings();
+	Q_ASSERT(conf);
+
+	// Normally already done on a worker thread by StelApp
+	loadModuleData();
+
 	populateHipparcosLists();
 
 	setFontSize(StelApp::getInstance().getScreenFontSize());
@@ -453,6 +484,10 @@ void StarMgr::init()
 	setFlagAdditionalNames(conf->value("astro/flag_star_additional_names",true).toBool());
 	setDesignationUsage(conf->value("astro/flag_star_designation_usage", false).toBool());
 	setLabelsAmount(conf->value("stars/labels_amount",3.).toDouble());
+	setDrawThreadCount(conf->value("stars/draw_threads", 0).toInt());
+	zoneBuffers->setMemoryLimit(conf->value("stars/zone_buffers_memory_mb", 128).toInt());
+	zoneBuffers->setEpochBucketYears(conf->value("stars/zone_buffers_epoch_years", 1.0).toDouble());
+	setFlagZoneBuffers(conf->value("stars/flag_zone_buffers", false).toBool());
 
 	objectMgr->registerStelObjectMgr(this);
 	texPointer = StelApp::getInstance().getTextureManager().createTexture(StelFileMgr::getInstallationDir()+"/textures/pointeur2.png");   // Load pointer texture
@@ -1180,49 +1215,117 @@ int StarMgr::getMaxSearchLevel() const
 }
 
 
-// Draw all the stars
-void StarMgr::draw(StelCore* core)
+void StarMgr::setDrawThreadCount(int n)
 {
-	const StelProjectorP prj = core->getProjection(StelCore::FrameJ2000);
-	StelSkyDrawer* skyDrawer = core->getSkyDrawer();
-	// If stars are turned off don't waste time below
-	// projecting all stars just to draw disembodied labels
-	if (!starsFader.getInterstate())
-		return;
-
-	int maxSearchLevel = getMaxSearchLevel();
-	QVector<SphericalCap> viewportCaps = prj->getViewportConvexPolygon()->getBoundingSphericalCaps();
-	viewportCaps.append(core->getVisibleSkyArea());
-	const GeodesicSearchResult* geodesic_search_result = core->getGeodesicGrid(maxSearchLevel)->search(viewportCaps,maxSearchLevel);
+	n = qMax(0, n);
+	if (n!=drawThreadCount)
+	{
+		drawThreadCount = n;
+		emit drawThreadCountChanged(n);
+	}
+	// The main thread works too, the pool only provides the additional workers
+	drawThreadPool->setMaxThreadCount(qMax(1, getEffectiveDrawThreadCount()-1));
+}
 
-	// Set temporary static variable for optimization
-	const float names_brightness = labelsFader.getInterstate() * starsFader.getInterstate();
+void StarMgr::setFlagZoneBuffers(bool b)
+{
+	if (b!=flagZoneBuffers)
+	{
+		// The buffers are released in draw(), where the OpenGL context is current
+		flagZoneBuffers = b;
+		emit flagZoneBuffersChanged(b);
+	}
+}
 
-	// Prepare openGL for drawing many stars
-	StelPainter sPainter(prj);
-	sPainter.setFont(starFont);
-	skyDrawer->preDrawPointSource(&sPainter);
+int StarMgr::getEffectiveDrawThreadCount() const
+{
+	return drawThreadCount>0 ? drawThreadCount : qMax(1, QThread::idealThreadCount());
+}
 
-	// Prepare a table for storing precomputed RCMag for all ZoneArrays
-	RCMag rcmag_table[RCMAG_TABLE_SIZE];
-	
-	// Draw all the stars of all the selected zones
+void StarMgr::updateZoneBuffersInView(int maxSearchLevel)
+{
+	// The changes of the search result only tell which zones entered or left the view since the previous
+	// frame with the same search levels: after any other frame, all zones in the view are given again.
+	const bool changesOnly = zoneBuffersSearchLevel>=0 && zoneBuffersSearchLevel==maxSearchLevel;
+	if (!changesOnly)
+		zoneBuffers->setAllOutOfView();
+	QVector<int> entered, left;
 	for (const auto* z : gridLevels)
 	{
+		if (z->level>maxSearchLevel)
+			break;
+		if (z->hasStarNames())
+			continue;
+		if (changesOnly)
+			drawSearchResult->getZoneChanges(z->level, entered, left);
+		else
+		{
+			entered.clear();
+			left.clear();
+			int zone;
+			for (GeodesicSearchInsideIterator it(*drawSearchResult,z->level);(zone = it.next()) >= 0;)
+				entered.append(zone);
+			for (GeodesicSearchBorderIterator it(*drawSearchResult,z->level);(zone = it.next()) >= 0;)
+				entered.append(zone);
+		}
+		zoneBuffers->updateZonesInView(z, entered, left);
+	}
+	zoneBuffersSearchLevel = maxSearchLevel;
+}
+
+void StarMgr::prepareDraw(StelCore* core, const StelProjector* prj, const QVector<SphericalCap>& viewportCaps, int nThreads,
+			  bool useZoneBuffers)
+{
+	const StelSkyDrawer* skyDrawer = core->getSkyDrawer();
+	const int maxSearchLevel = getMaxSearchLevel();
+	// The zones are updated from those of the previous frame, which differ little while panning or zooming
+	const StelGeodesicGrid* grid = core->getGeodesicGrid(maxSearchLevel);
+	if (!drawSearchResult || drawSearchGrid!=grid || drawSearchGridLevel!=grid->getMaxLevel())
+	{
+		delete drawSearchResult;
+		drawSearchResult = new GeodesicSearchResult(*grid);
+		drawSearchGrid = grid;
+		drawSearchGridLevel = grid->getMaxLevel();
+		zoneBuffersSearchLevel = -1;
+	}
+	drawSearchResult->update(viewportCaps,maxSearchLevel);
+	const GeodesicSearchResult* geodesic_search_result = drawSearchResult;
+
+	if (useZoneBuffers)
+	{
+		zoneBuffers->beginFrame(core->getJDE());
+		updateZoneBuffersInView(maxSearchLevel);
+	}
+	else
+		zoneBuffersSearchLevel = -1;
+
+	// Prepare the tables of precomputed RCMag for all ZoneArrays, and collect the zones to draw
+	rcmagTables.resize(gridLevels.size()*RCMAG_TABLE_SIZE);
+	drawLimits.resize(gridLevels.size());
+	drawJobs.clear();
+	bufferDrawJobs.clear();
+	for (int l=0; l<gridLevels.size(); ++l)
+	{
+		const ZoneArray* z = gridLevels.at(l);
+		RCMag* rcmag_table = rcmagTables.data()+l*RCMAG_TABLE_SIZE;
 		int limitMagIndex=RCMAG_TABLE_SIZE;
 		const float mag_min = 0.001f*z->mag_min;
 		const float k = (0.001f*z->mag_range)/z->mag_steps; // MagStepIncrement
+		bool levelVisible = true;
 		for (int i=0;i<RCMAG_TABLE_SIZE;++i)
 		{
 			const float mag = mag_min+k*i;
 			if (skyDrawer->computeRCMag(mag, &rcmag_table[i])==false)
 			{
 				if (i==0)
-					goto exit_loop;
-				
+				{
+					levelVisible = false;
+					break;
+				}
+
 				// The last magnitude at which the star is visible
 				limitMagIndex = i-1;
-				
+
 				// We reached the point where stars are not visible anymore
 				// Fill the rest of the table with zero and leave.
 				for (;i<RCMAG_TABLE_SIZE;++i)
@@ -1234,6 +1337,9 @@ void StarMgr::draw(StelCore* core)
 			}
 			rcmag_table[i].radius *= starsFader.getInterstate();
 		}
+		// Deeper levels only contain fainter stars
+		if (!levelVisible)
+			break;
 		lastMaxSearchLevel = z->level;
 
 		int maxMagStarName = 0;
@@ -1245,23 +1351,144 @@ void StarMgr::draw(StelCore* core)
 			if (x > 0)
 				maxMagStarName = x;
 		}
+		drawLimits[l].limitMagIndex = limitMagIndex;
+		drawLimits[l].maxMagStarName = maxMagStarName;
+
+		// The stars of the zones in OpenGL buffers only need to be counted. The labels are only
+		// drawn from the CPU, so are the zones which could not be uploaded yet.
+		const bool levelBuffers = useZoneBuffers && !z->hasStarNames();
+		const int cutoffMagStep = levelBuffers ? z->getCutoffMagStep(skyDrawer, limitMagIndex) : 0;
+		auto addJob = [&](int zone, bool isInside)
+		{
+			if (levelBuffers)
+			{
+				const int nbStars = z->getNrOfStarsToDraw(zone, cutoffMagStep);
+				if (nbStars==0)
+					return;
+				QOpenGLBuffer* buffer = zoneBuffers->getBuffer(z, zone);
+				if (buffer)
+				{
+					bufferDrawJobs.append({l, buffer, nbStars, cutoffMagStep});
+					return;
+				}
+			}
+			drawJobs.append({l, zone, isInside});
+		};
 		int zone;
-		
 		for (GeodesicSearchInsideIterator it1(*geodesic_search_result,z->level);(zone = it1.next()) >= 0;)
-			z->draw(&sPainter, zone, true, rcmag_table, limitMagIndex, core, maxMagStarName, names_brightness, flagDesignations, viewportCaps);
+			addJob(zone, true);
 		for (GeodesicSearchBorderIterator it1(*geodesic_search_result,z->level);(zone = it1.next()) >= 0;)
-			z->draw(&sPainter, zone, false, rcmag_table, limitMagIndex, core, maxMagStarName,names_brightness, flagDesignations, viewportCaps);
+			addJob(zone, false);
+	}
+	if (useZoneBuffers)
+		zoneBuffers->endFrame();
+
+	nThreads = qBound(1, nThreads, qMax(1, drawJobs.size()));
+	drawBatches.resize(nThreads);
+	for (auto& batch : drawBatches)
+		batch.clear();
+
+	// Only const data is accessed from here on, and nothing is drawn.
+	const ZoneDrawJob* jobs = drawJobs.constData();
+	const LevelDrawLimits* limits = drawLimits.constData();
+	const RCMag* tables = rcmagTables.constData();
+	const bool designationUsage = flagDesignations;
+	runDrawJobs(drawThreadPool, nThreads, drawJobs.size(), drawBatches.data(), static_cast<quint32>(qrand()),
+		    [&](StarDrawBatch& batch, int j)
+	{
+		const ZoneDrawJob& job = jobs[j];
+		const LevelDrawLimits& lim = limits[job.level];
+		gridLevels.at(job.level)->draw(batch, prj, job.zone, job.isInside, tables+job.level*RCMAG_TABLE_SIZE,
+					       lim.limitMagIndex, core, lim.maxMagStarName, designationUsage, viewportCaps);
+	});
+}
+
+void StarMgr::runDrawJobs(QThreadPool* pool, int nThreads, int nbJobs, StarDrawBatch* batches, quint32 twinkleSeed,
+			  const std::function<void(StarDrawBatch&, int)>& drawJob)
+{
+	// Each worker takes the next job until there are none left, and fills its own batch.
+	QAtomicInt nextJob(0);
+	auto worker = [&](int t)
+	{
+		StarDrawBatch& batch = batches[t];
+		int j;
+		while ((j = nextJob.fetchAndAddRelaxed(1)) < nbJobs)
+		{
+			// The twinkling of a zone only depends on the frame and the zone, not on the worker
+			batch.pointSources.seedTwinkle(twinkleSeed ^ (static_cast<quint32>(j+1)*2654435761u));
+			drawJob(batch, j);
+		}
+	};
+
+	QVector<QFuture<void>> futures;
+	for (int t=1; t<nThreads; ++t)
+		futures.append(QtConcurrent::run(pool, [&worker, t]() { worker(t); }));
+	worker(0);
+	for (auto& future : futures)
+		future.waitForFinished();
+}
+
+// Draw all the stars
+void StarMgr::draw(StelCore* core)
+{
+	const StelProjectorP prj = core->getProjection(StelCore::FrameJ2000);
+	StelSkyDrawer* skyDrawer = core->getSkyDrawer();
+	// If stars are turned off don't waste time below
+	// projecting all stars just to draw disembodied labels
+	if (!starsFader.getInterstate())
+		return;
+
+	QVector<SphericalCap> viewportCaps = prj->getViewportConvexPolygon()->getBoundingSphericalCaps();
+	viewportCaps.append(core->getVisibleSkyArea());
+
+	const bool useZoneBuffers = flagZoneBuffers && skyDrawer->canDrawPointSourceBuffers(prj.data(), viewportCaps);
+	if (!flagZoneBuffers && zoneBuffers->getNrOfBuffers()>0)
+		zoneBuffers->clear();
+
+	// Compute the halos and labels of all the stars of the selected zones
+	{
+		StelProfiler::Scope profileScope("StarMgr::prepareDraw");
+		prepareDraw(core, prj.data(), viewportCaps, getEffectiveDrawThreadCount(), useZoneBuffers);
 	}
-	exit_loop:
+
+	// Set temporary static variable for optimization
+	const float names_brightness = labelsFader.getInterstate() * starsFader.getInterstate();
+
+	// Prepare openGL for drawing many stars
+	StelPainter sPainter(prj);
+	sPainter.setFont(starFont);
+	skyDrawer->preDrawPointSource(&sPainter);
+
+	for (const auto& batch : drawBatches)
+		skyDrawer->drawPointSourceBatch(&sPainter, batch.pointSources);
 
 	// Finish drawing many stars
 	skyDrawer->postDrawPointSource(&sPainter);
 
+	if (!bufferDrawJobs.isEmpty())
+	{
+		skyDrawer->preDrawPointSourceBuffers(&sPainter, viewportCaps, starsFader.getInterstate());
+		for (const auto& job : bufferDrawJobs)
+		{
+			const ZoneArray* z = gridLevels.at(job.level);
+			skyDrawer->drawPointSourceBuffer(*job.buffer, job.nbStars, 0.001f*z->mag_min, (0.001f*z->mag_range)/z->mag_steps, job.cutoffMagStep);
+		}
+		skyDrawer->postDrawPointSourceBuffers();
+	}
+
+	for (const auto& batch : drawBatches)
+	{
+		for (const auto& label : batch.labels)
+		{
+			sPainter.setColor(StelSkyDrawer::indexToColor(label.bVIndex)*0.75f, names_brightness);
+			sPainter.drawText(label.pos.toVec3d(), label.text, 0, label.offset, label.offset, false);
+		}
+	}
+
 	if (objectMgr->getFlagSelectedObjectPointer())
 		drawPointer(sPainter, core);
 }
 
-
 // Return a QList containing the stars located
 // inside the limFov circle around position v
 QList<StelObjectP > StarMgr::searchAround(const Vec3d& vv, double limFov, const StelCore* core) const
@@ -1366,6 +1593,29 @@ void StarMgr::updateI18n()
 		const QString r = tn.join(" - ");
 		additionalNamesMapI18n[i] = r;
 	}
+
+	commonNamesSearchIndex.clear();
+	commonNamesSearchIndexI18n.clear();
+	additionalNamesSearchIndex.clear();
+	additionalNamesSearchIndexI18n.clear();
+	for (const auto& name : commonNamesMap)
+		commonNamesSearchIndex.insert(name);
+	for (const auto& name : commonNamesMapI18n)
+		commonNamesSearchIndexI18n.insert(name);
+	for (const auto& names : additionalNamesMap)
+	{
+		for (const auto& name : names.split(" - "))
+			additionalNamesSearchIndex.insert(name);
+	}
+	for (const auto& names : additionalNamesMapI18n)
+	{
+		for (const auto& name : names.split(" - "))
+			additionalNamesSearchIndexI18n.insert(name);
+	}
+	commonNamesSearchIndex.build();
+	commonNamesSearchIndexI18n.build();
+	additionalNamesSearchIndex.build();
+	additionalNamesSearchIndexI18n.build();
 }
 
 // Search the star by HP number
@@ -1507,79 +1757,15 @@ QStringList StarMgr::listMatchingObjects(const QString& objPrefix, int maxNbItem
 
 	QString objw = objPrefix.toUpper();
 
-	QMap<QString, int> cNamesIdx = inEnglish ? commonNamesIndex : commonNamesIndexI18n;
-	QMap<QString, int> aNamesIdx;
-	if (getFlagAdditionalNames())
-		aNamesIdx = inEnglish ? additionalNamesIndex : additionalNamesIndexI18n;
-
 	// Search for common names
-	if (useStartOfWords)
-	{
-		for (auto it = cNamesIdx.lowerBound(objw); it != cNamesIdx.end(); ++it)
-		{
-			if (it.key().startsWith(objw))
-			{
-				if (maxNbItem<=0)
-					break;
-				result.append(inEnglish ? getCommonEnglishName(it.value()) : getCommonName(it.value()));
-				--maxNbItem;
-			}
-			else
-				break;
-		}
-		for (auto ita = aNamesIdx.lowerBound(objw); ita != aNamesIdx.end(); ++ita)
-		{
-			if (ita.key().startsWith(objw))
-			{
-				if (maxNbItem<=0)
-					break;
-				QStringList names = (inEnglish ? getAdditionalEnglishNames(ita.value()) : getAdditionalNames(ita.value())).split(" - ");
-				for (auto name : names)
-				{
-					if (name.contains(objw, Qt::CaseInsensitive))
-					{
-						result.append(name);
-						--maxNbItem;
-					}
-				}
-			}
-			else
-				break;
-		}
-	}
-	else
-	{
-		QMapIterator<QString, int> i(cNamesIdx);
-		while (i.hasNext())
-		{
-			i.next();
-			if (i.key().contains(objw))
-			{
-				if (maxNbItem<=0)
-					break;
-				result.append(inEnglish ? getCommonEnglishName(i.value()) : getCommonName(i.value()));
-				--maxNbItem;
-			}
-		}
-		QMapIterator<QString, int> j(aNamesIdx);
-		while (j.hasNext())
-		{
-			j.next();
-			if (j.key().contains(objw))
-			{
-				if (maxNbItem<=0)
-					break;
-				QStringList names = (inEnglish ? getAdditionalEnglishNames(j.value()) : getAdditionalNames(j.value())).split(" - ");
-				for (auto name : names)
-				{
-					if (name.contains(objw, Qt::CaseInsensitive))
-					{
-						result.append(name);
-						--maxNbItem;
-					}
-				}
-			}
-		}
+	QStringList names = (inEnglish ? commonNamesSearchIndex : commonNamesSearchIndexI18n).find(objw, maxNbItem, useStartOfWords);
+	result << names;
+	maxNbItem -= names.size();
+	if (getFlagAdditionalNames() && maxNbItem>0)
+	{
+		names = (inEnglish ? additionalNamesSearchIndex : additionalNamesSearchIndexI18n).find(objw, maxNbItem, useStartOfWords);
+		result << names;
+		maxNbItem -= names.size();
 	}
 
 	// Search for sci names
@@ -23,22 +23,54 @@
 #include <QFont>
 #include <QVariantMap>
 #include <QVector>
+#include <functional>
 #include "StelFader.hpp"
 #include "StelObjectModule.hpp"
+#include "StelObjectNameIndex.hpp"
 #include "StelTextureTypes.hpp"
 #include "StelProjectorType.hpp"
+#include "StelSkyDrawer.hpp"
+#include "StarBatch.hpp"
 
 class StelObject;
 class StelToneReproducer;
 class StelProjector;
 class StelPainter;
+class SphericalCap;
 class QSettings;
+class QThreadPool;
 
 class ZoneArray;
 struct HipIndexStruct;
+class StelGeodesicGrid;
+class GeodesicSearchResult;
+class StarZoneBuffers;
+class QOpenGLBuffer;
 
 static const int RCMAG_TABLE_SIZE = 4096;
 
+//! @struct StarLabel
+//! Label of a named star, collected while computing the stars of a zone
+//! and drawn afterwards in the main thread.
+struct StarLabel
+{
+	Vec3f pos;		//! J2000 position of the star
+	QString text;		//! Name or designation to display
+	int bVIndex;		//! B-V color index of the star
+	float offset;		//! Offset of the label from the star, pixels
+};
+
+//! @struct StarDrawBatch
+//! Output of one star drawing worker: the halos of the visible stars and the labels to draw.
+struct StarDrawBatch
+{
+	StelSkyDrawer::PointSourceBatch pointSources;
+	QVector<StarLabel> labels;
+	//! Working buffer for the star positions of the zone being computed
+	StarBatch stars;
+	void clear() {pointSources.clear(); labels.clear();}
+};
+
 typedef struct
 {
 	QString designation;	//! GCVS designation
@@ -119,6 +151,16 @@ class StarMgr : public StelObjectModule
 		   WRITE setDesignationUsage
 		   NOTIFY designationUsageChanged
 		   )
+	Q_PROPERTY(int drawThreadCount
+		   READ getDrawThreadCount
+		   WRITE setDrawThreadCount
+		   NOTIFY drawThreadCountChanged
+		   )
+	Q_PROPERTY(bool flagZoneBuffers
+		   READ getFlagZoneBuffers
+		   WRITE setFlagZoneBuffers
+		   NOTIFY flagZoneBuffersChanged
+		   )
 
 public:
 	StarMgr(void);
@@ -135,6 +177,9 @@ public:
 	//! - Sets various display flags from the ini parser object
 	virtual void init();
 
+	//! Load the star catalogs, the designations and the GCVS, WDS, cross-identification and parallax error data.
+	virtual void loadModuleData();
+
 	//! Draw the stars and the star selection indicator if necessary.
 	virtual void draw(StelCore* core);
 
@@ -211,6 +256,20 @@ public slots:
 	void setFlagAdditionalNames(bool flag) { if (flagAdditionalStarNames!=flag){ flagAdditionalStarNames=flag; emit flagAdditionalNamesDisplayedChanged(flag);}}
 	static bool getFlagAdditionalNames(void) { return flagAdditionalStarNames; }
 
+	//! Set the number of threads used to compute the visible stars in draw().
+	//! @param n the number of threads, or 0 to use one thread per CPU core
+	void setDrawThreadCount(int n);
+	//! Get the number of threads used to compute the visible stars in draw() (0 means one per CPU core).
+	int getDrawThreadCount(void) const { return drawThreadCount; }
+
+	//! Set whether the stars of the catalogs without star names are drawn from OpenGL buffers kept from frame to frame.
+	//! The stars of each visible zone are then uploaded once, and the GPU computes their projection, extinction
+	//! and halo, so that draw() doesn't compute anything per star for these catalogs.
+	//! The stars are still drawn from the CPU with the projections and frames the shader doesn't support.
+	void setFlagZoneBuffers(bool b);
+	//! Get whether the stars of the catalogs without star names are drawn from OpenGL buffers.
+	bool getFlagZoneBuffers(void) const { return flagZoneBuffers; }
+
 public:
 	///////////////////////////////////////////////////////////////////////////
 	// Other methods
@@ -220,6 +279,14 @@ public:
 	//! one was not found.
 	StelObjectP searchHP(int hip) const;
 
+	//! Run drawJob(batch, j) for the jobs 0..nbJobs-1, as done by draw() for the visible zones.
+	//! The jobs are shared between nThreads workers: the calling thread and nThreads-1 threads of pool.
+	//! Each worker takes the next job until there are none left, and fills its own batch of batches.
+	//! Before each job, the twinkling of the batch is seeded from twinkleSeed and the job number, so that
+	//! the computed stars are the same whatever the number of threads.
+	static void runDrawJobs(QThreadPool* pool, int nThreads, int nbJobs, StarDrawBatch* batches, quint32 twinkleSeed,
+				const std::function<void(StarDrawBatch&, int)>& drawJob);
+
 	//! Get the (translated) common name for a star with a specified
 	//! Hipparcos catalogue number.
 	//! @param hip The Hipparcos number of star
@@ -388,6 +455,8 @@ signals:
 	void designationUsageChanged(const bool flag);
 	void flagAdditionalNamesDisplayedChanged(const bool displayed);
 	void labelsAmountChanged(float a);
+	void drawThreadCountChanged(int n);
+	void flagZoneBuffersChanged(bool b);
 
 private:
 	void setCheckFlag(const QString& catalogId, bool b);
@@ -431,6 +500,19 @@ private:
 	//! Draw a nice animated pointer around the object.
 	void drawPointer(StelPainter& sPainter, const StelCore* core);
 
+	//! Compute the halos and labels of the stars in all visible zones into drawBatches.
+	//! The zones are shared between nThreads workers, each filling its own batch.
+	//! @param useZoneBuffers whether to collect the zones of the catalogs without star names in bufferDrawJobs
+	//! instead, when their buffer is available.
+	void prepareDraw(StelCore* core, const StelProjector* prj, const QVector<SphericalCap>& viewportCaps, int nThreads,
+			 bool useZoneBuffers=false);
+	//! Tell zoneBuffers which zones of the catalogs without star names entered or left the view, from the zone
+	//! changes of drawSearchResult, so that it keeps the buffers of the zones in the view.
+	void updateZoneBuffersInView(int maxSearchLevel);
+
+	//! Get the number of threads to use in prepareDraw().
+	int getEffectiveDrawThreadCount() const;
+
 	void populateHipparcosLists();
 	void populateStarsDesignations();
 
@@ -447,6 +529,50 @@ private:
 
 	int maxGeodesicGridLevel;
 	int lastMaxSearchLevel;
+	//! Set once loadModuleData() has run.
+	bool dataLoaded;
+
+	//! A zone to compute in prepareDraw()
+	struct ZoneDrawJob
+	{
+		int level;
+		int zone;
+		bool isInside;
+	};
+	//! The magnitude limits of a level in prepareDraw()
+	struct LevelDrawLimits
+	{
+		int limitMagIndex;
+		int maxMagStarName;
+	};
+	//! A zone to draw from its OpenGL buffer
+	struct ZoneBufferDrawJob
+	{
+		int level;
+		QOpenGLBuffer* buffer;
+		int nbStars;
+		int cutoffMagStep;
+	};
+	QVector<ZoneDrawJob> drawJobs;
+	QVector<ZoneBufferDrawJob> bufferDrawJobs;
+	QVector<LevelDrawLimits> drawLimits;
+	//! A table of precomputed RCMag per ZoneArray
+	QVector<RCMag> rcmagTables;
+	//! A batch of computed stars per draw thread
+	QVector<StarDrawBatch> drawBatches;
+	QThreadPool* drawThreadPool;
+	int drawThreadCount;
+	//! The zones of the previous frame, updated from one frame to the next in prepareDraw()
+	GeodesicSearchResult* drawSearchResult;
+	//! The grid of drawSearchResult, and its level to tell a new grid allocated at the same address
+	const StelGeodesicGrid* drawSearchGrid;
+	int drawSearchGridLevel;
+	//! The buffers of the zones drawn with StelSkyDrawer::drawPointSourceBuffer()
+	StarZoneBuffers* zoneBuffers;
+	//! The search level for which zoneBuffers got the zone changes of drawSearchResult in the previous frame,
+	//! or -1 if it has to get all the zones in the view again
+	int zoneBuffersSearchLevel;
+	bool flagZoneBuffers;
 	
 	// A ZoneArray per grid level
 	QVector<ZoneArray*> gridLevels;
@@ -475,6 +601,11 @@ private:
 	static QHash<int, QString> additionalNamesMapI18n;
 	static QMap<QString, int> additionalNamesIndex;
 	static QMap<QString, int> additionalNamesIndexI18n;
+	// the common and additional names for listMatchingObjects(), rebuilt in updateI18n()
+	static StelObjectNameIndex commonNamesSearchIndex;
+	static StelObjectNameIndex commonNamesSearchIndexI18n;
+	static StelObjectNameIndex additionalNamesSearchIndex;
+	static StelObjectNameIndex additionalNamesSearchIndexI18n;
 
 	static QHash<int, QString> sciNamesMapI18n;	
 	static QMap<QString, int> sciNamesIndexI18n;
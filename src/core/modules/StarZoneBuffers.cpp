@@ -0,0 +1,193 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StarZoneBuffers.hpp"
+#include "ZoneArray.hpp"
+
+#include <QOpenGLBuffer>
+#include <QOpenGLContext>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+const double J2000 = 2451545.0;
+}
+
+StarZoneBuffers::StarZoneBuffers()
+	: memoryUsage(0)
+	, memoryLimit(128)
+	, epochBucketYears(1.)
+	, maxUploadedStarsPerFrame(100000)
+	, frame(0)
+	, frameJDE(J2000)
+	, uploadedStars(0)
+{
+}
+
+StarZoneBuffers::~StarZoneBuffers()
+{
+	clear();
+}
+
+quint64 StarZoneBuffers::getKey(const ZoneArray* zoneArray, int zone)
+{
+	return (static_cast<quint64>(static_cast<quint32>(zoneArray->level)) << 32) | static_cast<quint32>(zone);
+}
+
+void StarZoneBuffers::setMemoryLimit(int megabytes)
+{
+	memoryLimit = qMax(0, megabytes);
+}
+
+void StarZoneBuffers::setEpochBucketYears(double years)
+{
+	epochBucketYears = qMax(0.01, years);
+}
+
+int StarZoneBuffers::getEpochBucket(double jde) const
+{
+	return static_cast<int>(std::floor((jde-J2000)/(365.25*epochBucketYears)));
+}
+
+double StarZoneBuffers::getEpochBucketJDE(int epochBucket) const
+{
+	return J2000 + (epochBucket+0.5)*365.25*epochBucketYears;
+}
+
+void StarZoneBuffers::beginFrame(double jde)
+{
+	++frame;
+	frameJDE = jde;
+	uploadedStars = 0;
+}
+
+void StarZoneBuffers::updateZonesInView(const ZoneArray* zoneArray, const QVector<int>& entered, const QVector<int>& left)
+{
+	for (int zone : left)
+	{
+		auto it = buffers.find(getKey(zoneArray, zone));
+		if (it!=buffers.end())
+		{
+			it->inView = false;
+			it->lastUsedFrame = frame;
+		}
+	}
+	for (int zone : entered)
+	{
+		auto it = buffers.find(getKey(zoneArray, zone));
+		if (it!=buffers.end())
+			it->inView = true;
+	}
+}
+
+void StarZoneBuffers::setAllOutOfView()
+{
+	for (auto& zoneBuffer : buffers)
+	{
+		if (zoneBuffer.inView)
+		{
+			zoneBuffer.inView = false;
+			zoneBuffer.lastUsedFrame = frame;
+		}
+	}
+}
+
+QOpenGLBuffer* StarZoneBuffers::getBuffer(const ZoneArray* zoneArray, int zone)
+{
+	// The stars without proper motions are the same at all dates
+	int epochBucket = 0;
+	if (zoneArray->hasProperMotions())
+		epochBucket = getEpochBucket(frameJDE);
+
+	const quint64 key = getKey(zoneArray, zone);
+	auto it = buffers.find(key);
+	if (it!=buffers.end() && it->epochBucket==epochBucket)
+	{
+		it->lastUsedFrame = frame;
+		it->inView = true;
+		return it->buffer;
+	}
+
+	if (uploadedStars>=maxUploadedStarsPerFrame || !QOpenGLContext::currentContext())
+		return Q_NULLPTR;
+
+	zoneArray->fillPointSourceBuffer(batch, zone, zoneArray->getMovementFactor(getEpochBucketJDE(epochBucket)), vertices);
+	const int size = vertices.size()*static_cast<int>(sizeof(StelSkyDrawer::PointSourceBufferVertex));
+
+	if (it==buffers.end())
+	{
+		QOpenGLBuffer* buffer = new QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+		buffer->setUsagePattern(QOpenGLBuffer::StaticDraw);
+		if (!buffer->create())
+		{
+			delete buffer;
+			return Q_NULLPTR;
+		}
+		ZoneBuffer zoneBuffer = {buffer, epochBucket, frame, true, 0};
+		it = buffers.insert(key, zoneBuffer);
+	}
+	it->buffer->bind();
+	it->buffer->allocate(vertices.constData(), size);
+	it->buffer->release();
+	memoryUsage += size - it->size;
+	it->size = size;
+	it->epochBucket = epochBucket;
+	it->lastUsedFrame = frame;
+	it->inView = true;
+	uploadedStars += vertices.size()/6;
+	return it->buffer;
+}
+
+void StarZoneBuffers::endFrame()
+{
+	const qint64 limit = static_cast<qint64>(memoryLimit)*1024*1024;
+	if (memoryUsage<=limit)
+		return;
+
+	QVector<QPair<int, quint64>> unused;
+	for (auto it = buffers.constBegin(); it != buffers.constEnd(); ++it)
+	{
+		if (!it->inView)
+			unused.append(qMakePair(it->lastUsedFrame, it.key()));
+	}
+	std::sort(unused.begin(), unused.end());
+	for (const auto& u : unused)
+	{
+		if (memoryUsage<=limit)
+			break;
+		auto it = buffers.find(u.second);
+		memoryUsage -= it->size;
+		it->buffer->destroy();
+		delete it->buffer;
+		buffers.erase(it);
+	}
+}
+
+void StarZoneBuffers::clear()
+{
+	for (auto& zoneBuffer : buffers)
+	{
+		zoneBuffer.buffer->destroy();
+		delete zoneBuffer.buffer;
+	}
+	buffers.clear();
+	memoryUsage = 0;
+}
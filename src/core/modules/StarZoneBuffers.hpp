@@ -0,0 +1,121 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef STARZONEBUFFERS_HPP
+#define STARZONEBUFFERS_HPP
+
+#include "StelSkyDrawer.hpp"
+#include "StarBatch.hpp"
+
+#include <QHash>
+#include <QVector>
+
+class ZoneArray;
+class QOpenGLBuffer;
+
+//! @class StarZoneBuffers
+//! Cache of the OpenGL vertex buffers holding the stars of the zones of the catalogs without star names,
+//! which StelSkyDrawer::drawPointSourceBuffer() draws without computing anything per star on the CPU.
+//! The buffer of a zone is uploaded the first time the zone is drawn. The buffers of the zones in the view are kept,
+//! those of the zones which left the view are released in the order they left once the buffers exceed the memory limit.
+//! The zones which enter and leave the view are given by updateZonesInView(), from GeodesicSearchResult::getZoneChanges().
+//! The stars with proper motions are stored at their position in the middle of an epoch bucket, and uploaded again
+//! when the date leaves the bucket. The stars without proper motions are uploaded once.
+//! The number of stars uploaded per frame is limited, so that looking at a new part of the sky doesn't stall a frame:
+//! getBuffer() returns no buffer for the zones which could not be uploaded yet, and they must be drawn from the CPU.
+//! All methods must be called from the main thread, with the OpenGL context current.
+class StarZoneBuffers
+{
+public:
+	StarZoneBuffers();
+	~StarZoneBuffers();
+
+	//! Set the maximum size of the buffers kept from one frame to the next, in MB.
+	void setMemoryLimit(int megabytes);
+	int getMemoryLimit() const {return memoryLimit;}
+
+	//! Set the length of the epoch buckets in years.
+	void setEpochBucketYears(double years);
+	double getEpochBucketYears() const {return epochBucketYears;}
+	//! Get the epoch bucket of a date, counted from J2000.0.
+	int getEpochBucket(double jde) const;
+	//! Get the date in the middle of an epoch bucket, for which the stars with proper motions are uploaded.
+	double getEpochBucketJDE(int epochBucket) const;
+
+	//! Set the maximum number of stars to upload in a frame.
+	void setMaxUploadedStarsPerFrame(int n) {maxUploadedStarsPerFrame = n;}
+
+	//! Start a new frame at the given date.
+	void beginFrame(double jde);
+
+	//! Mark the buffers of the zones of a catalog which entered or left the view since the last frame.
+	//! A zone which is both in @p entered and in @p left stays in the view.
+	void updateZonesInView(const ZoneArray* zoneArray, const QVector<int>& entered, const QVector<int>& left);
+	//! Mark all buffers as out of the view, e.g. before giving all the zones in the view to updateZonesInView()
+	//! when the zone changes since the last frame are not known.
+	void setAllOutOfView();
+
+	//! Get the buffer of a zone, uploading it if it is not cached or if it was uploaded for another epoch bucket.
+	//! The zone is marked as in the view.
+	//! @return the buffer, or Q_NULLPTR if the upload limit of the frame is reached or no buffer can be created.
+	QOpenGLBuffer* getBuffer(const ZoneArray* zoneArray, int zone);
+
+	//! Release the buffers of the zones out of the view, the first ones to leave it first, until the buffers fit in the memory limit.
+	//! The buffers of the zones in the view are kept in any case.
+	void endFrame();
+
+	//! Release all the buffers.
+	void clear();
+
+	//! Get the number of buffers and their total size in bytes.
+	int getNrOfBuffers() const {return buffers.size();}
+	qint64 getMemoryUsage() const {return memoryUsage;}
+
+	//! Get the number of stars uploaded in the current frame.
+	int getNrOfUploadedStars() const {return uploadedStars;}
+
+private:
+	struct ZoneBuffer
+	{
+		QOpenGLBuffer* buffer;
+		int epochBucket;
+		//! The last frame in which the zone was drawn or in the view
+		int lastUsedFrame;
+		bool inView;
+		qint64 size;
+	};
+
+	static quint64 getKey(const ZoneArray* zoneArray, int zone);
+
+	QHash<quint64, ZoneBuffer> buffers;
+	qint64 memoryUsage;
+	int memoryLimit;
+	double epochBucketYears;
+	int maxUploadedStarsPerFrame;
+
+	int frame;
+	double frameJDE;
+	int uploadedStars;
+
+	//! Working buffers for the uploads
+	StarBatch batch;
+	QVector<StelSkyDrawer::PointSourceBufferVertex> vertices;
+};
+
+#endif // STARZONEBUFFERS_HPP
@@ -23,10 +23,14 @@
 #include "StelGeodesicGrid.hpp"
 #include "StelObject.hpp"
 #include "StelPainter.hpp"
+#include "StelProjector.hpp"
 
 #include <QDebug>
 #include <QFile>
 #include <QDir>
+
+#include <algorithm>
+
 #ifdef Q_OS_WIN
 #include <io.h>
 #include <Windows.h>
@@ -408,20 +412,14 @@ SpecialZoneArray<Star>::~SpecialZoneArray(void)
 	nr_of_stars = 0;
 }
 
-template<class Star>
-void SpecialZoneArray<Star>::draw(StelPainter* sPainter, int index, bool isInsideViewport, const RCMag* rcmag_table,
-				  int limitMagIndex, StelCore* core, int maxMagStarName, float names_brightness, bool designationUsage,
-				  const QVector<SphericalCap> &boundingCaps) const
+float ZoneArray::getMovementFactor(double jde) const
 {
-	StelSkyDrawer* drawer = core->getSkyDrawer();
-	Vec3f vf;
 	static const double d2000 = 2451545.0;
-	const float movementFactor = static_cast<float>((M_PI/180.)*(0.0001/3600.) * ((core->getJDE()-d2000)/365.25) / static_cast<double>(star_position_scale));
+	return static_cast<float>((M_PI/180.)*(0.0001/3600.) * ((jde-d2000)/365.25) / static_cast<double>(star_position_scale));
+}
 
-	const Extinction& extinction=core->getSkyDrawer()->getExtinction();
-	const bool withExtinction=drawer->getFlagHasAtmosphere() && extinction.getExtinctionCoefficient()>=0.01f;
-	const float k = 0.001f*mag_range/mag_steps; // from StarMgr.cpp line 654
-	
+int ZoneArray::getCutoffMagStep(const StelSkyDrawer* drawer, int limitMagIndex) const
+{
 	// Allow artificial cutoff:
 	// find the (integer) mag at which is just bright enough to be drawn.
 	int cutoffMagStep=limitMagIndex;
@@ -432,48 +430,104 @@ void SpecialZoneArray<Star>::draw(StelPainter* sPainter, int index, bool isInsid
 			cutoffMagStep = limitMagIndex;
 	}
 	Q_ASSERT(cutoffMagStep<RCMAG_TABLE_SIZE);
-    
-	// Go through all stars, which are sorted by magnitude (bright stars first)
+	return cutoffMagStep;
+}
+
+template<class Star>
+int SpecialZoneArray<Star>::getNrOfStarsToDraw(int index, int cutoffMagStep) const
+{
+	// The stars are sorted by magnitude (bright stars first): only take those above the artificial cutoff
+	const SpecialZoneData<Star>* zone = getZones() + index;
+	const Star* firstStar = zone->getStars();
+	const Star* lastStar = std::partition_point(firstStar, firstStar + zone->size,
+						    [cutoffMagStep](const Star& s) { return s.getMag() <= cutoffMagStep; });
+	return static_cast<int>(lastStar - firstStar);
+}
+
+template<class Star>
+void SpecialZoneArray<Star>::fillPointSourceBuffer(StarBatch& batch, int index, float movementFactor,
+						    QVector<StelSkyDrawer::PointSourceBufferVertex>& vertices) const
+{
+	const SpecialZoneData<Star>* zone = getZones() + index;
+	const int n = zone->size;
+	vertices.resize(n*6);
+	if (n==0)
+		return;
+	batch.decode(zone, n);
+	batch.computePositions(zone, movementFactor);
+	const float* px = batch.x.constData();
+	const float* py = batch.y.constData();
+	const float* pz = batch.z.constData();
+	StelSkyDrawer::PointSourceBufferVertex* vx = vertices.data();
+	const Star* s = zone->getStars();
+	for (int i=0; i<n; ++i, ++s, vx+=6)
+		StelSkyDrawer::fillPointSourceBufferVertices(vx, Vec3f(px[i], py[i], pz[i]), s->getBVIndex(), s->getMag());
+}
+
+template<class Star>
+void SpecialZoneArray<Star>::draw(StarDrawBatch& batch, const StelProjector* prj, int index, bool isInsideViewport, const RCMag* rcmag_table,
+				  int limitMagIndex, const StelCore* core, int maxMagStarName, bool designationUsage,
+				  const QVector<SphericalCap> &boundingCaps) const
+{
+	const StelSkyDrawer* drawer = core->getSkyDrawer();
+	Vec3f vf;
+	const float movementFactor = getMovementFactor(core->getJDE());
+
+	const Extinction& extinction=drawer->getExtinction();
+	const bool withExtinction=drawer->getFlagHasAtmosphere() && extinction.getExtinctionCoefficient()>=0.01f;
+	const float k = 0.001f*mag_range/mag_steps; // from StarMgr.cpp line 654
+	
+	const int cutoffMagStep = getCutoffMagStep(drawer, limitMagIndex);
+	const int n = getNrOfStarsToDraw(index, cutoffMagStep);
+	if (n==0)
+		return;
 	const SpecialZoneData<Star>* zoneToDraw = getZones() + index;
-	const Star* lastStar = zoneToDraw->getStars() + zoneToDraw->size;
-	for (const Star* s=zoneToDraw->getStars();s<lastStar;++s)
+	const Star* firstStar = zoneToDraw->getStars();
+
+	// Compute and project the positions of all these stars at once
+	StarBatch& stars = batch.stars;
+	stars.decode(zoneToDraw, n);
+	stars.computePositions(zoneToDraw, movementFactor);
+	stars.project(prj);
+	const float* px = stars.x.constData();
+	const float* py = stars.y.constData();
+	const float* pz = stars.z.constData();
+	const float* wx = stars.winX.constData();
+	const float* wy = stars.winY.constData();
+	quint8* visible = stars.valid.data();
+
+	// If the star zone is not strictly contained inside the viewport, eliminate from the
+	// beginning the stars actually outside viewport.
+	if (!isInsideViewport)
 	{
-		// Artifical cutoff per magnitude
-		if (s->getMag() > cutoffMagStep)
-			break;
-    
-		// Because of the test above, the star should always be visible from this point.
-		
-		// Array of 2 numbers containing radius and magnitude
-		const RCMag* tmpRcmag = &rcmag_table[s->getMag()];
-		
-		// Get the star position from the array
-		s->getJ2000Pos(zoneToDraw, movementFactor, vf);
-		
-		// If the star zone is not strictly contained inside the viewport, eliminate from the 
-		// beginning the stars actually outside viewport.
-		if (!isInsideViewport)
+		for (const auto& cap : boundingCaps)
 		{
-			vf.normalize();
-			bool isVisible = true;
-			for (const auto& cap : boundingCaps)
-			{
-				if (!cap.contains(vf))
-				{
-					isVisible = false;
-					continue;
-				}
-			}
-			if (!isVisible)
-				continue;
+			const float nx = static_cast<float>(cap.n[0]);
+			const float ny = static_cast<float>(cap.n[1]);
+			const float nz = static_cast<float>(cap.n[2]);
+			const float d = static_cast<float>(cap.d);
+			for (int i=0; i<n; ++i)
+				visible[i] &= (px[i]*nx + py[i]*ny + pz[i]*nz >= d);
 		}
+		for (int i=0; i<n; ++i)
+			visible[i] &= (prj->checkInViewport(Vec3f(wx[i], wy[i], 0.f)) ? 1 : 0);
+	}
+
+	const Star* s = firstStar;
+	for (int i=0; i<n; ++i, ++s)
+	{
+		if (!visible[i])
+			continue;
+
+		// Array of 2 numbers containing radius and magnitude
+		const RCMag* tmpRcmag = &rcmag_table[s->getMag()];
+		vf.set(px[i], py[i], pz[i]);
 
 		int extinctedMagIndex = s->getMag();
 		float twinkleFactor=1.0f; // allow height-dependent twinkle.
 		if (withExtinction)
 		{
 			Vec3f altAz(vf);
-			altAz.normalize();
 			core->j2000ToAltAzInPlaceNoRefraction(&altAz);
 			float extMagShift=0.0f;
 			extinction.forward(altAz, &extMagShift);
@@ -484,12 +538,15 @@ void SpecialZoneArray<Star>::draw(StelPainter* sPainter, int index, bool isInsid
 			twinkleFactor=qMin(1.0f, 1.0f-0.9f*altAz[2]); // suppress twinkling in higher altitudes. Keep 0.1 twinkle amount in zenith.
 		}
 
-		if (drawer->drawPointSource(sPainter, vf, *tmpRcmag, s->getBVIndex(), !isInsideViewport, twinkleFactor) && s->hasName() && extinctedMagIndex < maxMagStarName && s->hasComponentID()<=1)
+		if (drawer->addPointSource(wx[i], wy[i], *tmpRcmag, s->getBVIndex(), batch.pointSources, twinkleFactor) && s->hasName() && extinctedMagIndex < maxMagStarName && s->hasComponentID()<=1)
 		{
-			const float offset = tmpRcmag->radius*0.7f;
-			const Vec3f colorr = StelSkyDrawer::indexToColor(s->getBVIndex())*0.75f;
-			sPainter->setColor(colorr,names_brightness);
-			sPainter->drawText(vf.toVec3d(), designationUsage ? s->getDesignation() : s->getNameI18n(), 0, offset, offset, false);
+			// Labels are drawn later in the main thread
+			StarLabel label;
+			label.pos = vf;
+			label.text = designationUsage ? s->getDesignation() : s->getNameI18n();
+			label.bVIndex = s->getBVIndex();
+			label.offset = tmpRcmag->radius*0.7f;
+			batch.labels.append(label);
 		}
 	}
 }
@@ -34,6 +34,8 @@
 #include <QFile>
 #include <QDebug>
 
+#include <type_traits>
+
 #ifdef __OpenBSD__
 #include <unistd.h>
 #endif
@@ -99,11 +101,34 @@ public:
 							  QList<StelObjectP > &result) = 0;
 
 	//! Pure virtual method. See subclass implementation.
-	virtual void draw(StelPainter* sPainter, int index,bool is_inside,
-					  const RCMag* rcmag_table, int limitMagIndex, StelCore* core,
-					  int maxMagStarName, float names_brightness, bool designationUsage,
+	virtual void draw(StarDrawBatch& batch, const StelProjector* prj, int index, bool is_inside,
+					  const RCMag* rcmag_table, int limitMagIndex, const StelCore* core,
+					  int maxMagStarName, bool designationUsage,
 					  const QVector<SphericalCap>& boundingCaps) const = 0;
 
+	//! Get whether the stars of this catalog have names, which are only drawn by draw().
+	virtual bool hasStarNames() const = 0;
+
+	//! Get whether the stars of this catalog have proper motions.
+	virtual bool hasProperMotions() const = 0;
+
+	//! Get the number of stars of a zone which are bright enough to be drawn.
+	//! @param cutoffMagStep the magnitude index returned by getCutoffMagStep()
+	virtual int getNrOfStarsToDraw(int index, int cutoffMagStep) const = 0;
+
+	//! Write the vertices of all the stars of a zone for StelSkyDrawer::drawPointSourceBuffer(), brightest stars first.
+	//! @param batch a working buffer for the star positions
+	//! @param movementFactor the proper motion factor, as returned by getMovementFactor()
+	virtual void fillPointSourceBuffer(StarBatch& batch, int index, float movementFactor,
+					   QVector<StelSkyDrawer::PointSourceBufferVertex>& vertices) const = 0;
+
+	//! Get the proper motion factor of the stars at a date, as for Star1::getJ2000Pos().
+	float getMovementFactor(double jde) const;
+
+	//! Get the magnitude index from which the stars are not drawn, taking into account the user-defined magnitude limit.
+	//! @param limitMagIndex the index at which the stars are not visible anymore
+	int getCutoffMagStep(const StelSkyDrawer* drawer, int limitMagIndex) const;
+
 	//! Get whether or not the catalog was successfully loaded.
 	//! @return @c true if at least one zone was loaded, otherwise @c false
 	bool isInitialized(void) const { return (nr_of_zones>0); }
@@ -170,20 +195,30 @@ protected:
 		return static_cast<SpecialZoneData<Star>*>(zones);
 	}
 
-	//! Draw stars and their names onto the viewport.
-	//! @param sPainter the painter to use 
+	//! Compute the halos of the stars of a zone and collect the labels to draw.
+	//! Nothing is drawn here: this only reads shared state, so different zones
+	//! may be processed concurrently from worker threads, each with its own batch.
+	//! @param batch the buffer receiving the star vertices and label candidates
+	//! @param prj the projector of the frame
 	//! @param index zone index to draw
 	//! @param isInsideViewport whether the zone is inside the current viewport
 	//! @param rcmag_table table of magnitudes
 	//! @param limitMagIndex index from rcmag_table at which stars are not visible anymore
 	//! @param core core to use for drawing
 	//! @param maxMagStarName magnitude limit of stars that display labels
-	//! @param names_brightness brightness of labels
-	virtual void draw(StelPainter* sPainter, int index, bool isInsideViewport,
-			  const RCMag *rcmag_table, int limitMagIndex, StelCore* core,
-			  int maxMagStarName, float names_brightness, bool designationUsage,
+	//! @param designationUsage whether labels show designations instead of common names
+	//! @param boundingCaps the caps bounding the viewport
+	virtual void draw(StarDrawBatch& batch, const StelProjector* prj, int index, bool isInsideViewport,
+			  const RCMag *rcmag_table, int limitMagIndex, const StelCore* core,
+			  int maxMagStarName, bool designationUsage,
 			  const QVector<SphericalCap>& boundingCaps) const;
 
+	virtual bool hasStarNames() const {return std::is_same<Star, Star1>::value;}
+	virtual bool hasProperMotions() const {return !std::is_same<Star, Star3>::value;}
+	virtual int getNrOfStarsToDraw(int index, int cutoffMagStep) const;
+	virtual void fillPointSourceBuffer(StarBatch& batch, int index, float movementFactor,
+					   QVector<StelSkyDrawer::PointSourceBufferVertex>& vertices) const;
+
 	virtual void scaleAxis();
 	virtual void searchAround(const StelCore* core, int index,const Vec3d &v,double cosLimFov,
 					  QList<StelObjectP > &result);
@@ -31,6 +31,8 @@ Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
 #include "de430.hpp"
 #include "pluto.h"
 
+#include <QMutex>
+
 #define EPHEM_MERCURY_ID  0
 #define EPHEM_VENUS_ID    1
 #define EPHEM_EMB_ID      2
@@ -58,13 +60,18 @@ Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
 **            7 = uranus 
 **/
 
+// jpl_init_ephemeris() reports errors in a static variable: serialize opening the DE files.
+static QMutex jplInitMutex;
+
 void EphemWrapper::init_de430(const char* filepath)
 {
+	QMutexLocker locker(&jplInitMutex);
 	InitDE430(filepath);
 }
 
 void EphemWrapper::init_de431(const char* filepath)
 {
+	QMutexLocker locker(&jplInitMutex);
 	InitDE431(filepath);
 }
 
@@ -92,28 +99,117 @@ bool EphemWrapper::use_de431(const double jd)
 	return StelApp::getInstance().getCore()->de431IsActive() && EphemWrapper::jd_fits_de431(jd);
 }
 
-// planet_id is ONLY one of the #defined values 0..8 above.
-void get_planet_helio_coordsv(const double jd, double xyz[3], double xyzdot[3], const int planet_id)
+EphemerisContext::EphemerisContext()
 {
-	bool deOk=false;
-	double xyz6[6];
-	if(!std::isfinite(jd))
+	StelCore* core=StelApp::getInstance().getCore();
+	de430Enabled=core->de430IsActive();
+	de431Enabled=core->de431IsActive();
+	init();
+}
+
+EphemerisContext::EphemerisContext(bool useDe430, bool useDe431)
+	: de430Enabled(useDe430)
+	, de431Enabled(useDe431)
+{
+	init();
+}
+
+void EphemerisContext::init()
+{
+	de430Opened=false;
+	de431Opened=false;
+	de430Handle=Q_NULLPTR;
+	de431Handle=Q_NULLPTR;
+	InitVsop87Cache(&vsop87Cache);
+	InitElp82bCache(&elp82bCache);
+}
+
+EphemerisContext::~EphemerisContext()
+{
+	if (de430Handle)
+		jpl_close_ephemeris(de430Handle);
+	if (de431Handle)
+		jpl_close_ephemeris(de431Handle);
+}
+
+void* EphemerisContext::getDe430Handle()
+{
+	if (!de430Opened)
 	{
-		qDebug() << "get_planet_helio_coordsv(): SKIPPED CoordCalc, jd is infinite/nan: " << jd;
-		return;
+		QMutexLocker locker(&jplInitMutex);
+		de430Handle=OpenDe430Handle();
+		de430Opened=true;
 	}
+	return de430Handle;
+}
 
-	if(EphemWrapper::use_de430(jd))
+void* EphemerisContext::getDe431Handle()
+{
+	if (!de431Opened)
 	{
-		deOk=GetDe430Coor(jd, planet_id + 1, xyz6);
+		QMutexLocker locker(&jplInitMutex);
+		de431Handle=OpenDe431Handle();
+		de431Opened=true;
+	}
+	return de431Handle;
+}
+
+// Get coordinates from DE430 or DE431, if they are in use for jd.
+// With a context its own file handles are used, otherwise the shared handles.
+static bool get_de_coordsv(const double jd, const int planet_id, double xyz6[6], EphemerisContext* context, const int centralBody_id=CENTRAL_PLANET_ID)
+{
+	if (context)
+	{
+		if (context->use_de430(jd))
+		{
+			void* handle=context->getDe430Handle();
+			return handle && GetDe430CoorWithHandle(handle, jd, planet_id, xyz6, centralBody_id);
+		}
+		else if (context->use_de431(jd))
+		{
+			void* handle=context->getDe431Handle();
+			return handle && GetDe431CoorWithHandle(handle, jd, planet_id, xyz6, centralBody_id);
+		}
+		return false;
 	}
+
+	if(EphemWrapper::use_de430(jd))
+		return GetDe430Coor(jd, planet_id, xyz6, centralBody_id);
 	else if(EphemWrapper::use_de431(jd))
+		return GetDe431Coor(jd, planet_id, xyz6, centralBody_id);
+	return false;
+}
+
+static void get_vsop87_coordsv(const double jd, const int planet_id, double xyz6[6], EphemerisContext* context)
+{
+	if (context)
+		GetVsop87CoorCached(&context->vsop87Cache, jd, planet_id, xyz6);
+	else
+		GetVsop87Coor(jd, planet_id, xyz6);
+}
+
+static void get_elp82b_coords(const double jd, double xyz[3], EphemerisContext* context)
+{
+	if (context)
+		GetElp82bCoorCached(&context->elp82bCache, jd, xyz);
+	else
+		GetElp82bCoor(jd, xyz);
+}
+
+// planet_id is ONLY one of the #defined values 0..8 above.
+void get_planet_helio_coordsv(const double jd, double xyz[3], double xyzdot[3], const int planet_id, EphemerisContext* context)
+{
+	double xyz6[6];
+	if(!std::isfinite(jd))
 	{
-		deOk=GetDe431Coor(jd, planet_id + 1, xyz6);
+		qDebug() << "get_planet_helio_coordsv(): SKIPPED CoordCalc, jd is infinite/nan: " << jd;
+		return;
 	}
+
+	const bool deOk=get_de_coordsv(jd, planet_id + 1, xyz6, context);
 	if (!deOk) //VSOP87 as fallback
 	{
-		GetVsop87Coor(jd, planet_id, xyz6);
+		get_vsop87_coordsv(jd, planet_id, xyz6, context);
 	}
 	xyz[0]   =xyz6[0]; xyz[1]   =xyz6[1]; xyz[2]   =xyz6[2];
 	xyzdot[0]=xyz6[3]; xyzdot[1]=xyz6[4]; xyzdot[2]=xyz6[5];
@@ -152,10 +248,8 @@ void get_planet_helio_osculating_coordsv(double jd0, double jd, double xyz[3], d
  * for given Julian Day. Values are in AU.
  * params : Julian day, rect coords */
 
-void get_pluto_helio_coordsv(double jd,double xyz[3], double xyzdot[3], void* unused)
+void get_pluto_helio_coordsv(double jd,double xyz[3], double xyzdot[3], void* context)
 {
-	Q_UNUSED(unused);
-	bool deOk=false;
 	double xyz6[6];
 	if(!std::isfinite(jd))
 	{
@@ -163,14 +257,7 @@ void get_pluto_helio_coordsv(double jd,double xyz[3], double xyzdot[3], void* un
 		return;
 	}
 
-	if(EphemWrapper::use_de430(jd))
-	{
-		deOk=GetDe430Coor(jd, EPHEM_JPL_PLUTO_ID, xyz6);
-	}
-	else if(EphemWrapper::use_de431(jd))
-	{
-		deOk=GetDe431Coor(jd, EPHEM_JPL_PLUTO_ID, xyz6);
-	}
+	const bool deOk=get_de_coordsv(jd, EPHEM_JPL_PLUTO_ID, xyz6, static_cast<EphemerisContext*>(context));
 
 	if (deOk)
 	{
@@ -193,21 +280,18 @@ void get_sun_helio_coordsv(double jd,double xyz[3], double xyzdot[3], void* unus
 	xyzdot[0]=0.; xyzdot[1]=0.; xyzdot[2]=0.;
 }
 
-void get_mercury_helio_coordsv(double jd,double xyz[3], double xyzdot[3], void* unused)
+void get_mercury_helio_coordsv(double jd,double xyz[3], double xyzdot[3], void* context)
 {
-	Q_UNUSED(unused);
-	get_planet_helio_coordsv(jd, xyz, xyzdot, EPHEM_MERCURY_ID);
+	get_planet_helio_coordsv(jd, xyz, xyzdot, EPHEM_MERCURY_ID, static_cast<EphemerisContext*>(context));
 }
-void get_venus_helio_coordsv(double jd,double xyz[3], double xyzdot[3], void* unused)
+void get_venus_helio_coordsv(double jd,double xyz[3], double xyzdot[3], void* context)
 {
-	Q_UNUSED(unused);
-	get_planet_helio_coordsv(jd, xyz, xyzdot, EPHEM_VENUS_ID);
+	get_planet_helio_coordsv(jd, xyz, xyzdot, EPHEM_VENUS_ID, static_cast<EphemerisContext*>(context));
 }
 
-void get_earth_helio_coordsv(const double jd,double xyz[3], double xyzdot[3], void* unused)
+void get_earth_helio_coordsv(const double jd,double xyz[3], double xyzdot[3], void* context)
 {
-	Q_UNUSED(unused);
-	bool deOk=false;
+	EphemerisContext* ctx=static_cast<EphemerisContext*>(context);
 	double xyz6[6];
 	if(!std::isfinite(jd))
 	{
@@ -215,19 +299,12 @@ void get_earth_helio_coordsv(const double jd,double xyz[3], double xyzdot[3], vo
 		return;
 	}
 
-	if(EphemWrapper::use_de430(jd))
-	{
-		deOk=GetDe430Coor(jd, EPHEM_JPL_EARTH_ID, xyz6);
-	}
-	else if(EphemWrapper::use_de431(jd))
-	{
-		deOk=GetDe431Coor(jd, EPHEM_JPL_EARTH_ID, xyz6);
-	}
+	const bool deOk=get_de_coordsv(jd, EPHEM_JPL_EARTH_ID, xyz6, ctx);
 	if (!deOk) //VSOP87 as fallback
 	{
 		double moon[3];
-		GetVsop87Coor(jd,EPHEM_EMB_ID,xyz6);
-		GetElp82bCoor(jd,moon);
+		get_vsop87_coordsv(jd,EPHEM_EMB_ID,xyz6,ctx);
+		get_elp82b_coords(jd,moon,ctx);
 		/* Earth != EMB:
 	0.0121505677733761 = mu_m/(1+mu_m),
 	mu_m = mass(moon)/mass(earth) = 0.01230002 */
@@ -240,34 +317,29 @@ void get_earth_helio_coordsv(const double jd,double xyz[3], double xyzdot[3], vo
 	xyzdot[0]=xyz6[3]; xyzdot[1]=xyz6[4]; xyzdot[2]=xyz6[5];
 }
 
-void get_mars_helio_coordsv(double jd,double xyz[3], double xyzdot[3], void* unused)
+void get_mars_helio_coordsv(double jd,double xyz[3], double xyzdot[3], void* context)
 {
-	Q_UNUSED(unused);
-	get_planet_helio_coordsv(jd, xyz, xyzdot, EPHEM_MARS_ID);
+	get_planet_helio_coordsv(jd, xyz, xyzdot, EPHEM_MARS_ID, static_cast<EphemerisContext*>(context));
 }
 
-void get_jupiter_helio_coordsv(double jd,double xyz[3], double xyzdot[3], void* unused)
+void get_jupiter_helio_coordsv(double jd,double xyz[3], double xyzdot[3], void* context)
 {
-	Q_UNUSED(unused);
-	get_planet_helio_coordsv(jd, xyz, xyzdot, EPHEM_JUPITER_ID);
+	get_planet_helio_coordsv(jd, xyz, xyzdot, EPHEM_JUPITER_ID, static_cast<EphemerisContext*>(context));
 }
 
-void get_saturn_helio_coordsv(double jd,double xyz[3], double xyzdot[3], void* unused)
+void get_saturn_helio_coordsv(double jd,double xyz[3], double xyzdot[3], void* context)
 {
-	Q_UNUSED(unused);
-	get_planet_helio_coordsv(jd, xyz, xyzdot, EPHEM_SATURN_ID);
+	get_planet_helio_coordsv(jd, xyz, xyzdot, EPHEM_SATURN_ID, static_cast<EphemerisContext*>(context));
 }
 
-void get_uranus_helio_coordsv(double jd,double xyz[3], double xyzdot[3], void* unused)
+void get_uranus_helio_coordsv(double jd,double xyz[3], double xyzdot[3], void* context)
 {
-	Q_UNUSED(unused);
-	get_planet_helio_coordsv(jd, xyz, xyzdot, EPHEM_URANUS_ID);
+	get_planet_helio_coordsv(jd, xyz, xyzdot, EPHEM_URANUS_ID, static_cast<EphemerisContext*>(context));
 }
 
-void get_neptune_helio_coordsv(double jd,double xyz[3], double xyzdot[3], void* unused)
+void get_neptune_helio_coordsv(double jd,double xyz[3], double xyzdot[3], void* context)
 {
-	Q_UNUSED(unused);
-	get_planet_helio_coordsv(jd, xyz, xyzdot, EPHEM_NEPTUNE_ID);
+	get_planet_helio_coordsv(jd, xyz, xyzdot, EPHEM_NEPTUNE_ID, static_cast<EphemerisContext*>(context));
 }
 
 void get_mercury_helio_osculating_coords(double jd0,double jd,double xyz[3], double xyzdot[3])
@@ -317,15 +389,11 @@ void get_neptune_helio_osculating_coords(double jd0,double jd,double xyz[3], dou
  * Michelle Chapront-Touze and Jean Chapront of the Bureau des Longitudes,
  * Paris. ELP 2000-82B theory
  * param jd Julian day, rect pos */
-void get_lunar_parent_coordsv(double jde, double xyz[3], double xyzdot[3], void* unused)
+void get_lunar_parent_coordsv(double jde, double xyz[3], double xyzdot[3], void* context)
 {
-	Q_UNUSED(unused);
+	EphemerisContext* ctx=static_cast<EphemerisContext*>(context);
 	double xyz6[6];
-	bool deOk=false;
-	if(EphemWrapper::use_de430(jde))
-		deOk=GetDe430Coor(jde, EPHEM_JPL_MOON_ID, xyz6, EPHEM_JPL_EARTH_ID);
-	else if(EphemWrapper::use_de431(jde))
-		deOk=GetDe431Coor(jde, EPHEM_JPL_MOON_ID, xyz6, EPHEM_JPL_EARTH_ID);
+	const bool deOk=get_de_coordsv(jde, EPHEM_JPL_MOON_ID, xyz6, ctx, EPHEM_JPL_EARTH_ID);
 
 	if (deOk)
 	{
@@ -334,7 +402,7 @@ void get_lunar_parent_coordsv(double jde, double xyz[3], double xyzdot[3], void*
 	}
 	else
 	{  // fallback to DE-less solution.
-		GetElp82bCoor(jde,xyz);
+		get_elp82b_coords(jde,xyz,ctx);
 		xyzdot[0]=xyzdot[1]=xyzdot[2]=0.0; // TODO: Some meaningful way to get speed?
 	}
 }
@@ -32,6 +32,11 @@ Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
 #ifndef EPHEMWRAPPER_HPP
 #define EPHEMWRAPPER_HPP
 
+#include "vsop87.h"
+#include "elp82b.h"
+
+#include <QtGlobal>
+
 #define DE430_FILENAME  "linux_p1550p2650.430"
 #define DE431_FILENAME  "lnxm13000p17000.431"
 
@@ -45,7 +50,55 @@ public:
     static bool use_de431(const double jd);
 };
 
-// These functions have an unused void pointer to be compatible to PosFuncType in SolarSystem and Planet classes.
+//! @class EphemerisContext
+//! The state of the planetary theories needed for computations outside the main thread.
+//! VSOP87 and ELP82B keep interpolation caches, and DE430/DE431 read records into a cache of their file handle.
+//! By default these are static and shared, so positions can only be computed from the main thread.
+//! An EphemerisContext owns its own caches and opens its own DE430/DE431 file handles on first use,
+//! so that one context per thread (or per job) allows computations in parallel.
+//! Pass a pointer to the context as the last (user data) argument of the get_*_helio_coordsv() functions
+//! and of get_lunar_parent_coordsv(). With Q_NULLPTR, the static caches are used.
+//! The theories of the planet moons don't need a context: L1.2 has no cache, and MarsSat, TASS1.7
+//! and GUST86 keep their caches per thread.
+//! @note the get_*_helio_osculating_coords() functions still use the static VSOP87 cache and
+//! DE430/DE431 handles, and must only be called from the main thread.
+class EphemerisContext
+{
+public:
+	//! Create a context which uses DE430/DE431 if they are active in StelCore.
+	EphemerisContext();
+	//! Create a context with explicit DE430/DE431 usage, e.g. for tools without StelApp.
+	//! DE430/DE431 must have been initialized with EphemWrapper::init_de430()/init_de431() to be used.
+	EphemerisContext(bool useDe430, bool useDe431);
+	~EphemerisContext();
+
+	//! @return true if DE430 shall be used for jd in this context
+	bool use_de430(const double jd) const {return de430Enabled && EphemWrapper::jd_fits_de430(jd);}
+	//! @return true if DE431 shall be used for jd in this context
+	bool use_de431(const double jd) const {return de431Enabled && EphemWrapper::jd_fits_de431(jd);}
+
+	//! Get the DE430 file handle of this context, opened on first call.
+	//! @return Q_NULLPTR if the file could not be opened
+	void* getDe430Handle();
+	//! Get the DE431 file handle of this context, opened on first call.
+	//! @return Q_NULLPTR if the file could not be opened
+	void* getDe431Handle();
+
+	Vsop87Cache vsop87Cache;
+	Elp82bCache elp82bCache;
+
+private:
+	Q_DISABLE_COPY(EphemerisContext)
+	void init();
+
+	bool de430Enabled, de431Enabled;
+	bool de430Opened, de431Opened;
+	void* de430Handle;
+	void* de431Handle;
+};
+
+// These functions have a void pointer to be compatible to PosFuncType in SolarSystem and Planet classes.
+// For the planets and the Moon it may point to an EphemerisContext, otherwise it is unused.
 void get_sun_helio_coordsv(double jd,double xyz[3], double xyzdot[3], void*);
 void get_mercury_helio_coordsv(double jd,double xyz[3], double xyzdot[3], void*);
 void get_venus_helio_coordsv(double jd,double xyz[3], double xyzdot[3], void*);
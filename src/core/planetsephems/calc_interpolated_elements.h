@@ -25,6 +25,15 @@ SOFTWARE.
 #ifndef CALC_INTERPOLATED_ELEMENTS_H
 #define CALC_INTERPOLATED_ELEMENTS_H
 
+/* Storage class for the caches of the planetary and satellite theories.
+   The caches are per thread, so that positions may be computed in
+   background threads while the main thread draws the sky. */
+#if defined(_MSC_VER)
+#define EPHEM_THREAD_LOCAL __declspec(thread)
+#else
+#define EPHEM_THREAD_LOCAL __thread
+#endif
+
 extern
 void CalcInterpolatedElements(const double t,double elem[],
                               const int dim,
@@ -34,6 +34,13 @@ void InitDE430(const char* filepath);
 // most of the time centralBody_id likely is the Sun. However, for Moon, use centralBody_id=EPHEM_JPL_EARTH_ID=3
 // return true if OK, false if something was wrong with the JPL functions. In this case, see log for details.
 bool GetDe430Coor(const double jde, const int planet_id, double * xyz, const int centralBody_id=CENTRAL_PLANET_ID);
+// Open an additional, independent handle on the DE430 file given to InitDE430(), with its own record cache.
+// If the file is memory mapped, the new handle shares the mapping.
+// This allows computations in several threads, with one handle per thread. Close it with jpl_close_ephemeris().
+// Returns Q_NULLPTR if DE430 has not been initialized successfully. Calls to jpl_init_ephemeris() must not run concurrently.
+void* OpenDe430Handle();
+// Same as GetDe430Coor(), using a handle from OpenDe430Handle().
+bool GetDe430CoorWithHandle(void* handle, const double jde, const int planet_id, double * xyz, const int centralBody_id=CENTRAL_PLANET_ID);
 // Not possible for a DE.
 //void GetDe430OsculatingCoor(double jd0, double jd, int planet_id, double *xyz, const int centralBody_id=CENTRAL_PLANET_ID);
 
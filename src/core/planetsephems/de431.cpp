@@ -36,14 +36,10 @@ THE SOFTWARE.
 #endif
 
 static void * ephem;
+static QByteArray ephemFilePath;
    
-static Vec3d tempECLpos = Vec3d(0,0,0);
-static Vec3d tempECLspd = Vec3d(0,0,0);
-static Vec3d tempICRFpos = Vec3d(0,0,0);
-static Vec3d tempICRFspd = Vec3d(0,0,0);
 static char nams[JPL_MAX_N_CONSTANTS][6];
 static double vals[JPL_MAX_N_CONSTANTS];
-static double tempXYZ[6];
 #ifdef UNIT_TEST
 // NOTE: Added hook for unit testing
 static const Mat4d matJ2000ToVsop87(Mat4d::xrotation(-23.4392803055555555556*(M_PI/180)) * Mat4d::zrotation(0.0000275*(M_PI/180)));
@@ -53,7 +49,8 @@ static bool initDone = false;
 
 void InitDE431(const char* filepath)
 {
-	ephem = jpl_init_ephemeris(filepath, nams, vals);
+	ephemFilePath = filepath;
+	ephem = jpl_init_ephemeris_mapped(filepath, nams, vals);
 
 	if(jpl_init_error_code() != 0)
 	{
@@ -68,7 +65,8 @@ void InitDE431(const char* filepath)
 		double jd1, jd2;
 		jd1=jpl_get_double(ephem, JPL_EPHEM_START_JD);
 		jd2=jpl_get_double(ephem, JPL_EPHEM_END_JD);
-		qDebug() << "DE431 init successful. startJD=" << QString::number(jd1, 'f', 4) << "endJD=" << QString::number(jd2, 'f', 4);
+		qDebug() << "DE431 init successful. startJD=" << QString::number(jd1, 'f', 4) << "endJD=" << QString::number(jd2, 'f', 4)
+			 << (jpl_is_mapped(ephem) ? "(memory mapped)" : "");
 	}
 }
 
@@ -77,12 +75,29 @@ void TerminateDE431()
   jpl_close_ephemeris(ephem);
 }
 
+void* OpenDe431Handle()
+{
+	if (!initDone)
+		return Q_NULLPTR;
+	// A mapped file can be shared, only the interpolation state must be separate.
+	void* handle = jpl_is_mapped(ephem) ? jpl_clone_ephemeris(ephem) : jpl_init_ephemeris(ephemFilePath.constData(), Q_NULLPTR, Q_NULLPTR);
+	if (!handle)
+		qDebug() << "Error" << jpl_init_error_code() << "at opening another DE431 handle:" << jpl_init_error_message();
+	return handle;
+}
+
 bool GetDe431Coor(const double jde, const int planet_id, double * xyz, const int centralBody_id)
 {
-    if(initDone)
-    {
+	if(initDone)
+		return GetDe431CoorWithHandle(ephem, jde, planet_id, xyz, centralBody_id);
+	return false;
+}
+
+bool GetDe431CoorWithHandle(void* handle, const double jde, const int planet_id, double * xyz, const int centralBody_id)
+{
+	double tempXYZ[6];
 	// This may return some error code!
-	int jplresult=jpl_pleph(ephem, jde, planet_id, centralBody_id, tempXYZ, 1);
+	int jplresult=jpl_pleph(handle, jde, planet_id, centralBody_id, tempXYZ, 1);
 
 	switch (jplresult)
 	{
@@ -108,8 +123,9 @@ bool GetDe431Coor(const double jde, const int planet_id, double * xyz, const int
 			return false;
 	}
 
-	tempICRFpos = Vec3d(tempXYZ[0], tempXYZ[1], tempXYZ[2]);
-	tempICRFspd = Vec3d(tempXYZ[3], tempXYZ[4], tempXYZ[5]);
+	const Vec3d tempICRFpos(tempXYZ[0], tempXYZ[1], tempXYZ[2]);
+	const Vec3d tempICRFspd(tempXYZ[3], tempXYZ[4], tempXYZ[5]);
+	Vec3d tempECLpos, tempECLspd;
 	#ifdef UNIT_TEST
 	tempECLpos = matJ2000ToVsop87 * tempICRFpos;
 	tempECLspd = matJ2000ToVsop87 * tempICRFspd;
@@ -125,8 +141,6 @@ bool GetDe431Coor(const double jde, const int planet_id, double * xyz, const int
 	xyz[4] = tempECLspd[1];
 	xyz[5] = tempECLspd[2];
 	return true;
-    }
-    return false;
 }
 
 
@@ -43,6 +43,7 @@ the original Fortran code:
 
 ****************************************************************/
 
+#include "elp82b.h"
 #include "calc_interpolated_elements.h"
 
 #include <math.h>
@@ -162709,13 +162710,14 @@ void GetElp82bSphericalCoor(const double t,double r[3], void *user) {
   r[2] = (accu[2] + t*(accu[5] + t*accu[8])) * a0_div_ath_times_au;
 }
 
-  /* ugly static variable for caching: */
-static double t_0 = -1e100;
-static double t_1 = -1e100;
-static double t_2 = -1e100;
-static double r_0[3];
-static double r_1[3];
-static double r_2[3];
+  /* cache for GetElp82bCoor(), not reentrant: */
+static struct Elp82bCache elp82b_static_cache = {-1e100,-1e100,-1e100,{0},{0},{0}};
+
+void InitElp82bCache(struct Elp82bCache *cache) {
+  cache->t_0 = -1e100;
+  cache->t_1 = -1e100;
+  cache->t_2 = -1e100;
+}
 
 #define DELTA_T (1.0/(24.0*36525.0))
 
@@ -162732,10 +162734,16 @@ static const double q4 = -1.371808e-12;
 static const double q5 = -3.20334e-15;
 
 void GetElp82bCoor(const double jd,double xyz[3]) {
+  GetElp82bCoorCached(&elp82b_static_cache,jd,xyz);
+}
+
+void GetElp82bCoorCached(struct Elp82bCache *cache,const double jd,double xyz[3]) {
   const double t = (jd - 2451545.0) / 36525.0;
   double r[3];
   CalcInterpolatedElements(t,r,3,&GetElp82bSphericalCoor,DELTA_T,
-                           &t_0,r_0,&t_1,r_1,&t_2,r_2,0);
+                           &cache->t_0,cache->r_0,
+                           &cache->t_1,cache->r_1,
+                           &cache->t_2,cache->r_2,0);
   {
     const double rh = r[2] * cos(r[1]);
     const double x3 = r[2] * sin(r[1]);
@@ -78,7 +78,27 @@ void GetElp82bCoor(double jd,double xyz[3]);
      From this I conclude that in the context of stellarium
      ICRF, J2000 and FK5 are the same, while the transformation
      ICRF <-> VSOP87 must be done with the matrix given above.
+
+     ATTENTION! Due to static caching this function is not reentrant.
+     For computations in several threads use GetElp82bCoorCached()
+     with one struct Elp82bCache per thread.
    */
+
+struct Elp82bCache {
+  double t_0,t_1,t_2;
+  double r_0[3];
+  double r_1[3];
+  double r_2[3];
+};
+  /* Interpolation cache for GetElp82bCoorCached().
+     The contents belong to this function, the user must only
+     initialize it with InitElp82bCache() before the first use.
+  */
+
+void InitElp82bCache(struct Elp82bCache *cache);
+
+void GetElp82bCoorCached(struct Elp82bCache *cache,double jd,double xyz[3]);
+  /* Same as GetElp82bCoor(), with the cache supplied by the caller. */
      
 
 #ifdef __cplusplus
@@ -426,17 +426,17 @@ static const double GUST86toVsop87[9] = {
 };
 
 #define GUST86_DIM (5*6)
-static double t_0 = -1e100;
-static double t_1 = -1e100;
-static double t_2 = -1e100;
-static double gust86_elem_0[GUST86_DIM];
-static double gust86_elem_1[GUST86_DIM];
-static double gust86_elem_2[GUST86_DIM];
+static EPHEM_THREAD_LOCAL double t_0 = -1e100;
+static EPHEM_THREAD_LOCAL double t_1 = -1e100;
+static EPHEM_THREAD_LOCAL double t_2 = -1e100;
+static EPHEM_THREAD_LOCAL double gust86_elem_0[GUST86_DIM];
+static EPHEM_THREAD_LOCAL double gust86_elem_1[GUST86_DIM];
+static EPHEM_THREAD_LOCAL double gust86_elem_2[GUST86_DIM];
 /* 1 day: */
 #define DELTA_T 1.0
 
-static double gust86_jd0 = -1e100;
-static double gust86_elem[GUST86_DIM];
+static EPHEM_THREAD_LOCAL double gust86_jd0 = -1e100;
+static EPHEM_THREAD_LOCAL double gust86_elem[GUST86_DIM];
 
 void GetGust86Coor(const double jd, const int body, double *xyz, double *xyzdot) {
 	double xyz6[6];
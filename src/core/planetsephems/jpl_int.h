@@ -35,6 +35,8 @@ struct interpolation_info
    unsigned n_posn_avail, n_vel_avail;
    };
 
+struct jpl_mapping;
+
 struct jpl_eph_data {
    double ephem_start, ephem_end, ephem_step;
    uint32_t ncon;
@@ -52,6 +54,10 @@ struct jpl_eph_data {
    double *cache;
    struct interpolation_info iinfo;
    FILE *ifile;
+               /* Set if the file is mapped into memory (see           */
+               /* jpl_init_ephemeris_mapped()).  'cache' then points   */
+               /* directly to the current record in the mapping.       */
+   struct jpl_mapping *mapping;
    };
 #pragma pack()
 
@@ -63,6 +63,9 @@ details of the implementation encapsulated.
 #include <stdint.h>
 
 #include "StelUtils.hpp"
+
+#include <QFile>
+#include <QAtomicInt>
 /**** include variable and type definitions, specific for this C version */
 
 #include "jpleph.h"
@@ -80,6 +83,28 @@ details of the implementation encapsulated.
 #endif
 
 
+/* A memory mapping of an ephemeris file.  It is shared by the handle   */
+/* which created it and all handles cloned from that handle,  and freed  */
+/* when the last of them is closed.  The mapping is only ever read,  so  */
+/* the handles can be used in different threads without locking.       */
+struct jpl_mapping
+{
+   QFile file;
+   const uchar *data;
+   qint64 size;
+   QAtomicInt ref;
+};
+
+/* Start of record nr in the mapping,  or NULL if the file is too short */
+static const uchar *jpl_mapped_record(const struct jpl_eph_data *eph, const uint32_t nr)
+{
+   /* Two blocks ahead to account for header: */
+   const qint64 offset = ((qint64)nr + 2) * (qint64)eph->recsize;
+   if(offset + (qint64)eph->ncoeff * (qint64)sizeof(double) > eph->mapping->size)
+      return(NULL);
+   return(eph->mapping->data + offset);
+}
+
 double DLL_FUNC jpl_get_double(const void *ephem, const int value)
 {
    return(*(double *)((char *)ephem + value));
@@ -603,7 +628,16 @@ int DLL_FUNC jpl_state(void *ephem, const double et, const int list[14],
 	}
 
 	/*   read correct record if not in core (static vector buf[])   */
-	if(nr != eph->curr_cache_loc)
+	if(nr != eph->curr_cache_loc && eph->mapping)
+	{
+		/* mapped file: just point to the record,  no copy needed */
+		const uchar *record = jpl_mapped_record(eph, nr);
+		if(!record)
+			return(JPL_EPH_READ_ERROR);
+		eph->curr_cache_loc = nr;
+		eph->cache = buf = (double *)record;
+	}
+	else if(nr != eph->curr_cache_loc)
 	{
 		eph->curr_cache_loc = nr;
 		/* Read two blocks ahead to account for header: */
@@ -891,6 +925,9 @@ void * DLL_FUNC jpl_init_ephemeris(const char *ephemeris_filename,
       return(NULL);
     }
     memcpy(rval, &temp_data, sizeof(struct jpl_eph_data));
+               /* The header doesn't set the mapping;  the file is read   */
+               /* unless jpl_init_ephemeris_mapped() maps it afterwards.  */
+    rval->mapping = NULL;
     rval->iinfo.posn_coeff[0] = 1.0;
             /* Seed a bogus value here.  The first and subsequent calls to */
             /* 'interp' will correct it to a value between -1 and +1.      */
@@ -957,10 +994,94 @@ void DLL_FUNC jpl_close_ephemeris(void *ephem)
 {
    struct jpl_eph_data *eph = (struct jpl_eph_data *)ephem;
 
-   fclose(eph->ifile);
+   if(eph->ifile)
+      fclose(eph->ifile);
+   if(eph->mapping && !eph->mapping->ref.deref())
+      delete eph->mapping;
    free(ephem);
 }
 
+/****************************************************************************
+**    jpl_init_ephemeris_mapped(ephemeris_filename, nam, val)             **
+*****************************************************************************
+**                                                                         **
+**    Same as jpl_init_ephemeris(),  but maps the whole file into memory.  **
+**    jpl_state() then interpolates directly from the mapped records       **
+**    instead of seeking and reading each record into the cache.          **
+**    If the file cannot be mapped (e.g. no address space left on 32 bit  **
+**    systems) or needs byte swapping,  the regular file reading is used.  **
+**    Use jpl_is_mapped() to find out which mode is in use.               **
+****************************************************************************/
+void * DLL_FUNC jpl_init_ephemeris_mapped(const char *ephemeris_filename,
+                          char nam[][6], double *val)
+{
+   struct jpl_eph_data *eph = (struct jpl_eph_data *)
+                        jpl_init_ephemeris(ephemeris_filename, nam, val);
+
+   if(!eph)
+      return(NULL);
+   if(eph->swap_bytes)
+   {
+      qDebug() << "jpl_init_ephemeris_mapped(): byte order differs, not mapping" << ephemeris_filename;
+      return(eph);
+   }
+
+   struct jpl_mapping *mapping = new struct jpl_mapping;
+   mapping->file.setFileName(QFile::decodeName(ephemeris_filename));
+   mapping->data = NULL;
+   mapping->size = 0;
+   if(mapping->file.open(QIODevice::ReadOnly))
+   {
+      mapping->size = mapping->file.size();
+      mapping->data = mapping->file.map(0, mapping->size);
+   }
+   if(!mapping->data)
+   {
+      qDebug() << "jpl_init_ephemeris_mapped(): cannot map" << ephemeris_filename << mapping->file.errorString();
+      delete mapping;
+      return(eph);
+   }
+   /* The mapping stays valid after closing the file. */
+   mapping->file.close();
+   mapping->ref = 1;
+   eph->mapping = mapping;
+   eph->curr_cache_loc = (uint32_t)-1;
+   fclose(eph->ifile);
+   eph->ifile = NULL;
+   return(eph);
+}
+
+/****************************************************************************
+**    jpl_clone_ephemeris(ephem)                                          **
+*****************************************************************************
+**                                                                         **
+**    Returns a new handle on a mapped ephemeris,  which shares the        **
+**    mapping but has its own interpolation state.  Use one handle per     **
+**    thread.  Returns NULL if ephem is not mapped.  Close the new handle  **
+**    with jpl_close_ephemeris().                                          **
+****************************************************************************/
+void * DLL_FUNC jpl_clone_ephemeris(const void *ephem)
+{
+   const struct jpl_eph_data *eph = (const struct jpl_eph_data *)ephem;
+   struct jpl_eph_data *rval;
+
+   if(!eph || !eph->mapping)
+      return(NULL);
+   rval = (struct jpl_eph_data *)malloc(sizeof(struct jpl_eph_data));
+   if(!rval)
+      return(NULL);
+   memcpy(rval, eph, sizeof(struct jpl_eph_data));
+   rval->mapping->ref.ref();
+   rval->curr_cache_loc = (uint32_t)-1;
+   rval->pvsun_t = -1e100;
+   return(rval);
+}
+
+int DLL_FUNC jpl_is_mapped(const void *ephem)
+{
+   return(ephem && ((const struct jpl_eph_data *)ephem)->mapping != NULL);
+}
+
 /* Added 2011 Jan 18:  random access to any desired JPL constant */
 
 
@@ -53,6 +53,10 @@ extern "C" {
 
 void * DLL_FUNC jpl_init_ephemeris( const char *ephemeris_filename,
                                              char nam[][6], double *val);
+void * DLL_FUNC jpl_init_ephemeris_mapped( const char *ephemeris_filename,
+                                             char nam[][6], double *val);
+void * DLL_FUNC jpl_clone_ephemeris( const void *ephem);
+int DLL_FUNC jpl_is_mapped( const void *ephem);
 void DLL_FUNC jpl_close_ephemeris( void *ephem);
 int DLL_FUNC jpl_state( void *ephem, const double et, const int list[14],
                           double pv[][6], double nut[4], const int bary);
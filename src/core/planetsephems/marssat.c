@@ -408,25 +408,25 @@ void GenerateMarsSatToVSOP87(double t,double mat_mars_sat_to_vsop87[9]) {
   }
 }
 
-static double t_0 = -1e100;
-static double t_1 = -1e100;
-static double t_2 = -1e100;
-static double marssat_elem_0[2*6];
-static double marssat_elem_1[2*6];
-static double marssat_elem_2[2*6];
+static EPHEM_THREAD_LOCAL double t_0 = -1e100;
+static EPHEM_THREAD_LOCAL double t_1 = -1e100;
+static EPHEM_THREAD_LOCAL double t_2 = -1e100;
+static EPHEM_THREAD_LOCAL double marssat_elem_0[2*6];
+static EPHEM_THREAD_LOCAL double marssat_elem_1[2*6];
+static EPHEM_THREAD_LOCAL double marssat_elem_2[2*6];
 
 /* 1 day: */
 #define DELTA_T 1.0
 
-static double marssat_jd0 = -1e100;
-static double marssat_elem[2*6];
+static EPHEM_THREAD_LOCAL double marssat_jd0 = -1e100;
+static EPHEM_THREAD_LOCAL double marssat_elem[2*6];
 
 static void CalcAllMarsSatElem(double t,double elem[12], void *user) {
   CalcMarsSatElem(t,0,elem+(0*6));
   CalcMarsSatElem(t,1,elem+(1*6));
 }
 
-static double mars_sat_to_vsop87[9];
+static EPHEM_THREAD_LOCAL double mars_sat_to_vsop87[9];
 
 void GetMarsSatCoor(double jd,int body,double *xyz, double *xyzdot) {
 	double xyz6[6];
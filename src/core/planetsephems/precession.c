@@ -33,6 +33,7 @@ Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
 
 #include <math.h>
 #include <assert.h>
+#include "calc_interpolated_elements.h" // EPHEM_THREAD_LOCAL
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846264338327950288
@@ -43,9 +44,9 @@ Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
 /* Interval threshold (days) for re-computing nutation values. with 1/24, compute only every hour  */
 #define NUTATION_EPOCH_THRESHOLD (1./24.)
 
-/* cache results for retrieval if recomputation is not required */
+/* cache results for retrieval if recomputation is not required. The caches are per thread. */
 
-static double c_psi_A=0.0, c_omega_A=0.0, c_chi_A=0.0, /*c_p_A=0.0, */ c_epsilon_A=0.0,
+static EPHEM_THREAD_LOCAL double c_psi_A=0.0, c_omega_A=0.0, c_chi_A=0.0, /*c_p_A=0.0, */ c_epsilon_A=0.0,
 		c_Y_A=0.0, c_X_A=0.0, c_Q_A=0.0, c_P_A=0.0,
 		c_lastJDE=-1e100;
 
@@ -374,10 +375,10 @@ static const struct nut2000B nut2000Btable[78] = {
 { -2,  0,  2,  4,  2,     7.35,      -1214,       0,      518,     0,      5,     2},
 { -1,  0,  4,  0,  2,     9.06,       1146,       0,     -490,     0,     -3,    -1}};
 
-/* cache results for retrieval if recomputation is not required */
-static double c_deltaEps=0.0;
-static double c_deltaPsi=0.0;
-static double c_jdeLastNut=-1e-100;
+/* cache results for retrieval if recomputation is not required. The caches are per thread. */
+static EPHEM_THREAD_LOCAL double c_deltaEps=0.0;
+static EPHEM_THREAD_LOCAL double c_deltaPsi=0.0;
+static EPHEM_THREAD_LOCAL double c_jdeLastNut=-1e-100;
 
 
 //! Compute and return nutation angles of the abridged IAU-2000B nutation.
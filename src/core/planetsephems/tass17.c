@@ -3143,17 +3143,17 @@ const double TASS17toJ2000[9] = {
 */
 
 #define TASS17_DIM (8*6)
-static double t_0 = -1e100;
-static double t_1 = -1e100;
-static double t_2 = -1e100;
-static double tass17_elem_0[TASS17_DIM];
-static double tass17_elem_1[TASS17_DIM];
-static double tass17_elem_2[TASS17_DIM];
+static EPHEM_THREAD_LOCAL double t_0 = -1e100;
+static EPHEM_THREAD_LOCAL double t_1 = -1e100;
+static EPHEM_THREAD_LOCAL double t_2 = -1e100;
+static EPHEM_THREAD_LOCAL double tass17_elem_0[TASS17_DIM];
+static EPHEM_THREAD_LOCAL double tass17_elem_1[TASS17_DIM];
+static EPHEM_THREAD_LOCAL double tass17_elem_2[TASS17_DIM];
 /* 1 day: */
 #define DELTA_T 1.0
 
-static double tass17_jd0 = -1e100;
-static double tass17_elem[TASS17_DIM];
+static EPHEM_THREAD_LOCAL double tass17_jd0 = -1e100;
+static EPHEM_THREAD_LOCAL double tass17_elem[TASS17_DIM];
 
 void CalcAllTass17Elem(const double t,double elem[TASS17_DIM], void *user)
 {
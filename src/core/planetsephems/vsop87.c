@@ -137317,38 +137317,46 @@ void CalcVsop87Elem(const double t,double elem[8*6], void *user) {
 */
 }
 
-/* dirty caching in static variables
-   If you ever want to allow parallel execution,
-   make a struct from these and malloc such structs and add pointer arguments to the calls as needed.
-*/
 #define VSOP87_DIM (8*6)
-static double t_0 = -1e100;
-static double t_1 = -1e100;
-static double t_2 = -1e100;
-static double vsop87_elem_0[VSOP87_DIM];
-static double vsop87_elem_1[VSOP87_DIM];
-static double vsop87_elem_2[VSOP87_DIM];
 /* 10 days: */
 #define DELTA_T (10.0/365250.0)
 
-static double vsop87_jd0 = -1e100;
-static double vsop87_elem[VSOP87_DIM];
+void InitVsop87Cache(struct Vsop87Cache *cache) {
+  cache->t_0 = -1e100;
+  cache->t_1 = -1e100;
+  cache->t_2 = -1e100;
+  cache->jd0 = -1e100;
+}
+
+/* cache for the functions without explicit cache argument.
+   These are not reentrant and must only be used from the main thread.
+*/
+static struct Vsop87Cache vsop87_static_cache = {-1e100,-1e100,-1e100,{0},{0},{0},-1e100,{0}};
 
 void GetVsop87Coor(double jd,int body,double *xyz) {
-  GetVsop87OsculatingCoor(jd,jd,body,xyz);
+  GetVsop87OsculatingCoorCached(&vsop87_static_cache,jd,jd,body,xyz);
 }
 
 void GetVsop87OsculatingCoor(const double jd0,const double jd,const int body,double *xyz) {
-  if (jd0 != vsop87_jd0) {
+  GetVsop87OsculatingCoorCached(&vsop87_static_cache,jd0,jd,body,xyz);
+}
+
+void GetVsop87CoorCached(struct Vsop87Cache *cache,double jd,int body,double *xyz) {
+  GetVsop87OsculatingCoorCached(cache,jd,jd,body,xyz);
+}
+
+void GetVsop87OsculatingCoorCached(struct Vsop87Cache *cache,
+                                   const double jd0,const double jd,const int body,double *xyz) {
+  if (jd0 != cache->jd0) {
 	const double t0 = (jd0 - 2451545.0) / 365250.0;
-	vsop87_jd0 = jd0;
-	CalcInterpolatedElements(t0,vsop87_elem,
+	cache->jd0 = jd0;
+	CalcInterpolatedElements(t0,cache->elem,
 							 VSOP87_DIM,
 							 &CalcVsop87Elem,DELTA_T,
-							 &t_0,vsop87_elem_0,
-							 &t_1,vsop87_elem_1,
-							 &t_2,vsop87_elem_2,
+							 &cache->t_0,cache->elem_0,
+							 &cache->t_1,cache->elem_1,
+							 &cache->t_2,cache->elem_2,
 							 0);
   }
-  EllipticToRectangularA(vsop87_mu[body],vsop87_elem+(body*6),jd-jd0,xyz);
+  EllipticToRectangularA(vsop87_mu[body],cache->elem+(body*6),jd-jd0,xyz);
 }
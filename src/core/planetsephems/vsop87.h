@@ -42,7 +42,9 @@ Furthermore I used the addition formulas
 so that for given T the functions cos and sin have only to be called 12 times.
 
 
-ATTENTION! Due to static caching this solution is not reentrant and cannot be parallelized to run in several threads.
+ATTENTION! The functions without explicit cache argument use a static cache
+and are therefore not reentrant. For computations in several threads use
+one struct Vsop87Cache per thread and the ...Cached() functions.
 
 ****************************************************************/
 
@@ -66,6 +68,28 @@ void GetVsop87OsculatingCoor(const double jd0,const double jd, const int body,do
   /* The oculating orbit of epoch jd0, evaluated at jd, is returned.
   */
 
+struct Vsop87Cache {
+  double t_0,t_1,t_2;
+  double elem_0[8*6];
+  double elem_1[8*6];
+  double elem_2[8*6];
+  double jd0;
+  double elem[8*6];
+};
+  /* Interpolation cache for the ...Cached() functions.
+     The contents belong to these functions, the user must only
+     initialize it with InitVsop87Cache() before the first use.
+  */
+
+void InitVsop87Cache(struct Vsop87Cache *cache);
+
+void GetVsop87CoorCached(struct Vsop87Cache *cache,double jd,int body,double *xyz);
+void GetVsop87OsculatingCoorCached(struct Vsop87Cache *cache,
+                                   const double jd0,const double jd,const int body,double *xyz);
+  /* Same as above, with the cache supplied by the caller.
+     These functions are reentrant as long as every thread uses its own cache.
+  */
+
 #ifdef __cplusplus
 }
 #endif
@@ -125,6 +125,10 @@ AstroCalcDialog::AstroCalcDialog(QObject* parent)
 	, graphPlotNeedsRefresh(false)
 {
 	ui = new Ui_astroCalcDialogForm;
+	phenomenaSearch = new PhenomenaSearch(this);
+	connect(phenomenaSearch, SIGNAL(resultsReady(int,QMap<double, double>)), this, SLOT(addPhenomenaResults(int,QMap<double, double>)));
+	connect(phenomenaSearch, SIGNAL(progressChanged(int,int)), this, SLOT(updatePhenomenaProgress(int,int)));
+	connect(phenomenaSearch, SIGNAL(finished(bool)), this, SLOT(finishPhenomena(bool)));
 	core = StelApp::getInstance().getCore();
 	solarSystem = GETSTELMODULE(SolarSystem);
 	dsoMgr = GETSTELMODULE(NebulaMgr);
@@ -2505,6 +2509,7 @@ void AstroCalcDialog::savePhenomenaCelestialGroup(int index)
 
 void AstroCalcDialog::cleanupPhenomena()
 {
+	phenomenaSearch->cancel();
 	ui->phenomenaTreeWidget->clear();
 	adjustPhenomenaColumns();
 }
@@ -3646,6 +3651,13 @@ void AstroCalcDialog::selectCurrentPhenomen(const QModelIndex& modelIndex)
 
 void AstroCalcDialog::calculatePhenomena()
 {
+	// The button cancels a running search
+	if (phenomenaSearch->isRunning())
+	{
+		phenomenaSearch->cancel();
+		return;
+	}
+
 	QString currentPlanet = ui->object1ComboBox->currentData().toString();
 	double separation = ui->allowedSeparationSpinBox->valueDegrees();
 	bool opposition = ui->phenomenaOppositionCheckBox->isChecked();
@@ -3820,9 +3832,11 @@ void AstroCalcDialog::calculatePhenomena()
 
 	PlanetP planet = solarSystem->searchByEnglishName(currentPlanet);
 	PlanetP sun = solarSystem->getSun();
+	phenomenaJobs.clear();
+	phenomenaSearchJobs.clear();
 	if (planet)
 	{
-		const double currentJD = core->getJD();   // save current JD
+		SolarSystem::PositionEvaluator evaluator(solarSystem, core);
 		double startJD = StelUtils::qDateTimeToJd(QDateTime(ui->phenomenFromDateEdit->date()));
 		double stopJD = StelUtils::qDateTimeToJd(QDateTime(ui->phenomenToDateEdit->date().addDays(1)));
 		startJD = startJD - core->getUTCOffset(startJD) / 24.;
@@ -3837,10 +3851,10 @@ void AstroCalcDialog::calculatePhenomena()
 				if (selectedObject!=planet && selectedObject->getType() != "Satellite")
 				{
 					// conjunction
-					fillPhenomenaTable(findClosestApproach(planet, selectedObject, startJD, stopJD, separation, PhenomenaTypeIndex::Conjuction), planet, selectedObject, PhenomenaTypeIndex::Conjuction);
+					addPhenomenaJob(evaluator, PhenomenaTypeIndex::Conjuction, planet, selectedObject, startJD, stopJD, separation, true);
 					// opposition
 					if (opposition)
-						fillPhenomenaTable(findClosestApproach(planet, selectedObject, startJD, stopJD, separation, PhenomenaTypeIndex::Opposition), planet, selectedObject, PhenomenaTypeIndex::Opposition);
+						addPhenomenaJob(evaluator, PhenomenaTypeIndex::Opposition, planet, selectedObject, startJD, stopJD, separation, true);
 				}
 			}
 		}
@@ -3851,10 +3865,10 @@ void AstroCalcDialog::calculatePhenomena()
 			{
 				// conjunction
 				StelObjectP mObj = qSharedPointerCast<StelObject>(obj);
-				fillPhenomenaTable(findClosestApproach(planet, mObj, startJD, stopJD, separation, PhenomenaTypeIndex::Conjuction), planet, obj, PhenomenaTypeIndex::Conjuction);
+				addPhenomenaJob(evaluator, PhenomenaTypeIndex::Conjuction, planet, mObj, startJD, stopJD, separation);
 				// opposition
 				if (opposition)
-					fillPhenomenaTable(findClosestApproach(planet, mObj, startJD, stopJD, separation, PhenomenaTypeIndex::Opposition), planet, obj, PhenomenaTypeIndex::Opposition);
+					addPhenomenaJob(evaluator, PhenomenaTypeIndex::Opposition, planet, mObj, startJD, stopJD, separation);
 			}
 		}
 		else if (obj2Type == 10 || obj2Type == 11 || obj2Type == 12)
@@ -3863,8 +3877,7 @@ void AstroCalcDialog::calculatePhenomena()
 			for (auto& obj : star)
 			{
 				// conjunction
-				StelObjectP mObj = qSharedPointerCast<StelObject>(obj);
-				fillPhenomenaTable(findClosestApproach(planet, mObj, startJD, stopJD, separation, PhenomenaTypeIndex::Conjuction), planet, obj, PhenomenaTypeIndex::Conjuction);
+				addPhenomenaJob(evaluator, PhenomenaTypeIndex::Conjuction, planet, obj, startJD, stopJD, separation);
 			}
 		}
 		else
@@ -3874,7 +3887,7 @@ void AstroCalcDialog::calculatePhenomena()
 			{
 				// conjunction
 				StelObjectP mObj = qSharedPointerCast<StelObject>(obj);
-				fillPhenomenaTable(findClosestApproach(planet, mObj, startJD, stopJD, separation, PhenomenaTypeIndex::Conjuction), planet, obj);
+				addPhenomenaJob(evaluator, PhenomenaTypeIndex::Conjuction, planet, mObj, startJD, stopJD, separation);
 			}
 		}
 
@@ -3884,23 +3897,64 @@ void AstroCalcDialog::calculatePhenomena()
 			if (planet->getHeliocentricEclipticPos().length()<core->getCurrentPlanet()->getHeliocentricEclipticPos().length())
 			{
 				// greatest elongations for inner planets
-				fillPhenomenaTable(findGreatestElongationApproach(planet, mObj, startJD, stopJD), planet, sun, PhenomenaTypeIndex::GreatestElongation);
+				addPhenomenaJob(evaluator, PhenomenaTypeIndex::GreatestElongation, planet, mObj, startJD, stopJD, separation);
 			}
 			// stationary points
-			fillPhenomenaTable(findStationaryPointApproach(planet, startJD, stopJD), planet, sun, PhenomenaTypeIndex::StationaryPoint);
+			addPhenomenaJob(evaluator, PhenomenaTypeIndex::StationaryPoint, planet, mObj, startJD, stopJD, separation);
 			// perihelion and aphelion points
 			if (perihelion)
-				fillPhenomenaTable(findOrbitalPointApproach(planet, startJD, stopJD), planet, sun, PhenomenaTypeIndex::OrbitalPoint);
+				addPhenomenaJob(evaluator, PhenomenaTypeIndex::OrbitalPoint, planet, mObj, startJD, stopJD, separation);
 		}
 
-		core->setJD(currentJD); // restore time
-		core->update(0);
+		if (!phenomenaSearchJobs.isEmpty())
+		{
+			phenomenaButtonText = ui->phenomenaPushButton->text();
+			phenomenaSearch->start(phenomenaSearchJobs, startJD, stopJD);
+			return;
+		}
 	}
 
+	// adjust the column width
+	adjustPhenomenaColumns();
+}
+
+void AstroCalcDialog::addPhenomenaResults(int job, const QMap<double, double>& results)
+{
+	if (job<0 || job>=phenomenaJobs.size())
+		return;
+
+	const PhenomenaJobInfo& info = phenomenaJobs.at(job);
+	const double currentJD = core->getJD();   // save current JD
+	PlanetP planet2 = info.anyObject ? PlanetP() : info.object2.dynamicCast<Planet>();
+	NebulaP nebula2 = info.anyObject ? NebulaP() : info.object2.dynamicCast<Nebula>();
+	if (planet2)
+		fillPhenomenaTable(results, info.object1, planet2, info.mode);
+	else if (nebula2)
+		fillPhenomenaTable(results, info.object1, nebula2);
+	else
+		fillPhenomenaTable(results, info.object1, info.object2, info.mode);
+	// Restore the time only: the next frame recomputes the positions anyway and finishPhenomena() updates the core once per search.
+	core->setJD(currentJD);
+
 	// adjust the column width
 	adjustPhenomenaColumns();
 	// sort-by-date
-	ui->phenomenaTreeWidget->sortItems(PhenomenaDate, Qt::AscendingOrder);	
+	ui->phenomenaTreeWidget->sortItems(PhenomenaDate, Qt::AscendingOrder);
+}
+
+void AstroCalcDialog::updatePhenomenaProgress(int done, int total)
+{
+	if (total>0)
+		ui->phenomenaPushButton->setText(QString("%1 (%2%)").arg(q_("Cancel")).arg(100*done/total));
+}
+
+void AstroCalcDialog::finishPhenomena(bool cancelled)
+{
+	Q_UNUSED(cancelled)
+	// The filled table rows have moved the planets to the dates of the events
+	core->update(0);
+	ui->phenomenaPushButton->setText(phenomenaButtonText);
+	adjustPhenomenaColumns();
 }
 
 void AstroCalcDialog::savePhenomena()
@@ -4406,521 +4460,80 @@ double AstroCalcDialog::findInitialStep(double startJD, double stopJD, QStringLi
 	return step;
 }
 
-QMap<double, double> AstroCalcDialog::findClosestApproach(PlanetP& object1, StelObjectP& object2, double startJD, double stopJD, double maxSeparation, int mode)
-{
-	double dist, prevDist, step, step0;
-	int sgn, prevSgn = 0;
-	QMap<double, double> separations;
-	QPair<double, double> extremum;
-
-	QStringList objects;
-	objects.clear();
-	objects.append(object1->getEnglishName());
-	objects.append(object2->getEnglishName());
-	step0 = findInitialStep(startJD, stopJD, objects);
-	step = step0;
-	double jd = startJD;
-	prevDist = findDistance(jd, object1, object2, mode);
-	jd += step;
-	while (jd <= stopJD)
-	{
-		dist = findDistance(jd, object1, object2, mode);
-		sgn = StelUtils::sign(dist - prevDist);
-
-		double factor = qAbs((dist - prevDist) / dist);
-		if (factor > 10.)
-			step = step0 * factor / 10.;
-		else
-			step = step0;
-
-		if (sgn != prevSgn && prevSgn == -1)
-		{
-			if (step > step0)
-			{
-				jd -= step;
-				step = step0;
-				sgn = prevSgn;
-				while (jd <= stopJD)
-				{
-					dist = findDistance(jd, object1, object2, mode);
-					sgn = StelUtils::sign(dist - prevDist);
-					if (sgn != prevSgn)
-						break;
-
-					prevDist = dist;
-					prevSgn = sgn;
-					jd += step;
-				}
-			}
-
-			if (findPrecise(&extremum, object1, object2, jd, step, sgn, mode))
-			{
-				double sep = extremum.second * 180. / M_PI;
-				if (sep < maxSeparation)
-					separations.insert(extremum.first, extremum.second);
-			}
-		}
-
-		prevDist = dist;
-		prevSgn = sgn;
-		jd += step;
-	}
-	return separations;
-}
-
-bool AstroCalcDialog::findPrecise(QPair<double, double>* out, PlanetP object1, StelObjectP object2, double JD, double step, int prevSign, int mode)
+namespace
 {
-	int sgn;
-	double dist, prevDist;
-
-	if (out == Q_NULLPTR)
-		return false;
-
-	prevDist = findDistance(JD, object1, object2, mode);
-	step = -step / 2.;
-	prevSign = -prevSign;
-
-	while (true)
+	//! Samples the positions for the phenomena searches. Every sampler has its own copy of the evaluator and thus its own ephemeris caches.
+	class PhenomenaSampler : public PhenomenaSearch::Sampler
 	{
-		JD += step;
-		dist = findDistance(JD, object1, object2, mode);
+	public:
+		PhenomenaSampler(const SolarSystem::PositionEvaluator& evaluator, const PlanetP& object1, const PlanetP& object2, const Vec3d& fixedPos)
+			: evaluator(evaluator), object1(object1), object2(object2), fixedPos(fixedPos) {}
 
-		if (qAbs(step) < 1. / 1440.)
+		virtual double angularDistance(double JD) Q_DECL_OVERRIDE
 		{
-			out->first = JD - step / 2.0;
-			out->second = findDistance(JD - step / 2.0, object1, object2, mode);
-			if (out->second < findDistance(JD - 5.0, object1, object2, mode))
-				return true;
-			else
-				return false;
+			const double JDE = evaluator.getJDE(JD);
+			return evaluator.getJ2000EquatorialPos(object1.data(), JDE).angle(getSecondPos(JDE));
 		}
-		sgn = StelUtils::sign(dist - prevDist);
-		if (sgn != prevSign)
+		virtual bool isEast(double JD) Q_DECL_OVERRIDE
 		{
-			step = -step / 2.0;
-			sgn = -sgn;
+			const double JDE = evaluator.getJDE(JD);
+			return evaluator.getJ2000EquatorialPos(object1.data(), JDE).longitude()>getSecondPos(JDE).longitude();
 		}
-		prevDist = dist;
-		prevSign = sgn;
-	}
-}
-
-double AstroCalcDialog::findDistance(double JD, PlanetP object1, StelObjectP object2, int mode)
-{
-	core->setJD(JD);
-	core->update(0);
-	double angle = object1->getJ2000EquatorialPos(core).angle(object2->getJ2000EquatorialPos(core));
-	if (mode==PhenomenaTypeIndex::Opposition)
-		angle = M_PI - angle;	
-	return angle;
-}
-
-QMap<double, double> AstroCalcDialog::findGreatestElongationApproach(PlanetP& object1, StelObjectP& object2, double startJD, double stopJD)
-{
-	double dist, prevDist, step, step0;
-	QMap<double, double> separations;
-	QPair<double, double> extremum;
-
-	QStringList objects;
-	objects.clear();
-	objects.append(object1->getEnglishName());
-	objects.append(object2->getEnglishName());
-	step0 = findInitialStep(startJD, stopJD, objects);
-	step = step0;
-	double jd = startJD;
-	prevDist = findDistance(jd, object1, object2, PhenomenaTypeIndex::Conjuction);
-	jd += step;
-	while (jd <= stopJD)
-	{
-		dist = findDistance(jd, object1, object2, PhenomenaTypeIndex::Conjuction);
-		double factor = qAbs((dist - prevDist) / dist);
-		if (factor > 10.)
-			step = step0 * factor / 10.;
-		else
-			step = step0;
-
-		if (dist>prevDist)
+		virtual double rightAscension(double JD) Q_DECL_OVERRIDE
 		{
-			if (step > step0)
-			{
-				jd -= step;
-				step = step0;
-				while (jd <= stopJD)
-				{
-					dist = findDistance(jd, object1, object2, PhenomenaTypeIndex::Conjuction);
-					if (dist<prevDist)
-						break;
-
-					prevDist = dist;
-					jd += step;
-				}
-			}
-
-			if (findPreciseGreatestElongation(&extremum, object1, object2, jd, stopJD, step))
-			{
-				separations.insert(extremum.first, extremum.second);
-			}
-		}
-
-		prevDist = dist;
-		jd += step;
-	}
-	return separations;
-}
-
-bool AstroCalcDialog::findPreciseGreatestElongation(QPair<double, double>* out, PlanetP object1, StelObjectP object2, double JD, double stopJD, double step)
-{
-	double dist, prevDist;
-
-	if (out == Q_NULLPTR)
-		return false;
-
-	prevDist = findDistance(JD, object1, object2, PhenomenaTypeIndex::Conjuction);
-	step = -step / 2.;
-
-	while (true)
-	{
-		JD += step;
-		dist = findDistance(JD, object1, object2, PhenomenaTypeIndex::Conjuction);
-
-		if (qAbs(step) < 1. / 1440.)
-		{
-			out->first = JD - step / 2.0;
-			out->second = findDistance(JD - step / 2.0, object1, object2, PhenomenaTypeIndex::Conjuction);
-			if (out->second > findDistance(JD - 5.0, object1, object2, PhenomenaTypeIndex::Conjuction))
-			{
-				if (object1->getJ2000EquatorialPos(core).longitude()>object2->getJ2000EquatorialPos(core).longitude())
-					out->second *= -1.0; // let's use negative value for eastern elongations
-				return true;
-			}
-			else
-				return false;
-		}
-		if (dist<prevDist)
-		{
-			step = -step / 2.0;
-		}
-		prevDist = dist;
-
-		if (JD > stopJD)
-			return false;
-	}
-}
-
-QMap<double, double> AstroCalcDialog::findStationaryPointApproach(PlanetP &object1, double startJD, double stopJD)
-{
-	double RA, prevRA, step, step0;
-	QMap<double, double> separations;
-	QPair<double, double> extremum;
-
-	QStringList objects;
-	objects.clear();
-	objects.append(object1->getEnglishName());
-	step0 = findInitialStep(startJD, stopJD, objects);
-	step = step0;
-	double jd = startJD;
-	prevRA = findRightAscension(jd, object1);
-	jd += step;
-	while (jd <= stopJD)
-	{
-		RA = findRightAscension(jd, object1);
-		double factor = qAbs((RA - prevRA) / RA);
-		if (factor > 10.)
-			step = step0 * factor / 10.;
-		else
-			step = step0;
-
-		if (RA>prevRA && qAbs(RA - prevRA)<180.)
-		{
-			if (step > step0)
-			{
-				jd -= step;
-				step = step0;
-				while (jd <= stopJD)
-				{
-					RA = findRightAscension(jd, object1);
-					if (RA<prevRA)
-						break;
-
-					prevRA = RA;
-					jd += step;
-				}
-			}
-
-			if (findPreciseStationaryPoint(&extremum, object1, jd, stopJD, step, true))
-			{
-				separations.insert(extremum.first, extremum.second);
-			}
+			double ra, dec;
+			StelUtils::rectToSphe(&ra, &dec, evaluator.getJ2000EquatorialPos(object1.data(), evaluator.getJDE(JD)));
+			return ra*M_180_PI;
 		}
-		prevRA = RA;
-		jd += step;
-	}
-
-	step0 = findInitialStep(startJD, stopJD, objects);
-	step = step0;
-	jd = startJD;
-	prevRA = findRightAscension(jd, object1);
-	jd += step;
-	while (jd <= stopJD)
-	{
-		RA = findRightAscension(jd, object1);
-		double factor = qAbs((RA - prevRA) / RA);
-		if (factor > 10.)
-			step = step0 * factor / 10.;
-		else
-			step = step0;
-
-		if (RA<prevRA && qAbs(RA - prevRA)<180.)
+		virtual double heliocentricDistance(double JD) Q_DECL_OVERRIDE
 		{
-			if (step > step0)
-			{
-				jd -= step;
-				step = step0;
-				while (jd <= stopJD)
-				{
-					RA = findRightAscension(jd, object1);
-					if (RA>prevRA)
-						break;
-
-					prevRA = RA;
-					jd += step;
-				}
-			}
-
-			if (findPreciseStationaryPoint(&extremum, object1, jd, stopJD, step, false))
-			{
-				separations.insert(extremum.first, extremum.second);
-			}
+			return evaluator.getHeliocentricEclipticPos(object1.data(), evaluator.getJDE(JD)).length();
 		}
-		prevRA = RA;
-		jd += step;
-	}
-
-	return separations;
-}
-
-bool AstroCalcDialog::findPreciseStationaryPoint(QPair<double, double> *out, PlanetP object, double JD, double stopJD, double step, bool retrograde)
-{
-	double RA, prevRA;
-
-	if (out == Q_NULLPTR)
-		return false;
-
-	prevRA = findRightAscension(JD, object);
-	step = -step / 2.;
 
-	while (true)
-	{
-		JD += step;
-		RA = findRightAscension(JD, object);
-
-		if (qAbs(step) < 1. / 1440.)
-		{
-			out->first = JD - step / 2.0;
-			out->second = findRightAscension(JD - step / 2.0, object);
-			if (retrograde) // begin retrograde motion
-			{
-				if (out->second > findRightAscension(JD - 5.0, object))
-				{
-					out->second = -1.0;
-					return true;
-				}
-				else
-					return false;
-			}
-			else
-			{
-				if (out->second < findRightAscension(JD - 5.0, object))
-				{
-					out->second = 1.0;
-					return true;
-				}
-				else
-					return false;
-			}
-		}
-		if (retrograde)
-		{
-			if (RA<prevRA)
-				step = -step / 2.0;
-		}
-		else
+	private:
+		Vec3d getSecondPos(double JDE)
 		{
-			if (RA>prevRA)
-				step = -step / 2.0;
+			return object2 ? evaluator.getJ2000EquatorialPos(object2.data(), JDE) : fixedPos;
 		}
-		prevRA = RA;
-
-		if (JD > stopJD)
-			return false;
-	}
-}
 
-double AstroCalcDialog::findRightAscension(double JD, PlanetP object)
-{
-	core->setJD(JD);
-	core->update(0);
-	double ra, dec;
-	StelUtils::rectToSphe(&ra, &dec, object->getJ2000EquatorialPos(core));
-	return ra*M_180_PI;
+		SolarSystem::PositionEvaluator evaluator;
+		PlanetP object1;
+		PlanetP object2;
+		Vec3d fixedPos;
+	};
 }
 
-QMap<double, double> AstroCalcDialog::findOrbitalPointApproach(PlanetP &object1, double startJD, double stopJD)
+void AstroCalcDialog::addPhenomenaJob(const SolarSystem::PositionEvaluator& evaluator, int mode, PlanetP object1, StelObjectP object2, double startJD, double stopJD, double maxSeparation, bool anyObject)
 {
-	double distance, prevDistance, step, step0;
-	QMap<double, double> separations;
-	QPair<double, double> extremum;
-
 	QStringList objects;
-	objects.clear();
 	objects.append(object1->getEnglishName());
-	step0 = findInitialStep(startJD, stopJD, objects);
-	step = step0;
-	double jd = startJD - step;
-	prevDistance = findRightAscension(jd, object1);
-	jd += step;
-	double stopJDfx = stopJD + step;
-	while (jd <= stopJDfx)
-	{
-		distance = findHeliocentricDistance(jd, object1);
-		double factor = qAbs((distance - prevDistance) / distance);
-		if (factor > 10.)
-			step = step0 * factor / 10.;
-		else
-			step = step0;
-
-		if (distance>prevDistance)
-		{
-			if (step > step0)
-			{
-				jd -= step;
-				step = step0;
-				while (jd <= stopJDfx)
-				{
-					distance = findHeliocentricDistance(jd, object1);
-					if (distance<prevDistance)
-						break;
-
-					prevDistance = distance;
-					jd += step;
-				}
-			}
-
-			if (findPreciseOrbitalPoint(&extremum, object1, jd, stopJDfx, step, false))
-			{
-				if (extremum.first>startJD && extremum.first<stopJD)
-					separations.insert(extremum.first, extremum.second);
-			}
-		}
-
-		prevDistance = distance;
-		jd += step;
-	}
-
-	step0 = findInitialStep(startJD, stopJD, objects);
-	step = step0;
-	jd = startJD - step;
-	prevDistance = findRightAscension(jd, object1);
-	jd += step;
-	while (jd <= stopJDfx)
-	{
-		distance = findHeliocentricDistance(jd, object1);
-		double factor = qAbs((distance - prevDistance) / distance);
-		if (factor > 10.)
-			step = step0 * factor / 10.;
-		else
-			step = step0;
-
-		if (distance<prevDistance)
-		{
-			if (step > step0)
-			{
-				jd -= step;
-				step = step0;
-				while (jd <= stopJDfx)
-				{
-					distance = findHeliocentricDistance(jd, object1);
-					if (distance>prevDistance)
-						break;
-
-					prevDistance = distance;
-					jd += step;
-				}
-			}
-
-			if (findPreciseOrbitalPoint(&extremum, object1, jd, stopJDfx, step, true))
-			{
-				if (extremum.first>startJD && extremum.first<stopJD)
-					separations.insert(extremum.first, extremum.second);
-			}
-		}
-
-		prevDistance = distance;
-		jd += step;
-	}
-
-	return separations;
-}
-
-bool AstroCalcDialog::findPreciseOrbitalPoint(QPair<double, double>* out, PlanetP object1, double JD, double stopJD, double step, bool minimal)
-{
-	double dist, prevDist;
-
-	if (out == Q_NULLPTR)
-		return false;
-
-	prevDist = findHeliocentricDistance(JD, object1);
-	step = -step / 2.;
-
-	while (true)
-	{
-		JD += step;
-		dist = findHeliocentricDistance(JD, object1);
-
-		if (qAbs(step) < 1. / 1440.)
-		{
-			out->first = JD - step / 2.0;
-			out->second = findHeliocentricDistance(JD - step / 2.0, object1);
-			if (minimal)
-			{
-				if (out->second > findHeliocentricDistance(JD - step / 5.0, object1))
-				{
-					out->second *= -1;
-					return true;
-				}
-				else
-					return false;
-			}
-			else
-			{
-				if (out->second < findHeliocentricDistance(JD - step / 5.0, object1))
-					return true;
-				else
-					return false;
-			}
-		}
-		if (minimal)
-		{
-			if (dist>prevDist)
-				step = -step / 2.0;
-		}
-		else
-		{
-			if (dist<prevDist)
-				step = -step / 2.0;
-		}
-		prevDist = dist;
-
-		if (JD > stopJD)
-			return false;
-	}
-}
+	if (mode==PhenomenaTypeIndex::Conjuction || mode==PhenomenaTypeIndex::Opposition || mode==PhenomenaTypeIndex::GreatestElongation)
+		objects.append(object2->getEnglishName());
+
+	// Objects outside the solar system are not thread-safe: take their position now.
+	PlanetP planet2 = object2.dynamicCast<Planet>();
+	Vec3d fixedPos(0.);
+	if (!planet2)
+		fixedPos = object2->getJ2000EquatorialPos(core);
+
+	// The copy of the evaluator is shared by all shards of the job and only read by them.
+	QSharedPointer<SolarSystem::PositionEvaluator> settings(new SolarSystem::PositionEvaluator(evaluator));
+
+	PhenomenaSearch::Job job;
+	job.kind = static_cast<PhenomenaSearch::Kind>(mode);
+	job.step = findInitialStep(startJD, stopJD, objects);
+	job.maxSeparation = maxSeparation;
+	job.createSampler = [settings, object1, planet2, fixedPos]() {
+		return PhenomenaSearch::SamplerP(new PhenomenaSampler(*settings, object1, planet2, fixedPos));
+	};
 
-double AstroCalcDialog::findHeliocentricDistance(double JD, PlanetP object1)
-{
-	core->setJD(JD);
-	core->update(0);
-	return object1->getHeliocentricEclipticPos().length();
+	PhenomenaJobInfo info;
+	info.object1 = object1;
+	info.object2 = object2;
+	info.mode = mode;
+	info.anyObject = anyObject;
+	phenomenaJobs.append(info);
+	phenomenaSearchJobs.append(job);
 }
 
 void AstroCalcDialog::changePage(QListWidgetItem* current, QListWidgetItem* previous)
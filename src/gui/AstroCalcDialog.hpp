@@ -32,6 +32,7 @@
 #include "StelCore.hpp"
 #include "Planet.hpp"
 #include "SolarSystem.hpp"
+#include "PhenomenaSearch.hpp"
 #include "Nebula.hpp"
 #include "NebulaMgr.hpp"
 #include "StelPropertyMgr.hpp"
@@ -207,6 +208,10 @@ private slots:
 	//! Calculating phenomena for selected celestial body and fill the list.
 	void calculatePhenomena();
 	void cleanupPhenomena();
+	//! Add the results of a background phenomena search to the list.
+	void addPhenomenaResults(int job, const QMap<double, double>& results);
+	void updatePhenomenaProgress(int done, int total);
+	void finishPhenomena(bool cancelled);
 	void selectCurrentPhenomen(const QModelIndex &modelIndex);
 	void savePhenomena();
 	void savePhenomenaAngularSeparation();
@@ -375,10 +380,12 @@ private:
 	//! angular separation ("conjunction" defined as equality of right ascension
 	//! of two body) and current solution is not accurate and slow.	
 	//! @note modes: 0 - conjuction, 1 - opposition, 2 - greatest elongation
-	QMap<double, double> findClosestApproach(PlanetP& object1, StelObjectP& object2, double startJD, double stopJD, double maxSeparation, int mode);
-	double findDistance(double JD, PlanetP object1, StelObjectP object2, int mode);
+	//! @note The searches run in the background with PhenomenaSearch, the results are added to the table as they arrive.
+	//! Positions are computed with copies of a SolarSystem::PositionEvaluator and leave the date of the core untouched.
+	//! Stars and DSO are taken at their position for the current date.
+	//! @param anyObject fill the table as for an arbitrary selected object, even if object2 is a planet or DSO
+	void addPhenomenaJob(const SolarSystem::PositionEvaluator& evaluator, int mode, PlanetP object1, StelObjectP object2, double startJD, double stopJD, double maxSeparation, bool anyObject=false);
 	double findInitialStep(double startJD, double stopJD, QStringList objects);
-	bool findPrecise(QPair<double, double>* out, PlanetP object1, StelObjectP object2, double JD, double step, int prevSign, int mode);
 	void fillPhenomenaTable(const QMap<double, double> list, const PlanetP object1, const StelObjectP object2, int mode);
 	void fillPhenomenaTable(const QMap<double, double> list, const PlanetP object1, const NebulaP object2);
 	//! @note modes: 0 - conjuction, 1 - opposition, 2 - greatest elongation
@@ -386,17 +393,19 @@ private:
 	void fillPhenomenaTableVis(QString phenomenType, double JD, QString firstObjectName, float firstObjectMagnitude,
 				   QString secondObjectName, float secondObjectMagnitude, QString separation, QString elevation,
 				   QString elongation, QString angularDistance, QString elongTooltip="", QString angDistTooltip="");
-	//! Calculation greatest elongations
-	QMap<double, double> findGreatestElongationApproach(PlanetP& object1, StelObjectP& object2, double startJD, double stopJD);
-	bool findPreciseGreatestElongation(QPair<double, double>* out, PlanetP object1, StelObjectP object2, double JD, double stopJD, double step);
-	//! Calculation stationary points
-	QMap<double, double> findStationaryPointApproach(PlanetP& object1, double startJD, double stopJD);
-	bool findPreciseStationaryPoint(QPair<double, double>* out, PlanetP object, double JD, double stopJD, double step, bool retrograde);
-	double findRightAscension(double JD, PlanetP object);
-	//! Calculation perihelion and aphelion points
-	QMap<double, double> findOrbitalPointApproach(PlanetP& object1, double startJD, double stopJD);
-	bool findPreciseOrbitalPoint(QPair<double, double>* out, PlanetP object1, double JD, double stopJD, double step, bool minimal);
-	double findHeliocentricDistance(double JD, PlanetP object1);
+
+	//! The objects of a phenomena search job, to pick the right fillPhenomenaTable() for its results
+	struct PhenomenaJobInfo
+	{
+		PlanetP object1;
+		StelObjectP object2;
+		int mode;
+		bool anyObject;
+	};
+	PhenomenaSearch* phenomenaSearch;
+	QVector<PhenomenaSearch::Job> phenomenaSearchJobs;
+	QVector<PhenomenaJobInfo> phenomenaJobs;
+	QString phenomenaButtonText;
 
 	bool plotAltVsTime, plotAltVsTimeSun, plotAltVsTimeMoon, plotAltVsTimePositive, plotMonthlyElevation, plotMonthlyElevationPositive, plotDistanceGraph, plotAngularDistanceGraph, plotAziVsTime;
 	int altVsTimePositiveLimit, monthlyElevationPositiveLimit, graphsDuration;
@@ -47,6 +47,7 @@
 
 #include "StelObject.hpp"
 #include "StelObjectMgr.hpp"
+#include "StelProfiler.hpp"
 #include "StelProjector.hpp"
 #include "StelSkyCultureMgr.hpp"
 #include "StelSkyDrawer.hpp"
@@ -327,6 +328,16 @@ float StelMainScriptAPI::getMaxFps()
 	return StelMainView::getInstance().getMaxFps();
 }
 
+QVariantMap StelMainScriptAPI::getProfilerStatistics()
+{
+	return StelApp::getInstance().getProfiler()->getStatistics();
+}
+
+void StelMainScriptAPI::dumpProfilerTrace(int frames, const QString& fileName)
+{
+	StelApp::getInstance().getProfiler()->startTrace(frames, fileName);
+}
+
 QString StelMainScriptAPI::getMountMode()
 {
 	if (GETSTELMODULE(StelMovementMgr)->getMountMode() == StelMovementMgr::MountEquinoxEquatorial)
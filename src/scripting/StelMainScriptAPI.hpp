@@ -416,6 +416,18 @@ public slots:
 	//! @return The current maximum frames per second setting.
 	static float getMaxFps();
 
+	//! Get the frame profiler statistics of the modules.
+	//! The profiler is enabled with core.setProperty("StelProfiler.enabled", true).
+	//! @return a map with the number of profiled frames ("frames") and a list of "scopes", each with its
+	//! "path", "name", "depth", mean "calls" per frame and "mean", "min", "max" and "p95" time per frame in ms.
+	static QVariantMap getProfilerStatistics();
+
+	//! Record the next frames with the profiler and write them as a Chrome trace JSON file,
+	//! which can be opened in chrome://tracing. This enables the profiler.
+	//! @param frames the number of frames to record.
+	//! @param fileName the output file, relative to the user directory. The default is trace.json.
+	static void dumpProfilerTrace(int frames, const QString& fileName="");
+
 	//! Get the mount mode as a string
 	//! @return "equatorial" or "azimuthal"
 	static QString getMountMode();
@@ -0,0 +1,253 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testBatchEphemeris.hpp"
+
+#include <QBuffer>
+#include <QDataStream>
+#include <QThread>
+#include <cmath>
+
+#include "BatchEphemeris.hpp"
+#include "StelUtils.hpp"
+
+QTEST_GUILESS_MAIN(TestBatchEphemeris)
+
+Q_DECLARE_METATYPE(BatchEphemeris::Format)
+
+static const double startJD = 2458849.5;
+
+namespace
+{
+	//! Bodies moving along circles, body b at RA 15+30b+10t degrees (t in days since startJD), declination 10(b-1) degrees and distance 1+b AU.
+	//! Sampling slows down for the first dates, so that the early chunks finish last.
+	class SyntheticSource : public BatchEphemeris::Source
+	{
+	public:
+		SyntheticSource(int bodies, bool slowStart) : bodies(bodies), slowStart(slowStart) {}
+		virtual void compute(double JD, Vec3d* positions, double* heliocentricDistances) Q_DECL_OVERRIDE
+		{
+			if (slowStart && JD < startJD + 0.1)
+				QThread::usleep(500);
+			for (int b=0; b<bodies; ++b)
+			{
+				double ra, dec, distance, heliocentricDistance;
+				expected(b, JD, &ra, &dec, &distance, &heliocentricDistance);
+				StelUtils::spheToRect(ra*M_PI_180, dec*M_PI_180, positions[b]);
+				positions[b] *= distance;
+				heliocentricDistances[b] = heliocentricDistance;
+			}
+		}
+
+		//! The values of body b at JD, angles in degrees
+		static void expected(int b, double JD, double* ra, double* dec, double* distance, double* heliocentricDistance)
+		{
+			*ra = StelUtils::fmodpos(15. + 30.*b + 10.*(JD - startJD), 360.);
+			*dec = 10.*(b - 1);
+			*distance = 1. + b;
+			*heliocentricDistance = 2. + b + 0.01*(JD - startJD);
+		}
+
+	private:
+		int bodies;
+		bool slowStart;
+	};
+
+	BatchEphemeris* makeBatch(const QStringList& names, bool slowStart=false)
+	{
+		const int bodies = names.size();
+		return new BatchEphemeris(names, [bodies, slowStart]() {
+			return BatchEphemeris::SourceP(new SyntheticSource(bodies, slowStart));
+		});
+	}
+
+	const QStringList names = QStringList() << "Mercury" << "Venus" << "Mars";
+}
+
+void TestBatchEphemeris::testRowCount_data()
+{
+	QTest::addColumn<double>("stopJD");
+	QTest::addColumn<double>("step");
+	QTest::addColumn<int>("dates");
+
+	// The stop date is included, also when the division by the step rounds down.
+	QTest::newRow("one day in minutes") << startJD + 1. << 1./1440. << 1441;
+	QTest::newRow("one day in hours") << startJD + 1. << 1./24. << 25;
+	QTest::newRow("stop between steps") << startJD + 1.01 << 1./24. << 25;
+	QTest::newRow("ten years in days") << startJD + 3652.5 << 0.5 << 7306;
+	QTest::newRow("single date") << startJD << 1. << 1;
+	QTest::newRow("stop before start") << startJD - 1. << 1. << 0;
+}
+
+void TestBatchEphemeris::testRowCount()
+{
+	QFETCH(double, stopJD);
+	QFETCH(double, step);
+	QFETCH(int, dates);
+
+	QScopedPointer<BatchEphemeris> batch(makeBatch(names));
+	batch->setRange(startJD, stopJD, step);
+	QCOMPARE(batch->rowCount(), qint64(dates)*names.size());
+	if (dates==0)
+		return;
+
+	batch->setFormat(BatchEphemeris::Binary);
+	batch->setChunkSize(100);
+	QCOMPARE(batch->write(Q_NULLPTR), qint64(dates)*names.size());
+}
+
+void TestBatchEphemeris::testCsv()
+{
+	QScopedPointer<BatchEphemeris> batch(makeBatch(names, true));
+	const double step = 1./1440.;
+	const int dates = 601;
+	batch->setRange(startJD, startJD + (dates-1)*step, step);
+	batch->setFormat(BatchEphemeris::Csv);
+	batch->setChunkSize(7);
+	batch->setThreadCount(4);
+
+	QBuffer buffer;
+	buffer.open(QIODevice::WriteOnly);
+	QCOMPARE(batch->write(&buffer), qint64(dates)*names.size());
+
+	const QList<QByteArray> lines = buffer.data().split('\n');
+	// header, one line per row and the empty string after the last newline
+	QCOMPARE(lines.size(), dates*names.size() + 2);
+	QCOMPARE(lines.first(), QByteArray("jd,object,ra_j2000,dec_j2000,distance,heliocentric_distance"));
+	QVERIFY(lines.last().isEmpty());
+
+	// Rows are ordered by date and then by body, whatever the order in which the chunks were computed.
+	for (int i=0; i<dates; ++i)
+	{
+		const double JD = startJD + i*step;
+		for (int b=0; b<names.size(); ++b)
+		{
+			const QList<QByteArray> fields = lines.at(1 + i*names.size() + b).split(',');
+			QCOMPARE(fields.size(), 6);
+			QVERIFY2(qAbs(fields.at(0).toDouble() - JD) < 1e-6, fields.at(0).constData());
+			QCOMPARE(QString(fields.at(1)), names.at(b));
+			double ra, dec, distance, heliocentricDistance;
+			SyntheticSource::expected(b, JD, &ra, &dec, &distance, &heliocentricDistance);
+			QVERIFY(qAbs(fields.at(2).toDouble() - ra) < 2e-6);
+			QVERIFY(qAbs(fields.at(3).toDouble() - dec) < 2e-6);
+			QVERIFY(qAbs(fields.at(4).toDouble() - distance) < 2e-9);
+			QVERIFY(qAbs(fields.at(5).toDouble() - heliocentricDistance) < 2e-9);
+		}
+	}
+}
+
+void TestBatchEphemeris::testBinary()
+{
+	QScopedPointer<BatchEphemeris> batch(makeBatch(names, true));
+	const double step = 1./1440.;
+	const int dates = 601;
+	const int chunkSize = 7;
+	batch->setRange(startJD, startJD + (dates-1)*step, step);
+	batch->setFormat(BatchEphemeris::Binary);
+	batch->setChunkSize(chunkSize);
+	batch->setThreadCount(4);
+
+	QBuffer buffer;
+	buffer.open(QIODevice::WriteOnly);
+	QCOMPARE(batch->write(&buffer), qint64(dates)*names.size());
+
+	QDataStream in(buffer.data());
+	in.setByteOrder(QDataStream::LittleEndian);
+	in.setFloatingPointPrecision(QDataStream::DoublePrecision);
+
+	char magic[8];
+	QCOMPARE(in.readRawData(magic, 8), 8);
+	QCOMPARE(QByteArray(magic, 8), QByteArray("STELEPHB"));
+	quint32 version, bodies;
+	in >> version >> bodies;
+	QCOMPARE(version, quint32(1));
+	QCOMPARE(bodies, quint32(names.size()));
+	for (const auto& name : names)
+	{
+		quint32 length;
+		in >> length;
+		QByteArray utf8(static_cast<int>(length), '\0');
+		QCOMPARE(in.readRawData(utf8.data(), static_cast<int>(length)), static_cast<int>(length));
+		QCOMPARE(QString::fromUtf8(utf8), name);
+	}
+
+	// One block per chunk, in date order
+	int date = 0;
+	while (!in.atEnd())
+	{
+		quint32 n;
+		in >> n;
+		QCOMPARE(n, quint32(qMin(chunkSize, dates - date)));
+		QVector<double> jds(static_cast<int>(n));
+		for (auto& jd : jds)
+			in >> jd;
+		for (quint32 i=0; i<n; ++i)
+			QCOMPARE(jds.at(static_cast<int>(i)), startJD + (date + static_cast<int>(i))*step);
+		for (quint32 b=0; b<bodies; ++b)
+		{
+			QVector<double> columns(4*static_cast<int>(n));
+			for (auto& v : columns)
+				in >> v;
+			for (quint32 i=0; i<n; ++i)
+			{
+				double ra, dec, distance, heliocentricDistance;
+				SyntheticSource::expected(static_cast<int>(b), jds.at(static_cast<int>(i)), &ra, &dec, &distance, &heliocentricDistance);
+				QVERIFY(qAbs(columns.at(static_cast<int>(i)) - ra) < 1e-9);
+				QVERIFY(qAbs(columns.at(static_cast<int>(n + i)) - dec) < 1e-9);
+				QVERIFY(qAbs(columns.at(static_cast<int>(2*n + i)) - distance) < 1e-12);
+				QCOMPARE(columns.at(static_cast<int>(3*n + i)), heliocentricDistance);
+			}
+		}
+		QCOMPARE(in.status(), QDataStream::Ok);
+		date += static_cast<int>(n);
+	}
+	QCOMPARE(date, dates);
+}
+
+void TestBatchEphemeris::testEmpty()
+{
+	QScopedPointer<BatchEphemeris> batch(makeBatch(QStringList()));
+	batch->setRange(startJD, startJD + 1., 1.);
+	QCOMPARE(batch->write(Q_NULLPTR), qint64(-1));
+	QVERIFY(!batch->errorString().isEmpty());
+}
+
+void TestBatchEphemeris::benchmarkWrite_data()
+{
+	QTest::addColumn<BatchEphemeris::Format>("format");
+	QTest::newRow("CSV") << BatchEphemeris::Csv;
+	QTest::newRow("binary") << BatchEphemeris::Binary;
+}
+
+void TestBatchEphemeris::benchmarkWrite()
+{
+	QFETCH(BatchEphemeris::Format, format);
+
+	QStringList bodies;
+	for (int i=0; i<30; ++i)
+		bodies << QString("Body %1").arg(i);
+	QScopedPointer<BatchEphemeris> batch(makeBatch(bodies));
+	// 30 days in steps of one minute
+	batch->setRange(startJD, startJD + 30., 1./1440.);
+	batch->setFormat(format);
+
+	QBENCHMARK {
+		batch->write(Q_NULLPTR);
+	}
+}
@@ -0,0 +1,137 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testEphemerisContext.hpp"
+
+#include <QDebug>
+#include <QFile>
+#include <QFuture>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <cstring>
+
+#include "StelFileMgr.hpp"
+#include "EphemWrapper.hpp"
+
+QTEST_GUILESS_MAIN(TestEphemerisContext)
+
+typedef void (*CoordFunc)(double, double*, double*, void*);
+
+static const CoordFunc coordFuncs[] = {
+	&get_mercury_helio_coordsv,
+	&get_venus_helio_coordsv,
+	&get_earth_helio_coordsv,
+	&get_mars_helio_coordsv,
+	&get_jupiter_helio_coordsv,
+	&get_saturn_helio_coordsv,
+	&get_uranus_helio_coordsv,
+	&get_neptune_helio_coordsv,
+	&get_pluto_helio_coordsv,
+	&get_lunar_parent_coordsv
+};
+static const int coordFuncCount = sizeof(coordFuncs)/sizeof(coordFuncs[0]);
+static const int dateCount = 2000;
+
+void TestEphemerisContext::initTestCase()
+{
+	StelFileMgr::init();
+
+	de430FilePath = StelFileMgr::findFile("ephem/" + QString(DE430_FILENAME), StelFileMgr::File);
+	de431FilePath = StelFileMgr::findFile("ephem/" + QString(DE431_FILENAME), StelFileMgr::File);
+
+	if (!de430FilePath.isEmpty())
+		EphemWrapper::init_de430(QFile::encodeName(de430FilePath).constData());
+	if (!de431FilePath.isEmpty())
+		EphemWrapper::init_de431(QFile::encodeName(de431FilePath).constData());
+
+	// More threads than cores, so that the threads really interleave
+	threadCount = qMax(8, 2*QThread::idealThreadCount());
+}
+
+QVector<double> TestEphemerisContext::computeSeries(EphemerisContext* context, double startJD)
+{
+	QVector<double> result;
+	result.reserve(dateCount*coordFuncCount*6);
+	double jd = startJD;
+	for (int i=0; i<dateCount; ++i)
+	{
+		// Mostly small steps, which use the interpolation caches, with a few jumps back and forth
+		if (i%100==99)
+			jd += (i%200==199 ? -3000.25 : 2500.5);
+		else
+			jd += 0.37;
+
+		for (int f=0; f<coordFuncCount; ++f)
+		{
+			double xyz[3], xyzdot[3];
+			coordFuncs[f](jd, xyz, xyzdot, context);
+			result << xyz[0] << xyz[1] << xyz[2] << xyzdot[0] << xyzdot[1] << xyzdot[2];
+		}
+	}
+	return result;
+}
+
+void TestEphemerisContext::compareThreads(bool useDe430, bool useDe431, double startJD)
+{
+	QVector<double> reference;
+	{
+		EphemerisContext context(useDe430, useDe431);
+		reference = computeSeries(&context, startJD);
+	}
+
+	QThreadPool pool;
+	pool.setMaxThreadCount(threadCount);
+	QList<QFuture<QVector<double>>> futures;
+	for (int t=0; t<threadCount; ++t)
+	{
+		futures << QtConcurrent::run(&pool, [useDe430, useDe431, startJD]() {
+			EphemerisContext context(useDe430, useDe431);
+			return computeSeries(&context, startJD);
+		});
+	}
+
+	for (int t=0; t<threadCount; ++t)
+	{
+		const QVector<double> result = futures[t].result();
+		QCOMPARE(result.size(), reference.size());
+		QVERIFY2(std::memcmp(result.constData(), reference.constData(), sizeof(double)*static_cast<size_t>(reference.size()))==0,
+			 qPrintable(QString("thread %1 differs from the single-threaded result").arg(t)));
+	}
+}
+
+void TestEphemerisContext::testThreadsVsop87()
+{
+	compareThreads(false, false, 2451545.0);
+}
+
+void TestEphemerisContext::testThreadsDe430()
+{
+	if (de430FilePath.isEmpty())
+		QSKIP("DE430 ephemeris file not found");
+	compareThreads(true, false, 2451545.0);
+}
+
+void TestEphemerisContext::testThreadsDe431()
+{
+	if (de431FilePath.isEmpty())
+		QSKIP("DE431 ephemeris file not found");
+	// Start before the range of DE430
+	compareThreads(false, true, 2100000.5);
+}
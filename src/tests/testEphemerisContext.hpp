@@ -0,0 +1,49 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef TESTEPHEMERISCONTEXT_HPP
+#define TESTEPHEMERISCONTEXT_HPP
+
+#include <QObject>
+#include <QtTest>
+
+class EphemerisContext;
+
+//! Computes positions of the planets and the Moon from many threads, each with its own
+//! EphemerisContext, and checks them bit for bit against single-threaded results.
+class TestEphemerisContext : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void testThreadsVsop87();
+	void testThreadsDe430();
+	void testThreadsDe431();
+
+private:
+	//! Compute the positions of all bodies for a fixed series of dates.
+	static QVector<double> computeSeries(EphemerisContext* context, double startJD);
+	void compareThreads(bool useDe430, bool useDe431, double startJD);
+
+	QString de430FilePath, de431FilePath;
+	int threadCount;
+};
+
+#endif // TESTEPHEMERISCONTEXT_HPP
@@ -0,0 +1,316 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testHorizonProfile.hpp"
+#include "StelFileMgr.hpp"
+#include "StelIniParser.hpp"
+#include "StelUtils.hpp"
+
+#include <QElapsedTimer>
+#include <QDebug>
+#include <QImage>
+#include <QSettings>
+
+QTEST_GUILESS_MAIN(TestHorizonProfile)
+
+void TestHorizonProfile::initTestCase()
+{
+	StelFileMgr::init();
+}
+
+Vec3d TestHorizonProfile::direction(double azimuth, double altitude)
+{
+	Vec3d v;
+	StelUtils::spheToRect((180.-azimuth)*M_PI_180, altitude*M_PI_180, v);
+	return v;
+}
+
+QImage TestHorizonProfile::createPanorama(int width, int height, float altTop, float altBottom)
+{
+	QImage image(width, height, QImage::Format_ARGB32);
+	for (int y=0; y<height; ++y)
+	{
+		const float alt = altTop - (y+0.5f)*(altTop-altBottom)/height;
+		for (int x=0; x<width; ++x)
+		{
+			const float az = std::fmod(90.f + (x+0.5f)*360.f/width, 360.f);
+			int alpha = 0;
+			if (alt<0.f || (az>=100.f && az<140.f && alt<10.f))
+				alpha = 255;
+			else if (az>=200.f && az<220.f && alt<20.f)
+				alpha = 128;
+			image.setPixel(x, y, qRgba(50, 100, 50, alpha));
+		}
+	}
+	return image;
+}
+
+QVector<Vec3d> TestHorizonProfile::createDirections(int n)
+{
+	QVector<Vec3d> dirs(n);
+	for (int i=0; i<n; ++i)
+	{
+		// Points of a Fibonacci sphere
+		const double z = 1. - (2.*i+1.)/n;
+		const double r = std::sqrt(1.-z*z);
+		const double a = i*2.399963229728653;
+		dirs[i].set(r*std::cos(a), r*std::sin(a), z);
+	}
+	return dirs;
+}
+
+void TestHorizonProfile::testEquirectangular()
+{
+	HorizonProfile profile;
+	QVERIFY(!profile.isValid());
+	QCOMPARE(profile.getOpacity(direction(0., 10.)), 0.f);
+	QCOMPARE(profile.getOpacity(direction(0., -10.)), 1.f);
+
+	profile.buildEquirectangular(createPanorama(720, 360, 90.f, -90.f), M_PI_2f, -M_PI_2f, 0.f);
+	QVERIFY(profile.isValid());
+	QCOMPARE(profile.getNbAzimuths(), 720);
+	QCOMPARE(profile.getNbAltitudes(), 360);
+
+	QCOMPARE(profile.getOpacity(direction(50., -1.)), 1.f);
+	QCOMPARE(profile.getOpacity(direction(50., 1.)), 0.f);
+	QCOMPARE(profile.getOpacity(direction(120., 5.)), 1.f);
+	QCOMPARE(profile.getOpacity(direction(120., 15.)), 0.f);
+	QCOMPARE(profile.getOpacity(direction(210., 10.)), 128.f/255.f);
+	QCOMPARE(profile.getOpacity(direction(210., 25.)), 0.f);
+	QCOMPARE(profile.getOpacity(direction(300., -89.)), 1.f);
+	QCOMPARE(profile.getOpacity(direction(300., 89.)), 0.f);
+	// Directions need not be normalized
+	QCOMPARE(profile.getOpacity(direction(120., 5.)*3.), 1.f);
+	QCOMPARE(profile.getOpacity(direction(210., 10.)*0.1), 128.f/255.f);
+
+	// A cropped panorama: transparent above, opaque below
+	profile.buildEquirectangular(createPanorama(720, 60, 20.f, -10.f), 20.f*M_PI_180f, -10.f*M_PI_180f, 0.f);
+	QCOMPARE(profile.getNbAltitudes(), 60);
+	QCOMPARE(profile.getOpacity(direction(50., -30.)), 1.f);
+	QCOMPARE(profile.getOpacity(direction(50., -5.)), 1.f);
+	QCOMPARE(profile.getOpacity(direction(50., 5.)), 0.f);
+	QCOMPARE(profile.getOpacity(direction(120., 5.)), 1.f);
+	QCOMPARE(profile.getOpacity(direction(210., 15.)), 128.f/255.f);
+	QCOMPARE(profile.getOpacity(direction(210., 30.)), 0.f);
+
+	// The image is rotated to the East by angleRotateZ
+	profile.buildEquirectangular(createPanorama(720, 360, 90.f, -90.f), M_PI_2f, -M_PI_2f, 30.f*M_PI_180f);
+	QCOMPARE(profile.getOpacity(direction(120., 5.)), 0.f);
+	QCOMPARE(profile.getOpacity(direction(150., 5.)), 1.f);
+
+	profile.buildEquirectangular(QImage(), M_PI_2f, -M_PI_2f, 0.f);
+	QVERIFY(!profile.isValid());
+}
+
+void TestHorizonProfile::testPanels()
+{
+	// The same panorama as 4 panels of an old_style landscape, from -10° to 30°
+	const QImage image = createPanorama(1600, 100, 30.f, -10.f);
+	QVector<HorizonProfile::Panel> panels;
+	for (int i=0; i<4; ++i)
+	{
+		HorizonProfile::Panel panel = {&image, {i/4.f, 0.f, (i+1)/4.f, 1.f}};
+		panels.append(panel);
+	}
+	HorizonProfile profile;
+	profile.buildPanels(panels, 1, 40.f, -10.f, 0.f, false);
+	QVERIFY(profile.isValid());
+	QCOMPARE(profile.getNbAzimuths(), 1600);
+	QCOMPARE(profile.getNbAltitudes(), 100);
+	QCOMPARE(profile.getOpacity(direction(120., 5.)), 1.f);
+	QCOMPARE(profile.getOpacity(direction(120., 15.)), 0.f);
+	QCOMPARE(profile.getOpacity(direction(210., 15.)), 128.f/255.f);
+	QCOMPARE(profile.getOpacity(direction(300., -5.)), 1.f);
+	QCOMPARE(profile.getOpacity(direction(300., 5.)), 0.f);
+	QCOMPARE(profile.getOpacity(direction(300., -20.)), 1.f);
+	QCOMPARE(profile.getOpacity(direction(300., 35.)), 0.f);
+
+	// The panels repeated twice around the horizon: the mountain is seen from 95° to 115° and from 275° to 295°
+	profile.buildPanels(panels, 2, 40.f, -10.f, 0.f, false);
+	QCOMPARE(profile.getOpacity(direction(105., 5.)), 1.f);
+	QCOMPARE(profile.getOpacity(direction(120., 5.)), 0.f);
+	QCOMPARE(profile.getOpacity(direction(285., 5.)), 1.f);
+
+	// A missing image gives no profile
+	QImage missing;
+	panels[2].image = &missing;
+	profile.buildPanels(panels, 1, 40.f, -10.f, 0.f, false);
+	QVERIFY(!profile.isValid());
+}
+
+void TestHorizonProfile::testFisheye()
+{
+	// A fisheye image of 180°, opaque below 10°
+	const int size = 400;
+	QImage image(size, size, QImage::Format_ARGB32);
+	for (int y=0; y<size; ++y)
+	{
+		for (int x=0; x<size; ++x)
+		{
+			const float radius = std::sqrt((x+0.5f-size/2)*(x+0.5f-size/2) + (y+0.5f-size/2)*(y+0.5f-size/2))/(size/2);
+			const float alt = 90.f*(1.f-radius);
+			image.setPixel(x, y, qRgba(0, 0, 0, alt<10.f ? 255 : 0));
+		}
+	}
+	HorizonProfile profile;
+	profile.buildFisheye(image, M_PIf, 0.f);
+	QVERIFY(profile.isValid());
+	for (int az=0; az<360; az+=15)
+	{
+		QCOMPARE(profile.getOpacity(direction(az, -5.)), 1.f);
+		QCOMPARE(profile.getOpacity(direction(az, 5.)), 1.f);
+		QCOMPARE(profile.getOpacity(direction(az, 15.)), 0.f);
+		QCOMPARE(profile.getOpacity(direction(az, 80.)), 0.f);
+	}
+}
+
+void TestHorizonProfile::testRotation()
+{
+	HorizonProfile profile;
+	profile.buildEquirectangular(createPanorama(720, 360, 90.f, -90.f), M_PI_2f, -M_PI_2f, 0.f);
+	// Like Landscape::setZRotation(), which rotates the landscape towards the West
+	profile.setZRotation(90.f*M_PI_180f);
+	QCOMPARE(profile.getOpacity(direction(120., 5.)), 0.f);
+	QCOMPARE(profile.getOpacity(direction(210., 5.)), 1.f);
+	QCOMPARE(profile.getOpacity(direction(300., 10.)), 128.f/255.f);
+	profile.setZRotation(0.f);
+	QCOMPARE(profile.getOpacity(direction(120., 5.)), 1.f);
+}
+
+void TestHorizonProfile::testBatch()
+{
+	HorizonProfile profile;
+	profile.buildEquirectangular(createPanorama(720, 360, 90.f, -90.f), M_PI_2f, -M_PI_2f, 0.f);
+	const QVector<Vec3d> dirs = createDirections(10000);
+	QVector<float> opacity(dirs.size());
+	profile.getOpacity(dirs.size(), dirs.constData(), opacity.data());
+	int opaque = 0;
+	for (int i=0; i<dirs.size(); ++i)
+	{
+		QCOMPARE(opacity[i], profile.getOpacity(dirs[i]));
+		if (opacity[i]==1.f)
+			++opaque;
+	}
+	// A bit more than the half of the sky is hidden.
+	QVERIFY(opaque>5000 && opaque<5300);
+}
+
+void TestHorizonProfile::testMemory()
+{
+	// A sharp horizon costs two altitudes per column, whatever the height of the image.
+	const QImage image = createPanorama(4096, 2048, 90.f, -90.f);
+	HorizonProfile profile;
+	profile.buildEquirectangular(image, M_PI_2f, -M_PI_2f, 0.f);
+	QCOMPARE(profile.getNbAzimuths(), 4096);
+	QCOMPARE(profile.getNbAltitudes(), 2048);
+	const int imageSize = image.bytesPerLine()*image.height();
+	QVERIFY(profile.getMemorySize() < imageSize/50);
+	qDebug() << "Image:" << imageSize/1024 << "kB, profile:" << profile.getMemorySize()/1024 << "kB";
+}
+
+void TestHorizonProfile::benchmarkLandscapes()
+{
+	const QSet<QString> landscapeDirs = StelFileMgr::listContents("landscapes", StelFileMgr::Directory);
+	if (landscapeDirs.isEmpty())
+		QSKIP("No landscapes found");
+
+	const QVector<Vec3d> dirs = createDirections(100000);
+	QVector<float> opacity(dirs.size());
+	QList<HorizonProfile> profiles;
+	for (const auto& id : landscapeDirs)
+	{
+		const QString iniFile = StelFileMgr::findFile("landscapes/" + id + "/landscape.ini");
+		if (iniFile.isEmpty())
+			continue;
+		QSettings ini(iniFile, StelIniFormat);
+		if (!ini.value("landscape/polygonal_horizon_list").toString().isEmpty())
+			continue; // opacity queries use the polygon
+		const QString type = ini.value("landscape/type").toString();
+		auto texturePath = [&id](const QString& name) {
+			QString path = StelFileMgr::findFile("landscapes/" + id + "/" + name);
+			return path.isEmpty() ? StelFileMgr::findFile("textures/" + name) : path;
+		};
+
+		QElapsedTimer timer;
+		timer.start();
+		HorizonProfile profile;
+		qint64 imageSize = 0;
+		if (type=="spherical")
+		{
+			const QImage image(texturePath(ini.value("landscape/maptex").toString()));
+			imageSize = image.bytesPerLine()*image.height();
+			profile.buildEquirectangular(image, ini.value("landscape/maptex_top", 90.f).toFloat()*M_PI_180f,
+						     ini.value("landscape/maptex_bottom", -90.f).toFloat()*M_PI_180f,
+						     ini.value("landscape/angle_rotatez", 0.f).toFloat()*M_PI_180f);
+		}
+		else if (type=="fisheye")
+		{
+			const QImage image(texturePath(ini.value("landscape/maptex").toString()));
+			imageSize = image.bytesPerLine()*image.height();
+			profile.buildFisheye(image, ini.value("landscape/texturefov", 360).toFloat()*M_PI_180f,
+					     ini.value("landscape/angle_rotatez", 0.f).toFloat()*M_PI_180f);
+		}
+		else if (type=="old_style" && ini.value("landscape/calibrated", false).toBool())
+		{
+			const int nbSideTexs = ini.value("landscape/nbsidetex", 0).toInt();
+			const int nbSide = ini.value("landscape/nbside", 0).toInt();
+			QVector<QImage> images;
+			for (int i=0; i<nbSideTexs; ++i)
+			{
+				images.append(QImage(texturePath(ini.value(QString("landscape/tex%1").arg(i)).toString())));
+				imageSize += images.last().bytesPerLine()*images.last().height();
+			}
+			QVector<HorizonProfile::Panel> panels;
+			for (int i=0; i<nbSide; ++i)
+			{
+				const QStringList parameters = ini.value(QString("landscape/side%1").arg(i)).toString().split(':');
+				const int texnum = parameters.value(0).mid(3).toInt();
+				if (texnum<0 || texnum>=images.size() || parameters.size()<5)
+					break;
+				HorizonProfile::Panel panel = {&images.at(texnum), {parameters.at(1).toFloat(), parameters.at(2).toFloat(),
+										     parameters.at(3).toFloat(), parameters.at(4).toFloat()}};
+				panels.append(panel);
+			}
+			if (panels.size()==nbSide)
+				profile.buildPanels(panels, ini.value("landscape/nb_decor_repeat", 1).toInt(),
+						    ini.value("landscape/decor_alt_angle", 0.).toFloat(),
+						    ini.value("landscape/decor_angle_shift", 0.).toFloat(),
+						    ini.value("landscape/decor_angle_rotatez", 0.).toFloat()*M_PI_180f,
+						    ini.value("landscape/tan_mode", false).toBool());
+		}
+		if (!profile.isValid())
+			continue;
+		const qint64 buildTime = timer.elapsed();
+
+		timer.restart();
+		profile.getOpacity(dirs.size(), dirs.constData(), opacity.data());
+		const qint64 queryTime = timer.nsecsElapsed();
+		qDebug() << id << type << ": images" << imageSize/1024 << "kB, profile" << profile.getMemorySize()/1024 << "kB,"
+			 << profile.getNbAzimuths() << "x" << profile.getNbAltitudes() << ", built in" << buildTime << "ms,"
+			 << static_cast<double>(queryTime)/dirs.size() << "ns/query";
+		profiles.append(profile);
+	}
+	if (profiles.isEmpty())
+		QSKIP("No landscape with an image to sample");
+
+	QBENCHMARK {
+		for (const auto& profile : profiles)
+			profile.getOpacity(dirs.size(), dirs.constData(), opacity.data());
+	}
+}
@@ -0,0 +1,50 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef TESTHORIZONPROFILE_HPP
+#define TESTHORIZONPROFILE_HPP
+
+#include <QObject>
+#include <QtTest>
+
+#include "HorizonProfile.hpp"
+
+class TestHorizonProfile : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	void testEquirectangular();
+	void testPanels();
+	void testFisheye();
+	void testRotation();
+	void testBatch();
+	void testMemory();
+	void benchmarkLandscapes();
+private:
+	//! Return the direction of an azimuth (from North towards East) and an altitude, in degrees.
+	static Vec3d direction(double azimuth, double altitude);
+	//! Create a full equirectangular panorama (left border East) with a horizon at 0°, a mountain up to 10°
+	//! from azimuth 100° to 140° and a half transparent tree up to 20° from azimuth 200° to 220°.
+	static QImage createPanorama(int width, int height, float altTop, float altBottom);
+	//! Return directions spread over the whole sky.
+	static QVector<Vec3d> createDirections(int n);
+};
+
+#endif // TESTHORIZONPROFILE_HPP
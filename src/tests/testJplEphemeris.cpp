@@ -0,0 +1,195 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testJplEphemeris.hpp"
+
+#include <QDebug>
+#include <QFile>
+#include <QTemporaryDir>
+#include <cstring>
+
+#include "StelFileMgr.hpp"
+#include "EphemWrapper.hpp"
+#include "jpleph.h"
+
+QTEST_GUILESS_MAIN(TestJplEphemeris)
+
+static const int dateCount = 20000;
+
+void TestJplEphemeris::initTestCase()
+{
+	StelFileMgr::init();
+
+	de430FilePath = StelFileMgr::findFile("ephem/" + QString(DE430_FILENAME), StelFileMgr::File);
+	de431FilePath = StelFileMgr::findFile("ephem/" + QString(DE431_FILENAME), StelFileMgr::File);
+}
+
+// Fills the stack below the caller with garbage, like a previous call would
+static void dirtyStack()
+{
+	volatile unsigned char garbage[4096];
+	for (size_t i=0; i<sizeof(garbage); ++i)
+		garbage[i] = 0xA5;
+}
+
+void TestJplEphemeris::testFileReadingNotMapped()
+{
+	// A DE430 header without records: 400 constants, no coefficients
+	QByteArray file(4096, '\0');
+	const char title[] = "JPL Planetary Ephemeris DE430/LE430";
+	std::memcpy(file.data(), title, sizeof(title)-1);
+	const double header[] = { 2287184.5, 2688976.5, 32.0 };
+	std::memcpy(file.data()+2652, header, sizeof(header));
+	const quint32 ncon = 400;
+	std::memcpy(file.data()+2676, &ncon, sizeof(ncon));
+	const double auAndEmrat[] = { 149597870.7, 81.30056907419062 };
+	std::memcpy(file.data()+2680, auAndEmrat, sizeof(auAndEmrat));
+
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	QFile out(dir.filePath("header.430"));
+	QVERIFY(out.open(QIODevice::WriteOnly));
+	QCOMPARE(out.write(file), qint64(file.size()));
+	out.close();
+	const QByteArray fileName = QFile::encodeName(out.fileName());
+
+	dirtyStack();
+	void* ephem = jpl_init_ephemeris(fileName.constData(), Q_NULLPTR, Q_NULLPTR);
+	QVERIFY(ephem);
+	QVERIFY(!jpl_is_mapped(ephem));
+	QCOMPARE(jpl_get_double(ephem, JPL_EPHEM_START_JD), header[0]);
+	QCOMPARE(jpl_get_double(ephem, JPL_EPHEM_END_JD), header[1]);
+	jpl_close_ephemeris(ephem);
+}
+
+void TestJplEphemeris::addFileRows()
+{
+	if (de430FilePath.isEmpty() && de431FilePath.isEmpty())
+		QSKIP("Neither DE430 nor DE431 ephemeris file found");
+	QTest::addColumn<QString>("filePath");
+	if (!de430FilePath.isEmpty())
+		QTest::newRow("DE430") << de430FilePath;
+	if (!de431FilePath.isEmpty())
+		QTest::newRow("DE431") << de431FilePath;
+}
+
+QVector<double> TestJplEphemeris::makeDates(void* ephem, bool random)
+{
+	const double start = jpl_get_double(ephem, JPL_EPHEM_START_JD);
+	const double end = jpl_get_double(ephem, JPL_EPHEM_END_JD);
+	QVector<double> dates;
+	dates.reserve(dateCount);
+	qsrand(4711);
+	for (int i=0; i<dateCount; ++i)
+	{
+		if (random)
+			dates << start + (end-start)*qrand()/RAND_MAX;
+		else // Steps of 2.4 hours, as in a time lapse, starting at J2000 if possible
+			dates << qBound(start, 2451545.0, end-dateCount) + 0.1*i;
+	}
+	return dates;
+}
+
+void TestJplEphemeris::testMappedMatchesFileReading_data()
+{
+	addFileRows();
+}
+
+void TestJplEphemeris::testMappedMatchesFileReading()
+{
+	QFETCH(QString, filePath);
+	const QByteArray fileName = QFile::encodeName(filePath);
+	void* fileEphem = jpl_init_ephemeris(fileName.constData(), Q_NULLPTR, Q_NULLPTR);
+	void* mappedEphem = jpl_init_ephemeris_mapped(fileName.constData(), Q_NULLPTR, Q_NULLPTR);
+	QVERIFY(fileEphem);
+	QVERIFY(mappedEphem);
+	if (!jpl_is_mapped(mappedEphem))
+	{
+		jpl_close_ephemeris(fileEphem);
+		jpl_close_ephemeris(mappedEphem);
+		QSKIP("The file could not be mapped on this system");
+	}
+	void* clonedEphem = jpl_clone_ephemeris(mappedEphem);
+	QVERIFY(clonedEphem);
+
+	const QVector<double> dates = makeDates(fileEphem, true);
+	for (double jd : dates)
+	{
+		for (int body=1; body<=13; ++body)
+		{
+			double fromFile[6], fromMapping[6], fromClone[6];
+			QCOMPARE(jpl_pleph(fileEphem, jd, body, CENTRAL_PLANET_ID, fromFile, 1), 0);
+			QCOMPARE(jpl_pleph(mappedEphem, jd, body, CENTRAL_PLANET_ID, fromMapping, 1), 0);
+			QCOMPARE(jpl_pleph(clonedEphem, jd, body, CENTRAL_PLANET_ID, fromClone, 1), 0);
+			QVERIFY2(std::memcmp(fromFile, fromMapping, sizeof(fromFile))==0, qPrintable(QString("JD %1 body %2").arg(jd, 0, 'f', 5).arg(body)));
+			QVERIFY2(std::memcmp(fromFile, fromClone, sizeof(fromFile))==0, qPrintable(QString("JD %1 body %2").arg(jd, 0, 'f', 5).arg(body)));
+		}
+	}
+
+	// The clone keeps the mapping alive
+	jpl_close_ephemeris(mappedEphem);
+	double xyz[6];
+	QCOMPARE(jpl_pleph(clonedEphem, dates.first(), 3, CENTRAL_PLANET_ID, xyz, 1), 0);
+	jpl_close_ephemeris(clonedEphem);
+	jpl_close_ephemeris(fileEphem);
+}
+
+void TestJplEphemeris::benchmarkLookups_data()
+{
+	if (de430FilePath.isEmpty() && de431FilePath.isEmpty())
+		QSKIP("Neither DE430 nor DE431 ephemeris file found");
+	QTest::addColumn<QString>("filePath");
+	QTest::addColumn<bool>("mapped");
+	QTest::addColumn<bool>("random");
+	const QList<QPair<QString, QString>> files = {qMakePair(QString("DE430"), de430FilePath), qMakePair(QString("DE431"), de431FilePath)};
+	for (const auto& file : files)
+	{
+		if (file.second.isEmpty())
+			continue;
+		QTest::newRow(qPrintable(file.first + " fread sequential")) << file.second << false << false;
+		QTest::newRow(qPrintable(file.first + " mapped sequential")) << file.second << true << false;
+		QTest::newRow(qPrintable(file.first + " fread random")) << file.second << false << true;
+		QTest::newRow(qPrintable(file.first + " mapped random")) << file.second << true << true;
+	}
+}
+
+void TestJplEphemeris::benchmarkLookups()
+{
+	QFETCH(QString, filePath);
+	QFETCH(bool, mapped);
+	QFETCH(bool, random);
+	const QByteArray fileName = QFile::encodeName(filePath);
+	void* ephem = mapped ? jpl_init_ephemeris_mapped(fileName.constData(), Q_NULLPTR, Q_NULLPTR)
+			     : jpl_init_ephemeris(fileName.constData(), Q_NULLPTR, Q_NULLPTR);
+	QVERIFY(ephem);
+	if (mapped && !jpl_is_mapped(ephem))
+	{
+		jpl_close_ephemeris(ephem);
+		QSKIP("The file could not be mapped on this system");
+	}
+
+	const QVector<double> dates = makeDates(ephem, random);
+	double xyz[6];
+	QBENCHMARK {
+		// Earth, the most frequent lookup in Stellarium
+		for (double jd : dates)
+			jpl_pleph(ephem, jd, 3, CENTRAL_PLANET_ID, xyz, 1);
+	}
+	jpl_close_ephemeris(ephem);
+}
@@ -0,0 +1,48 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef TESTJPLEPHEMERIS_HPP
+#define TESTJPLEPHEMERIS_HPP
+
+#include <QObject>
+#include <QtTest>
+
+//! Compares the memory mapped reader of the JPL DE430/DE431 files with the
+//! regular file reader, and benchmarks both for random and sequential dates.
+//! The tests with the real files are skipped if they are not installed.
+class TestJplEphemeris : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void testFileReadingNotMapped();
+	void testMappedMatchesFileReading_data();
+	void testMappedMatchesFileReading();
+	void benchmarkLookups_data();
+	void benchmarkLookups();
+
+private:
+	void addFileRows();
+	static QVector<double> makeDates(void* ephem, bool random);
+
+	QString de430FilePath, de431FilePath;
+};
+
+#endif // TESTJPLEPHEMERIS_HPP
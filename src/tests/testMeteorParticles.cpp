@@ -0,0 +1,231 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testMeteorParticles.hpp"
+#include "StelUtils.hpp"
+
+#include <QElapsedTimer>
+#include <QDebug>
+
+QTEST_GUILESS_MAIN(TestMeteorParticles)
+
+static const double frameTime = 1./60.;
+static const float thickness = 0.1f;
+static const float bolideSize = 0.3f;
+
+void TestMeteorParticles::initPool(MeteorParticles& meteors, int& palette) const
+{
+	meteors.setSeed(1833);
+	palette = meteors.addPalette({MeteorParticles::ColorPair("white", 80), MeteorParticles::ColorPair("blueGreen", 20)});
+	QVector<float> brightness(76);
+	for (int i=0; i<brightness.size(); ++i)
+		brightness[i] = 1.f - 0.9f*i/(brightness.size()-1);
+	meteors.setBrightness(brightness);
+}
+
+int TestMeteorParticles::simulate(MeteorParticles& meteors, int palette, float zhr, int frames) const
+{
+	// A Leonid-like shower: fast meteors from a high radiant
+	Vec3d radiant;
+	StelUtils::spheToRect(0.5, 0.9, radiant);
+	int maxMeteors = 0;
+	for (int f=0; f<frames; ++f)
+	{
+		meteors.update(frameTime, true);
+		const int n = meteors.getNrOfSpawns(zhr, frameTime);
+		for (int i=0; i<n; ++i)
+			meteors.spawn(radiant, 71.f, palette, 2.5f);
+		meteors.buildDrawArrays(thickness, bolideSize);
+		maxMeteors = qMax(maxMeteors, meteors.getNrOfMeteors());
+	}
+	return maxMeteors;
+}
+
+void TestMeteorParticles::testRandom()
+{
+	MeteorParticles a, b;
+	a.setSeed(42);
+	b.setSeed(42);
+	double sum = 0.;
+	for (int i=0; i<100000; ++i)
+	{
+		const float r = a.random();
+		QVERIFY(r >= 0.f && r < 1.f);
+		QCOMPARE(b.random(), r);
+		sum += static_cast<double>(r);
+	}
+	QVERIFY(std::fabs(sum/100000. - 0.5) < 0.01);
+
+	b.setSeed(43);
+	int same = 0;
+	for (int i=0; i<1000; ++i)
+		if (a.random() == b.random())
+			++same;
+	QVERIFY(same < 10);
+}
+
+void TestMeteorParticles::testSpawn()
+{
+	MeteorParticles meteors;
+	int palette;
+	initPool(meteors, palette);
+
+	// From the zenith, all meteors are visible
+	for (int i=0; i<100; ++i)
+		QVERIFY(meteors.spawn(Vec3d(0., 0., 1.), 40.f, palette));
+	QCOMPARE(meteors.getNrOfMeteors(), 100);
+
+	// No meteor from a radiant below the horizon or with an unknown palette
+	QVERIFY(!meteors.spawn(Vec3d(1., 0., -0.1), 40.f, palette));
+	QVERIFY(!meteors.spawn(Vec3d(0., 0., 1.), 40.f, palette+1));
+	QCOMPARE(meteors.getNrOfMeteors(), 100);
+
+	// No meteor too faint for the sky drawer
+	meteors.setBrightness(QVector<float>(76, 0.f));
+	QVERIFY(!meteors.spawn(Vec3d(0., 0., 1.), 40.f, palette));
+
+	meteors.clear();
+	QCOMPARE(meteors.getNrOfMeteors(), 0);
+	QVERIFY(!meteors.spawn(Vec3d(0., 0., 1.), 40.f, palette));
+}
+
+void TestMeteorParticles::testCapacity()
+{
+	MeteorParticles meteors(16);
+	int palette;
+	initPool(meteors, palette);
+
+	int spawned = 0;
+	for (int i=0; i<100; ++i)
+		if (meteors.spawn(Vec3d(0., 0., 1.), 40.f, palette))
+			++spawned;
+	QCOMPARE(spawned, 16);
+	QCOMPARE(meteors.getNrOfMeteors(), 16);
+
+	// A storm doesn't go beyond the capacity
+	QVERIFY(simulate(meteors, palette, 1e7f, 60) <= 16);
+
+	meteors.setCapacity(32);
+	QCOMPARE(meteors.getCapacity(), 32);
+	QCOMPARE(meteors.getNrOfMeteors(), 0);
+}
+
+void TestMeteorParticles::testUpdate()
+{
+	MeteorParticles meteors;
+	int palette;
+	initPool(meteors, palette);
+	QVERIFY(meteors.spawn(Vec3d(0., 0., 1.), 40.f, palette));
+
+	// The head of the meteor is the last point of the line, it comes down from the zenith at 40 km/s
+	meteors.buildDrawArrays(0.f, 0.f);
+	const Vec3d start = meteors.getLineVertices().last();
+	QVERIFY(start[2] > 0.);
+	meteors.update(0.1, true);
+	meteors.buildDrawArrays(0.f, 0.f);
+	const Vec3d head = meteors.getLineVertices().last();
+	QVERIFY(std::fabs(start[2] - head[2] - 4./1242.) < 1e-6);
+	QVERIFY(std::fabs(start[0] - head[0]) < 1e-6 && std::fabs(start[1] - head[1]) < 1e-6);
+	// The train doesn't extend beyond the start of the burn
+	QVERIFY(std::fabs(meteors.getLineVertices().first()[2] - start[2]) < 1e-6);
+
+	// The meteor ends its burn after at most 12 seconds and fades out
+	for (int i=0; i<200 && meteors.getNrOfMeteors(); ++i)
+		meteors.update(0.1, true);
+	QCOMPARE(meteors.getNrOfMeteors(), 0);
+
+	// When the time doesn't run at real speed, the meteors fade out at once
+	for (int i=0; i<10; ++i)
+		QVERIFY(meteors.spawn(Vec3d(0., 0., 1.), 40.f, palette));
+	for (int i=0; i<5; ++i)
+		meteors.update(0.1, false);
+	QCOMPARE(meteors.getNrOfMeteors(), 0);
+}
+
+void TestMeteorParticles::testDrawArrays()
+{
+	MeteorParticles meteors;
+	int palette;
+	initPool(meteors, palette);
+	const int n = 5;
+	for (int i=0; i<n; ++i)
+		QVERIFY(meteors.spawn(Vec3d(0., 0., 1.), 40.f, palette));
+
+	const int segments = MeteorParticles::Segments;
+	meteors.buildDrawArrays(thickness, bolideSize);
+	QCOMPARE(meteors.getTrainVertices().size(), n*3*(segments-1)*6);
+	QCOMPARE(meteors.getLineVertices().size(), n*(segments-1)*2);
+	QCOMPARE(meteors.getBolideVertices().size(), n*6);
+	for (const auto& v : meteors.getTrainVertices())
+		QVERIFY(v[2] > 0.);
+
+	// Lines only
+	meteors.buildDrawArrays(0.f, 0.f);
+	QCOMPARE(meteors.getTrainVertices().size(), 0);
+	QCOMPARE(meteors.getLineVertices().size(), n*(segments-1)*2);
+	QCOMPARE(meteors.getBolideVertices().size(), 0);
+}
+
+void TestMeteorParticles::testSameSeedSameMeteors()
+{
+	MeteorParticles a, b, c;
+	int palette;
+	initPool(a, palette);
+	initPool(b, palette);
+	initPool(c, palette);
+	c.setSeed(1966);
+
+	QVERIFY(simulate(a, palette, 1e5f, 600) > 0);
+	simulate(b, palette, 1e5f, 600);
+	simulate(c, palette, 1e5f, 600);
+	QCOMPARE(a.getNrOfMeteors(), b.getNrOfMeteors());
+	QVERIFY(a.getLineVertices() == b.getLineVertices());
+	QVERIFY(a.getNrOfMeteors() != c.getNrOfMeteors() || a.getLineVertices() != c.getLineVertices());
+}
+
+void TestMeteorParticles::benchmarkZHR_data()
+{
+	QTest::addColumn<float>("zhr");
+	QTest::newRow("ZHR 10") << 10.f;
+	QTest::newRow("ZHR 100") << 100.f;
+	QTest::newRow("ZHR 1000") << 1000.f;
+	QTest::newRow("ZHR 10000") << 10000.f;
+	QTest::newRow("ZHR 100000") << 100000.f;
+}
+
+void TestMeteorParticles::benchmarkZHR()
+{
+	QFETCH(float, zhr);
+	MeteorParticles meteors;
+	int palette;
+	initPool(meteors, palette);
+
+	// Reach the steady state of the shower, then time a minute of frames
+	simulate(meteors, palette, zhr, 600);
+	QElapsedTimer timer;
+	timer.start();
+	const int frames = 3600;
+	const int maxMeteors = simulate(meteors, palette, zhr, frames);
+	const qint64 ns = timer.nsecsElapsed();
+	qDebug() << "ZHR" << zhr << ":" << ns/frames << "ns/frame for up to" << maxMeteors << "meteors";
+
+	QBENCHMARK {
+		simulate(meteors, palette, zhr, 60);
+	}
+}
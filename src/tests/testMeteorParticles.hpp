@@ -0,0 +1,48 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef TESTMETEORPARTICLES_HPP
+#define TESTMETEORPARTICLES_HPP
+
+#include <QObject>
+#include <QtTest>
+
+#include "MeteorParticles.hpp"
+
+class TestMeteorParticles : public QObject
+{
+Q_OBJECT
+private slots:
+	void testRandom();
+	void testSpawn();
+	void testCapacity();
+	void testUpdate();
+	void testDrawArrays();
+	void testSameSeedSameMeteors();
+	void benchmarkZHR_data();
+	void benchmarkZHR();
+private:
+	//! Create a pool with a single palette and a brightness decreasing with the magnitude
+	void initPool(MeteorParticles& meteors, int& palette) const;
+	//! Run the frames of a shower at 60 frames per second.
+	//! @return the largest number of meteors seen in a frame.
+	int simulate(MeteorParticles& meteors, int palette, float zhr, int frames) const;
+};
+
+#endif // TESTMETEORPARTICLES_HPP
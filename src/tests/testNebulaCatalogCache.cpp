@@ -0,0 +1,205 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testNebulaCatalogCache.hpp"
+
+#include "Nebula.hpp"
+#include "NebulaMgr.hpp"
+#include "NebulaCatalogCache.hpp"
+
+#include <QDataStream>
+#include <QFile>
+#include <QSet>
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestNebulaCatalogCache)
+
+// Must match StellariumDSOCatalogVersion in NebulaMgr.cpp, else the records are not read
+static const QString catalogVersion = "3.11";
+static const QString catalogEdition = "test";
+
+void TestNebulaCatalogCache::initTestCase()
+{
+	QVERIFY(tempDir.isValid());
+	catalogFile = tempDir.path() + "/catalog.dat";
+	cacheFile = tempDir.path() + "/catalog.cache";
+	// about the size of the standard catalog
+	writeCatalog(catalogFile, 90000);
+	cacheKey = NebulaCatalogCache::getCacheKey(catalogFile, catalogVersion);
+	QVERIFY(!cacheKey.isEmpty());
+}
+
+void TestNebulaCatalogCache::writeCatalog(const QString &fileName, int count)
+{
+	static const char* const mTypes[] = { "SBc", "E2", "Sa", "Irr", "", "IV2p" };
+	QByteArray raw;
+	QDataStream out(&raw, QIODevice::WriteOnly);
+	out.setVersion(QDataStream::Qt_5_2);
+	out << catalogVersion << catalogEdition;
+	for (int i=0; i<count; ++i)
+	{
+		const unsigned int n = static_cast<unsigned int>(i);
+		const float ra = static_cast<float>(std::fmod(i*0.61803, 2.*M_PI));
+		const float dec = static_cast<float>(std::asin(std::fmod(i*0.7548776, 2.)-1.));
+		const QString mType = QString::fromLatin1(mTypes[i%6]);
+		// A few objects get each catalog number or string designation, most have none of them
+		const auto num = [n](unsigned int k) { return n%k==0 ? n/k+1 : 0u; };
+		const auto str = [i](int k) { return i%k==0 ? QString("%1-%2.%3").arg(k).arg(i/100).arg(i%100) : QString(); };
+		out << n+1 << ra << dec << 5.f+(i%150)*0.1f << 4.5f+(i%140)*0.1f << static_cast<unsigned int>(i%35) << mType
+		    << (i%90)*0.01f << (i%60)*0.01f << i%180 << (i%7)*0.001f << 0.0001f << (i%5)*0.1f << 0.01f
+		    << (i%11)*10.f << 1.f
+		    << num(3) << num(5) << num(700) << num(800) << num(300) << num(250) << num(350) << num(200)
+		    << num(60) << num(70) << num(400) << num(450) << num(2) << num(4) << str(600) << num(330)
+		    << num(90) << str(150) << str(160) << str(500) << str(170) << str(900) << str(40) << str(850)
+		    << num(1000) << num(1100) << num(1200) << num(1300) << num(1400);
+	}
+
+	// catalog.dat is a zlib stream, without the size which qCompress() puts in front of it
+	QFile file(fileName);
+	QVERIFY(file.open(QIODevice::WriteOnly));
+	file.write(qCompress(raw).mid(4));
+	file.close();
+}
+
+void TestNebulaCatalogCache::compare(const Nebula &a, const Nebula &b)
+{
+	QCOMPARE(a.XYZ, b.XYZ);
+	QCOMPARE(a.DSO_nb, b.DSO_nb);
+	QCOMPARE(a.nType, b.nType);
+	QCOMPARE(a.mTypeString, b.mTypeString);
+	QCOMPARE(a.bMag, b.bMag);
+	QCOMPARE(a.vMag, b.vMag);
+	QCOMPARE(a.majorAxisSize, b.majorAxisSize);
+	QCOMPARE(a.minorAxisSize, b.minorAxisSize);
+	QCOMPARE(a.orientationAngle, b.orientationAngle);
+	QCOMPARE(a.redshift, b.redshift);
+	QCOMPARE(a.redshiftErr, b.redshiftErr);
+	QCOMPARE(a.parallax, b.parallax);
+	QCOMPARE(a.parallaxErr, b.parallaxErr);
+	QCOMPARE(a.oDistance, b.oDistance);
+	QCOMPARE(a.oDistanceErr, b.oDistanceErr);
+	QCOMPARE(a.withoutID, b.withoutID);
+	// The designations cover all the catalog numbers and strings
+	QCOMPARE(a.getDesignations(), b.getDesignations());
+}
+
+void TestNebulaCatalogCache::testCacheRoundTrip()
+{
+	QVector<NebulaP> parsed;
+	QString version, edition;
+	QVERIFY(NebulaMgr::readDSOCatalog(catalogFile, parsed, version, edition));
+	QCOMPARE(parsed.size(), 90000);
+	QCOMPARE(version, catalogVersion);
+	QCOMPARE(edition, catalogEdition);
+
+	QVERIFY(NebulaCatalogCache::save(cacheFile, cacheKey, version, edition, parsed));
+	NebulaCatalogCache cache;
+	QVERIFY(cache.open(cacheFile, cacheKey));
+	QCOMPARE(cache.size(), parsed.size());
+	QCOMPARE(cache.getVersion(), version);
+	QCOMPARE(cache.getEdition(), edition);
+	for (int i=0; i<cache.size(); ++i)
+	{
+		compare(*parsed.at(i), *cache.createNebula(i));
+		if (QTest::currentTestFailed())
+		{
+			qWarning() << "DSO" << i << "differs";
+			return;
+		}
+	}
+}
+
+void TestNebulaCatalogCache::testCacheInvalidation()
+{
+	QVector<NebulaP> parsed;
+	QString version, edition;
+	QVERIFY(NebulaMgr::readDSOCatalog(catalogFile, parsed, version, edition));
+	QVERIFY(NebulaCatalogCache::save(cacheFile, cacheKey, version, edition, parsed));
+
+	NebulaCatalogCache cache;
+	QVERIFY(!cache.open(cacheFile, NebulaCatalogCache::getCacheKey(catalogFile, "3.10")));
+	QVERIFY(!cache.isOpen());
+
+	// Another catalog file gives another key
+	const QString otherFile = tempDir.path() + "/other.dat";
+	writeCatalog(otherFile, 10);
+	QVERIFY(NebulaCatalogCache::getCacheKey(otherFile, catalogVersion) != cacheKey);
+	QVERIFY(!cache.open(cacheFile, NebulaCatalogCache::getCacheKey(otherFile, catalogVersion)));
+
+	// A truncated cache is rejected
+	const QString truncatedFile = tempDir.path() + "/truncated.cache";
+	QVERIFY(QFile::copy(cacheFile, truncatedFile));
+	QFile truncated(truncatedFile);
+	QVERIFY(truncated.resize(truncated.size()/2));
+	QVERIFY(!cache.open(truncatedFile, cacheKey));
+
+	QVERIFY(cache.open(cacheFile, cacheKey));
+}
+
+void TestNebulaCatalogCache::testCacheSharesStrings()
+{
+	// The memory saved by the cache: each distinct string is allocated once, and no designation list is built at load time
+	QVector<NebulaP> parsed;
+	QString version, edition;
+	QVERIFY(NebulaMgr::readDSOCatalog(catalogFile, parsed, version, edition));
+	QVERIFY(NebulaCatalogCache::save(cacheFile, cacheKey, version, edition, parsed));
+	NebulaCatalogCache cache;
+	QVERIFY(cache.open(cacheFile, cacheKey));
+
+	QSet<const QChar*> parsedStrings, cachedStrings;
+	for (int i=0; i<cache.size(); ++i)
+	{
+		const NebulaP n = cache.createNebula(i);
+		QVERIFY(n->designations.isEmpty());
+		if (!n->mTypeString.isEmpty())
+			cachedStrings.insert(n->mTypeString.constData());
+		if (!parsed.at(i)->mTypeString.isEmpty())
+			parsedStrings.insert(parsed.at(i)->mTypeString.constData());
+	}
+	// The five non-empty morphological types of writeCatalog()
+	QCOMPARE(cachedStrings.size(), 5);
+	QCOMPARE(parsedStrings.size(), 75000);
+}
+
+void TestNebulaCatalogCache::benchmarkReadCatalog()
+{
+	QBENCHMARK {
+		QVector<NebulaP> dsos;
+		QString version, edition;
+		NebulaMgr::readDSOCatalog(catalogFile, dsos, version, edition);
+	}
+}
+
+void TestNebulaCatalogCache::benchmarkReadCache()
+{
+	QVector<NebulaP> parsed;
+	QString version, edition;
+	QVERIFY(NebulaMgr::readDSOCatalog(catalogFile, parsed, version, edition));
+	QVERIFY(NebulaCatalogCache::save(cacheFile, cacheKey, version, edition, parsed));
+
+	// Same steps as NebulaMgr::readDSOCatalogCache()
+	QBENCHMARK {
+		NebulaCatalogCache cache;
+		QVector<NebulaP> dsos;
+		cache.open(cacheFile, cacheKey);
+		dsos.reserve(cache.size());
+		for (int i=0; i<cache.size(); ++i)
+			dsos.append(cache.createNebula(i));
+	}
+}
@@ -0,0 +1,334 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testPhenomenaSearch.hpp"
+
+#include <QSignalSpy>
+#include <cmath>
+
+#include "PhenomenaSearch.hpp"
+#include "StelCore.hpp"
+#include "EphemWrapper.hpp"
+#include "VecMath.hpp"
+
+QTEST_GUILESS_MAIN(TestPhenomenaSearch)
+
+Q_DECLARE_METATYPE(PhenomenaSearch::Kind)
+
+namespace
+{
+	//! Smooth functions with many extrema, loosely modelled on the apparent motion of a planet.
+	class SyntheticSampler : public PhenomenaSearch::Sampler
+	{
+	public:
+		SyntheticSampler(int cost=0) : cost(cost) {}
+		virtual double angularDistance(double JD) Q_DECL_OVERRIDE
+		{
+			return 1.5 + std::sin(2.*M_PI*JD/37.3) + 0.3*std::sin(2.*M_PI*JD/11.1) + burn(JD);
+		}
+		virtual bool isEast(double JD) Q_DECL_OVERRIDE
+		{
+			return std::sin(2.*M_PI*JD/53.) > 0.;
+		}
+		virtual double rightAscension(double JD) Q_DECL_OVERRIDE
+		{
+			// retrograde loops every 90 days
+			return 100. + 0.1*(JD - 2451545.) + 10.*std::sin(2.*M_PI*JD/90.);
+		}
+		virtual double heliocentricDistance(double JD) Q_DECL_OVERRIDE
+		{
+			return 1. + 0.2*std::cos(2.*M_PI*JD/365.25);
+		}
+
+	private:
+		//! Simulate the cost of a real ephemeris evaluation.
+		double burn(double JD) const
+		{
+			double x = 0.;
+			for (int i=0; i<cost; ++i)
+				x += std::sin(JD + i);
+			return x*1e-300;
+		}
+		int cost;
+	};
+
+	typedef void (*CoordFunc)(double, double*, double*, void*);
+
+	void get_moon_helio_coordsv(double jd, double xyz[3], double xyzdot[3], void* context)
+	{
+		double moon[3], moonDot[3];
+		get_earth_helio_coordsv(jd, xyz, xyzdot, context);
+		get_lunar_parent_coordsv(jd, moon, moonDot, context);
+		for (int i=0; i<3; ++i)
+		{
+			xyz[i] += moon[i];
+			xyzdot[i] += moonDot[i];
+		}
+	}
+
+	enum Body { Sun, Moon, Mercury, Venus, Mars, Jupiter, Saturn };
+	const CoordFunc bodyCoordFuncs[] = {
+		&get_sun_helio_coordsv,
+		&get_moon_helio_coordsv,
+		&get_mercury_helio_coordsv,
+		&get_venus_helio_coordsv,
+		&get_mars_helio_coordsv,
+		&get_jupiter_helio_coordsv,
+		&get_saturn_helio_coordsv
+	};
+
+	//! Geometric geocentric positions from the planetary theories. Like the samplers of AstroCalc,
+	//! every instance has its own EphemerisContext, so that the shards can run in parallel.
+	class EphemerisSampler : public PhenomenaSearch::Sampler
+	{
+	public:
+		EphemerisSampler(CoordFunc body1, CoordFunc body2) : context(false, false), body1(body1), body2(body2) {}
+		virtual double angularDistance(double JD) Q_DECL_OVERRIDE
+		{
+			return geocentricPos(body1, JD).angle(geocentricPos(body2, JD));
+		}
+		virtual bool isEast(double JD) Q_DECL_OVERRIDE
+		{
+			return geocentricPos(body1, JD).longitude() > geocentricPos(body2, JD).longitude();
+		}
+		virtual double rightAscension(double JD) Q_DECL_OVERRIDE
+		{
+			const Vec3d pos = StelCore::matVsop87ToJ2000.multiplyWithoutTranslation(geocentricPos(body1, JD));
+			double ra = pos.longitude()*180./M_PI;
+			if (ra<0.)
+				ra += 360.;
+			return ra;
+		}
+		virtual double heliocentricDistance(double JD) Q_DECL_OVERRIDE
+		{
+			return heliocentricPos(body1, JD).length();
+		}
+
+	private:
+		Vec3d heliocentricPos(CoordFunc body, double JD)
+		{
+			Vec3d pos, velocity;
+			body(JD, pos, velocity, &context);
+			return pos;
+		}
+		Vec3d geocentricPos(CoordFunc body, double JD)
+		{
+			return heliocentricPos(body, JD) - heliocentricPos(&get_earth_helio_coordsv, JD);
+		}
+
+		EphemerisContext context;
+		CoordFunc body1, body2;
+	};
+
+	PhenomenaSearch::Job makeJob(PhenomenaSearch::Kind kind, double step, int cost=0)
+	{
+		PhenomenaSearch::Job job;
+		job.kind = kind;
+		job.step = step;
+		job.maxSeparation = 180.;
+		job.createSampler = [cost]() { return PhenomenaSearch::SamplerP(new SyntheticSampler(cost)); };
+		return job;
+	}
+
+	//! Run a sharded search and merge the streamed results of every job.
+	QVector<QMap<double, double> > runSharded(const QVector<PhenomenaSearch::Job>& jobs, double startJD, double stopJD, int threads)
+	{
+		QVector<QMap<double, double> > results(jobs.size());
+		PhenomenaSearch search;
+		QObject::connect(&search, &PhenomenaSearch::resultsReady, [&results](int job, const QMap<double, double>& found) {
+			results[job].unite(found);
+		});
+		QSignalSpy finishedSpy(&search, SIGNAL(finished(bool)));
+		search.start(jobs, startJD, stopJD, threads);
+		if (finishedSpy.isEmpty())
+			finishedSpy.wait(60000);
+		return results;
+	}
+}
+
+static const double startJD = 2451545.0;
+static const double stopJD = startJD + 5000.;
+
+void TestPhenomenaSearch::testShardedMatchesReference_data()
+{
+	QTest::addColumn<PhenomenaSearch::Kind>("kind");
+	QTest::addColumn<double>("step");
+	QTest::addColumn<int>("threads");
+
+	QTest::newRow("conjunction, 1 thread") << PhenomenaSearch::Conjunction << 1.0 << 1;
+	QTest::newRow("conjunction") << PhenomenaSearch::Conjunction << 1.0 << 0;
+	QTest::newRow("conjunction, coarse") << PhenomenaSearch::Conjunction << 2.5 << 0;
+	QTest::newRow("opposition") << PhenomenaSearch::Opposition << 0.5 << 0;
+	QTest::newRow("greatest elongation") << PhenomenaSearch::GreatestElongation << 1.0 << 0;
+	QTest::newRow("stationary point") << PhenomenaSearch::StationaryPoint << 1.0 << 0;
+	QTest::newRow("orbital point") << PhenomenaSearch::OrbitalPoint << 1.0 << 3;
+}
+
+void TestPhenomenaSearch::testShardedMatchesReference()
+{
+	QFETCH(PhenomenaSearch::Kind, kind);
+	QFETCH(double, step);
+	QFETCH(int, threads);
+
+	const PhenomenaSearch::Job job = makeJob(kind, step);
+	QVERIFY(PhenomenaSearch::windowCount(job, startJD, stopJD) > 1);
+
+	const QMap<double, double> reference = PhenomenaSearch::search(job, startJD, stopJD);
+	QVERIFY(!reference.isEmpty());
+
+	const QMap<double, double> sharded = runSharded(QVector<PhenomenaSearch::Job>() << job, startJD, stopJD, threads).at(0);
+	// These functions never trigger the adaptive step, so the shards sample the dates of the reference and the results are identical.
+	QCOMPARE(sharded.keys(), reference.keys());
+	QCOMPARE(sharded.values(), reference.values());
+}
+
+void TestPhenomenaSearch::testShardedMatchesReferenceEphemeris_data()
+{
+	QTest::addColumn<PhenomenaSearch::Kind>("kind");
+	QTest::addColumn<int>("body1");
+	QTest::addColumn<int>("body2");
+	QTest::addColumn<double>("step");
+	QTest::addColumn<double>("years");
+
+	// The steps are those of AstroCalcDialog::findInitialStep()
+	QTest::newRow("Jupiter-Saturn conjunction") << PhenomenaSearch::Conjunction << int(Jupiter) << int(Saturn) << 90.5625 << 200.;
+	QTest::newRow("Moon-Sun conjunction") << PhenomenaSearch::Conjunction << int(Moon) << int(Sun) << 0.25 << 5.;
+	QTest::newRow("Mars opposition") << PhenomenaSearch::Opposition << int(Mars) << int(Sun) << 5. << 50.;
+	QTest::newRow("Venus greatest elongation") << PhenomenaSearch::GreatestElongation << int(Venus) << int(Sun) << 2.5 << 20.;
+	QTest::newRow("Mars stationary point") << PhenomenaSearch::StationaryPoint << int(Mars) << int(Sun) << 5. << 50.;
+	QTest::newRow("Mercury perihelion and aphelion") << PhenomenaSearch::OrbitalPoint << int(Mercury) << int(Sun) << 2.5 << 20.;
+}
+
+void TestPhenomenaSearch::testShardedMatchesReferenceEphemeris()
+{
+	QFETCH(PhenomenaSearch::Kind, kind);
+	QFETCH(int, body1);
+	QFETCH(int, body2);
+	QFETCH(double, step);
+	QFETCH(double, years);
+
+	PhenomenaSearch::Job job;
+	job.kind = kind;
+	job.step = step;
+	job.maxSeparation = 180.;
+	const CoordFunc func1 = bodyCoordFuncs[body1];
+	const CoordFunc func2 = bodyCoordFuncs[body2];
+	job.createSampler = [func1, func2]() { return PhenomenaSearch::SamplerP(new EphemerisSampler(func1, func2)); };
+
+	const double start = 2415020.5; // 1900-01-01
+	const double stop = start + years*365.25;
+	QVERIFY(PhenomenaSearch::windowCount(job, start, stop) > 1);
+
+	const QMap<double, double> reference = PhenomenaSearch::search(job, start, stop);
+	QVERIFY(!reference.isEmpty());
+	const QMap<double, double> sharded = runSharded(QVector<PhenomenaSearch::Job>() << job, start, stop, 0).at(0);
+
+	// Scans which took an adaptive step leave the sampling grid, so the times may differ within the refinement precision.
+	QCOMPARE(sharded.size(), reference.size());
+	const QList<double> referenceTimes = reference.keys();
+	const QList<double> shardedTimes = sharded.keys();
+	for (int i=0; i<reference.size(); ++i)
+	{
+		QVERIFY2(qAbs(shardedTimes.at(i) - referenceTimes.at(i)) <= 2./1440.,
+			 qPrintable(QString("event %1: JD %2 vs. %3").arg(i).arg(shardedTimes.at(i), 0, 'f', 5).arg(referenceTimes.at(i), 0, 'f', 5)));
+		const double referenceValue = reference.value(referenceTimes.at(i));
+		QVERIFY(qAbs(sharded.value(shardedTimes.at(i)) - referenceValue) <= 1e-5*qMax(1., qAbs(referenceValue)));
+	}
+}
+
+void TestPhenomenaSearch::testProgress()
+{
+	QVector<PhenomenaSearch::Job> jobs;
+	jobs << makeJob(PhenomenaSearch::Conjunction, 1.0) << makeJob(PhenomenaSearch::StationaryPoint, 1.0);
+	const int total = PhenomenaSearch::windowCount(jobs.at(0), startJD, stopJD) + PhenomenaSearch::windowCount(jobs.at(1), startJD, stopJD);
+
+	PhenomenaSearch search;
+	QSignalSpy progressSpy(&search, SIGNAL(progressChanged(int,int)));
+	QSignalSpy finishedSpy(&search, SIGNAL(finished(bool)));
+	search.start(jobs, startJD, stopJD);
+	QVERIFY(search.isRunning());
+	QVERIFY(finishedSpy.wait(60000));
+	QVERIFY(!search.isRunning());
+	QCOMPARE(finishedSpy.count(), 1);
+	QCOMPARE(finishedSpy.at(0).at(0).toBool(), false);
+
+	// one initial report plus one per shard, counting up to the total
+	QCOMPARE(progressSpy.count(), total + 1);
+	for (int i=0; i<progressSpy.count(); ++i)
+	{
+		QCOMPARE(progressSpy.at(i).at(0).toInt(), i);
+		QCOMPARE(progressSpy.at(i).at(1).toInt(), total);
+	}
+}
+
+void TestPhenomenaSearch::testCancel()
+{
+	PhenomenaSearch search;
+	QSignalSpy resultsSpy(&search, SIGNAL(resultsReady(int,QMap<double, double>)));
+	QSignalSpy finishedSpy(&search, SIGNAL(finished(bool)));
+
+	QVector<PhenomenaSearch::Job> jobs;
+	jobs << makeJob(PhenomenaSearch::Conjunction, 0.01, 200);
+	search.start(jobs, startJD, stopJD, 2);
+	search.cancel();
+	QVERIFY(!search.isRunning());
+	QCOMPARE(finishedSpy.count(), 1);
+	QCOMPARE(finishedSpy.at(0).at(0).toBool(), true);
+
+	// the workers stop quickly and nothing is reported after the cancellation
+	search.waitForFinished();
+	QTest::qWait(100);
+	QCOMPARE(resultsSpy.count(), 0);
+	QCOMPARE(finishedSpy.count(), 1);
+
+	// the search can be restarted
+	jobs.clear();
+	jobs << makeJob(PhenomenaSearch::OrbitalPoint, 1.0);
+	search.start(jobs, startJD, stopJD);
+	QVERIFY(finishedSpy.wait(60000));
+	QCOMPARE(finishedSpy.last().at(0).toBool(), false);
+	QVERIFY(resultsSpy.count() > 0);
+}
+
+void TestPhenomenaSearch::benchmarkSearch_data()
+{
+	QTest::addColumn<bool>("sharded");
+	QTest::newRow("reference") << false;
+	QTest::newRow("sharded") << true;
+}
+
+void TestPhenomenaSearch::benchmarkSearch()
+{
+	QFETCH(bool, sharded);
+
+	QVector<PhenomenaSearch::Job> jobs;
+	for (int i=0; i<8; ++i)
+		jobs << makeJob(PhenomenaSearch::Conjunction, 1.0, 50);
+
+	QBENCHMARK
+	{
+		if (sharded)
+			runSharded(jobs, startJD, stopJD, 0);
+		else
+		{
+			for (const auto& job : jobs)
+				PhenomenaSearch::search(job, startJD, stopJD);
+		}
+	}
+}
@@ -0,0 +1,151 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testPositionEvaluator.hpp"
+
+#include "SolarSystem.hpp"
+#include "StelCore.hpp"
+#include "StelUtils.hpp"
+#include "EphemWrapper.hpp"
+
+QTEST_GUILESS_MAIN(TestPositionEvaluator)
+
+// The positions are computed by the same functions in both ways, only the order of the additions may differ.
+static const double maxDifference = 1e-12; // AU
+
+PlanetP TestPositionEvaluator::addPlanet(const QString& name, posFuncType coordFunc, const QString& type, PlanetP parent)
+{
+	PlanetP p(new Planet(name, 0.001, 0., Vec3f(1.f), 0.3f, 0.9f, "", "", "", coordFunc, Q_NULLPTR, Q_NULLPTR, false, false, false, true, type));
+	// Same as in SolarSystem::loadPlanets()
+	if (parent)
+	{
+		p->parent = parent;
+		parent->satellites.append(p);
+	}
+	planets.append(p);
+	return p;
+}
+
+void TestPositionEvaluator::initTestCase()
+{
+	Planet::init();
+	sun = addPlanet("Sun", &get_sun_helio_coordsv, "star", PlanetP());
+	earth = addPlanet("Earth", &get_earth_helio_coordsv, "planet", sun);
+	moon = addPlanet("Moon", &get_lunar_parent_coordsv, "moon", earth);
+	jupiter = addPlanet("Jupiter", &get_jupiter_helio_coordsv, "planet", sun);
+	io = addPlanet("Io", &get_io_parent_coordsv, "moon", jupiter);
+	context = new EphemerisContext(false, false);
+}
+
+void TestPositionEvaluator::cleanupTestCase()
+{
+	delete context;
+	for (const auto& p : planets)
+	{
+		p->satellites.clear();
+		p->parent.clear();
+	}
+	planets.clear();
+	sun.clear(); earth.clear(); moon.clear(); jupiter.clear(); io.clear();
+}
+
+void TestPositionEvaluator::computePositions(double JDE)
+{
+	for (const auto& p : planets)
+		p->computePosition(JDE);
+	const Vec3d obsPosJDE = earth->getHeliocentricEclipticPos();
+	for (const auto& p : planets)
+	{
+		const double light_speed_correction = (p->getHeliocentricEclipticPos()-obsPosJDE).length() * (AU / (SPEED_OF_LIGHT * 86400.));
+		p->computePosition(JDE-light_speed_correction);
+	}
+}
+
+void TestPositionEvaluator::comparePositions(double JDE)
+{
+	const Vec3d observerCenter = earth->computeEclipticPos(JDE, context);
+	for (const auto& p : planets)
+	{
+		const Vec3d expected = p->getHeliocentricEclipticPos();
+		const Vec3d pos = SolarSystem::PositionEvaluator::computeLightTimeCorrectedPos(p.data(), JDE, observerCenter, context);
+		QVERIFY2((pos-expected).length() <= maxDifference,
+			 qPrintable(QString("%1 at JDE %2: %3 vs. %4").arg(p->getEnglishName()).arg(JDE, 0, 'f', 5).arg(pos.toString()).arg(expected.toString())));
+	}
+}
+
+void TestPositionEvaluator::testMatchesComputePositions_data()
+{
+	QTest::addColumn<double>("startJDE");
+	QTest::newRow("J2000") << 2451545.0;
+	QTest::newRow("2020") << 2458849.5;
+	QTest::newRow("1600") << 2305447.5;
+}
+
+void TestPositionEvaluator::testMatchesComputePositions()
+{
+	QFETCH(double, startJDE);
+	// Days apart, so that no position is kept from the previous date.
+	for (int i=0; i<200; ++i)
+	{
+		const double JDE = startJDE + i*3.17;
+		computePositions(JDE);
+		comparePositions(JDE);
+	}
+
+	// The satellites are really corrected, i.e. the comparison is not only between geometric positions.
+	const Vec3d geometricIo = jupiter->computeEclipticPos(startJDE, context) + io->computeEclipticPos(startJDE, context);
+	computePositions(startJDE);
+	QVERIFY((io->getHeliocentricEclipticPos()-geometricIo).length() > 1e-5);
+}
+
+void TestPositionEvaluator::testDeltaJDE()
+{
+	// Light time of the Moon is about 1.3s, the default update threshold for moons is 1ms.
+	const double JDE = 2458849.5;
+	const double moonDeltaJDE = moon->deltaJDE;
+	moon->deltaJDE = 2.*StelCore::JD_SECOND;
+	computePositions(JDE);
+	comparePositions(JDE);
+	const Vec3d geometricMoon = earth->computeEclipticPos(JDE, context) + moon->computeEclipticPos(JDE, context);
+	const Vec3d pos = SolarSystem::PositionEvaluator::computeLightTimeCorrectedPos(moon.data(), JDE, earth->computeEclipticPos(JDE, context), context);
+	QVERIFY((pos-geometricMoon).length() <= maxDifference);
+
+	moon->deltaJDE = moonDeltaJDE;
+	computePositions(JDE+10.);
+	comparePositions(JDE+10.);
+}
+
+void TestPositionEvaluator::benchmarkComputePositions()
+{
+	double JDE = 2458849.5;
+	QBENCHMARK {
+		JDE += 0.5;
+		computePositions(JDE);
+		io->getHeliocentricEclipticPos();
+	}
+}
+
+void TestPositionEvaluator::benchmarkLightTimeCorrectedPos()
+{
+	double JDE = 2458849.5;
+	QBENCHMARK {
+		JDE += 0.5;
+		SolarSystem::PositionEvaluator::computeLightTimeCorrectedPos(io.data(), JDE, earth->computeEclipticPos(JDE, context), context);
+	}
+}
@@ -0,0 +1,57 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef TESTPOSITIONEVALUATOR_HPP
+#define TESTPOSITIONEVALUATOR_HPP
+
+#include <QObject>
+#include <QtTest>
+
+#include "Planet.hpp"
+
+class EphemerisContext;
+
+//! Builds a small solar system (Sun, Earth, Moon, Jupiter, Io) and checks the light time corrected
+//! positions of SolarSystem::PositionEvaluator against the stateful computation of SolarSystem::computePositions().
+class TestPositionEvaluator : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void testMatchesComputePositions_data();
+	void testMatchesComputePositions();
+	void testDeltaJDE();
+	void benchmarkComputePositions();
+	void benchmarkLightTimeCorrectedPos();
+
+private:
+	PlanetP addPlanet(const QString& name, posFuncType coordFunc, const QString& type, PlanetP parent);
+	//! The light time loops of SolarSystem::computePositions() for an observer on Earth.
+	void computePositions(double JDE);
+	//! Compare all bodies at JDE, the Planet objects must have been updated for JDE.
+	void comparePositions(double JDE);
+
+	QList<PlanetP> planets; // in hierarchical order, as SolarSystem::systemPlanets
+	PlanetP sun, earth, moon, jupiter, io;
+	EphemerisContext* context;
+};
+
+#endif // TESTPOSITIONEVALUATOR_HPP
@@ -0,0 +1,126 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testSkybright.hpp"
+#include "Skybright.hpp"
+#include "StelUtils.hpp"
+#include "VecMath.hpp"
+
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestSkybright)
+
+// About the grid of the atmosphere at its highest resolution
+static const int gridSize = 265;
+static const float moonAzimuth = 2.1f;
+static const float sunAzimuth = 0.3f;
+
+static Vec3f direction(float azimuth, float altitude)
+{
+	return Vec3f(std::cos(altitude)*std::cos(azimuth), std::cos(altitude)*std::sin(azimuth), std::sin(altitude));
+}
+
+void TestSkybright::initTestCase()
+{
+	for (int i=0; i<gridSize; ++i)
+	{
+		for (int j=0; j<gridSize; ++j)
+		{
+			Vec3f v = direction(2.f*M_PIf*j/gridSize, M_PIf*i/(gridSize-1) - M_PI_2f);
+			v[2] = std::fabs(v[2]);
+			gridX << v[0];
+			gridY << v[1];
+			gridZ << v[2];
+		}
+	}
+	// Points at and around the moon, where acos() is not computed from its power series
+	for (int i=0; i<200; ++i)
+	{
+		const Vec3f v = direction(moonAzimuth + 0.0005f*(i%20), 0.4f + 0.0005f*(i/20));
+		gridX << v[0];
+		gridY << v[1];
+		gridZ << v[2];
+	}
+	cosDistMoon.resize(gridZ.size());
+	cosDistSun.resize(gridZ.size());
+}
+
+void TestSkybright::setSky(Skybright &skyb, float sunAltitude, float moonAltitude)
+{
+	const Vec3f sun = direction(sunAzimuth, sunAltitude);
+	const Vec3f moon = direction(moonAzimuth, moonAltitude);
+	skyb.setLocation(0.8f, 200.f, 15.f, 40.f);
+	skyb.setSunMoon(moon[2], sun[2]);
+	skyb.setDate(2020, 5, 0.5f, -12.f);
+	for (int i=0; i<gridZ.size(); ++i)
+	{
+		cosDistMoon[i] = moon[0]*gridX[i] + moon[1]*gridY[i] + moon[2]*gridZ[i];
+		cosDistSun[i] = sun[0]*gridX[i] + sun[1]*gridY[i] + sun[2]*gridZ[i];
+	}
+}
+
+void TestSkybright::testBatch_data()
+{
+	QTest::addColumn<float>("sunAltitude");
+	QTest::addColumn<float>("moonAltitude");
+	QTest::newRow("day") << 0.8f << 0.4f;
+	QTest::newRow("sunset") << 0.02f << 0.4f;
+	QTest::newRow("twilight") << -0.15f << 0.4f;
+	QTest::newRow("night with moon") << -0.6f << 0.4f;
+	QTest::newRow("moon rising") << -0.6f << -0.02f;
+	QTest::newRow("night without moon") << -0.6f << -0.4f;
+}
+
+void TestSkybright::testBatch()
+{
+	QFETCH(float, sunAltitude);
+	QFETCH(float, moonAltitude);
+	Skybright skyb;
+	setSky(skyb, sunAltitude, moonAltitude);
+
+	QVector<float> luminance(gridZ.size());
+	skyb.getLuminance(gridZ.size(), cosDistMoon.constData(), cosDistSun.constData(), gridZ.constData(), luminance.data());
+	for (int i=0; i<gridZ.size(); ++i)
+	{
+		const float expected = skyb.computeLuminance(cosDistMoon[i], cosDistSun[i], gridZ[i]);
+		QVERIFY2(std::fabs(luminance[i]-expected) <= 1e-5f*expected,
+			 qPrintable(QString("point %1: %2 instead of %3").arg(i).arg(luminance[i]).arg(expected)));
+	}
+}
+
+void TestSkybright::benchmarkScalar()
+{
+	Skybright skyb;
+	setSky(skyb, -0.15f, 0.4f);
+	QVector<float> luminance(gridZ.size());
+	QBENCHMARK {
+		for (int i=0; i<gridZ.size(); ++i)
+			luminance[i] = skyb.computeLuminance(cosDistMoon[i], cosDistSun[i], gridZ[i]);
+	}
+}
+
+void TestSkybright::benchmarkBatch()
+{
+	Skybright skyb;
+	setSky(skyb, -0.15f, 0.4f);
+	QVector<float> luminance(gridZ.size());
+	QBENCHMARK {
+		skyb.getLuminance(gridZ.size(), cosDistMoon.constData(), cosDistSun.constData(), gridZ.constData(), luminance.data());
+	}
+}
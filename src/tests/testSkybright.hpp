@@ -0,0 +1,48 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef TESTSKYBRIGHT_HPP
+#define TESTSKYBRIGHT_HPP
+
+#include <QObject>
+#include <QtTest>
+#include <QVector>
+
+class Skybright;
+
+//! Compares the batch Skybright::getLuminance() with the luminance model of one position.
+class TestSkybright : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	void testBatch_data();
+	void testBatch();
+	void benchmarkScalar();
+	void benchmarkBatch();
+private:
+	//! Set up the model for the sun and the moon at the given altitudes (radians) and compute the cosines of the grid
+	void setSky(Skybright& skyb, float sunAltitude, float moonAltitude);
+
+	//! Directions of a grid over the sky, mirrored above the horizon as in Atmosphere
+	QVector<float> gridX, gridY, gridZ;
+	QVector<float> cosDistMoon, cosDistSun;
+};
+
+#endif // TESTSKYBRIGHT_HPP
@@ -0,0 +1,375 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testStarBatch.hpp"
+#include "StarBatch.hpp"
+#include "StarMgr.hpp"
+#include "ZoneArray.hpp"
+#include "StelApp.hpp"
+#include "StelCore.hpp"
+#include "StelGeodesicGrid.hpp"
+#include "StelProjectorClasses.hpp"
+#include "StelSphereGeometry.hpp"
+
+#include <QFile>
+#include <QSettings>
+#include <QThreadPool>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+QTEST_GUILESS_MAIN(TestStarBatch)
+
+static const int smallZoneSize = 20000;
+static const int bigZoneSize = 1000000;
+static const float movementFactor = 12.5f;
+// 320 zones of about 12 degrees
+static const int catalogLevel = 2;
+
+static void initTriangle(int lev, int index, const Vec3f &c0, const Vec3f &c1, const Vec3f &c2, void* context)
+{
+	if (lev==catalogLevel)
+		static_cast<ZoneArray*>(context)->initTriangle(index, c0, c1, c2);
+}
+
+void TestStarBatch::initTestCase()
+{
+	app = Q_NULLPTR;
+	core = Q_NULLPTR;
+	catalog = Q_NULLPTR;
+	qsrand(1234);
+	fillZone(zone, zoneData, smallZoneSize);
+	fillZone(bigZone, bigZoneData, bigZoneSize);
+
+	// SpecialZoneArray::draw() reads the date and the sky drawer from the core, which only need the settings
+	QVERIFY(tempDir.isValid());
+	app = new StelApp(Q_NULLPTR);
+	app->confSettings = new QSettings(tempDir.filePath("config.ini"), QSettings::IniFormat, app);
+	core = new StelCore();
+	core->JD.first = 2458849.5; // 2020-01-01
+	core->skyDrawer = new StelSkyDrawer(core);
+	StelSkyDrawer* drawer = core->getSkyDrawer();
+	// Without atmosphere the stars don't depend on the location, but they still twinkle
+	drawer->setFlagHasAtmosphere(false);
+	drawer->setFlagTwinkle(true);
+	drawer->setFlagForcedTwinkle(true);
+	drawer->setTwinkleAmount(0.3);
+
+	const QString catalogPath = tempDir.filePath("stars_test.cat");
+	writeCatalog(catalogPath, catalogLevel);
+	catalog = ZoneArray::create(catalogPath, false);
+	QVERIFY(catalog);
+	// As done by StarMgr::init()
+	StelGeodesicGrid grid(catalogLevel);
+	grid.visitTriangles(catalogLevel, initTriangle, catalog);
+	catalog->scaleAxis();
+}
+
+void TestStarBatch::cleanupTestCase()
+{
+	zone.stars = Q_NULLPTR;
+	bigZone.stars = Q_NULLPTR;
+	delete catalog;
+	catalog = Q_NULLPTR;
+	delete core;
+	core = Q_NULLPTR;
+	// The StelApp destructor expects a fully initialized application, so the instance is left to the end of the process
+}
+
+void TestStarBatch::fillZone(SpecialZoneData<Star2>& z, QByteArray& data, int n)
+{
+	// Random Star2 records: every bit pattern is a valid position and proper motion
+	data.resize(n*static_cast<int>(sizeof(Star2)));
+	for (int i=0; i<data.size(); ++i)
+		data[i] = static_cast<char>(qrand() & 0xFF);
+
+	z.center = Vec3f(0.6f, -0.3f, 0.74f);
+	z.center.normalize();
+	z.axis0 = Vec3f(0.f, 0.f, 1.f) ^ z.center;
+	z.axis0.normalize();
+	z.axis1 = z.center ^ z.axis0;
+	// A zone of about 6 degrees, as for level 3 of the geodesic grid
+	const float scale = 0.05f/Star2::MaxPosVal;
+	z.axis0 *= scale;
+	z.axis1 *= scale;
+	z.size = n;
+	z.stars = data.data();
+}
+
+void TestStarBatch::writeCatalog(const QString& fileName, int level) const
+{
+	// Header as read by ZoneArray::create(), for Star2 records
+	const unsigned int header[] = {FILE_MAGIC_NATIVE, 1, 0, 0, static_cast<unsigned int>(level), 6000, 1500, 30};
+	const int nbZones = StelGeodesicGrid::nrOfZones(level);
+	QVector<unsigned int> zoneSizes(nbZones, static_cast<unsigned int>(bigZone.size/nbZones));
+	zoneSizes.last() += static_cast<unsigned int>(bigZone.size%nbZones);
+
+	QFile file(fileName);
+	QVERIFY(file.open(QIODevice::WriteOnly));
+	file.write(reinterpret_cast<const char*>(header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(zoneSizes.constData()), nbZones*static_cast<qint64>(sizeof(unsigned int)));
+	file.write(bigZoneData);
+}
+
+StelProjectorP TestStarBatch::createProjector(const QString& type) const
+{
+	const Mat4d m = Mat4d::xrotation(0.4) * Mat4d::zrotation(2.2);
+	StelProjector::ModelViewTranformP mv(new StelProjector::Mat4dTransform(m));
+	StelProjector* prj = Q_NULLPTR;
+	if (type=="Perspective")
+		prj = new StelProjectorPerspective(mv);
+	else if (type=="EqualArea")
+		prj = new StelProjectorEqualArea(mv);
+	else if (type=="Stereographic")
+		prj = new StelProjectorStereographic(mv);
+	else if (type=="Fisheye")
+		prj = new StelProjectorFisheye(mv);
+	else if (type=="Hammer")
+		prj = new StelProjectorHammer(mv);
+	else if (type=="Cylinder")
+		prj = new StelProjectorCylinder(mv);
+	else if (type=="Mercator")
+		prj = new StelProjectorMercator(mv);
+	else if (type=="Orthographic")
+		prj = new StelProjectorOrthographic(mv);
+	else if (type=="Sinusoidal")
+		prj = new StelProjectorSinusoidal(mv);
+	else if (type=="Miller")
+		prj = new StelProjectorMiller(mv);
+	Q_ASSERT(prj);
+
+	StelProjector::StelProjectorParams params;
+	params.viewportXywh.set(0, 0, 1024, 768);
+	params.viewportCenter.set(512., 384.);
+	params.viewportFovDiameter = 768.;
+	params.fov = 60.f;
+	params.zNear = 0.000001;
+	params.zFar = 500.;
+	prj->init(params);
+	return StelProjectorP(prj);
+}
+
+void TestStarBatch::testComputePositions()
+{
+	StarBatch batch;
+	batch.decode(&zone, zone.size);
+	batch.computePositions(&zone, movementFactor);
+	QCOMPARE(batch.size(), zone.size);
+
+	const Star2* s = zone.getStars();
+	for (int i=0; i<zone.size; ++i, ++s)
+	{
+		Vec3f ref;
+		s->getJ2000Pos(&zone, movementFactor, ref);
+		ref.normalize();
+		const Vec3f v(batch.x[i], batch.y[i], batch.z[i]);
+		QVERIFY2((v-ref).length() < 1e-5f, qPrintable(QString("star %1: (%2, %3, %4) instead of (%5, %6, %7)")
+							    .arg(i).arg(static_cast<double>(v[0])).arg(static_cast<double>(v[1])).arg(static_cast<double>(v[2]))
+							    .arg(static_cast<double>(ref[0])).arg(static_cast<double>(ref[1])).arg(static_cast<double>(ref[2]))));
+	}
+}
+
+void TestStarBatch::testProject_data()
+{
+	QTest::addColumn<QString>("type");
+	QTest::newRow("Perspective") << "Perspective";
+	QTest::newRow("EqualArea") << "EqualArea";
+	QTest::newRow("Stereographic") << "Stereographic";
+	QTest::newRow("Fisheye") << "Fisheye";
+	QTest::newRow("Hammer") << "Hammer";
+	QTest::newRow("Cylinder") << "Cylinder";
+	QTest::newRow("Mercator") << "Mercator";
+	QTest::newRow("Orthographic") << "Orthographic";
+	QTest::newRow("Sinusoidal") << "Sinusoidal";
+	QTest::newRow("Miller") << "Miller";
+}
+
+void TestStarBatch::testProject()
+{
+	QFETCH(QString, type);
+	StelProjectorP prj = createProjector(type);
+
+	// Spread the stars over the whole sky to test all branches of the projections
+	StarBatch batch;
+	batch.decode(&zone, zone.size);
+	batch.computePositions(&zone, movementFactor);
+	for (int i=0; i<batch.size(); ++i)
+	{
+		const float a = 2.f*static_cast<float>(M_PI)*i/batch.size();
+		const float b = static_cast<float>(M_PI)*((i*7919)%batch.size())/batch.size() - static_cast<float>(M_PI_2);
+		batch.x[i] = std::cos(b)*std::cos(a);
+		batch.y[i] = std::cos(b)*std::sin(a);
+		batch.z[i] = std::sin(b);
+	}
+	batch.project(prj.data());
+
+	int mismatches = 0;
+	for (int i=0; i<batch.size(); ++i)
+	{
+		Vec3f v(batch.x[i], batch.y[i], batch.z[i]);
+		const bool ok = prj->projectInPlace(v);
+		if (ok != static_cast<bool>(batch.valid[i]))
+		{
+			// The validity of points exactly on a projection boundary may differ by rounding
+			++mismatches;
+			continue;
+		}
+		if (!ok)
+			continue;
+		QVERIFY2(std::fabs(v[0]-batch.winX[i]) < 1e-2f + 1e-4f*std::fabs(v[0]) &&
+			 std::fabs(v[1]-batch.winY[i]) < 1e-2f + 1e-4f*std::fabs(v[1]),
+			 qPrintable(QString("star %1: (%2, %3) instead of (%4, %5)").arg(i)
+				    .arg(static_cast<double>(batch.winX[i])).arg(static_cast<double>(batch.winY[i]))
+				    .arg(static_cast<double>(v[0])).arg(static_cast<double>(v[1]))));
+	}
+	QVERIFY2(mismatches <= batch.size()/1000, qPrintable(QString("%1 validity mismatches").arg(mismatches)));
+}
+
+static bool vertexLessThan(const StelSkyDrawer::StarVertex& a, const StelSkyDrawer::StarVertex& b)
+{
+	if (a.pos[0]!=b.pos[0])
+		return a.pos[0]<b.pos[0];
+	if (a.pos[1]!=b.pos[1])
+		return a.pos[1]<b.pos[1];
+	return memcmp(a.color, b.color, 3)<0;
+}
+
+QVector<StelSkyDrawer::StarVertex> TestStarBatch::drawJobs(int nThreads, quint32 twinkleSeed, const StelProjector* prj) const
+{
+	QThreadPool pool;
+	pool.setMaxThreadCount(qMax(1, nThreads-1));
+	QVector<StarDrawBatch> batches(nThreads);
+
+	// All the stars are bright enough to be drawn
+	RCMag rcmag;
+	rcmag.radius = 2.f;
+	rcmag.luminance = 1.f;
+	const QVector<RCMag> rcmagTable(RCMAG_TABLE_SIZE, rcmag);
+	const int limitMagIndex = RCMAG_TABLE_SIZE-1;
+	const QVector<SphericalCap> viewportCaps = prj->getViewportConvexPolygon()->getBoundingSphericalCaps();
+
+	// The zones are not preselected as done by StarMgr::prepareDraw(): the draw() of each zone has to discard
+	// the stars outside of the viewport.
+	StarMgr::runDrawJobs(&pool, nThreads, StelGeodesicGrid::nrOfZones(catalogLevel), batches.data(), twinkleSeed,
+			     [&](StarDrawBatch& batch, int j)
+	{
+		catalog->draw(batch, prj, j, false, rcmagTable.constData(), limitMagIndex, core, 0, false, viewportCaps);
+	});
+
+	QVector<StelSkyDrawer::StarVertex> vertices;
+	for (const auto& batch : batches)
+		vertices += batch.pointSources.vertices;
+	return vertices;
+}
+
+void TestStarBatch::testDrawJobs_data()
+{
+	QTest::addColumn<int>("nThreads");
+	QTest::newRow("2 threads") << 2;
+	QTest::newRow("4 threads") << 4;
+	QTest::newRow("8 threads") << 8;
+	QTest::newRow("ideal") << qMax(2, QThread::idealThreadCount());
+}
+
+void TestStarBatch::testDrawJobs()
+{
+	QFETCH(int, nThreads);
+	StelProjectorP prj = createProjector("Stereographic");
+	// The halos are blended additively, so the order in which the batches are drawn doesn't matter
+	QVector<StelSkyDrawer::StarVertex> serial = drawJobs(1, 42u, prj.data());
+	QVector<StelSkyDrawer::StarVertex> parallel = drawJobs(nThreads, 42u, prj.data());
+	QVERIFY(!serial.isEmpty());
+	QCOMPARE(parallel.size(), serial.size());
+	std::sort(serial.begin(), serial.end(), vertexLessThan);
+	std::sort(parallel.begin(), parallel.end(), vertexLessThan);
+	for (int i=0; i<serial.size(); ++i)
+	{
+		QVERIFY2(!vertexLessThan(serial.at(i), parallel.at(i)) && !vertexLessThan(parallel.at(i), serial.at(i)),
+			 qPrintable(QString("vertex %1 differs").arg(i)));
+	}
+
+	// The stars twinkle from one frame to the next
+	QVector<StelSkyDrawer::StarVertex> nextFrame = drawJobs(nThreads, 43u, prj.data());
+	std::sort(nextFrame.begin(), nextFrame.end(), vertexLessThan);
+	int changed = 0;
+	for (int i=0; i<serial.size(); ++i)
+		changed += (memcmp(serial.at(i).color, nextFrame.at(i).color, 3)!=0) ? 1 : 0;
+	QVERIFY(changed > serial.size()/2);
+}
+
+void TestStarBatch::benchmarkStarsPerSecond_data()
+{
+	testProject_data();
+}
+
+void TestStarBatch::benchmarkScalarStarsPerSecond_data()
+{
+	testProject_data();
+}
+
+void TestStarBatch::benchmarkScalarStarsPerSecond()
+{
+	QFETCH(QString, type);
+	StelProjectorP prj = createProjector(type);
+	const int n = bigZone.size;
+
+	// Reference: one star at a time, as done before the batch kernel
+	QBENCHMARK {
+		const Star2* s = bigZone.getStars();
+		for (int i=0; i<n; ++i, ++s)
+		{
+			Vec3f v;
+			s->getJ2000Pos(&bigZone, movementFactor, v);
+			v.normalize();
+			prj->projectInPlace(v);
+		}
+	}
+}
+
+void TestStarBatch::benchmarkStarsPerSecond()
+{
+	QFETCH(QString, type);
+	StelProjectorP prj = createProjector(type);
+	StarBatch batch;
+	const int n = bigZone.size;
+
+	QBENCHMARK {
+		batch.decode(&bigZone, n);
+		batch.computePositions(&bigZone, movementFactor);
+		batch.project(prj.data());
+	}
+}
+
+void TestStarBatch::benchmarkDrawJobs_data()
+{
+	QTest::addColumn<int>("nThreads");
+	QTest::newRow("1 thread") << 1;
+	QTest::newRow("2 threads") << 2;
+	QTest::newRow("4 threads") << 4;
+	QTest::newRow("ideal") << qMax(1, QThread::idealThreadCount());
+}
+
+void TestStarBatch::benchmarkDrawJobs()
+{
+	QFETCH(int, nThreads);
+	StelProjectorP prj = createProjector("Stereographic");
+	QBENCHMARK {
+		drawJobs(nThreads, 42u, prj.data());
+	}
+}
@@ -0,0 +1,71 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef TESTSTARBATCH_HPP
+#define TESTSTARBATCH_HPP
+
+#include <QObject>
+#include <QtTest>
+
+#include "ZoneData.hpp"
+#include "Star.hpp"
+#include "StelProjector.hpp"
+#include "StelSkyDrawer.hpp"
+
+class StelApp;
+class StelCore;
+class ZoneArray;
+
+class TestStarBatch : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void testComputePositions();
+	void testProject_data();
+	void testProject();
+	void testDrawJobs_data();
+	void testDrawJobs();
+	void benchmarkScalarStarsPerSecond_data();
+	void benchmarkScalarStarsPerSecond();
+	void benchmarkStarsPerSecond_data();
+	void benchmarkStarsPerSecond();
+	void benchmarkDrawJobs_data();
+	void benchmarkDrawJobs();
+private:
+	void fillZone(SpecialZoneData<Star2>& zone, QByteArray& data, int n);
+	StelProjectorP createProjector(const QString& type) const;
+	//! Write the stars of bigZone as a star catalog of the given geodesic grid level.
+	void writeCatalog(const QString& fileName, int level) const;
+	//! Draw all the zones of the catalog with SpecialZoneArray::draw() and StarMgr::runDrawJobs()
+	//! in nThreads threads, and return all the vertices of the batches.
+	QVector<StelSkyDrawer::StarVertex> drawJobs(int nThreads, quint32 twinkleSeed, const StelProjector* prj) const;
+
+	SpecialZoneData<Star2> zone, bigZone;
+	QByteArray zoneData, bigZoneData;
+	QTemporaryDir tempDir;
+	//! A core with only a sky drawer, as needed by SpecialZoneArray::draw()
+	StelApp* app;
+	StelCore* core;
+	//! bigZone spread over the zones of a catalog, each zone drawn by a separate job
+	ZoneArray* catalog;
+};
+
+#endif // TESTSTARBATCH_HPP
@@ -0,0 +1,238 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testStarZoneBuffers.hpp"
+#include "StarZoneBuffers.hpp"
+#include "ZoneArray.hpp"
+
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+
+// OpenGL needs a QGuiApplication, the test is run with the offscreen platform
+QTEST_MAIN(TestStarZoneBuffers)
+
+static const double J2000 = 2451545.0;
+// 256 kB per zone
+static const int starsPerZone = 256*1024/(6*static_cast<int>(sizeof(StelSkyDrawer::PointSourceBufferVertex)));
+static const qint64 zoneBufferSize = starsPerZone*6*static_cast<qint64>(sizeof(StelSkyDrawer::PointSourceBufferVertex));
+
+//! A catalog of level 1 with the same number of stars in each zone, which records the uploads of its zones
+class TestZoneArray : public ZoneArray
+{
+public:
+	explicit TestZoneArray(bool properMotions)
+		: ZoneArray(QString(), Q_NULLPTR, 1, 0, 1000, 30)
+		, properMotions(properMotions)
+		, uploads(static_cast<int>(nr_of_zones), 0)
+		, lastMovementFactor(0.f)
+	{
+		star_position_scale = 1.f;
+	}
+
+	virtual void searchAround(const StelCore*, int, const Vec3d&, double, QList<StelObjectP>&) {}
+	virtual void draw(StarDrawBatch&, const StelProjector*, int, bool, const RCMag*, int, const StelCore*,
+			  int, bool, const QVector<SphericalCap>&) const {}
+	virtual bool hasStarNames() const {return false;}
+	virtual bool hasProperMotions() const {return properMotions;}
+	virtual int getNrOfStarsToDraw(int, int) const {return starsPerZone;}
+	virtual void fillPointSourceBuffer(StarBatch&, int index, float movementFactor,
+					   QVector<StelSkyDrawer::PointSourceBufferVertex>& vertices) const
+	{
+		vertices.fill(StelSkyDrawer::PointSourceBufferVertex(), starsPerZone*6);
+		++uploads[index];
+		lastMovementFactor = movementFactor;
+	}
+	virtual void scaleAxis() {}
+
+	const bool properMotions;
+	mutable QVector<int> uploads;
+	mutable float lastMovementFactor;
+};
+
+void TestStarZoneBuffers::initTestCase()
+{
+	surface = new QOffscreenSurface();
+	surface->create();
+	context = new QOpenGLContext();
+	if (!context->create() || !context->makeCurrent(surface))
+	{
+		delete context;
+		context = Q_NULLPTR;
+	}
+}
+
+void TestStarZoneBuffers::cleanupTestCase()
+{
+	if (context)
+		context->doneCurrent();
+	delete context;
+	delete surface;
+}
+
+void TestStarZoneBuffers::testEpochBuckets()
+{
+	StarZoneBuffers buffers;
+	buffers.setEpochBucketYears(1.);
+	QCOMPARE(buffers.getEpochBucket(J2000), 0);
+	QCOMPARE(buffers.getEpochBucket(J2000+365.), 0);
+	QCOMPARE(buffers.getEpochBucket(J2000+365.5), 1);
+	QCOMPARE(buffers.getEpochBucket(J2000-1.), -1);
+	QCOMPARE(buffers.getEpochBucketJDE(0), J2000+182.625);
+	QCOMPARE(buffers.getEpochBucketJDE(-1), J2000-182.625);
+
+	buffers.setEpochBucketYears(10.);
+	QCOMPARE(buffers.getEpochBucket(J2000+3000.), 0);
+	QCOMPARE(buffers.getEpochBucket(J2000+4000.), 1);
+	QCOMPARE(buffers.getEpochBucketJDE(1), J2000+5478.75);
+
+	// The length of the buckets has a lower limit
+	buffers.setEpochBucketYears(0.);
+	QCOMPARE(buffers.getEpochBucketYears(), 0.01);
+}
+
+void TestStarZoneBuffers::testNoContext()
+{
+	// Without OpenGL, all zones are drawn from the CPU
+	if (context)
+		context->doneCurrent();
+	TestZoneArray zoneArray(true);
+	StarZoneBuffers buffers;
+	buffers.beginFrame(J2000);
+	for (int zone=0; zone<4; ++zone)
+		QVERIFY(buffers.getBuffer(&zoneArray, zone)==Q_NULLPTR);
+	buffers.endFrame();
+	QCOMPARE(buffers.getNrOfBuffers(), 0);
+	QCOMPARE(buffers.getMemoryUsage(), Q_INT64_C(0));
+	QCOMPARE(zoneArray.uploads.count(0), zoneArray.uploads.size());
+	if (context)
+		QVERIFY(context->makeCurrent(surface));
+}
+
+void TestStarZoneBuffers::testUploadLimit()
+{
+	if (!context)
+		QSKIP("No OpenGL context");
+	TestZoneArray zoneArray(true);
+	StarZoneBuffers buffers;
+	buffers.setMaxUploadedStarsPerFrame(2*starsPerZone);
+
+	// The zones over the limit of the frame are drawn from the CPU, and uploaded in the next frames
+	buffers.beginFrame(J2000);
+	QVERIFY(buffers.getBuffer(&zoneArray, 0)!=Q_NULLPTR);
+	QVERIFY(buffers.getBuffer(&zoneArray, 1)!=Q_NULLPTR);
+	QVERIFY(buffers.getBuffer(&zoneArray, 2)==Q_NULLPTR);
+	QVERIFY(buffers.getBuffer(&zoneArray, 3)==Q_NULLPTR);
+	QCOMPARE(buffers.getNrOfUploadedStars(), 2*starsPerZone);
+	buffers.endFrame();
+	QCOMPARE(buffers.getNrOfBuffers(), 2);
+
+	buffers.beginFrame(J2000);
+	for (int zone=0; zone<4; ++zone)
+		QVERIFY(buffers.getBuffer(&zoneArray, zone)!=Q_NULLPTR);
+	buffers.endFrame();
+	QCOMPARE(buffers.getNrOfBuffers(), 4);
+	QCOMPARE(buffers.getMemoryUsage(), 4*zoneBufferSize);
+	QCOMPARE(zoneArray.uploads.mid(0, 4), QVector<int>(4, 1));
+}
+
+void TestStarZoneBuffers::testEpochUploads()
+{
+	if (!context)
+		QSKIP("No OpenGL context");
+	TestZoneArray moving(true), fixed(false);
+	StarZoneBuffers buffers;
+	buffers.setEpochBucketYears(1.);
+
+	// Both catalogs have the same level, so they must use different zones
+	buffers.beginFrame(J2000+10.);
+	QVERIFY(buffers.getBuffer(&moving, 0)!=Q_NULLPTR);
+	QVERIFY(buffers.getBuffer(&fixed, 1)!=Q_NULLPTR);
+	buffers.endFrame();
+	QCOMPARE(moving.uploads.at(0), 1);
+	QCOMPARE(moving.lastMovementFactor, moving.getMovementFactor(buffers.getEpochBucketJDE(0)));
+	QCOMPARE(fixed.uploads.at(1), 1);
+
+	// Same bucket
+	buffers.beginFrame(J2000+300.);
+	buffers.getBuffer(&moving, 0);
+	buffers.getBuffer(&fixed, 1);
+	buffers.endFrame();
+	QCOMPARE(moving.uploads.at(0), 1);
+	QCOMPARE(fixed.uploads.at(1), 1);
+
+	// Next bucket: only the stars with proper motions are uploaded again
+	buffers.beginFrame(J2000+400.);
+	buffers.getBuffer(&moving, 0);
+	buffers.getBuffer(&fixed, 1);
+	buffers.endFrame();
+	QCOMPARE(moving.uploads.at(0), 2);
+	QCOMPARE(moving.lastMovementFactor, moving.getMovementFactor(buffers.getEpochBucketJDE(1)));
+	QCOMPARE(fixed.uploads.at(1), 1);
+	QCOMPARE(buffers.getNrOfBuffers(), 2);
+	QCOMPARE(buffers.getMemoryUsage(), 2*zoneBufferSize);
+}
+
+void TestStarZoneBuffers::testRelease()
+{
+	if (!context)
+		QSKIP("No OpenGL context");
+	TestZoneArray zoneArray(false);
+	StarZoneBuffers buffers;
+	buffers.setMemoryLimit(1); // 4 zones
+	auto drawFrame = [&](const QVector<int>& left, const QVector<int>& drawn)
+	{
+		buffers.beginFrame(J2000);
+		buffers.updateZonesInView(&zoneArray, QVector<int>(), left);
+		for (int zone : drawn)
+			QVERIFY(buffers.getBuffer(&zoneArray, zone)!=Q_NULLPTR);
+		buffers.endFrame();
+	};
+
+	drawFrame({}, {0, 1, 2, 3});
+	drawFrame({0}, {1, 2, 3});
+	drawFrame({1}, {2, 3});
+	QCOMPARE(buffers.getNrOfBuffers(), 4);
+
+	// Over the limit: the zones out of the view are released, the first one to leave first
+	drawFrame({}, {2, 3, 4});
+	QCOMPARE(buffers.getNrOfBuffers(), 4);
+	drawFrame({}, {2, 3, 4, 5});
+	QCOMPARE(buffers.getNrOfBuffers(), 4);
+	QCOMPARE(buffers.getMemoryUsage(), 4*zoneBufferSize);
+	drawFrame({}, {0, 2, 3, 4, 5});
+	QCOMPARE(zoneArray.uploads.at(0), 2);
+	QCOMPARE(zoneArray.uploads.at(1), 1);
+
+	// The zones in the view are kept over the limit, even those not drawn in the frame
+	buffers.setMemoryLimit(0);
+	drawFrame({}, {2});
+	QCOMPARE(buffers.getNrOfBuffers(), 5);
+	drawFrame({0, 3}, {2});
+	QCOMPARE(buffers.getNrOfBuffers(), 3);
+
+	// Entering the view again keeps a buffer
+	buffers.setAllOutOfView();
+	buffers.updateZonesInView(&zoneArray, {2, 4}, QVector<int>());
+	buffers.beginFrame(J2000);
+	buffers.endFrame();
+	QCOMPARE(buffers.getNrOfBuffers(), 2);
+	buffers.clear();
+	QCOMPARE(buffers.getNrOfBuffers(), 0);
+	QCOMPARE(buffers.getMemoryUsage(), Q_INT64_C(0));
+}
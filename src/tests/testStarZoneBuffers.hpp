@@ -0,0 +1,47 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef TESTSTARZONEBUFFERS_HPP
+#define TESTSTARZONEBUFFERS_HPP
+
+#include <QObject>
+#include <QtTest>
+
+class QOffscreenSurface;
+class QOpenGLContext;
+
+//! Tests the epoch buckets, the release of the buffers and the zones left to the CPU path of StarZoneBuffers,
+//! with a catalog of generated zones. The tests which upload buffers are skipped without OpenGL.
+class TestStarZoneBuffers : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void testEpochBuckets();
+	void testNoContext();
+	void testUploadLimit();
+	void testEpochUploads();
+	void testRelease();
+private:
+	QOffscreenSurface* surface;
+	QOpenGLContext* context;
+};
+
+#endif // TESTSTARZONEBUFFERS_HPP
@@ -0,0 +1,221 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "tests/testStelGeodesicGrid.hpp"
+#include "StelGeodesicGrid.hpp"
+
+#include <QElapsedTimer>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestStelGeodesicGrid)
+
+// The levels used by StarMgr
+static const int gridLevel = 7;
+static const int searchLevel = 6;
+static const int frameCount = 200;
+
+// The bounding caps of a rectangular viewport and the cap above the horizon, as in StarMgr::draw()
+static QVector<SphericalCap> viewportCaps(const Vec3d& dir, double fovDegrees, const Vec3d& zenith)
+{
+	const Vec3d up(0., 0., 1.);
+	Vec3d right = dir^up;
+	right.normalize();
+	const Vec3d top = right^dir;
+	const double h = std::tan(fovDegrees*M_PI/360.);
+	const double w = 1.6*h;
+	const Vec3d corners[4] = { dir+right*w+top*h, dir-right*w+top*h, dir-right*w-top*h, dir+right*w-top*h };
+	QVector<SphericalCap> caps;
+	for (int i=0; i<4; ++i)
+	{
+		Vec3d n = corners[i]^corners[(i+1)%4];
+		n.normalize();
+		if (n*dir < 0.)
+			n = -n;
+		caps.append(SphericalCap(n, 0.));
+	}
+	caps.append(SphericalCap(zenith, -0.02));
+	return caps;
+}
+
+// The zones returned by the iterators, with the inside ones as 2*zone+1 and the border ones as 2*zone
+static QVector<int> getZones(const GeodesicSearchResult& result, int level)
+{
+	QVector<int> zones;
+	int zone;
+	for (GeodesicSearchInsideIterator it(result, level); (zone = it.next()) >= 0;)
+		zones.append(2*zone+1);
+	for (GeodesicSearchBorderIterator it(result, level); (zone = it.next()) >= 0;)
+		zones.append(2*zone);
+	std::sort(zones.begin(), zones.end());
+	return zones;
+}
+
+void TestStelGeodesicGrid::initTestCase()
+{
+	const Vec3d up(0., 0., 1.);
+	const Vec3d start(0.8, 0.2, 0.3);
+	const Vec3d zenith(0.1, 0.3, 0.9);
+	struct Motion
+	{
+		const char* name;
+		double fov;
+		//! degrees per frame, relative to the field of view
+		double panRate;
+		double zoomRate;
+		//! degrees per frame of the diurnal motion of the horizon
+		double timeRate;
+	};
+	const Motion motions[] = {
+		{ "slow pan 60 deg", 60., 0.001, 1., 0. },
+		{ "slow pan 5 deg", 5., 0.001, 1., 0. },
+		{ "slow pan, time running", 60., 0.001, 1., 0.004 },
+		{ "fast pan 60 deg", 60., 0.03, 1., 0. },
+		{ "zoom in", 100., 0., 0.98, 0. },
+		{ "zoom out", 2., 0., 1.02, 0. }
+	};
+	for (const auto& motion : motions)
+	{
+		Sequence sequence;
+		Vec3d dir = start;
+		dir.normalize();
+		Vec3d z = zenith;
+		z.normalize();
+		double fov = motion.fov;
+		for (int f=0; f<frameCount; ++f)
+		{
+			sequence.append(viewportCaps(dir, fov, z));
+			dir = Mat4d::rotation(up, motion.panRate*fov*M_PI/180.)*dir;
+			z = Mat4d::rotation(Vec3d(1., 0., 0.), motion.timeRate*M_PI/180.)*z;
+			fov *= motion.zoomRate;
+		}
+		sequences.insert(motion.name, sequence);
+	}
+
+	// A small cap as in StarMgr::searchAround(), which is not bounded by a great circle
+	Sequence sequence;
+	Vec3d dir = start;
+	dir.normalize();
+	for (int f=0; f<frameCount; ++f)
+	{
+		sequence.append(QVector<SphericalCap>() << SphericalCap(dir, std::cos(2.*M_PI/180.)));
+		dir = Mat4d::rotation(up, 0.05*M_PI/180.)*dir;
+	}
+	sequences.insert("small cap", sequence);
+}
+
+void TestStelGeodesicGrid::testUpdate_data()
+{
+	QTest::addColumn<QString>("sequence");
+	for (const auto& name : sequences.keys())
+		QTest::newRow(name.toLatin1().constData()) << name;
+}
+
+void TestStelGeodesicGrid::testUpdate()
+{
+	QFETCH(QString, sequence);
+	const StelGeodesicGrid grid(gridLevel);
+	GeodesicSearchResult result(grid);
+	const Sequence& frames = sequences.value(sequence);
+	for (int f=0; f<frames.size(); ++f)
+	{
+		result.update(frames.at(f), searchLevel);
+		const GeodesicSearchResult* expected = grid.search(frames.at(f), searchLevel);
+		for (int level=0; level<=gridLevel; ++level)
+		{
+			QVERIFY2(getZones(result, level)==getZones(*expected, level),
+				 qPrintable(QString("frame %1, level %2").arg(f).arg(level)));
+		}
+	}
+}
+
+void TestStelGeodesicGrid::testZoneChanges()
+{
+	const StelGeodesicGrid grid(gridLevel);
+	for (const auto& name : sequences.keys())
+	{
+		GeodesicSearchResult result(grid);
+		QVector<int> previous[gridLevel+1];
+		const Sequence& frames = sequences.value(name);
+		for (int f=0; f<frames.size(); ++f)
+		{
+			result.update(frames.at(f), searchLevel);
+			for (int level=0; level<=gridLevel; ++level)
+			{
+				const QVector<int> zones = getZones(result, level);
+				QVector<int> diff;
+				QVector<int> expectedEntered, expectedLeft;
+				std::set_difference(zones.constBegin(), zones.constEnd(), previous[level].constBegin(),
+						    previous[level].constEnd(), std::back_inserter(diff));
+				for (int z : diff)
+					expectedEntered.append(z/2);
+				diff.clear();
+				std::set_difference(previous[level].constBegin(), previous[level].constEnd(), zones.constBegin(),
+						    zones.constEnd(), std::back_inserter(diff));
+				for (int z : diff)
+					expectedLeft.append(z/2);
+
+				QVector<int> entered, left;
+				result.getZoneChanges(level, entered, left);
+				QVERIFY2(entered==expectedEntered && left==expectedLeft,
+					 qPrintable(QString("%1, frame %2, level %3").arg(name).arg(f).arg(level)));
+				previous[level] = zones;
+			}
+		}
+	}
+}
+
+void TestStelGeodesicGrid::benchmarkPanZoom()
+{
+	const StelGeodesicGrid grid(gridLevel);
+	QElapsedTimer timer;
+	for (const auto& name : sequences.keys())
+	{
+		const Sequence& frames = sequences.value(name);
+
+		timer.start();
+		for (const auto& caps : frames)
+			grid.search(caps, searchLevel);
+		const double searchUs = timer.nsecsElapsed()*1e-3/frames.size();
+
+		GeodesicSearchResult result(grid);
+		timer.restart();
+		for (const auto& caps : frames)
+			result.update(caps, searchLevel);
+		const double updateUs = timer.nsecsElapsed()*1e-3/frames.size();
+
+		GeodesicSearchResult resultWithChanges(grid);
+		QVector<int> entered, left;
+		int changes = 0;
+		timer.restart();
+		for (const auto& caps : frames)
+		{
+			resultWithChanges.update(caps, searchLevel);
+			resultWithChanges.getZoneChanges(searchLevel, entered, left);
+			changes += entered.size()+left.size();
+		}
+		const double changesUs = timer.nsecsElapsed()*1e-3/frames.size();
+
+		qDebug() << name << "- full search:" << searchUs << "us/frame, update:" << updateUs
+			 << "us/frame, update and zone changes:" << changesUs << "us/frame,"
+			 << static_cast<double>(changes)/frames.size() << "zone changes/frame";
+	}
+}
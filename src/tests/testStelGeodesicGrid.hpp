@@ -0,0 +1,43 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef TESTSTELGEODESICGRID_HPP
+#define TESTSTELGEODESICGRID_HPP
+
+#include <QObject>
+#include <QtTest>
+
+#include "StelSphereGeometry.hpp"
+
+class TestStelGeodesicGrid : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	void testUpdate_data();
+	void testUpdate();
+	void testZoneChanges();
+	void benchmarkPanZoom();
+private:
+	//! A sequence of viewport regions, one per frame
+	typedef QVector<QVector<SphericalCap>> Sequence;
+	QMap<QString, Sequence> sequences;
+};
+
+#endif // TESTSTELGEODESICGRID_HPP
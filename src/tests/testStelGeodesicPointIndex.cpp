@@ -0,0 +1,156 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testStelGeodesicPointIndex.hpp"
+#include "StelGeodesicPointIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestStelGeodesicPointIndex)
+
+// As many points as in the extended DSO catalog
+static const int pointCount = 94000;
+static const int queryCount = 10000;
+
+Vec3d TestStelGeodesicPointIndex::randomPoint() const
+{
+	Vec3d v;
+	do
+	{
+		v.set(2.*qrand()/RAND_MAX-1., 2.*qrand()/RAND_MAX-1., 2.*qrand()/RAND_MAX-1.);
+	} while (v.lengthSquared()>1. || v.lengthSquared()<0.01);
+	v.normalize();
+	return v;
+}
+
+void TestStelGeodesicPointIndex::initTestCase()
+{
+	qsrand(4321);
+	for (int i=0; i<pointCount; ++i)
+		points.append(randomPoint());
+	// some duplicates to check the tie breaking of findNearest()
+	for (int i=0; i<20; ++i)
+		points.append(points.at(i));
+	for (int i=0; i<queryCount; ++i)
+		queries.append(randomPoint());
+}
+
+void TestStelGeodesicPointIndex::testFindInCone_data()
+{
+	QTest::addColumn<double>("radius");
+	QTest::newRow("0.01 deg") << 0.01;
+	QTest::newRow("2.5 deg") << 2.5;
+	QTest::newRow("10 deg") << 10.;
+	QTest::newRow("100 deg") << 100.;
+	QTest::newRow("180 deg") << 180.;
+}
+
+void TestStelGeodesicPointIndex::testFindInCone()
+{
+	QFETCH(double, radius);
+	const double cosRadius = std::cos(radius*M_PI/180.);
+	StelGeodesicPointIndex index;
+	for (int i=0; i<points.size(); ++i)
+		index.insert(points.at(i), i);
+	index.build();
+	QCOMPARE(index.size(), points.size());
+
+	for (int q=0; q<200; ++q)
+	{
+		const Vec3d& v = queries.at(q);
+		QVector<int> expected, found;
+		for (int i=0; i<points.size(); ++i)
+		{
+			if (points.at(i)*v >= cosRadius)
+				expected.append(i);
+		}
+		index.findInCone(v, cosRadius, found);
+		std::sort(found.begin(), found.end());
+		QCOMPARE(found, expected);
+	}
+}
+
+void TestStelGeodesicPointIndex::testFindNearest()
+{
+	StelGeodesicPointIndex index;
+	for (int i=0; i<points.size(); ++i)
+		index.insert(points.at(i), i);
+
+	// the linear fallback before build() and the index have to agree with a full scan
+	for (int pass=0; pass<2; ++pass)
+	{
+		for (int q=0; q<500; ++q)
+		{
+			const Vec3d& v = queries.at(q);
+			int expected = -1;
+			double best = 0.999;
+			for (int i=0; i<points.size(); ++i)
+			{
+				if (points.at(i)*v > best)
+				{
+					best = points.at(i)*v;
+					expected = i;
+				}
+			}
+			QCOMPARE(index.findNearest(v, 0.999), expected);
+		}
+		index.build();
+	}
+
+	for (int i=0; i<20; ++i)
+		QCOMPARE(index.findNearest(points.at(i), 0.999), i);
+}
+
+void TestStelGeodesicPointIndex::benchmarkLinearConeQueries()
+{
+	// The linear scan the index replaces
+	const double cosRadius = std::cos(0.5*M_PI/180.);
+	QVector<int> result;
+	QBENCHMARK {
+		for (const auto& v : queries)
+		{
+			result.clear();
+			for (int i=0; i<points.size(); ++i)
+			{
+				if (points.at(i)*v >= cosRadius)
+					result.append(i);
+			}
+		}
+	}
+}
+
+void TestStelGeodesicPointIndex::benchmarkConeQueries()
+{
+	// A typical searchAround() call for a mouse click
+	const double cosRadius = std::cos(0.5*M_PI/180.);
+	StelGeodesicPointIndex index;
+	for (int i=0; i<points.size(); ++i)
+		index.insert(points.at(i), i);
+	index.build();
+
+	QVector<int> result;
+	QBENCHMARK {
+		for (const auto& v : queries)
+		{
+			result.clear();
+			index.findInCone(v, cosRadius, result);
+		}
+	}
+}
@@ -0,0 +1,289 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testStelLocationIndex.hpp"
+#include "StelLocationIndex.hpp"
+#include "StelLocationCache.hpp"
+#include "StelUtils.hpp"
+
+#include <QDataStream>
+#include <QTemporaryDir>
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestStelLocationIndex)
+
+// About as many locations as in base_locations.txt
+static const int earthCount = 40000;
+static const int marsCount = 60;
+static const int queryCount = 10000;
+
+static float randomLongitude()
+{
+	return 360.f*qrand()/RAND_MAX - 180.f;
+}
+
+static float randomLatitude()
+{
+	// uniform on the sphere
+	return static_cast<float>(std::asin(2.*qrand()/RAND_MAX - 1.)*180./M_PI);
+}
+
+void TestStelLocationIndex::initTestCase()
+{
+	qsrand(1234);
+	const QStringList countries = { "France", "Chile", "Japan", "Namibia", "Canada", "" };
+	const QStringList zones = { "Europe/Paris", "America/Santiago", "Asia/Tokyo", "Africa/Windhoek", "America/Toronto", "LMST" };
+	for (int i=0; i<earthCount+marsCount; ++i)
+	{
+		StelLocation loc;
+		loc.name = QString("Site %1").arg(i);
+		loc.country = countries.at(i % countries.size());
+		loc.state = (i % 3) ? QString("State %1").arg(i % 50) : QString();
+		loc.planetName = i < earthCount ? "Earth" : "Mars";
+		loc.longitude = randomLongitude();
+		loc.latitude = randomLatitude();
+		loc.altitude = i % 4000;
+		loc.bortleScaleIndex = 1 + i % 9;
+		loc.population = i*7;
+		loc.role = QChar("CRNOLX"[i % 6]);
+		loc.ianaTimeZone = zones.at(i % zones.size());
+		loc.landscapeKey = (i % 10) ? QString() : QString("guereins");
+		loc.isUserLocation = false;
+		locations.insert(loc.getID(), loc);
+	}
+	// a few locations at the same place as "Site 0", and at the poles
+	const StelLocation site0 = locations.value("Site 0, France");
+	for (int i=0; i<3; ++i)
+	{
+		StelLocation loc = site0;
+		loc.name = QString("Site 0 %1").arg(i);
+		locations.insert(loc.getID(), loc);
+		loc.name = QString("Pole %1").arg(i);
+		loc.latitude = i==1 ? 90.f : -90.f;
+		locations.insert(loc.getID(), loc);
+	}
+	for (int i=0; i<queryCount; ++i)
+		queries.append(qMakePair(randomLongitude(), randomLatitude()));
+}
+
+QString TestStelLocationIndex::scanNearest(const QString& planet, float longitude, float latitude, float maxDistance, float* distance) const
+{
+	QString best;
+	float bestDistance = maxDistance;
+	for (auto it = locations.constBegin(); it != locations.constEnd(); ++it)
+	{
+		if (it.value().planetName != planet)
+			continue;
+		const float d = StelLocation::distanceDegrees(longitude, latitude, it.value().longitude, it.value().latitude);
+		if (d <= bestDistance)
+		{
+			bestDistance = d;
+			best = it.key();
+		}
+	}
+	*distance = bestDistance;
+	return best;
+}
+
+void TestStelLocationIndex::testFindInRadius_data()
+{
+	QTest::addColumn<QString>("planet");
+	QTest::addColumn<float>("radius");
+	// The radii used by StelCore and the location dialog
+	QTest::newRow("Earth 1 deg") << "Earth" << 1.f;
+	QTest::newRow("Earth 5 deg") << "Earth" << 5.f;
+	QTest::newRow("Mars 30 deg") << "Mars" << 30.f;
+	QTest::newRow("Mars 180 deg") << "Mars" << 180.f;
+	QTest::newRow("Moon 30 deg") << "Moon" << 30.f;
+}
+
+void TestStelLocationIndex::testFindInRadius()
+{
+	QFETCH(QString, planet);
+	QFETCH(float, radius);
+	StelLocationIndex index;
+	index.build(locations);
+	QCOMPARE(index.size(), locations.size());
+
+	for (int q=0; q<200; ++q)
+	{
+		const float lon = queries.at(q).first;
+		const float lat = queries.at(q).second;
+		QStringList expected;
+		for (auto it = locations.constBegin(); it != locations.constEnd(); ++it)
+		{
+			const StelLocation& loc = it.value();
+			if (loc.planetName == planet && StelLocation::distanceDegrees(lon, lat, loc.longitude, loc.latitude) <= radius)
+				expected.append(it.key());
+		}
+		QCOMPARE(index.findInRadius(planet, lon, lat, radius), expected);
+	}
+}
+
+void TestStelLocationIndex::testFindNearest()
+{
+	StelLocationIndex index;
+	index.build(locations);
+
+	for (int q=0; q<1000; ++q)
+	{
+		const float lon = queries.at(q).first;
+		const float lat = queries.at(q).second;
+		const QString& planet = q%2 ? "Earth" : "Mars";
+		float expectedDistance;
+		const QString expected = scanNearest(planet, lon, lat, 180.f, &expectedDistance);
+		const QString found = index.findNearest(planet, lon, lat);
+		QVERIFY(!found.isEmpty());
+		// The index compares in double precision, the scan in single precision, so only the distances have to agree
+		const StelLocation& loc = locations.value(found);
+		QVERIFY2(qAbs(StelLocation::distanceDegrees(lon, lat, loc.longitude, loc.latitude) - expectedDistance) < 1e-3f,
+			 qPrintable(QString("%1 instead of %2").arg(found, expected)));
+	}
+
+	// of several locations at the same place, the first by ID is returned
+	const StelLocation& site0 = locations.value("Site 0, France");
+	QCOMPARE(index.findNearest("Earth", site0.longitude, site0.latitude, 0.1f), QString("Site 0 0, France"));
+	QCOMPARE(index.findNearest("Earth", site0.longitude + 10.f, site0.latitude, 0.001f), QString());
+	QCOMPARE(index.findNearest("Moon", 0.f, 0.f), QString());
+}
+
+void TestStelLocationIndex::testCache()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString dataFile = dir.path() + "/locations.bin";
+	QFile data(dataFile);
+	QVERIFY(data.open(QIODevice::WriteOnly));
+	data.write("data");
+	data.close();
+
+	const QString cacheFile = dir.path() + "/cache/locations.cache";
+	const QByteArray key = StelLocationCache::getCacheKey(dataFile);
+	QVERIFY(StelLocationCache::save(cacheFile, key, locations));
+
+	QMap<QString, StelLocation> loaded;
+	QVERIFY(StelLocationCache::load(cacheFile, key, loaded));
+	QCOMPARE(loaded.size(), locations.size());
+	QCOMPARE(loaded.keys(), locations.keys());
+	for (auto it = locations.constBegin(); it != locations.constEnd(); ++it)
+	{
+		const StelLocation& a = it.value();
+		const StelLocation& b = loaded.value(it.key());
+		QCOMPARE(b.name, a.name);
+		QCOMPARE(b.state, a.state);
+		QCOMPARE(b.country, a.country);
+		QCOMPARE(b.planetName, a.planetName);
+		QCOMPARE(b.longitude, a.longitude);
+		QCOMPARE(b.latitude, a.latitude);
+		QCOMPARE(b.altitude, a.altitude);
+		QCOMPARE(b.bortleScaleIndex, a.bortleScaleIndex);
+		QCOMPARE(b.population, a.population);
+		QCOMPARE(b.role, a.role);
+		QCOMPARE(b.ianaTimeZone, a.ianaTimeZone);
+		QCOMPARE(b.landscapeKey, a.landscapeKey);
+		QCOMPARE(b.isUserLocation, a.isUserLocation);
+	}
+	// the repeated strings are shared
+	const StelLocation& l0 = loaded.value(locations.keys().at(0));
+	for (const auto& loc : loaded)
+	{
+		if (loc.ianaTimeZone == l0.ianaTimeZone)
+			QCOMPARE(loc.ianaTimeZone.constData(), l0.ianaTimeZone.constData());
+	}
+
+	// an outdated cache is ignored
+	QVERIFY(!StelLocationCache::load(cacheFile, QByteArray(20, 'x'), loaded));
+	QVERIFY(!StelLocationCache::load(dir.path() + "/missing.cache", key, loaded));
+}
+
+void TestStelLocationIndex::benchmarkStreamLoad()
+{
+	// base_locations.bin.gz is a compressed QDataStream of the map
+	QByteArray stream;
+	{
+		QDataStream out(&stream, QIODevice::WriteOnly);
+		out.setVersion(QDataStream::Qt_5_2);
+		out << locations;
+	}
+	const QByteArray compressed = qCompress(stream).mid(4); // zlib stream without the Qt size prefix
+
+	QMap<QString, StelLocation> streamed;
+	QBENCHMARK {
+		streamed.clear();
+		QDataStream in(StelUtils::uncompress(compressed));
+		in.setVersion(QDataStream::Qt_5_2);
+		in >> streamed;
+	}
+	QCOMPARE(streamed.size(), locations.size());
+}
+
+void TestStelLocationIndex::benchmarkCacheLoad()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString cacheFile = dir.path() + "/locations.cache";
+	const QByteArray key(20, 'k');
+	QVERIFY(StelLocationCache::save(cacheFile, key, locations));
+
+	QMap<QString, StelLocation> cached;
+	QBENCHMARK {
+		StelLocationCache::load(cacheFile, key, cached);
+	}
+	QCOMPARE(cached.size(), locations.size());
+}
+
+void TestStelLocationIndex::benchmarkBuildIndex()
+{
+	QBENCHMARK {
+		StelLocationIndex index;
+		index.build(locations);
+	}
+}
+
+void TestStelLocationIndex::benchmarkScanNearest()
+{
+	// Nearest location and 5 degree neighbourhood, as for a click on the map of the location dialog
+	QBENCHMARK {
+		for (const auto& q : queries)
+		{
+			float d;
+			scanNearest("Earth", q.first, q.second, 5.f, &d);
+		}
+	}
+}
+
+void TestStelLocationIndex::benchmarkNearest()
+{
+	StelLocationIndex index;
+	index.build(locations);
+	QBENCHMARK {
+		for (const auto& q : queries)
+			index.findNearest("Earth", q.first, q.second, 5.f);
+	}
+}
+
+void TestStelLocationIndex::benchmarkFindInRadius()
+{
+	StelLocationIndex index;
+	index.build(locations);
+	QBENCHMARK {
+		for (const auto& q : queries)
+			index.findInRadius("Earth", q.first, q.second, 5.f);
+	}
+}
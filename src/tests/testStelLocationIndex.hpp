@@ -0,0 +1,52 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef TESTSTELLOCATIONINDEX_HPP
+#define TESTSTELLOCATIONINDEX_HPP
+
+#include <QObject>
+#include <QtTest>
+#include <QMap>
+
+#include "StelLocation.hpp"
+
+class TestStelLocationIndex : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	void testFindInRadius_data();
+	void testFindInRadius();
+	void testFindNearest();
+	void testCache();
+	void benchmarkStreamLoad();
+	void benchmarkCacheLoad();
+	void benchmarkBuildIndex();
+	void benchmarkScanNearest();
+	void benchmarkNearest();
+	void benchmarkFindInRadius();
+private:
+	//! The closest location by a linear scan, as the location manager did before the index
+	QString scanNearest(const QString& planet, float longitude, float latitude, float maxDistance, float* distance) const;
+
+	QMap<QString, StelLocation> locations;
+	QVector<QPair<float, float>> queries;
+};
+
+#endif // TESTSTELLOCATIONINDEX_HPP
@@ -0,0 +1,181 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testStelOBJ.hpp"
+
+#include "StelOBJ.hpp"
+
+#include <QFile>
+#include <QTextStream>
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestStelOBJ)
+
+void TestStelOBJ::initTestCase()
+{
+	QVERIFY(tempDir.isValid());
+	QFile mtl(tempDir.path() + "/grid.mtl");
+	QVERIFY(mtl.open(QIODevice::WriteOnly | QIODevice::Text));
+	mtl.write("newmtl ground\nKd 0.4 0.3 0.2\nmap_Kd ground.png\n\n"
+		  "newmtl roof\nKa 0.1 0.1 0.1\nKd 0.8 0.1 0.1\nNs 20\nbAlphatest 1\n");
+	mtl.close();
+
+	smallFile = tempDir.path() + "/small.obj";
+	bigFile = tempDir.path() + "/big.obj";
+	writeGrid(smallFile, 16);
+	// about 500k triangles, large enough to see the parsing cost
+	writeGrid(bigFile, 500);
+}
+
+void TestStelOBJ::writeGrid(const QString &fileName, int size)
+{
+	// A wavy height field, split into 2 objects with one material each
+	QFile file(fileName);
+	QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Text));
+	QTextStream out(&file);
+	out << "mtllib grid.mtl\n";
+	for (int y=0; y<=size; ++y)
+		for (int x=0; x<=size; ++x)
+		{
+			out << "v " << x << ' ' << y << ' ' << std::sin(x*0.3)*std::cos(y*0.2) << '\n';
+			out << "vt " << static_cast<double>(x)/size << ' ' << static_cast<double>(y)/size << '\n';
+		}
+	for (int half=0; half<2; ++half)
+	{
+		out << "o part" << half << "\nusemtl " << (half ? "roof" : "ground") << '\n';
+		for (int y=half*size/2; y<(half+1)*size/2; ++y)
+			for (int x=0; x<size; ++x)
+			{
+				const int i = y*(size+1) + x + 1;
+				out << "f " << i << '/' << i << ' ' << i+1 << '/' << i+1 << ' ' << i+size+2 << '/' << i+size+2 << '\n';
+				out << "f " << i << '/' << i << ' ' << i+size+2 << '/' << i+size+2 << ' ' << i+size+1 << '/' << i+size+1 << '\n';
+			}
+	}
+}
+
+void TestStelOBJ::compare(const StelOBJ &a, const StelOBJ &b)
+{
+	QVERIFY(b.isLoaded());
+	QCOMPARE(a.getVertexList().size(), b.getVertexList().size());
+	QVERIFY(a.getVertexList() == b.getVertexList());
+	QVERIFY(a.getIndexList() == b.getIndexList());
+	QCOMPARE(a.getObjectMap(), b.getObjectMap());
+	QCOMPARE(a.getCentroid(), b.getCentroid());
+	QCOMPARE(a.getAABBox().min, b.getAABBox().min);
+	QCOMPARE(a.getAABBox().max, b.getAABBox().max);
+
+	QCOMPARE(a.getMaterialList().size(), b.getMaterialList().size());
+	for (int i=0; i<a.getMaterialList().size(); ++i)
+	{
+		const StelOBJ::Material& ma = a.getMaterialList().at(i);
+		const StelOBJ::Material& mb = b.getMaterialList().at(i);
+		QCOMPARE(ma.name, mb.name);
+		QCOMPARE(ma.Kd, mb.Kd);
+		QCOMPARE(ma.Ns, mb.Ns);
+		QCOMPARE(ma.map_Kd, mb.map_Kd);
+		QCOMPARE(ma.additionalParams, mb.additionalParams);
+	}
+
+	QCOMPARE(a.getObjectList().size(), b.getObjectList().size());
+	for (int i=0; i<a.getObjectList().size(); ++i)
+	{
+		const StelOBJ::Object& oa = a.getObjectList().at(i);
+		const StelOBJ::Object& ob = b.getObjectList().at(i);
+		QCOMPARE(oa.name, ob.name);
+		QCOMPARE(oa.centroid, ob.centroid);
+		QCOMPARE(oa.groups.size(), ob.groups.size());
+		for (int j=0; j<oa.groups.size(); ++j)
+		{
+			QCOMPARE(oa.groups.at(j).startIndex, ob.groups.at(j).startIndex);
+			QCOMPARE(oa.groups.at(j).indexCount, ob.groups.at(j).indexCount);
+			QCOMPARE(oa.groups.at(j).materialIndex, ob.groups.at(j).materialIndex);
+			QCOMPARE(oa.groups.at(j).boundingbox.min, ob.groups.at(j).boundingbox.min);
+			QCOMPARE(oa.groups.at(j).boundingbox.max, ob.groups.at(j).boundingbox.max);
+		}
+	}
+}
+
+void TestStelOBJ::testCacheRoundTrip()
+{
+	StelOBJ parsed;
+	QVERIFY(parsed.load(smallFile, StelOBJ::XZY));
+
+	// the first call parses and writes the cache, the second one only reads it
+	QFile::remove(smallFile + ".cache");
+	StelOBJ first, cached;
+	QVERIFY(first.loadCached(smallFile, StelOBJ::XZY));
+	QVERIFY(QFile::exists(smallFile + ".cache"));
+	QVERIFY(cached.loadCache(smallFile + ".cache", StelOBJ::getCacheKey(smallFile, StelOBJ::XZY)));
+	compare(parsed, first);
+	compare(parsed, cached);
+	QVERIFY(cached.loadCached(smallFile, StelOBJ::XZY));
+	compare(parsed, cached);
+}
+
+void TestStelOBJ::testCacheInvalidation()
+{
+	const QString cacheFile = smallFile + ".cache";
+	StelOBJ obj;
+	QVERIFY(obj.loadCached(smallFile, StelOBJ::XYZ));
+	const QByteArray key = StelOBJ::getCacheKey(smallFile, StelOBJ::XYZ);
+	QVERIFY(obj.loadCache(cacheFile, key));
+
+	// another vertex order yields other vertex data
+	const QByteArray otherKey = StelOBJ::getCacheKey(smallFile, StelOBJ::ZXY);
+	QVERIFY(!otherKey.isEmpty());
+	QVERIFY(otherKey != key);
+	QVERIFY(!obj.loadCache(cacheFile, otherKey));
+
+	// a modified material file must invalidate the cache
+	QFile mtl(tempDir.path() + "/grid.mtl");
+	QVERIFY(mtl.open(QIODevice::Append | QIODevice::Text));
+	mtl.write("Ke 0.0 0.0 0.0\n");
+	mtl.close();
+	QVERIFY(!obj.loadCache(cacheFile, key));
+	QVERIFY(obj.loadCached(smallFile, StelOBJ::XYZ));
+	QVERIFY(obj.loadCache(cacheFile, key));
+
+	// a truncated cache is rejected
+	QFile cache(cacheFile);
+	QVERIFY(cache.resize(cache.size()/2));
+	QVERIFY(!obj.loadCache(cacheFile, key));
+}
+
+void TestStelOBJ::benchmarkParse()
+{
+	StelOBJ obj;
+	QBENCHMARK {
+		obj.load(bigFile);
+	}
+}
+
+void TestStelOBJ::benchmarkCachedLoad()
+{
+	// the first call writes the cache, the benchmark only reads it
+	QFile::remove(bigFile + ".cache");
+	StelOBJ parsed;
+	QVERIFY(parsed.loadCached(bigFile));
+	QVERIFY(QFile::exists(bigFile + ".cache"));
+
+	StelOBJ cached;
+	QBENCHMARK {
+		cached.loadCached(bigFile);
+	}
+	compare(parsed, cached);
+}
@@ -0,0 +1,219 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testStelObjectNameIndex.hpp"
+
+#include "StelObjectMgr.hpp"
+#include "StelObjectModule.hpp"
+
+QTEST_GUILESS_MAIN(TestStelObjectNameIndex)
+
+namespace
+{
+	//! An object module which only has names, found through its StelObjectNameIndex like the catalog modules do.
+	class NamesModule : public StelObjectModule
+	{
+	public:
+		NamesModule(const QString& name, const QStringList& names) : name(name)
+		{
+			setObjectName(name);
+			for (const auto& n : names)
+				index.insert(n);
+			index.build();
+		}
+		virtual void init() Q_DECL_OVERRIDE {}
+		virtual void update(double) Q_DECL_OVERRIDE {}
+		virtual QList<StelObjectP> searchAround(const Vec3d&, double, const StelCore*) const Q_DECL_OVERRIDE { return QList<StelObjectP>(); }
+		virtual StelObjectP searchByNameI18n(const QString&) const Q_DECL_OVERRIDE { return StelObjectP(); }
+		virtual StelObjectP searchByName(const QString&) const Q_DECL_OVERRIDE { return StelObjectP(); }
+		virtual StelObjectP searchByID(const QString&) const Q_DECL_OVERRIDE { return StelObjectP(); }
+		virtual QStringList listMatchingObjects(const QString& objPrefix, int maxNbItem, bool useStartOfWords, bool) const Q_DECL_OVERRIDE
+		{
+			return index.find(objPrefix, maxNbItem, useStartOfWords);
+		}
+		virtual QStringList listAllObjects(bool) const Q_DECL_OVERRIDE { return QStringList(); }
+		virtual QString getName() const Q_DECL_OVERRIDE { return name; }
+		virtual QString getStelObjectType() const Q_DECL_OVERRIDE { return name; }
+
+	private:
+		QString name;
+		StelObjectNameIndex index;
+	};
+}
+
+void TestStelObjectNameIndex::initTestCase()
+{
+	// About the size of the star, DSO and solar system catalogs together
+	qsrand(1234);
+	for (int i=1; i<=120000; ++i)
+		names << QString("HIP %1").arg(i);
+	for (int i=1; i<=7840; ++i)
+		names << QString("NGC %1").arg(i) << QString("NGC%1").arg(i);
+	for (int i=1; i<=5386; ++i)
+		names << QString("IC %1").arg(i);
+	for (int i=1; i<=110; ++i)
+		names << QString("M%1").arg(i) << QString("M %1").arg(i);
+	static const char letters[] = "abcdefghijklmnopqrstuvwxyz";
+	for (int i=0; i<20000; ++i)
+	{
+		QString name(QChar(letters[qrand()%26]).toUpper());
+		const int len = 3 + qrand()%8;
+		for (int j=0; j<len; ++j)
+			name.append(QChar(letters[qrand()%26]));
+		names << name;
+	}
+	names << "Sirius" << "Vega" << "Andromeda Galaxy" << "Orion Nebula" << "Mars" << "Jupiter";
+
+	for (const auto& name : names)
+		index.insert(name);
+	index.build();
+	names.removeDuplicates();
+}
+
+void TestStelObjectNameIndex::testFind_data()
+{
+	QTest::addColumn<QString>("text");
+	QTest::addColumn<bool>("useStartOfWords");
+	const QStringList texts = QStringList() << "" << "m" << "M3" << "m 3" << "ngc 22" << "hip 1234" << "sir"
+						<< "galaxy" << "ebu" << "abc" << "x" << "12" << "zzzzzz" << "Orion Nebula";
+	for (const auto& t : texts)
+	{
+		QTest::newRow(qPrintable("prefix " + t)) << t << true;
+		QTest::newRow(qPrintable("substring " + t)) << t << false;
+	}
+}
+
+void TestStelObjectNameIndex::testFind()
+{
+	QFETCH(QString, text);
+	QFETCH(bool, useStartOfWords);
+
+	QStringList expected;
+	for (const auto& name : names)
+	{
+		if (useStartOfWords ? name.startsWith(text, Qt::CaseInsensitive) : name.contains(text, Qt::CaseInsensitive))
+			expected << name;
+	}
+	expected.sort();
+
+	QCOMPARE(index.find(text, -1, useStartOfWords), expected);
+}
+
+void TestStelObjectNameIndex::testAlias()
+{
+	StelObjectNameIndex idx;
+	idx.insert("Mel 20", "Melotte 20");
+	idx.insert("Mel 20");
+	idx.insert("Cr 399", "Collinder 399");
+	// not built yet: linear scan
+	QCOMPARE(idx.findPrefix("melotte"), QStringList() << "Mel 20");
+	idx.build();
+	QCOMPARE(idx.size(), 3);
+	QCOMPARE(idx.findPrefix("mel"), QStringList() << "Mel 20");
+	QCOMPARE(idx.findPrefix("melotte 2"), QStringList() << "Mel 20");
+	QCOMPARE(idx.findSubstring("linder"), QStringList() << "Cr 399");
+	QCOMPARE(idx.findSubstring("Cr 3"), QStringList());
+	idx.clear();
+	QVERIFY(idx.isEmpty());
+	QCOMPARE(idx.findPrefix("Mel"), QStringList());
+}
+
+void TestStelObjectNameIndex::testMaxNbItem()
+{
+	QCOMPARE(index.findPrefix("HIP", 0), QStringList());
+	QCOMPARE(index.findSubstring("HIP", 0), QStringList());
+
+	const QStringList all = index.findSubstring("NGC 1");
+	const QStringList some = index.findSubstring("NGC 1", 5);
+	QCOMPARE(some.size(), 5);
+	for (const auto& name : some)
+		QVERIFY(all.contains(name));
+
+	// the first names in alphabetical order
+	QCOMPARE(index.findPrefix("M1", 3), QStringList() << "M1" << "M10" << "M100");
+}
+
+static const QStringList benchmarkTexts = QStringList() << "M" << "M31" << "NGC 22" << "IC 4" << "HIP 1" << "Sir" << "ebu"
+							 << "galaxy" << "Orion" << "abc";
+
+void TestStelObjectNameIndex::benchmarkFindLinear()
+{
+	// A scan of all names, as done before the index
+	QBENCHMARK {
+		for (const auto& t : benchmarkTexts)
+		{
+			QStringList prefix, substring;
+			for (const auto& name : names)
+			{
+				if (name.startsWith(t, Qt::CaseInsensitive) && prefix.size()<5)
+					prefix << name;
+				if (name.contains(t, Qt::CaseInsensitive) && substring.size()<5)
+					substring << name;
+			}
+		}
+	}
+}
+
+void TestStelObjectNameIndex::benchmarkFind()
+{
+	QBENCHMARK {
+		for (const auto& t : benchmarkTexts)
+		{
+			index.findPrefix(t, 5);
+			index.findSubstring(t, 5);
+		}
+	}
+}
+
+void TestStelObjectNameIndex::benchmarkListMatchingObjects_data()
+{
+	QTest::addColumn<bool>("useStartOfWords");
+	QTest::newRow("prefix") << true;
+	QTest::newRow("substring") << false;
+}
+
+void TestStelObjectNameIndex::benchmarkListMatchingObjects()
+{
+	QFETCH(bool, useStartOfWords);
+
+	// The search dialog queries all object modules through StelObjectMgr
+	QStringList stars, dso, others;
+	for (const auto& name : names)
+	{
+		if (name.startsWith("HIP"))
+			stars << name;
+		else if (name.startsWith("NGC") || name.startsWith("IC") || name.startsWith("M"))
+			dso << name;
+		else
+			others << name;
+	}
+	NamesModule starModule("Star", stars), dsoModule("Nebula", dso), otherModule("Other", others);
+	StelObjectMgr objectMgr;
+	objectMgr.registerStelObjectMgr(&starModule);
+	objectMgr.registerStelObjectMgr(&dsoModule);
+	objectMgr.registerStelObjectMgr(&otherModule);
+
+	const QStringList queries = QStringList() << "M" << "M3" << "M31" << "NGC" << "NGC 22" << "IC 4"
+		<< "Mel" << "HIP 1" << "HD 3" << "Sir" << "Vega" << "Mar" << "Jup" << "Ceres" << "alp" << "neb"
+		<< "cluster" << "ae" << "an" << "Orion";
+	QBENCHMARK {
+		for (const auto& q : queries)
+			objectMgr.listMatchingObjects(q, 5, useStartOfWords, true);
+	}
+}
@@ -0,0 +1,195 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testStelProfiler.hpp"
+#include "StelProfiler.hpp"
+
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QtConcurrent>
+
+QTEST_GUILESS_MAIN(TestStelProfiler)
+
+// Find a scope of the statistics by its path
+static QVariantMap findScope(const QVariantMap& stats, const QString& path)
+{
+	for (const auto& v : stats.value("scopes").toList())
+	{
+		const QVariantMap s = v.toMap();
+		if (s.value("path").toString()==path)
+			return s;
+	}
+	return QVariantMap();
+}
+
+static void busyWait(qint64 ns)
+{
+	QElapsedTimer t;
+	t.start();
+	while (t.nsecsElapsed()<ns) {}
+}
+
+void TestStelProfiler::testDisabled()
+{
+	StelProfiler profiler;
+	profiler.beginFrame();
+	{
+		StelProfiler::Scope scope("Module");
+	}
+	profiler.endFrame();
+	const QVariantMap stats = profiler.getStatistics();
+	QCOMPARE(stats.value("frames").toInt(), 0);
+	QVERIFY(stats.value("scopes").toList().isEmpty());
+}
+
+void TestStelProfiler::testHierarchy()
+{
+	StelProfiler profiler;
+	profiler.setFlagEnabled(true);
+	for (int frame=0; frame<3; ++frame)
+	{
+		profiler.beginFrame();
+		{
+			StelProfiler::Scope update("StelApp::update");
+			{
+				StelProfiler::Scope module("StarMgr");
+				StelProfiler::Scope hot("StarMgr::prepareDraw");
+			}
+			StelProfiler::Scope module("SolarSystem");
+			for (int i=0; i<4; ++i)
+				StelProfiler::Scope hot("Planet::computePosition");
+		}
+		{
+			StelProfiler::Scope draw("StelApp::draw");
+			StelProfiler::Scope module("StarMgr");
+		}
+		// Scopes of other threads are ignored
+		QtConcurrent::run([]() { StelProfiler::Scope scope("Worker"); }).waitForFinished();
+		profiler.endFrame();
+	}
+
+	const QVariantMap stats = profiler.getStatistics();
+	QCOMPARE(stats.value("frames").toInt(), 3);
+	const QStringList expected = QStringList()
+		<< "Frame" << "Frame/StelApp::update" << "Frame/StelApp::update/StarMgr"
+		<< "Frame/StelApp::update/StarMgr/StarMgr::prepareDraw" << "Frame/StelApp::update/SolarSystem"
+		<< "Frame/StelApp::update/SolarSystem/Planet::computePosition" << "Frame/StelApp::draw"
+		<< "Frame/StelApp::draw/StarMgr";
+	QStringList paths;
+	for (const auto& v : stats.value("scopes").toList())
+		paths << v.toMap().value("path").toString();
+	QCOMPARE(paths, expected);
+
+	QCOMPARE(findScope(stats, "Frame/StelApp::update/SolarSystem/Planet::computePosition").value("calls").toDouble(), 4.);
+	QCOMPARE(findScope(stats, "Frame/StelApp::draw/StarMgr").value("depth").toInt(), 2);
+}
+
+void TestStelProfiler::testStatistics()
+{
+	StelProfiler profiler;
+	profiler.setFlagEnabled(true);
+	// One slow frame out of ten
+	for (int frame=0; frame<10; ++frame)
+	{
+		profiler.beginFrame();
+		{
+			StelProfiler::Scope scope("Module");
+			busyWait(frame==5 ? 20000000 : 1000000);
+		}
+		profiler.endFrame();
+	}
+
+	const QVariantMap s = findScope(profiler.getStatistics(), "Frame/Module");
+	QVERIFY(!s.isEmpty());
+	QVERIFY(s.value("min").toDouble() >= 1.);
+	QVERIFY(s.value("max").toDouble() >= 20.);
+	QVERIFY(s.value("mean").toDouble() > s.value("min").toDouble());
+	QVERIFY(s.value("mean").toDouble() < s.value("max").toDouble());
+	QVERIFY(s.value("p95").toDouble() <= s.value("max").toDouble());
+	QVERIFY(findScope(profiler.getStatistics(), "Frame").value("mean").toDouble() >= s.value("mean").toDouble());
+
+	// Disabling clears the history
+	profiler.setFlagEnabled(false);
+	QCOMPARE(profiler.getStatistics().value("frames").toInt(), 0);
+}
+
+void TestStelProfiler::testTrace()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString fileName = dir.path() + "/trace.json";
+
+	StelProfiler profiler;
+	QSignalSpy written(&profiler, SIGNAL(traceWritten(QString)));
+	profiler.startTrace(2, fileName);
+	QVERIFY(profiler.getFlagEnabled());
+	for (int frame=0; frame<4; ++frame)
+	{
+		profiler.beginFrame();
+		{
+			StelProfiler::Scope outer("Outer");
+			StelProfiler::Scope inner("Inner");
+		}
+		profiler.endFrame();
+	}
+	QCOMPARE(written.count(), 1);
+
+	QFile file(fileName);
+	QVERIFY(file.open(QIODevice::ReadOnly));
+	const QJsonArray events = QJsonDocument::fromJson(file.readAll()).object().value("traceEvents").toArray();
+	// Inner, Outer and Frame for each of the two frames
+	QCOMPARE(events.size(), 6);
+	for (const auto& v : events)
+	{
+		const QJsonObject e = v.toObject();
+		QCOMPARE(e.value("ph").toString(), QString("X"));
+		QVERIFY(e.value("dur").toDouble() >= 0.);
+	}
+	// Children end before their parents
+	QCOMPARE(events.at(0).toObject().value("name").toString(), QString("Inner"));
+	QCOMPARE(events.at(2).toObject().value("name").toString(), QString("Frame"));
+}
+
+void TestStelProfiler::benchmarkScopes_data()
+{
+	QTest::addColumn<bool>("enabled");
+	QTest::newRow("disabled") << false;
+	QTest::newRow("enabled") << true;
+}
+
+void TestStelProfiler::benchmarkScopes()
+{
+	// Cost of the 40 scopes of a frame
+	QFETCH(bool, enabled);
+	StelProfiler profiler;
+	profiler.setFlagEnabled(enabled);
+	const char* const names[] = { "StarMgr", "NebulaMgr", "SolarSystem", "LandscapeMgr", "GridLinesMgr" };
+	QBENCHMARK {
+		profiler.beginFrame();
+		for (int i=0; i<8; ++i)
+		{
+			for (const char* name : names)
+				StelProfiler::Scope scope(name);
+		}
+		profiler.endFrame();
+	}
+}
@@ -0,0 +1,162 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testStelTextShaper.hpp"
+#include "StelTextShaper.hpp"
+#include "StelGlyphAtlas.hpp"
+
+#include <QFontMetrics>
+
+#include <algorithm>
+
+// Fonts need a QGuiApplication, the test is run with the offscreen platform
+QTEST_MAIN(TestStelTextShaper)
+
+void TestStelTextShaper::initTestCase()
+{
+	font.setPixelSize(13);
+	// Labels of about one frame with stars, DSO, planets and grids
+	for (int i=0; i<500; ++i)
+		labels << QString("HIP %1").arg(1000+i*37) << QString("NGC %1").arg(200+i*11);
+	labels << "Sirius" << "Vega" << "Andromeda Galaxy" << "Orion Nebula" << "Jupiter" << "Io" << "Europa"
+	       << QString::fromUtf8("\xce\xb1 Cen") << QString::fromUtf8("\xd0\x91\xd0\xb5\xd1\x82\xd0\xb5\xd0\xbb\xd1\x8c\xd0\xb3\xd0\xb5\xd0\xb9\xd0\xb7\xd0\xb5");
+	for (int i=0; i<24; ++i)
+		labels << QString("%1h").arg(i) << QString("+%1%2").arg(i*3).arg(QChar(0x00B0));
+}
+
+void TestStelTextShaper::testShape()
+{
+	StelTextShaper shaper;
+	const StelShapedText* text = shaper.shape("Andromeda Galaxy", font);
+	QVERIFY(text);
+	QCOMPARE(text->glyphs.size(), 16);
+	QVERIFY(text->width > 0.f);
+	QVERIFY(text->width > text->glyphs.last().x);
+	for (int i=1; i<text->glyphs.size(); ++i)
+		QVERIFY(text->glyphs.at(i).x > text->glyphs.at(i-1).x);
+	for (const auto& g : text->glyphs)
+	{
+		QVERIFY(g.font >= 0 && g.font < shaper.getFontCount());
+		QVERIFY(qAbs(g.y) < 0.01f);
+	}
+
+	QVERIFY(shaper.shape("", font)->glyphs.isEmpty());
+}
+
+void TestStelTextShaper::testCache()
+{
+	StelTextShaper shaper(100);
+	const StelShapedText* a = shaper.shape("Vega", font);
+	QCOMPARE(shaper.shape("Vega", font), a);
+	QCOMPARE(shaper.getCacheHits(), 1);
+	QCOMPARE(shaper.getCacheMisses(), 1);
+
+	// Another size is another string
+	QFont big = font;
+	big.setPixelSize(30);
+	const StelShapedText* b = shaper.shape("Vega", big);
+	QVERIFY(b != a);
+	QVERIFY(b->width > a->width);
+	QCOMPARE(shaper.getCacheMisses(), 2);
+
+	// Strings longer than the cache are still shaped
+	const QString longText(200, QChar('x'));
+	QCOMPARE(shaper.shape(longText, font)->glyphs.size(), 200);
+
+	shaper.clear();
+	QCOMPARE(shaper.getCacheHits(), 0);
+}
+
+void TestStelTextShaper::testAtlas()
+{
+	StelTextShaper shaper;
+	StelGlyphAtlas atlas(128);
+	QVector<QRect> rects;
+	for (const auto& label : labels)
+	{
+		for (const auto& g : shaper.shape(label, font)->glyphs)
+		{
+			const StelGlyphAtlas::Glyph& glyph = atlas.getGlyph(shaper.getFont(g.font), g.font, g.index);
+			if (glyph.page < 0)
+				continue;
+			QVERIFY(QRect(0, 0, atlas.getPageSize(), atlas.getPageSize()).contains(glyph.rect));
+			rects << QRect(glyph.rect.topLeft() + QPoint(glyph.page*atlas.getPageSize(), 0), glyph.rect.size());
+		}
+	}
+	QVERIFY(atlas.getPageCount() > 1);
+
+	// Each glyph is rendered once, without overlap
+	QVERIFY(rects.size() > atlas.getGlyphCount());
+	std::sort(rects.begin(), rects.end(), [](const QRect& a, const QRect& b) { return a.x() < b.x() || (a.x() == b.x() && a.y() < b.y()); });
+	rects.erase(std::unique(rects.begin(), rects.end()), rects.end());
+	QVERIFY(rects.size() <= atlas.getGlyphCount());
+	for (int i=0; i<rects.size(); ++i)
+		for (int j=i+1; j<rects.size(); ++j)
+			QVERIFY(!rects.at(i).intersects(rects.at(j)));
+
+	// The glyph pixels are white with some coverage
+	const StelShapedText* text = shaper.shape("W", font);
+	const StelGlyphAtlas::Glyph& glyph = atlas.getGlyph(shaper.getFont(text->glyphs.first().font), text->glyphs.first().font, text->glyphs.first().index);
+	const QImage& page = atlas.getPageImage(glyph.page);
+	int covered = 0;
+	for (int y=glyph.rect.top(); y<=glyph.rect.bottom(); ++y)
+		for (int x=glyph.rect.left(); x<=glyph.rect.right(); ++x)
+		{
+			const QColor c = page.pixelColor(x, y);
+			QCOMPARE(c.red(), 255);
+			if (c.alpha() > 128)
+				++covered;
+		}
+	QVERIFY(covered > 0);
+}
+
+void TestStelTextShaper::benchmarkFontMetrics()
+{
+	// Reference: measuring each label with the font metrics, as needed to lay out a string texture
+	QFontMetrics metrics(font);
+	QBENCHMARK {
+		for (const auto& label : labels)
+			metrics.boundingRect(label);
+	}
+}
+
+void TestStelTextShaper::benchmarkFirstShaping()
+{
+	QBENCHMARK {
+		StelTextShaper shaper;
+		for (const auto& label : labels)
+			shaper.shape(label, font);
+	}
+}
+
+void TestStelTextShaper::benchmarkCachedShaping()
+{
+	StelTextShaper shaper;
+	for (const auto& label : labels)
+		shaper.shape(label, font);
+	QStringList distinctLabels = labels;
+	distinctLabels.removeDuplicates();
+	QCOMPARE(shaper.getCacheMisses(), distinctLabels.size());
+
+	QBENCHMARK {
+		for (const auto& label : labels)
+			shaper.shape(label, font);
+	}
+	QCOMPARE(shaper.getCacheMisses(), distinctLabels.size());
+}
@@ -0,0 +1,187 @@
+/*
+ * Stellarium
+ * Copyright (C) 2020 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testUTCOffsetCache.hpp"
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QDebug>
+
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestUTCOffsetCache)
+
+static const double JD_1850 = 2396758.5;
+static const double JD_2100 = 2488069.5;
+static const double TZ_ERA_BEGINNING = 2395996.5; // December 1, 1847
+
+int TestUTCOffsetCache::getTimeZoneOffset(const QTimeZone& tz, bool useDST, double JD)
+{
+	const QDateTime universal = QDateTime::fromMSecsSinceEpoch(static_cast<qint64>(std::floor((JD-2440587.5)*86400000.+0.5)), Qt::UTC);
+	return useDST ? tz.offsetFromUtc(universal) : tz.standardTimeOffset(universal);
+}
+
+void TestUTCOffsetCache::testFixedOffset()
+{
+	StelUTCOffsetCache cache;
+	QCOMPARE(cache.getOffset(2451545.0), 0);
+	cache.setFixedOffset(-18000);
+	QCOMPARE(cache.getOffset(0.), -18000);
+	QCOMPARE(cache.getOffset(2451545.0), -18000);
+	QCOMPARE(cache.getOffset(1e9), -18000);
+	QCOMPARE(cache.getNbTransitions(), 0);
+
+	// An invalid time zone gives the offset before the time zone at all dates, e.g. for LMST.
+	cache.setTimeZone(QTimeZone("LMST"), true, TZ_ERA_BEGINNING, 3000);
+	QCOMPARE(cache.getOffset(2451545.0), 3000);
+}
+
+void TestUTCOffsetCache::testTimeZone_data()
+{
+	QTest::addColumn<QString>("zone");
+	QTest::addColumn<bool>("useDST");
+	const QStringList zones = {"Europe/Berlin", "America/New_York", "Australia/Sydney", "Asia/Kolkata", "Europe/Moscow", "America/Santiago"};
+	for (const auto& zone : zones)
+	{
+		QTest::newRow(qPrintable(zone + " DST")) << zone << true;
+		QTest::newRow(qPrintable(zone)) << zone << false;
+	}
+}
+
+void TestUTCOffsetCache::testTimeZone()
+{
+	QFETCH(QString, zone);
+	QFETCH(bool, useDST);
+	const QTimeZone tz(zone.toUtf8());
+	if (!tz.isValid())
+		QSKIP("Time zone not available");
+
+	StelUTCOffsetCache cache;
+	cache.setTimeZone(tz, useDST);
+	// Every 7.3 days and a few hours, and in random order
+	for (double JD=JD_1850; JD<JD_2100; JD+=7.3127)
+		QCOMPARE(cache.getOffset(JD), getTimeZoneOffset(tz, useDST, JD));
+	for (int i=0; i<5000; ++i)
+	{
+		const double JD = JD_1850 + std::fmod(i*7919.123457, JD_2100-JD_1850);
+		QCOMPARE(cache.getOffset(JD), getTimeZoneOffset(tz, useDST, JD));
+	}
+
+	// Around each transition
+	const QTimeZone::OffsetDataList list = tz.transitions(QDateTime(QDate(1950, 1, 1), QTime(0, 0), Qt::UTC),
+							       QDateTime(QDate(2050, 1, 1), QTime(0, 0), Qt::UTC));
+	for (const auto& data : list)
+	{
+		const double JD = 2440587.5 + data.atUtc.toMSecsSinceEpoch()/86400000.;
+		for (double dt : {-1./24., -1./86400., 0., 1./86400., 1./24.})
+			QCOMPARE(cache.getOffset(JD+dt), getTimeZoneOffset(tz, useDST, JD+dt));
+	}
+}
+
+void TestUTCOffsetCache::testBeginDate()
+{
+	const QTimeZone tz("Europe/London");
+	if (!tz.isValid())
+		QSKIP("Time zone not available");
+	StelUTCOffsetCache cache;
+	cache.setTimeZone(tz, true, TZ_ERA_BEGINNING, -452);
+	QCOMPARE(cache.getOffset(TZ_ERA_BEGINNING-1.), -452);
+	QCOMPARE(cache.getOffset(TZ_ERA_BEGINNING-1e6), -452);
+	QCOMPARE(cache.getOffset(TZ_ERA_BEGINNING+1.), getTimeZoneOffset(tz, true, TZ_ERA_BEGINNING+1.));
+	// Summer time in 2000
+	QCOMPARE(cache.getOffset(2451727.0), 3600);
+	QCOMPARE(cache.getOffset(2451545.0), 0);
+}
+
+void TestUTCOffsetCache::testOutOfRange()
+{
+	const QTimeZone tz("America/New_York");
+	if (!tz.isValid())
+		QSKIP("Time zone not available");
+	StelUTCOffsetCache cache;
+	cache.setTimeZone(tz, true);
+	const double minJD = QDate(StelUTCOffsetCache::MinYear, 1, 1).toJulianDay() - 0.5;
+	const double maxJD = QDate(StelUTCOffsetCache::MaxYear+1, 1, 1).toJulianDay() - 0.5;
+	// Far in the past and in the future, and outside the range of QDateTime
+	for (double JD : {-1e12, -1e6, 0., 1e6, minJD-1.})
+		QCOMPARE(cache.getOffset(JD), getTimeZoneOffset(tz, true, minJD));
+	for (double JD : {maxJD, maxJD+1e6, 1e12})
+		QCOMPARE(cache.getOffset(JD), getTimeZoneOffset(tz, true, maxJD));
+	// The years in between are loaded as needed.
+	QCOMPARE(cache.getOffset(2451727.0), -4*3600);
+	QCOMPARE(cache.getOffset(2451545.0), -5*3600);
+}
+
+void TestUTCOffsetCache::testPreload()
+{
+	const QTimeZone tz("Europe/Berlin");
+	if (!tz.isValid())
+		QSKIP("Time zone not available");
+	StelUTCOffsetCache cache;
+	cache.setTimeZone(tz, true);
+	cache.preload(2451545.0, 2451545.0 + 365.25*50);
+	const int nbTransitions = cache.getNbTransitions();
+	QVERIFY(nbTransitions>=100);
+	for (double JD=2451545.0; JD<2451545.0 + 365.25*50; JD+=0.7)
+		cache.getOffset(JD);
+	QCOMPARE(cache.getNbTransitions(), nbTransitions);
+
+	// Loading earlier and later blocks gives the same table as loading them at once.
+	cache.getOffset(JD_1850);
+	cache.getOffset(JD_2100);
+	StelUTCOffsetCache other;
+	other.setTimeZone(tz, true);
+	other.preload(JD_1850, JD_2100);
+	QCOMPARE(cache.getNbTransitions(), other.getNbTransitions());
+	for (double JD=JD_1850; JD<JD_2100; JD+=3.1)
+		QCOMPARE(cache.getOffset(JD), other.getOffset(JD));
+}
+
+void TestUTCOffsetCache::benchmarkQueries()
+{
+	const QTimeZone tz("Europe/Berlin");
+	if (!tz.isValid())
+		QSKIP("Time zone not available");
+	const int n = 1000000;
+	QVector<double> dates(n);
+	for (int i=0; i<n; ++i)
+		dates[i] = JD_1850 + std::fmod(i*0.0137 + (i%97)*123.4567, JD_2100-JD_1850);
+
+	QElapsedTimer timer;
+	timer.start();
+	qint64 sum = 0;
+	for (int i=0; i<n; i+=100)
+		sum += getTimeZoneOffset(tz, true, dates[i]);
+	const double directTime = timer.nsecsElapsed()/(n/100.);
+
+	StelUTCOffsetCache cache;
+	cache.setTimeZone(tz, true);
+	timer.restart();
+	for (int i=0; i<n; ++i)
+		sum += cache.getOffset(dates[i]);
+	const double cacheTime = static_cast<double>(timer.nsecsElapsed())/n;
+	qDebug() << "QTimeZone:" << directTime << "ns/query, cache:" << cacheTime << "ns/query for" << n << "queries with"
+		 << cache.getNbTransitions() << "transitions";
+	QVERIFY(sum!=0);
+
+	QBENCHMARK {
+		for (int i=0; i<n; ++i)
+			sum += cache.getOffset(dates[i]);
+	}
+}